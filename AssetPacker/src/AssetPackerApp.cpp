@@ -0,0 +1,195 @@
+﻿#include "Core/AssetPack.h"
+#include "Core/JobSystem.h"
+#include "Core/Log.h"
+#include "Core/Memory.h"
+#include "Core/Profiler.h"
+
+#include <algorithm>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/// <summary>
+/// 命令行参数
+/// </summary>
+typedef struct AssetPackerSettings
+{
+	std::vector<const char*>	mInputs;
+	const char*					pOutput = "assets" ASSET_PACK_EXTENSION;
+	// 资源名相对于此目录; 为空时目录输入相对于该目录本身, 文件输入只用文件名
+	const char*					pRoot = NULL;
+	// 输出比所有输入都新时默认跳过
+	bool						mForce = false;
+} AssetPackerSettings;
+
+/// <summary>
+/// 一个待打包的文件与它在包内的名称
+/// </summary>
+typedef struct PackInput
+{
+	std::string	mName;
+	std::string	mFileName;
+} PackInput;
+
+static void printUsage()
+{
+	printf(
+		"Usage: AssetPacker [options] <file or directory>...\n"
+		"  Packs the files (directories recursively) into one LZ4 compressed pack (format version %d)\n"
+		"  --output <file>  pack to write (default assets" ASSET_PACK_EXTENSION ")\n"
+		"  --root <dir>     name assets by their path relative to <dir>; by default files inside a directory input\n"
+		"                   are named relative to it and file inputs by their file name\n"
+		"  --force          pack even when the output is newer than every input\n",
+		ASSET_PACK_VERSION);
+}
+
+static bool parseSettings(int argc, char** argv, AssetPackerSettings* pSettings)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "--force")
+			pSettings->mForce = true;
+		else if (arg == "--output" && i + 1 < argc)
+			pSettings->pOutput = argv[++i];
+		else if (arg == "--root" && i + 1 < argc)
+			pSettings->pRoot = argv[++i];
+		else if (arg == "--help")
+			return false;
+		else if (arg.rfind("--", 0) == 0)
+		{
+			SHEN_CLIENT_ERROR("unknown option {0}", arg);
+			return false;
+		}
+		else
+			pSettings->mInputs.push_back(argv[i]);
+	}
+	return !pSettings->mInputs.empty();
+}
+
+static void addPackInput(const AssetPackerSettings* pSettings, const fs::path& file, const fs::path& base, std::vector<PackInput>* pInputs)
+{
+	PackInput input;
+	input.mName = (pSettings->pRoot ? file.lexically_relative(pSettings->pRoot) : file.lexically_relative(base)).generic_string();
+	input.mFileName = file.string();
+	pInputs->push_back(input);
+}
+
+/// <summary>
+/// 展开目录输入; 名称排序后写入, 相同的输入总是得到相同的包
+/// </summary>
+static bool collectInputs(const AssetPackerSettings* pSettings, std::vector<PackInput>* pInputs)
+{
+	for (const char* pInput : pSettings->mInputs)
+	{
+		std::error_code error;
+		fs::path input = pInput;
+		if (fs::is_directory(input, error))
+		{
+			for (fs::recursive_directory_iterator it(input, error), end; it != end && !error; it.increment(error))
+			{
+				if (it->is_regular_file(error))
+					addPackInput(pSettings, it->path(), input, pInputs);
+			}
+		}
+		else if (fs::is_regular_file(input, error))
+			addPackInput(pSettings, input, input.parent_path(), pInputs);
+		else
+		{
+			SHEN_CLIENT_ERROR("{0} does not exist", pInput);
+			return false;
+		}
+		if (error)
+		{
+			SHEN_CLIENT_ERROR("failed to list {0}: {1}", pInput, error.message());
+			return false;
+		}
+	}
+	std::sort(pInputs->begin(), pInputs->end(), [](const PackInput& a, const PackInput& b) { return a.mName < b.mName; });
+	return true;
+}
+
+static bool isUpToDate(const std::vector<PackInput>& inputs, const fs::path& output)
+{
+	std::error_code error;
+	fs::file_time_type outputTime = fs::last_write_time(output, error);
+	if (error)
+		return false;
+	for (const PackInput& input : inputs)
+	{
+		fs::file_time_type inputTime = fs::last_write_time(input.mFileName, error);
+		if (error || inputTime > outputTime)
+			return false;
+	}
+	return true;
+}
+
+/// <summary>
+/// 先写入临时文件再替换, 中途失败或被中断时不会留下半个输出文件
+/// </summary>
+static bool packAssets(const AssetPackerSettings* pSettings)
+{
+	std::vector<PackInput> inputs;
+	if (!collectInputs(pSettings, &inputs))
+		return false;
+	fs::path output = pSettings->pOutput;
+	if (!pSettings->mForce && isUpToDate(inputs, output))
+	{
+		fmt::print("{0} is up to date\n", output.string());
+		return true;
+	}
+
+	std::vector<AssetPackSource> sources(inputs.size());
+	uint64_t inputBytes = 0;
+	std::error_code error;
+	for (size_t i = 0; i < inputs.size(); ++i)
+	{
+		sources[i].pName = inputs[i].mName.c_str();
+		sources[i].pFileName = inputs[i].mFileName.c_str();
+		inputBytes += fs::file_size(inputs[i].mFileName, error);
+	}
+
+	if (output.has_parent_path())
+		fs::create_directories(output.parent_path(), error);
+	fs::path temporary = output;
+	temporary += ".tmp";
+	if (!writeAssetPack(temporary.string().c_str(), sources.data(), (uint32_t)sources.size()))
+		return false;
+
+	fs::rename(temporary, output, error);
+	if (error)
+	{
+		SHEN_CLIENT_ERROR("failed to replace {0}: {1}", output.string(), error.message());
+		fs::remove(temporary, error);
+		return false;
+	}
+	fmt::print("wrote {0}: {1} assets, {2} KB -> {3} KB\n", output.string(), sources.size(), inputBytes / 1024,
+		fs::file_size(output, error) / 1024);
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	Log::Init();
+	initMemorySystem("AssetPacker");
+	initProfiler();
+	initJobSystem(0);
+
+	int result = 0;
+	AssetPackerSettings settings;
+	if (!parseSettings(argc, argv, &settings))
+	{
+		printUsage();
+		result = 1;
+	}
+	else if (!packAssets(&settings))
+		result = 1;
+
+	exitJobSystem();
+	exitProfiler();
+	exitMemorySystem();
+	Log::Shutdown();
+	return result;
+}
@@ -0,0 +1,12 @@
+#version 450
+
+layout(location = 0) in vec3 inNormal;
+
+layout(location = 0) out vec4 outColor;
+
+void main()
+{
+	// 固定方向光, 只用于区分朝向
+	float diffuse = max(dot(normalize(inNormal), normalize(vec3(0.4, 0.8, 0.4))), 0.0);
+	outColor = vec4(vec3(0.15 + 0.85 * diffuse), 1.0);
+}
@@ -0,0 +1,19 @@
+#version 450
+
+// meshes 场景: 未压缩的 MeshVertex, 每个实例推送一次世界视图投影矩阵
+layout(location = 0) in vec3 inPosition;
+layout(location = 1) in vec3 inNormal;
+layout(location = 2) in vec2 inTexCoord;
+
+layout(push_constant) uniform PushConstants
+{
+	mat4 mWorldViewProjection;
+} pushConstants;
+
+layout(location = 0) out vec3 outNormal;
+
+void main()
+{
+	gl_Position = pushConstants.mWorldViewProjection * vec4(inPosition, 1.0);
+	outNormal = inNormal;
+}
@@ -0,0 +1,429 @@
+﻿#include "Core/Log.h"
+#include "Core/Memory.h"
+#include "Core/Profiler.h"
+#include "Renderer/Renderer.h"
+#include "Renderer/GpuProfiler.h"
+#include "ImGui/UI.h"
+
+#include "BenchmarkScenes.h"
+#include "BenchmarkReport.h"
+
+#include <string>
+
+// 同时在途的帧数, 也是 GPU 计时器的环形缓冲数量
+const uint32_t BENCHMARK_FRAMES_IN_FLIGHT = 2;
+
+// 进程退出码, 供 CI 判断结果
+const int BENCHMARK_EXIT_SUCCESS = 0;
+const int BENCHMARK_EXIT_REGRESSION = 1;
+const int BENCHMARK_EXIT_ERROR = 2;
+
+/// <summary>
+/// 命令行参数
+/// </summary>
+typedef struct BenchmarkSettings
+{
+	std::vector<BenchmarkSceneDesc>	mScenes;
+	uint32_t						mWarmupFrames = 60;
+	uint32_t						mMeasuredFrames = 300;
+	uint32_t						mWidth = 1280;
+	uint32_t						mHeight = 720;
+	const char*						pGpuName = NULL;
+	bool							mSoftware = false;
+	const char*						pShaderDirectory = "shaders";
+	const char*						pOutputPrefix = "benchmark";
+	const char*						pBaselineFile = NULL;
+	double							mTolerance = 0.10;
+} BenchmarkSettings;
+
+static void printUsage()
+{
+	printf(
+		"Usage: Benchmark [options]\n"
+		"  --scene <type:count>   draws, pipelines, textures, ui, meshes, clusters or clusters_cpu, repeatable\n"
+		"                         (default draws:1000 pipelines:64 textures:64 ui:50 meshes:256 clusters:256\n"
+		"                         clusters_cpu:256)\n"
+		"  --warmup <frames>      frames run before measuring (60)\n"
+		"  --frames <frames>      measured frames per scene (300)\n"
+		"  --width <pixels>       render target width (1280)\n"
+		"  --height <pixels>      render target height (720)\n"
+		"  --gpu <name>           select the GPU whose name contains <name>\n"
+		"  --software             run on a software rasterizer (lavapipe, SwiftShader)\n"
+		"  --shaders <dir>        directory holding vert.spv, frag.spv, the mesh_*.spv shaders and cluster_cull.spv (shaders)\n"
+		"  --output <prefix>      writes <prefix>.json and <prefix>.csv (benchmark)\n"
+		"  --baseline <file.csv>  compare against a previous .csv, exit 1 on regression\n"
+		"  --tolerance <ratio>    allowed relative slowdown against the baseline (0.10)\n");
+}
+
+static bool parseSettings(int argc, char** argv, BenchmarkSettings* pSettings)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "--software")
+		{
+			pSettings->mSoftware = true;
+			continue;
+		}
+		if (arg == "--help" || i + 1 >= argc)
+			return false;
+
+		const char* pValue = argv[++i];
+		if (arg == "--scene")
+		{
+			BenchmarkSceneDesc sceneDesc = {};
+			if (!parseBenchmarkScene(pValue, &sceneDesc))
+			{
+				SHEN_CLIENT_ERROR("invalid scene {0}, expected <type:count>", pValue);
+				return false;
+			}
+			pSettings->mScenes.push_back(sceneDesc);
+		}
+		else if (arg == "--warmup")
+			pSettings->mWarmupFrames = (uint32_t)atoi(pValue);
+		else if (arg == "--frames")
+			pSettings->mMeasuredFrames = (uint32_t)atoi(pValue);
+		else if (arg == "--width")
+			pSettings->mWidth = (uint32_t)atoi(pValue);
+		else if (arg == "--height")
+			pSettings->mHeight = (uint32_t)atoi(pValue);
+		else if (arg == "--gpu")
+			pSettings->pGpuName = pValue;
+		else if (arg == "--shaders")
+			pSettings->pShaderDirectory = pValue;
+		else if (arg == "--output")
+			pSettings->pOutputPrefix = pValue;
+		else if (arg == "--baseline")
+			pSettings->pBaselineFile = pValue;
+		else if (arg == "--tolerance")
+			pSettings->mTolerance = atof(pValue);
+		else
+		{
+			SHEN_CLIENT_ERROR("unknown option {0}", arg);
+			return false;
+		}
+	}
+
+	if (pSettings->mMeasuredFrames == 0 || pSettings->mWidth == 0 || pSettings->mHeight == 0)
+	{
+		SHEN_CLIENT_ERROR("--frames, --width and --height must be greater than 0");
+		return false;
+	}
+	if (pSettings->mScenes.empty())
+	{
+		pSettings->mScenes = {
+			{ BENCHMARK_SCENE_DRAWS, 1000 },
+			{ BENCHMARK_SCENE_PIPELINES, 64 },
+			{ BENCHMARK_SCENE_TEXTURES, 64 },
+			{ BENCHMARK_SCENE_UI, 50 },
+			{ BENCHMARK_SCENE_MESHES, 256 },
+			{ BENCHMARK_SCENE_CLUSTERS, 256 },
+			{ BENCHMARK_SCENE_CLUSTERS_CPU, 256 },
+		};
+	}
+	return true;
+}
+
+static bool fileExists(const std::string& path)
+{
+	FILE* pFile = fopen(path.c_str(), "rb");
+	if (!pFile)
+		return false;
+	fclose(pFile);
+	return true;
+}
+
+/// <summary>
+/// 所有内存分类的累计分配次数与字节数
+/// </summary>
+static void getTotalAllocations(uint64_t* pOutAllocations, uint64_t* pOutBytes, uint64_t* pOutPeakBytes)
+{
+	*pOutAllocations = 0;
+	*pOutBytes = 0;
+	*pOutPeakBytes = 0;
+	for (uint32_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i)
+	{
+		MemoryCategoryStats stats;
+		getMemoryStats((MemoryCategory)i, &stats);
+		*pOutAllocations += stats.mTotalAllocations;
+		*pOutBytes += stats.mTotalBytesAllocated;
+		*pOutPeakBytes += stats.mPeakBytes;
+	}
+}
+
+/// <summary>
+/// 运行单个场景: 预热帧, 测量帧, 再多跑几帧以回读最后几个测量帧的 GPU 计时
+/// </summary>
+static void runBenchmarkScene(const BenchmarkContext* pContext, Cmd** ppCmds, Fence** ppFences,
+	const BenchmarkSceneDesc* pSceneDesc, const BenchmarkSettings* pSettings, BenchmarkSceneResult* pOutResult)
+{
+	BenchmarkScene* pScene;
+	addBenchmarkScene(pContext, pSceneDesc, &pScene);
+	const char* pSceneName = getBenchmarkSceneName(pScene);
+	SHEN_CLIENT_INFO("running scene {0}", pSceneName);
+
+	memset(pOutResult, 0, sizeof(BenchmarkSceneResult));
+	strncpy(pOutResult->mName, pSceneName, sizeof(pOutResult->mName) - 1);
+
+	std::vector<double> frameSamples;
+	std::vector<double> cpuSamples;
+	std::vector<double> gpuSamples;
+	frameSamples.reserve(pSettings->mMeasuredFrames);
+	cpuSamples.reserve(pSettings->mMeasuredFrames);
+	gpuSamples.reserve(pSettings->mMeasuredFrames);
+
+	// 测量帧对应的 GPU 帧序号范围, 过滤预热帧与收尾帧的结果
+	uint64_t firstGpuFrame = UINT64_MAX;
+	uint64_t lastGpuFrame = 0;
+	uint64_t lastReadGpuFrame = UINT64_MAX;
+	uint64_t allocationsBegin = 0, bytesBegin = 0, peakBytes = 0;
+	uint64_t allocationsEnd = 0, bytesEnd = 0;
+
+	const uint32_t measureBegin = pSettings->mWarmupFrames;
+	const uint32_t measureEnd = measureBegin + pSettings->mMeasuredFrames;
+	const uint32_t frameCount = measureEnd + BENCHMARK_FRAMES_IN_FLIGHT;
+	for (uint32_t frame = 0; frame < frameCount; ++frame)
+	{
+		SHEN_PROFILE_FRAME();
+		bool measured = frame >= measureBegin && frame < measureEnd;
+		if (frame == measureBegin)
+		{
+			// 峰值从测量开始统计, 场景资源已包含在当前占用中
+			resetMemoryPeakStats();
+			getTotalAllocations(&allocationsBegin, &bytesBegin, &peakBytes);
+		}
+
+		uint64_t frameBegin = profilerGetTicks();
+		uint32_t slot = frame % BENCHMARK_FRAMES_IN_FLIGHT;
+		waitForFences(pContext->pRenderer, 1, &ppFences[slot]);
+
+		uint64_t cpuBegin = profilerGetTicks();
+		updateBenchmarkScene(pScene, frame);
+
+		Cmd* pCmd = ppCmds[slot];
+		beginCmd(pCmd);
+		cmdBeginGpuFrameProfile(pCmd);
+		cmdBeginGpuTimestampQuery(pCmd, pSceneName);
+		cmdDrawBenchmarkScene(pCmd, pScene);
+		cmdEndGpuTimestampQuery(pCmd);
+		cmdEndGpuFrameProfile(pCmd);
+		endCmd(pCmd);
+
+		uint64_t gpuFrame = 0;
+		if (measured && getGpuProfileFrameIndex(pContext->pQueue, &gpuFrame))
+		{
+			if (firstGpuFrame == UINT64_MAX)
+				firstGpuFrame = gpuFrame;
+			lastGpuFrame = gpuFrame;
+		}
+
+		QueueSubmitDesc submitDesc = {};
+		submitDesc.mCmdCount = 1;
+		submitDesc.ppCmds = &pCmd;
+		submitDesc.pSignalFence = ppFences[slot];
+		queueSubmit(pContext->pQueue, &submitDesc);
+		// 无交换链时没有 queuePresent, 由这里结束渲染器帧统计
+		endRendererFrame(pContext->pRenderer);
+		uint64_t frameEnd = profilerGetTicks();
+
+		GpuProfileResults gpuResults;
+		if (getGpuProfileResults(pContext->pQueue, &gpuResults) && gpuResults.mTimerCount > 0 &&
+			gpuResults.mFrameIndex != lastReadGpuFrame &&
+			gpuResults.mFrameIndex >= firstGpuFrame && gpuResults.mFrameIndex <= lastGpuFrame)
+		{
+			lastReadGpuFrame = gpuResults.mFrameIndex;
+			gpuSamples.push_back(gpuResults.pTimers[0].mMilliseconds);
+		}
+
+		if (measured)
+		{
+			frameSamples.push_back(profilerTicksToMilliseconds(frameEnd - frameBegin));
+			cpuSamples.push_back(profilerTicksToMilliseconds(frameEnd - cpuBegin));
+		}
+		if (frame + 1 == measureEnd)
+		{
+			getTotalAllocations(&allocationsEnd, &bytesEnd, &peakBytes);
+			getRendererStats(pContext->pRenderer, &pOutResult->mRendererStats);
+		}
+	}
+	waitQueueIdle(pContext->pQueue);
+	removeBenchmarkScene(pContext, pScene);
+
+	computeBenchmarkStatistics(frameSamples, &pOutResult->mFrameMilliseconds);
+	computeBenchmarkStatistics(cpuSamples, &pOutResult->mCpuMilliseconds);
+	computeBenchmarkStatistics(gpuSamples, &pOutResult->mGpuMilliseconds);
+	pOutResult->mGpuSampleCount = (uint32_t)gpuSamples.size();
+	pOutResult->mAllocationsPerFrame = (double)(allocationsEnd - allocationsBegin) / pSettings->mMeasuredFrames;
+	pOutResult->mBytesAllocatedPerFrame = (double)(bytesEnd - bytesBegin) / pSettings->mMeasuredFrames;
+	pOutResult->mPeakTrackedBytes = peakBytes;
+}
+
+static int runBenchmark(const BenchmarkSettings* pSettings)
+{
+	//网格类场景使用自己的着色器, clusters 场景还需要簇剔除计算着色器, 只在需要时检查
+	std::vector<std::string> shaderFiles = { "vert.spv", "frag.spv" };
+	bool meshShaders = false;
+	bool cullShader = false;
+	for (const BenchmarkSceneDesc& sceneDesc : pSettings->mScenes)
+	{
+		meshShaders |= sceneDesc.mType == BENCHMARK_SCENE_MESHES || sceneDesc.mType == BENCHMARK_SCENE_CLUSTERS ||
+			sceneDesc.mType == BENCHMARK_SCENE_CLUSTERS_CPU;
+		cullShader |= sceneDesc.mType == BENCHMARK_SCENE_CLUSTERS;
+	}
+	if (meshShaders)
+	{
+		shaderFiles.push_back("mesh_vert.spv");
+		shaderFiles.push_back("mesh_frag.spv");
+	}
+	if (cullShader)
+		shaderFiles.push_back("cluster_cull.spv");
+	for (const std::string& shaderFile : shaderFiles)
+	{
+		std::string shaderPath = std::string(pSettings->pShaderDirectory) + "/" + shaderFile;
+		if (!fileExists(shaderPath))
+		{
+			SHEN_CLIENT_ERROR("missing {0}, pass the shader directory with --shaders", shaderPath);
+			return BENCHMARK_EXIT_ERROR;
+		}
+	}
+
+	//UI 上下文需要先于渲染器创建
+	platformInitUserInterface();
+
+	//无窗口初始化 Instance 到 LogicalDevice
+	RendererDesc rendererDesc;
+	memset(&rendererDesc, 0, sizeof(rendererDesc));
+	rendererDesc.pGpuName = pSettings->pGpuName;
+	rendererDesc.mForceSoftwareRasterizer = pSettings->mSoftware;
+	Renderer* pRenderer = NULL;
+	SwapChain* pSwapChain = NULL;
+	std::vector<Texture> swapChainTextures;
+	initRenderer("Benchmark", &rendererDesc, &pRenderer, NULL, &pSwapChain, swapChainTextures);
+	if (!pRenderer)
+		return BENCHMARK_EXIT_ERROR;
+	SHEN_CLIENT_INFO("benchmark device: {0}", pRenderer->mCapabilities.mDeviceName);
+
+	QueueDesc queueDesc = {};
+	queueDesc.mType = QUEUE_TYPE_GRAPHICS;
+	queueDesc.mFlag = QUEUE_FLAG_INIT_MICROPROFILE;
+	queueDesc.mGpuProfilerFrameCount = BENCHMARK_FRAMES_IN_FLIGHT;
+	Queue* pQueue = NULL;
+	addQueue(pRenderer, &queueDesc, &pQueue);
+
+	CmdPoolDesc cmdPoolDesc = {};
+	cmdPoolDesc.pQueue = pQueue;
+	CmdPool* pCmdPool = NULL;
+	addCmdPool(pRenderer, &cmdPoolDesc, &pCmdPool);
+
+	Cmd* pCmds[BENCHMARK_FRAMES_IN_FLIGHT] = { NULL };
+	Fence* pFences[BENCHMARK_FRAMES_IN_FLIGHT] = { NULL };
+	CmdDesc cmdDesc = {};
+	cmdDesc.pPool = pCmdPool;
+	for (uint32_t i = 0; i < BENCHMARK_FRAMES_IN_FLIGHT; ++i)
+	{
+		addCmd(pRenderer, &cmdDesc, &pCmds[i]);
+		addFence(pRenderer, &pFences[i]);
+	}
+
+	RenderTargetDesc renderTargetDesc = {};
+	renderTargetDesc.mWidth = pSettings->mWidth;
+	renderTargetDesc.mHeight = pSettings->mHeight;
+	renderTargetDesc.mFormat = VK_FORMAT_R8G8B8A8_UNORM;
+	Texture* pRenderTarget = NULL;
+	addRenderTarget(pRenderer, &renderTargetDesc, &pRenderTarget);
+
+	//初始化UI 接口, 绘制到离屏渲染目标
+	UserInterfaceDesc uiRenderDesc = {};
+	uiRenderDesc.pRenderer = pRenderer;
+	uiRenderDesc.pGraphicsQueue = pQueue;
+	uiRenderDesc.pCmdPool = pCmdPool;
+	uiRenderDesc.mColorFormat = renderTargetDesc.mFormat;
+	uiRenderDesc.mWidth = renderTargetDesc.mWidth;
+	uiRenderDesc.mHeight = renderTargetDesc.mHeight;
+	initUserInterface(&uiRenderDesc);
+
+	BenchmarkContext context = {};
+	context.pRenderer = pRenderer;
+	context.pQueue = pQueue;
+	context.pCmdPool = pCmdPool;
+	context.pRenderTarget = pRenderTarget;
+	context.pShaderDirectory = pSettings->pShaderDirectory;
+	context.mFramesInFlight = BENCHMARK_FRAMES_IN_FLIGHT;
+
+	std::vector<BenchmarkSceneResult> results(pSettings->mScenes.size());
+	for (size_t i = 0; i < pSettings->mScenes.size(); ++i)
+		runBenchmarkScene(&context, pCmds, pFences, &pSettings->mScenes[i], pSettings, &results[i]);
+
+	for (uint32_t i = 0; i < BENCHMARK_FRAMES_IN_FLIGHT; ++i)
+	{
+		removeFence(pRenderer, pFences[i]);
+		removeCmd(pRenderer, pCmds[i]);
+	}
+	removeRenderTarget(pRenderer, pRenderTarget);
+
+	fmt::print("{0:<20} {1:>10} {2:>10} {3:>10} {4:>10} {5:>12} {6:>14}\n",
+		"scene", "cpu p50", "cpu p95", "gpu p50", "gpu p95", "allocs/frame", "peak bytes");
+	for (const BenchmarkSceneResult& result : results)
+	{
+		fmt::print("{0:<20} {1:>10.3f} {2:>10.3f} {3:>10.3f} {4:>10.3f} {5:>12.1f} {6:>14}\n",
+			result.mName, result.mCpuMilliseconds.mP50, result.mCpuMilliseconds.mP95,
+			result.mGpuMilliseconds.mP50, result.mGpuMilliseconds.mP95,
+			result.mAllocationsPerFrame, result.mPeakTrackedBytes);
+	}
+
+	BenchmarkReportDesc reportDesc = {};
+	reportDesc.pDeviceName = pRenderer->mCapabilities.mDeviceName;
+	reportDesc.mWidth = pSettings->mWidth;
+	reportDesc.mHeight = pSettings->mHeight;
+	reportDesc.mWarmupFrames = pSettings->mWarmupFrames;
+	reportDesc.mMeasuredFrames = pSettings->mMeasuredFrames;
+	std::string jsonFile = std::string(pSettings->pOutputPrefix) + ".json";
+	std::string csvFile = std::string(pSettings->pOutputPrefix) + ".csv";
+	writeBenchmarkJson(jsonFile.c_str(), &reportDesc, results);
+	writeBenchmarkCsv(csvFile.c_str(), results);
+	fmt::print("wrote {0} and {1}\n", jsonFile, csvFile);
+
+	if (!pSettings->pBaselineFile)
+		return BENCHMARK_EXIT_SUCCESS;
+
+	uint32_t regressionCount = compareBenchmarkBaseline(pSettings->pBaselineFile, pSettings->mTolerance, results);
+	if (regressionCount > 0)
+	{
+		SHEN_CLIENT_ERROR("{0} metrics regressed beyond {1:.0f}% of {2}", regressionCount, pSettings->mTolerance * 100.0, pSettings->pBaselineFile);
+		return BENCHMARK_EXIT_REGRESSION;
+	}
+	fmt::print("no regressions against {0}\n", pSettings->pBaselineFile);
+	return BENCHMARK_EXIT_SUCCESS;
+}
+
+int main(int argc, char** argv)
+{
+	Log::Init();
+	initMemorySystem("Benchmark");
+	initProfiler();
+
+	int result = BENCHMARK_EXIT_ERROR;
+	BenchmarkSettings settings;
+	if (!parseSettings(argc, argv, &settings))
+	{
+		printUsage();
+	}
+	else
+	{
+		try
+		{
+			result = runBenchmark(&settings);
+		}
+		catch (const std::exception& e)
+		{
+			SHEN_CLIENT_ERROR("benchmark failed: {0}", e.what());
+			result = BENCHMARK_EXIT_ERROR;
+		}
+	}
+
+	// 与 Sandbox 一致, 渲染器没有 exitRenderer, 设备随进程退出释放
+	exitProfiler();
+	exitMemorySystem();
+	Log::Shutdown();
+	return result;
+}
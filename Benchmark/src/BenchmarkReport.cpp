@@ -0,0 +1,210 @@
+﻿#include "BenchmarkReport.h"
+#include "Core/Log.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include <set>
+#include <string>
+
+/// <summary>
+/// 写入报告和基线的单个指标
+/// </summary>
+typedef struct BenchmarkMetric
+{
+	const char*	pName;
+	double		mValue;
+	// 参与基线比较的指标
+	bool		mGated;
+	// 绝对容差, 避免接近 0 的指标因噪声被判为回退
+	double		mAbsoluteSlack;
+} BenchmarkMetric;
+
+static void getBenchmarkMetrics(const BenchmarkSceneResult& result, std::vector<BenchmarkMetric>& metrics)
+{
+	// GPU 指标只有在回读到结果时才参与比较, 软件设备或未开启计时器时记为 0
+	bool hasGpu = result.mGpuSampleCount > 0;
+	metrics = {
+		{ "frame_ms_mean",			result.mFrameMilliseconds.mMean,	false,	0.0 },
+		{ "frame_ms_p50",			result.mFrameMilliseconds.mP50,		false,	0.0 },
+		{ "frame_ms_p95",			result.mFrameMilliseconds.mP95,		false,	0.0 },
+		{ "frame_ms_p99",			result.mFrameMilliseconds.mP99,		false,	0.0 },
+		{ "frame_ms_max",			result.mFrameMilliseconds.mMax,		false,	0.0 },
+		{ "cpu_ms_mean",			result.mCpuMilliseconds.mMean,		false,	0.0 },
+		{ "cpu_ms_p50",				result.mCpuMilliseconds.mP50,		true,	0.05 },
+		{ "cpu_ms_p90",				result.mCpuMilliseconds.mP90,		false,	0.0 },
+		{ "cpu_ms_p95",				result.mCpuMilliseconds.mP95,		true,	0.05 },
+		{ "cpu_ms_p99",				result.mCpuMilliseconds.mP99,		false,	0.0 },
+		{ "cpu_ms_max",				result.mCpuMilliseconds.mMax,		false,	0.0 },
+		{ "gpu_ms_mean",			result.mGpuMilliseconds.mMean,		false,	0.0 },
+		{ "gpu_ms_p50",				result.mGpuMilliseconds.mP50,		hasGpu,	0.05 },
+		{ "gpu_ms_p90",				result.mGpuMilliseconds.mP90,		false,	0.0 },
+		{ "gpu_ms_p95",				result.mGpuMilliseconds.mP95,		hasGpu,	0.05 },
+		{ "gpu_ms_p99",				result.mGpuMilliseconds.mP99,		false,	0.0 },
+		{ "gpu_ms_max",				result.mGpuMilliseconds.mMax,		false,	0.0 },
+		{ "gpu_samples",			(double)result.mGpuSampleCount,		false,	0.0 },
+		{ "allocations_per_frame",	result.mAllocationsPerFrame,		true,	0.5 },
+		{ "bytes_allocated_per_frame",	result.mBytesAllocatedPerFrame,	false,	0.0 },
+		{ "peak_tracked_bytes",		(double)result.mPeakTrackedBytes,	true,	64.0 * 1024.0 },
+		{ "draw_calls",				(double)result.mRendererStats.mDrawCalls,		false,	0.0 },
+		{ "dispatch_calls",			(double)result.mRendererStats.mDispatchCalls,	false,	0.0 },
+		{ "vertices",				(double)result.mRendererStats.mVertices,		false,	0.0 },
+		{ "instances",				(double)result.mRendererStats.mInstances,		false,	0.0 },
+		{ "pipeline_binds",			(double)result.mRendererStats.mPipelineBinds,	false,	0.0 },
+		{ "descriptor_binds",		(double)result.mRendererStats.mDescriptorBinds,	false,	0.0 },
+		{ "buffer_binds",			(double)result.mRendererStats.mBufferBinds,		false,	0.0 },
+		{ "barriers",				(double)result.mRendererStats.mBarriers,		false,	0.0 },
+		{ "render_passes",			(double)result.mRendererStats.mRenderPasses,	false,	0.0 },
+		{ "queue_submits",			(double)result.mRendererStats.mQueueSubmits,	false,	0.0 },
+		{ "bytes_uploaded",			(double)result.mRendererStats.mBytesUploaded,	false,	0.0 },
+		{ "descriptor_sets_allocated",	(double)result.mRendererStats.mDescriptorSetsAllocated,	false,	0.0 },
+	};
+}
+
+void computeBenchmarkStatistics(std::vector<double>& samples, BenchmarkStatistics* pOutStatistics)
+{
+	memset(pOutStatistics, 0, sizeof(BenchmarkStatistics));
+	if (samples.empty())
+		return;
+
+	std::sort(samples.begin(), samples.end());
+	double sum = 0.0;
+	for (double sample : samples)
+		sum += sample;
+
+	auto percentile = [&samples](double p) {
+		size_t rank = (size_t)ceil(p * (double)samples.size());
+		return samples[rank > 0 ? rank - 1 : 0];
+	};
+	pOutStatistics->mMean = sum / (double)samples.size();
+	pOutStatistics->mP50 = percentile(0.50);
+	pOutStatistics->mP90 = percentile(0.90);
+	pOutStatistics->mP95 = percentile(0.95);
+	pOutStatistics->mP99 = percentile(0.99);
+	pOutStatistics->mMax = samples.back();
+}
+
+static void writeJsonString(FILE* pFile, const char* pText)
+{
+	fputc('"', pFile);
+	for (const char* c = pText; *c; ++c)
+	{
+		if (*c == '"' || *c == '\\')
+			fputc('\\', pFile);
+		if ((unsigned char)*c >= 0x20)
+			fputc(*c, pFile);
+	}
+	fputc('"', pFile);
+}
+
+void writeBenchmarkJson(const char* pFileName, const BenchmarkReportDesc* pDesc, const std::vector<BenchmarkSceneResult>& results)
+{
+	FILE* pFile = fopen(pFileName, "w");
+	if (!pFile)
+	{
+		SHEN_CLIENT_ERROR("failed to open benchmark report {0}", pFileName);
+		throw std::runtime_error("failed to open benchmark report!");
+	}
+
+	fprintf(pFile, "{\n\t\"device\": ");
+	writeJsonString(pFile, pDesc->pDeviceName);
+	fprintf(pFile, ",\n\t\"width\": %u,\n\t\"height\": %u,\n", pDesc->mWidth, pDesc->mHeight);
+	fprintf(pFile, "\t\"warmupFrames\": %u,\n\t\"measuredFrames\": %u,\n", pDesc->mWarmupFrames, pDesc->mMeasuredFrames);
+	fprintf(pFile, "\t\"scenes\": [");
+
+	std::vector<BenchmarkMetric> metrics;
+	for (size_t i = 0; i < results.size(); ++i)
+	{
+		fprintf(pFile, "%s\n\t\t{\n\t\t\t\"name\": ", i > 0 ? "," : "");
+		writeJsonString(pFile, results[i].mName);
+		getBenchmarkMetrics(results[i], metrics);
+		for (const BenchmarkMetric& metric : metrics)
+			fprintf(pFile, ",\n\t\t\t\"%s\": %.6g", metric.pName, metric.mValue);
+		fprintf(pFile, "\n\t\t}");
+	}
+	fprintf(pFile, "\n\t]\n}\n");
+	fclose(pFile);
+}
+
+void writeBenchmarkCsv(const char* pFileName, const std::vector<BenchmarkSceneResult>& results)
+{
+	FILE* pFile = fopen(pFileName, "w");
+	if (!pFile)
+	{
+		SHEN_CLIENT_ERROR("failed to open benchmark report {0}", pFileName);
+		throw std::runtime_error("failed to open benchmark report!");
+	}
+
+	fprintf(pFile, "scene,metric,value\n");
+	std::vector<BenchmarkMetric> metrics;
+	for (const BenchmarkSceneResult& result : results)
+	{
+		getBenchmarkMetrics(result, metrics);
+		for (const BenchmarkMetric& metric : metrics)
+			fprintf(pFile, "%s,%s,%.9g\n", result.mName, metric.pName, metric.mValue);
+	}
+	fclose(pFile);
+}
+
+uint32_t compareBenchmarkBaseline(const char* pBaselineFile, double tolerance, const std::vector<BenchmarkSceneResult>& results)
+{
+	FILE* pFile = fopen(pBaselineFile, "r");
+	if (!pFile)
+	{
+		SHEN_CLIENT_ERROR("failed to open benchmark baseline {0}", pBaselineFile);
+		throw std::runtime_error("failed to open benchmark baseline!");
+	}
+
+	// 键为 "场景/指标"
+	std::map<std::string, double> baseline;
+	std::set<std::string> baselineScenes;
+	char line[256];
+	while (fgets(line, sizeof(line), pFile))
+	{
+		char* pMetric = strchr(line, ',');
+		char* pValue = pMetric ? strchr(pMetric + 1, ',') : NULL;
+		if (!pValue)
+			continue;
+		*pMetric++ = '\0';
+		*pValue++ = '\0';
+		char* pEnd = NULL;
+		double value = strtod(pValue, &pEnd);
+		// 跳过表头和无法解析的行
+		if (pEnd == pValue)
+			continue;
+		baselineScenes.insert(line);
+		baseline[std::string(line) + "/" + pMetric] = value;
+	}
+	fclose(pFile);
+
+	uint32_t regressionCount = 0;
+	std::vector<BenchmarkMetric> metrics;
+	for (const BenchmarkSceneResult& result : results)
+	{
+		if (baselineScenes.find(result.mName) == baselineScenes.end())
+		{
+			SHEN_CLIENT_WARN("benchmark scene {0} has no baseline, skipped", result.mName);
+			continue;
+		}
+
+		getBenchmarkMetrics(result, metrics);
+		for (const BenchmarkMetric& metric : metrics)
+		{
+			if (!metric.mGated)
+				continue;
+			auto it = baseline.find(std::string(result.mName) + "/" + metric.pName);
+			if (it == baseline.end())
+				continue;
+
+			double limit = it->second * (1.0 + tolerance) + metric.mAbsoluteSlack;
+			if (metric.mValue > limit)
+			{
+				SHEN_CLIENT_ERROR("regression: {0} {1} = {2:.4f}, baseline {3:.4f}, limit {4:.4f}",
+					result.mName, metric.pName, metric.mValue, it->second, limit);
+				++regressionCount;
+			}
+		}
+	}
+	return regressionCount;
+}
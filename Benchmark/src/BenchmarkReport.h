@@ -0,0 +1,58 @@
+﻿#pragma once
+#include "Renderer/Renderer.h"
+
+#include <vector>
+
+/// <summary>
+/// 一组帧时间样本的统计量, 百分位数取最近秩
+/// </summary>
+typedef struct BenchmarkStatistics
+{
+	double mMean;
+	double mP50;
+	double mP90;
+	double mP95;
+	double mP99;
+	double mMax;
+} BenchmarkStatistics;
+
+/// <summary>
+/// 单个场景的测量结果
+/// </summary>
+typedef struct BenchmarkSceneResult
+{
+	char				mName[64];
+	// 整帧 (含等待栅栏), 录制与提交, GPU 根区间, 单位毫秒
+	BenchmarkStatistics	mFrameMilliseconds;
+	BenchmarkStatistics	mCpuMilliseconds;
+	BenchmarkStatistics	mGpuMilliseconds;
+	// 回读到的 GPU 帧数, 队列未开启计时器时为 0
+	uint32_t			mGpuSampleCount;
+	// 测量帧内所有内存分类的分配次数与字节数之和除以帧数
+	double				mAllocationsPerFrame;
+	double				mBytesAllocatedPerFrame;
+	// 各分类峰值之和, 各分类峰值不一定出现在同一时刻, 是实际峰值的上界
+	uint64_t			mPeakTrackedBytes;
+	// 最后一个测量帧的渲染器计数
+	RendererStats		mRendererStats;
+} BenchmarkSceneResult;
+
+typedef struct BenchmarkReportDesc
+{
+	const char*	pDeviceName;
+	uint32_t	mWidth;
+	uint32_t	mHeight;
+	uint32_t	mWarmupFrames;
+	uint32_t	mMeasuredFrames;
+} BenchmarkReportDesc;
+
+// 会对 samples 排序, 样本为空时所有统计量为 0
+void computeBenchmarkStatistics(std::vector<double>& samples, BenchmarkStatistics* pOutStatistics);
+
+// 写出失败时抛出 std::runtime_error
+void writeBenchmarkJson(const char* pFileName, const BenchmarkReportDesc* pDesc, const std::vector<BenchmarkSceneResult>& results);
+// 每行 "scene,metric,value", 同时也是基线文件格式
+void writeBenchmarkCsv(const char* pFileName, const std::vector<BenchmarkSceneResult>& results);
+
+// 与 CSV 基线比较受控指标, 返回超出容差的指标数量; 基线无法读取时抛出 std::runtime_error
+uint32_t compareBenchmarkBaseline(const char* pBaselineFile, double tolerance, const std::vector<BenchmarkSceneResult>& results);
@@ -0,0 +1,682 @@
+﻿#include "BenchmarkScenes.h"
+#include "Core/Log.h"
+#include "Core/Memory.h"
+#include "ImGui/UI.h"
+#include "Renderer/Mesh.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <cmath>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+namespace fs = std::filesystem;
+
+// textures 场景中每个渲染目标的尺寸
+const uint32_t BENCHMARK_TEXTURE_SIZE = 256;
+// meshes 场景的单位球: 经线与纬线分段数, 约 1.2 万个三角形, 足以简化出多级 LOD
+const uint32_t BENCHMARK_MESH_SEGMENTS = 96;
+const uint32_t BENCHMARK_MESH_RINGS = 64;
+// 实例之间的间距 (世界单位), 实例排成向 -z 延伸的网格, 远处的实例会选到更粗的 LOD
+const float BENCHMARK_MESH_SPACING = 3.0f;
+const float BENCHMARK_MESH_FOV = glm::radians(60.0f);
+// LOD 选择允许的屏幕空间误差 (像素) 与滞后比例
+const float BENCHMARK_MESH_LOD_THRESHOLD = 1.0f;
+const float BENCHMARK_MESH_LOD_HYSTERESIS = 0.2f;
+// 球体顶点与索引 (含全部 LOD) 都远小于此
+const uint64_t BENCHMARK_GEOMETRY_BUFFER_SIZE = 8ull << 20;
+
+static const char* gSceneTypeNames[BENCHMARK_SCENE_COUNT] = {
+	"draws",
+	"pipelines",
+	"textures",
+	"ui",
+	"meshes",
+	"clusters",
+	"clusters_cpu",
+};
+
+struct BenchmarkScene
+{
+	BenchmarkSceneDesc		mDesc;
+	char					mName[64];
+	Texture*				pRenderTarget;
+	std::vector<Pipeline*>	mPipelines;
+	std::vector<Texture*>	mTextures;
+	// meshes 与 clusters 场景
+	GeometryBuffer*			pGeometryBuffer = NULL;
+	Mesh*					pMesh = NULL;
+	// 每个实例的位置, 上一帧的 LOD 与本帧的世界视图投影矩阵
+	std::vector<glm::vec3>	mInstancePositions;
+	std::vector<uint32_t>	mInstanceLods;
+	std::vector<glm::mat4>	mInstanceTransforms;
+	// clusters 与 clusters_cpu 场景: 每个在途帧一个间接命令缓冲, 每个实例占其中固定的一段
+	std::vector<Buffer*>	mIndirectBuffers;
+	uint32_t				mInstanceCommandCapacity = 0;
+	std::vector<uint32_t>	mInstanceCommandCounts;
+	uint32_t				mFrameSlot = 0;
+	// clusters 场景: 簇剔除计算管线, 每个在途帧的实例数据缓冲与描述符集, 本帧的推送常量
+	Pipeline*					pCullPipeline = NULL;
+	std::vector<Buffer*>		mCullInstanceBuffers;
+	std::vector<DescriptorSet*>	mCullDescriptorSets;
+	MeshClusterCullConstants	mCullConstants = {};
+};
+
+bool parseBenchmarkScene(const char* pText, BenchmarkSceneDesc* pOutDesc)
+{
+	const char* pSeparator = strchr(pText, ':');
+	if (!pSeparator)
+		return false;
+
+	std::string typeName(pText, pSeparator - pText);
+	char* pEnd = NULL;
+	unsigned long count = strtoul(pSeparator + 1, &pEnd, 10);
+	if (*pEnd != '\0' || count == 0)
+		return false;
+
+	for (uint32_t i = 0; i < BENCHMARK_SCENE_COUNT; ++i)
+	{
+		if (typeName == gSceneTypeNames[i])
+		{
+			pOutDesc->mType = (BenchmarkSceneType)i;
+			pOutDesc->mCount = (uint32_t)count;
+			return true;
+		}
+	}
+	return false;
+}
+
+const char* getBenchmarkSceneTypeName(BenchmarkSceneType type)
+{
+	return type < BENCHMARK_SCENE_COUNT ? gSceneTypeNames[type] : "unknown";
+}
+
+const char* getBenchmarkSceneName(const BenchmarkScene* pScene)
+{
+	return pScene->mName;
+}
+
+/// <summary>
+/// 创建与渲染目标格式匹配的管线, 着色器为 <pShaderPrefix>vert.spv 与 <pShaderPrefix>frag.spv
+/// </summary>
+static Pipeline* addScenePipeline(const BenchmarkContext* pContext, VkFormat colorFormat, const char* pShaderPrefix,
+	const VertexLayout* pVertexLayout, uint32_t pushConstantSize)
+{
+	std::string vertPath = std::string(pContext->pShaderDirectory) + "/" + pShaderPrefix + "vert.spv";
+	std::string fragPath = std::string(pContext->pShaderDirectory) + "/" + pShaderPrefix + "frag.spv";
+
+	ShaderDesc shaderDesc = {};
+	shaderDesc.mStages = SHADER_STAGE_VERT;
+	shaderDesc.pFileName = vertPath.c_str();
+	Shader* pVertShader;
+	addShader(pContext->pRenderer, &shaderDesc, &pVertShader);
+	shaderDesc.mStages = SHADER_STAGE_FRAG;
+	shaderDesc.pFileName = fragPath.c_str();
+	Shader* pFragShader;
+	addShader(pContext->pRenderer, &shaderDesc, &pFragShader);
+
+	PipelineDesc pipelineDesc = {};
+	pipelineDesc.mType = PIPELINE_TYPE_GRAPHICS;
+	pipelineDesc.mGraphicsDesc.pColorFormats = &colorFormat;
+	pipelineDesc.mGraphicsDesc.mRenderTargetCount = 1;
+	pipelineDesc.mGraphicsDesc.pShaderCount = 2;
+	pipelineDesc.mGraphicsDesc.pShaders[0] = pVertShader;
+	pipelineDesc.mGraphicsDesc.pShaders[1] = pFragShader;
+	pipelineDesc.mGraphicsDesc.pVertexLayout = pVertexLayout;
+	pipelineDesc.mGraphicsDesc.mPushConstantSize = pushConstantSize;
+	Pipeline* pPipeline;
+	addPipeline(pContext->pRenderer, &pipelineDesc, &pPipeline);
+
+	removeShader(pContext->pRenderer, pVertShader);
+	removeShader(pContext->pRenderer, pFragShader);
+	return pPipeline;
+}
+
+// 三角形管线不使用顶点输入, 顶点由着色器按 gl_VertexIndex 生成
+static Pipeline* addTrianglePipeline(const BenchmarkContext* pContext, VkFormat colorFormat)
+{
+	return addScenePipeline(pContext, colorFormat, "", NULL, 0);
+}
+
+// 簇剔除计算管线, 着色器为 cluster_cull.spv, 绑定簇表, 实例数据与间接命令三个存储缓冲
+static Pipeline* addClusterCullPipeline(const BenchmarkContext* pContext)
+{
+	std::string shaderPath = std::string(pContext->pShaderDirectory) + "/cluster_cull.spv";
+	ShaderDesc shaderDesc = {};
+	shaderDesc.mStages = SHADER_STAGE_COMP;
+	shaderDesc.pFileName = shaderPath.c_str();
+	Shader* pShader;
+	addShader(pContext->pRenderer, &shaderDesc, &pShader);
+
+	PipelineDesc pipelineDesc = {};
+	pipelineDesc.mType = PIPELINE_TYPE_COMPUTE;
+	pipelineDesc.mComputeDesc.pShader = pShader;
+	pipelineDesc.mComputeDesc.mStorageBufferCount = 3;
+	pipelineDesc.mComputeDesc.mPushConstantSize = sizeof(MeshClusterCullConstants);
+	Pipeline* pPipeline;
+	addPipeline(pContext->pRenderer, &pipelineDesc, &pPipeline);
+
+	removeShader(pContext->pRenderer, pShader);
+	return pPipeline;
+}
+
+/// <summary>
+/// 写出单位球 OBJ, 南北半球分为两个对象 (两个子网格), 极点处退化的三角形不写出
+/// 三角形从球外看为逆时针, 投影到 y 轴朝下的帧缓冲后为顺时针, 与管线默认的正面朝向一致
+/// </summary>
+static void writeSphereObj(const char* pFileName)
+{
+	FILE* pFile = fopen(pFileName, "wb");
+	if (!pFile)
+	{
+		SHEN_CLIENT_ERROR("failed to create {0}", pFileName);
+		throw std::runtime_error("failed to create benchmark mesh!");
+	}
+
+	const float pi = 3.14159265358979f;
+	fprintf(pFile, "# unit sphere for the meshes benchmark scene\n");
+	for (uint32_t ring = 0; ring <= BENCHMARK_MESH_RINGS; ++ring)
+	{
+		float theta = pi * (float)ring / BENCHMARK_MESH_RINGS;
+		for (uint32_t segment = 0; segment <= BENCHMARK_MESH_SEGMENTS; ++segment)
+		{
+			float phi = 2.0f * pi * (float)segment / BENCHMARK_MESH_SEGMENTS;
+			float x = sinf(theta) * cosf(phi), y = cosf(theta), z = sinf(theta) * sinf(phi);
+			fprintf(pFile, "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.6f %.6f %.6f\n", x, y, z,
+				(float)segment / BENCHMARK_MESH_SEGMENTS, (float)ring / BENCHMARK_MESH_RINGS, x, y, z);
+		}
+	}
+
+	for (uint32_t ring = 0; ring < BENCHMARK_MESH_RINGS; ++ring)
+	{
+		if (ring == 0 || ring == BENCHMARK_MESH_RINGS / 2)
+			fprintf(pFile, "o %s\n", ring == 0 ? "north" : "south");
+		for (uint32_t segment = 0; segment < BENCHMARK_MESH_SEGMENTS; ++segment)
+		{
+			// OBJ 索引从 1 开始
+			uint32_t a = ring * (BENCHMARK_MESH_SEGMENTS + 1) + segment + 1;
+			uint32_t b = a + 1;
+			uint32_t c = a + BENCHMARK_MESH_SEGMENTS + 1;
+			uint32_t d = c + 1;
+			if (ring != 0)
+				fprintf(pFile, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", a, a, a, b, b, b, c, c, c);
+			if (ring != BENCHMARK_MESH_RINGS - 1)
+				fprintf(pFile, "f %u/%u/%u %u/%u/%u %u/%u/%u\n", b, b, b, d, d, d, c, c, c);
+		}
+	}
+	fclose(pFile);
+}
+
+static void updateMeshScene(BenchmarkScene* pScene, uint32_t frameIndex);
+static void verifyClusterCulling(const BenchmarkContext* pContext, BenchmarkScene* pScene);
+
+/// <summary>
+/// 导入球体网格 (meshes 场景生成 LOD, clusters 场景生成簇), 实例排成 columns x rows 的网格
+/// clusters 场景的间接命令由计算着色器写出, 创建后先与 CPU 参考实现对比一帧的可见簇
+/// </summary>
+static void addMeshScene(const BenchmarkContext* pContext, BenchmarkScene* pScene)
+{
+	bool gpuCulling = pScene->mDesc.mType == BENCHMARK_SCENE_CLUSTERS;
+	bool clusters = gpuCulling || pScene->mDesc.mType == BENCHMARK_SCENE_CLUSTERS_CPU;
+	GeometryBufferDesc geometryBufferDesc = {};
+	geometryBufferDesc.mVertexBufferSize = BENCHMARK_GEOMETRY_BUFFER_SIZE;
+	geometryBufferDesc.mIndexBufferSize = BENCHMARK_GEOMETRY_BUFFER_SIZE;
+	addGeometryBuffer(pContext->pRenderer, &geometryBufferDesc, &pScene->pGeometryBuffer);
+
+	std::string fileName = (fs::temp_directory_path() / "shen_benchmark_sphere.obj").string();
+	writeSphereObj(fileName.c_str());
+	MeshDesc meshDesc = {};
+	meshDesc.pFileName = fileName.c_str();
+	meshDesc.pGeometryBuffer = pScene->pGeometryBuffer;
+	meshDesc.pQueue = pContext->pQueue;
+	meshDesc.mFlags = clusters ? MESH_LOAD_FLAG_GENERATE_CLUSTERS : MESH_LOAD_FLAG_GENERATE_LODS;
+	addMesh(pContext->pRenderer, &meshDesc, &pScene->pMesh);
+	std::error_code removeError;
+	fs::remove(fileName, removeError);
+
+	uint32_t count = pScene->mDesc.mCount;
+	uint32_t columns = (uint32_t)ceilf(sqrtf((float)count));
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		float x = ((float)(i % columns) - (float)(columns - 1) * 0.5f) * BENCHMARK_MESH_SPACING;
+		float z = -(float)(i / columns) * BENCHMARK_MESH_SPACING;
+		pScene->mInstancePositions.push_back(glm::vec3(x, 0.0f, z));
+	}
+	// 每帧的更新只写入预先分配的数组, 不计入每帧分配次数
+	pScene->mInstanceLods.assign(count, 0);
+	pScene->mInstanceTransforms.resize(count);
+
+	if (clusters)
+	{
+		const Mesh* pMesh = pScene->pMesh;
+		if (gpuCulling && pMesh->mClusterCount == 0)
+		{
+			SHEN_CLIENT_ERROR("the clusters scene needs a mesh with clusters");
+			throw std::runtime_error("benchmark mesh has no clusters!");
+		}
+		// GPU 剔除每个簇一个固定槽位, 绘制数恒为簇数; CPU 剔除合并相邻的可见簇, 绘制数每帧不同
+		pScene->mInstanceCommandCapacity = gpuCulling ? pMesh->mClusterCount : std::max(pMesh->mClusterCount, pMesh->mSubmeshCount);
+		pScene->mInstanceCommandCounts.assign(count, gpuCulling ? pMesh->mClusterCount : 0);
+		BufferDesc bufferDesc = {};
+		bufferDesc.mSize = (uint64_t)count * pScene->mInstanceCommandCapacity * sizeof(VkDrawIndexedIndirectCommand);
+		bufferDesc.mUsage = gpuCulling ? VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT :
+			VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+		bufferDesc.mMemoryUsage = gpuCulling ? RESOURCE_MEMORY_USAGE_GPU_ONLY : RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+		for (uint32_t i = 0; i < pContext->mFramesInFlight; ++i)
+		{
+			Buffer* pBuffer;
+			addBuffer(pContext->pRenderer, &bufferDesc, &pBuffer);
+			pScene->mIndirectBuffers.push_back(pBuffer);
+		}
+	}
+	if (gpuCulling)
+	{
+		pScene->pCullPipeline = addClusterCullPipeline(pContext);
+		BufferDesc instanceBufferDesc = {};
+		instanceBufferDesc.mSize = (uint64_t)count * sizeof(MeshClusterCullInstance);
+		instanceBufferDesc.mUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT;
+		instanceBufferDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+		DescriptorSetDesc descriptorSetDesc = {};
+		descriptorSetDesc.pPipeline = pScene->pCullPipeline;
+		for (uint32_t i = 0; i < pContext->mFramesInFlight; ++i)
+		{
+			Buffer* pInstanceBuffer;
+			addBuffer(pContext->pRenderer, &instanceBufferDesc, &pInstanceBuffer);
+			pScene->mCullInstanceBuffers.push_back(pInstanceBuffer);
+			DescriptorSet* pDescriptorSet;
+			addDescriptorSet(pContext->pRenderer, &descriptorSetDesc, &pDescriptorSet);
+			pScene->mCullDescriptorSets.push_back(pDescriptorSet);
+			Buffer* pBuffers[3] = { pScene->pMesh->pClusterBuffer, pInstanceBuffer, pScene->mIndirectBuffers[i] };
+			updateDescriptorSet(pContext->pRenderer, pDescriptorSet, 3, pBuffers);
+		}
+	}
+
+	VkFormat colorFormat = pContext->pRenderTarget->mFormat;
+	pScene->mPipelines.push_back(addScenePipeline(pContext, colorFormat, "mesh_", getMeshVertexLayout(), sizeof(glm::mat4)));
+
+	if (gpuCulling)
+		verifyClusterCulling(pContext, pScene);
+}
+
+void addBenchmarkScene(const BenchmarkContext* pContext, const BenchmarkSceneDesc* pDesc, BenchmarkScene** ppScene)
+{
+	BenchmarkScene* pScene = shen_new(MEMORY_CATEGORY_ASSETS, BenchmarkScene);
+	pScene->mDesc = *pDesc;
+	pScene->pRenderTarget = pContext->pRenderTarget;
+	snprintf(pScene->mName, sizeof(pScene->mName), "%s_%u", getBenchmarkSceneTypeName(pDesc->mType), pDesc->mCount);
+
+	VkFormat colorFormat = pContext->pRenderTarget->mFormat;
+	switch (pDesc->mType)
+	{
+	case BENCHMARK_SCENE_DRAWS:
+		pScene->mPipelines.push_back(addTrianglePipeline(pContext, colorFormat));
+		break;
+	case BENCHMARK_SCENE_PIPELINES:
+		// 每条管线都是独立创建的对象, 驱动无法合并绑定
+		for (uint32_t i = 0; i < pDesc->mCount; ++i)
+			pScene->mPipelines.push_back(addTrianglePipeline(pContext, colorFormat));
+		break;
+	case BENCHMARK_SCENE_TEXTURES:
+	{
+		pScene->mPipelines.push_back(addTrianglePipeline(pContext, colorFormat));
+		RenderTargetDesc renderTargetDesc = {};
+		renderTargetDesc.mWidth = BENCHMARK_TEXTURE_SIZE;
+		renderTargetDesc.mHeight = BENCHMARK_TEXTURE_SIZE;
+		renderTargetDesc.mFormat = colorFormat;
+		for (uint32_t i = 0; i < pDesc->mCount; ++i)
+		{
+			Texture* pTexture;
+			addRenderTarget(pContext->pRenderer, &renderTargetDesc, &pTexture);
+			pScene->mTextures.push_back(pTexture);
+		}
+		break;
+	}
+	case BENCHMARK_SCENE_MESHES:
+	case BENCHMARK_SCENE_CLUSTERS:
+	case BENCHMARK_SCENE_CLUSTERS_CPU:
+		addMeshScene(pContext, pScene);
+		break;
+	case BENCHMARK_SCENE_UI:
+	default:
+		break;
+	}
+	*ppScene = pScene;
+}
+
+void removeBenchmarkScene(const BenchmarkContext* pContext, BenchmarkScene* pScene)
+{
+	for (Pipeline* pPipeline : pScene->mPipelines)
+		removePipeline(pContext->pRenderer, pPipeline);
+	for (Texture* pTexture : pScene->mTextures)
+		removeRenderTarget(pContext->pRenderer, pTexture);
+	for (DescriptorSet* pDescriptorSet : pScene->mCullDescriptorSets)
+		removeDescriptorSet(pContext->pRenderer, pDescriptorSet);
+	for (Buffer* pBuffer : pScene->mCullInstanceBuffers)
+		removeBuffer(pContext->pRenderer, pBuffer);
+	if (pScene->pCullPipeline)
+		removePipeline(pContext->pRenderer, pScene->pCullPipeline);
+	for (Buffer* pBuffer : pScene->mIndirectBuffers)
+		removeBuffer(pContext->pRenderer, pBuffer);
+	if (pScene->pMesh)
+		removeMesh(pContext->pRenderer, pScene->pMesh);
+	if (pScene->pGeometryBuffer)
+		removeGeometryBuffer(pContext->pRenderer, pScene->pGeometryBuffer);
+	shen_delete(pScene);
+}
+
+/// <summary>
+/// 生成 N 个带常见控件的窗口, 按网格排布避免全部重叠后被裁剪
+/// </summary>
+static void buildBenchmarkUserInterface(uint32_t windowCount, uint32_t frameIndex)
+{
+	const float windowWidth = 220.0f;
+	const float windowHeight = 160.0f;
+	ImVec2 displaySize = ImGui::GetIO().DisplaySize;
+	uint32_t columns = (uint32_t)(displaySize.x / windowWidth);
+	if (columns == 0)
+		columns = 1;
+
+	float values[32];
+	for (uint32_t i = 0; i < 32; ++i)
+		values[i] = (float)((i * 7 + frameIndex) % 32);
+
+	char title[32];
+	for (uint32_t i = 0; i < windowCount; ++i)
+	{
+		float x = (float)(i % columns) * windowWidth;
+		float y = fmodf((float)(i / columns) * windowHeight, displaySize.y > windowHeight ? displaySize.y - windowHeight : 1.0f);
+		ImGui::SetNextWindowPos(ImVec2(x, y));
+		ImGui::SetNextWindowSize(ImVec2(windowWidth, windowHeight));
+		snprintf(title, sizeof(title), "Window %u", i);
+		ImGui::Begin(title, NULL, ImGuiWindowFlags_NoSavedSettings);
+		ImGui::Text("Frame %u", frameIndex);
+		float value = (float)((frameIndex + i) % 100);
+		ImGui::SliderFloat("Slider", &value, 0.0f, 100.0f);
+		ImGui::Button("Button");
+		ImGui::PlotLines("Plot", values, 32);
+		ImGui::ProgressBar(value / 100.0f);
+		ImGui::End();
+	}
+}
+
+/// <summary>
+/// 相机沿 x 轴往复平移并俯视实例网格, 按帧序号确定位置, 保证每次运行的 LOD 与可见簇分布相同
+/// </summary>
+static void getMeshSceneCamera(const BenchmarkScene* pScene, uint32_t frameIndex, glm::vec3* pEye, glm::mat4* pViewProjection)
+{
+	float width = (float)pScene->pRenderTarget->mWidth;
+	float height = (float)pScene->pRenderTarget->mHeight;
+	uint32_t count = pScene->mDesc.mCount;
+	uint32_t columns = (uint32_t)ceilf(sqrtf((float)count));
+	uint32_t rows = (count + columns - 1) / columns;
+
+	float sweep = (float)columns * BENCHMARK_MESH_SPACING * 0.5f;
+	glm::vec3 eye(sinf((float)frameIndex * 0.01f) * sweep, 4.0f, 6.0f);
+	glm::mat4 view = glm::lookAt(eye, eye + glm::vec3(0.0f, -0.3f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+	float farPlane = (float)(rows + columns) * BENCHMARK_MESH_SPACING + 10.0f;
+	*pViewProjection = glm::perspectiveRH_ZO(BENCHMARK_MESH_FOV, width / height, 0.1f, farPlane) * view;
+	*pEye = eye;
+}
+
+/// <summary>
+/// 逐实例计算世界视图投影矩阵, meshes 场景按包围球距离选择 LOD
+/// clusters_cpu 场景把可见簇的命令写入本帧的间接缓冲, clusters 场景只写入实例数据与推送常量, 剔除在录制时分派
+/// </summary>
+static void updateMeshScene(BenchmarkScene* pScene, uint32_t frameIndex)
+{
+	const Mesh* pMesh = pScene->pMesh;
+	float height = (float)pScene->pRenderTarget->mHeight;
+	uint32_t count = pScene->mDesc.mCount;
+	glm::vec3 eye;
+	glm::mat4 viewProjection;
+	getMeshSceneCamera(pScene, frameIndex, &eye, &viewProjection);
+
+	glm::vec3 boundsMin(pMesh->mBoundsMin[0], pMesh->mBoundsMin[1], pMesh->mBoundsMin[2]);
+	glm::vec3 boundsMax(pMesh->mBoundsMax[0], pMesh->mBoundsMax[1], pMesh->mBoundsMax[2]);
+	glm::vec3 boundsCenter = (boundsMin + boundsMax) * 0.5f;
+	float boundsRadius = glm::length(boundsMax - boundsMin) * 0.5f;
+
+	MeshLodSelectDesc lodDesc = {};
+	lodDesc.mScale = 1.0f;
+	lodDesc.mProjectionScale = getMeshLodProjectionScale(BENCHMARK_MESH_FOV, height);
+	lodDesc.mThresholdPixels = BENCHMARK_MESH_LOD_THRESHOLD;
+	lodDesc.mHysteresis = BENCHMARK_MESH_LOD_HYSTERESIS;
+
+	MeshClusterCullDesc cullDesc = {};
+	cullDesc.pViewProjectionMatrix = &viewProjection[0][0];
+	cullDesc.mCameraPosition[0] = eye.x;
+	cullDesc.mCameraPosition[1] = eye.y;
+	cullDesc.mCameraPosition[2] = eye.z;
+	cullDesc.mConeCulling = true;
+	VkDrawIndexedIndirectCommand* pCommands = NULL;
+	MeshClusterCullInstance* pCullInstances = NULL;
+	if (!pScene->mIndirectBuffers.empty())
+		pScene->mFrameSlot = frameIndex % (uint32_t)pScene->mIndirectBuffers.size();
+	if (pScene->mDesc.mType == BENCHMARK_SCENE_CLUSTERS_CPU)
+		pCommands = (VkDrawIndexedIndirectCommand*)pScene->mIndirectBuffers[pScene->mFrameSlot]->pCpuMappedAddress;
+	if (pScene->mDesc.mType == BENCHMARK_SCENE_CLUSTERS)
+	{
+		pCullInstances = (MeshClusterCullInstance*)pScene->mCullInstanceBuffers[pScene->mFrameSlot]->pCpuMappedAddress;
+		getMeshClusterCullConstants(pMesh, &cullDesc, count, &pScene->mCullConstants);
+	}
+
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		const glm::vec3& position = pScene->mInstancePositions[i];
+		glm::mat4 world = glm::translate(glm::mat4(1.0f), position);
+		pScene->mInstanceTransforms[i] = viewProjection * world;
+		if (pCommands)
+		{
+			cullDesc.pWorldMatrix = &world[0][0];
+			pScene->mInstanceCommandCounts[i] = cullMeshClusters(pMesh, &cullDesc, pCommands + (size_t)i * pScene->mInstanceCommandCapacity, NULL);
+		}
+		else if (pCullInstances)
+		{
+			getMeshClusterCullInstance(&world[0][0], &pCullInstances[i]);
+		}
+		else
+		{
+			lodDesc.mDistance = glm::length(position + boundsCenter - eye) - boundsRadius;
+			pScene->mInstanceLods[i] = selectMeshLod(pMesh, &lodDesc, pScene->mInstanceLods[i]);
+		}
+	}
+}
+
+/// <summary>
+/// GPU 与 CPU 簇剔除的一致性检查: 用第 0 帧的相机分派一次剔除并回读命令, 与 cullMeshClusters 的结果逐实例逐簇比较
+/// GPU 命令中 instanceCount 为 1 的簇即可见; CPU 命令合并了相邻的簇, 簇的起始索引落在某条命令内即可见
+/// 可见集合不一致时抛出异常, 基准测试不会在错误的剔除结果上计时
+/// </summary>
+static void verifyClusterCulling(const BenchmarkContext* pContext, BenchmarkScene* pScene)
+{
+	const Mesh* pMesh = pScene->pMesh;
+	uint32_t count = pScene->mDesc.mCount;
+	updateMeshScene(pScene, 0);
+	Buffer* pCommandBuffer = pScene->mIndirectBuffers[pScene->mFrameSlot];
+
+	BufferDesc readbackDesc = {};
+	readbackDesc.mSize = pCommandBuffer->mSize;
+	readbackDesc.mUsage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	readbackDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_TO_CPU;
+	Buffer* pReadbackBuffer;
+	addBuffer(pContext->pRenderer, &readbackDesc, &pReadbackBuffer);
+
+	CmdPoolDesc cmdPoolDesc = {};
+	cmdPoolDesc.pQueue = pContext->pQueue;
+	cmdPoolDesc.mTransient = true;
+	CmdPool* pCmdPool;
+	addCmdPool(pContext->pRenderer, &cmdPoolDesc, &pCmdPool);
+	CmdDesc cmdDesc = {};
+	cmdDesc.pPool = pCmdPool;
+	Cmd* pCmd;
+	addCmd(pContext->pRenderer, &cmdDesc, &pCmd);
+
+	beginCmd(pCmd);
+	cmdCullMeshClusters(pCmd, pMesh, pScene->pCullPipeline, pScene->mCullDescriptorSets[pScene->mFrameSlot], &pScene->mCullConstants, pCommandBuffer);
+	cmdBufferBarrier(pCmd, pCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+	cmdCopyBuffer(pCmd, pReadbackBuffer, 0, pCommandBuffer, 0, pCommandBuffer->mSize);
+	cmdBufferBarrier(pCmd, pReadbackBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+	endCmd(pCmd);
+
+	QueueSubmitDesc submitDesc = {};
+	submitDesc.ppCmds = &pCmd;
+	submitDesc.mCmdCount = 1;
+	queueSubmit(pContext->pQueue, &submitDesc);
+	waitQueueIdle(pContext->pQueue);
+	removeCmd(pContext->pRenderer, pCmd);
+	removeCmdPool(pContext->pRenderer, pCmdPool);
+
+	glm::vec3 eye;
+	glm::mat4 viewProjection;
+	getMeshSceneCamera(pScene, 0, &eye, &viewProjection);
+	MeshClusterCullDesc cullDesc = {};
+	cullDesc.pViewProjectionMatrix = &viewProjection[0][0];
+	cullDesc.mCameraPosition[0] = eye.x;
+	cullDesc.mCameraPosition[1] = eye.y;
+	cullDesc.mCameraPosition[2] = eye.z;
+	cullDesc.mConeCulling = true;
+
+	const VkDrawIndexedIndirectCommand* pGpuCommands = (const VkDrawIndexedIndirectCommand*)pReadbackBuffer->pCpuMappedAddress;
+	std::vector<VkDrawIndexedIndirectCommand> cpuCommands(std::max(pMesh->mClusterCount, pMesh->mSubmeshCount));
+	uint64_t visibleClusters = 0;
+	uint64_t mismatches = 0;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		glm::mat4 world = glm::translate(glm::mat4(1.0f), pScene->mInstancePositions[i]);
+		cullDesc.pWorldMatrix = &world[0][0];
+		uint32_t commandCount = cullMeshClusters(pMesh, &cullDesc, cpuCommands.data(), NULL);
+		for (uint32_t c = 0; c < pMesh->mClusterCount; ++c)
+		{
+			uint32_t firstIndex = pMesh->mFirstIndex + pMesh->pClusters[c].mFirstIndex;
+			bool cpuVisible = false;
+			for (uint32_t k = 0; k < commandCount && !cpuVisible; ++k)
+				cpuVisible = firstIndex >= cpuCommands[k].firstIndex && firstIndex < cpuCommands[k].firstIndex + cpuCommands[k].indexCount;
+			const VkDrawIndexedIndirectCommand& gpuCommand = pGpuCommands[(size_t)i * pMesh->mClusterCount + c];
+			bool gpuVisible = gpuCommand.instanceCount != 0;
+			if (cpuVisible != gpuVisible || gpuCommand.firstIndex != firstIndex || gpuCommand.indexCount != pMesh->pClusters[c].mIndexCount)
+				++mismatches;
+			visibleClusters += cpuVisible ? 1 : 0;
+		}
+	}
+	removeBuffer(pContext->pRenderer, pReadbackBuffer);
+
+	if (mismatches)
+	{
+		SHEN_CLIENT_ERROR("GPU cluster culling disagrees with cullMeshClusters on {0} of {1} clusters", mismatches, (uint64_t)count * pMesh->mClusterCount);
+		throw std::runtime_error("GPU cluster culling mismatch!");
+	}
+	SHEN_CLIENT_INFO("GPU cluster culling matches the CPU reference: {0} of {1} clusters visible", visibleClusters, (uint64_t)count * pMesh->mClusterCount);
+}
+
+void updateBenchmarkScene(BenchmarkScene* pScene, uint32_t frameIndex)
+{
+	switch (pScene->mDesc.mType)
+	{
+	case BENCHMARK_SCENE_UI:
+		beginUserInterfaceFrame();
+		buildBenchmarkUserInterface(pScene->mDesc.mCount, frameIndex);
+		endUserInterfaceFrame();
+		break;
+	case BENCHMARK_SCENE_MESHES:
+	case BENCHMARK_SCENE_CLUSTERS:
+	case BENCHMARK_SCENE_CLUSTERS_CPU:
+		updateMeshScene(pScene, frameIndex);
+		break;
+	default:
+		break;
+	}
+}
+
+/// <summary>
+/// 清屏并绑定管线, 视口覆盖整个渲染目标
+/// </summary>
+static void cmdBeginBenchmarkTarget(Cmd* pCmd, Texture* pTarget)
+{
+	RenderingDesc renderingDesc = {};
+	renderingDesc.mColorAttachmentCount = 1;
+	renderingDesc.mColorAttachments[0].pTexture = pTarget;
+	renderingDesc.mColorAttachments[0].mLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	renderingDesc.mColorAttachments[0].mStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+	renderingDesc.mColorAttachments[0].mClearValue = { {{0.0f, 0.0f, 0.0f, 1.0f}} };
+	cmdBeginRendering(pCmd, &renderingDesc);
+	cmdSetViewport(pCmd, 0.0f, 0.0f, (float)pTarget->mWidth, (float)pTarget->mHeight, 0.0f, 1.0f);
+	cmdSetScissor(pCmd, 0, 0, pTarget->mWidth, pTarget->mHeight);
+}
+
+void cmdDrawBenchmarkScene(Cmd* pCmd, BenchmarkScene* pScene)
+{
+	switch (pScene->mDesc.mType)
+	{
+	case BENCHMARK_SCENE_DRAWS:
+		cmdBeginBenchmarkTarget(pCmd, pScene->pRenderTarget);
+		cmdBindPipeline(pCmd, pScene->mPipelines[0]);
+		for (uint32_t i = 0; i < pScene->mDesc.mCount; ++i)
+			cmdDraw(pCmd, 3, 0);
+		cmdEndRendering(pCmd);
+		break;
+	case BENCHMARK_SCENE_PIPELINES:
+		cmdBeginBenchmarkTarget(pCmd, pScene->pRenderTarget);
+		for (Pipeline* pPipeline : pScene->mPipelines)
+		{
+			cmdBindPipeline(pCmd, pPipeline);
+			cmdDraw(pCmd, 3, 0);
+		}
+		cmdEndRendering(pCmd);
+		break;
+	case BENCHMARK_SCENE_TEXTURES:
+		// 渲染器尚不支持纹理采样绑定, 以渲染到纹理并转换为采样布局来模拟纹理数量带来的切换与屏障开销
+		for (Texture* pTexture : pScene->mTextures)
+		{
+			cmdBeginBenchmarkTarget(pCmd, pTexture);
+			cmdBindPipeline(pCmd, pScene->mPipelines[0]);
+			cmdDraw(pCmd, 3, 0);
+			cmdEndRendering(pCmd);
+			cmdTextureBarrier(pCmd, pTexture, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		}
+		break;
+	case BENCHMARK_SCENE_UI:
+		cmdBeginBenchmarkTarget(pCmd, pScene->pRenderTarget);
+		cmdEndRendering(pCmd);
+		cmdDrawUserInterface(pCmd, pScene->pRenderTarget);
+		break;
+	case BENCHMARK_SCENE_MESHES:
+		cmdBeginBenchmarkTarget(pCmd, pScene->pRenderTarget);
+		cmdBindPipeline(pCmd, pScene->mPipelines[0]);
+		cmdBindGeometryBuffer(pCmd, pScene->pGeometryBuffer);
+		for (uint32_t i = 0; i < pScene->mDesc.mCount; ++i)
+		{
+			cmdPushConstants(pCmd, &pScene->mInstanceTransforms[i], sizeof(glm::mat4));
+			cmdDrawMeshLod(pCmd, pScene->pMesh, pScene->mInstanceLods[i]);
+		}
+		cmdEndRendering(pCmd);
+		break;
+	case BENCHMARK_SCENE_CLUSTERS:
+	case BENCHMARK_SCENE_CLUSTERS_CPU:
+	{
+		const uint32_t stride = sizeof(VkDrawIndexedIndirectCommand);
+		Buffer* pIndirectBuffer = pScene->mIndirectBuffers[pScene->mFrameSlot];
+		// GPU 剔除在渲染通道外分派, 其屏障使随后的间接绘制读到本帧写出的命令
+		if (pScene->pCullPipeline)
+			cmdCullMeshClusters(pCmd, pScene->pMesh, pScene->pCullPipeline, pScene->mCullDescriptorSets[pScene->mFrameSlot],
+				&pScene->mCullConstants, pIndirectBuffer);
+		cmdBeginBenchmarkTarget(pCmd, pScene->pRenderTarget);
+		cmdBindPipeline(pCmd, pScene->mPipelines[0]);
+		cmdBindGeometryBuffer(pCmd, pScene->pGeometryBuffer);
+		for (uint32_t i = 0; i < pScene->mDesc.mCount; ++i)
+		{
+			cmdPushConstants(pCmd, &pScene->mInstanceTransforms[i], sizeof(glm::mat4));
+			cmdDrawIndexedIndirect(pCmd, pIndirectBuffer, (uint64_t)i * pScene->mInstanceCommandCapacity * stride,
+				pScene->mInstanceCommandCounts[i], stride);
+		}
+		cmdEndRendering(pCmd);
+		break;
+	}
+	default:
+		break;
+	}
+}
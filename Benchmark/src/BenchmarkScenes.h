@@ -0,0 +1,61 @@
+﻿#pragma once
+#include "Renderer/Renderer.h"
+
+/// <summary>
+/// 合成测试场景类型, 每种场景只放大一种开销
+/// </summary>
+typedef enum BenchmarkSceneType
+{
+	// 单管线, N 次三角形绘制
+	BENCHMARK_SCENE_DRAWS = 0,
+	// N 条管线, 每条绑定一次并绘制一次
+	BENCHMARK_SCENE_PIPELINES,
+	// N 个离屏渲染目标, 逐个渲染并转换为采样布局
+	BENCHMARK_SCENE_TEXTURES,
+	// N 个 ImGui 窗口
+	BENCHMARK_SCENE_UI,
+	// N 个网格实例, 每帧按投影误差为每个实例选择 LOD
+	BENCHMARK_SCENE_MESHES,
+	// N 个网格实例, 每帧由计算着色器剔除全部实例的簇, 以固定槽位的间接命令绘制
+	BENCHMARK_SCENE_CLUSTERS,
+	// 同 clusters, 但在 CPU 上逐实例剔除 (cullMeshClusters) 并写入间接缓冲, 作为 GPU 剔除的对照
+	BENCHMARK_SCENE_CLUSTERS_CPU,
+	BENCHMARK_SCENE_COUNT
+} BenchmarkSceneType;
+
+typedef struct BenchmarkSceneDesc
+{
+	BenchmarkSceneType	mType;
+	uint32_t			mCount;
+} BenchmarkSceneDesc;
+
+/// <summary>
+/// 场景共用的渲染对象, 由基准测试主程序创建
+/// </summary>
+typedef struct BenchmarkContext
+{
+	Renderer*	pRenderer;
+	Queue*		pQueue;
+	CmdPool*	pCmdPool;
+	// 主渲染目标, 除 textures 场景外都绘制到这里
+	Texture*	pRenderTarget;
+	const char*	pShaderDirectory;
+	// 同时在途的帧数, 每帧由 CPU 写入的缓冲按此数量分配
+	uint32_t	mFramesInFlight;
+} BenchmarkContext;
+
+typedef struct BenchmarkScene BenchmarkScene;
+
+// 解析 "类型:数量" 形式的场景描述, 如 "draws:1000"
+bool parseBenchmarkScene(const char* pText, BenchmarkSceneDesc* pOutDesc);
+const char* getBenchmarkSceneTypeName(BenchmarkSceneType type);
+
+void addBenchmarkScene(const BenchmarkContext* pContext, const BenchmarkSceneDesc* pDesc, BenchmarkScene** ppScene);
+// 调用前需确保 GPU 不再使用场景资源
+void removeBenchmarkScene(const BenchmarkContext* pContext, BenchmarkScene* pScene);
+// 场景名称, 如 "draws_1000", 用作结果与基线中的键
+const char* getBenchmarkSceneName(const BenchmarkScene* pScene);
+
+// 每帧录制前的 CPU 工作 (UI 场景在这里生成绘制数据), 调用前需等待 frameIndex 所在的帧位完成
+void updateBenchmarkScene(BenchmarkScene* pScene, uint32_t frameIndex);
+void cmdDrawBenchmarkScene(Cmd* pCmd, BenchmarkScene* pScene);
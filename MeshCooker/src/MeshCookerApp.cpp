@@ -0,0 +1,142 @@
+﻿#include "Core/JobSystem.h"
+#include "Core/Log.h"
+#include "Core/Memory.h"
+#include "Core/Profiler.h"
+#include "Renderer/Mesh.h"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/// <summary>
+/// 命令行参数
+/// </summary>
+typedef struct MeshCookerSettings
+{
+	std::vector<const char*>	mInputs;
+	// 为空时输出到输入文件所在目录
+	const char*					pOutputDirectory = NULL;
+	uint32_t					mFlags = MESH_LOAD_FLAG_GENERATE_LODS | MESH_LOAD_FLAG_GENERATE_CLUSTERS;
+	// 输出比输入新时默认跳过
+	bool						mForce = false;
+} MeshCookerSettings;
+
+static void printUsage()
+{
+	printf(
+		"Usage: MeshCooker [options] <input.obj>...\n"
+		"  Converts each OBJ into <name>" MESH_FILE_EXTENSION " (format version %d)\n"
+		"  --output-dir <dir>     write the cooked files to <dir> instead of next to the inputs\n"
+		"  --skip-optimization    only deduplicate vertices, keep the authored triangle order\n"
+		"  --compact-vertices     quantize vertices to 16 bytes (SNORM16 position, octahedral normal, UNORM16 uv)\n"
+		"  --no-lods              do not generate simplified LODs, only LOD 0 is written\n"
+		"  --no-clusters          do not split LOD 0 into culling clusters\n"
+		"  --force                cook even when the output is newer than the input\n",
+		MESH_FILE_VERSION);
+}
+
+static bool parseSettings(int argc, char** argv, MeshCookerSettings* pSettings)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "--skip-optimization")
+			pSettings->mFlags |= MESH_LOAD_FLAG_SKIP_OPTIMIZATION;
+		else if (arg == "--compact-vertices")
+			pSettings->mFlags |= MESH_LOAD_FLAG_COMPACT_VERTICES;
+		else if (arg == "--no-lods")
+			pSettings->mFlags &= ~MESH_LOAD_FLAG_GENERATE_LODS;
+		else if (arg == "--no-clusters")
+			pSettings->mFlags &= ~MESH_LOAD_FLAG_GENERATE_CLUSTERS;
+		else if (arg == "--force")
+			pSettings->mForce = true;
+		else if (arg == "--output-dir" && i + 1 < argc)
+			pSettings->pOutputDirectory = argv[++i];
+		else if (arg == "--help")
+			return false;
+		else if (arg.rfind("--", 0) == 0)
+		{
+			SHEN_CLIENT_ERROR("unknown option {0}", arg);
+			return false;
+		}
+		else
+			pSettings->mInputs.push_back(argv[i]);
+	}
+	return !pSettings->mInputs.empty();
+}
+
+static bool isUpToDate(const fs::path& input, const fs::path& output)
+{
+	std::error_code error;
+	fs::file_time_type outputTime = fs::last_write_time(output, error);
+	if (error)
+		return false;
+	fs::file_time_type inputTime = fs::last_write_time(input, error);
+	return !error && outputTime >= inputTime;
+}
+
+/// <summary>
+/// 先写入临时文件再替换, 中途失败或被中断时不会留下半个输出文件
+/// </summary>
+static bool cookMeshFile(const MeshCookerSettings* pSettings, const char* pInput)
+{
+	fs::path input = pInput;
+	fs::path outputDirectory = pSettings->pOutputDirectory ? fs::path(pSettings->pOutputDirectory) : input.parent_path();
+	fs::path output = outputDirectory / input.stem();
+	output += MESH_FILE_EXTENSION;
+	if (!pSettings->mForce && isUpToDate(input, output))
+	{
+		fmt::print("{0} is up to date\n", output.string());
+		return true;
+	}
+
+	std::error_code error;
+	if (!outputDirectory.empty())
+		fs::create_directories(outputDirectory, error);
+	fs::path temporary = output;
+	temporary += ".tmp";
+	if (!cookMesh(input.string().c_str(), temporary.string().c_str(), pSettings->mFlags))
+		return false;
+
+	fs::rename(temporary, output, error);
+	if (error)
+	{
+		SHEN_CLIENT_ERROR("failed to replace {0}: {1}", output.string(), error.message());
+		fs::remove(temporary, error);
+		return false;
+	}
+	fmt::print("wrote {0} ({1} KB)\n", output.string(), fs::file_size(output, error) / 1024);
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	Log::Init();
+	initMemorySystem("MeshCooker");
+	initProfiler();
+	initJobSystem(0);
+
+	int result = 0;
+	MeshCookerSettings settings;
+	if (!parseSettings(argc, argv, &settings))
+	{
+		printUsage();
+		result = 1;
+	}
+	else
+	{
+		for (const char* pInput : settings.mInputs)
+		{
+			if (!cookMeshFile(&settings, pInput))
+				result = 1;
+		}
+	}
+
+	exitJobSystem();
+	exitProfiler();
+	exitMemorySystem();
+	Log::Shutdown();
+	return result;
+}
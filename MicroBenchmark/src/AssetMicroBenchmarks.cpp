@@ -0,0 +1,177 @@
+﻿#include "MicroBenchmark.h"
+#include "Core/Log.h"
+#include "Renderer/ObjParser.h"
+
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <string>
+
+namespace fs = std::filesystem;
+
+// 合成网格每行的顶点数, 行与行之间以三角形带相连
+const uint32_t ASSET_BENCHMARK_GRID_WIDTH = 1024;
+// 正确性校验使用的小文件大小, 足以切出多个解析块
+const uint64_t ASSET_BENCHMARK_VERIFY_SIZE = 8ull << 20;
+
+typedef struct AssetBenchmarkState
+{
+	std::string mObjFile;
+	uint64_t	mObjSize;
+} AssetBenchmarkState;
+
+static AssetBenchmarkState* pAssetState = NULL;
+
+// 防止解析结果被优化掉
+static volatile size_t gAssetSink = 0;
+
+/// <summary>
+/// 写出不小于 targetSize 字节的 OBJ: 逐行写出顶点 (v/vt/vn), 再写出连接上一行的三角形,
+/// 坐标带伪随机扰动, 数值格式与扫描模型导出的文件相近 (6 位小数)
+/// </summary>
+static void writeSyntheticObj(const char* pFileName, uint64_t targetSize)
+{
+	FILE* pFile = fopen(pFileName, "wb");
+	if (!pFile)
+	{
+		SHEN_CLIENT_ERROR("failed to create {0}", pFileName);
+		throw std::runtime_error("failed to create synthetic obj!");
+	}
+	setvbuf(pFile, NULL, _IOFBF, 1 << 20);
+
+	uint32_t seed = 0x2545F491u;
+	auto noise = [&seed]() {
+		seed = seed * 1664525u + 1013904223u;
+		return (float)(seed >> 8) / 16777216.0f - 0.5f;
+	};
+
+	uint64_t written = (uint64_t)fprintf(pFile, "# synthetic grid for the obj microbenchmarks\no synthetic\n");
+	for (uint32_t row = 0; written < targetSize; ++row)
+	{
+		for (uint32_t column = 0; column < ASSET_BENCHMARK_GRID_WIDTH; ++column)
+		{
+			float x = (float)column * 0.01f;
+			float z = (float)row * 0.01f;
+			written += (uint64_t)fprintf(pFile, "v %.6f %.6f %.6f\nvt %.6f %.6f\nvn %.6f %.6f %.6f\n", x, noise() * 0.05f, z,
+				(float)column / ASSET_BENCHMARK_GRID_WIDTH, (float)(row % 4096) / 4096.0f, noise() * 0.1f, 1.0f, noise() * 0.1f);
+		}
+		if (!row)
+			continue;
+
+		// 负索引引用最近写出的两行, 与导出器分块写出时的用法相同
+		for (uint32_t column = 0; column + 1 < ASSET_BENCHMARK_GRID_WIDTH; ++column)
+		{
+			int a = (int)column - 2 * (int)ASSET_BENCHMARK_GRID_WIDTH;
+			int b = a + 1;
+			int c = (int)column - (int)ASSET_BENCHMARK_GRID_WIDTH;
+			int d = c + 1;
+			written += (uint64_t)fprintf(pFile, "f %d/%d/%d %d/%d/%d %d/%d/%d\nf %d/%d/%d %d/%d/%d %d/%d/%d\n",
+				a, a, a, c, c, c, b, b, b, b, b, b, c, c, c, d, d, d);
+		}
+	}
+	fclose(pFile);
+}
+
+static bool isSameObj(const tinyobj::attrib_t& a, const tinyobj::attrib_t& b, const std::vector<tinyobj::shape_t>& shapesA, const std::vector<tinyobj::shape_t>& shapesB)
+{
+	auto sameFloats = [](const std::vector<float>& x, const std::vector<float>& y) {
+		return x.size() == y.size() && (x.empty() || !memcmp(x.data(), y.data(), x.size() * sizeof(float)));
+	};
+	if (!sameFloats(a.vertices, b.vertices) || !sameFloats(a.normals, b.normals) || !sameFloats(a.texcoords, b.texcoords))
+		return false;
+	if (shapesA.size() != shapesB.size())
+		return false;
+	for (size_t i = 0; i < shapesA.size(); ++i)
+	{
+		const tinyobj::mesh_t& meshA = shapesA[i].mesh;
+		const tinyobj::mesh_t& meshB = shapesB[i].mesh;
+		if (shapesA[i].name != shapesB[i].name || meshA.indices.size() != meshB.indices.size() ||
+			meshA.num_face_vertices != meshB.num_face_vertices || meshA.material_ids != meshB.material_ids)
+			return false;
+		for (size_t j = 0; j < meshA.indices.size(); ++j)
+		{
+			const tinyobj::index_t& indexA = meshA.indices[j];
+			const tinyobj::index_t& indexB = meshB.indices[j];
+			if (indexA.vertex_index != indexB.vertex_index || indexA.normal_index != indexB.normal_index || indexA.texcoord_index != indexB.texcoord_index)
+				return false;
+		}
+	}
+	return true;
+}
+
+/// <summary>
+/// 并行解析必须与 tinyobjloader 逐位相同, 计时之前先在小文件上比较一次
+/// </summary>
+static void verifyParallelObjParser(const char* pFileName)
+{
+	writeSyntheticObj(pFileName, ASSET_BENCHMARK_VERIFY_SIZE);
+	tinyobj::attrib_t referenceAttrib, parallelAttrib;
+	std::vector<tinyobj::shape_t> referenceShapes, parallelShapes;
+	std::vector<tinyobj::material_t> materials;
+	std::string error;
+	bool loaded = tinyobj::LoadObj(&referenceAttrib, &referenceShapes, &materials, &error, pFileName) &&
+		loadObjParallel(&parallelAttrib, &parallelShapes, &materials, &error, pFileName);
+	std::error_code removeError;
+	fs::remove(pFileName, removeError);
+	if (!loaded || !isSameObj(referenceAttrib, parallelAttrib, referenceShapes, parallelShapes))
+	{
+		SHEN_CLIENT_ERROR("parallel obj parser output differs from tinyobjloader");
+		throw std::runtime_error("parallel obj parser mismatch!");
+	}
+}
+
+static void benchmarkParseTinyObjLoader(void* pUserData, uint32_t iterationCount)
+{
+	AssetBenchmarkState* pState = (AssetBenchmarkState*)pUserData;
+	for (uint32_t i = 0; i < iterationCount; ++i)
+	{
+		tinyobj::attrib_t attrib;
+		std::vector<tinyobj::shape_t> shapes;
+		std::vector<tinyobj::material_t> materials;
+		std::string error;
+		tinyobj::LoadObj(&attrib, &shapes, &materials, &error, pState->mObjFile.c_str());
+		gAssetSink += attrib.vertices.size();
+	}
+}
+
+static void benchmarkParseParallel(void* pUserData, uint32_t iterationCount)
+{
+	AssetBenchmarkState* pState = (AssetBenchmarkState*)pUserData;
+	for (uint32_t i = 0; i < iterationCount; ++i)
+	{
+		tinyobj::attrib_t attrib;
+		std::vector<tinyobj::shape_t> shapes;
+		std::vector<tinyobj::material_t> materials;
+		std::string error;
+		loadObjParallel(&attrib, &shapes, &materials, &error, pState->mObjFile.c_str());
+		gAssetSink += attrib.vertices.size();
+	}
+}
+
+void addAssetMicroBenchmarks(std::vector<MicroBenchmarkDesc>& benchmarks, uint32_t objSizeMB)
+{
+	if (!objSizeMB)
+		return;
+
+	pAssetState = new AssetBenchmarkState();
+	pAssetState->mObjFile = (fs::temp_directory_path() / "shen_microbenchmark.obj").string();
+	verifyParallelObjParser(pAssetState->mObjFile.c_str());
+
+	SHEN_CLIENT_INFO("writing {0} MB synthetic obj to {1}", objSizeMB, pAssetState->mObjFile);
+	writeSyntheticObj(pAssetState->mObjFile.c_str(), (uint64_t)objSizeMB << 20);
+	pAssetState->mObjSize = fs::file_size(pAssetState->mObjFile);
+
+	// 单次解析即为秒级, 每个样本只解析一次; 第一个样本之前文件已在页缓存中
+	benchmarks.push_back({ "obj/parse_tinyobjloader", benchmarkParseTinyObjLoader, NULL, pAssetState, 1 });
+	benchmarks.push_back({ "obj/parse_parallel", benchmarkParseParallel, NULL, pAssetState, 1 });
+}
+
+void removeAssetMicroBenchmarks()
+{
+	if (!pAssetState)
+		return;
+	std::error_code error;
+	fs::remove(pAssetState->mObjFile, error);
+	delete pAssetState;
+	pAssetState = NULL;
+}
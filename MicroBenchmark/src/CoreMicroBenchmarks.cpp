@@ -0,0 +1,152 @@
+﻿#include "MicroBenchmark.h"
+#include "Core/LayerStack.h"
+#include "Events/ApplicationEvent.h"
+#include "Events/KeyEvent.h"
+
+// 与 Application 默认层数相近: 若干应用层加 ImGui/性能面板等覆盖层
+const uint32_t CORE_BENCHMARK_LAYER_COUNT = 12;
+const uint32_t CORE_BENCHMARK_OVERLAY_COUNT = 4;
+
+// 防止被测操作的结果被优化掉
+static volatile uint64_t gSink = 0;
+
+/// <summary>
+/// 只检查按键事件的层, 对其他事件不做处理, 事件会遍历整个层栈
+/// </summary>
+class BenchmarkLayer : public Layer
+{
+public:
+	BenchmarkLayer() : Layer("BenchmarkLayer") {}
+
+	void OnEvent(Event& event) override
+	{
+		EventDispatcher dispatcher(event);
+		dispatcher.Dispatch<KeyPressedEvent>([](KeyPressedEvent& e) {
+			gSink += e.GetKeyCode();
+			return false;
+		});
+	}
+};
+
+typedef struct CoreBenchmarkState
+{
+	LayerStack*	pLayerStack;
+	// 每次迭代压入再弹出, 不归层栈所有
+	Layer*		pTransientLayer;
+} CoreBenchmarkState;
+
+static CoreBenchmarkState* pCoreState = NULL;
+
+static void benchmarkDispatchMatch(void* pUserData, uint32_t iterationCount)
+{
+	WindowResizeEvent event(1280, 720);
+	for (uint32_t i = 0; i < iterationCount; ++i)
+	{
+		event.Handled = false;
+		EventDispatcher dispatcher(event);
+		dispatcher.Dispatch<WindowResizeEvent>([](WindowResizeEvent& e) {
+			gSink += e.GetWidth();
+			return false;
+		});
+	}
+}
+
+static void benchmarkDispatchMismatch(void* pUserData, uint32_t iterationCount)
+{
+	KeyPressedEvent event(KEY_SPACE, 0);
+	for (uint32_t i = 0; i < iterationCount; ++i)
+	{
+		EventDispatcher dispatcher(event);
+		gSink += dispatcher.Dispatch<WindowResizeEvent>([](WindowResizeEvent& e) {
+			return true;
+		});
+	}
+}
+
+/// <summary>
+/// 与 Application::OnEvent 相同的路径: 窗口事件分发后由层栈自顶向下传递, 无层处理时遍历全部层
+/// </summary>
+static void benchmarkApplicationOnEvent(void* pUserData, uint32_t iterationCount)
+{
+	CoreBenchmarkState* pState = (CoreBenchmarkState*)pUserData;
+	KeyPressedEvent event(KEY_A, 0);
+	for (uint32_t i = 0; i < iterationCount; ++i)
+	{
+		event.Handled = false;
+		EventDispatcher dispatcher(event);
+		dispatcher.Dispatch<WindowCloseEvent>([](WindowCloseEvent& e) { return true; });
+		dispatcher.Dispatch<WindowResizeEvent>([](WindowResizeEvent& e) { return true; });
+		pState->pLayerStack->OnEvent(event);
+	}
+}
+
+static void benchmarkPushPopLayer(void* pUserData, uint32_t iterationCount)
+{
+	CoreBenchmarkState* pState = (CoreBenchmarkState*)pUserData;
+	for (uint32_t i = 0; i < iterationCount; ++i)
+	{
+		pState->pLayerStack->PushLayer(pState->pTransientLayer);
+		pState->pLayerStack->PopLayer(pState->pTransientLayer);
+	}
+}
+
+static void benchmarkPushPopOverlay(void* pUserData, uint32_t iterationCount)
+{
+	CoreBenchmarkState* pState = (CoreBenchmarkState*)pUserData;
+	for (uint32_t i = 0; i < iterationCount; ++i)
+	{
+		pState->pLayerStack->PushOverlay(pState->pTransientLayer);
+		pState->pLayerStack->PopOverlay(pState->pTransientLayer);
+	}
+}
+
+/// <summary>
+/// 级别被关闭的日志宏, 只应付出级别判断的开销, 参数不应被格式化
+/// </summary>
+static void benchmarkLogDisabled(void* pUserData, uint32_t iterationCount)
+{
+	spdlog::level::level_enum level = Log::GetCoreLogger()->level();
+	Log::GetCoreLogger()->set_level(spdlog::level::info);
+	for (uint32_t i = 0; i < iterationCount; ++i)
+		SHEN_CORE_TRACE("frame {0} took {1} ms in {2}", i, 16.6f, "benchmark");
+	Log::GetCoreLogger()->set_level(level);
+}
+
+static void benchmarkLogDisabledNoArgs(void* pUserData, uint32_t iterationCount)
+{
+	spdlog::level::level_enum level = Log::GetCoreLogger()->level();
+	Log::GetCoreLogger()->set_level(spdlog::level::info);
+	for (uint32_t i = 0; i < iterationCount; ++i)
+		SHEN_CORE_TRACE("benchmark");
+	Log::GetCoreLogger()->set_level(level);
+}
+
+void addCoreMicroBenchmarks(std::vector<MicroBenchmarkDesc>& benchmarks)
+{
+	pCoreState = new CoreBenchmarkState();
+	pCoreState->pLayerStack = new LayerStack();
+	for (uint32_t i = 0; i < CORE_BENCHMARK_LAYER_COUNT; ++i)
+		pCoreState->pLayerStack->PushLayer(new BenchmarkLayer());
+	for (uint32_t i = 0; i < CORE_BENCHMARK_OVERLAY_COUNT; ++i)
+		pCoreState->pLayerStack->PushOverlay(new BenchmarkLayer());
+	pCoreState->pTransientLayer = new BenchmarkLayer();
+
+	benchmarks.push_back({ "event/dispatch_match", benchmarkDispatchMatch, NULL, pCoreState, 1000000 });
+	benchmarks.push_back({ "event/dispatch_mismatch", benchmarkDispatchMismatch, NULL, pCoreState, 1000000 });
+	benchmarks.push_back({ "event/application_on_event_16_layers", benchmarkApplicationOnEvent, NULL, pCoreState, 200000 });
+	benchmarks.push_back({ "layerstack/push_pop_layer", benchmarkPushPopLayer, NULL, pCoreState, 200000 });
+	benchmarks.push_back({ "layerstack/push_pop_overlay", benchmarkPushPopOverlay, NULL, pCoreState, 200000 });
+	benchmarks.push_back({ "log/trace_disabled_with_args", benchmarkLogDisabled, NULL, pCoreState, 1000000 });
+	benchmarks.push_back({ "log/trace_disabled_no_args", benchmarkLogDisabledNoArgs, NULL, pCoreState, 1000000 });
+}
+
+void removeCoreMicroBenchmarks()
+{
+	if (!pCoreState)
+		return;
+	// 层栈析构时释放其中的层
+	delete pCoreState->pLayerStack;
+	delete pCoreState->pTransientLayer;
+	delete pCoreState;
+	pCoreState = NULL;
+}
@@ -0,0 +1,77 @@
+﻿#include "MicroBenchmark.h"
+#include "Core/Log.h"
+#include "Core/Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+void runMicroBenchmark(const MicroBenchmarkDesc* pDesc, const MicroBenchmarkSettings* pSettings, MicroBenchmarkResult* pOutResult)
+{
+	std::vector<double> samples;
+	samples.reserve(pSettings->mSamples);
+	for (uint32_t sample = 0; sample < pSettings->mWarmupSamples + pSettings->mSamples; ++sample)
+	{
+		uint64_t begin = profilerGetTicks();
+		pDesc->pFunction(pDesc->pUserData, pDesc->mIterations);
+		uint64_t end = profilerGetTicks();
+		if (pDesc->pEndSample)
+			pDesc->pEndSample(pDesc->pUserData);
+
+		if (sample >= pSettings->mWarmupSamples)
+			samples.push_back(profilerTicksToMilliseconds(end - begin) * 1.0e6 / pDesc->mIterations);
+	}
+
+	std::sort(samples.begin(), samples.end());
+	double sum = 0.0;
+	for (double value : samples)
+		sum += value;
+	double mean = sum / samples.size();
+	double variance = 0.0;
+	for (double value : samples)
+		variance += (value - mean) * (value - mean);
+	size_t middle = samples.size() / 2;
+	double median = samples.size() % 2 ? samples[middle] : 0.5 * (samples[middle - 1] + samples[middle]);
+
+	pOutResult->pName = pDesc->pName;
+	pOutResult->mIterations = pDesc->mIterations;
+	pOutResult->mSamples = (uint32_t)samples.size();
+	pOutResult->mMinNanoseconds = samples.front();
+	pOutResult->mMedianNanoseconds = median;
+	pOutResult->mMeanNanoseconds = mean;
+	pOutResult->mStdDevNanoseconds = samples.size() > 1 ? sqrt(variance / (samples.size() - 1)) : 0.0;
+	pOutResult->mMaxNanoseconds = samples.back();
+	pOutResult->mOpsPerSecond = median > 0.0 ? 1.0e9 / median : 0.0;
+}
+
+void printMicroBenchmarkResults(const std::vector<MicroBenchmarkResult>& results)
+{
+	fmt::print("{0:<40} {1:>10} {2:>12} {3:>12} {4:>12} {5:>10} {6:>14}\n",
+		"benchmark", "iterations", "min ns", "median ns", "mean ns", "stddev %", "ops/s");
+	for (const MicroBenchmarkResult& result : results)
+	{
+		double relativeStdDev = result.mMeanNanoseconds > 0.0 ? 100.0 * result.mStdDevNanoseconds / result.mMeanNanoseconds : 0.0;
+		fmt::print("{0:<40} {1:>10} {2:>12.2f} {3:>12.2f} {4:>12.2f} {5:>10.1f} {6:>14.0f}\n",
+			result.pName, result.mIterations, result.mMinNanoseconds, result.mMedianNanoseconds,
+			result.mMeanNanoseconds, relativeStdDev, result.mOpsPerSecond);
+	}
+}
+
+void writeMicroBenchmarkCsv(const char* pFileName, const std::vector<MicroBenchmarkResult>& results)
+{
+	FILE* pFile = fopen(pFileName, "w");
+	if (!pFile)
+	{
+		SHEN_CLIENT_ERROR("failed to open microbenchmark report {0}", pFileName);
+		throw std::runtime_error("failed to open microbenchmark report!");
+	}
+
+	fprintf(pFile, "benchmark,iterations,samples,min_ns,median_ns,mean_ns,stddev_ns,max_ns,ops_per_second\n");
+	for (const MicroBenchmarkResult& result : results)
+	{
+		fprintf(pFile, "%s,%u,%u,%.3f,%.3f,%.3f,%.3f,%.3f,%.1f\n", result.pName, result.mIterations, result.mSamples,
+			result.mMinNanoseconds, result.mMedianNanoseconds, result.mMeanNanoseconds,
+			result.mStdDevNanoseconds, result.mMaxNanoseconds, result.mOpsPerSecond);
+	}
+	fclose(pFile);
+}
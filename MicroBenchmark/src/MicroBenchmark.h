@@ -0,0 +1,64 @@
+﻿#pragma once
+#include <cstdint>
+#include <vector>
+
+// 执行 iterationCount 次被测操作
+typedef void (*MicroBenchmarkFunction)(void* pUserData, uint32_t iterationCount);
+// 每个样本结束后在计时范围外调用, 用于回收样本产生的状态 (如等待队列空闲)
+typedef void (*MicroBenchmarkSampleCallback)(void* pUserData);
+
+/// <summary>
+/// 单个微基准测试, 迭代次数固定, 使不同版本的结果可直接比较
+/// </summary>
+typedef struct MicroBenchmarkDesc
+{
+	// 形如 "分组/名称", 用于过滤与报告
+	const char*						pName;
+	MicroBenchmarkFunction			pFunction;
+	MicroBenchmarkSampleCallback	pEndSample;
+	void*							pUserData;
+	// 每个样本的迭代次数
+	uint32_t						mIterations;
+} MicroBenchmarkDesc;
+
+typedef struct MicroBenchmarkSettings
+{
+	// 每个测试的样本数, 统计量基于样本间的差异
+	uint32_t	mSamples;
+	// 丢弃的预热样本数
+	uint32_t	mWarmupSamples;
+} MicroBenchmarkSettings;
+
+/// <summary>
+/// 单个测试的结果, 时间为每次操作的纳秒数
+/// </summary>
+typedef struct MicroBenchmarkResult
+{
+	const char*	pName;
+	uint32_t	mIterations;
+	uint32_t	mSamples;
+	double		mMinNanoseconds;
+	double		mMedianNanoseconds;
+	double		mMeanNanoseconds;
+	double		mStdDevNanoseconds;
+	double		mMaxNanoseconds;
+	// 按中位数换算
+	double		mOpsPerSecond;
+} MicroBenchmarkResult;
+
+void runMicroBenchmark(const MicroBenchmarkDesc* pDesc, const MicroBenchmarkSettings* pSettings, MicroBenchmarkResult* pOutResult);
+
+// 打印结果表格到标准输出, 不经过日志, Dist 下同样可见
+void printMicroBenchmarkResults(const std::vector<MicroBenchmarkResult>& results);
+// 每个测试一行, 写出失败时抛出 std::runtime_error
+void writeMicroBenchmarkCsv(const char* pFileName, const std::vector<MicroBenchmarkResult>& results);
+
+// 各组测试, 由 MicroBenchmarkApp 按顺序收集
+void addCoreMicroBenchmarks(std::vector<MicroBenchmarkDesc>& benchmarks);
+void removeCoreMicroBenchmarks();
+// 需要 Vulkan 设备, pShaderDirectory 中缺少着色器时跳过绘制录制测试
+void addRendererMicroBenchmarks(std::vector<MicroBenchmarkDesc>& benchmarks, const char* pShaderDirectory, bool software, const char* pGpuName);
+void removeRendererMicroBenchmarks();
+// 生成 objSizeMB 大小的合成 OBJ, 比较 tinyobjloader 与并行解析, 为 0 时不添加
+void addAssetMicroBenchmarks(std::vector<MicroBenchmarkDesc>& benchmarks, uint32_t objSizeMB);
+void removeAssetMicroBenchmarks();
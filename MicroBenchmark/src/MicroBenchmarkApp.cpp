@@ -0,0 +1,154 @@
+﻿#include "Core/JobSystem.h"
+#include "Core/Log.h"
+#include "Core/Memory.h"
+#include "Core/Profiler.h"
+
+#include "MicroBenchmark.h"
+
+#include <string>
+
+/// <summary>
+/// 命令行参数
+/// </summary>
+typedef struct MicroBenchmarkAppSettings
+{
+	MicroBenchmarkSettings	mSettings = { 20, 3 };
+	// 只运行名称包含该子串的测试
+	const char*				pFilter = NULL;
+	const char*				pOutputFile = NULL;
+	const char*				pShaderDirectory = "shaders";
+	const char*				pGpuName = NULL;
+	// 合成 OBJ 的大小 (MB), 单次解析即为秒级, 默认 0 不运行 obj 组
+	uint32_t				mObjSizeMB = 0;
+	bool					mSoftware = false;
+	// 不创建 Vulkan 设备, 只运行 Core 组
+	bool					mCoreOnly = false;
+} MicroBenchmarkAppSettings;
+
+static void printUsage()
+{
+	printf(
+		"Usage: MicroBenchmark [options]\n"
+		"  --filter <text>        only run benchmarks whose name contains <text>\n"
+		"  --samples <count>      measured samples per benchmark (20)\n"
+		"  --warmup <count>       discarded samples per benchmark (3)\n"
+		"  --output <file.csv>    write the results as CSV\n"
+		"  --core-only            skip the benchmarks that need a Vulkan device\n"
+		"  --gpu <name>           select the GPU whose name contains <name>\n"
+		"  --software             run on a software rasterizer (lavapipe, SwiftShader)\n"
+		"  --shaders <dir>        directory holding vert.spv and frag.spv (shaders)\n"
+		"  --obj-size <MB>        run the obj group on a synthetic OBJ of <MB> (off)\n");
+}
+
+static bool parseSettings(int argc, char** argv, MicroBenchmarkAppSettings* pSettings)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "--software")
+		{
+			pSettings->mSoftware = true;
+			continue;
+		}
+		if (arg == "--core-only")
+		{
+			pSettings->mCoreOnly = true;
+			continue;
+		}
+		if (arg == "--help" || i + 1 >= argc)
+			return false;
+
+		const char* pValue = argv[++i];
+		if (arg == "--filter")
+			pSettings->pFilter = pValue;
+		else if (arg == "--samples")
+			pSettings->mSettings.mSamples = (uint32_t)atoi(pValue);
+		else if (arg == "--warmup")
+			pSettings->mSettings.mWarmupSamples = (uint32_t)atoi(pValue);
+		else if (arg == "--output")
+			pSettings->pOutputFile = pValue;
+		else if (arg == "--gpu")
+			pSettings->pGpuName = pValue;
+		else if (arg == "--shaders")
+			pSettings->pShaderDirectory = pValue;
+		else if (arg == "--obj-size")
+			pSettings->mObjSizeMB = (uint32_t)atoi(pValue);
+		else
+		{
+			SHEN_CLIENT_ERROR("unknown option {0}", arg);
+			return false;
+		}
+	}
+
+	if (pSettings->mSettings.mSamples == 0)
+	{
+		SHEN_CLIENT_ERROR("--samples must be greater than 0");
+		return false;
+	}
+	return true;
+}
+
+static int runMicroBenchmarks(const MicroBenchmarkAppSettings* pSettings)
+{
+	std::vector<MicroBenchmarkDesc> benchmarks;
+	addCoreMicroBenchmarks(benchmarks);
+	addAssetMicroBenchmarks(benchmarks, pSettings->mObjSizeMB);
+	if (!pSettings->mCoreOnly)
+		addRendererMicroBenchmarks(benchmarks, pSettings->pShaderDirectory, pSettings->mSoftware, pSettings->pGpuName);
+
+	std::vector<MicroBenchmarkResult> results;
+	for (const MicroBenchmarkDesc& benchmark : benchmarks)
+	{
+		if (pSettings->pFilter && !strstr(benchmark.pName, pSettings->pFilter))
+			continue;
+		SHEN_CLIENT_INFO("running {0}", benchmark.pName);
+		MicroBenchmarkResult result;
+		runMicroBenchmark(&benchmark, &pSettings->mSettings, &result);
+		results.push_back(result);
+	}
+
+	printMicroBenchmarkResults(results);
+	if (pSettings->pOutputFile)
+	{
+		writeMicroBenchmarkCsv(pSettings->pOutputFile, results);
+		fmt::print("wrote {0}\n", pSettings->pOutputFile);
+	}
+
+	removeRendererMicroBenchmarks();
+	removeAssetMicroBenchmarks();
+	removeCoreMicroBenchmarks();
+	return results.empty() ? 1 : 0;
+}
+
+int main(int argc, char** argv)
+{
+	Log::Init();
+	initMemorySystem("MicroBenchmark");
+	initProfiler();
+	initJobSystem(0);
+
+	int result = 1;
+	MicroBenchmarkAppSettings settings;
+	if (!parseSettings(argc, argv, &settings))
+	{
+		printUsage();
+	}
+	else
+	{
+		try
+		{
+			result = runMicroBenchmarks(&settings);
+		}
+		catch (const std::exception& e)
+		{
+			SHEN_CLIENT_ERROR("microbenchmark failed: {0}", e.what());
+			result = 1;
+		}
+	}
+
+	exitJobSystem();
+	exitProfiler();
+	exitMemorySystem();
+	Log::Shutdown();
+	return result;
+}
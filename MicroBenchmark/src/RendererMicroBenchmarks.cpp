@@ -0,0 +1,224 @@
+﻿#include "MicroBenchmark.h"
+#include "Core/Log.h"
+#include "Renderer/Renderer.h"
+
+#include <string>
+
+// queueSubmit 测试中每次提交发出与等待的信号量数量
+const uint32_t RENDERER_BENCHMARK_SEMAPHORE_COUNT = 16;
+// 录制测试的渲染目标尺寸, 只录制不提交, 尺寸不影响结果
+const uint32_t RENDERER_BENCHMARK_TARGET_SIZE = 64;
+
+typedef struct RendererBenchmarkState
+{
+	Renderer*	pRenderer;
+	Queue*		pQueue;
+	CmdPool*	pCmdPool;
+	Cmd*		pCmd;
+	Semaphore*	pSemaphores[RENDERER_BENCHMARK_SEMAPHORE_COUNT];
+	Texture*	pRenderTarget;
+	Pipeline*	pPipeline;
+} RendererBenchmarkState;
+
+static RendererBenchmarkState* pRendererState = NULL;
+
+static void benchmarkAddRemoveFence(void* pUserData, uint32_t iterationCount)
+{
+	RendererBenchmarkState* pState = (RendererBenchmarkState*)pUserData;
+	for (uint32_t i = 0; i < iterationCount; ++i)
+	{
+		Fence* pFence;
+		addFence(pState->pRenderer, &pFence);
+		removeFence(pState->pRenderer, pFence);
+	}
+}
+
+static void benchmarkAddRemoveSemaphore(void* pUserData, uint32_t iterationCount)
+{
+	RendererBenchmarkState* pState = (RendererBenchmarkState*)pUserData;
+	for (uint32_t i = 0; i < iterationCount; ++i)
+	{
+		Semaphore* pSemaphore;
+		addSemaphore(pState->pRenderer, &pSemaphore);
+		removeSemaphore(pState->pRenderer, pSemaphore);
+	}
+}
+
+static void benchmarkAddRemoveCmd(void* pUserData, uint32_t iterationCount)
+{
+	RendererBenchmarkState* pState = (RendererBenchmarkState*)pUserData;
+	CmdDesc cmdDesc = {};
+	cmdDesc.pPool = pState->pCmdPool;
+	for (uint32_t i = 0; i < iterationCount; ++i)
+	{
+		Cmd* pCmd;
+		addCmd(pState->pRenderer, &cmdDesc, &pCmd);
+		removeCmd(pState->pRenderer, pCmd);
+	}
+}
+
+/// <summary>
+/// 每次迭代两次空提交: 第一次发出全部信号量, 第二次等待全部信号量
+/// </summary>
+static void benchmarkQueueSubmitSemaphores(void* pUserData, uint32_t iterationCount)
+{
+	RendererBenchmarkState* pState = (RendererBenchmarkState*)pUserData;
+	QueueSubmitDesc signalDesc = {};
+	signalDesc.ppSignalSemaphores = pState->pSemaphores;
+	signalDesc.mSignalSemaphoreCount = RENDERER_BENCHMARK_SEMAPHORE_COUNT;
+	QueueSubmitDesc waitDesc = {};
+	waitDesc.ppWaitSemaphores = pState->pSemaphores;
+	waitDesc.mWaitSemaphoreCount = RENDERER_BENCHMARK_SEMAPHORE_COUNT;
+	for (uint32_t i = 0; i < iterationCount; ++i)
+	{
+		queueSubmit(pState->pQueue, &signalDesc);
+		queueSubmit(pState->pQueue, &waitDesc);
+	}
+}
+
+static void benchmarkQueueSubmitEmpty(void* pUserData, uint32_t iterationCount)
+{
+	RendererBenchmarkState* pState = (RendererBenchmarkState*)pUserData;
+	QueueSubmitDesc submitDesc = {};
+	for (uint32_t i = 0; i < iterationCount; ++i)
+		queueSubmit(pState->pQueue, &submitDesc);
+}
+
+/// <summary>
+/// 一次录制 iterationCount 个绘制, 开始与结束录制的开销被摊薄
+/// </summary>
+static void benchmarkCmdDraw(void* pUserData, uint32_t iterationCount)
+{
+	RendererBenchmarkState* pState = (RendererBenchmarkState*)pUserData;
+	Cmd* pCmd = pState->pCmd;
+	beginCmd(pCmd);
+	RenderingDesc renderingDesc = {};
+	renderingDesc.mColorAttachmentCount = 1;
+	renderingDesc.mColorAttachments[0].pTexture = pState->pRenderTarget;
+	renderingDesc.mColorAttachments[0].mLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	renderingDesc.mColorAttachments[0].mStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	cmdBeginRendering(pCmd, &renderingDesc);
+	cmdBindPipeline(pCmd, pState->pPipeline);
+	cmdSetViewport(pCmd, 0.0f, 0.0f, (float)RENDERER_BENCHMARK_TARGET_SIZE, (float)RENDERER_BENCHMARK_TARGET_SIZE, 0.0f, 1.0f);
+	cmdSetScissor(pCmd, 0, 0, RENDERER_BENCHMARK_TARGET_SIZE, RENDERER_BENCHMARK_TARGET_SIZE);
+	for (uint32_t i = 0; i < iterationCount; ++i)
+		cmdDraw(pCmd, 3, 0);
+	cmdEndRendering(pCmd);
+	endCmd(pCmd);
+}
+
+// 样本之间等待提交完成, 避免队列无限增长; 同时清空累计的帧统计
+static void endRendererSample(void* pUserData)
+{
+	RendererBenchmarkState* pState = (RendererBenchmarkState*)pUserData;
+	waitQueueIdle(pState->pQueue);
+	endRendererFrame(pState->pRenderer);
+}
+
+static bool fileExists(const std::string& path)
+{
+	FILE* pFile = fopen(path.c_str(), "rb");
+	if (!pFile)
+		return false;
+	fclose(pFile);
+	return true;
+}
+
+static Pipeline* addDrawPipeline(Renderer* pRenderer, const std::string& vertPath, const std::string& fragPath, VkFormat colorFormat)
+{
+	ShaderDesc shaderDesc = {};
+	shaderDesc.mStages = SHADER_STAGE_VERT;
+	shaderDesc.pFileName = vertPath.c_str();
+	Shader* pVertShader;
+	addShader(pRenderer, &shaderDesc, &pVertShader);
+	shaderDesc.mStages = SHADER_STAGE_FRAG;
+	shaderDesc.pFileName = fragPath.c_str();
+	Shader* pFragShader;
+	addShader(pRenderer, &shaderDesc, &pFragShader);
+
+	PipelineDesc pipelineDesc = {};
+	pipelineDesc.mType = PIPELINE_TYPE_GRAPHICS;
+	pipelineDesc.mGraphicsDesc.pColorFormats = &colorFormat;
+	pipelineDesc.mGraphicsDesc.mRenderTargetCount = 1;
+	pipelineDesc.mGraphicsDesc.pShaderCount = 2;
+	pipelineDesc.mGraphicsDesc.pShaders[0] = pVertShader;
+	pipelineDesc.mGraphicsDesc.pShaders[1] = pFragShader;
+	Pipeline* pPipeline;
+	addPipeline(pRenderer, &pipelineDesc, &pPipeline);
+
+	removeShader(pRenderer, pVertShader);
+	removeShader(pRenderer, pFragShader);
+	return pPipeline;
+}
+
+void addRendererMicroBenchmarks(std::vector<MicroBenchmarkDesc>& benchmarks, const char* pShaderDirectory, bool software, const char* pGpuName)
+{
+	pRendererState = new RendererBenchmarkState();
+	memset(pRendererState, 0, sizeof(RendererBenchmarkState));
+
+	//无窗口初始化 Instance 到 LogicalDevice
+	RendererDesc rendererDesc;
+	memset(&rendererDesc, 0, sizeof(rendererDesc));
+	rendererDesc.pGpuName = pGpuName;
+	rendererDesc.mForceSoftwareRasterizer = software;
+	SwapChain* pSwapChain = NULL;
+	std::vector<Texture> swapChainTextures;
+	initRenderer("MicroBenchmark", &rendererDesc, &pRendererState->pRenderer, NULL, &pSwapChain, swapChainTextures);
+	Renderer* pRenderer = pRendererState->pRenderer;
+	SHEN_CLIENT_INFO("microbenchmark device: {0}", pRenderer->mCapabilities.mDeviceName);
+
+	QueueDesc queueDesc = {};
+	queueDesc.mType = QUEUE_TYPE_GRAPHICS;
+	addQueue(pRenderer, &queueDesc, &pRendererState->pQueue);
+
+	CmdPoolDesc cmdPoolDesc = {};
+	cmdPoolDesc.pQueue = pRendererState->pQueue;
+	addCmdPool(pRenderer, &cmdPoolDesc, &pRendererState->pCmdPool);
+	CmdDesc cmdDesc = {};
+	cmdDesc.pPool = pRendererState->pCmdPool;
+	addCmd(pRenderer, &cmdDesc, &pRendererState->pCmd);
+	for (uint32_t i = 0; i < RENDERER_BENCHMARK_SEMAPHORE_COUNT; ++i)
+		addSemaphore(pRenderer, &pRendererState->pSemaphores[i]);
+
+	benchmarks.push_back({ "renderer/add_remove_fence", benchmarkAddRemoveFence, NULL, pRendererState, 2000 });
+	benchmarks.push_back({ "renderer/add_remove_semaphore", benchmarkAddRemoveSemaphore, NULL, pRendererState, 2000 });
+	benchmarks.push_back({ "renderer/add_remove_cmd", benchmarkAddRemoveCmd, NULL, pRendererState, 2000 });
+	benchmarks.push_back({ "renderer/queue_submit_empty", benchmarkQueueSubmitEmpty, endRendererSample, pRendererState, 1000 });
+	benchmarks.push_back({ "renderer/queue_submit_16_semaphores", benchmarkQueueSubmitSemaphores, endRendererSample, pRendererState, 500 });
+
+	std::string vertPath = std::string(pShaderDirectory) + "/vert.spv";
+	std::string fragPath = std::string(pShaderDirectory) + "/frag.spv";
+	if (!fileExists(vertPath) || !fileExists(fragPath))
+	{
+		SHEN_CLIENT_WARN("missing {0} or {1}, skipping renderer/cmd_draw", vertPath, fragPath);
+		return;
+	}
+
+	RenderTargetDesc renderTargetDesc = {};
+	renderTargetDesc.mWidth = RENDERER_BENCHMARK_TARGET_SIZE;
+	renderTargetDesc.mHeight = RENDERER_BENCHMARK_TARGET_SIZE;
+	renderTargetDesc.mFormat = VK_FORMAT_R8G8B8A8_UNORM;
+	addRenderTarget(pRenderer, &renderTargetDesc, &pRendererState->pRenderTarget);
+	pRendererState->pPipeline = addDrawPipeline(pRenderer, vertPath, fragPath, renderTargetDesc.mFormat);
+	benchmarks.push_back({ "renderer/cmd_draw", benchmarkCmdDraw, endRendererSample, pRendererState, 100000 });
+}
+
+void removeRendererMicroBenchmarks()
+{
+	if (!pRendererState)
+		return;
+
+	Renderer* pRenderer = pRendererState->pRenderer;
+	waitQueueIdle(pRendererState->pQueue);
+	if (pRendererState->pPipeline)
+		removePipeline(pRenderer, pRendererState->pPipeline);
+	if (pRendererState->pRenderTarget)
+		removeRenderTarget(pRenderer, pRendererState->pRenderTarget);
+	for (uint32_t i = 0; i < RENDERER_BENCHMARK_SEMAPHORE_COUNT; ++i)
+		removeSemaphore(pRenderer, pRendererState->pSemaphores[i]);
+	removeCmd(pRenderer, pRendererState->pCmd);
+	removeCmdPool(pRenderer, pRendererState->pCmdPool);
+	// 与 Sandbox 一致, 渲染器没有 exitRenderer, 设备随进程退出释放
+	delete pRendererState;
+	pRendererState = NULL;
+}
@@ -2,6 +2,7 @@
 #include "Core/App.h"
 #include "TestLayer.h"
 #include "Renderer/Renderer.h"
+#include "Renderer/GpuProfiler.h"
 #include "ImGui/UI.h"
 
 const int MAX_FRAMES_IN_FLIGHT = 2;
@@ -9,12 +10,10 @@ const int MAX_FRAMES_IN_FLIGHT = 2;
 Renderer* pRenderer = NULL;
 Queue* pGraphicsQueue = NULL;
 SwapChain* pSwapChain = NULL;
-RenderPass* pRenderPass = NULL;
 Pipeline* pPipeline = NULL;
 VkPipelineLayout pipelineLayout;
 VkPipeline graphicsPipeline;
 std::vector<Texture> pTextures;
-std::vector<FrameBuffer*> pFrameBuffers;
 CmdPool* pCmdPool = NULL;
 Cmd* pCmds[MAX_FRAMES_IN_FLIGHT] = { NULL };
 Semaphore* pImageAvailableSemaphores[MAX_FRAMES_IN_FLIGHT] = { NULL };
@@ -46,6 +45,7 @@ public:
 		QueueDesc queueDesc = {};
 		queueDesc.mType = QUEUE_TYPE_GRAPHICS;
 		queueDesc.mFlag = QUEUE_FLAG_INIT_MICROPROFILE;
+		queueDesc.mGpuProfilerFrameCount = MAX_FRAMES_IN_FLIGHT;
 		addQueue(pRenderer, &queueDesc, &pGraphicsQueue);
 
 		//Application::Get().PushLayer(new TestLayer());
@@ -67,7 +67,8 @@ public:
 		addShader(pRenderer, &shaderDesc, &pFragShader);
 
 		GraphicsPipelineDesc graphicsPinelineDesc = {};
-		graphicsPinelineDesc.pColorFormats = pSwapChain->pDesc->mImageFormat;
+		graphicsPinelineDesc.pColorFormats = &pSwapChain->pDesc->mImageFormat;
+		graphicsPinelineDesc.mRenderTargetCount = 1;
 		graphicsPinelineDesc.pShaderCount = 2;
 		graphicsPinelineDesc.pShaders[0] = pVertShader;
 		graphicsPinelineDesc.pShaders[1] = pFragShader;
@@ -77,8 +78,10 @@ public:
 		pipelineDesc.mType = PIPELINE_TYPE_GRAPHICS;
 		addPipeline(pRenderer, &pipelineDesc, &pPipeline);
 
+		removeShader(pRenderer, pVertShader);
+		removeShader(pRenderer, pFragShader);
+
 		pipelineLayout = pPipeline->mVkPipelineLayout;
-		pRenderPass = &pPipeline->mRenderPass;
 		graphicsPipeline = pPipeline->pVkPipeline;
 
 	}
@@ -86,7 +89,6 @@ public:
 	bool Load() override
 	{
 		createGraphicsPipeline();
-		createFramebuffers();
 		createCommandPool();
 		createCommandBuffers();
 		createSyncObjects();
@@ -98,24 +100,9 @@ public:
 		uiRenderDesc.pRenderer = pRenderer;
 		uiRenderDesc.pCmdPool = pCmdPool;
 		initUserInterface(&uiRenderDesc);
-		createImGuiCommandBuffers(pTextures);
 		return true;
 	}
 
-	void createFramebuffers() {
-		FrameBufferDesc frameBufferDesc = {};
-		frameBufferDesc.mHeight = pSwapChain->pDesc->mHeight;
-		frameBufferDesc.mWidth = pSwapChain->pDesc->mWidth;
-		frameBufferDesc.pRenderPass = pRenderPass;
-		pFrameBuffers.resize(pTextures.size());
-		FrameBuffer* pFrameBuffer = NULL;
-		for (size_t i = 0; i < pTextures.size(); i++)
-		{
-			frameBufferDesc.pTexture = &pTextures[i];
-			addFrameBuffer(pRenderer, &frameBufferDesc, &pFrameBuffers[i]);
-		}
-	}
-
 	void createCommandPool()
 	{
 		CmdPoolDesc cmdPoolDesc = {};
@@ -150,8 +137,16 @@ public:
 		//开始指令录制
 		Cmd* cmd = pCmds[currentFrame];
 		beginCmd(cmd);
-		//绑定到渲染子通道
-		cmdBindRenderPass(cmd, pRenderPass, pFrameBuffers[imageIndex]);
+		cmdBeginGpuFrameProfile(cmd);
+		//开始渲染到交换链图像
+		RenderingDesc renderingDesc = {};
+		renderingDesc.mColorAttachmentCount = 1;
+		renderingDesc.mColorAttachments[0].pTexture = &pTextures[imageIndex];
+		renderingDesc.mColorAttachments[0].mLoadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+		renderingDesc.mColorAttachments[0].mStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+		renderingDesc.mColorAttachments[0].mClearValue = { {{0.0f, 0.0f, 0.0f, 1.0f}} };
+		cmdBeginGpuTimestampQuery(cmd, "Triangle");
+		cmdBeginRendering(cmd, &renderingDesc);
 		//指令绑定到管线
 		cmdBindPipeline(cmd, pPipeline);
 		// 设置指令视口尺寸
@@ -164,9 +159,15 @@ public:
 		//指令绘制
 		cmdDraw(cmd, 3, 0);
 
-		vkCmdEndRenderPass(cmd->pVkCmdBuf);
+		cmdEndRendering(cmd);
+		cmdEndGpuTimestampQuery(cmd);
 		//绘制UI
-		cmdDrawUserInterface(cmd,imageIndex,currentFrame, pInFlightFences[currentFrame]->pVkFence);
+		cmdBeginGpuTimestampQuery(cmd, "UI");
+		cmdDrawUserInterface(cmd, &pTextures[imageIndex]);
+		cmdEndGpuTimestampQuery(cmd);
+		//转换为呈现布局
+		cmdTextureBarrier(cmd, &pTextures[imageIndex], VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
+		cmdEndGpuFrameProfile(cmd);
 		// 结束绘制
 		endCmd(cmd);
 		//图像队列提交
@@ -0,0 +1,181 @@
+﻿#include "Core/JobSystem.h"
+#include "Core/Log.h"
+#include "Core/Memory.h"
+#include "Core/Profiler.h"
+#include "Renderer/TextureLoader.h"
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+/// <summary>
+/// 命令行参数
+/// </summary>
+typedef struct TextureCookerSettings
+{
+	std::vector<const char*>	mInputs;
+	// 为空时输出到输入文件所在目录
+	const char*					pOutputDirectory = NULL;
+	TextureCompressionFormat	mFormat = TEXTURE_COMPRESSION_BC7;
+	TextureCompressionQuality	mQuality = TEXTURE_COMPRESSION_QUALITY_NORMAL;
+	uint32_t					mFlags = TEXTURE_LOAD_FLAG_SRGB | TEXTURE_LOAD_FLAG_GENERATE_MIPS;
+	// 输出比输入新时默认跳过
+	bool						mForce = false;
+} TextureCookerSettings;
+
+static void printUsage()
+{
+	printf(
+		"Usage: TextureCooker [options] <input image>...\n"
+		"  Compresses each image into <name>" TEXTURE_FILE_EXTENSION " (format version %d)\n"
+		"  --output-dir <dir>         write the cooked files to <dir> instead of next to the inputs\n"
+		"  --format bc1|bc3|bc5|bc7   block format (default bc7); bc1 drops alpha, bc5 keeps only red and green\n"
+		"  --quality fast|normal|high encoder effort (default normal)\n"
+		"  --linear                   the image holds data, not color (normal, roughness, masks)\n"
+		"  --no-mips                  only write mip 0\n"
+		"  --force                    cook even when the output is newer than the input\n",
+		TEXTURE_FILE_VERSION);
+}
+
+static bool parseFormat(const std::string& name, TextureCompressionFormat* pFormat)
+{
+	static const char* formatNames[TEXTURE_COMPRESSION_FORMAT_COUNT] = { "bc1", "bc3", "bc5", "bc7" };
+	for (uint32_t i = 0; i < TEXTURE_COMPRESSION_FORMAT_COUNT; ++i)
+	{
+		if (name == formatNames[i])
+		{
+			*pFormat = (TextureCompressionFormat)i;
+			return true;
+		}
+	}
+	SHEN_CLIENT_ERROR("unknown format {0}", name);
+	return false;
+}
+
+static bool parseQuality(const std::string& name, TextureCompressionQuality* pQuality)
+{
+	if (name == "fast")
+		*pQuality = TEXTURE_COMPRESSION_QUALITY_FAST;
+	else if (name == "normal")
+		*pQuality = TEXTURE_COMPRESSION_QUALITY_NORMAL;
+	else if (name == "high")
+		*pQuality = TEXTURE_COMPRESSION_QUALITY_HIGH;
+	else
+	{
+		SHEN_CLIENT_ERROR("unknown quality {0}", name);
+		return false;
+	}
+	return true;
+}
+
+static bool parseSettings(int argc, char** argv, TextureCookerSettings* pSettings)
+{
+	for (int i = 1; i < argc; ++i)
+	{
+		std::string arg = argv[i];
+		if (arg == "--linear")
+			pSettings->mFlags &= ~TEXTURE_LOAD_FLAG_SRGB;
+		else if (arg == "--no-mips")
+			pSettings->mFlags &= ~TEXTURE_LOAD_FLAG_GENERATE_MIPS;
+		else if (arg == "--force")
+			pSettings->mForce = true;
+		else if (arg == "--output-dir" && i + 1 < argc)
+			pSettings->pOutputDirectory = argv[++i];
+		else if (arg == "--format" && i + 1 < argc)
+		{
+			if (!parseFormat(argv[++i], &pSettings->mFormat))
+				return false;
+		}
+		else if (arg == "--quality" && i + 1 < argc)
+		{
+			if (!parseQuality(argv[++i], &pSettings->mQuality))
+				return false;
+		}
+		else if (arg == "--help")
+			return false;
+		else if (arg.rfind("--", 0) == 0)
+		{
+			SHEN_CLIENT_ERROR("unknown option {0}", arg);
+			return false;
+		}
+		else
+			pSettings->mInputs.push_back(argv[i]);
+	}
+	return !pSettings->mInputs.empty();
+}
+
+static bool isUpToDate(const fs::path& input, const fs::path& output)
+{
+	std::error_code error;
+	fs::file_time_type outputTime = fs::last_write_time(output, error);
+	if (error)
+		return false;
+	fs::file_time_type inputTime = fs::last_write_time(input, error);
+	return !error && outputTime >= inputTime;
+}
+
+/// <summary>
+/// 先写入临时文件再替换, 中途失败或被中断时不会留下半个输出文件
+/// </summary>
+static bool cookTextureFile(const TextureCookerSettings* pSettings, const char* pInput)
+{
+	fs::path input = pInput;
+	fs::path outputDirectory = pSettings->pOutputDirectory ? fs::path(pSettings->pOutputDirectory) : input.parent_path();
+	fs::path output = outputDirectory / input.stem();
+	output += TEXTURE_FILE_EXTENSION;
+	if (!pSettings->mForce && isUpToDate(input, output))
+	{
+		fmt::print("{0} is up to date\n", output.string());
+		return true;
+	}
+
+	std::error_code error;
+	if (!outputDirectory.empty())
+		fs::create_directories(outputDirectory, error);
+	fs::path temporary = output;
+	temporary += ".tmp";
+	if (!cookTexture(input.string().c_str(), temporary.string().c_str(), pSettings->mFormat, pSettings->mQuality, pSettings->mFlags))
+		return false;
+
+	fs::rename(temporary, output, error);
+	if (error)
+	{
+		SHEN_CLIENT_ERROR("failed to replace {0}: {1}", output.string(), error.message());
+		fs::remove(temporary, error);
+		return false;
+	}
+	fmt::print("wrote {0} ({1} KB)\n", output.string(), fs::file_size(output, error) / 1024);
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	Log::Init();
+	initMemorySystem("TextureCooker");
+	initProfiler();
+	initJobSystem(0);
+
+	int result = 0;
+	TextureCookerSettings settings;
+	if (!parseSettings(argc, argv, &settings))
+	{
+		printUsage();
+		result = 1;
+	}
+	else
+	{
+		for (const char* pInput : settings.mInputs)
+		{
+			if (!cookTextureFile(&settings, pInput))
+				result = 1;
+		}
+	}
+
+	exitJobSystem();
+	exitProfiler();
+	exitMemorySystem();
+	Log::Shutdown();
+	return result;
+}
@@ -1,5 +1,12 @@
 #include "Application.h"
 #include "Renderer/Renderer.h"
+#include "Core/Memory.h"
+#include "Core/Profiler.h"
+#include "Core/FlightRecorder.h"
+#include "Core/JobSystem.h"
+#include "Core/MetricsExporter.h"
+#include "ImGui/PerformanceOverlay.h"
+#include "ImGui/UI.h"
 
 static App* pApp = nullptr;
 
@@ -21,7 +28,7 @@ Application::Application(int argc, char** argv, App* app) {
 
 	m_Window->SetEventCallback(SHEN_BIND_EVENT_FN(OnEvent));
 
-	// ʼϵͳ
+	// 初始化子系统
 	InitBaseSubSystems();
 
 	pApp = app;
@@ -31,6 +38,9 @@ Application::Application(int argc, char** argv, App* app) {
 
 	m_ImGuiLayer = new ImGuiLayer();
 	PushOverlay(m_ImGuiLayer);
+
+	m_PerformanceOverlay = new PerformanceOverlay();
+	PushOverlay(m_PerformanceOverlay);
 }
 
 Application::~Application() 
@@ -39,12 +49,11 @@ Application::~Application()
 }
 
 /// <summary>
-/// ʼϵͳ
+/// 初始化子系统
 /// </summary>
 /// <returns></returns>
 bool Application::InitBaseSubSystems()
 {
-	extern bool platformInitUserInterface();
 	if (!platformInitUserInterface())
 	{
 		return false;
@@ -56,46 +65,53 @@ bool Application::InitBaseSubSystems()
 void Application::Run() {
 	while (m_Running)
 	{
+		SHEN_PROFILE_FRAME();
+		flightRecorderBeginFrame();
+		metricsExporterBeginFrame();
+		SHEN_PROFILE_SCOPE("Application::Run");
 		float time = (float)glfwGetTime();
 		Timestep timestep = time - m_LastFrameTime;
 		m_LastFrameTime = time;
+		updateMemoryStats(timestep);
 
 		if (!m_Minimized)
 		{
 			{
-
+				SHEN_PROFILE_SCOPE("LayerStack::OnUpdate");
 				for (Layer* layer : m_LayerStack)
 					layer->OnUpdate(timestep);
 			}
 
 			m_ImGuiLayer->Begin();
 			{
-
+				SHEN_PROFILE_SCOPE("LayerStack::OnImGuiRender");
 				for (Layer* layer : m_LayerStack)
 					layer->OnImGuiRender();
 			}
 			m_ImGuiLayer->End();
 		}
 
-		m_Window->OnUpdate();
+		{
+			SHEN_PROFILE_SCOPE("Window::OnUpdate");
+			m_Window->OnUpdate();
+		}
 
-		pApp->Draw();
+		{
+			SHEN_PROFILE_SCOPE("App::Draw");
+			pApp->Draw();
+		}
 	}
 
 }
 
 void Application::OnEvent(Event& e)
 {
+	SHEN_PROFILE_FUNCTION();
 	EventDispatcher dispatcher(e);
 	//SHEN_CORE_INFO("{0}", e);
 	dispatcher.Dispatch<WindowCloseEvent>(SHEN_BIND_EVENT_FN(Application::OnWindowClose));
 	dispatcher.Dispatch<WindowResizeEvent>(SHEN_BIND_EVENT_FN(Application::OnWindowResize));
-	for (auto it = m_LayerStack.rbegin(); it != m_LayerStack.rend(); ++it)
-	{
-		if (e.Handled)
-			break;
-		(*it)->OnEvent(e);
-	}
+	m_LayerStack.OnEvent(e);
 }
 
 void Application::PushLayer(Layer* layer)
@@ -130,8 +146,50 @@ void Application::Close()
 
 int CreateApplication(int argc, char** argv, App* app) {
 	Log::Init();
+	initMemorySystem(app->GetName());
+	initProfiler();
+	initJobSystem(0);
+
+	// SHEN_CAPTURE_FRAMES=N 启动后立即捕获 N 帧, 写出 <应用名>_trace.json
+	const char* pCaptureFrames = getenv("SHEN_CAPTURE_FRAMES");
+	if (pCaptureFrames && atoi(pCaptureFrames) > 0)
+	{
+		std::string traceFile = std::string(app->GetName()) + "_trace.json";
+		profilerRequestCapture((uint32_t)atoi(pCaptureFrames), traceFile.c_str());
+	}
+
+	// SHEN_FLIGHT_RECORDER=0 关闭帧尖峰记录
+	const char* pFlightRecorder = getenv("SHEN_FLIGHT_RECORDER");
+	if (!pFlightRecorder || atoi(pFlightRecorder) != 0)
+	{
+		FlightRecorderDesc flightRecorderDesc = {};
+		flightRecorderDesc.pName = app->GetName();
+		initFlightRecorder(&flightRecorderDesc);
+	}
+
+	// SHEN_METRICS_PORT=<端口> 在 127.0.0.1 上提供 Prometheus 指标, SHEN_METRICS_FILE=<文件> 追加 JSON 行,
+	// SHEN_METRICS_INTERVAL=<秒> 设置聚合间隔
+	const char* pMetricsPort = getenv("SHEN_METRICS_PORT");
+	const char* pMetricsFile = getenv("SHEN_METRICS_FILE");
+	if ((pMetricsPort && atoi(pMetricsPort) > 0) || (pMetricsFile && pMetricsFile[0]))
+	{
+		const char* pMetricsInterval = getenv("SHEN_METRICS_INTERVAL");
+		MetricsExporterDesc metricsDesc = {};
+		metricsDesc.pName = app->GetName();
+		metricsDesc.mHttpPort = pMetricsPort ? (uint16_t)atoi(pMetricsPort) : 0;
+		metricsDesc.pJsonFile = (pMetricsFile && pMetricsFile[0]) ? pMetricsFile : NULL;
+		metricsDesc.mIntervalSeconds = pMetricsInterval ? (float)atof(pMetricsInterval) : 0.0f;
+		initMetricsExporter(&metricsDesc);
+	}
+
 	Application* application = new Application(argc, argv, app);
 	application->Run();
 	delete application;
+	exitMetricsExporter();
+	exitFlightRecorder();
+	exitJobSystem();
+	exitProfiler();
+	exitMemorySystem();
+	Log::Shutdown();
 	return 0;
 }
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "Events/ApplicationEvent.h"
 
 #include "ImGui/ImGuiLayer.h"
+#include "ImGui/PerformanceOverlay.h"
 #include "LayerStack.h"
 #include "Core/App.h"
 
@@ -26,6 +27,7 @@ public:
 	void PushOverlay(Layer* layer);
 
 	ImGuiLayer* GetImGuiLayer() { return m_ImGuiLayer; }
+	PerformanceOverlay* GetPerformanceOverlay() { return m_PerformanceOverlay; }
 
 	Window& GetWindow() { return *m_Window; }
 
@@ -50,6 +52,7 @@ private:
 private:
 	static Application* s_Instance;
 	ImGuiLayer* m_ImGuiLayer;
+	PerformanceOverlay* m_PerformanceOverlay;
 	LayerStack m_LayerStack;
 
 };
\ No newline at end of file
@@ -0,0 +1,753 @@
+#include "AssetPack.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "Core/JobSystem.h"
+#include "Core/Log.h"
+#include "Core/Lz4.h"
+#include "Core/MappedFile.h"
+#include "Core/Memory.h"
+#include "Core/Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <condition_variable>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// The decode thread hands at most this many blocks to one parallelFor, so a high-priority request that
+	// arrives while a long list of small assets is decoding waits for one batch only
+	const uint32_t MAX_DECODE_BATCH_BLOCKS = 256;
+	// ReadFile takes a 32-bit size, larger reads are split
+	const uint64_t MAX_READ_SIZE = 1ull << 30;
+
+	typedef enum AssetRequestState
+	{
+		ASSET_REQUEST_STATE_QUEUED_READ = 0,
+		ASSET_REQUEST_STATE_READING,
+		ASSET_REQUEST_STATE_QUEUED_DECODE,
+		ASSET_REQUEST_STATE_DECODING,
+		ASSET_REQUEST_STATE_COMPLETE,
+		ASSET_REQUEST_STATE_FAILED,
+	} AssetRequestState;
+
+	template<typename T>
+	using AssetVector = std::vector<T, CategoryAllocator<T, MEMORY_CATEGORY_ASSETS>>;
+	typedef std::deque<AssetRequest*, CategoryAllocator<AssetRequest*, MEMORY_CATEGORY_ASSETS>> AssetRequestQueue;
+
+	// One block of one request, decoded by a job worker
+	struct DecodeJob
+	{
+		AssetRequest*  pRequest;
+		const uint8_t* pStored;
+		uint8_t*       pData;
+		uint32_t       mStoredSize;
+		uint32_t       mSize;
+	};
+
+	struct CompressContext
+	{
+		const uint8_t*  pSource;
+		uint64_t        mSourceSize;
+		uint32_t        mBlockSize;
+		uint8_t*        pCompressed;
+		size_t          mSlotSize;
+		AssetPackBlock* pBlocks;
+	};
+}
+
+struct AssetRequest
+{
+	AssetPack*            pPack;
+	const AssetPackEntry* pEntry;
+	// The blocks as stored in the file. NULL when every block is raw and the read lands in pData directly.
+	uint8_t*              pStoredData;
+	uint8_t*              pData;
+	// Index into AssetPack::mRequests
+	uint32_t              mIndex;
+	// The fields below are guarded by AssetPack::mMutex
+	AssetPriority         mPriority;
+	AssetRequestState     mState;
+	// Released while a pack thread was working on it, that thread frees it once done
+	bool                  mReleased;
+	std::atomic<bool>     mDecodeFailed;
+};
+
+struct AssetPack
+{
+	std::string                 mFileName;
+#ifdef _WIN32
+	void*                       pFileHandle;
+#else
+	int                         mFileDescriptor;
+#endif
+	AssetPackHeader             mHeader;
+	AssetVector<uint8_t>        mToc;
+	const AssetPackEntry*       pEntries;
+	const AssetPackBlock*       pBlocks;
+	const char*                 pNames;
+
+	std::mutex                  mMutex;
+	std::condition_variable     mReadAvailable;
+	std::condition_variable     mDecodeAvailable;
+	std::condition_variable     mRequestCompleted;
+	AssetRequestQueue           mReadQueues[ASSET_PRIORITY_COUNT];
+	AssetRequestQueue           mDecodeQueues[ASSET_PRIORITY_COUNT];
+	// Every request that was not released yet
+	AssetVector<AssetRequest*>  mRequests;
+	bool                        mQuit;
+	std::thread                 mIoThread;
+	std::thread                 mDecodeThread;
+};
+
+// Separators become '/', a leading "./" or "/" is dropped
+static std::string normalizeAssetName(const char* pName)
+{
+	std::string name = pName;
+	std::replace(name.begin(), name.end(), '\\', '/');
+	size_t start = 0;
+	for (;;)
+	{
+		if (name.compare(start, 2, "./") == 0)
+			start += 2;
+		else if (name.compare(start, 1, "/") == 0)
+			start += 1;
+		else
+			break;
+	}
+	return name.substr(start);
+}
+
+static uint64_t hashAssetName(const char* pName, size_t length)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (size_t i = 0; i < length; ++i)
+	{
+		hash ^= (uint8_t)pName[i];
+		hash *= 1099511628211ull;
+	}
+	return hash;
+}
+
+static uint32_t getBlockSize(const AssetPackEntry* pEntry, uint32_t blockSize, uint32_t block)
+{
+	return (uint32_t)std::min<uint64_t>(blockSize, pEntry->mSize - (uint64_t)block * blockSize);
+}
+
+#ifdef _WIN32
+
+static bool openPackFile(AssetPack* pPack)
+{
+	HANDLE file = CreateFileA(pPack->mFileName.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		SHEN_CORE_ERROR("failed to open {0} (error {1})", pPack->mFileName, GetLastError());
+		return false;
+	}
+	pPack->pFileHandle = file;
+	return true;
+}
+
+static void closePackFile(AssetPack* pPack)
+{
+	if (pPack->pFileHandle)
+		CloseHandle(pPack->pFileHandle);
+	pPack->pFileHandle = NULL;
+}
+
+// Positional read, the handle's file pointer is not shared state between the I/O thread and openAssetPack
+static bool readPackFile(const AssetPack* pPack, uint64_t offset, void* pData, uint64_t size)
+{
+	uint8_t* pOut = (uint8_t*)pData;
+	while (size)
+	{
+		OVERLAPPED overlapped = {};
+		overlapped.Offset = (DWORD)offset;
+		overlapped.OffsetHigh = (DWORD)(offset >> 32);
+		DWORD bytesRead = 0;
+		if (!ReadFile(pPack->pFileHandle, pOut, (DWORD)std::min(size, MAX_READ_SIZE), &bytesRead, &overlapped) || !bytesRead)
+		{
+			SHEN_CORE_ERROR("failed to read {0} at offset {1} (error {2})", pPack->mFileName, offset, GetLastError());
+			return false;
+		}
+		pOut += bytesRead;
+		offset += bytesRead;
+		size -= bytesRead;
+	}
+	return true;
+}
+
+#else
+
+static bool openPackFile(AssetPack* pPack)
+{
+	pPack->mFileDescriptor = open(pPack->mFileName.c_str(), O_RDONLY);
+	if (pPack->mFileDescriptor < 0)
+	{
+		SHEN_CORE_ERROR("failed to open {0}: {1}", pPack->mFileName, strerror(errno));
+		return false;
+	}
+	return true;
+}
+
+static void closePackFile(AssetPack* pPack)
+{
+	if (pPack->mFileDescriptor >= 0)
+		close(pPack->mFileDescriptor);
+	pPack->mFileDescriptor = -1;
+}
+
+static bool readPackFile(const AssetPack* pPack, uint64_t offset, void* pData, uint64_t size)
+{
+	uint8_t* pOut = (uint8_t*)pData;
+	while (size)
+	{
+		ssize_t bytesRead = pread(pPack->mFileDescriptor, pOut, (size_t)std::min(size, MAX_READ_SIZE), (off_t)offset);
+		if (bytesRead < 0 && errno == EINTR)
+			continue;
+		if (bytesRead <= 0)
+		{
+			SHEN_CORE_ERROR("failed to read {0} at offset {1}: {2}", pPack->mFileName, offset,
+				bytesRead < 0 ? strerror(errno) : "unexpected end of file");
+			return false;
+		}
+		pOut += bytesRead;
+		offset += (uint64_t)bytesRead;
+		size -= (uint64_t)bytesRead;
+	}
+	return true;
+}
+
+#endif
+
+static void compressBlockJob(void* pUserData, uint32_t index)
+{
+	CompressContext* pContext = (CompressContext*)pUserData;
+	uint64_t offset = (uint64_t)index * pContext->mBlockSize;
+	uint32_t size = (uint32_t)std::min<uint64_t>(pContext->mBlockSize, pContext->mSourceSize - offset);
+	const uint8_t* pSource = pContext->pSource + offset;
+	uint8_t* pCompressed = pContext->pCompressed + index * pContext->mSlotSize;
+	// A compressed block is always smaller than its data, so equal sizes mark raw blocks
+	size_t storedSize = lz4CompressBlock(pSource, size, pCompressed, size - 1);
+	if (!storedSize)
+	{
+		memcpy(pCompressed, pSource, size);
+		storedSize = size;
+	}
+	pContext->pBlocks[index].mStoredSize = (uint32_t)storedSize;
+}
+
+bool writeAssetPack(const char* pFileName, const AssetPackSource* pSources, uint32_t count)
+{
+	SHEN_PROFILE_FUNCTION();
+	std::vector<std::string> names(count);
+	std::vector<uint32_t> nameOrder(count);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		names[i] = normalizeAssetName(pSources[i].pName);
+		nameOrder[i] = i;
+	}
+	std::sort(nameOrder.begin(), nameOrder.end(), [&names](uint32_t a, uint32_t b) { return names[a] < names[b]; });
+	for (uint32_t i = 1; i < count; ++i)
+	{
+		if (names[nameOrder[i]] == names[nameOrder[i - 1]])
+		{
+			SHEN_CORE_ERROR("{0} and {1} are both packed as {2}", pSources[nameOrder[i - 1]].pFileName, pSources[nameOrder[i]].pFileName,
+				names[nameOrder[i]]);
+			return false;
+		}
+	}
+
+	FILE* pFile = fopen(pFileName, "wb");
+	if (!pFile)
+	{
+		SHEN_CORE_ERROR("failed to create {0}", pFileName);
+		return false;
+	}
+
+	AssetPackHeader header = {};
+	header.mMagic = ASSET_PACK_MAGIC;
+	header.mVersion = ASSET_PACK_VERSION;
+	header.mBlockSize = ASSET_PACK_BLOCK_SIZE;
+	// Placeholder, rewritten once the TOC offset is known
+	bool written = fwrite(&header, sizeof(header), 1, pFile) == 1;
+	uint64_t offset = sizeof(header);
+
+	AssetVector<AssetPackEntry> entries(count);
+	AssetVector<AssetPackBlock> blocks;
+	AssetVector<uint8_t> compressed;
+	std::string nameTable;
+	const size_t slotSize = lz4CompressBound(ASSET_PACK_BLOCK_SIZE);
+	for (uint32_t i = 0; i < count && written; ++i)
+	{
+		MappedFile source;
+		if (!openMappedFile(pSources[i].pFileName, true, &source))
+		{
+			written = false;
+			break;
+		}
+
+		AssetPackEntry& entry = entries[i];
+		entry.mNameHash = hashAssetName(names[i].data(), names[i].size());
+		entry.mNameOffset = (uint32_t)nameTable.size();
+		entry.mNameLength = (uint32_t)names[i].size();
+		entry.mDataOffset = offset;
+		entry.mSize = source.mSize;
+		entry.mFirstBlock = (uint32_t)blocks.size();
+		entry.mBlockCount = (uint32_t)((source.mSize + ASSET_PACK_BLOCK_SIZE - 1) / ASSET_PACK_BLOCK_SIZE);
+		nameTable += names[i];
+		blocks.resize(blocks.size() + entry.mBlockCount);
+		compressed.resize(std::max<size_t>(compressed.size(), entry.mBlockCount * slotSize));
+
+		CompressContext context;
+		context.pSource = source.pData;
+		context.mSourceSize = source.mSize;
+		context.mBlockSize = ASSET_PACK_BLOCK_SIZE;
+		context.pCompressed = compressed.data();
+		context.mSlotSize = slotSize;
+		context.pBlocks = blocks.data() + entry.mFirstBlock;
+		parallelFor(entry.mBlockCount, compressBlockJob, &context);
+
+		entry.mStoredSize = 0;
+		for (uint32_t block = 0; block < entry.mBlockCount && written; ++block)
+		{
+			uint32_t storedSize = context.pBlocks[block].mStoredSize;
+			written = fwrite(compressed.data() + block * slotSize, 1, storedSize, pFile) == storedSize;
+			entry.mStoredSize += storedSize;
+		}
+		offset += entry.mStoredSize;
+		closeMappedFile(&source);
+	}
+
+	std::sort(entries.begin(), entries.end(), [&nameTable](const AssetPackEntry& a, const AssetPackEntry& b)
+	{
+		if (a.mNameHash != b.mNameHash)
+			return a.mNameHash < b.mNameHash;
+		return nameTable.compare(a.mNameOffset, a.mNameLength, nameTable, b.mNameOffset, b.mNameLength) < 0;
+	});
+	header.mEntryCount = count;
+	header.mBlockCount = (uint32_t)blocks.size();
+	header.mNameBytes = (uint32_t)nameTable.size();
+	header.mTocOffset = offset;
+	header.mFileSize = offset + count * sizeof(AssetPackEntry) + blocks.size() * sizeof(AssetPackBlock) + nameTable.size();
+	written = written &&
+		fwrite(entries.data(), sizeof(AssetPackEntry), count, pFile) == count &&
+		fwrite(blocks.data(), sizeof(AssetPackBlock), blocks.size(), pFile) == blocks.size() &&
+		fwrite(nameTable.data(), 1, nameTable.size(), pFile) == nameTable.size() &&
+		fseek(pFile, 0, SEEK_SET) == 0 &&
+		fwrite(&header, sizeof(header), 1, pFile) == 1;
+	written = fclose(pFile) == 0 && written;
+	if (!written)
+	{
+		SHEN_CORE_ERROR("failed to write {0}", pFileName);
+		remove(pFileName);
+	}
+	return written;
+}
+
+// Checks that every lookup and read the TOC can lead to stays inside the file
+static bool validateAssetPack(const AssetPack* pPack)
+{
+	const AssetPackHeader& header = pPack->mHeader;
+	for (uint32_t i = 0; i < header.mEntryCount; ++i)
+	{
+		const AssetPackEntry& entry = pPack->pEntries[i];
+		if ((i && entry.mNameHash < pPack->pEntries[i - 1].mNameHash) ||
+			(uint64_t)entry.mNameOffset + entry.mNameLength > header.mNameBytes ||
+			hashAssetName(pPack->pNames + entry.mNameOffset, entry.mNameLength) != entry.mNameHash ||
+			(uint64_t)entry.mFirstBlock + entry.mBlockCount > header.mBlockCount ||
+			// mBlockCount == ceil(mSize / mBlockSize), written so that neither side can overflow
+			entry.mSize > (uint64_t)entry.mBlockCount * header.mBlockSize ||
+			(entry.mBlockCount && entry.mSize <= (uint64_t)(entry.mBlockCount - 1) * header.mBlockSize) ||
+			entry.mDataOffset < sizeof(AssetPackHeader) || entry.mDataOffset > header.mTocOffset ||
+			entry.mStoredSize > header.mTocOffset - entry.mDataOffset)
+			return false;
+
+		uint64_t storedSize = 0;
+		for (uint32_t block = 0; block < entry.mBlockCount; ++block)
+		{
+			uint32_t blockStoredSize = pPack->pBlocks[entry.mFirstBlock + block].mStoredSize;
+			if (!blockStoredSize || blockStoredSize > getBlockSize(&entry, header.mBlockSize, block))
+				return false;
+			storedSize += blockStoredSize;
+		}
+		if (storedSize != entry.mStoredSize)
+			return false;
+	}
+	return true;
+}
+
+static void freeAssetRequest(AssetPack* pPack, AssetRequest* pRequest)
+{
+	AssetRequest* pLast = pPack->mRequests.back();
+	pPack->mRequests[pRequest->mIndex] = pLast;
+	pLast->mIndex = pRequest->mIndex;
+	pPack->mRequests.pop_back();
+	shen_free(pRequest->pStoredData);
+	shen_free(pRequest->pData);
+	shen_delete(pRequest);
+}
+
+static AssetRequest* popHighestPriority(AssetRequestQueue* pQueues)
+{
+	for (int priority = ASSET_PRIORITY_COUNT - 1; priority >= 0; --priority)
+	{
+		if (!pQueues[priority].empty())
+		{
+			AssetRequest* pRequest = pQueues[priority].front();
+			pQueues[priority].pop_front();
+			return pRequest;
+		}
+	}
+	return NULL;
+}
+
+static bool hasQueuedRequest(const AssetRequestQueue* pQueues)
+{
+	for (uint32_t priority = 0; priority < ASSET_PRIORITY_COUNT; ++priority)
+	{
+		if (!pQueues[priority].empty())
+			return true;
+	}
+	return false;
+}
+
+static void removeQueuedRequest(AssetRequestQueue* pQueues, AssetRequest* pRequest)
+{
+	AssetRequestQueue& queue = pQueues[pRequest->mPriority];
+	queue.erase(std::find(queue.begin(), queue.end(), pRequest));
+}
+
+static void ioThreadMain(AssetPack* pPack)
+{
+	SHEN_PROFILE_THREAD("Asset I/O");
+	std::unique_lock<std::mutex> lock(pPack->mMutex);
+	for (;;)
+	{
+		pPack->mReadAvailable.wait(lock, [pPack] { return pPack->mQuit || hasQueuedRequest(pPack->mReadQueues); });
+		if (pPack->mQuit)
+			break;
+		AssetRequest* pRequest = popHighestPriority(pPack->mReadQueues);
+		pRequest->mState = ASSET_REQUEST_STATE_READING;
+		lock.unlock();
+
+		bool succeeded;
+		{
+			SHEN_PROFILE_SCOPE("readAsset");
+			const AssetPackEntry* pEntry = pRequest->pEntry;
+			pRequest->pData = (uint8_t*)shen_malloc(MEMORY_CATEGORY_ASSETS, pEntry->mSize);
+			if (pEntry->mStoredSize != pEntry->mSize)
+				pRequest->pStoredData = (uint8_t*)shen_malloc(MEMORY_CATEGORY_ASSETS, pEntry->mStoredSize);
+			if ((pEntry->mSize && !pRequest->pData) || (pEntry->mStoredSize != pEntry->mSize && !pRequest->pStoredData))
+			{
+				SHEN_CORE_ERROR("{0}: out of memory reading {1} ({2} bytes)", pPack->mFileName,
+					std::string(pPack->pNames + pEntry->mNameOffset, pEntry->mNameLength), pEntry->mSize + pEntry->mStoredSize);
+				succeeded = false;
+			}
+			else
+			{
+				succeeded = readPackFile(pPack, pEntry->mDataOffset, pRequest->pStoredData ? pRequest->pStoredData : pRequest->pData,
+					pEntry->mStoredSize);
+			}
+		}
+
+		lock.lock();
+		if (pRequest->mReleased)
+			freeAssetRequest(pPack, pRequest);
+		else if (succeeded && pRequest->pStoredData)
+		{
+			pRequest->mState = ASSET_REQUEST_STATE_QUEUED_DECODE;
+			pPack->mDecodeQueues[pRequest->mPriority].push_back(pRequest);
+			pPack->mDecodeAvailable.notify_one();
+		}
+		else
+		{
+			pRequest->mState = succeeded ? ASSET_REQUEST_STATE_COMPLETE : ASSET_REQUEST_STATE_FAILED;
+			pPack->mRequestCompleted.notify_all();
+		}
+	}
+}
+
+static void decodeBlockJob(void* pUserData, uint32_t index)
+{
+	DecodeJob* pJob = (DecodeJob*)pUserData + index;
+	if (pJob->mStoredSize == pJob->mSize)
+		memcpy(pJob->pData, pJob->pStored, pJob->mSize);
+	else if (!lz4DecompressBlock(pJob->pStored, pJob->mStoredSize, pJob->pData, pJob->mSize))
+		pJob->pRequest->mDecodeFailed.store(true, std::memory_order_relaxed);
+}
+
+static void decodeThreadMain(AssetPack* pPack)
+{
+	SHEN_PROFILE_THREAD("Asset Decode");
+	std::vector<AssetRequest*> batch;
+	std::vector<DecodeJob> jobs;
+	std::unique_lock<std::mutex> lock(pPack->mMutex);
+	for (;;)
+	{
+		pPack->mDecodeAvailable.wait(lock, [pPack] { return pPack->mQuit || hasQueuedRequest(pPack->mDecodeQueues); });
+		if (pPack->mQuit)
+			break;
+		batch.clear();
+		uint32_t blockCount = 0;
+		while (blockCount < MAX_DECODE_BATCH_BLOCKS && hasQueuedRequest(pPack->mDecodeQueues))
+		{
+			AssetRequest* pRequest = popHighestPriority(pPack->mDecodeQueues);
+			pRequest->mState = ASSET_REQUEST_STATE_DECODING;
+			batch.push_back(pRequest);
+			blockCount += pRequest->pEntry->mBlockCount;
+		}
+		lock.unlock();
+
+		{
+			SHEN_PROFILE_SCOPE("decodeAssets");
+			jobs.clear();
+			for (AssetRequest* pRequest : batch)
+			{
+				const AssetPackEntry* pEntry = pRequest->pEntry;
+				const uint8_t* pStored = pRequest->pStoredData;
+				for (uint32_t block = 0; block < pEntry->mBlockCount; ++block)
+				{
+					DecodeJob job;
+					job.pRequest = pRequest;
+					job.pStored = pStored;
+					job.pData = pRequest->pData + (uint64_t)block * pPack->mHeader.mBlockSize;
+					job.mStoredSize = pPack->pBlocks[pEntry->mFirstBlock + block].mStoredSize;
+					job.mSize = getBlockSize(pEntry, pPack->mHeader.mBlockSize, block);
+					jobs.push_back(job);
+					pStored += job.mStoredSize;
+				}
+			}
+			parallelFor((uint32_t)jobs.size(), decodeBlockJob, jobs.data());
+		}
+
+		for (AssetRequest* pRequest : batch)
+		{
+			shen_free(pRequest->pStoredData);
+			pRequest->pStoredData = NULL;
+			if (pRequest->mDecodeFailed.load(std::memory_order_relaxed))
+			{
+				SHEN_CORE_ERROR("{0}: {1} is corrupt", pPack->mFileName,
+					std::string(pPack->pNames + pRequest->pEntry->mNameOffset, pRequest->pEntry->mNameLength));
+			}
+		}
+		lock.lock();
+		for (AssetRequest* pRequest : batch)
+		{
+			if (pRequest->mReleased)
+				freeAssetRequest(pPack, pRequest);
+			else
+				pRequest->mState = pRequest->mDecodeFailed.load(std::memory_order_relaxed) ? ASSET_REQUEST_STATE_FAILED : ASSET_REQUEST_STATE_COMPLETE;
+		}
+		pPack->mRequestCompleted.notify_all();
+	}
+}
+
+bool openAssetPack(const char* pFileName, AssetPack** ppPack)
+{
+	SHEN_PROFILE_FUNCTION();
+	AssetPack* pPack = shen_new(MEMORY_CATEGORY_ASSETS, AssetPack);
+	pPack->mFileName = pFileName;
+#ifdef _WIN32
+	pPack->pFileHandle = NULL;
+#else
+	pPack->mFileDescriptor = -1;
+#endif
+	pPack->mQuit = false;
+	if (!openPackFile(pPack) || !readPackFile(pPack, 0, &pPack->mHeader, sizeof(AssetPackHeader)))
+	{
+		closePackFile(pPack);
+		shen_delete(pPack);
+		return false;
+	}
+
+	const AssetPackHeader& header = pPack->mHeader;
+	bool valid = header.mMagic == ASSET_PACK_MAGIC && header.mVersion == ASSET_PACK_VERSION;
+	if (!valid)
+		SHEN_CORE_ERROR("{0} is not an asset pack of version {1}; rebuild it with AssetPacker", pFileName, ASSET_PACK_VERSION);
+	uint64_t tocSize = (uint64_t)header.mEntryCount * sizeof(AssetPackEntry) + (uint64_t)header.mBlockCount * sizeof(AssetPackBlock) +
+		header.mNameBytes;
+	if (valid && (!header.mBlockSize || header.mTocOffset < sizeof(AssetPackHeader) || header.mFileSize != header.mTocOffset + tocSize))
+	{
+		SHEN_CORE_ERROR("{0} is truncated or corrupt", pFileName);
+		valid = false;
+	}
+	if (valid)
+	{
+		pPack->mToc.resize(tocSize);
+		valid = readPackFile(pPack, header.mTocOffset, pPack->mToc.data(), tocSize);
+		pPack->pEntries = (const AssetPackEntry*)pPack->mToc.data();
+		pPack->pBlocks = (const AssetPackBlock*)(pPack->pEntries + header.mEntryCount);
+		pPack->pNames = (const char*)(pPack->pBlocks + header.mBlockCount);
+		if (valid && !validateAssetPack(pPack))
+		{
+			SHEN_CORE_ERROR("{0} is truncated or corrupt", pFileName);
+			valid = false;
+		}
+	}
+	if (!valid)
+	{
+		closePackFile(pPack);
+		shen_delete(pPack);
+		return false;
+	}
+
+	pPack->mIoThread = std::thread(ioThreadMain, pPack);
+	pPack->mDecodeThread = std::thread(decodeThreadMain, pPack);
+	SHEN_CORE_INFO("opened {0}: {1} assets", pFileName, header.mEntryCount);
+	*ppPack = pPack;
+	return true;
+}
+
+void closeAssetPack(AssetPack* pPack)
+{
+	{
+		std::lock_guard<std::mutex> lock(pPack->mMutex);
+		pPack->mQuit = true;
+	}
+	pPack->mReadAvailable.notify_all();
+	pPack->mDecodeAvailable.notify_all();
+	pPack->mIoThread.join();
+	pPack->mDecodeThread.join();
+
+	if (!pPack->mRequests.empty())
+		SHEN_CORE_WARN("closing {0} with {1} requests that were not released", pPack->mFileName, pPack->mRequests.size());
+	while (!pPack->mRequests.empty())
+		freeAssetRequest(pPack, pPack->mRequests.back());
+	closePackFile(pPack);
+	shen_delete(pPack);
+}
+
+static const AssetPackEntry* findAssetEntry(const AssetPack* pPack, const char* pName)
+{
+	std::string name = normalizeAssetName(pName);
+	uint64_t hash = hashAssetName(name.data(), name.size());
+	const AssetPackEntry* pEnd = pPack->pEntries + pPack->mHeader.mEntryCount;
+	const AssetPackEntry* pEntry = std::lower_bound(pPack->pEntries, pEnd, hash,
+		[](const AssetPackEntry& entry, uint64_t value) { return entry.mNameHash < value; });
+	for (; pEntry != pEnd && pEntry->mNameHash == hash; ++pEntry)
+	{
+		if (name.compare(0, name.size(), pPack->pNames + pEntry->mNameOffset, pEntry->mNameLength) == 0)
+			return pEntry;
+	}
+	return NULL;
+}
+
+bool findAsset(const AssetPack* pPack, const char* pName, uint64_t* pOutSize)
+{
+	const AssetPackEntry* pEntry = findAssetEntry(pPack, pName);
+	if (pEntry && pOutSize)
+		*pOutSize = pEntry->mSize;
+	return pEntry != NULL;
+}
+
+AssetRequest* requestAsset(AssetPack* pPack, const char* pName, AssetPriority priority)
+{
+	const AssetPackEntry* pEntry = findAssetEntry(pPack, pName);
+	if (!pEntry)
+	{
+		SHEN_CORE_ERROR("{0} has no asset named {1}", pPack->mFileName, pName);
+		return NULL;
+	}
+
+	AssetRequest* pRequest = shen_new(MEMORY_CATEGORY_ASSETS, AssetRequest);
+	pRequest->pPack = pPack;
+	pRequest->pEntry = pEntry;
+	pRequest->pStoredData = NULL;
+	pRequest->pData = NULL;
+	pRequest->mPriority = priority;
+	pRequest->mReleased = false;
+	pRequest->mDecodeFailed.store(false, std::memory_order_relaxed);
+	std::lock_guard<std::mutex> lock(pPack->mMutex);
+	pRequest->mIndex = (uint32_t)pPack->mRequests.size();
+	pPack->mRequests.push_back(pRequest);
+	// Empty assets have nothing to read
+	if (!pEntry->mSize)
+	{
+		pRequest->mState = ASSET_REQUEST_STATE_COMPLETE;
+		return pRequest;
+	}
+	pRequest->mState = ASSET_REQUEST_STATE_QUEUED_READ;
+	pPack->mReadQueues[priority].push_back(pRequest);
+	pPack->mReadAvailable.notify_one();
+	return pRequest;
+}
+
+void setAssetRequestPriority(AssetRequest* pRequest, AssetPriority priority)
+{
+	AssetPack* pPack = pRequest->pPack;
+	std::lock_guard<std::mutex> lock(pPack->mMutex);
+	if (pRequest->mPriority == priority)
+		return;
+	AssetRequestQueue* pQueues = NULL;
+	if (pRequest->mState == ASSET_REQUEST_STATE_QUEUED_READ)
+		pQueues = pPack->mReadQueues;
+	else if (pRequest->mState == ASSET_REQUEST_STATE_QUEUED_DECODE)
+		pQueues = pPack->mDecodeQueues;
+	if (pQueues)
+	{
+		removeQueuedRequest(pQueues, pRequest);
+		pQueues[priority].push_back(pRequest);
+	}
+	pRequest->mPriority = priority;
+}
+
+bool isAssetRequestComplete(const AssetRequest* pRequest)
+{
+	std::lock_guard<std::mutex> lock(pRequest->pPack->mMutex);
+	return pRequest->mState >= ASSET_REQUEST_STATE_COMPLETE;
+}
+
+bool waitForAssetRequest(AssetRequest* pRequest)
+{
+	SHEN_PROFILE_FUNCTION();
+	setAssetRequestPriority(pRequest, ASSET_PRIORITY_HIGH);
+	AssetPack* pPack = pRequest->pPack;
+	std::unique_lock<std::mutex> lock(pPack->mMutex);
+	pPack->mRequestCompleted.wait(lock, [pRequest] { return pRequest->mState >= ASSET_REQUEST_STATE_COMPLETE; });
+	return pRequest->mState == ASSET_REQUEST_STATE_COMPLETE;
+}
+
+const uint8_t* getAssetRequestData(const AssetRequest* pRequest, uint64_t* pOutSize)
+{
+	*pOutSize = pRequest->pEntry->mSize;
+	return pRequest->pData;
+}
+
+void releaseAssetRequest(AssetRequest* pRequest)
+{
+	AssetPack* pPack = pRequest->pPack;
+	std::lock_guard<std::mutex> lock(pPack->mMutex);
+	switch (pRequest->mState)
+	{
+	case ASSET_REQUEST_STATE_QUEUED_READ:
+		removeQueuedRequest(pPack->mReadQueues, pRequest);
+		freeAssetRequest(pPack, pRequest);
+		break;
+	case ASSET_REQUEST_STATE_QUEUED_DECODE:
+		removeQueuedRequest(pPack->mDecodeQueues, pRequest);
+		freeAssetRequest(pPack, pRequest);
+		break;
+	case ASSET_REQUEST_STATE_READING:
+	case ASSET_REQUEST_STATE_DECODING:
+		pRequest->mReleased = true;
+		break;
+	default:
+		freeAssetRequest(pPack, pRequest);
+		break;
+	}
+}
@@ -0,0 +1,65 @@
+#pragma once
+
+#include "Core/AssetPackFormat.h"
+
+#include <cstdint>
+
+// Read-only virtual filesystem over one asset pack (see AssetPackFormat.h). The pack is opened once.
+// Every read is a positional read on that one handle, so thousands of small assets cost no per-file
+// open, seek or close calls.
+// Two threads service the requests of each pack:
+// - The I/O thread fetches each asset's blocks with a single read.
+// - The decode thread hands the compressed blocks of the assets it has collected to the job system,
+//   so decompression runs on the workers and overlaps the next reads.
+// Both threads pick the highest-priority request first, and raising a request's priority moves it ahead of
+// everything queued at its old level.
+//
+// Asset names are relative paths. '\' is treated as '/', a leading "./" or "/" is ignored, and names are
+// case sensitive. Request functions may be called from any thread.
+
+typedef struct AssetPack AssetPack;
+typedef struct AssetRequest AssetRequest;
+
+typedef enum AssetPriority
+{
+	// Prefetching and streaming ahead of need
+	ASSET_PRIORITY_LOW = 0,
+	ASSET_PRIORITY_NORMAL,
+	// Needed for the frame being built (visible objects, blocking loads)
+	ASSET_PRIORITY_HIGH,
+	ASSET_PRIORITY_COUNT
+} AssetPriority;
+
+// One file to pack: pName is the name the asset is requested by, pFileName where its bytes come from
+typedef struct AssetPackSource
+{
+	const char* pName;
+	const char* pFileName;
+} AssetPackSource;
+
+// Writes a pack of the given files. Blocks are compressed in parallel on the job system, blocks LZ4 cannot
+// shrink are stored raw. Returns false (and logs) on unreadable sources, duplicate names or write errors.
+bool writeAssetPack(const char* pFileName, const AssetPackSource* pSources, uint32_t count);
+
+// Returns false (and logs) when the file cannot be opened or its TOC is corrupt
+bool openAssetPack(const char* pFileName, AssetPack** ppPack);
+// Joins the I/O and decode threads. Requests still alive are freed (and reported), their pointers become invalid.
+void closeAssetPack(AssetPack* pPack);
+
+// Returns false when the pack has no asset of that name; pOutSize (optional) receives its uncompressed size
+bool findAsset(const AssetPack* pPack, const char* pName, uint64_t* pOutSize);
+
+// Queues an asynchronous read. Returns NULL (and logs) when the asset does not exist.
+AssetRequest* requestAsset(AssetPack* pPack, const char* pName, AssetPriority priority);
+// Moves a request that has not been read or decoded yet to the back of another priority's queue
+void setAssetRequestPriority(AssetRequest* pRequest, AssetPriority priority);
+// True once the request finished, successfully or not
+bool isAssetRequestComplete(const AssetRequest* pRequest);
+// Blocks until the request finished, raising it to ASSET_PRIORITY_HIGH first. Returns false when the read or
+// the decompression failed (logged).
+bool waitForAssetRequest(AssetRequest* pRequest);
+// Uncompressed bytes of a completed request, valid until the request is released
+const uint8_t* getAssetRequestData(const AssetRequest* pRequest, uint64_t* pOutSize);
+// Frees the request and its data. Pending requests are cancelled; requests being read or decoded are freed
+// by the pack thread once it is done with them.
+void releaseAssetRequest(AssetRequest* pRequest);
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+
+// Binary layout of an asset pack (.spak), written by AssetPacker and read by openAssetPack.
+// Each asset is split into ASSET_PACK_BLOCK_SIZE blocks that are LZ4 compressed on their own, so one
+// asset's blocks decompress in parallel. A block that LZ4 cannot shrink is stored raw. An asset's blocks
+// are stored back to back, so the whole asset is fetched with one read.
+// The table of contents (TOC) follows the data, so the packer can stream the assets out first.
+// The file is little-endian. Bump ASSET_PACK_VERSION whenever any of these structs changes.
+//
+// [AssetPackHeader][asset 0 blocks][asset 1 blocks]...[AssetPackEntry...][AssetPackBlock...][names]
+
+#define ASSET_PACK_MAGIC 0x4B415053u // "SPAK"
+#define ASSET_PACK_VERSION 1
+#define ASSET_PACK_EXTENSION ".spak"
+// Uncompressed size of every block but an asset's last one
+#define ASSET_PACK_BLOCK_SIZE (64u << 10)
+
+typedef struct AssetPackHeader
+{
+	uint32_t mMagic;
+	uint32_t mVersion;
+	uint32_t mBlockSize;
+	uint32_t mEntryCount;
+	uint32_t mBlockCount;
+	uint32_t mNameBytes;
+	// Start of the entry array; the block array and the names follow it without padding
+	uint64_t mTocOffset;
+	// Size of the whole file, used to detect truncated packs
+	uint64_t mFileSize;
+} AssetPackHeader;
+
+// Entries are sorted by mNameHash. Lookups binary search the hash, then compare names to resolve collisions.
+typedef struct AssetPackEntry
+{
+	// FNV-1a 64 of the name as stored, see AssetPack.h for how names are normalized
+	uint64_t mNameHash;
+	// Byte offset into the name table, names are not NUL terminated
+	uint32_t mNameOffset;
+	uint32_t mNameLength;
+	// Offset of the first block from the start of the file
+	uint64_t mDataOffset;
+	// Bytes the blocks occupy in the file and bytes they decompress to
+	uint64_t mStoredSize;
+	uint64_t mSize;
+	uint32_t mFirstBlock;
+	uint32_t mBlockCount;
+} AssetPackEntry;
+
+typedef struct AssetPackBlock
+{
+	// Equal to the block's uncompressed size when it is stored raw
+	uint32_t mStoredSize;
+} AssetPackBlock;
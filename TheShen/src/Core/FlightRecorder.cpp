@@ -0,0 +1,333 @@
+#include "FlightRecorder.h"
+#include "Core/Log.h"
+#include "Core/Memory.h"
+#include "Core/Profiler.h"
+#include "Renderer/GpuProfiler.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+
+namespace
+{
+	// The median is refreshed every few frames, it moves slowly and sorting every frame is wasted work
+	const uint32_t MEDIAN_UPDATE_INTERVAL = 16;
+	// Frames needed before the median is trusted
+	const uint32_t MIN_FRAMES_FOR_MEDIAN = 60;
+
+	enum TraceTrack
+	{
+		TRACK_GPU = 0,
+		TRACK_SPIKES,
+	};
+
+	struct FlightFrame
+	{
+		// Counted by the recorder itself, the profiler's frame index stays 0 when the profiler is compiled out
+		uint64_t       mFrameIndex;
+		uint64_t       mBeginTicks;
+		uint64_t       mEndTicks;
+		// First submit on a queue with a GPU profiler, GPU scopes are drawn from here
+		uint64_t       mSubmitTicks;
+		uint64_t       mPresentTicks;
+		Queue*         pGpuQueue;
+		uint64_t       mGpuFrameIndex;
+		RendererStats  mStats;
+		bool           mHasStats;
+		uint32_t       mGpuTimerCount;
+		GpuTimerResult mGpuTimers[FLIGHT_RECORDER_MAX_GPU_TIMERS];
+	};
+
+	struct FlightRecorder
+	{
+		FlightRecorderDesc mDesc;
+		char               mName[64];
+
+		FlightFrame*       pFrames;
+		// Duration of every frame in the ring, negative for frames left out of spike detection
+		float*             pFrameMilliseconds;
+		float*             pMedianScratch;
+		// Frames started so far, the newest one lives in slot (mFrameCount - 1) % mDesc.mFrameCount
+		uint64_t           mFrameCount;
+		bool               mSkipCurrentFrame;
+
+		float              mMedianMilliseconds;
+		uint32_t           mFramesSinceMedian;
+
+		bool               mDumpPending;
+		uint32_t           mFramesUntilDump;
+		uint64_t           mSpikeFrameIndex;
+		float              mSpikeMilliseconds;
+		float              mSpikeMedianMilliseconds;
+		uint64_t           mSpikeBeginTicks;
+		uint64_t           mSpikeEndTicks;
+		uint64_t           mLastDumpTicks;
+		uint32_t           mDumpCount;
+		uint32_t           mSuppressedSpikes;
+
+		uint64_t           mLastGpuResultFrame;
+		bool               mHasGpuResult;
+	};
+
+	FlightRecorder* pRecorder = NULL;
+
+	FlightFrame* getCurrentFrame()
+	{
+		if (!pRecorder || pRecorder->mFrameCount == 0)
+			return NULL;
+		return &pRecorder->pFrames[(pRecorder->mFrameCount - 1) % pRecorder->mDesc.mFrameCount];
+	}
+
+	void updateMedian()
+	{
+		uint32_t ringSize = pRecorder->mDesc.mFrameCount;
+		uint32_t closedFrames = (uint32_t)std::min<uint64_t>(pRecorder->mFrameCount, ringSize);
+		uint32_t count = 0;
+		for (uint32_t i = 0; i < closedFrames; ++i)
+		{
+			if (pRecorder->pFrameMilliseconds[i] >= 0.0f)
+				pRecorder->pMedianScratch[count++] = pRecorder->pFrameMilliseconds[i];
+		}
+		if (count < MIN_FRAMES_FOR_MEDIAN)
+		{
+			pRecorder->mMedianMilliseconds = 0.0f;
+			return;
+		}
+		float* pMiddle = pRecorder->pMedianScratch + count / 2;
+		std::nth_element(pRecorder->pMedianScratch, pMiddle, pRecorder->pMedianScratch + count);
+		pRecorder->mMedianMilliseconds = *pMiddle;
+	}
+
+	struct DumpContext
+	{
+		double ticksPerMillisecond;
+		char   mSpikeName[128];
+	};
+
+	void writeDumpTracks(void* pUserData, ProfileTraceWriter* pWriter)
+	{
+		DumpContext* pContext = (DumpContext*)pUserData;
+		profilerTraceAddTrack(pWriter, TRACK_GPU, "GPU");
+		profilerTraceAddTrack(pWriter, TRACK_SPIKES, "Spikes");
+		profilerTraceAddScope(pWriter, TRACK_SPIKES, pContext->mSpikeName, pRecorder->mSpikeBeginTicks, pRecorder->mSpikeEndTicks);
+
+		uint32_t ringSize = pRecorder->mDesc.mFrameCount;
+		uint64_t firstFrame = pRecorder->mFrameCount > ringSize ? pRecorder->mFrameCount - ringSize : 0;
+		for (uint64_t frame = firstFrame; frame < pRecorder->mFrameCount; ++frame)
+		{
+			const FlightFrame* pFrame = &pRecorder->pFrames[frame % ringSize];
+
+			// GPU and CPU clocks are not correlated, each GPU frame is anchored at its submit
+			// so the scopes line up with the CPU frame that recorded them
+			for (uint32_t i = 0; i < pFrame->mGpuTimerCount && pFrame->mSubmitTicks; ++i)
+			{
+				const GpuTimerResult* pTimer = &pFrame->mGpuTimers[i];
+				uint64_t begin = pFrame->mSubmitTicks + (uint64_t)(pTimer->mStartMilliseconds * pContext->ticksPerMillisecond);
+				uint64_t end = begin + (uint64_t)(pTimer->mMilliseconds * pContext->ticksPerMillisecond);
+				profilerTraceAddScope(pWriter, TRACK_GPU, pTimer->mName, begin, end);
+			}
+
+			profilerTraceAddCounter(pWriter, "Frame ms", pFrame->mBeginTicks,
+				profilerTicksToMilliseconds(pFrame->mEndTicks - pFrame->mBeginTicks));
+			if (pFrame->mHasStats)
+			{
+				uint64_t ticks = pFrame->mPresentTicks ? pFrame->mPresentTicks : pFrame->mEndTicks;
+				profilerTraceAddCounter(pWriter, "Draw calls", ticks, (double)pFrame->mStats.mDrawCalls);
+				profilerTraceAddCounter(pWriter, "Dispatch calls", ticks, (double)pFrame->mStats.mDispatchCalls);
+				profilerTraceAddCounter(pWriter, "Vertices", ticks, (double)pFrame->mStats.mVertices);
+				profilerTraceAddCounter(pWriter, "Pipeline binds", ticks, (double)pFrame->mStats.mPipelineBinds);
+				profilerTraceAddCounter(pWriter, "Descriptor binds", ticks, (double)pFrame->mStats.mDescriptorBinds);
+				profilerTraceAddCounter(pWriter, "Barriers", ticks, (double)pFrame->mStats.mBarriers);
+				profilerTraceAddCounter(pWriter, "Render passes", ticks, (double)pFrame->mStats.mRenderPasses);
+				profilerTraceAddCounter(pWriter, "Queue submits", ticks, (double)pFrame->mStats.mQueueSubmits);
+				profilerTraceAddCounter(pWriter, "Bytes uploaded", ticks, (double)pFrame->mStats.mBytesUploaded);
+			}
+		}
+	}
+
+	void writeDump(uint64_t endTicks)
+	{
+		uint32_t ringSize = pRecorder->mDesc.mFrameCount;
+		uint64_t firstFrame = pRecorder->mFrameCount > ringSize ? pRecorder->mFrameCount - ringSize : 0;
+		uint64_t beginTicks = pRecorder->pFrames[firstFrame % ringSize].mBeginTicks;
+
+		DumpContext context;
+		context.ticksPerMillisecond = 1000000.0 / profilerTicksToMilliseconds(1000000);
+		snprintf(context.mSpikeName, sizeof(context.mSpikeName), "Spike %.2f ms (median %.2f ms)",
+			pRecorder->mSpikeMilliseconds, pRecorder->mSpikeMedianMilliseconds);
+
+		char fileName[128];
+		snprintf(fileName, sizeof(fileName), "%s_spike_%llu.json", pRecorder->mName, (unsigned long long)pRecorder->mSpikeFrameIndex);
+		SHEN_CORE_WARN("flight recorder: frame {0} took {1:.2f} ms (median {2:.2f} ms), writing {3}",
+			pRecorder->mSpikeFrameIndex, pRecorder->mSpikeMilliseconds, pRecorder->mSpikeMedianMilliseconds, fileName);
+		if (pRecorder->mSuppressedSpikes)
+		{
+			SHEN_CORE_WARN("flight recorder: {0} spikes since the last dump were not written because of the rate limit", pRecorder->mSuppressedSpikes);
+			pRecorder->mSuppressedSpikes = 0;
+		}
+
+		profilerWriteChromeTrace(fileName, beginTicks, endTicks, writeDumpTracks, &context);
+		pRecorder->mLastDumpTicks = profilerGetTicks();
+		++pRecorder->mDumpCount;
+		pRecorder->mDumpPending = false;
+	}
+
+	void checkForSpike(const FlightFrame* pFrame, float milliseconds)
+	{
+		float median = pRecorder->mMedianMilliseconds;
+		if (median <= 0.0f || pRecorder->mDumpPending)
+			return;
+		if (milliseconds <= median * pRecorder->mDesc.mSpikeMultiplier || milliseconds <= pRecorder->mDesc.mMinSpikeMilliseconds)
+			return;
+
+		bool limitReached = pRecorder->mDumpCount >= pRecorder->mDesc.mMaxDumps;
+		bool tooSoon = pRecorder->mDumpCount &&
+			profilerTicksToMilliseconds(pFrame->mEndTicks - pRecorder->mLastDumpTicks) < pRecorder->mDesc.mMinSecondsBetweenDumps * 1000.0;
+		if (limitReached || tooSoon)
+		{
+			++pRecorder->mSuppressedSpikes;
+			return;
+		}
+
+		pRecorder->mDumpPending = true;
+		pRecorder->mFramesUntilDump = pRecorder->mDesc.mFramesAfterSpike;
+		pRecorder->mSpikeFrameIndex = pFrame->mFrameIndex;
+		pRecorder->mSpikeMilliseconds = milliseconds;
+		pRecorder->mSpikeMedianMilliseconds = median;
+		pRecorder->mSpikeBeginTicks = pFrame->mBeginTicks;
+		pRecorder->mSpikeEndTicks = pFrame->mEndTicks;
+	}
+}
+
+void initFlightRecorder(const FlightRecorderDesc* pDesc)
+{
+	pRecorder = shen_new(MEMORY_CATEGORY_PROFILER, FlightRecorder);
+	memset(pRecorder, 0, sizeof(*pRecorder));
+
+	FlightRecorderDesc* pSettings = &pRecorder->mDesc;
+	*pSettings = *pDesc;
+	if (!pSettings->mFrameCount)
+		pSettings->mFrameCount = FLIGHT_RECORDER_DEFAULT_FRAME_COUNT;
+	// The window has to fit in the profiler's frame history to get frame markers
+	pSettings->mFrameCount = std::min<uint32_t>(std::max<uint32_t>(pSettings->mFrameCount, MIN_FRAMES_FOR_MEDIAN + 1), PROFILER_FRAME_HISTORY - 1);
+	if (pSettings->mSpikeMultiplier <= 0.0f)
+		pSettings->mSpikeMultiplier = 2.0f;
+	if (pSettings->mMinSpikeMilliseconds <= 0.0f)
+		pSettings->mMinSpikeMilliseconds = 10.0f;
+	if (!pSettings->mFramesAfterSpike)
+		pSettings->mFramesAfterSpike = 30;
+	pSettings->mFramesAfterSpike = std::min(pSettings->mFramesAfterSpike, pSettings->mFrameCount / 2);
+	if (pSettings->mMinSecondsBetweenDumps <= 0.0f)
+		pSettings->mMinSecondsBetweenDumps = 30.0f;
+	if (!pSettings->mMaxDumps)
+		pSettings->mMaxDumps = 10;
+	strncpy(pRecorder->mName, pDesc->pName ? pDesc->pName : "shen", sizeof(pRecorder->mName) - 1);
+	pSettings->pName = pRecorder->mName;
+
+	pRecorder->pFrames = (FlightFrame*)shen_calloc(MEMORY_CATEGORY_PROFILER, pSettings->mFrameCount, sizeof(FlightFrame));
+	pRecorder->pFrameMilliseconds = (float*)shen_calloc(MEMORY_CATEGORY_PROFILER, pSettings->mFrameCount, sizeof(float));
+	pRecorder->pMedianScratch = (float*)shen_calloc(MEMORY_CATEGORY_PROFILER, pSettings->mFrameCount, sizeof(float));
+
+	SHEN_CORE_INFO("flight recorder: keeping {0} frames, spike threshold {1:.1f}x median", pSettings->mFrameCount, pSettings->mSpikeMultiplier);
+}
+
+void exitFlightRecorder()
+{
+	if (!pRecorder)
+		return;
+
+	shen_free(pRecorder->pFrames);
+	shen_free(pRecorder->pFrameMilliseconds);
+	shen_free(pRecorder->pMedianScratch);
+	shen_delete(pRecorder);
+	pRecorder = NULL;
+}
+
+void flightRecorderBeginFrame()
+{
+	if (!pRecorder)
+		return;
+
+	uint64_t now = profilerGetTicks();
+	uint32_t ringSize = pRecorder->mDesc.mFrameCount;
+
+	FlightFrame* pPrevious = getCurrentFrame();
+	if (pPrevious)
+	{
+		pPrevious->mEndTicks = now;
+		float milliseconds = (float)profilerTicksToMilliseconds(now - pPrevious->mBeginTicks);
+		pRecorder->pFrameMilliseconds[(pRecorder->mFrameCount - 1) % ringSize] = pRecorder->mSkipCurrentFrame ? -1.0f : milliseconds;
+
+		if (++pRecorder->mFramesSinceMedian >= MEDIAN_UPDATE_INTERVAL)
+		{
+			updateMedian();
+			pRecorder->mFramesSinceMedian = 0;
+		}
+		if (!pRecorder->mSkipCurrentFrame)
+			checkForSpike(pPrevious, milliseconds);
+	}
+
+	// Writing the dump happens inside the frame that is about to start, so that frame is skipped
+	bool dumpNow = pRecorder->mDumpPending && pRecorder->mFramesUntilDump-- == 0;
+	if (dumpNow)
+		writeDump(now);
+
+	FlightFrame* pFrame = &pRecorder->pFrames[pRecorder->mFrameCount % ringSize];
+	memset(pFrame, 0, offsetof(FlightFrame, mGpuTimers));
+	pFrame->mFrameIndex = pRecorder->mFrameCount;
+	pFrame->mBeginTicks = now;
+	++pRecorder->mFrameCount;
+	pRecorder->mSkipCurrentFrame = dumpNow;
+}
+
+void flightRecorderOnSubmit(Queue* pQueue)
+{
+	FlightFrame* pFrame = getCurrentFrame();
+	if (!pFrame || pFrame->pGpuQueue)
+		return;
+
+	uint64_t gpuFrameIndex;
+	if (!getGpuProfileFrameIndex(pQueue, &gpuFrameIndex))
+		return;
+	pFrame->pGpuQueue = pQueue;
+	pFrame->mGpuFrameIndex = gpuFrameIndex;
+	pFrame->mSubmitTicks = profilerGetTicks();
+}
+
+void flightRecorderOnPresent(Queue* pQueue)
+{
+	FlightFrame* pFrame = getCurrentFrame();
+	if (!pFrame)
+		return;
+
+	pFrame->mPresentTicks = profilerGetTicks();
+	getRendererStats(pQueue->pRenderer, &pFrame->mStats);
+	pFrame->mHasStats = true;
+
+	// GPU results trail the CPU by a few frames, attach them to the frame that submitted the work
+	GpuProfileResults results;
+	if (!getGpuProfileResults(pQueue, &results) || !results.mTimerCount)
+		return;
+	if (pRecorder->mHasGpuResult && results.mFrameIndex <= pRecorder->mLastGpuResultFrame)
+		return;
+	pRecorder->mHasGpuResult = true;
+	pRecorder->mLastGpuResultFrame = results.mFrameIndex;
+
+	uint32_t ringSize = pRecorder->mDesc.mFrameCount;
+	uint64_t searchCount = std::min<uint64_t>(pRecorder->mFrameCount, ringSize);
+	for (uint64_t i = 0; i < searchCount; ++i)
+	{
+		FlightFrame* pTarget = &pRecorder->pFrames[(pRecorder->mFrameCount - 1 - i) % ringSize];
+		if (pTarget->pGpuQueue != pQueue || pTarget->mGpuFrameIndex != results.mFrameIndex)
+			continue;
+		pTarget->mGpuTimerCount = std::min<uint32_t>(results.mTimerCount, FLIGHT_RECORDER_MAX_GPU_TIMERS);
+		memcpy(pTarget->mGpuTimers, results.pTimers, pTarget->mGpuTimerCount * sizeof(GpuTimerResult));
+		break;
+	}
+}
+
+uint32_t flightRecorderGetDumpCount()
+{
+	return pRecorder ? pRecorder->mDumpCount : 0;
+}
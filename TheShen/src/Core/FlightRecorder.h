@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+
+struct Queue;
+
+// Always-on recorder for intermittent frame spikes. It keeps the duration, GPU timings and renderer
+// counters of the last mFrameCount frames in a fixed ring, CPU scopes stay in the profiler's own rings.
+// When a frame is much slower than the running median it records mFramesAfterSpike more frames, then
+// writes the whole window as a Chrome trace next to the executable. Dumps are rate limited, and the
+// frame that writes a dump is left out of spike detection so a dump never triggers the next one.
+// All functions must be called from the thread that runs the frame loop.
+
+#define FLIGHT_RECORDER_DEFAULT_FRAME_COUNT 300
+// GPU scopes kept per frame, deeper or later scopes are dropped
+#define FLIGHT_RECORDER_MAX_GPU_TIMERS 32
+
+// Zero fields take the defaults listed next to them
+typedef struct FlightRecorderDesc
+{
+	// Dump files are named "<pName>_spike_<frame>.json", defaults to "shen"
+	const char* pName;
+	// Frames kept in the ring, FLIGHT_RECORDER_DEFAULT_FRAME_COUNT
+	uint32_t    mFrameCount;
+	// A frame is a spike when it is slower than both mSpikeMultiplier * median (2.0)
+	// and mMinSpikeMilliseconds (10 ms), the floor keeps 1 ms -> 2 ms jitter at high frame rates quiet
+	float       mSpikeMultiplier;
+	float       mMinSpikeMilliseconds;
+	// Frames recorded after a spike before the dump is written, also lets late GPU results arrive (30)
+	uint32_t    mFramesAfterSpike;
+	// Spikes closer than this to the previous dump are only counted (30 s)
+	float       mMinSecondsBetweenDumps;
+	// Dumps written per run at most (10)
+	uint32_t    mMaxDumps;
+} FlightRecorderDesc;
+
+void initFlightRecorder(const FlightRecorderDesc* pDesc);
+void exitFlightRecorder();
+
+// Frame boundary, called by Application::Run right after SHEN_PROFILE_FRAME.
+// Closes the previous frame, checks it for a spike and writes a pending dump when it is due.
+void flightRecorderBeginFrame();
+
+// Called by queueSubmit and queuePresent, no-ops while the recorder is not initialized
+void flightRecorderOnSubmit(Queue* pQueue);
+void flightRecorderOnPresent(Queue* pQueue);
+
+uint32_t flightRecorderGetDumpCount();
@@ -0,0 +1,150 @@
+#include "JobSystem.h"
+
+#include "Core/Log.h"
+#include "Core/Memory.h"
+#include "Core/Profiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	// One parallelFor call, lives on the caller's stack. Workers only touch it while mUsers counts them,
+	// the caller does not return before it has taken the batch out of the queue and mUsers dropped to 0.
+	struct JobBatch
+	{
+		JobFunction           pFunction;
+		void*                 pUserData;
+		uint32_t              mCount;
+		std::atomic<uint32_t> mNext;
+		uint32_t              mUsers;
+	};
+
+	struct JobSystem
+	{
+		std::mutex               mMutex;
+		std::condition_variable  mWorkAvailable;
+		std::condition_variable  mBatchReleased;
+		std::deque<JobBatch*>    mBatches;
+		std::vector<std::thread> mThreads;
+		bool                     mQuit = false;
+	};
+
+	JobSystem* pJobSystem = NULL;
+}
+
+// Returns false once every item of the batch has been claimed
+static bool runJob(JobBatch* pBatch)
+{
+	uint32_t index = pBatch->mNext.fetch_add(1, std::memory_order_relaxed);
+	if (index >= pBatch->mCount)
+		return false;
+	pBatch->pFunction(pBatch->pUserData, index);
+	return true;
+}
+
+static void workerMain(uint32_t workerIndex)
+{
+	std::string threadName = "Job Worker " + std::to_string(workerIndex);
+	SHEN_PROFILE_THREAD(threadName.c_str());
+
+	std::unique_lock<std::mutex> lock(pJobSystem->mMutex);
+	for (;;)
+	{
+		pJobSystem->mWorkAvailable.wait(lock, [] { return pJobSystem->mQuit || !pJobSystem->mBatches.empty(); });
+		if (pJobSystem->mBatches.empty())
+			break;
+
+		JobBatch* pBatch = pJobSystem->mBatches.front();
+		++pBatch->mUsers;
+		lock.unlock();
+		while (runJob(pBatch))
+		{
+		}
+		lock.lock();
+
+		// Fully claimed batches leave the queue so idle workers move on to the next one
+		if (!pJobSystem->mBatches.empty() && pJobSystem->mBatches.front() == pBatch)
+			pJobSystem->mBatches.pop_front();
+		if (--pBatch->mUsers == 0)
+			pJobSystem->mBatchReleased.notify_all();
+	}
+}
+
+void initJobSystem(uint32_t threadCount)
+{
+	if (pJobSystem)
+		return;
+	if (!threadCount)
+		threadCount = std::max(1u, std::thread::hardware_concurrency()) - 1;
+
+	// Every parallelFor caller so far is an asset import or cook step
+	pJobSystem = shen_new(MEMORY_CATEGORY_ASSETS, JobSystem);
+	for (uint32_t i = 0; i < threadCount; ++i)
+		pJobSystem->mThreads.emplace_back(workerMain, i);
+	SHEN_CORE_INFO("job system started {0} worker threads", threadCount);
+}
+
+void exitJobSystem()
+{
+	if (!pJobSystem)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(pJobSystem->mMutex);
+		pJobSystem->mQuit = true;
+	}
+	pJobSystem->mWorkAvailable.notify_all();
+	for (std::thread& thread : pJobSystem->mThreads)
+		thread.join();
+	shen_delete(pJobSystem);
+	pJobSystem = NULL;
+}
+
+uint32_t getJobThreadCount()
+{
+	return pJobSystem ? (uint32_t)pJobSystem->mThreads.size() + 1 : 1;
+}
+
+void parallelFor(uint32_t count, JobFunction pFunction, void* pUserData)
+{
+	if (!count)
+		return;
+
+	JobBatch batch;
+	batch.pFunction = pFunction;
+	batch.pUserData = pUserData;
+	batch.mCount = count;
+	batch.mNext.store(0, std::memory_order_relaxed);
+	batch.mUsers = 0;
+
+	if (!pJobSystem || pJobSystem->mThreads.empty() || count == 1)
+	{
+		while (runJob(&batch))
+		{
+		}
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(pJobSystem->mMutex);
+		pJobSystem->mBatches.push_back(&batch);
+	}
+	pJobSystem->mWorkAvailable.notify_all();
+	while (runJob(&batch))
+	{
+	}
+
+	std::unique_lock<std::mutex> lock(pJobSystem->mMutex);
+	auto it = std::find(pJobSystem->mBatches.begin(), pJobSystem->mBatches.end(), &batch);
+	if (it != pJobSystem->mBatches.end())
+		pJobSystem->mBatches.erase(it);
+	// Workers still running an item hold a use, every item has finished once the last of them let go
+	pJobSystem->mBatchReleased.wait(lock, [&batch] { return batch.mUsers == 0; });
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+// Fixed pool of worker threads for data-parallel work (asset import, cooking). Work is submitted as a
+// parallelFor: the calling thread runs items as well and returns once every item finished, so calls may
+// nest and no job handles outlive the call. Before initJobSystem (or after exitJobSystem) parallelFor runs
+// every item on the calling thread, so tools that never start the pool still work.
+
+typedef void (*JobFunction)(void* pUserData, uint32_t index);
+
+// threadCount is the number of workers besides the calling thread, 0 picks hardware threads - 1.
+// Workers name themselves in the profiler, so exitJobSystem has to run before exitProfiler.
+void initJobSystem(uint32_t threadCount);
+void exitJobSystem();
+
+// Threads that take part in a parallelFor: the workers plus the caller
+uint32_t getJobThreadCount();
+
+// Runs pFunction(pUserData, i) for every i in [0, count) across the pool and waits for all of them.
+// Items are claimed one at a time, so each should be large enough (tens of microseconds) to hide that.
+void parallelFor(uint32_t count, JobFunction pFunction, void* pUserData);
@@ -39,4 +39,14 @@ void LayerStack::PopOverlay(Layer* overlay)
 		overlay->OnDetach();
 		m_Layers.erase(it);
 	}
+}
+
+void LayerStack::OnEvent(Event& e)
+{
+	for (auto it = m_Layers.rbegin(); it != m_Layers.rend(); ++it)
+	{
+		if (e.Handled)
+			break;
+		(*it)->OnEvent(e);
+	}
 }
\ No newline at end of file
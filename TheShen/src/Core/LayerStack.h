@@ -2,10 +2,14 @@
 
 #include "Base.h"
 #include "Layer.h"
+#include "Memory.h"
 
 class LayerStack
 {
 public:
+	// The layer list is walked for every dispatched event, so it is charged to the events category
+	typedef std::vector<Layer*, CategoryAllocator<Layer*, MEMORY_CATEGORY_EVENTS>> LayerList;
+
 	LayerStack() = default;
 	~LayerStack();
 
@@ -14,17 +18,20 @@ public:
 	void PopLayer(Layer* layer);
 	void PopOverlay(Layer* overlay);
 
-	std::vector<Layer*>::iterator begin() { return m_Layers.begin(); }
-	std::vector<Layer*>::iterator end() { return m_Layers.end(); }
-	std::vector<Layer*>::reverse_iterator rbegin() { return m_Layers.rbegin(); }
-	std::vector<Layer*>::reverse_iterator rend() { return m_Layers.rend(); }
+	// Offers the event to the layers from the top (last overlay) down until one marks it handled
+	void OnEvent(Event& e);
+
+	LayerList::iterator begin() { return m_Layers.begin(); }
+	LayerList::iterator end() { return m_Layers.end(); }
+	LayerList::reverse_iterator rbegin() { return m_Layers.rbegin(); }
+	LayerList::reverse_iterator rend() { return m_Layers.rend(); }
 
-	std::vector<Layer*>::const_iterator begin() const { return m_Layers.begin(); }
-	std::vector<Layer*>::const_iterator end()	const { return m_Layers.end(); }
-	std::vector<Layer*>::const_reverse_iterator rbegin() const { return m_Layers.rbegin(); }
-	std::vector<Layer*>::const_reverse_iterator rend() const { return m_Layers.rend(); }
+	LayerList::const_iterator begin() const { return m_Layers.begin(); }
+	LayerList::const_iterator end()	const { return m_Layers.end(); }
+	LayerList::const_reverse_iterator rbegin() const { return m_Layers.rbegin(); }
+	LayerList::const_reverse_iterator rend() const { return m_Layers.rend(); }
 
 private:
-	std::vector<Layer*> m_Layers;
+	LayerList m_Layers;
 	unsigned int m_LayerInsertIndex = 0;
 };
\ No newline at end of file
@@ -1,15 +1,56 @@
 #include "Log.h"
+#include "spdlog/async.h"
+#include "spdlog/sinks/rotating_file_sink.h"
 #include "spdlog/sinks/stdout_color_sinks.h"
 
+// Messages the logging thread may lag behind by, shared by both loggers
+static const size_t LOG_QUEUE_SIZE = 8192;
+static const char* LOG_FILE_NAME = "logs/TheShen.log";
+static const size_t LOG_FILE_MAX_SIZE = 8 * 1024 * 1024;
+static const size_t LOG_FILE_MAX_FILES = 3;
+
 std::shared_ptr<spdlog::logger> Log::s_CoreLogger;
 std::shared_ptr<spdlog::logger> Log::s_ClientLogger;
 
+static std::shared_ptr<spdlog::logger> createAsyncLogger(const char* pName, const std::vector<spdlog::sink_ptr>& sinks)
+{
+	std::shared_ptr<spdlog::logger> logger = std::make_shared<spdlog::async_logger>(pName, sinks.begin(), sinks.end(),
+		spdlog::thread_pool(), spdlog::async_overflow_policy::overrun_oldest);
+	logger->set_level((spdlog::level::level_enum)SHEN_LOG_ACTIVE_LEVEL);
+	logger->flush_on(spdlog::level::warn);
+	spdlog::register_logger(logger);
+	return logger;
+}
+
 void Log::Init()
 {
-	spdlog::set_pattern("%^[%T] %n: %v%$");
-	s_CoreLogger = spdlog::stdout_color_mt("SHEN_SDK");
-	s_CoreLogger->set_level(spdlog::level::trace);
+	spdlog::init_thread_pool(LOG_QUEUE_SIZE, 1);
+
+	std::vector<spdlog::sink_ptr> sinks;
+	sinks.push_back(std::make_shared<spdlog::sinks::stdout_color_sink_mt>());
+	sinks.back()->set_pattern("%^[%T] %n: %v%$");
 
-	s_ClientLogger = spdlog::stdout_color_mt("APP");
-	s_ClientLogger->set_level(spdlog::level::trace);
-}
\ No newline at end of file
+	// The file keeps what the console drops: date, milliseconds, thread and level on every line
+	spdlog::sink_ptr fileSink;
+	try
+	{
+		fileSink = std::make_shared<spdlog::sinks::rotating_file_sink_mt>(LOG_FILE_NAME, LOG_FILE_MAX_SIZE, LOG_FILE_MAX_FILES);
+		fileSink->set_pattern("[%Y-%m-%d %T.%e] [%t] [%l] %n: %v");
+		sinks.push_back(fileSink);
+	}
+	catch (const spdlog::spdlog_ex&)
+	{
+		// A read-only working directory should not stop the engine, keep logging to the console
+	}
+
+	s_CoreLogger = createAsyncLogger("SHEN_SDK", sinks);
+	s_ClientLogger = createAsyncLogger("APP", sinks);
+
+	if (!fileSink)
+		SHEN_CORE_WARN("failed to open {0}, logging to the console only", LOG_FILE_NAME);
+}
+
+void Log::Shutdown()
+{
+	spdlog::shutdown();
+}
@@ -3,10 +3,34 @@
 #include "spdlog/spdlog.h"
 #include "spdlog/fmt/ostr.h"
 
+// Compile-time log level. Macros below SHEN_LOG_ACTIVE_LEVEL expand to nothing, so their arguments are
+// never formatted or even evaluated. Values match spdlog::level so the runtime level can start from it.
+// Override with premake's --log-level option; Distribution builds keep warnings and above by default.
+// Tools and benchmarks print their results with fmt::print so those still show up in Distribution builds.
+#define SHEN_LOG_LEVEL_TRACE    SPDLOG_LEVEL_TRACE
+#define SHEN_LOG_LEVEL_INFO     SPDLOG_LEVEL_INFO
+#define SHEN_LOG_LEVEL_WARN     SPDLOG_LEVEL_WARN
+#define SHEN_LOG_LEVEL_ERROR    SPDLOG_LEVEL_ERROR
+#define SHEN_LOG_LEVEL_CRITICAL SPDLOG_LEVEL_CRITICAL
+#define SHEN_LOG_LEVEL_OFF      SPDLOG_LEVEL_OFF
+
+#ifndef SHEN_LOG_ACTIVE_LEVEL
+#ifdef SHEN_DIST
+#define SHEN_LOG_ACTIVE_LEVEL SHEN_LOG_LEVEL_WARN
+#else
+#define SHEN_LOG_ACTIVE_LEVEL SHEN_LOG_LEVEL_TRACE
+#endif
+#endif
+
+// Both loggers are asynchronous: a call formats the message and pushes it onto a bounded queue, and a
+// dedicated thread writes it to the console and a rotating file. When the queue is full the oldest
+// message is dropped instead of stalling the caller. Warnings and above flush the file immediately.
 class Log
 {
 public:
 	static void Init();
+	// Drains the queue and joins the logging thread. Nothing may log after this.
+	static void Shutdown();
 
 	inline static std::shared_ptr<spdlog::logger>& GetCoreLogger() { return s_CoreLogger; }
 
@@ -20,15 +44,42 @@ private:
 };
 
 // Core log macros
+#if SHEN_LOG_ACTIVE_LEVEL <= SHEN_LOG_LEVEL_TRACE
 #define SHEN_CORE_TRACE(...)    ::Log::GetCoreLogger()->trace(__VA_ARGS__)
+#define SHEN_CLIENT_TRACE(...)  ::Log::GetClientLogger()->trace(__VA_ARGS__)
+#else
+#define SHEN_CORE_TRACE(...)    (void)0
+#define SHEN_CLIENT_TRACE(...)  (void)0
+#endif
+
+#if SHEN_LOG_ACTIVE_LEVEL <= SHEN_LOG_LEVEL_INFO
 #define SHEN_CORE_INFO(...)     ::Log::GetCoreLogger()->info(__VA_ARGS__)
+#define SHEN_CLIENT_INFO(...)   ::Log::GetClientLogger()->info(__VA_ARGS__)
+#else
+#define SHEN_CORE_INFO(...)     (void)0
+#define SHEN_CLIENT_INFO(...)   (void)0
+#endif
+
+#if SHEN_LOG_ACTIVE_LEVEL <= SHEN_LOG_LEVEL_WARN
 #define SHEN_CORE_WARN(...)     ::Log::GetCoreLogger()->warn(__VA_ARGS__)
+#define SHEN_CLIENT_WARN(...)   ::Log::GetClientLogger()->warn(__VA_ARGS__)
+#else
+#define SHEN_CORE_WARN(...)     (void)0
+#define SHEN_CLIENT_WARN(...)   (void)0
+#endif
+
+#if SHEN_LOG_ACTIVE_LEVEL <= SHEN_LOG_LEVEL_ERROR
 #define SHEN_CORE_ERROR(...)    ::Log::GetCoreLogger()->error(__VA_ARGS__)
-#define SHEN_CORE_CRITICAL(...) ::Log::GetCoreLogger()->critical(__VA_ARGS__)
-// Clien log macros
-#define SHEN_CLIENT_TRACE(...)			::Log::GetClientLogger()->trace(__VA_ARGS__)
-#define SHEN_CLIENT_INFO(...)			::Log::GetClientLogger()->info(__VA_ARGS__)
-#define SHEN_CLIENT_WARN(...)			::Log::GetClientLogger()->warn(__VA_ARGS__)
-#define SHEN_CLIENT_ERROR(...)			::Log::GetClientLogger()->error(__VA_ARGS__)
-#define SHEN_CLIENT_CRITICAL(...)		::Log::GetClientLogger()->critical(__VA_ARGS__)
+#define SHEN_CLIENT_ERROR(...)  ::Log::GetClientLogger()->error(__VA_ARGS__)
+#else
+#define SHEN_CORE_ERROR(...)    (void)0
+#define SHEN_CLIENT_ERROR(...)  (void)0
+#endif
 
+#if SHEN_LOG_ACTIVE_LEVEL <= SHEN_LOG_LEVEL_CRITICAL
+#define SHEN_CORE_CRITICAL(...)   ::Log::GetCoreLogger()->critical(__VA_ARGS__)
+#define SHEN_CLIENT_CRITICAL(...) ::Log::GetClientLogger()->critical(__VA_ARGS__)
+#else
+#define SHEN_CORE_CRITICAL(...)   (void)0
+#define SHEN_CLIENT_CRITICAL(...) (void)0
+#endif
@@ -0,0 +1,187 @@
+#include "Lz4.h"
+
+#include <cstring>
+
+namespace
+{
+	const uint32_t MIN_MATCH = 4;
+	// The format requires the last 5 bytes to be literals and the last match to start 12 bytes before the end
+	const size_t LAST_LITERALS = 5;
+	const size_t MATCH_FIND_LIMIT = 12;
+	const size_t MAX_OFFSET = 65535;
+	const uint32_t HASH_BITS = 12;
+	// Scanning speeds up by one byte every 64 bytes without a match, so incompressible data is skipped quickly
+	const uint32_t SKIP_SHIFT = 6;
+}
+
+static uint32_t read32(const uint8_t* p)
+{
+	uint32_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static uint32_t hashSequence(uint32_t sequence)
+{
+	return (sequence * 2654435761u) >> (32 - HASH_BITS);
+}
+
+// Lengths of 15 and above continue in bytes of 255 until a byte below 255
+static uint8_t* writeLength(uint8_t* pOut, size_t length)
+{
+	for (; length >= 255; length -= 255)
+		*pOut++ = 255;
+	*pOut++ = (uint8_t)length;
+	return pOut;
+}
+
+size_t lz4CompressBound(size_t srcSize)
+{
+	return srcSize + srcSize / 255 + 16;
+}
+
+// Worst case of one sequence: token, literal length bytes, literals, offset, match length bytes
+static size_t getSequenceBound(size_t literalLength, size_t matchLength)
+{
+	return 1 + literalLength / 255 + 1 + literalLength + 2 + matchLength / 255 + 1;
+}
+
+size_t lz4CompressBlock(const uint8_t* pSrc, size_t srcSize, uint8_t* pDst, size_t dstCapacity)
+{
+	uint32_t table[1u << HASH_BITS];
+	memset(table, 0, sizeof(table));
+
+	uint8_t* pOut = pDst;
+	const uint8_t* pDstEnd = pDst + dstCapacity;
+	size_t anchor = 0;
+	if (srcSize > MATCH_FIND_LIMIT)
+	{
+		const size_t matchFindEnd = srcSize - MATCH_FIND_LIMIT;
+		const size_t matchEnd = srcSize - LAST_LITERALS;
+		size_t position = 0;
+		while (position < matchFindEnd)
+		{
+			uint32_t sequence = read32(pSrc + position);
+			uint32_t hash = hashSequence(sequence);
+			size_t candidate = table[hash];
+			table[hash] = (uint32_t)position;
+			// Slot 0 doubles as "empty", the byte comparison rejects it when it does not match
+			if (candidate >= position || position - candidate > MAX_OFFSET || read32(pSrc + candidate) != sequence)
+			{
+				position += 1 + ((position - anchor) >> SKIP_SHIFT);
+				continue;
+			}
+
+			// Extend backwards over literals that match as well, then forwards up to the last literals
+			while (position > anchor && candidate > 0 && pSrc[position - 1] == pSrc[candidate - 1])
+			{
+				--position;
+				--candidate;
+			}
+			size_t matchLength = MIN_MATCH;
+			while (position + matchLength < matchEnd && pSrc[candidate + matchLength] == pSrc[position + matchLength])
+				++matchLength;
+
+			size_t literalLength = position - anchor;
+			if ((size_t)(pDstEnd - pOut) < getSequenceBound(literalLength, matchLength))
+				return 0;
+			uint8_t* pToken = pOut++;
+			*pToken = (uint8_t)((literalLength < 15 ? literalLength : 15) << 4);
+			if (literalLength >= 15)
+				pOut = writeLength(pOut, literalLength - 15);
+			memcpy(pOut, pSrc + anchor, literalLength);
+			pOut += literalLength;
+			size_t offset = position - candidate;
+			*pOut++ = (uint8_t)offset;
+			*pOut++ = (uint8_t)(offset >> 8);
+			size_t extraLength = matchLength - MIN_MATCH;
+			*pToken |= (uint8_t)(extraLength < 15 ? extraLength : 15);
+			if (extraLength >= 15)
+				pOut = writeLength(pOut, extraLength - 15);
+
+			position += matchLength;
+			anchor = position;
+			// Index the position just before the next scan start, so back-to-back repeats are found
+			if (position - 2 < matchFindEnd)
+				table[hashSequence(read32(pSrc + position - 2))] = (uint32_t)(position - 2);
+		}
+	}
+
+	// The block always ends with a literal-only sequence, empty when the last match ran up to matchEnd
+	size_t literalLength = srcSize - anchor;
+	if ((size_t)(pDstEnd - pOut) < 1 + literalLength / 255 + 1 + literalLength)
+		return 0;
+	*pOut++ = (uint8_t)((literalLength < 15 ? literalLength : 15) << 4);
+	if (literalLength >= 15)
+		pOut = writeLength(pOut, literalLength - 15);
+	memcpy(pOut, pSrc + anchor, literalLength);
+	pOut += literalLength;
+	return (size_t)(pOut - pDst);
+}
+
+// Adds the 255-continued extension of a length field, false when it runs past the input
+static bool readLength(const uint8_t** ppIn, const uint8_t* pInEnd, size_t* pLength)
+{
+	const uint8_t* pIn = *ppIn;
+	uint8_t byte;
+	do
+	{
+		if (pIn == pInEnd)
+			return false;
+		byte = *pIn++;
+		*pLength += byte;
+	} while (byte == 255);
+	*ppIn = pIn;
+	return true;
+}
+
+bool lz4DecompressBlock(const uint8_t* pSrc, size_t srcSize, uint8_t* pDst, size_t dstSize)
+{
+	const uint8_t* pIn = pSrc;
+	const uint8_t* pInEnd = pSrc + srcSize;
+	uint8_t* pOut = pDst;
+	uint8_t* pOutEnd = pDst + dstSize;
+	for (;;)
+	{
+		if (pIn == pInEnd)
+			return false;
+		uint8_t token = *pIn++;
+		size_t literalLength = token >> 4;
+		if (literalLength == 15 && !readLength(&pIn, pInEnd, &literalLength))
+			return false;
+		if (literalLength > (size_t)(pInEnd - pIn) || literalLength > (size_t)(pOutEnd - pOut))
+			return false;
+		memcpy(pOut, pIn, literalLength);
+		pIn += literalLength;
+		pOut += literalLength;
+		// Only the last sequence has no match
+		if (pIn == pInEnd)
+			return pOut == pOutEnd;
+
+		if (pInEnd - pIn < 2)
+			return false;
+		size_t offset = pIn[0] | ((size_t)pIn[1] << 8);
+		pIn += 2;
+		if (offset == 0 || offset > (size_t)(pOut - pDst))
+			return false;
+		size_t matchLength = token & 15;
+		if (matchLength == 15 && !readLength(&pIn, pInEnd, &matchLength))
+			return false;
+		matchLength += MIN_MATCH;
+		if (matchLength > (size_t)(pOutEnd - pOut))
+			return false;
+
+		const uint8_t* pMatch = pOut - offset;
+		if (offset >= matchLength)
+		{
+			memcpy(pOut, pMatch, matchLength);
+			pOut += matchLength;
+		}
+		else
+		{
+			// Overlapping copy repeats the last offset bytes, which is how runs are encoded
+			for (size_t i = 0; i < matchLength; ++i)
+				*pOut++ = pMatch[i];
+		}
+	}
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// LZ4 block format (no frame header, no checksum), compatible with LZ4_compress_default /
+// LZ4_decompress_safe. The compressor is a single-probe greedy matcher: a few hundred MB/s, ratios a
+// little below the reference fast mode. The decompressor checks every length and offset against both
+// buffers, so corrupt input fails instead of reading or writing out of bounds.
+
+// Worst-case compressed size of srcSize bytes (incompressible input grows by about 0.4%)
+size_t lz4CompressBound(size_t srcSize);
+
+// Returns the compressed size, or 0 when the result would not fit into dstCapacity. Callers that keep
+// incompressible data raw pass dstCapacity = srcSize - 1 and store the block uncompressed on 0.
+size_t lz4CompressBlock(const uint8_t* pSrc, size_t srcSize, uint8_t* pDst, size_t dstCapacity);
+
+// Decompresses a whole block, which has to produce exactly dstSize bytes. Returns false on corrupt input.
+bool lz4DecompressBlock(const uint8_t* pSrc, size_t srcSize, uint8_t* pDst, size_t dstSize);
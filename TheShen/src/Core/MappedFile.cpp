@@ -0,0 +1,121 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Core/Log.h"
+
+#include <cerrno>
+#include <cstring>
+
+#ifdef _WIN32
+
+bool openMappedFile(const char* pFileName, bool sequential, MappedFile* pOutFile)
+{
+	memset(pOutFile, 0, sizeof(*pOutFile));
+	HANDLE file = CreateFileA(pFileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | (sequential ? FILE_FLAG_SEQUENTIAL_SCAN : 0), NULL);
+	if (file == INVALID_HANDLE_VALUE)
+	{
+		SHEN_CORE_ERROR("failed to open {0} (error {1})", pFileName, GetLastError());
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(file, &size))
+	{
+		SHEN_CORE_ERROR("failed to query the size of {0} (error {1})", pFileName, GetLastError());
+		CloseHandle(file);
+		return false;
+	}
+	pOutFile->pFileHandle = file;
+	pOutFile->mSize = (size_t)size.QuadPart;
+	if (!pOutFile->mSize)
+		return true;
+
+	HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+	const void* pView = mapping ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : NULL;
+	if (!pView)
+	{
+		SHEN_CORE_ERROR("failed to map {0} (error {1})", pFileName, GetLastError());
+		if (mapping)
+			CloseHandle(mapping);
+		CloseHandle(file);
+		memset(pOutFile, 0, sizeof(*pOutFile));
+		return false;
+	}
+	pOutFile->pMappingHandle = mapping;
+	pOutFile->pData = (const uint8_t*)pView;
+	return true;
+}
+
+void closeMappedFile(MappedFile* pFile)
+{
+	if (pFile->pData)
+		UnmapViewOfFile(pFile->pData);
+	if (pFile->pMappingHandle)
+		CloseHandle(pFile->pMappingHandle);
+	if (pFile->pFileHandle)
+		CloseHandle(pFile->pFileHandle);
+	memset(pFile, 0, sizeof(*pFile));
+}
+
+#else
+
+bool openMappedFile(const char* pFileName, bool sequential, MappedFile* pOutFile)
+{
+	memset(pOutFile, 0, sizeof(*pOutFile));
+	pOutFile->mFileDescriptor = open(pFileName, O_RDONLY);
+	if (pOutFile->mFileDescriptor < 0)
+	{
+		SHEN_CORE_ERROR("failed to open {0}: {1}", pFileName, strerror(errno));
+		pOutFile->mFileDescriptor = -1;
+		return false;
+	}
+
+	struct stat info;
+	if (fstat(pOutFile->mFileDescriptor, &info) != 0)
+	{
+		SHEN_CORE_ERROR("failed to query the size of {0}: {1}", pFileName, strerror(errno));
+		close(pOutFile->mFileDescriptor);
+		pOutFile->mFileDescriptor = -1;
+		return false;
+	}
+	pOutFile->mSize = (size_t)info.st_size;
+	if (!pOutFile->mSize)
+		return true;
+
+	void* pView = mmap(NULL, pOutFile->mSize, PROT_READ, MAP_PRIVATE, pOutFile->mFileDescriptor, 0);
+	if (pView == MAP_FAILED)
+	{
+		SHEN_CORE_ERROR("failed to map {0}: {1}", pFileName, strerror(errno));
+		close(pOutFile->mFileDescriptor);
+		pOutFile->mFileDescriptor = -1;
+		return false;
+	}
+	if (sequential)
+	{
+		madvise(pView, pOutFile->mSize, MADV_SEQUENTIAL);
+		madvise(pView, pOutFile->mSize, MADV_WILLNEED);
+	}
+	pOutFile->pData = (const uint8_t*)pView;
+	return true;
+}
+
+void closeMappedFile(MappedFile* pFile)
+{
+	if (pFile->pData)
+		munmap((void*)pFile->pData, pFile->mSize);
+	if (pFile->mFileDescriptor >= 0)
+		close(pFile->mFileDescriptor);
+	memset(pFile, 0, sizeof(*pFile));
+	pFile->mFileDescriptor = -1;
+}
+
+#endif
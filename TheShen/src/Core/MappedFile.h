@@ -0,0 +1,23 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// Read-only memory mapping of a whole file. Pages are faulted in by the OS as they are touched,
+// so loaders can copy straight out of pData without an intermediate read buffer.
+typedef struct MappedFile
+{
+	const uint8_t* pData;
+	size_t         mSize;
+#ifdef _WIN32
+	void*          pFileHandle;
+	void*          pMappingHandle;
+#else
+	int            mFileDescriptor;
+#endif
+} MappedFile;
+
+// Returns false (and logs) when the file cannot be opened or mapped. Empty files map to pData == NULL.
+// sequential hints the OS to read ahead aggressively and drop pages behind the reader.
+bool openMappedFile(const char* pFileName, bool sequential, MappedFile* pOutFile);
+void closeMappedFile(MappedFile* pFile);
@@ -0,0 +1,244 @@
+#include "Memory.h"
+#include "Core/Log.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef SHEN_USE_MMGR
+#include "../../Vendor/FluidStudios/MemoryManager/mmgr.h"
+bool initMemAlloc(const char* appName);
+void exitMemAlloc(void);
+#endif
+
+namespace
+{
+	// Placed immediately in front of every pointer handed out by the tracker.
+	struct AllocationHeader
+	{
+		uint64_t mSize;
+		uint32_t mCategory;
+		uint32_t mOffset;
+	};
+	static_assert(sizeof(AllocationHeader) == 16, "AllocationHeader must keep 16 byte alignment");
+
+	const size_t MIN_ALIGNMENT = 16;
+	const float  RATE_WINDOW_SECONDS = 1.0f;
+
+	struct CategoryCounters
+	{
+		std::atomic<uint64_t> mLiveBytes{ 0 };
+		std::atomic<uint64_t> mPeakBytes{ 0 };
+		std::atomic<uint64_t> mLiveAllocations{ 0 };
+		std::atomic<uint64_t> mTotalAllocations{ 0 };
+		std::atomic<uint64_t> mTotalBytesAllocated{ 0 };
+
+		// Only touched by updateMemoryStats on the main thread
+		uint64_t mWindowStartAllocations = 0;
+		uint64_t mWindowStartBytes = 0;
+		std::atomic<float> mAllocationsPerSecond{ 0.0f };
+		std::atomic<float> mBytesPerSecond{ 0.0f };
+	};
+
+	CategoryCounters gCounters[MEMORY_CATEGORY_COUNT];
+	float gRateWindowTime = 0.0f;
+
+	const char* gCategoryNames[MEMORY_CATEGORY_COUNT] = {
+		"Renderer",
+		"UI",
+		"Assets",
+		"Events",
+		"Profiler",
+		"Vulkan Command",
+		"Vulkan Object",
+		"Vulkan Cache",
+		"Vulkan Device",
+		"Vulkan Instance",
+		"Vulkan Internal",
+	};
+
+	void trackAllocation(MemoryCategory category, size_t size)
+	{
+		CategoryCounters& counters = gCounters[category];
+		uint64_t live = counters.mLiveBytes.fetch_add(size, std::memory_order_relaxed) + size;
+		counters.mLiveAllocations.fetch_add(1, std::memory_order_relaxed);
+		counters.mTotalAllocations.fetch_add(1, std::memory_order_relaxed);
+		counters.mTotalBytesAllocated.fetch_add(size, std::memory_order_relaxed);
+
+		uint64_t peak = counters.mPeakBytes.load(std::memory_order_relaxed);
+		while (live > peak && !counters.mPeakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	void trackFree(MemoryCategory category, size_t size)
+	{
+		CategoryCounters& counters = gCounters[category];
+		counters.mLiveBytes.fetch_sub(size, std::memory_order_relaxed);
+		counters.mLiveAllocations.fetch_sub(1, std::memory_order_relaxed);
+	}
+
+	void* rawAlloc(size_t size, const char* f, int l, const char* sf)
+	{
+#ifdef SHEN_USE_MMGR
+		return mmgrAllocator(f, l, sf, m_alloc_malloc, MIN_ALIGNMENT, size);
+#else
+		(void)f;
+		(void)l;
+		(void)sf;
+		return malloc(size);
+#endif
+	}
+
+	void rawFree(void* ptr, const char* f, int l, const char* sf)
+	{
+#ifdef SHEN_USE_MMGR
+		mmgrDeallocator(f, l, sf, m_alloc_free, ptr);
+#else
+		(void)f;
+		(void)l;
+		(void)sf;
+		free(ptr);
+#endif
+	}
+
+	AllocationHeader* getHeader(void* ptr) { return (AllocationHeader*)ptr - 1; }
+}
+
+void initMemorySystem(const char* appName)
+{
+#ifdef SHEN_USE_MMGR
+	initMemAlloc(appName);
+#else
+	(void)appName;
+#endif
+}
+
+void exitMemorySystem()
+{
+	for (uint32_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i)
+	{
+		uint64_t live = gCounters[i].mLiveBytes.load();
+		if (live && i < MEMORY_CATEGORY_VULKAN_COMMAND)
+		{
+			SHEN_CORE_WARN("{0}: {1} bytes in {2} allocations still live at shutdown", gCategoryNames[i], live,
+				gCounters[i].mLiveAllocations.load());
+		}
+	}
+#ifdef SHEN_USE_MMGR
+	exitMemAlloc();
+#endif
+}
+
+void updateMemoryStats(float deltaTime)
+{
+	gRateWindowTime += deltaTime;
+	if (gRateWindowTime < RATE_WINDOW_SECONDS)
+		return;
+
+	for (uint32_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i)
+	{
+		CategoryCounters& counters = gCounters[i];
+		uint64_t allocations = counters.mTotalAllocations.load(std::memory_order_relaxed);
+		uint64_t bytes = counters.mTotalBytesAllocated.load(std::memory_order_relaxed);
+		counters.mAllocationsPerSecond.store((float)(allocations - counters.mWindowStartAllocations) / gRateWindowTime, std::memory_order_relaxed);
+		counters.mBytesPerSecond.store((float)(bytes - counters.mWindowStartBytes) / gRateWindowTime, std::memory_order_relaxed);
+		counters.mWindowStartAllocations = allocations;
+		counters.mWindowStartBytes = bytes;
+	}
+	gRateWindowTime = 0.0f;
+}
+
+void getMemoryStats(MemoryCategory category, MemoryCategoryStats* pOutStats)
+{
+	const CategoryCounters& counters = gCounters[category];
+	pOutStats->mLiveBytes = counters.mLiveBytes.load(std::memory_order_relaxed);
+	pOutStats->mPeakBytes = counters.mPeakBytes.load(std::memory_order_relaxed);
+	pOutStats->mLiveAllocations = counters.mLiveAllocations.load(std::memory_order_relaxed);
+	pOutStats->mTotalAllocations = counters.mTotalAllocations.load(std::memory_order_relaxed);
+	pOutStats->mTotalBytesAllocated = counters.mTotalBytesAllocated.load(std::memory_order_relaxed);
+	pOutStats->mAllocationsPerSecond = counters.mAllocationsPerSecond.load(std::memory_order_relaxed);
+	pOutStats->mBytesPerSecond = counters.mBytesPerSecond.load(std::memory_order_relaxed);
+}
+
+void resetMemoryPeakStats()
+{
+	for (uint32_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i)
+		gCounters[i].mPeakBytes.store(gCounters[i].mLiveBytes.load(std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+const char* getMemoryCategoryName(MemoryCategory category)
+{
+	return category < MEMORY_CATEGORY_COUNT ? gCategoryNames[category] : "Unknown";
+}
+
+void memoryTrackExternalAllocation(MemoryCategory category, size_t size) { trackAllocation(category, size); }
+
+void memoryTrackExternalFree(MemoryCategory category, size_t size) { trackFree(category, size); }
+
+void* shen_memalign_internal(MemoryCategory category, size_t alignment, size_t size, const char* f, int l, const char* sf)
+{
+	if (alignment < MIN_ALIGNMENT)
+		alignment = MIN_ALIGNMENT;
+
+	uint8_t* base = (uint8_t*)rawAlloc(size + sizeof(AllocationHeader) + alignment - 1, f, l, sf);
+	if (!base)
+		return NULL;
+
+	uintptr_t user = ((uintptr_t)base + sizeof(AllocationHeader) + alignment - 1) & ~(uintptr_t)(alignment - 1);
+	AllocationHeader* pHeader = getHeader((void*)user);
+	pHeader->mSize = size;
+	pHeader->mCategory = (uint32_t)category;
+	pHeader->mOffset = (uint32_t)(user - (uintptr_t)base);
+
+	trackAllocation(category, size);
+	return (void*)user;
+}
+
+void* shen_malloc_internal(MemoryCategory category, size_t size, const char* f, int l, const char* sf)
+{
+	return shen_memalign_internal(category, MIN_ALIGNMENT, size, f, l, sf);
+}
+
+void* shen_calloc_internal(MemoryCategory category, size_t count, size_t size, const char* f, int l, const char* sf)
+{
+	void* ptr = shen_memalign_internal(category, MIN_ALIGNMENT, count * size, f, l, sf);
+	if (ptr)
+		memset(ptr, 0, count * size);
+	return ptr;
+}
+
+void* shen_realloc_aligned_internal(MemoryCategory category, void* ptr, size_t alignment, size_t size, const char* f, int l, const char* sf)
+{
+	if (!ptr)
+		return shen_memalign_internal(category, alignment, size, f, l, sf);
+	if (size == 0)
+	{
+		shen_free_internal(ptr, f, l, sf);
+		return NULL;
+	}
+
+	void* newPtr = shen_memalign_internal(category, alignment, size, f, l, sf);
+	if (newPtr)
+	{
+		size_t oldSize = (size_t)getHeader(ptr)->mSize;
+		memcpy(newPtr, ptr, oldSize < size ? oldSize : size);
+		shen_free_internal(ptr, f, l, sf);
+	}
+	return newPtr;
+}
+
+void* shen_realloc_internal(MemoryCategory category, void* ptr, size_t size, const char* f, int l, const char* sf)
+{
+	return shen_realloc_aligned_internal(category, ptr, MIN_ALIGNMENT, size, f, l, sf);
+}
+
+void shen_free_internal(void* ptr, const char* f, int l, const char* sf)
+{
+	if (!ptr)
+		return;
+
+	AllocationHeader* pHeader = getHeader(ptr);
+	trackFree((MemoryCategory)pHeader->mCategory, (size_t)pHeader->mSize);
+	rawFree((uint8_t*)ptr - pHeader->mOffset, f, l, sf);
+}
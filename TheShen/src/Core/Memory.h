@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <utility>
+
+// Every engine allocation is tagged with a category so that live/peak bytes and allocation
+// rates can be reported per subsystem. Vulkan host allocations are reported per
+// VkSystemAllocationScope through the MEMORY_CATEGORY_VULKAN_* categories.
+typedef enum MemoryCategory
+{
+	MEMORY_CATEGORY_RENDERER = 0,
+	MEMORY_CATEGORY_UI,
+	MEMORY_CATEGORY_ASSETS,
+	MEMORY_CATEGORY_EVENTS,
+	MEMORY_CATEGORY_PROFILER,
+	MEMORY_CATEGORY_VULKAN_COMMAND,
+	MEMORY_CATEGORY_VULKAN_OBJECT,
+	MEMORY_CATEGORY_VULKAN_CACHE,
+	MEMORY_CATEGORY_VULKAN_DEVICE,
+	MEMORY_CATEGORY_VULKAN_INSTANCE,
+	/// Allocations the driver made on its own and only notified us about
+	MEMORY_CATEGORY_VULKAN_INTERNAL,
+	MEMORY_CATEGORY_COUNT
+} MemoryCategory;
+
+typedef struct MemoryCategoryStats
+{
+	uint64_t mLiveBytes;
+	uint64_t mPeakBytes;
+	uint64_t mLiveAllocations;
+	uint64_t mTotalAllocations;
+	uint64_t mTotalBytesAllocated;
+	/// Rates over the last completed sampling window (see updateMemoryStats)
+	float    mAllocationsPerSecond;
+	float    mBytesPerSecond;
+} MemoryCategoryStats;
+
+// Sets up the tracker. When SHEN_USE_MMGR is defined allocations are additionally forwarded to the
+// FluidStudios memory manager, which writes a leak report on exitMemorySystem.
+void initMemorySystem(const char* appName);
+void exitMemorySystem();
+
+// Called once per frame to roll the allocation rate window.
+void updateMemoryStats(float deltaTime);
+void getMemoryStats(MemoryCategory category, MemoryCategoryStats* pOutStats);
+// Restarts peak tracking from the current live bytes, so a peak can be measured over one phase (e.g. a benchmark scene).
+void resetMemoryPeakStats();
+const char* getMemoryCategoryName(MemoryCategory category);
+
+// Accounts for memory that was allocated outside the tracker (e.g. Vulkan internal allocation notifications).
+void memoryTrackExternalAllocation(MemoryCategory category, size_t size);
+void memoryTrackExternalFree(MemoryCategory category, size_t size);
+
+void* shen_malloc_internal(MemoryCategory category, size_t size, const char* f, int l, const char* sf);
+void* shen_memalign_internal(MemoryCategory category, size_t alignment, size_t size, const char* f, int l, const char* sf);
+void* shen_calloc_internal(MemoryCategory category, size_t count, size_t size, const char* f, int l, const char* sf);
+void* shen_realloc_internal(MemoryCategory category, void* ptr, size_t size, const char* f, int l, const char* sf);
+void* shen_realloc_aligned_internal(MemoryCategory category, void* ptr, size_t alignment, size_t size, const char* f, int l, const char* sf);
+void  shen_free_internal(void* ptr, const char* f, int l, const char* sf);
+
+template<typename T, typename... Args>
+T* shen_new_internal(MemoryCategory category, const char* f, int l, const char* sf, Args&&... args)
+{
+	T* ptr = (T*)shen_memalign_internal(category, alignof(T), sizeof(T), f, l, sf);
+	return new (ptr) T(std::forward<Args>(args)...);
+}
+
+template<typename T>
+void shen_delete_internal(T* ptr, const char* f, int l, const char* sf)
+{
+	if (ptr)
+	{
+		ptr->~T();
+		shen_free_internal(ptr, f, l, sf);
+	}
+}
+
+#define shen_malloc(category, size) shen_malloc_internal(category, size, __FILE__, __LINE__, __FUNCTION__)
+#define shen_memalign(category, align, size) shen_memalign_internal(category, align, size, __FILE__, __LINE__, __FUNCTION__)
+#define shen_calloc(category, count, size) shen_calloc_internal(category, count, size, __FILE__, __LINE__, __FUNCTION__)
+#define shen_realloc(category, ptr, size) shen_realloc_internal(category, ptr, size, __FILE__, __LINE__, __FUNCTION__)
+#define shen_free(ptr) shen_free_internal(ptr, __FILE__, __LINE__, __FUNCTION__)
+#define shen_new(category, ObjectType, ...) shen_new_internal<ObjectType>(category, __FILE__, __LINE__, __FUNCTION__, ##__VA_ARGS__)
+#define shen_delete(ptr) shen_delete_internal(ptr, __FILE__, __LINE__, __FUNCTION__)
+
+// STL allocator that charges a container's storage to a memory category.
+template<typename T, MemoryCategory Category>
+struct CategoryAllocator
+{
+	typedef T value_type;
+
+	CategoryAllocator() = default;
+	template<typename U>
+	CategoryAllocator(const CategoryAllocator<U, Category>&) {}
+
+	template<typename U>
+	struct rebind
+	{
+		typedef CategoryAllocator<U, Category> other;
+	};
+
+	T* allocate(size_t count)
+	{
+		return (T*)shen_memalign_internal(Category, alignof(T), count * sizeof(T), __FILE__, __LINE__, __FUNCTION__);
+	}
+	void deallocate(T* ptr, size_t) { shen_free_internal(ptr, __FILE__, __LINE__, __FUNCTION__); }
+
+	template<typename U>
+	bool operator==(const CategoryAllocator<U, Category>&) const { return true; }
+	template<typename U>
+	bool operator!=(const CategoryAllocator<U, Category>&) const { return false; }
+};
@@ -0,0 +1,609 @@
+#include "MetricsExporter.h"
+
+#ifdef _WIN32
+// winsock2.h has to be included before windows.h, which the renderer headers pull in
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "Core/Log.h"
+#include "Core/Memory.h"
+#include "Core/Profiler.h"
+#include "Renderer/GpuProfiler.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#ifdef _WIN32
+typedef SOCKET MetricsSocket;
+#define METRICS_INVALID_SOCKET INVALID_SOCKET
+#define closeMetricsSocket closesocket
+#else
+typedef int MetricsSocket;
+#define METRICS_INVALID_SOCKET (-1)
+#define closeMetricsSocket close
+#endif
+
+namespace
+{
+	const uint32_t HISTOGRAM_BUCKET_COUNT = (uint32_t)(METRICS_HISTOGRAM_MAX_MILLISECONDS / METRICS_HISTOGRAM_RESOLUTION_MILLISECONDS) + 1;
+	// Upper bound on how long a stop request or a pending sample waits for the HTTP listener
+	const uint32_t POLL_MILLISECONDS = 100;
+	// A scraper that connects but does not send its request within this time is dropped
+	const uint32_t REQUEST_TIMEOUT_MILLISECONDS = 1000;
+	const uint32_t MAX_METRIC_NAME = 64;
+
+	// Written by the frame loop with relaxed increments, drained by the exporter thread
+	struct MetricsHistogram
+	{
+		std::atomic<uint32_t> mBuckets[HISTOGRAM_BUCKET_COUNT];
+		std::atomic<uint64_t> mSumMicroseconds;
+		std::atomic<uint64_t> mMaxMicroseconds;
+	};
+
+	// What the exporter thread took out of a histogram for one interval
+	struct HistogramSample
+	{
+		uint32_t mBuckets[HISTOGRAM_BUCKET_COUNT];
+		uint64_t mCount;
+		double   mSumMilliseconds;
+		double   mMaxMilliseconds;
+	};
+
+	struct MetricsSample
+	{
+		double             mIntervalSeconds;
+		double             mTimestampSeconds;
+		HistogramSample    mFrames;
+		HistogramSample    mGpuFrames;
+		RendererStats      mRendererDelta;
+		MemoryCategoryStats mMemory[MEMORY_CATEGORY_COUNT];
+	};
+
+	struct MetricsExporter
+	{
+		MetricsExporterDesc     mDesc;
+		char                    mName[64];
+		// mName with quotes and backslashes escaped, valid both in a JSON string and in a Prometheus label value
+		char                    mEscapedName[128];
+		char                    mJsonFile[260];
+
+		// Frame loop side
+		MetricsHistogram        mFrameHistogram;
+		MetricsHistogram        mGpuHistogram;
+		// Renderer counters summed over every presented frame
+		RendererStatsCounters   mRendererTotals;
+		std::atomic<uint64_t>   mFrameCount;
+		uint64_t                mLastFrameTicks;
+		uint64_t                mLastRendererFrame;
+		uint64_t                mLastGpuFrame;
+		bool                    mHasGpuFrame;
+
+		// Exporter thread side
+		std::thread             mThread;
+		std::mutex              mStopMutex;
+		std::condition_variable mStopCondition;
+		bool                    mStop;
+		FILE*                   pJsonFile;
+		MetricsSocket           mListenSocket;
+		uint64_t                mLastSampleTicks;
+		RendererStats           mSampledTotals;
+		MetricsSample           mSample;
+		// Prometheus text of the latest sample, the listener runs on the exporter thread so it needs no lock
+		std::string             mPrometheusText;
+		std::string             mJsonLine;
+	};
+
+	MetricsExporter* pExporter = NULL;
+
+	void recordHistogram(MetricsHistogram* pHistogram, double milliseconds)
+	{
+		uint32_t bucket = (uint32_t)std::min(milliseconds / METRICS_HISTOGRAM_RESOLUTION_MILLISECONDS, (double)(HISTOGRAM_BUCKET_COUNT - 1));
+		pHistogram->mBuckets[bucket].fetch_add(1, std::memory_order_relaxed);
+		uint64_t microseconds = (uint64_t)(milliseconds * 1000.0);
+		pHistogram->mSumMicroseconds.fetch_add(microseconds, std::memory_order_relaxed);
+		uint64_t previousMax = pHistogram->mMaxMicroseconds.load(std::memory_order_relaxed);
+		while (microseconds > previousMax &&
+			!pHistogram->mMaxMicroseconds.compare_exchange_weak(previousMax, microseconds, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	// A frame recorded while this runs lands in either interval, never in both or neither
+	void drainHistogram(MetricsHistogram* pHistogram, HistogramSample* pOutSample)
+	{
+		pOutSample->mCount = 0;
+		for (uint32_t i = 0; i < HISTOGRAM_BUCKET_COUNT; ++i)
+		{
+			pOutSample->mBuckets[i] = pHistogram->mBuckets[i].exchange(0, std::memory_order_relaxed);
+			pOutSample->mCount += pOutSample->mBuckets[i];
+		}
+		pOutSample->mSumMilliseconds = pHistogram->mSumMicroseconds.exchange(0, std::memory_order_relaxed) / 1000.0;
+		pOutSample->mMaxMilliseconds = pHistogram->mMaxMicroseconds.exchange(0, std::memory_order_relaxed) / 1000.0;
+	}
+
+	// Nearest-rank percentile at bucket resolution, reported at the bucket's midpoint
+	double getPercentile(const HistogramSample* pSample, double percentile)
+	{
+		if (!pSample->mCount)
+			return 0.0;
+		uint64_t rank = std::max<uint64_t>(1, (uint64_t)(percentile * pSample->mCount + 0.999999));
+		uint64_t seen = 0;
+		for (uint32_t i = 0; i < HISTOGRAM_BUCKET_COUNT; ++i)
+		{
+			seen += pSample->mBuckets[i];
+			if (seen < rank)
+				continue;
+			if (i == HISTOGRAM_BUCKET_COUNT - 1)
+				return pSample->mMaxMilliseconds;
+			return std::min((i + 0.5) * METRICS_HISTOGRAM_RESOLUTION_MILLISECONDS, pSample->mMaxMilliseconds);
+		}
+		return pSample->mMaxMilliseconds;
+	}
+
+	double getMean(const HistogramSample* pSample)
+	{
+		return pSample->mCount ? pSample->mSumMilliseconds / pSample->mCount : 0.0;
+	}
+
+	void appendFormat(std::string& text, const char* pFormat, ...)
+	{
+		char buffer[512];
+		va_list args;
+		va_start(args, pFormat);
+		int length = vsnprintf(buffer, sizeof(buffer), pFormat, args);
+		va_end(args);
+		if (length > 0)
+			text.append(buffer, std::min<size_t>((size_t)length, sizeof(buffer) - 1));
+	}
+
+	// Both formats escape '"', '\\' and newlines with a backslash; other control characters are dropped
+	void escapeName(const char* pName, char* pOut, size_t outSize)
+	{
+		size_t length = 0;
+		for (const char* c = pName; *c && length + 3 <= outSize; ++c)
+		{
+			if (*c == '"' || *c == '\\')
+			{
+				pOut[length++] = '\\';
+				pOut[length++] = *c;
+			}
+			else if (*c == '\n')
+			{
+				pOut[length++] = '\\';
+				pOut[length++] = 'n';
+			}
+			else if ((unsigned char)*c >= 0x20)
+			{
+				pOut[length++] = *c;
+			}
+		}
+		pOut[length] = '\0';
+	}
+
+	// "mDrawCalls" -> "draw_calls", "Vulkan Command" -> "vulkan_command"
+	void toMetricName(const char* pName, char* pOut)
+	{
+		if (pName[0] == 'm' && pName[1] >= 'A' && pName[1] <= 'Z')
+			++pName;
+		uint32_t length = 0;
+		for (const char* c = pName; *c && length < MAX_METRIC_NAME - 2; ++c)
+		{
+			if (*c == ' ')
+			{
+				pOut[length++] = '_';
+				continue;
+			}
+			if (*c >= 'A' && *c <= 'Z')
+			{
+				// Only a lowercase letter or digit ends a word, so acronyms such as "UI" stay together
+				char previous = c > pName ? c[-1] : ' ';
+				if ((previous >= 'a' && previous <= 'z') || (previous >= '0' && previous <= '9'))
+					pOut[length++] = '_';
+				pOut[length++] = (char)(*c - 'A' + 'a');
+				continue;
+			}
+			pOut[length++] = *c;
+		}
+		pOut[length] = '\0';
+	}
+
+	void takeSample(uint64_t nowTicks)
+	{
+		MetricsSample* pSample = &pExporter->mSample;
+		pSample->mIntervalSeconds = profilerTicksToMilliseconds(nowTicks - pExporter->mLastSampleTicks) / 1000.0;
+		pSample->mTimestampSeconds = std::chrono::duration<double>(std::chrono::system_clock::now().time_since_epoch()).count();
+		pExporter->mLastSampleTicks = nowTicks;
+
+		drainHistogram(&pExporter->mFrameHistogram, &pSample->mFrames);
+		drainHistogram(&pExporter->mGpuHistogram, &pSample->mGpuFrames);
+		for (uint32_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i)
+			getMemoryStats((MemoryCategory)i, &pSample->mMemory[i]);
+
+		RendererStats totals = {};
+#define METRICS_READ_TOTAL(name)																	\
+		totals.name = pExporter->mRendererTotals.name.load(std::memory_order_relaxed);				\
+		pSample->mRendererDelta.name = totals.name - pExporter->mSampledTotals.name;
+		RENDERER_STATS_COUNTER_LIST(METRICS_READ_TOTAL)
+#undef METRICS_READ_TOTAL
+		pExporter->mSampledTotals = totals;
+	}
+
+	void writeJsonLine()
+	{
+		const MetricsSample* pSample = &pExporter->mSample;
+		std::string& line = pExporter->mJsonLine;
+		line.clear();
+		double fps = pSample->mIntervalSeconds > 0.0 ? pSample->mFrames.mCount / pSample->mIntervalSeconds : 0.0;
+		appendFormat(line, "{\"timestamp\":%.3f,\"app\":\"%s\",\"interval_s\":%.3f,\"frames\":%llu,\"fps\":%.2f,",
+			pSample->mTimestampSeconds, pExporter->mEscapedName, pSample->mIntervalSeconds, (unsigned long long)pSample->mFrames.mCount, fps);
+		appendFormat(line, "\"frame_ms\":{\"mean\":%.3f,\"p50\":%.3f,\"p90\":%.3f,\"p99\":%.3f,\"max\":%.3f},",
+			getMean(&pSample->mFrames), getPercentile(&pSample->mFrames, 0.5), getPercentile(&pSample->mFrames, 0.9),
+			getPercentile(&pSample->mFrames, 0.99), pSample->mFrames.mMaxMilliseconds);
+		appendFormat(line, "\"gpu_ms\":{\"frames\":%llu,\"mean\":%.3f,\"p50\":%.3f,\"p90\":%.3f,\"p99\":%.3f,\"max\":%.3f},",
+			(unsigned long long)pSample->mGpuFrames.mCount, getMean(&pSample->mGpuFrames), getPercentile(&pSample->mGpuFrames, 0.5),
+			getPercentile(&pSample->mGpuFrames, 0.9), getPercentile(&pSample->mGpuFrames, 0.99), pSample->mGpuFrames.mMaxMilliseconds);
+
+		char name[MAX_METRIC_NAME];
+		line += "\"memory\":{";
+		for (uint32_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i)
+		{
+			toMetricName(getMemoryCategoryName((MemoryCategory)i), name);
+			appendFormat(line, "%s\"%s\":{\"live_bytes\":%llu,\"peak_bytes\":%llu}", i ? "," : "", name,
+				(unsigned long long)pSample->mMemory[i].mLiveBytes, (unsigned long long)pSample->mMemory[i].mPeakBytes);
+		}
+		// Renderer counters are summed over the interval
+		line += "},\"renderer\":{";
+		const char* pSeparator = "";
+#define METRICS_JSON_COUNTER(field)																\
+		toMetricName(#field, name);																\
+		appendFormat(line, "%s\"%s\":%llu", pSeparator, name, (unsigned long long)pSample->mRendererDelta.field);	\
+		pSeparator = ",";
+		RENDERER_STATS_COUNTER_LIST(METRICS_JSON_COUNTER)
+#undef METRICS_JSON_COUNTER
+		line += "}}\n";
+
+		fwrite(line.data(), 1, line.size(), pExporter->pJsonFile);
+		fflush(pExporter->pJsonFile);
+	}
+
+	void appendPrometheusHeader(std::string& text, const char* pName, const char* pType, const char* pHelp)
+	{
+		appendFormat(text, "# HELP %s %s\n# TYPE %s %s\n", pName, pHelp, pName, pType);
+	}
+
+	void appendQuantiles(std::string& text, const char* pName, const HistogramSample* pSample)
+	{
+		static const double quantiles[] = { 0.5, 0.9, 0.99 };
+		for (double quantile : quantiles)
+			appendFormat(text, "%s{app=\"%s\",quantile=\"%g\"} %.3f\n", pName, pExporter->mEscapedName, quantile, getPercentile(pSample, quantile));
+	}
+
+	void buildPrometheusText()
+	{
+		const MetricsSample* pSample = &pExporter->mSample;
+		const char* pApp = pExporter->mEscapedName;
+		std::string& text = pExporter->mPrometheusText;
+		text.clear();
+
+		appendPrometheusHeader(text, "shen_metrics_interval_seconds", "gauge", "Length of the interval the gauges below cover.");
+		appendFormat(text, "shen_metrics_interval_seconds{app=\"%s\"} %.3f\n", pApp, pSample->mIntervalSeconds);
+		appendPrometheusHeader(text, "shen_frames_total", "counter", "Frames started since the exporter was initialized.");
+		appendFormat(text, "shen_frames_total{app=\"%s\"} %llu\n", pApp, (unsigned long long)pExporter->mFrameCount.load(std::memory_order_relaxed));
+		appendPrometheusHeader(text, "shen_frames_per_second", "gauge", "Frame rate over the last interval.");
+		appendFormat(text, "shen_frames_per_second{app=\"%s\"} %.2f\n", pApp,
+			pSample->mIntervalSeconds > 0.0 ? pSample->mFrames.mCount / pSample->mIntervalSeconds : 0.0);
+
+		appendPrometheusHeader(text, "shen_frame_time_milliseconds", "gauge", "CPU frame time percentiles over the last interval.");
+		appendQuantiles(text, "shen_frame_time_milliseconds", &pSample->mFrames);
+		appendPrometheusHeader(text, "shen_frame_time_mean_milliseconds", "gauge", "Mean CPU frame time over the last interval.");
+		appendFormat(text, "shen_frame_time_mean_milliseconds{app=\"%s\"} %.3f\n", pApp, getMean(&pSample->mFrames));
+		appendPrometheusHeader(text, "shen_frame_time_max_milliseconds", "gauge", "Slowest CPU frame in the last interval.");
+		appendFormat(text, "shen_frame_time_max_milliseconds{app=\"%s\"} %.3f\n", pApp, pSample->mFrames.mMaxMilliseconds);
+
+		appendPrometheusHeader(text, "shen_gpu_frame_time_milliseconds", "gauge", "GPU frame time percentiles over the last interval.");
+		appendQuantiles(text, "shen_gpu_frame_time_milliseconds", &pSample->mGpuFrames);
+		appendPrometheusHeader(text, "shen_gpu_frame_time_mean_milliseconds", "gauge", "Mean GPU frame time over the last interval.");
+		appendFormat(text, "shen_gpu_frame_time_mean_milliseconds{app=\"%s\"} %.3f\n", pApp, getMean(&pSample->mGpuFrames));
+
+		char name[MAX_METRIC_NAME];
+		appendPrometheusHeader(text, "shen_memory_live_bytes", "gauge", "Live bytes per memory category.");
+		for (uint32_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i)
+		{
+			toMetricName(getMemoryCategoryName((MemoryCategory)i), name);
+			appendFormat(text, "shen_memory_live_bytes{app=\"%s\",category=\"%s\"} %llu\n", pApp, name, (unsigned long long)pSample->mMemory[i].mLiveBytes);
+		}
+		appendPrometheusHeader(text, "shen_memory_peak_bytes", "gauge", "Peak live bytes per memory category.");
+		for (uint32_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i)
+		{
+			toMetricName(getMemoryCategoryName((MemoryCategory)i), name);
+			appendFormat(text, "shen_memory_peak_bytes{app=\"%s\",category=\"%s\"} %llu\n", pApp, name, (unsigned long long)pSample->mMemory[i].mPeakBytes);
+		}
+
+		char metric[MAX_METRIC_NAME + 32];
+#define METRICS_PROMETHEUS_COUNTER(field)																		\
+		toMetricName(#field, name);																				\
+		snprintf(metric, sizeof(metric), "shen_renderer_%s_total", name);										\
+		appendPrometheusHeader(text, metric, "counter", "Renderer counter summed over all presented frames.");	\
+		appendFormat(text, "%s{app=\"%s\"} %llu\n", metric, pApp, (unsigned long long)pExporter->mSampledTotals.field);
+		RENDERER_STATS_COUNTER_LIST(METRICS_PROMETHEUS_COUNTER)
+#undef METRICS_PROMETHEUS_COUNTER
+	}
+
+	void sendAll(MetricsSocket client, const char* pData, size_t size)
+	{
+		while (size)
+		{
+			int sent = send(client, pData, (int)std::min<size_t>(size, 1 << 20), 0);
+			if (sent <= 0)
+				return;
+			pData += sent;
+			size -= (size_t)sent;
+		}
+	}
+
+	bool waitReadable(MetricsSocket socket, uint32_t milliseconds)
+	{
+		fd_set readSet;
+		FD_ZERO(&readSet);
+		FD_SET(socket, &readSet);
+		timeval timeout;
+		timeout.tv_sec = milliseconds / 1000;
+		timeout.tv_usec = (milliseconds % 1000) * 1000;
+		return select((int)socket + 1, &readSet, NULL, NULL, &timeout) > 0;
+	}
+
+	// One request per connection, which is all a Prometheus scraper or curl needs
+	void serveClient(MetricsSocket client)
+	{
+		char request[1024];
+		int received = 0;
+		if (waitReadable(client, REQUEST_TIMEOUT_MILLISECONDS))
+			received = recv(client, request, sizeof(request) - 1, 0);
+		if (received <= 0)
+			return;
+		request[received] = '\0';
+
+		const char* pStatus = "404 Not Found";
+		const std::string* pBody = NULL;
+		if (!strncmp(request, "GET /metrics ", 13) || !strncmp(request, "GET / ", 6))
+		{
+			pStatus = "200 OK";
+			pBody = &pExporter->mPrometheusText;
+		}
+
+		char header[256];
+		int headerLength = snprintf(header, sizeof(header),
+			"HTTP/1.1 %s\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\nContent-Length: %zu\r\nConnection: close\r\n\r\n",
+			pStatus, pBody ? pBody->size() : (size_t)0);
+		sendAll(client, header, (size_t)headerLength);
+		if (pBody)
+			sendAll(client, pBody->data(), pBody->size());
+	}
+
+	bool openListenSocket(uint16_t port)
+	{
+#ifdef _WIN32
+		WSADATA wsaData;
+		if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0)
+			return false;
+#endif
+		MetricsSocket listenSocket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+		if (listenSocket == METRICS_INVALID_SOCKET)
+			return false;
+
+		int reuse = 1;
+		setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+		// Loopback only, the metrics are not meant to leave the machine without a proxy in front
+		sockaddr_in address = {};
+		address.sin_family = AF_INET;
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		address.sin_port = htons(port);
+		if (bind(listenSocket, (const sockaddr*)&address, sizeof(address)) != 0 || listen(listenSocket, 8) != 0)
+		{
+			closeMetricsSocket(listenSocket);
+			return false;
+		}
+		pExporter->mListenSocket = listenSocket;
+		return true;
+	}
+
+	void closeListenSocket()
+	{
+		if (pExporter->mListenSocket == METRICS_INVALID_SOCKET)
+			return;
+		closeMetricsSocket(pExporter->mListenSocket);
+		pExporter->mListenSocket = METRICS_INVALID_SOCKET;
+#ifdef _WIN32
+		WSACleanup();
+#endif
+	}
+
+	void publishSample(uint64_t nowTicks)
+	{
+		takeSample(nowTicks);
+		if (pExporter->pJsonFile)
+			writeJsonLine();
+		if (pExporter->mListenSocket != METRICS_INVALID_SOCKET)
+			buildPrometheusText();
+	}
+
+	void exporterThread()
+	{
+		double intervalMilliseconds = pExporter->mDesc.mIntervalSeconds * 1000.0;
+		while (true)
+		{
+			double elapsed = profilerTicksToMilliseconds(profilerGetTicks() - pExporter->mLastSampleTicks);
+			uint32_t waitMilliseconds = (uint32_t)std::max(intervalMilliseconds - elapsed, 0.0);
+			if (pExporter->mListenSocket != METRICS_INVALID_SOCKET)
+			{
+				{
+					std::lock_guard<std::mutex> lock(pExporter->mStopMutex);
+					if (pExporter->mStop)
+						break;
+				}
+				if (waitReadable(pExporter->mListenSocket, std::min(waitMilliseconds, POLL_MILLISECONDS)))
+				{
+					MetricsSocket client = accept(pExporter->mListenSocket, NULL, NULL);
+					if (client != METRICS_INVALID_SOCKET)
+					{
+						serveClient(client);
+						closeMetricsSocket(client);
+					}
+				}
+			}
+			else
+			{
+				std::unique_lock<std::mutex> lock(pExporter->mStopMutex);
+				if (pExporter->mStopCondition.wait_for(lock, std::chrono::milliseconds(waitMilliseconds), [] { return pExporter->mStop; }))
+					break;
+			}
+
+			uint64_t now = profilerGetTicks();
+			if (profilerTicksToMilliseconds(now - pExporter->mLastSampleTicks) >= intervalMilliseconds)
+				publishSample(now);
+		}
+		// The partial interval still goes to the file, a scraper would not see it anymore
+		if (pExporter->pJsonFile)
+			publishSample(profilerGetTicks());
+	}
+}
+
+bool initMetricsExporter(const MetricsExporterDesc* pDesc)
+{
+	pExporter = shen_new(MEMORY_CATEGORY_PROFILER, MetricsExporter);
+	pExporter->mDesc = *pDesc;
+	if (pExporter->mDesc.mIntervalSeconds <= 0.0f)
+		pExporter->mDesc.mIntervalSeconds = 1.0f;
+	memset(pExporter->mName, 0, sizeof(pExporter->mName));
+	strncpy(pExporter->mName, pDesc->pName ? pDesc->pName : "shen", sizeof(pExporter->mName) - 1);
+	pExporter->mDesc.pName = pExporter->mName;
+	escapeName(pExporter->mName, pExporter->mEscapedName, sizeof(pExporter->mEscapedName));
+	memset(pExporter->mJsonFile, 0, sizeof(pExporter->mJsonFile));
+	if (pDesc->pJsonFile)
+	{
+		strncpy(pExporter->mJsonFile, pDesc->pJsonFile, sizeof(pExporter->mJsonFile) - 1);
+		pExporter->mDesc.pJsonFile = pExporter->mJsonFile;
+	}
+
+	for (uint32_t i = 0; i < HISTOGRAM_BUCKET_COUNT; ++i)
+	{
+		pExporter->mFrameHistogram.mBuckets[i].store(0, std::memory_order_relaxed);
+		pExporter->mGpuHistogram.mBuckets[i].store(0, std::memory_order_relaxed);
+	}
+	pExporter->mFrameHistogram.mSumMicroseconds.store(0);
+	pExporter->mFrameHistogram.mMaxMicroseconds.store(0);
+	pExporter->mGpuHistogram.mSumMicroseconds.store(0);
+	pExporter->mGpuHistogram.mMaxMicroseconds.store(0);
+#define METRICS_RESET_TOTAL(name) pExporter->mRendererTotals.name.store(0);
+	RENDERER_STATS_COUNTER_LIST(METRICS_RESET_TOTAL)
+#undef METRICS_RESET_TOTAL
+	pExporter->mFrameCount.store(0);
+	pExporter->mLastFrameTicks = 0;
+	pExporter->mLastRendererFrame = 0;
+	pExporter->mLastGpuFrame = 0;
+	pExporter->mHasGpuFrame = false;
+	pExporter->mStop = false;
+	pExporter->pJsonFile = NULL;
+	pExporter->mListenSocket = METRICS_INVALID_SOCKET;
+	memset(&pExporter->mSampledTotals, 0, sizeof(pExporter->mSampledTotals));
+	memset(&pExporter->mSample, 0, sizeof(pExporter->mSample));
+	pExporter->mPrometheusText = "# no sample yet\n";
+
+	if (pExporter->mDesc.pJsonFile)
+	{
+		pExporter->pJsonFile = fopen(pExporter->mDesc.pJsonFile, "a");
+		if (!pExporter->pJsonFile)
+			SHEN_CORE_ERROR("metrics exporter: failed to open {0}", pExporter->mDesc.pJsonFile);
+	}
+	if (pExporter->mDesc.mHttpPort && !openListenSocket(pExporter->mDesc.mHttpPort))
+		SHEN_CORE_ERROR("metrics exporter: failed to listen on 127.0.0.1:{0}", pExporter->mDesc.mHttpPort);
+
+	if (!pExporter->pJsonFile && pExporter->mListenSocket == METRICS_INVALID_SOCKET)
+	{
+		shen_delete(pExporter);
+		pExporter = NULL;
+		return false;
+	}
+
+	if (pExporter->pJsonFile)
+		SHEN_CORE_INFO("metrics exporter: appending a sample every {0:.1f} s to {1}", pExporter->mDesc.mIntervalSeconds, pExporter->mDesc.pJsonFile);
+	if (pExporter->mListenSocket != METRICS_INVALID_SOCKET)
+		SHEN_CORE_INFO("metrics exporter: serving http://127.0.0.1:{0}/metrics", pExporter->mDesc.mHttpPort);
+
+	pExporter->mLastSampleTicks = profilerGetTicks();
+	pExporter->mThread = std::thread(exporterThread);
+	return true;
+}
+
+void exitMetricsExporter()
+{
+	if (!pExporter)
+		return;
+
+	{
+		std::lock_guard<std::mutex> lock(pExporter->mStopMutex);
+		pExporter->mStop = true;
+	}
+	pExporter->mStopCondition.notify_one();
+	pExporter->mThread.join();
+
+	closeListenSocket();
+	if (pExporter->pJsonFile)
+		fclose(pExporter->pJsonFile);
+	shen_delete(pExporter);
+	pExporter = NULL;
+}
+
+void metricsExporterBeginFrame()
+{
+	if (!pExporter)
+		return;
+
+	uint64_t now = profilerGetTicks();
+	if (pExporter->mLastFrameTicks)
+		recordHistogram(&pExporter->mFrameHistogram, profilerTicksToMilliseconds(now - pExporter->mLastFrameTicks));
+	pExporter->mLastFrameTicks = now;
+	pExporter->mFrameCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void metricsExporterOnPresent(Queue* pQueue)
+{
+	if (!pExporter)
+		return;
+
+	RendererStats stats;
+	getRendererStats(pQueue->pRenderer, &stats);
+	if (stats.mFrameIndex && stats.mFrameIndex != pExporter->mLastRendererFrame)
+	{
+		pExporter->mLastRendererFrame = stats.mFrameIndex;
+#define METRICS_ADD_TOTAL(name) pExporter->mRendererTotals.name.fetch_add(stats.name, std::memory_order_relaxed);
+		RENDERER_STATS_COUNTER_LIST(METRICS_ADD_TOTAL)
+#undef METRICS_ADD_TOTAL
+	}
+
+	// GPU results trail the CPU by a few frames, each result is counted once; the root scope is the whole frame
+	GpuProfileResults results;
+	if (!getGpuProfileResults(pQueue, &results) || !results.mTimerCount)
+		return;
+	if (pExporter->mHasGpuFrame && results.mFrameIndex <= pExporter->mLastGpuFrame)
+		return;
+	pExporter->mHasGpuFrame = true;
+	pExporter->mLastGpuFrame = results.mFrameIndex;
+	recordHistogram(&pExporter->mGpuHistogram, results.pTimers[0].mMilliseconds);
+}
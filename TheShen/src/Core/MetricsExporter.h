@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+
+struct Queue;
+
+// Exports aggregated frame metrics for fleet monitoring. The frame loop only bumps atomic counters:
+// a frame-time histogram, a GPU-time histogram (root scope of the queue's GPU profiler) and running
+// totals of the renderer counters. A background thread turns them into one sample per interval:
+// frame-time percentiles, GPU time, per-category memory and renderer counters. Each sample is either
+// appended to a file as one JSON object per line, served in Prometheus text format from a loopback
+// HTTP listener (curl http://127.0.0.1:<port>/metrics), or both.
+// Call the init/exit functions from the main thread; the frame hooks from the thread that runs the frame loop.
+
+// Frame and GPU times are bucketed at this resolution up to METRICS_HISTOGRAM_MAX_MILLISECONDS,
+// slower frames share an overflow bucket and percentiles that land there report the slowest frame.
+#define METRICS_HISTOGRAM_RESOLUTION_MILLISECONDS 0.1
+#define METRICS_HISTOGRAM_MAX_MILLISECONDS 250.0
+
+// Zero fields take the defaults listed next to them
+typedef struct MetricsExporterDesc
+{
+	// Reported as the "app" label / field, defaults to "shen"
+	const char* pName;
+	// Seconds aggregated into one sample (1.0)
+	float       mIntervalSeconds;
+	// Loopback port of the Prometheus listener, 0 disables it
+	uint16_t    mHttpPort;
+	// JSON lines are appended to this file, NULL disables it
+	const char* pJsonFile;
+} MetricsExporterDesc;
+
+// Returns false (and exports nothing) when neither output could be opened
+bool initMetricsExporter(const MetricsExporterDesc* pDesc);
+// Joins the exporter thread after writing the samples still pending
+void exitMetricsExporter();
+
+// Frame boundary, called by Application::Run next to flightRecorderBeginFrame
+void metricsExporterBeginFrame();
+// Called by queuePresent after the renderer stats of the frame were archived, no-op while not initialized
+void metricsExporterOnPresent(Queue* pQueue);
@@ -0,0 +1,444 @@
+#include "Profiler.h"
+#include "Core/Log.h"
+#include "Core/Memory.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+#if defined(_M_X64) || defined(__x86_64__)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#define PROFILER_USE_TSC 1
+#else
+#define PROFILER_USE_TSC 0
+#endif
+
+struct ProfileTraceWriter
+{
+	FILE*    pFile;
+	uint64_t mBeginTicks;
+	uint64_t mEndTicks;
+	bool     mFirst;
+	uint64_t mEventCount;
+};
+
+namespace
+{
+	static_assert((PROFILER_EVENTS_PER_THREAD & (PROFILER_EVENTS_PER_THREAD - 1)) == 0, "PROFILER_EVENTS_PER_THREAD must be a power of two");
+	const uint64_t EVENT_INDEX_MASK = PROFILER_EVENTS_PER_THREAD - 1;
+
+	typedef std::chrono::steady_clock ProfileClock;
+
+	// The TSC is read instead of QueryPerformanceCounter/steady_clock where available, it is several
+	// times cheaper. Its rate is measured against steady_clock and frozen once enough time has passed.
+	const double CALIBRATION_SECONDS = 1.0;
+
+	struct TickCalibration
+	{
+		uint64_t                 mStartTicks;
+		ProfileClock::time_point mStartTime;
+		std::atomic<double>      mFrozenMillisecondsPerTick{ 0.0 };
+	};
+
+	uint64_t readTicks()
+	{
+#if PROFILER_USE_TSC
+		return __rdtsc();
+#else
+		return (uint64_t)ProfileClock::now().time_since_epoch().count();
+#endif
+	}
+
+	TickCalibration gCalibration = { readTicks(), ProfileClock::now() };
+
+	double getMillisecondsPerTick()
+	{
+#if PROFILER_USE_TSC
+		double frozen = gCalibration.mFrozenMillisecondsPerTick.load(std::memory_order_relaxed);
+		if (frozen > 0.0)
+			return frozen;
+
+		uint64_t ticks = readTicks() - gCalibration.mStartTicks;
+		double elapsedMilliseconds = std::chrono::duration<double, std::milli>(ProfileClock::now() - gCalibration.mStartTime).count();
+		if (ticks == 0)
+			return 0.0;
+		double millisecondsPerTick = elapsedMilliseconds / (double)ticks;
+		if (elapsedMilliseconds >= CALIBRATION_SECONDS * 1000.0)
+			gCalibration.mFrozenMillisecondsPerTick.store(millisecondsPerTick, std::memory_order_relaxed);
+		return millisecondsPerTick;
+#else
+		return 1000.0 * (double)ProfileClock::period::num / (double)ProfileClock::period::den;
+#endif
+	}
+
+	// Written only by its owning thread. mWriteIndex counts every event ever recorded, the slot is
+	// mWriteIndex & EVENT_INDEX_MASK, so readers can tell how much of what they copied is still intact.
+	struct ThreadProfileBuffer
+	{
+		ProfileEvent          mEvents[PROFILER_EVENTS_PER_THREAD];
+		std::atomic<uint64_t> mWriteIndex{ 0 };
+		char                  mName[PROFILER_MAX_THREAD_NAME];
+	};
+
+	struct CaptureState
+	{
+		std::mutex           mMutex;
+		// Checked once per frame without taking the mutex
+		std::atomic<bool>    mActive{ false };
+		bool                 mRunning = false;
+		uint32_t             mFramesLeft = 0;
+		uint64_t             mBeginTicks = 0;
+		char                 mFileName[260];
+	};
+
+	ThreadProfileBuffer*  gThreads[PROFILER_MAX_THREADS] = {};
+	std::atomic<uint32_t> gThreadCount{ 0 };
+	std::mutex            gRegisterMutex;
+	bool                  gThreadLimitReported = false;
+	thread_local ThreadProfileBuffer* tThreadBuffer = NULL;
+
+	uint64_t              gFrameStarts[PROFILER_FRAME_HISTORY] = {};
+	std::atomic<uint64_t> gFrameCount{ 0 };
+
+	CaptureState gCapture;
+
+	ThreadProfileBuffer* registerThread()
+	{
+		std::lock_guard<std::mutex> lock(gRegisterMutex);
+		uint32_t index = gThreadCount.load(std::memory_order_relaxed);
+		if (index >= PROFILER_MAX_THREADS)
+		{
+			if (!gThreadLimitReported)
+			{
+				SHEN_CORE_WARN("profiler: more than {0} threads, scopes on new threads are ignored", PROFILER_MAX_THREADS);
+				gThreadLimitReported = true;
+			}
+			return NULL;
+		}
+
+		ThreadProfileBuffer* pBuffer = shen_new(MEMORY_CATEGORY_PROFILER, ThreadProfileBuffer);
+		snprintf(pBuffer->mName, sizeof(pBuffer->mName), "Thread %u", index);
+		gThreads[index] = pBuffer;
+		gThreadCount.store(index + 1, std::memory_order_release);
+		tThreadBuffer = pBuffer;
+		return pBuffer;
+	}
+
+	void writeJsonString(FILE* pFile, const char* pString)
+	{
+		fputc('"', pFile);
+		for (const char* c = pString; *c; ++c)
+		{
+			if (*c == '"' || *c == '\\')
+				fprintf(pFile, "\\%c", *c);
+			else if ((unsigned char)*c < 0x20)
+				fprintf(pFile, "\\u%04x", (unsigned)*c);
+			else
+				fputc(*c, pFile);
+		}
+		fputc('"', pFile);
+	}
+
+	void beginTraceEvent(ProfileTraceWriter* pWriter)
+	{
+		fputs(pWriter->mFirst ? "\n" : ",\n", pWriter->pFile);
+		pWriter->mFirst = false;
+	}
+
+	void writeTraceEvents(void* pUserData, uint32_t threadIndex, const ProfileEvent* pEvents, uint32_t eventCount)
+	{
+		ProfileTraceWriter* pWriter = (ProfileTraceWriter*)pUserData;
+		for (uint32_t i = 0; i < eventCount; ++i)
+		{
+			const ProfileEvent* pEvent = &pEvents[i];
+			// Scopes that started before the window are clamped to its start
+			uint64_t begin = pEvent->mBeginTicks > pWriter->mBeginTicks ? pEvent->mBeginTicks : pWriter->mBeginTicks;
+			beginTraceEvent(pWriter);
+			fputs("{\"ph\":\"X\",\"cat\":\"cpu\",\"name\":", pWriter->pFile);
+			writeJsonString(pWriter->pFile, pEvent->pName);
+			fprintf(pWriter->pFile, ",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", threadIndex,
+				profilerTicksToMilliseconds(begin - pWriter->mBeginTicks) * 1000.0,
+				profilerTicksToMilliseconds(pEvent->mEndTicks - begin) * 1000.0);
+		}
+		pWriter->mEventCount += eventCount;
+	}
+
+	void finishCapture(uint64_t endTicks)
+	{
+		profilerWriteChromeTrace(gCapture.mFileName, gCapture.mBeginTicks, endTicks);
+		gCapture.mRunning = false;
+		gCapture.mActive.store(false, std::memory_order_relaxed);
+	}
+}
+
+void initProfiler()
+{
+	profilerSetThreadName("Main");
+}
+
+void exitProfiler()
+{
+	std::lock_guard<std::mutex> lock(gRegisterMutex);
+	uint32_t count = gThreadCount.load(std::memory_order_relaxed);
+	gThreadCount.store(0, std::memory_order_release);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		shen_delete(gThreads[i]);
+		gThreads[i] = NULL;
+	}
+	tThreadBuffer = NULL;
+}
+
+void profilerSetThreadName(const char* pName)
+{
+	ThreadProfileBuffer* pBuffer = tThreadBuffer ? tThreadBuffer : registerThread();
+	if (!pBuffer)
+		return;
+	strncpy(pBuffer->mName, pName, sizeof(pBuffer->mName) - 1);
+	pBuffer->mName[sizeof(pBuffer->mName) - 1] = '\0';
+}
+
+uint64_t profilerGetTicks()
+{
+	return readTicks();
+}
+
+double profilerTicksToMilliseconds(uint64_t ticks)
+{
+	return (double)ticks * getMillisecondsPerTick();
+}
+
+void profilerRecordScope(const char* pName, uint64_t beginTicks, uint64_t endTicks)
+{
+	ThreadProfileBuffer* pBuffer = tThreadBuffer;
+	if (!pBuffer)
+	{
+		pBuffer = registerThread();
+		if (!pBuffer)
+			return;
+	}
+
+	uint64_t writeIndex = pBuffer->mWriteIndex.load(std::memory_order_relaxed);
+	ProfileEvent* pEvent = &pBuffer->mEvents[writeIndex & EVENT_INDEX_MASK];
+	pEvent->pName = pName;
+	pEvent->mBeginTicks = beginTicks;
+	pEvent->mEndTicks = endTicks;
+	pBuffer->mWriteIndex.store(writeIndex + 1, std::memory_order_release);
+}
+
+void profilerBeginFrame()
+{
+	uint64_t now = profilerGetTicks();
+	uint64_t frame = gFrameCount.load(std::memory_order_relaxed);
+	gFrameStarts[frame % PROFILER_FRAME_HISTORY] = now;
+	gFrameCount.store(frame + 1, std::memory_order_release);
+
+	if (!gCapture.mActive.load(std::memory_order_relaxed))
+		return;
+
+	std::lock_guard<std::mutex> lock(gCapture.mMutex);
+	if (!gCapture.mRunning)
+	{
+		gCapture.mRunning = true;
+		gCapture.mBeginTicks = now;
+		return;
+	}
+	if (--gCapture.mFramesLeft == 0)
+		finishCapture(now);
+}
+
+uint64_t profilerGetFrameIndex()
+{
+	uint64_t count = gFrameCount.load(std::memory_order_acquire);
+	return count ? count - 1 : 0;
+}
+
+bool profilerGetFrameStartTicks(uint64_t frameIndex, uint64_t* pOutTicks)
+{
+	uint64_t count = gFrameCount.load(std::memory_order_acquire);
+	// Keep one slot of slack so the entry is not being overwritten by the next profilerBeginFrame
+	if (frameIndex >= count || frameIndex + PROFILER_FRAME_HISTORY - 1 < count)
+		return false;
+	*pOutTicks = gFrameStarts[frameIndex % PROFILER_FRAME_HISTORY];
+	return true;
+}
+
+bool profilerRequestCapture(uint32_t frameCount, const char* pFileName)
+{
+	std::lock_guard<std::mutex> lock(gCapture.mMutex);
+	if (gCapture.mActive.load(std::memory_order_relaxed))
+	{
+		SHEN_CORE_WARN("profiler: a capture is already running, ignoring request for {0}", pFileName);
+		return false;
+	}
+	if (frameCount == 0)
+		frameCount = 1;
+	if (frameCount > PROFILER_FRAME_HISTORY - 1)
+		frameCount = PROFILER_FRAME_HISTORY - 1;
+
+	strncpy(gCapture.mFileName, pFileName, sizeof(gCapture.mFileName) - 1);
+	gCapture.mFileName[sizeof(gCapture.mFileName) - 1] = '\0';
+	gCapture.mFramesLeft = frameCount;
+	gCapture.mRunning = false;
+	gCapture.mActive.store(true, std::memory_order_relaxed);
+	SHEN_CORE_INFO("profiler: capturing {0} frames to {1}", frameCount, pFileName);
+	return true;
+}
+
+bool profilerIsCapturing()
+{
+	return gCapture.mActive.load(std::memory_order_relaxed);
+}
+
+void profilerCollectEvents(uint64_t beginTicks, uint64_t endTicks, ProfileEventVisitor visitor, void* pUserData)
+{
+	std::vector<ProfileEvent, CategoryAllocator<ProfileEvent, MEMORY_CATEGORY_PROFILER>> events;
+
+	uint32_t threadCount = gThreadCount.load(std::memory_order_acquire);
+	for (uint32_t t = 0; t < threadCount; ++t)
+	{
+		ThreadProfileBuffer* pBuffer = gThreads[t];
+		uint64_t writeIndex = pBuffer->mWriteIndex.load(std::memory_order_acquire);
+		uint64_t first = writeIndex > PROFILER_EVENTS_PER_THREAD ? writeIndex - PROFILER_EVENTS_PER_THREAD : 0;
+
+		// Scopes are recorded when they end, so end times only grow along the ring and everything that
+		// overlaps the window is a suffix of it. Walk back from the newest event until the window start.
+		events.clear();
+		bool reachedWindowStart = false;
+		for (uint64_t i = writeIndex; i > first; --i)
+		{
+			ProfileEvent event = pBuffer->mEvents[(i - 1) & EVENT_INDEX_MASK];
+			if (event.mEndTicks < beginTicks)
+			{
+				reachedWindowStart = true;
+				break;
+			}
+			events.push_back(event);
+		}
+
+		// Anything the owner lapped while we were copying is garbage. The slot at the current write
+		// index may be half written, hence the + 1.
+		std::atomic_thread_fence(std::memory_order_acquire);
+		uint64_t latestIndex = pBuffer->mWriteIndex.load(std::memory_order_relaxed);
+		uint64_t firstIntact = latestIndex >= PROFILER_EVENTS_PER_THREAD ? latestIndex - PROFILER_EVENTS_PER_THREAD + 1 : 0;
+		size_t intactCount = writeIndex > firstIntact ? (size_t)(writeIndex - firstIntact) : 0;
+		if (events.size() > intactCount)
+		{
+			events.resize(intactCount);
+			reachedWindowStart = false;
+		}
+		if (!reachedWindowStart && (first > 0 || firstIntact > 0))
+		{
+			SHEN_CORE_WARN("profiler: {0} recorded more than {1} scopes since the requested window started, the oldest are missing",
+				pBuffer->mName, PROFILER_EVENTS_PER_THREAD);
+		}
+
+		// Back to recording order, dropping scopes that started after the window
+		std::reverse(events.begin(), events.end());
+		uint32_t kept = 0;
+		for (size_t k = 0; k < events.size(); ++k)
+		{
+			if (events[k].mBeginTicks <= endTicks)
+				events[kept++] = events[k];
+		}
+		if (kept)
+			visitor(pUserData, t, events.data(), kept);
+	}
+}
+
+uint32_t profilerGetThreadCount()
+{
+	return gThreadCount.load(std::memory_order_acquire);
+}
+
+const char* profilerGetThreadName(uint32_t threadIndex)
+{
+	return threadIndex < profilerGetThreadCount() ? gThreads[threadIndex]->mName : "";
+}
+
+bool profilerWriteChromeTrace(const char* pFileName, uint64_t beginTicks, uint64_t endTicks, ProfileTraceCallback callback, void* pUserData)
+{
+	FILE* pFile = fopen(pFileName, "w");
+	if (!pFile)
+	{
+		SHEN_CORE_ERROR("profiler: failed to open {0} for writing", pFileName);
+		return false;
+	}
+
+	ProfileTraceWriter writer = { pFile, beginTicks, endTicks, true, 0 };
+	fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", pFile);
+
+	uint32_t threadCount = profilerGetThreadCount();
+	for (uint32_t t = 0; t < threadCount; ++t)
+	{
+		beginTraceEvent(&writer);
+		fprintf(pFile, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":", t);
+		writeJsonString(pFile, gThreads[t]->mName);
+		fputs("}}", pFile);
+	}
+
+	// Frame markers as global instant events
+	uint64_t frameCount = gFrameCount.load(std::memory_order_acquire);
+	uint64_t firstFrame = frameCount > PROFILER_FRAME_HISTORY - 1 ? frameCount - (PROFILER_FRAME_HISTORY - 1) : 0;
+	for (uint64_t frame = firstFrame; frame < frameCount; ++frame)
+	{
+		uint64_t frameStart;
+		if (!profilerGetFrameStartTicks(frame, &frameStart) || frameStart < beginTicks || frameStart > endTicks)
+			continue;
+		beginTraceEvent(&writer);
+		fprintf(pFile, "{\"ph\":\"i\",\"s\":\"g\",\"name\":\"Frame %llu\",\"pid\":0,\"tid\":0,\"ts\":%.3f}",
+			(unsigned long long)frame, profilerTicksToMilliseconds(frameStart - beginTicks) * 1000.0);
+	}
+
+	profilerCollectEvents(beginTicks, endTicks, writeTraceEvents, &writer);
+	if (callback)
+		callback(pUserData, &writer);
+
+	fputs("\n]}\n", pFile);
+	fclose(pFile);
+	SHEN_CORE_INFO("profiler: wrote {0} scopes ({1:.2f} ms) to {2}", writer.mEventCount,
+		profilerTicksToMilliseconds(endTicks - beginTicks), pFileName);
+	return true;
+}
+
+void profilerTraceAddTrack(ProfileTraceWriter* pWriter, uint32_t trackId, const char* pName)
+{
+	beginTraceEvent(pWriter);
+	fprintf(pWriter->pFile, "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":",
+		PROFILER_MAX_THREADS + trackId);
+	writeJsonString(pWriter->pFile, pName);
+	fputs("}}", pWriter->pFile);
+}
+
+void profilerTraceAddScope(ProfileTraceWriter* pWriter, uint32_t trackId, const char* pName, uint64_t beginTicks, uint64_t endTicks)
+{
+	if (endTicks < pWriter->mBeginTicks || beginTicks > pWriter->mEndTicks)
+		return;
+	uint64_t begin = beginTicks > pWriter->mBeginTicks ? beginTicks : pWriter->mBeginTicks;
+	beginTraceEvent(pWriter);
+	fputs("{\"ph\":\"X\",\"cat\":\"track\",\"name\":", pWriter->pFile);
+	writeJsonString(pWriter->pFile, pName);
+	fprintf(pWriter->pFile, ",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", PROFILER_MAX_THREADS + trackId,
+		profilerTicksToMilliseconds(begin - pWriter->mBeginTicks) * 1000.0,
+		profilerTicksToMilliseconds(endTicks - begin) * 1000.0);
+	++pWriter->mEventCount;
+}
+
+void profilerTraceAddCounter(ProfileTraceWriter* pWriter, const char* pName, uint64_t ticks, double value)
+{
+	if (ticks < pWriter->mBeginTicks || ticks > pWriter->mEndTicks)
+		return;
+	beginTraceEvent(pWriter);
+	fputs("{\"ph\":\"C\",\"name\":", pWriter->pFile);
+	writeJsonString(pWriter->pFile, pName);
+	fprintf(pWriter->pFile, ",\"pid\":0,\"ts\":%.3f,\"args\":{\"value\":%.17g}}",
+		profilerTicksToMilliseconds(ticks - pWriter->mBeginTicks) * 1000.0, value);
+}
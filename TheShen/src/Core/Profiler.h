@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// CPU scope profiler. Every thread owns a fixed-size ring of completed scopes that only it writes to,
+// so recording a scope is two clock reads and one release store. Readers (trace capture, the flight
+// recorder) copy events out of the rings and drop whatever the owner overwrote while they were copying.
+// The SHEN_PROFILE_* macros compile out in Distribution builds (SHEN_DIST).
+#ifndef SHEN_DIST
+#define SHEN_ENABLE_PROFILER 1
+#else
+#define SHEN_ENABLE_PROFILER 0
+#endif
+
+// Events kept per thread, must be a power of two
+#define PROFILER_EVENTS_PER_THREAD (1 << 16)
+#define PROFILER_MAX_THREADS 64
+#define PROFILER_MAX_THREAD_NAME 32
+// Frame start times kept for frame markers and capture windows
+#define PROFILER_FRAME_HISTORY 1024
+
+typedef struct ProfileEvent
+{
+	// Must point to storage that outlives the capture, normally a string literal or __FUNCTION__
+	const char* pName;
+	uint64_t    mBeginTicks;
+	uint64_t    mEndTicks;
+} ProfileEvent;
+
+void initProfiler();
+// Frees the thread rings, so every thread that recorded scopes must have been joined by then.
+void exitProfiler();
+
+// Names the calling thread in captured traces. Threads that never call this show up as "Thread N".
+void profilerSetThreadName(const char* pName);
+
+uint64_t profilerGetTicks();
+double   profilerTicksToMilliseconds(uint64_t ticks);
+void     profilerRecordScope(const char* pName, uint64_t beginTicks, uint64_t endTicks);
+
+// Marks the start of a frame. Called once per iteration of Application::Run.
+void     profilerBeginFrame();
+uint64_t profilerGetFrameIndex();
+// Start time of a recent frame, returns false once it has fallen out of the history.
+bool     profilerGetFrameStartTicks(uint64_t frameIndex, uint64_t* pOutTicks);
+
+// Captures the next frameCount frames and writes them to pFileName as Chrome trace JSON
+// (loadable in chrome://tracing and ui.perfetto.dev). Returns false if a capture is already running.
+bool profilerRequestCapture(uint32_t frameCount, const char* pFileName);
+bool profilerIsCapturing();
+
+// Copies out every event overlapping [beginTicks, endTicks], thread by thread.
+typedef void (*ProfileEventVisitor)(void* pUserData, uint32_t threadIndex, const ProfileEvent* pEvents, uint32_t eventCount);
+void        profilerCollectEvents(uint64_t beginTicks, uint64_t endTicks, ProfileEventVisitor visitor, void* pUserData);
+uint32_t    profilerGetThreadCount();
+const char* profilerGetThreadName(uint32_t threadIndex);
+
+// Lets the caller of profilerWriteChromeTrace append its own tracks (GPU timings, counters).
+// Track ids belong to the caller and never collide with profiler threads.
+typedef struct ProfileTraceWriter ProfileTraceWriter;
+typedef void (*ProfileTraceCallback)(void* pUserData, ProfileTraceWriter* pWriter);
+void profilerTraceAddTrack(ProfileTraceWriter* pWriter, uint32_t trackId, const char* pName);
+void profilerTraceAddScope(ProfileTraceWriter* pWriter, uint32_t trackId, const char* pName, uint64_t beginTicks, uint64_t endTicks);
+void profilerTraceAddCounter(ProfileTraceWriter* pWriter, const char* pName, uint64_t ticks, double value);
+
+// Writes the events and frame markers inside [beginTicks, endTicks] as Chrome trace JSON,
+// then calls callback so it can add more events to the same file.
+bool profilerWriteChromeTrace(const char* pFileName, uint64_t beginTicks, uint64_t endTicks,
+	ProfileTraceCallback callback = NULL, void* pUserData = NULL);
+
+class ProfileScope
+{
+public:
+	explicit ProfileScope(const char* pName)
+		: pName(pName), mBeginTicks(profilerGetTicks())
+	{
+	}
+	~ProfileScope() { profilerRecordScope(pName, mBeginTicks, profilerGetTicks()); }
+
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	const char* pName;
+	uint64_t    mBeginTicks;
+};
+
+#if SHEN_ENABLE_PROFILER
+#define SHEN_PROFILE_CONCAT_INNER(a, b) a##b
+#define SHEN_PROFILE_CONCAT(a, b) SHEN_PROFILE_CONCAT_INNER(a, b)
+#define SHEN_PROFILE_SCOPE(name) ::ProfileScope SHEN_PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define SHEN_PROFILE_FUNCTION() SHEN_PROFILE_SCOPE(__FUNCTION__)
+#define SHEN_PROFILE_FRAME() ::profilerBeginFrame()
+#define SHEN_PROFILE_THREAD(name) ::profilerSetThreadName(name)
+#else
+#define SHEN_PROFILE_SCOPE(name)
+#define SHEN_PROFILE_FUNCTION()
+#define SHEN_PROFILE_FRAME()
+#define SHEN_PROFILE_THREAD(name)
+#endif
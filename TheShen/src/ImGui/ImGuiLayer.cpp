@@ -5,6 +5,7 @@
 #include "imgui.h"
 #include "example/imgui_impl_glfw.h"
 #include "example/imgui_impl_vulkan.h"
+#include "UI.h"
 
 ImGuiLayer::ImGuiLayer()
 	: Layer("ImGuiLayer")
@@ -31,11 +32,11 @@ void ImGuiLayer::OnEvent(Event& e)
 
 void ImGuiLayer::Begin()
 {
-
+	beginUserInterfaceFrame();
 }
 
 void ImGuiLayer::End()
 {
-
+	endUserInterfaceFrame();
 }
 
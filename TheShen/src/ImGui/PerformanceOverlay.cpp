@@ -0,0 +1,310 @@
+#include "PerformanceOverlay.h"
+
+#include "imgui.h"
+#include "UI.h"
+#include "Renderer/Renderer.h"
+#include "Renderer/GpuProfiler.h"
+#include "Core/Memory.h"
+#include "Core/Profiler.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	// 同名区间按线程合并后的耗时
+	struct CpuScopeStat
+	{
+		const char* pName;
+		uint32_t    mThreadIndex;
+		uint32_t    mCalls;
+		double      mMilliseconds;
+	};
+
+	typedef std::vector<CpuScopeStat, CategoryAllocator<CpuScopeStat, MEMORY_CATEGORY_UI>> CpuScopeStatList;
+
+	void accumulateCpuScopes(void* pUserData, uint32_t threadIndex, const ProfileEvent* pEvents, uint32_t eventCount)
+	{
+		CpuScopeStatList* pStats = (CpuScopeStatList*)pUserData;
+		for (uint32_t i = 0; i < eventCount; ++i)
+		{
+			const ProfileEvent* pEvent = &pEvents[i];
+			CpuScopeStat* pStat = NULL;
+			for (CpuScopeStat& stat : *pStats)
+			{
+				if (stat.mThreadIndex == threadIndex && (stat.pName == pEvent->pName || strcmp(stat.pName, pEvent->pName) == 0))
+				{
+					pStat = &stat;
+					break;
+				}
+			}
+			if (!pStat)
+			{
+				pStats->push_back({ pEvent->pName, threadIndex, 0, 0.0 });
+				pStat = &pStats->back();
+			}
+			++pStat->mCalls;
+			pStat->mMilliseconds += profilerTicksToMilliseconds(pEvent->mEndTicks - pEvent->mBeginTicks);
+		}
+	}
+
+	float percentile(const float* pSorted, uint32_t count, float p)
+	{
+		uint32_t index = (uint32_t)(p * (float)(count - 1) + 0.5f);
+		return pSorted[index < count ? index : count - 1];
+	}
+}
+
+PerformanceOverlay::PerformanceOverlay()
+	: Layer("PerformanceOverlay")
+{
+}
+
+void PerformanceOverlay::OnUpdate(Timestep ts)
+{
+	m_FrameTimes[m_FrameTimeOffset] = (float)ts * 1000.0f;
+	m_FrameTimeOffset = (m_FrameTimeOffset + 1) % FRAME_HISTORY;
+	if (m_FrameTimeCount < FRAME_HISTORY)
+		++m_FrameTimeCount;
+}
+
+void PerformanceOverlay::OnEvent(Event& e)
+{
+	EventDispatcher dispatcher(e);
+	dispatcher.Dispatch<KeyPressedEvent>(SHEN_BIND_EVENT_FN(PerformanceOverlay::OnKeyPressed));
+}
+
+bool PerformanceOverlay::OnKeyPressed(KeyPressedEvent& e)
+{
+	if (e.GetKeyCode() != TOGGLE_KEY || e.GetRepeatCount() > 0)
+		return false;
+	m_Visible = !m_Visible;
+	return true;
+}
+
+void PerformanceOverlay::OnImGuiRender()
+{
+	if (!m_Visible)
+		return;
+
+	SHEN_PROFILE_FUNCTION();
+	ImGui::SetNextWindowSize(ImVec2(480.0f, 640.0f), ImGuiCond_FirstUseEver);
+	if (ImGui::Begin("Performance (F3)", &m_Visible))
+	{
+		DrawFrameTimes();
+		if (ImGui::CollapsingHeader("CPU", ImGuiTreeNodeFlags_DefaultOpen))
+			DrawCpuBreakdown();
+		if (ImGui::CollapsingHeader("GPU", ImGuiTreeNodeFlags_DefaultOpen))
+			DrawGpuBreakdown();
+		if (ImGui::CollapsingHeader("Renderer", ImGuiTreeNodeFlags_DefaultOpen))
+			DrawRendererCounters();
+		if (ImGui::CollapsingHeader("Memory"))
+			DrawMemory();
+	}
+	ImGui::End();
+}
+
+/// <summary>
+/// 帧时间曲线, 分位数与直方图
+/// </summary>
+void PerformanceOverlay::DrawFrameTimes()
+{
+	if (m_FrameTimeCount == 0)
+		return;
+
+	// 环形缓冲按时间顺序展开
+	uint32_t first = m_FrameTimeCount < FRAME_HISTORY ? 0 : m_FrameTimeOffset;
+	for (uint32_t i = 0; i < m_FrameTimeCount; ++i)
+		m_SortedFrameTimes[i] = m_FrameTimes[(first + i) % FRAME_HISTORY];
+	std::sort(m_SortedFrameTimes, m_SortedFrameTimes + m_FrameTimeCount);
+
+	float p50 = percentile(m_SortedFrameTimes, m_FrameTimeCount, 0.50f);
+	float p95 = percentile(m_SortedFrameTimes, m_FrameTimeCount, 0.95f);
+	float p99 = percentile(m_SortedFrameTimes, m_FrameTimeCount, 0.99f);
+	float maxTime = m_SortedFrameTimes[m_FrameTimeCount - 1];
+
+	ImGui::Text("%.1f FPS  (%u frames)", p50 > 0.0f ? 1000.0f / p50 : 0.0f, m_FrameTimeCount);
+	ImGui::Text("p50 %.2f ms  p95 %.2f ms  p99 %.2f ms  max %.2f ms", p50, p95, p99, maxTime);
+
+	float graphMax = std::max(p99 * 1.5f, 1.0f);
+	ImGui::PlotLines("##FrameTimes", m_FrameTimes, (int)m_FrameTimeCount, (int)first, "frame time (ms)",
+		0.0f, graphMax, ImVec2(-1.0f, 80.0f));
+
+	// 直方图覆盖 [0, max(p99 * 1.5)], 超出部分计入最后一个桶
+	memset(m_Histogram, 0, sizeof(m_Histogram));
+	float bucketWidth = graphMax / (float)HISTOGRAM_BUCKETS;
+	for (uint32_t i = 0; i < m_FrameTimeCount; ++i)
+	{
+		uint32_t bucket = (uint32_t)(m_SortedFrameTimes[i] / bucketWidth);
+		m_Histogram[bucket < HISTOGRAM_BUCKETS ? bucket : HISTOGRAM_BUCKETS - 1] += 1.0f;
+	}
+	char label[64];
+	snprintf(label, sizeof(label), "0 - %.1f ms", graphMax);
+	ImGui::PlotHistogram("##FrameTimeHistogram", m_Histogram, (int)HISTOGRAM_BUCKETS, 0, label,
+		0.0f, FLT_MAX, ImVec2(-1.0f, 60.0f));
+}
+
+/// <summary>
+/// CPU 区间耗时, 取最近 CPU_AVERAGE_FRAMES 帧的平均
+/// </summary>
+void PerformanceOverlay::DrawCpuBreakdown()
+{
+#if SHEN_ENABLE_PROFILER
+	uint64_t currentFrame = profilerGetFrameIndex();
+	uint64_t frameCount = std::min<uint64_t>(CPU_AVERAGE_FRAMES, currentFrame);
+	uint64_t beginTicks, endTicks;
+	if (frameCount == 0 ||
+		!profilerGetFrameStartTicks(currentFrame - frameCount, &beginTicks) ||
+		!profilerGetFrameStartTicks(currentFrame, &endTicks))
+	{
+		ImGui::TextDisabled("no completed frames yet");
+		return;
+	}
+
+	CpuScopeStatList stats;
+	profilerCollectEvents(beginTicks, endTicks, accumulateCpuScopes, &stats);
+	std::sort(stats.begin(), stats.end(), [](const CpuScopeStat& a, const CpuScopeStat& b) {
+		return a.mThreadIndex != b.mThreadIndex ? a.mThreadIndex < b.mThreadIndex : a.mMilliseconds > b.mMilliseconds;
+	});
+
+	if (ImGui::BeginTable("CpuScopes", 4, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp | ImGuiTableFlags_ScrollY,
+		ImVec2(0.0f, 200.0f)))
+	{
+		ImGui::TableSetupScrollFreeze(0, 1);
+		ImGui::TableSetupColumn("Thread");
+		ImGui::TableSetupColumn("Scope");
+		ImGui::TableSetupColumn("Calls/frame");
+		ImGui::TableSetupColumn("ms/frame");
+		ImGui::TableHeadersRow();
+		for (const CpuScopeStat& stat : stats)
+		{
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn(); ImGui::TextUnformatted(profilerGetThreadName(stat.mThreadIndex));
+			ImGui::TableNextColumn(); ImGui::TextUnformatted(stat.pName);
+			ImGui::TableNextColumn(); ImGui::Text("%.1f", (double)stat.mCalls / (double)frameCount);
+			ImGui::TableNextColumn(); ImGui::Text("%.3f", stat.mMilliseconds / (double)frameCount);
+		}
+		ImGui::EndTable();
+	}
+
+	if (profilerIsCapturing())
+	{
+		ImGui::TextDisabled("capturing...");
+	}
+	else if (ImGui::Button("Capture 60 frames"))
+	{
+		char fileName[64];
+		snprintf(fileName, sizeof(fileName), "shen_capture_%llu.json", (unsigned long long)currentFrame);
+		profilerRequestCapture(60, fileName);
+	}
+#else
+	ImGui::TextDisabled("CPU profiling is compiled out in this build");
+#endif
+}
+
+/// <summary>
+/// GPU 区间耗时, 来自 UI 所用图形队列的时间戳查询
+/// </summary>
+void PerformanceOverlay::DrawGpuBreakdown()
+{
+	Queue* pQueue = getUserInterfaceQueue();
+	GpuProfileResults results = {};
+	if (!pQueue || !getGpuProfileResults(pQueue, &results))
+	{
+		ImGui::TextDisabled("GPU profiler is not enabled on the graphics queue");
+		return;
+	}
+	if (results.mTimerCount == 0)
+	{
+		ImGui::TextDisabled("waiting for GPU results");
+		return;
+	}
+
+	if (ImGui::BeginTable("GpuScopes", 2, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp))
+	{
+		ImGui::TableSetupColumn("Scope");
+		ImGui::TableSetupColumn("ms");
+		ImGui::TableHeadersRow();
+		for (uint32_t i = 0; i < results.mTimerCount; ++i)
+		{
+			const GpuTimerResult* pTimer = &results.pTimers[i];
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn(); ImGui::Text("%*s%s", (int)pTimer->mDepth * 2, "", pTimer->mName);
+			ImGui::TableNextColumn(); ImGui::Text("%.3f", pTimer->mMilliseconds);
+		}
+		ImGui::EndTable();
+	}
+}
+
+/// <summary>
+/// 上一帧的渲染统计
+/// </summary>
+void PerformanceOverlay::DrawRendererCounters()
+{
+	Renderer* pRenderer = getUserInterfaceRenderer();
+	if (!pRenderer)
+	{
+		ImGui::TextDisabled("renderer not initialized");
+		return;
+	}
+
+	RendererStats stats;
+	getRendererStats(pRenderer, &stats);
+	ImGui::Text("Draw calls:       %llu", (unsigned long long)stats.mDrawCalls);
+	ImGui::Text("Dispatch calls:   %llu", (unsigned long long)stats.mDispatchCalls);
+	ImGui::Text("Vertices:         %llu", (unsigned long long)stats.mVertices);
+	ImGui::Text("Instances:        %llu", (unsigned long long)stats.mInstances);
+	ImGui::Text("Pipeline binds:   %llu", (unsigned long long)stats.mPipelineBinds);
+	ImGui::Text("Descriptor binds: %llu", (unsigned long long)stats.mDescriptorBinds);
+	ImGui::Text("Buffer binds:     %llu", (unsigned long long)stats.mBufferBinds);
+	ImGui::Text("Barriers:         %llu", (unsigned long long)stats.mBarriers);
+	ImGui::Text("Render passes:    %llu", (unsigned long long)stats.mRenderPasses);
+	ImGui::Text("Queue submits:    %llu", (unsigned long long)stats.mQueueSubmits);
+	ImGui::Text("Descriptor sets:  %llu", (unsigned long long)stats.mDescriptorSetsAllocated);
+	ImGui::Text("Uploaded:         %.1f KB", stats.mBytesUploaded / 1024.0);
+}
+
+/// <summary>
+/// 各分类内存统计
+/// </summary>
+void PerformanceOverlay::DrawMemory()
+{
+	if (ImGui::BeginTable("MemoryStats", 5, ImGuiTableFlags_Borders | ImGuiTableFlags_RowBg | ImGuiTableFlags_SizingStretchProp))
+	{
+		ImGui::TableSetupColumn("Category");
+		ImGui::TableSetupColumn("Live (KB)");
+		ImGui::TableSetupColumn("Peak (KB)");
+		ImGui::TableSetupColumn("Allocs/s");
+		ImGui::TableSetupColumn("KB/s");
+		ImGui::TableHeadersRow();
+
+		MemoryCategoryStats total = {};
+		for (uint32_t i = 0; i < MEMORY_CATEGORY_COUNT; ++i)
+		{
+			MemoryCategoryStats stats;
+			getMemoryStats((MemoryCategory)i, &stats);
+			total.mLiveBytes += stats.mLiveBytes;
+			total.mPeakBytes += stats.mPeakBytes;
+			total.mAllocationsPerSecond += stats.mAllocationsPerSecond;
+			total.mBytesPerSecond += stats.mBytesPerSecond;
+
+			ImGui::TableNextRow();
+			ImGui::TableNextColumn(); ImGui::TextUnformatted(getMemoryCategoryName((MemoryCategory)i));
+			ImGui::TableNextColumn(); ImGui::Text("%.1f", stats.mLiveBytes / 1024.0);
+			ImGui::TableNextColumn(); ImGui::Text("%.1f", stats.mPeakBytes / 1024.0);
+			ImGui::TableNextColumn(); ImGui::Text("%.0f", stats.mAllocationsPerSecond);
+			ImGui::TableNextColumn(); ImGui::Text("%.1f", stats.mBytesPerSecond / 1024.0f);
+		}
+
+		ImGui::TableNextRow();
+		ImGui::TableNextColumn(); ImGui::TextUnformatted("Total");
+		ImGui::TableNextColumn(); ImGui::Text("%.1f", total.mLiveBytes / 1024.0);
+		ImGui::TableNextColumn(); ImGui::Text("%.1f", total.mPeakBytes / 1024.0);
+		ImGui::TableNextColumn(); ImGui::Text("%.0f", total.mAllocationsPerSecond);
+		ImGui::TableNextColumn(); ImGui::Text("%.1f", total.mBytesPerSecond / 1024.0f);
+		ImGui::EndTable();
+	}
+}
@@ -0,0 +1,46 @@
+#pragma once
+#include "Core/Layer.h"
+#include "Events/KeyEvent.h"
+
+/// <summary>
+/// 性能面板: 帧时间曲线与直方图, CPU/GPU 分段耗时, 渲染统计与内存统计
+/// 默认隐藏, 按 F3 切换; 隐藏时每帧只记录一次帧时间
+/// </summary>
+class PerformanceOverlay : public Layer
+{
+public:
+	PerformanceOverlay();
+	~PerformanceOverlay() = default;
+
+	virtual void OnUpdate(Timestep ts) override;
+	virtual void OnImGuiRender() override;
+	virtual void OnEvent(Event& e) override;
+
+	void SetVisible(bool visible) { m_Visible = visible; }
+	bool IsVisible() const { return m_Visible; }
+
+	static const KeyCode TOGGLE_KEY = KEY_F3;
+
+private:
+	bool OnKeyPressed(KeyPressedEvent& e);
+
+	void DrawFrameTimes();
+	void DrawCpuBreakdown();
+	void DrawGpuBreakdown();
+	void DrawRendererCounters();
+	void DrawMemory();
+
+private:
+	static const uint32_t FRAME_HISTORY = 512;
+	static const uint32_t HISTOGRAM_BUCKETS = 48;
+	// CPU 分段耗时取最近若干帧的平均值, 避免数值跳动
+	static const uint32_t CPU_AVERAGE_FRAMES = 30;
+
+	bool m_Visible = false;
+
+	float m_FrameTimes[FRAME_HISTORY] = {};
+	float m_SortedFrameTimes[FRAME_HISTORY] = {};
+	float m_Histogram[HISTOGRAM_BUCKETS] = {};
+	uint32_t m_FrameTimeCount = 0;
+	uint32_t m_FrameTimeOffset = 0;
+};
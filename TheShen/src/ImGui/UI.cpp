@@ -3,6 +3,8 @@
 #include "UI.h"
 #include "Renderer/Renderer.h"
 #include "Core/Log.h"
+#include "Core/Memory.h"
+#include "Core/Profiler.h"
 #include "Core/Application.h"
 
 typedef struct UserInterface
@@ -11,15 +13,28 @@ typedef struct UserInterface
 	Queue* pGraphicsQueue = NULL;
 	SwapChain* pSwapChain = NULL;
 	CmdPool* pCmdPool = NULL;
+	bool mFrameActive = false;
+	// 无交换链 (离屏渲染) 时不接入 glfw, 显示尺寸固定
+	bool mHeadless = false;
+	uint32_t mWidth = 0;
+	uint32_t mHeight = 0;
 } UserInterface;
 
 static UserInterface* pUserInterface = NULL;
 
 VkDescriptorPool m_ImGuiDescriptorPool;
-VkRenderPass m_ImGuiRenderPass;
-std::vector<VkFramebuffer> m_ImGuiFramebuffers;
 
 
+static void* imguiAlloc(size_t size, void* pUserData)
+{
+	return shen_malloc(MEMORY_CATEGORY_UI, size);
+}
+
+static void imguiFree(void* ptr, void* pUserData)
+{
+	shen_free(ptr);
+}
+
 void createImGuiDescriptorPool()
 {
 	VkDescriptorPoolSize pool_sizes[] =
@@ -42,7 +57,7 @@ void createImGuiDescriptorPool()
 	pool_info.maxSets = 1000 * IM_ARRAYSIZE(pool_sizes);
 	pool_info.poolSizeCount = (uint32_t)IM_ARRAYSIZE(pool_sizes);
 	pool_info.pPoolSizes = pool_sizes;
-	if (vkCreateDescriptorPool(pUserInterface->pRenderer->pVkDevice, &pool_info, nullptr, &m_ImGuiDescriptorPool) != VK_SUCCESS)
+	if (pUserInterface->pRenderer->mVkDeviceTable.vkCreateDescriptorPool(pUserInterface->pRenderer->pVkDevice, &pool_info, pUserInterface->pRenderer->pVkAllocator, &m_ImGuiDescriptorPool) != VK_SUCCESS)
 	{
 		SHEN_CORE_ERROR("Create DescriptorPool for m_ImGuiDescriptorPool failed!");
 		throw std::runtime_error("Create DescriptorPool for m_ImGuiDescriptorPool failed!");
@@ -62,48 +77,6 @@ void createCommandPool()
 	//}
 }
 
-void createImGuiRenderPass()
-{
-	VkAttachmentDescription attachment = {};
-	attachment.format = VK_FORMAT_B8G8R8A8_UNORM;
-	attachment.samples = VK_SAMPLE_COUNT_1_BIT;
-	attachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
-	attachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-	attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-	attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	attachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	attachment.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-	VkAttachmentReference color_attachment = {};
-	color_attachment.attachment = 0;
-	color_attachment.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-	VkSubpassDescription subpass = {};
-	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-	subpass.colorAttachmentCount = 1;
-	subpass.pColorAttachments = &color_attachment;
-
-	VkSubpassDependency dependency = {};
-	dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
-	dependency.dstSubpass = 0;
-	dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	dependency.srcAccessMask = 0; // or VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-
-	VkRenderPassCreateInfo info = {};
-	info.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-	info.attachmentCount = 1;
-	info.pAttachments = &attachment;
-	info.subpassCount = 1;
-	info.pSubpasses = &subpass;
-	info.dependencyCount = 1;
-	info.pDependencies = &dependency;
-
-	if (vkCreateRenderPass(pUserInterface->pRenderer->pVkDevice, &info, nullptr, &m_ImGuiRenderPass) != VK_SUCCESS)
-		throw std::runtime_error("failed to create render pass!");
-}
-
 VkCommandBuffer beginSingleTimeCommands(const VkCommandPool& cmdPool) {
 	VkCommandBufferAllocateInfo allocInfo{};
 	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -112,63 +85,45 @@ VkCommandBuffer beginSingleTimeCommands(const VkCommandPool& cmdPool) {
 	allocInfo.commandBufferCount = 1;
 
 	VkCommandBuffer commandBuffer;
-	vkAllocateCommandBuffers(pUserInterface->pRenderer->pVkDevice, &allocInfo, &commandBuffer);
+	pUserInterface->pRenderer->mVkDeviceTable.vkAllocateCommandBuffers(pUserInterface->pRenderer->pVkDevice, &allocInfo, &commandBuffer);
 
 	VkCommandBufferBeginInfo beginInfo{};
 	beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 	beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 
-	vkBeginCommandBuffer(commandBuffer, &beginInfo);
+	pUserInterface->pRenderer->mVkDeviceTable.vkBeginCommandBuffer(commandBuffer, &beginInfo);
 
 	return commandBuffer;
 }
 
 void endSingleTimeCommands(VkCommandBuffer commandBuffer, const VkCommandPool& cmdPool) {
-	vkEndCommandBuffer(commandBuffer);
+	pUserInterface->pRenderer->mVkDeviceTable.vkEndCommandBuffer(commandBuffer);
 
 	VkSubmitInfo submitInfo{};
 	submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
 	submitInfo.commandBufferCount = 1;
 	submitInfo.pCommandBuffers = &commandBuffer;
 
-	vkQueueSubmit(pUserInterface->pGraphicsQueue->pVkQueue, 1, &submitInfo, VK_NULL_HANDLE);
-	vkQueueWaitIdle(pUserInterface->pGraphicsQueue->pVkQueue);
+	pUserInterface->pGraphicsQueue->pVkDeviceTable->vkQueueSubmit(pUserInterface->pGraphicsQueue->pVkQueue, 1, &submitInfo, VK_NULL_HANDLE);
+	pUserInterface->pGraphicsQueue->pVkDeviceTable->vkQueueWaitIdle(pUserInterface->pGraphicsQueue->pVkQueue);
 
-	vkFreeCommandBuffers(pUserInterface->pRenderer->pVkDevice, cmdPool, 1, &commandBuffer);
+	pUserInterface->pRenderer->mVkDeviceTable.vkFreeCommandBuffers(pUserInterface->pRenderer->pVkDevice, cmdPool, 1, &commandBuffer);
 }
 
-void createImGuiCommandBuffers(std::vector<Texture> pTextures)
+/// <summary>
+/// ImGui 后端函数加载: 设备级函数取自 vkGetDeviceProcAddr, 其余回退到实例
+/// </summary>
+static PFN_vkVoidFunction loadImGuiVulkanFunction(const char* pFunctionName, void* pUserData)
 {
-	std::vector<VkImageView> swapChainImageViews;
-	swapChainImageViews.resize(pTextures.size());
-	for (size_t i = 0; i < pTextures.size(); i++)
-	{
-		swapChainImageViews[i] = pTextures[i].pVkSRVDescriptor;
-	}
-	m_ImGuiFramebuffers.resize(swapChainImageViews.size());
-
-	VkImageView attachment[1];
-	VkFramebufferCreateInfo info = {};
-	info.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-	info.renderPass = m_ImGuiRenderPass;
-	info.attachmentCount = 1;
-	info.pAttachments = attachment;
-	info.width = pUserInterface->pSwapChain->pDesc->mWidth;
-	info.height = pUserInterface->pSwapChain->pDesc->mHeight;
-	info.layers = 1;
-	for (uint32_t i = 0; i < swapChainImageViews.size(); i++)
-	{
-		attachment[0] = swapChainImageViews[i];
-		if (vkCreateFramebuffer(pUserInterface->pRenderer->pVkDevice, &info, nullptr, &m_ImGuiFramebuffers[i]) != VK_SUCCESS)
-		{
-			throw std::runtime_error("failed to create framebuffer!");
-		}
-	}
+	Renderer* pRenderer = (Renderer*)pUserData;
+	PFN_vkVoidFunction pFunction = vkGetDeviceProcAddr(pRenderer->pVkDevice, pFunctionName);
+	if (!pFunction)
+		pFunction = vkGetInstanceProcAddr(pRenderer->pVkInstance, pFunctionName);
+	return pFunction;
 }
 
-
 /// <summary>
-///	ʼûӿ
+///	初始化用户接口
 /// </summary>
 /// <param name="pDesc"></param>
 void initUserInterface(UserInterfaceDesc* pDesc)
@@ -181,9 +136,27 @@ void initUserInterface(UserInterfaceDesc* pDesc)
 	createImGuiDescriptorPool();
 
 	createCommandPool();
-	createImGuiRenderPass();
 
-	ImGui_ImplGlfw_InitForVulkan((GLFWwindow*)(Application::Get().GetNativeWindow()), true);
+	if (!ImGui_ImplVulkan_LoadFunctions(loadImGuiVulkanFunction, pUserInterface->pRenderer))
+	{
+		SHEN_CORE_ERROR("failed to load Vulkan functions for ImGui!");
+		throw std::runtime_error("failed to load Vulkan functions for ImGui!");
+	}
+
+	pUserInterface->mHeadless = pUserInterface->pSwapChain == NULL;
+	if (pUserInterface->mHeadless)
+	{
+		// 没有平台窗口, 关闭多视口, 也不写 imgui.ini
+		ImGuiIO& io = ImGui::GetIO();
+		io.ConfigFlags &= ~ImGuiConfigFlags_ViewportsEnable;
+		io.IniFilename = NULL;
+		pUserInterface->mWidth = pDesc->mWidth;
+		pUserInterface->mHeight = pDesc->mHeight;
+	}
+	else
+	{
+		ImGui_ImplGlfw_InitForVulkan((GLFWwindow*)(Application::Get().GetNativeWindow()), true);
+	}
 	ImGui_ImplVulkan_InitInfo init_info = {};
 	init_info.Instance = pUserInterface->pRenderer->pVkInstance;
 	init_info.PhysicalDevice = pUserInterface->pRenderer->pVkActiveGPU;
@@ -196,9 +169,11 @@ void initUserInterface(UserInterfaceDesc* pDesc)
 	init_info.MinImageCount = 2;
 	init_info.ImageCount = 2;
 	init_info.MSAASamples = VK_SAMPLE_COUNT_1_BIT;
-	init_info.Allocator = nullptr;
+	init_info.Allocator = pUserInterface->pRenderer->pVkAllocator;
 	init_info.CheckVkResultFn = nullptr;
-	ImGui_ImplVulkan_Init(&init_info, m_ImGuiRenderPass);
+	// 1.87 的 ImGui 后端只能基于 VkRenderPass 创建管线, 使用与交换链格式兼容的缓存渲染通道
+	VkFormat colorFormat = pUserInterface->mHeadless ? pDesc->mColorFormat : pUserInterface->pSwapChain->pDesc->mImageFormat;
+	ImGui_ImplVulkan_Init(&init_info, getCompatibleRenderPass(pUserInterface->pRenderer, 1, &colorFormat));
 
 	 //Upload Fonts
 	{
@@ -206,68 +181,135 @@ void initUserInterface(UserInterfaceDesc* pDesc)
 		ImGui_ImplVulkan_CreateFontsTexture(commandBuffer);
 		endSingleTimeCommands(commandBuffer, pUserInterface->pCmdPool->pVkCmdPool);
 		ImGui_ImplVulkan_DestroyFontUploadObjects();
+
+		// 字体图集以 RGBA32 上传, 后端为其分配一个描述符集
+		unsigned char* pPixels;
+		int width, height;
+		ImGui::GetIO().Fonts->GetTexDataAsRGBA32(&pPixels, &width, &height);
+		RENDERER_STATS_ADD(pUserInterface->pRenderer, mBytesUploaded, (size_t)width * height * 4);
+		RENDERER_STATS_ADD(pUserInterface->pRenderer, mDescriptorSetsAllocated, 1);
+		RENDERER_STATS_ADD(pUserInterface->pRenderer, mQueueSubmits, 1);
 	}
 }
 
 /// <summary>
-/// ûӿڻ
+/// 开始 UI 帧, 由 ImGuiLayer::Begin 调用; 之后各层在 OnImGuiRender 中提交窗口
 /// </summary>
-/// <param name="pCmd"></param>
-void cmdDrawUserInterface(void* /* Cmd* */ pCmd, uint32_t imageIndex, uint32_t currentFrame, VkFence fence)
+void beginUserInterfaceFrame()
 {
-	Cmd* cmd = (Cmd*)pCmd;
+	if (!pUserInterface || !pUserInterface->pRenderer)
+		return;
 
+	SHEN_PROFILE_FUNCTION();
 	ImGui_ImplVulkan_NewFrame();
-	ImGui_ImplGlfw_NewFrame();
-
+	if (pUserInterface->mHeadless)
+	{
+		// 无窗口时按固定帧率推进, 结果与实际耗时无关
+		ImGuiIO& io = ImGui::GetIO();
+		io.DisplaySize = ImVec2((float)pUserInterface->mWidth, (float)pUserInterface->mHeight);
+		io.DeltaTime = 1.0f / 60.0f;
+	}
+	else
+	{
+		ImGui_ImplGlfw_NewFrame();
+	}
 	ImGui::NewFrame();
+	pUserInterface->mFrameActive = true;
+}
 
-	static bool show_demo_window = true;
-	ImGui::ShowDemoWindow(&show_demo_window);
-
-	ImGui::Begin("Viewport");
-
-	ImGui::Text("Test");
-
-	ImGui::End();
+/// <summary>
+/// 结束 UI 帧并生成绘制数据, 由 ImGuiLayer::End 调用
+/// </summary>
+void endUserInterfaceFrame()
+{
+	if (!pUserInterface || !pUserInterface->mFrameActive)
+		return;
 
-	ImGuiIO& io = ImGui::GetIO();
+	SHEN_PROFILE_FUNCTION();
 	ImGui::Render();
+	ImGuiIO& io = ImGui::GetIO();
 	if (io.ConfigFlags & ImGuiConfigFlags_ViewportsEnable)
 	{
+		SHEN_PROFILE_SCOPE("ImGui::RenderPlatformWindows");
 		ImGui::UpdatePlatformWindows();
 		ImGui::RenderPlatformWindowsDefault();
 	}
+	pUserInterface->mFrameActive = false;
+}
+
+/// <summary>
+/// ImGui 后端直接录制 Vulkan 指令, 按其录制方式补记渲染统计:
+/// 每帧上传一次顶点/索引数据, 绑定一次管线与缓冲, 每个绘制命令绑定纹理描述符集后做一次索引绘制
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pDrawData"></param>
+static void countUserInterfaceDrawData(Renderer* pRenderer, const ImDrawData* pDrawData)
+{
+	uint64_t drawCount = 0;
+	for (int i = 0; i < pDrawData->CmdListsCount; ++i)
+	{
+		const ImDrawList* pCmdList = pDrawData->CmdLists[i];
+		for (int j = 0; j < pCmdList->CmdBuffer.Size; ++j)
+		{
+			if (pCmdList->CmdBuffer[j].UserCallback == NULL)
+				++drawCount;
+		}
+	}
+	RENDERER_STATS_ADD(pRenderer, mDrawCalls, drawCount);
+	RENDERER_STATS_ADD(pRenderer, mInstances, drawCount);
+	RENDERER_STATS_ADD(pRenderer, mVertices, pDrawData->TotalIdxCount);
+	RENDERER_STATS_ADD(pRenderer, mDescriptorBinds, drawCount);
+	RENDERER_STATS_ADD(pRenderer, mPipelineBinds, 1);
+	RENDERER_STATS_ADD(pRenderer, mBufferBinds, 2);
+	RENDERER_STATS_ADD(pRenderer, mBytesUploaded,
+		(uint64_t)pDrawData->TotalVtxCount * sizeof(ImDrawVert) + (uint64_t)pDrawData->TotalIdxCount * sizeof(ImDrawIdx));
+}
 
-	// vkResetCommandPool(m_Device, m_ImGuiCommandPool, 0);
-	//VkCommandBufferBeginInfo info = {};
-	//info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-	//info.flags |= VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-	//vkBeginCommandBuffer(cmd->pVkCmdBuf, &info);
-
-	VkRenderPassBeginInfo renderPassInfo = {};
-	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-	renderPassInfo.renderPass = m_ImGuiRenderPass;
-	renderPassInfo.framebuffer = m_ImGuiFramebuffers[imageIndex];
-	renderPassInfo.renderArea.offset = { 0, 0 };
-	renderPassInfo.renderArea.extent = pUserInterface->pSwapChain->pDesc->mExtend2D;
-	VkClearValue clearColor = { 0.0f, 0.0f, 0.0f, 1.0f };
-	renderPassInfo.clearValueCount = 1;
-	renderPassInfo.pClearValues = &clearColor;
-	vkCmdBeginRenderPass(cmd->pVkCmdBuf, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+/// <summary>
+/// 用户接口绘制, 录制 endUserInterfaceFrame 生成的绘制数据
+/// </summary>
+/// <param name="pCmd"></param>
+void cmdDrawUserInterface(void* /* Cmd* */ pCmd, Texture* pRenderTarget)
+{
+	SHEN_PROFILE_FUNCTION();
+	Cmd* cmd = (Cmd*)pCmd;
+	ImDrawData* pDrawData = ImGui::GetDrawData();
+	if (!pDrawData || pDrawData->CmdListsCount == 0)
+		return;
+
+	// UI 叠加在场景之上, 保留渲染目标原有内容
+	RenderingDesc renderingDesc = {};
+	renderingDesc.mColorAttachmentCount = 1;
+	renderingDesc.mColorAttachments[0].pTexture = pRenderTarget;
+	renderingDesc.mColorAttachments[0].mLoadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	renderingDesc.mColorAttachments[0].mStoreOp = VK_ATTACHMENT_STORE_OP_STORE;
+	renderingDesc.mUseRenderPass = true;
+	cmdBeginRendering(cmd, &renderingDesc);
 	// Record dear imgui primitives into command buffer
-	ImGui_ImplVulkan_RenderDrawData(ImGui::GetDrawData(), cmd->pVkCmdBuf);
-	//vkCmdEndRenderPass(cmd->pVkCmdBuf);
-	//vkEndCommandBuffer(cmd->pVkCmdBuf);
-	/*cmd->pVkCmdBuf = m_ImGuiCommandBuffers[currentFrame];*/
-	//cmd->pVkActiveRenderPass = m_ImGuiRenderPass;
+	{
+		SHEN_PROFILE_SCOPE("ImGui_ImplVulkan_RenderDrawData");
+		ImGui_ImplVulkan_RenderDrawData(pDrawData, cmd->pVkCmdBuf);
+	}
+	cmdEndRendering(cmd);
+	countUserInterfaceDrawData(cmd->pRenderer, pDrawData);
+}
+
+Renderer* getUserInterfaceRenderer()
+{
+	return pUserInterface ? pUserInterface->pRenderer : NULL;
+}
+
+Queue* getUserInterfaceQueue()
+{
+	return pUserInterface ? pUserInterface->pGraphicsQueue : NULL;
 }
 
 bool platformInitUserInterface()
 {
-	UserInterface* pAppUI = (UserInterface*)malloc(sizeof(UserInterface));
+	UserInterface* pAppUI = (UserInterface*)shen_calloc(MEMORY_CATEGORY_UI, 1, sizeof(UserInterface));
 
 	IMGUI_CHECKVERSION();
+	ImGui::SetAllocatorFunctions(imguiAlloc, imguiFree, NULL);
 	ImGui::CreateContext();
 
 	ImGuiIO& io = ImGui::GetIO();
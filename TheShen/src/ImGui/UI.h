@@ -9,11 +9,25 @@ struct UserInterfaceDesc
 	void* pGraphicsQueue = NULL;
 	void* pSwapChain = NULL;
 	void* pCmdPool = NULL;
+	//Used when pSwapChain is NULL (headless): format and size of the render target the UI is drawn into;
+	VkFormat mColorFormat = VK_FORMAT_UNDEFINED;
+	uint32_t mWidth = 0;
+	uint32_t mHeight = 0;
 };
 
+//Create the ImGui context, called by Application before the App initializes;
+bool platformInitUserInterface();
+
 //To be Called at application initialization time by the App Layer;
 void initUserInterface(UserInterfaceDesc* pDesc);
 
-//Draw Imgui components;
-void cmdDrawUserInterface(void* /* Cmd* */ pCmd, uint32_t imageIndex, uint32_t currentFrame, VkFence fence);
-void createImGuiCommandBuffers(std::vector<Texture> pTextures);
\ No newline at end of file
+//Start/finish the ImGui frame, called by ImGuiLayer::Begin/End around the layers' OnImGuiRender;
+void beginUserInterfaceFrame();
+void endUserInterfaceFrame();
+
+//Record the draw data produced by endUserInterfaceFrame;
+void cmdDrawUserInterface(void* /* Cmd* */ pCmd, Texture* pRenderTarget);
+
+//Renderer and graphics queue the UI was initialized with, NULL before initUserInterface;
+Renderer* getUserInterfaceRenderer();
+Queue* getUserInterfaceQueue();
\ No newline at end of file
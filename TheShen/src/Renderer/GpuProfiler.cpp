@@ -0,0 +1,314 @@
+#include "GpuProfiler.h"
+#include "Core/Log.h"
+#include "Core/Memory.h"
+
+// 每帧占用的时间戳查询数量
+#define GPU_PROFILER_QUERIES_PER_FRAME (GPU_PROFILER_MAX_SCOPES_PER_FRAME * 2)
+// 超出容量被丢弃的区间在栈中的占位值
+#define GPU_PROFILER_DROPPED_SCOPE UINT32_MAX
+
+typedef struct GpuProfileScope
+{
+	char		mName[GPU_PROFILER_MAX_NAME_LENGTH];
+	uint32_t	mDepth;
+	uint32_t	mParentIndex;
+	uint32_t	mBeginQuery;
+	uint32_t	mEndQuery;
+} GpuProfileScope;
+
+/// <summary>
+/// 环形缓冲中的一帧, 对应查询池中连续的一段查询
+/// </summary>
+typedef struct GpuProfileFrame
+{
+	GpuProfileScope	mScopes[GPU_PROFILER_MAX_SCOPES_PER_FRAME];
+	uint32_t		mScopeCount;
+	uint32_t		mQueryCount;
+	uint64_t		mFrameIndex;
+	// 已录制但尚未回读
+	bool			mPending;
+} GpuProfileFrame;
+
+typedef struct GpuProfiler
+{
+	VkQueryPool			pVkQueryPool;
+	GpuProfileFrame*	pFrames;
+	uint32_t			mFrameCount;
+	uint32_t			mCurrentFrame;
+	uint64_t			mFrameIndex;
+	// 时间戳有效位掩码 (timestampValidBits)
+	uint64_t			mTimestampMask;
+	// 每个时间戳计数对应的纳秒数
+	double				mTimestampPeriod;
+	uint32_t			mStack[GPU_PROFILER_MAX_DEPTH];
+	uint32_t			mStackDepth;
+	bool				mFrameActive;
+	bool				mOverflowReported;
+	uint64_t			mQueryData[GPU_PROFILER_QUERIES_PER_FRAME];
+	GpuTimerResult		mResults[GPU_PROFILER_MAX_SCOPES_PER_FRAME];
+	uint32_t			mResultCount;
+	uint64_t			mResultFrameIndex;
+} GpuProfiler;
+
+/// <summary>
+/// 创建队列的 GPU 计时器
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pQueue"></param>
+/// <param name="frameCount">环形缓冲帧数, 为 0 时使用默认值</param>
+void initGpuProfiler(Renderer* pRenderer, Queue* pQueue, uint32_t frameCount)
+{
+	uint32_t queueFamilyCount = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(pRenderer->pVkActiveGPU, &queueFamilyCount, nullptr);
+	std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+	vkGetPhysicalDeviceQueueFamilyProperties(pRenderer->pVkActiveGPU, &queueFamilyCount, queueFamilies.data());
+
+	uint32_t validBits = pQueue->mVkQueueIndex < queueFamilyCount ? queueFamilies[pQueue->mVkQueueIndex].timestampValidBits : 0;
+	if (validBits == 0 || pRenderer->mCapabilities.mTimestampPeriod <= 0.0f)
+	{
+		SHEN_CORE_WARN("queue family {0} does not support timestamps, gpu profiler disabled", pQueue->mVkQueueIndex);
+		pQueue->pGpuProfiler = NULL;
+		return;
+	}
+
+	GpuProfiler* pProfiler = shen_new(MEMORY_CATEGORY_RENDERER, GpuProfiler);
+	pProfiler->mFrameCount = frameCount ? frameCount : GPU_PROFILER_DEFAULT_FRAME_COUNT;
+	pProfiler->mTimestampMask = validBits >= 64 ? UINT64_MAX : ((1ull << validBits) - 1);
+	pProfiler->mTimestampPeriod = (double)pRenderer->mCapabilities.mTimestampPeriod;
+	pProfiler->pFrames = (GpuProfileFrame*)shen_calloc(MEMORY_CATEGORY_RENDERER, pProfiler->mFrameCount, sizeof(GpuProfileFrame));
+
+	VkQueryPoolCreateInfo queryPoolInfo{};
+	queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	queryPoolInfo.queryCount = GPU_PROFILER_QUERIES_PER_FRAME * pProfiler->mFrameCount;
+	if (pRenderer->mVkDeviceTable.vkCreateQueryPool(pRenderer->pVkDevice, &queryPoolInfo, pRenderer->pVkAllocator, &pProfiler->pVkQueryPool) != VK_SUCCESS) {
+		SHEN_CORE_ERROR("failed to create timestamp query pool!");
+		throw std::runtime_error("failed to create timestamp query pool!");
+	}
+
+	pQueue->pGpuProfiler = pProfiler;
+}
+
+/// <summary>
+/// 释放队列的 GPU 计时器, 调用前需确保队列空闲
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pQueue"></param>
+void exitGpuProfiler(Renderer* pRenderer, Queue* pQueue)
+{
+	GpuProfiler* pProfiler = pQueue->pGpuProfiler;
+	if (!pProfiler)
+		return;
+
+	pRenderer->mVkDeviceTable.vkDestroyQueryPool(pRenderer->pVkDevice, pProfiler->pVkQueryPool, pRenderer->pVkAllocator);
+	shen_free(pProfiler->pFrames);
+	shen_delete(pProfiler);
+	pQueue->pGpuProfiler = NULL;
+}
+
+/// <summary>
+/// 非阻塞回读一帧的查询结果, 结果未全部就绪时返回 false
+/// </summary>
+static bool resolveGpuProfileFrame(Renderer* pRenderer, GpuProfiler* pProfiler, uint32_t frameSlot)
+{
+	GpuProfileFrame* pFrame = &pProfiler->pFrames[frameSlot];
+	if (pFrame->mQueryCount)
+	{
+		VkResult result = pRenderer->mVkDeviceTable.vkGetQueryPoolResults(pRenderer->pVkDevice, pProfiler->pVkQueryPool,
+			frameSlot * GPU_PROFILER_QUERIES_PER_FRAME, pFrame->mQueryCount,
+			pFrame->mQueryCount * sizeof(uint64_t), pProfiler->mQueryData, sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+		if (result != VK_SUCCESS)
+			return false;
+	}
+
+	const double millisecondsPerTick = pProfiler->mTimestampPeriod * 1e-6;
+	// 第一个区间为整帧, 其开始时间戳作为偏移的基准
+	uint64_t frameBegin = pFrame->mScopeCount ? pProfiler->mQueryData[pFrame->mScopes[0].mBeginQuery] & pProfiler->mTimestampMask : 0;
+	for (uint32_t i = 0; i < pFrame->mScopeCount; ++i)
+	{
+		const GpuProfileScope* pScope = &pFrame->mScopes[i];
+		GpuTimerResult* pResult = &pProfiler->mResults[i];
+		memcpy(pResult->mName, pScope->mName, sizeof(pResult->mName));
+		pResult->mDepth = pScope->mDepth;
+		pResult->mParentIndex = pScope->mParentIndex;
+		// 区间未闭合 (帧结束时仍未调用 End) 时记为 0
+		uint64_t begin = pProfiler->mQueryData[pScope->mBeginQuery] & pProfiler->mTimestampMask;
+		pResult->mStartMilliseconds = (double)((begin - frameBegin) & pProfiler->mTimestampMask) * millisecondsPerTick;
+		if (pScope->mEndQuery == GPU_PROFILER_DROPPED_SCOPE)
+		{
+			pResult->mMilliseconds = 0.0;
+			continue;
+		}
+		uint64_t end = pProfiler->mQueryData[pScope->mEndQuery] & pProfiler->mTimestampMask;
+		pResult->mMilliseconds = (double)((end - begin) & pProfiler->mTimestampMask) * millisecondsPerTick;
+	}
+	pProfiler->mResultCount = pFrame->mScopeCount;
+	pProfiler->mResultFrameIndex = pFrame->mFrameIndex;
+	return true;
+}
+
+static void writeGpuTimestamp(Cmd* pCmd, GpuProfiler* pProfiler, VkPipelineStageFlagBits stage, uint32_t* pOutQuery)
+{
+	GpuProfileFrame* pFrame = &pProfiler->pFrames[pProfiler->mCurrentFrame];
+	uint32_t query = pFrame->mQueryCount++;
+	pCmd->pVkDeviceTable->vkCmdWriteTimestamp(pCmd->pVkCmdBuf, stage, pProfiler->pVkQueryPool,
+		pProfiler->mCurrentFrame * GPU_PROFILER_QUERIES_PER_FRAME + query);
+	*pOutQuery = query;
+}
+
+/// <summary>
+/// 开始一帧的 GPU 计时, 需在渲染通道之外录制
+/// </summary>
+/// <param name="pCmd"></param>
+void cmdBeginGpuFrameProfile(Cmd* pCmd)
+{
+	GpuProfiler* pProfiler = pCmd->pQueue ? pCmd->pQueue->pGpuProfiler : NULL;
+	if (!pProfiler)
+		return;
+
+	Renderer* pRenderer = pCmd->pRenderer;
+	uint32_t frameSlot = (uint32_t)(pProfiler->mFrameIndex % pProfiler->mFrameCount);
+	GpuProfileFrame* pFrame = &pProfiler->pFrames[frameSlot];
+
+	// 复用该槽位时, 上一次使用它的帧通常已经因为等待栅栏而完成, 结果可以直接读取
+	bool resolved = !pFrame->mPending || resolveGpuProfileFrame(pRenderer, pProfiler, frameSlot);
+	if (resolved && pRenderer->mCapabilities.mHostQueryReset)
+	{
+		pRenderer->mVkDeviceTable.vkResetQueryPool(pRenderer->pVkDevice, pProfiler->pVkQueryPool,
+			frameSlot * GPU_PROFILER_QUERIES_PER_FRAME, GPU_PROFILER_QUERIES_PER_FRAME);
+	}
+	else
+	{
+		// 查询可能仍在 GPU 上使用, 在指令流中重置以保证顺序
+		pCmd->pVkDeviceTable->vkCmdResetQueryPool(pCmd->pVkCmdBuf, pProfiler->pVkQueryPool,
+			frameSlot * GPU_PROFILER_QUERIES_PER_FRAME, GPU_PROFILER_QUERIES_PER_FRAME);
+	}
+
+	pFrame->mScopeCount = 0;
+	pFrame->mQueryCount = 0;
+	pFrame->mFrameIndex = pProfiler->mFrameIndex++;
+	pFrame->mPending = true;
+	pProfiler->mCurrentFrame = frameSlot;
+	pProfiler->mStackDepth = 0;
+	pProfiler->mFrameActive = true;
+
+	cmdBeginGpuTimestampQuery(pCmd, "GPU Frame");
+}
+
+/// <summary>
+/// 结束一帧的 GPU 计时, 关闭所有未闭合的区间
+/// </summary>
+/// <param name="pCmd"></param>
+void cmdEndGpuFrameProfile(Cmd* pCmd)
+{
+	GpuProfiler* pProfiler = pCmd->pQueue ? pCmd->pQueue->pGpuProfiler : NULL;
+	if (!pProfiler || !pProfiler->mFrameActive)
+		return;
+
+	if (pProfiler->mStackDepth > 1)
+	{
+		SHEN_CORE_WARN("gpu profiler: {0} timestamp queries were not ended before the end of the frame", pProfiler->mStackDepth - 1);
+	}
+	while (pProfiler->mStackDepth)
+		cmdEndGpuTimestampQuery(pCmd);
+	pProfiler->mFrameActive = false;
+}
+
+/// <summary>
+/// 开始一个计时区间
+/// </summary>
+/// <param name="pCmd"></param>
+/// <param name="pName">区间名称, 超出长度时截断</param>
+void cmdBeginGpuTimestampQuery(Cmd* pCmd, const char* pName)
+{
+	GpuProfiler* pProfiler = pCmd->pQueue ? pCmd->pQueue->pGpuProfiler : NULL;
+	if (!pProfiler || !pProfiler->mFrameActive)
+		return;
+
+	if (pProfiler->mStackDepth >= GPU_PROFILER_MAX_DEPTH)
+	{
+		SHEN_CORE_ERROR("gpu profiler: timestamp query {0} exceeds the maximum depth {1}!", pName, GPU_PROFILER_MAX_DEPTH);
+		throw std::runtime_error("gpu profiler stack overflow!");
+	}
+
+	GpuProfileFrame* pFrame = &pProfiler->pFrames[pProfiler->mCurrentFrame];
+	if (pFrame->mScopeCount >= GPU_PROFILER_MAX_SCOPES_PER_FRAME)
+	{
+		if (!pProfiler->mOverflowReported)
+		{
+			SHEN_CORE_WARN("gpu profiler: more than {0} timestamp queries in one frame, extra queries are dropped", GPU_PROFILER_MAX_SCOPES_PER_FRAME);
+			pProfiler->mOverflowReported = true;
+		}
+		pProfiler->mStack[pProfiler->mStackDepth++] = GPU_PROFILER_DROPPED_SCOPE;
+		return;
+	}
+
+	uint32_t scopeIndex = pFrame->mScopeCount++;
+	GpuProfileScope* pScope = &pFrame->mScopes[scopeIndex];
+	strncpy(pScope->mName, pName, GPU_PROFILER_MAX_NAME_LENGTH - 1);
+	pScope->mName[GPU_PROFILER_MAX_NAME_LENGTH - 1] = '\0';
+	pScope->mDepth = pProfiler->mStackDepth;
+	pScope->mParentIndex = pProfiler->mStackDepth ? pProfiler->mStack[pProfiler->mStackDepth - 1] : UINT32_MAX;
+	pScope->mEndQuery = GPU_PROFILER_DROPPED_SCOPE;
+	writeGpuTimestamp(pCmd, pProfiler, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, &pScope->mBeginQuery);
+
+	pProfiler->mStack[pProfiler->mStackDepth++] = scopeIndex;
+}
+
+/// <summary>
+/// 结束最近开始的计时区间
+/// </summary>
+/// <param name="pCmd"></param>
+void cmdEndGpuTimestampQuery(Cmd* pCmd)
+{
+	GpuProfiler* pProfiler = pCmd->pQueue ? pCmd->pQueue->pGpuProfiler : NULL;
+	if (!pProfiler || !pProfiler->mFrameActive)
+		return;
+
+	if (pProfiler->mStackDepth == 0)
+	{
+		SHEN_CORE_ERROR("gpu profiler: cmdEndGpuTimestampQuery without a matching begin!");
+		throw std::runtime_error("unbalanced gpu timestamp query!");
+	}
+
+	uint32_t scopeIndex = pProfiler->mStack[--pProfiler->mStackDepth];
+	if (scopeIndex == GPU_PROFILER_DROPPED_SCOPE)
+		return;
+
+	GpuProfileFrame* pFrame = &pProfiler->pFrames[pProfiler->mCurrentFrame];
+	writeGpuTimestamp(pCmd, pProfiler, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, &pFrame->mScopes[scopeIndex].mEndQuery);
+}
+
+/// <summary>
+/// 最近一次 cmdBeginGpuFrameProfile 开始的帧序号, 尚未开始任何帧或队列未开启计时器时返回 false
+/// </summary>
+/// <param name="pQueue"></param>
+/// <param name="pOutFrameIndex"></param>
+/// <returns></returns>
+bool getGpuProfileFrameIndex(Queue* pQueue, uint64_t* pOutFrameIndex)
+{
+	GpuProfiler* pProfiler = pQueue->pGpuProfiler;
+	if (!pProfiler || pProfiler->mFrameIndex == 0)
+		return false;
+
+	*pOutFrameIndex = pProfiler->mFrameIndex - 1;
+	return true;
+}
+
+/// <summary>
+/// 获取最近一次回读成功的结果, 结果在下一次 cmdBeginGpuFrameProfile 前有效
+/// </summary>
+/// <param name="pQueue"></param>
+/// <param name="pOutResults"></param>
+/// <returns></returns>
+bool getGpuProfileResults(Queue* pQueue, GpuProfileResults* pOutResults)
+{
+	GpuProfiler* pProfiler = pQueue->pGpuProfiler;
+	if (!pProfiler)
+		return false;
+
+	pOutResults->pTimers = pProfiler->mResults;
+	pOutResults->mTimerCount = pProfiler->mResultCount;
+	pOutResults->mFrameIndex = pProfiler->mResultFrameIndex;
+	return true;
+}
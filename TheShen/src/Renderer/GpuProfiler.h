@@ -0,0 +1,56 @@
+#pragma once
+
+#include "Renderer.h"
+
+// 每帧最多记录的计时区间数量 (每个区间占用两个时间戳查询)
+#define GPU_PROFILER_MAX_SCOPES_PER_FRAME 128
+// 计时区间最大嵌套深度
+#define GPU_PROFILER_MAX_DEPTH 16
+#define GPU_PROFILER_MAX_NAME_LENGTH 64
+// 未指定时的帧环形缓冲数量, 应不小于同时在途的帧数
+#define GPU_PROFILER_DEFAULT_FRAME_COUNT 3
+
+/// <summary>
+/// 单个计时区间的结果
+/// </summary>
+typedef struct GpuTimerResult
+{
+	char		mName[GPU_PROFILER_MAX_NAME_LENGTH];
+	// 嵌套深度, 0 为整帧
+	uint32_t	mDepth;
+	// 父区间在结果数组中的索引, 根区间为 UINT32_MAX
+	uint32_t	mParentIndex;
+	// 相对整帧开始的偏移
+	double		mStartMilliseconds;
+	double		mMilliseconds;
+} GpuTimerResult;
+
+/// <summary>
+/// 一帧的 GPU 计时结果
+/// </summary>
+typedef struct GpuProfileResults
+{
+	const GpuTimerResult*	pTimers;
+	uint32_t				mTimerCount;
+	// 结果对应的帧序号 (cmdBeginGpuFrameProfile 的调用次数), 用于判断数据是否过期
+	uint64_t				mFrameIndex;
+} GpuProfileResults;
+
+// 创建队列的 GPU 计时器, addQueue 在设置 QUEUE_FLAG_INIT_MICROPROFILE 时调用
+void initGpuProfiler(Renderer* pRenderer, Queue* pQueue, uint32_t frameCount);
+void exitGpuProfiler(Renderer* pRenderer, Queue* pQueue);
+
+// 每帧录制的第一个/最后一个指令, 整帧作为深度为 0 的根区间
+// 开始时回读 frameCount 帧之前的结果, 结果未就绪时不等待, 直接跳过
+void cmdBeginGpuFrameProfile(Cmd* pCmd);
+void cmdEndGpuFrameProfile(Cmd* pCmd);
+
+// 可嵌套的计时区间, 队列未开启计时器时为空操作
+void cmdBeginGpuTimestampQuery(Cmd* pCmd, const char* pName);
+void cmdEndGpuTimestampQuery(Cmd* pCmd);
+
+// 最近一次 cmdBeginGpuFrameProfile 开始的帧序号, 与 GpuProfileResults::mFrameIndex 对应
+bool getGpuProfileFrameIndex(Queue* pQueue, uint64_t* pOutFrameIndex);
+
+// 获取最近一次回读成功的结果, 队列未开启计时器时返回 false
+bool getGpuProfileResults(Queue* pQueue, GpuProfileResults* pOutResults);
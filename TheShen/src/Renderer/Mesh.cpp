@@ -0,0 +1,1032 @@
+#include "Mesh.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "ObjParser.h"
+#include "Core/Log.h"
+#include "Core/MappedFile.h"
+#include "Core/Profiler.h"
+
+#include <cfloat>
+#include <cmath>
+#include <cstdio>
+#include <string>
+
+typedef std::vector<MeshVertex, CategoryAllocator<MeshVertex, MEMORY_CATEGORY_ASSETS>> MeshVertexList;
+typedef std::vector<uint32_t, CategoryAllocator<uint32_t, MEMORY_CATEGORY_ASSETS>> MeshIndexList;
+typedef std::vector<Submesh, CategoryAllocator<Submesh, MEMORY_CATEGORY_ASSETS>> SubmeshList;
+typedef std::vector<MeshCluster, CategoryAllocator<MeshCluster, MEMORY_CATEGORY_ASSETS>> MeshClusterList;
+typedef std::vector<uint8_t, CategoryAllocator<uint8_t, MEMORY_CATEGORY_ASSETS>> MeshByteList;
+
+/// <summary>
+/// 导入后的网格数据, 与烘焙文件的内容一一对应; mHeader 中的偏移与文件大小只在写出时填写
+/// mVertices 为优化用的浮点顶点, 编码后释放, 写出与上传的是 mVertexData
+/// </summary>
+typedef struct MeshData
+{
+	MeshFileHeader	mHeader;
+	MeshVertexList	mVertices;
+	MeshByteList	mVertexData;
+	MeshIndexList	mIndices;
+	SubmeshList		mSubmeshes;
+	MeshClusterList	mClusters;
+} MeshData;
+
+static_assert(sizeof(MeshVertex) == 8 * sizeof(float), "MeshVertex must stay tightly packed, it is hashed byte by byte");
+// 与 cluster_cull.comp 中的 std430 布局及推送常量块一致
+static_assert(sizeof(MeshClusterCullInstance) == 80, "MeshClusterCullInstance must match the std430 instance struct of the cull shader");
+static_assert(sizeof(MeshClusterCullConstants) == 128, "MeshClusterCullConstants must fit the guaranteed push constant size");
+
+static const VertexLayout gMeshVertexLayout = {
+	{
+		{ VK_FORMAT_R32G32B32_SFLOAT, 0, offsetof(MeshVertex, mPosition) },
+		{ VK_FORMAT_R32G32B32_SFLOAT, 1, offsetof(MeshVertex, mNormal) },
+		{ VK_FORMAT_R32G32_SFLOAT, 2, offsetof(MeshVertex, mTexCoord) },
+	},
+	3,
+	sizeof(MeshVertex),
+};
+
+// 与 MeshVertex 逐字节相同, 与 gMeshVertexLayout 对应
+static const VertexFormat gMeshVertexFormat = { { VERTEX_ENCODING_FLOAT32, VERTEX_ENCODING_FLOAT32, VERTEX_ENCODING_FLOAT32 } };
+static const VertexFormat gCompactMeshVertexFormat = { { VERTEX_ENCODING_SNORM16, VERTEX_ENCODING_OCT_SNORM16, VERTEX_ENCODING_UNORM16 } };
+
+// 每级 LOD 的目标索引数占上一级的比例
+const float MESH_LOD_REDUCTION = 0.5f;
+// 一级 LOD 的索引数超过上一级的该比例时认为简化已无效, 停止生成
+const float MESH_LOD_MIN_REDUCTION = 0.85f;
+// LOD 的累计误差上限 (以包围盒最大边长为单位), 更粗的 LOD 在任何距离下都不会被选中
+const float MESH_LOD_MAX_ERROR = 0.05f;
+// 简化时属性误差的权重, 依次对应 MeshVertex 中紧随位置的法线 xyz 与 UV
+const uint32_t MESH_LOD_ATTRIBUTE_COUNT = 5;
+static const float gMeshLodAttributeWeights[MESH_LOD_ATTRIBUTE_COUNT] = { 0.5f, 0.5f, 0.5f, 1.0f, 1.0f };
+
+const VertexLayout* getMeshVertexLayout()
+{
+	return &gMeshVertexLayout;
+}
+
+/// <summary>
+/// 首次适配分配, 起始偏移按 alignment 对齐, 对齐产生的前部空隙保留为空闲区间
+/// 没有足够大的区间时返回 false
+/// </summary>
+static bool allocateRange(BufferRangeList& freeRanges, uint64_t size, uint64_t alignment, BufferRange* pOutRange)
+{
+	for (size_t i = 0; i < freeRanges.size(); ++i)
+	{
+		BufferRange range = freeRanges[i];
+		uint64_t offset = (range.mOffset + alignment - 1) / alignment * alignment;
+		uint64_t end = range.mOffset + range.mSize;
+		if (offset + size > end)
+			continue;
+
+		freeRanges.erase(freeRanges.begin() + i);
+		if (end > offset + size)
+			freeRanges.insert(freeRanges.begin() + i, { offset + size, end - offset - size });
+		if (offset > range.mOffset)
+			freeRanges.insert(freeRanges.begin() + i, { range.mOffset, offset - range.mOffset });
+
+		pOutRange->mOffset = offset;
+		pOutRange->mSize = size;
+		return true;
+	}
+	return false;
+}
+
+/// <summary>
+/// 按偏移插回空闲列表, 与前后相邻的区间合并
+/// </summary>
+static void freeRange(BufferRangeList& freeRanges, BufferRange range)
+{
+	if (!range.mSize)
+		return;
+
+	auto it = std::lower_bound(freeRanges.begin(), freeRanges.end(), range,
+		[](const BufferRange& a, const BufferRange& b) { return a.mOffset < b.mOffset; });
+	it = freeRanges.insert(it, range);
+	if (it + 1 != freeRanges.end() && it->mOffset + it->mSize == (it + 1)->mOffset)
+	{
+		it->mSize += (it + 1)->mSize;
+		freeRanges.erase(it + 1);
+	}
+	if (it != freeRanges.begin() && (it - 1)->mOffset + (it - 1)->mSize == it->mOffset)
+	{
+		(it - 1)->mSize += it->mSize;
+		freeRanges.erase(it);
+	}
+}
+
+void addGeometryBuffer(Renderer* pRenderer, const GeometryBufferDesc* pDesc, GeometryBuffer** ppGeometryBuffer)
+{
+	GeometryBuffer* pGeometryBuffer = shen_new(MEMORY_CATEGORY_ASSETS, GeometryBuffer);
+
+	BufferDesc bufferDesc = {};
+	bufferDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_ONLY;
+	bufferDesc.mSize = pDesc->mVertexBufferSize;
+	bufferDesc.mUsage = VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	addBuffer(pRenderer, &bufferDesc, &pGeometryBuffer->pVertexBuffer);
+	bufferDesc.mSize = pDesc->mIndexBufferSize;
+	bufferDesc.mUsage = VK_BUFFER_USAGE_INDEX_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+	addBuffer(pRenderer, &bufferDesc, &pGeometryBuffer->pIndexBuffer);
+
+	pGeometryBuffer->mFreeVertexRanges.push_back({ 0, pDesc->mVertexBufferSize });
+	pGeometryBuffer->mFreeIndexRanges.push_back({ 0, pDesc->mIndexBufferSize });
+	*ppGeometryBuffer = pGeometryBuffer;
+}
+
+void removeGeometryBuffer(Renderer* pRenderer, GeometryBuffer* pGeometryBuffer)
+{
+	if (pGeometryBuffer->mFreeVertexRanges.size() != 1 || pGeometryBuffer->mFreeVertexRanges[0].mSize != pGeometryBuffer->pVertexBuffer->mSize)
+		SHEN_CORE_WARN("removing a geometry buffer that still holds meshes");
+
+	removeBuffer(pRenderer, pGeometryBuffer->pVertexBuffer);
+	removeBuffer(pRenderer, pGeometryBuffer->pIndexBuffer);
+	shen_delete(pGeometryBuffer);
+}
+
+/// <summary>
+/// 将一个 shape 展开为非索引的三角形顶点流并追加到 vertices, 每个角一个顶点
+/// 缺少法线时使用面法线, 纹理坐标 V 翻转为 Vulkan 的左上角原点
+/// </summary>
+static void buildVertexStream(const tinyobj::attrib_t& attrib, const tinyobj::shape_t& shape, MeshVertexList& vertices)
+{
+	const std::vector<tinyobj::index_t>& indices = shape.mesh.indices;
+	for (size_t i = 0; i + 2 < indices.size(); i += 3)
+	{
+		MeshVertex corners[3] = {};
+		bool hasNormals = true;
+		for (uint32_t k = 0; k < 3; ++k)
+		{
+			const tinyobj::index_t& index = indices[i + k];
+			MeshVertex& vertex = corners[k];
+			for (uint32_t c = 0; c < 3; ++c)
+				vertex.mPosition[c] = attrib.vertices[3 * index.vertex_index + c];
+			if (index.normal_index >= 0)
+			{
+				for (uint32_t c = 0; c < 3; ++c)
+					vertex.mNormal[c] = attrib.normals[3 * index.normal_index + c];
+			}
+			else
+			{
+				hasNormals = false;
+			}
+			if (index.texcoord_index >= 0)
+			{
+				vertex.mTexCoord[0] = attrib.texcoords[2 * index.texcoord_index + 0];
+				vertex.mTexCoord[1] = 1.0f - attrib.texcoords[2 * index.texcoord_index + 1];
+			}
+		}
+
+		if (!hasNormals)
+		{
+			const float* p0 = corners[0].mPosition;
+			const float* p1 = corners[1].mPosition;
+			const float* p2 = corners[2].mPosition;
+			float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			float normal[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			float length = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			float scale = length > 0.0f ? 1.0f / length : 0.0f;
+			for (uint32_t k = 0; k < 3; ++k)
+			{
+				for (uint32_t c = 0; c < 3; ++c)
+					corners[k].mNormal[c] = normal[c] * scale;
+			}
+		}
+
+		vertices.insert(vertices.end(), corners, corners + 3);
+	}
+}
+
+static void computeBounds(const MeshVertex* pVertices, const uint32_t* pIndices, size_t indexCount, float* pBoundsMin, float* pBoundsMax)
+{
+	for (uint32_t c = 0; c < 3; ++c)
+	{
+		pBoundsMin[c] = FLT_MAX;
+		pBoundsMax[c] = -FLT_MAX;
+	}
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		const float* pPosition = pVertices[pIndices[i]].mPosition;
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			pBoundsMin[c] = std::min(pBoundsMin[c], pPosition[c]);
+			pBoundsMax[c] = std::max(pBoundsMax[c], pPosition[c]);
+		}
+	}
+}
+
+/// <summary>
+/// 按导入标志选择顶点格式并编码顶点流, 填写文件头中的格式、反量化参数与顶点大小
+/// </summary>
+static void encodeMeshVertices(uint32_t flags, MeshData* pData)
+{
+	SHEN_PROFILE_FUNCTION();
+	MeshFileHeader& header = pData->mHeader;
+	header.mVertexFormat = (flags & MESH_LOAD_FLAG_COMPACT_VERTICES) ? gCompactMeshVertexFormat : gMeshVertexFormat;
+	header.mVertexStride = getVertexFormatStride(&header.mVertexFormat);
+
+	const MeshVertex* pVertices = pData->mVertices.data();
+	VertexStreamsDesc streams = {};
+	streams.mStreams[VERTEX_SEMANTIC_POSITION] = { pVertices->mPosition, sizeof(MeshVertex) };
+	streams.mStreams[VERTEX_SEMANTIC_NORMAL] = { pVertices->mNormal, sizeof(MeshVertex) };
+	streams.mStreams[VERTEX_SEMANTIC_TEXCOORD] = { pVertices->mTexCoord, sizeof(MeshVertex) };
+	streams.mVertexCount = (uint32_t)pData->mVertices.size();
+	computeVertexDequantization(&header.mVertexFormat, &streams, &header.mDequantization);
+
+	pData->mVertexData.resize((size_t)streams.mVertexCount * header.mVertexStride);
+	encodeVertices(&header.mVertexFormat, &streams, &header.mDequantization, pData->mVertexData.data());
+	pData->mVertices = MeshVertexList();
+}
+
+/// <summary>
+/// 生成 LOD 链, 每级由上一级简化得到并追加到索引流末尾, 同一级的子网格连续存放
+/// 子网格分别简化: 先把其引用的顶点压缩为局部顶点表, 使简化的开销只与子网格大小相关
+/// 逐级简化的误差累加作为该级相对原始网格的误差上界, 从子网格的包围盒换算到整个网格的包围盒
+/// </summary>
+static void generateMeshLods(uint32_t flags, MeshData* pData)
+{
+	SHEN_PROFILE_FUNCTION();
+	MeshFileHeader& header = pData->mHeader;
+	const MeshVertexList& vertices = pData->mVertices;
+	MeshIndexList& indices = pData->mIndices;
+	float meshScale = getSimplifyScale(vertices[0].mPosition, vertices.size(), sizeof(MeshVertex));
+	if (meshScale <= 0.0f)
+		return;
+
+	MeshIndexList globalToLocal(vertices.size(), UINT32_MAX);
+	MeshIndexList localToGlobal;
+	MeshVertexList localVertices;
+	MeshIndexList localIndices;
+	MeshIndexList simplified;
+	MeshIndexList ordered;
+	for (uint32_t lod = 1; lod < MESH_MAX_LODS && header.mLodErrors[lod - 1] < MESH_LOD_MAX_ERROR; ++lod)
+	{
+		uint32_t firstIndex = (uint32_t)indices.size();
+		float lodError = 0.0f;
+		for (Submesh& submesh : pData->mSubmeshes)
+		{
+			const MeshIndexRange& source = submesh.mLods[lod - 1];
+			submesh.mLods[lod].mFirstIndex = (uint32_t)indices.size();
+			if (!source.mIndexCount)
+				continue;
+
+			localToGlobal.clear();
+			localVertices.clear();
+			localIndices.resize(source.mIndexCount);
+			for (uint32_t i = 0; i < source.mIndexCount; ++i)
+			{
+				uint32_t index = indices[source.mFirstIndex + i];
+				if (globalToLocal[index] == UINT32_MAX)
+				{
+					globalToLocal[index] = (uint32_t)localToGlobal.size();
+					localToGlobal.push_back(index);
+					localVertices.push_back(vertices[index]);
+				}
+				localIndices[i] = globalToLocal[index];
+			}
+			for (uint32_t index : localToGlobal)
+				globalToLocal[index] = UINT32_MAX;
+
+			// 误差上限换算到子网格自身的包围盒
+			float localScale = getSimplifyScale(localVertices[0].mPosition, localVertices.size(), sizeof(MeshVertex));
+			float errorScale = localScale > 0.0f ? localScale / meshScale : 1.0f;
+			size_t targetIndexCount = (size_t)(source.mIndexCount * MESH_LOD_REDUCTION) / 3 * 3;
+			float error = 0.0f;
+			simplified.resize(source.mIndexCount);
+			size_t indexCount = simplifyMesh(simplified.data(), localIndices.data(), localIndices.size(), localVertices[0].mPosition, localVertices.size(),
+				sizeof(MeshVertex), localVertices[0].mNormal, sizeof(MeshVertex), gMeshLodAttributeWeights, MESH_LOD_ATTRIBUTE_COUNT, targetIndexCount,
+				(MESH_LOD_MAX_ERROR - header.mLodErrors[lod - 1]) / errorScale, &error);
+			lodError = std::max(lodError, error * errorScale);
+
+			const uint32_t* pLodIndices = simplified.data();
+			if (!(flags & MESH_LOAD_FLAG_SKIP_OPTIMIZATION))
+			{
+				ordered.resize(indexCount);
+				optimizeVertexCache(ordered.data(), simplified.data(), indexCount, localVertices.size());
+				pLodIndices = ordered.data();
+			}
+			submesh.mLods[lod].mIndexCount = (uint32_t)indexCount;
+			for (size_t i = 0; i < indexCount; ++i)
+				indices.push_back(localToGlobal[pLodIndices[i]]);
+		}
+
+		uint32_t indexCount = (uint32_t)indices.size() - firstIndex;
+		if (!indexCount || indexCount > header.mLods[lod - 1].mIndexCount * MESH_LOD_MIN_REDUCTION)
+		{
+			indices.resize(firstIndex);
+			for (Submesh& submesh : pData->mSubmeshes)
+				submesh.mLods[lod] = {};
+			break;
+		}
+		header.mLods[lod].mFirstIndex = firstIndex;
+		header.mLods[lod].mIndexCount = indexCount;
+		header.mLodErrors[lod] = header.mLodErrors[lod - 1] + lodError;
+		header.mLodCount = lod + 1;
+	}
+}
+
+/// <summary>
+/// 把子网格 LOD 0 的三角形 (pIndices) 按簇重排写入 pDst, 追加簇表; 包围体在顶点重排之后由 computeMeshClusterBounds 填写
+/// </summary>
+static void buildSubmeshClusters(Submesh* pSubmesh, uint32_t* pDst, const uint32_t* pIndices, const MeshVertexList& vertices, MeshClusterList* pClusters)
+{
+	size_t indexCount = pSubmesh->mLods[0].mIndexCount;
+	MeshIndexList triangleCounts(getClusterCountBound(indexCount, MESH_OPTIMIZER_CLUSTER_MAX_VERTICES, MESH_OPTIMIZER_CLUSTER_MAX_TRIANGLES));
+	size_t clusterCount = buildClusters(pDst, triangleCounts.data(), pIndices, indexCount, vertices[0].mPosition, vertices.size(), sizeof(MeshVertex),
+		MESH_OPTIMIZER_CLUSTER_MAX_VERTICES, MESH_OPTIMIZER_CLUSTER_MAX_TRIANGLES);
+
+	pSubmesh->mFirstCluster = (uint32_t)pClusters->size();
+	pSubmesh->mClusterCount = (uint32_t)clusterCount;
+	uint32_t firstIndex = pSubmesh->mLods[0].mFirstIndex;
+	for (size_t i = 0; i < clusterCount; ++i)
+	{
+		MeshCluster cluster = {};
+		cluster.mFirstIndex = firstIndex;
+		cluster.mIndexCount = triangleCounts[i] * 3;
+		firstIndex += cluster.mIndexCount;
+		pClusters->push_back(cluster);
+	}
+}
+
+static void computeMeshClusterBounds(MeshData* pData)
+{
+	SHEN_PROFILE_FUNCTION();
+	for (MeshCluster& cluster : pData->mClusters)
+	{
+		ClusterBounds bounds;
+		computeClusterBounds(&bounds, pData->mIndices.data() + cluster.mFirstIndex, cluster.mIndexCount, pData->mVertices[0].mPosition, sizeof(MeshVertex));
+		memcpy(cluster.mCenter, bounds.mCenter, sizeof(cluster.mCenter));
+		cluster.mRadius = bounds.mRadius;
+		memcpy(cluster.mConeApex, bounds.mConeApex, sizeof(cluster.mConeApex));
+		cluster.mConeCutoff = bounds.mConeCutoff;
+		memcpy(cluster.mConeAxis, bounds.mConeAxis, sizeof(cluster.mConeAxis));
+	}
+}
+
+/// <summary>
+/// 导入 OBJ 网格, 每个 shape 成为一个子网格
+/// 1. 并行解析并三角化 (输出与 tinyobjloader 相同), 展开为非索引顶点流
+/// 2. 按顶点内容在整个网格范围内去重生成索引, 子网格之间共享顶点
+/// 3. 逐子网格优化顶点缓存 -> 过度绘制 (或生成簇), 最后对整个索引流优化顶点读取
+///    顺序不能交换: 过度绘制与簇都以缓存顺序为起点重排三角形, 顶点读取依赖最终的三角形顺序
+/// 4. 按需生成 LOD, 各级共用 LOD 0 的顶点, 只追加索引
+/// </summary>
+static void importObjMesh(const char* pFileName, uint32_t flags, MeshData* pData)
+{
+	SHEN_PROFILE_FUNCTION();
+	tinyobj::attrib_t attrib;
+	std::vector<tinyobj::shape_t> shapes;
+	std::vector<tinyobj::material_t> materials;
+	std::string error;
+	if (!loadObjParallel(&attrib, &shapes, &materials, &error, pFileName))
+	{
+		SHEN_CORE_ERROR("failed to load mesh {0}: {1}", pFileName, error);
+		throw std::runtime_error("failed to load mesh!");
+	}
+	if (!error.empty())
+		SHEN_CORE_WARN("mesh {0}: {1}", pFileName, error);
+
+	size_t cornerCount = 0;
+	for (const tinyobj::shape_t& shape : shapes)
+		cornerCount += shape.mesh.indices.size();
+	MeshVertexList unindexedVertices;
+	unindexedVertices.reserve(cornerCount);
+	for (const tinyobj::shape_t& shape : shapes)
+	{
+		size_t firstIndex = unindexedVertices.size();
+		buildVertexStream(attrib, shape, unindexedVertices);
+		if (unindexedVertices.size() == firstIndex)
+			continue;
+
+		Submesh submesh = {};
+		strncpy(submesh.mName, shape.name.c_str(), MESH_SUBMESH_NAME_LENGTH - 1);
+		submesh.mLods[0].mFirstIndex = (uint32_t)firstIndex;
+		submesh.mLods[0].mIndexCount = (uint32_t)(unindexedVertices.size() - firstIndex);
+		pData->mSubmeshes.push_back(submesh);
+	}
+	size_t indexCount = unindexedVertices.size();
+	if (!indexCount)
+	{
+		SHEN_CORE_ERROR("mesh {0} has no triangles", pFileName);
+		throw std::runtime_error("failed to load mesh!");
+	}
+
+	MeshIndexList remap(indexCount);
+	size_t vertexCount = generateVertexRemap(remap.data(), NULL, indexCount, unindexedVertices.data(), indexCount, sizeof(MeshVertex));
+	MeshVertexList& vertices = pData->mVertices;
+	vertices.resize(vertexCount);
+	remapVertexBuffer(vertices.data(), unindexedVertices.data(), indexCount, sizeof(MeshVertex), remap.data());
+	MeshIndexList& indices = pData->mIndices;
+	indices.resize(indexCount);
+	remapIndexBuffer(indices.data(), NULL, indexCount, remap.data());
+	unindexedVertices = MeshVertexList();
+
+	VertexCacheStatistics before;
+	analyzeVertexCache(indices.data(), indexCount, vertexCount, MESH_OPTIMIZER_VERTEX_CACHE_SIZE, &before);
+	bool generateClusters = (flags & MESH_LOAD_FLAG_GENERATE_CLUSTERS) != 0;
+	if (!(flags & MESH_LOAD_FLAG_SKIP_OPTIMIZATION) || generateClusters)
+	{
+		MeshIndexList scratch(indexCount);
+		for (Submesh& submesh : pData->mSubmeshes)
+		{
+			uint32_t* pSubmeshIndices = indices.data() + submesh.mLods[0].mFirstIndex;
+			uint32_t* pScratch = scratch.data() + submesh.mLods[0].mFirstIndex;
+			size_t submeshIndexCount = submesh.mLods[0].mIndexCount;
+			if (flags & MESH_LOAD_FLAG_SKIP_OPTIMIZATION)
+				memcpy(pScratch, pSubmeshIndices, submeshIndexCount * sizeof(uint32_t));
+			else
+				optimizeVertexCache(pScratch, pSubmeshIndices, submeshIndexCount, vertexCount);
+
+			if (generateClusters)
+				buildSubmeshClusters(&submesh, pSubmeshIndices, pScratch, vertices, &pData->mClusters);
+			else
+				optimizeOverdraw(pSubmeshIndices, pScratch, submeshIndexCount, vertices[0].mPosition, vertexCount, sizeof(MeshVertex),
+					MESH_OPTIMIZER_DEFAULT_OVERDRAW_THRESHOLD);
+		}
+	}
+	if (!(flags & MESH_LOAD_FLAG_SKIP_OPTIMIZATION))
+	{
+		MeshVertexList fetchOrdered(vertexCount);
+		vertexCount = optimizeVertexFetch(fetchOrdered.data(), indices.data(), indexCount, vertices.data(), vertexCount, sizeof(MeshVertex));
+		fetchOrdered.resize(vertexCount);
+		vertices.swap(fetchOrdered);
+	}
+	VertexCacheStatistics after;
+	analyzeVertexCache(indices.data(), indexCount, vertexCount, MESH_OPTIMIZER_VERTEX_CACHE_SIZE, &after);
+	SHEN_CORE_INFO("mesh {0}: {1} triangles in {2} submeshes, {3} -> {4} vertices, ACMR {5:.3f} -> {6:.3f}", pFileName, indexCount / 3,
+		pData->mSubmeshes.size(), indexCount, vertexCount, before.mAcmr, after.mAcmr);
+
+	for (Submesh& submesh : pData->mSubmeshes)
+		computeBounds(vertices.data(), indices.data() + submesh.mLods[0].mFirstIndex, submesh.mLods[0].mIndexCount, submesh.mBoundsMin, submesh.mBoundsMax);
+
+	MeshFileHeader& header = pData->mHeader;
+	memset(&header, 0, sizeof(header));
+	header.mMagic = MESH_FILE_MAGIC;
+	header.mVersion = MESH_FILE_VERSION;
+	header.mVertexCount = (uint32_t)vertexCount;
+	header.mSubmeshCount = (uint32_t)pData->mSubmeshes.size();
+	header.mLodCount = 1;
+	header.mLods[0].mIndexCount = (uint32_t)indexCount;
+	computeBounds(vertices.data(), indices.data(), indexCount, header.mBoundsMin, header.mBoundsMax);
+	computeMeshClusterBounds(pData);
+	header.mClusterCount = (uint32_t)pData->mClusters.size();
+	if (flags & MESH_LOAD_FLAG_GENERATE_LODS)
+	{
+		generateMeshLods(flags, pData);
+		uint32_t coarsest = header.mLodCount - 1;
+		SHEN_CORE_INFO("mesh {0}: {1} LODs, coarsest {2} triangles with error {3:.5f}", pFileName, header.mLodCount,
+			header.mLods[coarsest].mIndexCount / 3, header.mLodErrors[coarsest]);
+	}
+	header.mIndexCount = (uint32_t)indices.size();
+	encodeMeshVertices(flags, pData);
+}
+
+static uint64_t alignStreamOffset(uint64_t offset)
+{
+	return (offset + MESH_FILE_STREAM_ALIGNMENT - 1) / MESH_FILE_STREAM_ALIGNMENT * MESH_FILE_STREAM_ALIGNMENT;
+}
+
+static bool writeMeshFile(const char* pFileName, MeshData* pData)
+{
+	MeshFileHeader& header = pData->mHeader;
+	header.mSubmeshOffset = sizeof(MeshFileHeader);
+	header.mClusterOffset = header.mSubmeshOffset + header.mSubmeshCount * sizeof(Submesh);
+	header.mVertexOffset = alignStreamOffset(header.mClusterOffset + header.mClusterCount * sizeof(MeshCluster));
+	header.mIndexOffset = alignStreamOffset(header.mVertexOffset + (uint64_t)header.mVertexCount * header.mVertexStride);
+	header.mFileSize = header.mIndexOffset + (uint64_t)header.mIndexCount * sizeof(uint32_t);
+
+	FILE* pFile = fopen(pFileName, "wb");
+	if (!pFile)
+	{
+		SHEN_CORE_ERROR("failed to create {0}", pFileName);
+		return false;
+	}
+
+	static const uint8_t padding[MESH_FILE_STREAM_ALIGNMENT] = {};
+	uint64_t clusterEnd = header.mClusterOffset + header.mClusterCount * sizeof(MeshCluster);
+	uint64_t vertexEnd = header.mVertexOffset + (uint64_t)header.mVertexCount * header.mVertexStride;
+	bool written =
+		fwrite(&header, sizeof(header), 1, pFile) == 1 &&
+		fwrite(pData->mSubmeshes.data(), sizeof(Submesh), header.mSubmeshCount, pFile) == header.mSubmeshCount &&
+		fwrite(pData->mClusters.data(), sizeof(MeshCluster), header.mClusterCount, pFile) == header.mClusterCount &&
+		fwrite(padding, 1, header.mVertexOffset - clusterEnd, pFile) == header.mVertexOffset - clusterEnd &&
+		fwrite(pData->mVertexData.data(), header.mVertexStride, header.mVertexCount, pFile) == header.mVertexCount &&
+		fwrite(padding, 1, header.mIndexOffset - vertexEnd, pFile) == header.mIndexOffset - vertexEnd &&
+		fwrite(pData->mIndices.data(), sizeof(uint32_t), header.mIndexCount, pFile) == header.mIndexCount;
+	written = fclose(pFile) == 0 && written;
+	if (!written)
+	{
+		SHEN_CORE_ERROR("failed to write {0}", pFileName);
+		remove(pFileName);
+	}
+	return written;
+}
+
+bool cookMesh(const char* pSrcFileName, const char* pDstFileName, uint32_t flags)
+{
+	MeshData data;
+	try
+	{
+		importObjMesh(pSrcFileName, flags, &data);
+	}
+	catch (const std::exception&)
+	{
+		return false;
+	}
+	return writeMeshFile(pDstFileName, &data);
+}
+
+/// <summary>
+/// 校验映射的烘焙文件, 所有区段都必须落在文件内
+/// </summary>
+static bool validateMeshFile(const char* pFileName, const MappedFile* pFile)
+{
+	if (pFile->mSize < sizeof(MeshFileHeader))
+	{
+		SHEN_CORE_ERROR("{0} is too small to be a mesh file", pFileName);
+		return false;
+	}
+	const MeshFileHeader* pHeader = (const MeshFileHeader*)pFile->pData;
+	if (pHeader->mMagic != MESH_FILE_MAGIC)
+	{
+		SHEN_CORE_ERROR("{0} is not a mesh file", pFileName);
+		return false;
+	}
+	if (pHeader->mVersion != MESH_FILE_VERSION)
+	{
+		SHEN_CORE_ERROR("{0} has version {1}, expected {2}; re-cook it with MeshCooker", pFileName, pHeader->mVersion, MESH_FILE_VERSION);
+		return false;
+	}
+	if (!isVertexFormatValid(&pHeader->mVertexFormat) || pHeader->mVertexStride != getVertexFormatStride(&pHeader->mVertexFormat))
+	{
+		SHEN_CORE_ERROR("{0} has an unsupported vertex format", pFileName);
+		return false;
+	}
+	if (pHeader->mFileSize != pFile->mSize ||
+		pHeader->mLodCount == 0 || pHeader->mLodCount > MESH_MAX_LODS ||
+		pHeader->mSubmeshOffset + (uint64_t)pHeader->mSubmeshCount * sizeof(Submesh) > pFile->mSize ||
+		pHeader->mClusterOffset + (uint64_t)pHeader->mClusterCount * sizeof(MeshCluster) > pFile->mSize ||
+		pHeader->mVertexOffset + (uint64_t)pHeader->mVertexCount * pHeader->mVertexStride > pFile->mSize ||
+		pHeader->mIndexOffset + (uint64_t)pHeader->mIndexCount * sizeof(uint32_t) > pFile->mSize ||
+		pHeader->mSubmeshOffset % alignof(Submesh) != 0 || pHeader->mClusterOffset % alignof(MeshCluster) != 0 ||
+		pHeader->mVertexOffset % MESH_FILE_STREAM_ALIGNMENT != 0 ||
+		pHeader->mIndexOffset % MESH_FILE_STREAM_ALIGNMENT != 0)
+	{
+		SHEN_CORE_ERROR("{0} is truncated or corrupt", pFileName);
+		return false;
+	}
+	for (uint32_t lod = 0; lod < pHeader->mLodCount; ++lod)
+	{
+		if ((uint64_t)pHeader->mLods[lod].mFirstIndex + pHeader->mLods[lod].mIndexCount > pHeader->mIndexCount)
+		{
+			SHEN_CORE_ERROR("{0} has an out of range LOD {1}", pFileName, lod);
+			return false;
+		}
+	}
+	// 簇只覆盖 LOD 0 的三角形
+	const MeshFileCluster* pClusters = (const MeshFileCluster*)(pFile->pData + pHeader->mClusterOffset);
+	for (uint32_t i = 0; i < pHeader->mClusterCount; ++i)
+	{
+		if (pClusters[i].mFirstIndex < pHeader->mLods[0].mFirstIndex ||
+			(uint64_t)pClusters[i].mFirstIndex + pClusters[i].mIndexCount > (uint64_t)pHeader->mLods[0].mFirstIndex + pHeader->mLods[0].mIndexCount)
+		{
+			SHEN_CORE_ERROR("{0} has an out of range cluster {1}", pFileName, i);
+			return false;
+		}
+	}
+	const Submesh* pSubmeshes = (const Submesh*)(pFile->pData + pHeader->mSubmeshOffset);
+	for (uint32_t i = 0; i < pHeader->mSubmeshCount; ++i)
+	{
+		if ((uint64_t)pSubmeshes[i].mFirstCluster + pSubmeshes[i].mClusterCount > pHeader->mClusterCount)
+		{
+			SHEN_CORE_ERROR("{0} has an out of range cluster list in submesh {1}", pFileName, i);
+			return false;
+		}
+		// 子网格的每个 LOD 都必须落在网格同一 LOD 的区间内
+		for (uint32_t lod = 0; lod < pHeader->mLodCount; ++lod)
+		{
+			const MeshIndexRange* pRange = &pSubmeshes[i].mLods[lod];
+			if (pRange->mFirstIndex < pHeader->mLods[lod].mFirstIndex ||
+				(uint64_t)pRange->mFirstIndex + pRange->mIndexCount > (uint64_t)pHeader->mLods[lod].mFirstIndex + pHeader->mLods[lod].mIndexCount)
+			{
+				SHEN_CORE_ERROR("{0} has an out of range LOD {1} in submesh {2}", pFileName, lod, i);
+				return false;
+			}
+		}
+	}
+	// 越界的索引会让 GPU 读到几何缓冲中其他网格的顶点, 加载时逐个检查
+	const uint32_t* pIndices = (const uint32_t*)(pFile->pData + pHeader->mIndexOffset);
+	uint32_t maxIndex = 0;
+	for (uint32_t i = 0; i < pHeader->mIndexCount; ++i)
+		maxIndex = std::max(maxIndex, pIndices[i]);
+	if (pHeader->mIndexCount > 0 && maxIndex >= pHeader->mVertexCount)
+	{
+		SHEN_CORE_ERROR("{0} references vertex {1} but has only {2} vertices", pFileName, maxIndex, pHeader->mVertexCount);
+		return false;
+	}
+	return true;
+}
+
+/// <summary>
+/// 经由暂存缓冲把顶点与索引拷贝到几何缓冲的子区间, 簇表拷贝到簇缓冲, 并等待队列空闲
+/// 源数据可以直接是映射文件中的流
+/// </summary>
+static void uploadMesh(Renderer* pRenderer, Queue* pQueue, Mesh* pMesh, const void* pVertices, const void* pIndices)
+{
+	SHEN_PROFILE_FUNCTION();
+	GeometryBuffer* pGeometryBuffer = pMesh->pGeometryBuffer;
+	uint64_t clusterSize = (uint64_t)pMesh->mClusterCount * sizeof(MeshCluster);
+	uint64_t clusterOffset = pMesh->mVertexRange.mSize + pMesh->mIndexRange.mSize;
+
+	BufferDesc stagingDesc = {};
+	stagingDesc.mSize = clusterOffset + clusterSize;
+	stagingDesc.mUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	stagingDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+	Buffer* pStagingBuffer;
+	addBuffer(pRenderer, &stagingDesc, &pStagingBuffer);
+	memcpy(pStagingBuffer->pCpuMappedAddress, pVertices, pMesh->mVertexRange.mSize);
+	memcpy((uint8_t*)pStagingBuffer->pCpuMappedAddress + pMesh->mVertexRange.mSize, pIndices, pMesh->mIndexRange.mSize);
+	if (clusterSize)
+		memcpy((uint8_t*)pStagingBuffer->pCpuMappedAddress + clusterOffset, pMesh->pClusters, clusterSize);
+
+	CmdPoolDesc cmdPoolDesc = {};
+	cmdPoolDesc.pQueue = pQueue;
+	cmdPoolDesc.mTransient = true;
+	CmdPool* pCmdPool;
+	addCmdPool(pRenderer, &cmdPoolDesc, &pCmdPool);
+	CmdDesc cmdDesc = {};
+	cmdDesc.pPool = pCmdPool;
+	Cmd* pCmd;
+	addCmd(pRenderer, &cmdDesc, &pCmd);
+
+	beginCmd(pCmd);
+	cmdCopyBuffer(pCmd, pGeometryBuffer->pVertexBuffer, pMesh->mVertexRange.mOffset, pStagingBuffer, 0, pMesh->mVertexRange.mSize);
+	cmdCopyBuffer(pCmd, pGeometryBuffer->pIndexBuffer, pMesh->mIndexRange.mOffset, pStagingBuffer, pMesh->mVertexRange.mSize, pMesh->mIndexRange.mSize);
+	cmdBufferBarrier(pCmd, pGeometryBuffer->pVertexBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT);
+	cmdBufferBarrier(pCmd, pGeometryBuffer->pIndexBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+		VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_ACCESS_INDEX_READ_BIT);
+	if (clusterSize)
+	{
+		cmdCopyBuffer(pCmd, pMesh->pClusterBuffer, 0, pStagingBuffer, clusterOffset, clusterSize);
+		cmdBufferBarrier(pCmd, pMesh->pClusterBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+			VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+	}
+	endCmd(pCmd);
+
+	QueueSubmitDesc submitDesc = {};
+	submitDesc.ppCmds = &pCmd;
+	submitDesc.mCmdCount = 1;
+	queueSubmit(pQueue, &submitDesc);
+	waitQueueIdle(pQueue);
+
+	removeCmd(pRenderer, pCmd);
+	removeCmdPool(pRenderer, pCmdPool);
+	removeBuffer(pRenderer, pStagingBuffer);
+}
+
+/// <summary>
+/// 按文件头创建网格, 从几何缓冲子分配区间并上传; 导入与加载烘焙文件两条路径共用
+/// </summary>
+static Mesh* createMesh(Renderer* pRenderer, const MeshDesc* pDesc, const MeshFileHeader* pHeader, const Submesh* pSubmeshes,
+	const MeshCluster* pClusters, const void* pVertices, const void* pIndices)
+{
+	Mesh* pMesh = shen_new(MEMORY_CATEGORY_ASSETS, Mesh);
+	memset(pMesh, 0, sizeof(*pMesh));
+	pMesh->pGeometryBuffer = pDesc->pGeometryBuffer;
+	memcpy(pMesh->mBoundsMin, pHeader->mBoundsMin, sizeof(pMesh->mBoundsMin));
+	memcpy(pMesh->mBoundsMax, pHeader->mBoundsMax, sizeof(pMesh->mBoundsMax));
+	pMesh->mLodCount = pHeader->mLodCount;
+	memcpy(pMesh->mLodErrors, pHeader->mLodErrors, sizeof(pMesh->mLodErrors));
+	memcpy(pMesh->mLods, pHeader->mLods, sizeof(pMesh->mLods));
+	pMesh->mSubmeshCount = pHeader->mSubmeshCount;
+	if (pMesh->mSubmeshCount)
+	{
+		pMesh->pSubmeshes = (Submesh*)shen_malloc(MEMORY_CATEGORY_ASSETS, pMesh->mSubmeshCount * sizeof(Submesh));
+		memcpy(pMesh->pSubmeshes, pSubmeshes, pMesh->mSubmeshCount * sizeof(Submesh));
+	}
+	pMesh->mClusterCount = pHeader->mClusterCount;
+	if (pMesh->mClusterCount)
+	{
+		pMesh->pClusters = (MeshCluster*)shen_malloc(MEMORY_CATEGORY_ASSETS, pMesh->mClusterCount * sizeof(MeshCluster));
+		memcpy(pMesh->pClusters, pClusters, pMesh->mClusterCount * sizeof(MeshCluster));
+		BufferDesc clusterBufferDesc = {};
+		clusterBufferDesc.mSize = pMesh->mClusterCount * sizeof(MeshCluster);
+		clusterBufferDesc.mUsage = VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+		clusterBufferDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_GPU_ONLY;
+		try
+		{
+			addBuffer(pRenderer, &clusterBufferDesc, &pMesh->pClusterBuffer);
+		}
+		catch (...)
+		{
+			shen_free(pMesh->pSubmeshes);
+			shen_free(pMesh->pClusters);
+			shen_delete(pMesh);
+			throw;
+		}
+	}
+
+	pMesh->mVertexFormat = pHeader->mVertexFormat;
+	pMesh->mDequantization = pHeader->mDequantization;
+	pMesh->mVertexStride = pHeader->mVertexStride;
+
+	// 顶点区间按该网格的顶点大小对齐, 使偏移能换算为 cmdDrawIndexed 的 vertexOffset
+	// 不同格式的网格可以共用几何缓冲, 绑定同一缓冲后由各自的管线布局解释
+	GeometryBuffer* pGeometryBuffer = pDesc->pGeometryBuffer;
+	if (!allocateRange(pGeometryBuffer->mFreeVertexRanges, (uint64_t)pHeader->mVertexCount * pHeader->mVertexStride, pHeader->mVertexStride, &pMesh->mVertexRange))
+	{
+		if (pMesh->pClusterBuffer)
+			removeBuffer(pRenderer, pMesh->pClusterBuffer);
+		shen_free(pMesh->pSubmeshes);
+		shen_free(pMesh->pClusters);
+		shen_delete(pMesh);
+		SHEN_CORE_ERROR("geometry buffer is out of vertex space for mesh {0}", pDesc->pFileName);
+		throw std::runtime_error("geometry buffer is full!");
+	}
+	if (!allocateRange(pGeometryBuffer->mFreeIndexRanges, (uint64_t)pHeader->mIndexCount * sizeof(uint32_t), sizeof(uint32_t), &pMesh->mIndexRange))
+	{
+		freeRange(pGeometryBuffer->mFreeVertexRanges, pMesh->mVertexRange);
+		if (pMesh->pClusterBuffer)
+			removeBuffer(pRenderer, pMesh->pClusterBuffer);
+		shen_free(pMesh->pSubmeshes);
+		shen_free(pMesh->pClusters);
+		shen_delete(pMesh);
+		SHEN_CORE_ERROR("geometry buffer is out of index space for mesh {0}", pDesc->pFileName);
+		throw std::runtime_error("geometry buffer is full!");
+	}
+	pMesh->mFirstVertex = (uint32_t)(pMesh->mVertexRange.mOffset / pHeader->mVertexStride);
+	pMesh->mVertexCount = pHeader->mVertexCount;
+	pMesh->mFirstIndex = (uint32_t)(pMesh->mIndexRange.mOffset / sizeof(uint32_t));
+	pMesh->mIndexCount = pHeader->mIndexCount;
+
+	uploadMesh(pRenderer, pDesc->pQueue, pMesh, pVertices, pIndices);
+	return pMesh;
+}
+
+static bool isCookedMeshFile(const char* pFileName)
+{
+	size_t length = strlen(pFileName);
+	size_t extensionLength = strlen(MESH_FILE_EXTENSION);
+	return length >= extensionLength && !strcmp(pFileName + length - extensionLength, MESH_FILE_EXTENSION);
+}
+
+/// <summary>
+/// 添加网格
+/// .smesh 文件映射后校验文件头, 顶点与索引流直接从映射内存拷贝到暂存缓冲, 耗时只取决于磁盘带宽
+/// 其余文件按 OBJ 导入, 适合资源迭代, 发布的资源应先用 MeshCooker 烘焙
+/// </summary>
+void addMesh(Renderer* pRenderer, const MeshDesc* pDesc, Mesh** ppMesh)
+{
+	SHEN_PROFILE_FUNCTION();
+	if (isCookedMeshFile(pDesc->pFileName))
+	{
+		MappedFile file;
+		if (!openMappedFile(pDesc->pFileName, true, &file))
+			throw std::runtime_error("failed to load mesh!");
+		if (!validateMeshFile(pDesc->pFileName, &file))
+		{
+			closeMappedFile(&file);
+			throw std::runtime_error("failed to load mesh!");
+		}
+
+		const MeshFileHeader* pHeader = (const MeshFileHeader*)file.pData;
+		try
+		{
+			*ppMesh = createMesh(pRenderer, pDesc, pHeader, (const Submesh*)(file.pData + pHeader->mSubmeshOffset),
+				(const MeshCluster*)(file.pData + pHeader->mClusterOffset), file.pData + pHeader->mVertexOffset, file.pData + pHeader->mIndexOffset);
+		}
+		catch (...)
+		{
+			closeMappedFile(&file);
+			throw;
+		}
+		closeMappedFile(&file);
+		return;
+	}
+
+	MeshData data;
+	importObjMesh(pDesc->pFileName, pDesc->mFlags, &data);
+	*ppMesh = createMesh(pRenderer, pDesc, &data.mHeader, data.mSubmeshes.data(), data.mClusters.data(), data.mVertexData.data(), data.mIndices.data());
+}
+
+void removeMesh(Renderer* pRenderer, Mesh* pMesh)
+{
+	freeRange(pMesh->pGeometryBuffer->mFreeVertexRanges, pMesh->mVertexRange);
+	freeRange(pMesh->pGeometryBuffer->mFreeIndexRanges, pMesh->mIndexRange);
+	if (pMesh->pClusterBuffer)
+		removeBuffer(pRenderer, pMesh->pClusterBuffer);
+	shen_free(pMesh->pSubmeshes);
+	shen_free(pMesh->pClusters);
+	shen_delete(pMesh);
+}
+
+float getMeshLodProjectionScale(float fovY, float viewportHeight)
+{
+	return viewportHeight / (2.0f * tanf(fovY * 0.5f));
+}
+
+/// <summary>
+/// 投影误差 = LOD 误差 * 网格包围盒最大边长 * 实例缩放 / 距离 * 像素比例
+/// 从 LOD 1 开始逐级检查, 比当前更粗的一级需要误差不超过收紧后的阈值, 当前及更细的一级只需不超过阈值
+/// 因此距离在临界值附近小幅变化时保持当前 LOD, 超出阈值时立即换回更细的一级
+/// </summary>
+uint32_t selectMeshLod(const Mesh* pMesh, const MeshLodSelectDesc* pDesc, uint32_t currentLod)
+{
+	if (pMesh->mLodCount <= 1 || pDesc->mDistance <= 0.0f)
+		return 0;
+
+	float extent = 0.0f;
+	for (uint32_t c = 0; c < 3; ++c)
+		extent = std::max(extent, pMesh->mBoundsMax[c] - pMesh->mBoundsMin[c]);
+	float pixelsPerError = extent * pDesc->mScale * pDesc->mProjectionScale / pDesc->mDistance;
+
+	uint32_t lod = 0;
+	for (uint32_t i = 1; i < pMesh->mLodCount; ++i)
+	{
+		float threshold = i > currentLod ? pDesc->mThresholdPixels * (1.0f - pDesc->mHysteresis) : pDesc->mThresholdPixels;
+		if (pMesh->mLodErrors[i] * pixelsPerError > threshold)
+			break;
+		lod = i;
+	}
+	return lod;
+}
+
+// 列主序 4x4 矩阵变换点 (w = 1) 或方向 (w = 0)
+static void transformMeshPoint(float* pDst, const float* pMatrix, const float* pSrc, float w)
+{
+	for (uint32_t r = 0; r < 3; ++r)
+		pDst[r] = pMatrix[r] * pSrc[0] + pMatrix[4 + r] * pSrc[1] + pMatrix[8 + r] * pSrc[2] + pMatrix[12 + r] * w;
+}
+
+// 写出一条间接绘制命令, firstIndex 相对于网格的起始索引
+static void writeMeshDrawCommand(VkDrawIndexedIndirectCommand* pCommand, const Mesh* pMesh, uint32_t firstIndex, uint32_t indexCount)
+{
+	pCommand->indexCount = indexCount;
+	pCommand->instanceCount = 1;
+	pCommand->firstIndex = pMesh->mFirstIndex + firstIndex;
+	pCommand->vertexOffset = (int32_t)pMesh->mFirstVertex;
+	pCommand->firstInstance = 0;
+}
+
+void getMeshClusterCullInstance(const float* pWorldMatrix, MeshClusterCullInstance* pOutInstance)
+{
+	memset(pOutInstance, 0, sizeof(*pOutInstance));
+	memcpy(pOutInstance->mWorldMatrix, pWorldMatrix, sizeof(pOutInstance->mWorldMatrix));
+	const float* w = pWorldMatrix;
+	float radiusScale = 0.0f;
+	for (uint32_t c = 0; c < 3; ++c)
+		radiusScale = std::max(radiusScale, w[c * 4] * w[c * 4] + w[c * 4 + 1] * w[c * 4 + 1] + w[c * 4 + 2] * w[c * 4 + 2]);
+	pOutInstance->mRadiusScale = sqrtf(radiusScale);
+}
+
+/// <summary>
+/// 视锥平面由视图投影矩阵的行组合得到 (Gribb-Hartmann), 平面法线指向视锥内部, 因此球心到任一平面的距离小于 -半径时不可见
+/// </summary>
+void getMeshClusterCullConstants(const Mesh* pMesh, const MeshClusterCullDesc* pDesc, uint32_t instanceCount, MeshClusterCullConstants* pOutConstants)
+{
+	memset(pOutConstants, 0, sizeof(*pOutConstants));
+	const float* m = pDesc->pViewProjectionMatrix;
+	for (uint32_t c = 0; c < 4; ++c)
+	{
+		float row0 = m[c * 4 + 0], row1 = m[c * 4 + 1], row2 = m[c * 4 + 2], row3 = m[c * 4 + 3];
+		pOutConstants->mFrustumPlanes[0][c] = row3 + row0;
+		pOutConstants->mFrustumPlanes[1][c] = row3 - row0;
+		pOutConstants->mFrustumPlanes[2][c] = row3 + row1;
+		pOutConstants->mFrustumPlanes[3][c] = row3 - row1;
+		pOutConstants->mFrustumPlanes[4][c] = row2;
+		pOutConstants->mFrustumPlanes[5][c] = row3 - row2;
+	}
+	for (float* pPlane : pOutConstants->mFrustumPlanes)
+	{
+		float length = sqrtf(pPlane[0] * pPlane[0] + pPlane[1] * pPlane[1] + pPlane[2] * pPlane[2]);
+		float invLength = length > 0.0f ? 1.0f / length : 0.0f;
+		for (uint32_t c = 0; c < 4; ++c)
+			pPlane[c] *= invLength;
+	}
+	memcpy(pOutConstants->mCameraPosition, pDesc->mCameraPosition, sizeof(pOutConstants->mCameraPosition));
+	pOutConstants->mConeCulling = pDesc->mConeCulling ? 1 : 0;
+	pOutConstants->mClusterCount = pMesh->mClusterCount;
+	pOutConstants->mInstanceCount = instanceCount;
+	pOutConstants->mFirstIndex = pMesh->mFirstIndex;
+	pOutConstants->mVertexOffset = (int32_t)pMesh->mFirstVertex;
+}
+
+/// <summary>
+/// 单个簇的可见性, 与 cluster_cull.comp 的判断逐项对应
+/// 包围球半径按模型矩阵最大的轴缩放放大, 背面锥的顶点与轴变换到世界空间后与相机位置比较
+/// </summary>
+static bool isMeshClusterVisible(const MeshCluster& cluster, const MeshClusterCullConstants* pConstants, const MeshClusterCullInstance* pInstance)
+{
+	const float* w = pInstance->mWorldMatrix;
+	float center[3];
+	transformMeshPoint(center, w, cluster.mCenter, 1.0f);
+	float radius = cluster.mRadius * pInstance->mRadiusScale;
+	for (const float* pPlane : pConstants->mFrustumPlanes)
+	{
+		if (pPlane[0] * center[0] + pPlane[1] * center[1] + pPlane[2] * center[2] + pPlane[3] < -radius)
+			return false;
+	}
+	if (pConstants->mConeCulling && cluster.mConeCutoff < 1.0f)
+	{
+		float apex[3], axis[3];
+		transformMeshPoint(apex, w, cluster.mConeApex, 1.0f);
+		transformMeshPoint(axis, w, cluster.mConeAxis, 0.0f);
+		const float* pCamera = pConstants->mCameraPosition;
+		float toApex[3] = { apex[0] - pCamera[0], apex[1] - pCamera[1], apex[2] - pCamera[2] };
+		float lengthProduct = sqrtf((toApex[0] * toApex[0] + toApex[1] * toApex[1] + toApex[2] * toApex[2]) *
+			(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2]));
+		if (lengthProduct > 0.0f &&
+			toApex[0] * axis[0] + toApex[1] * axis[1] + toApex[2] * axis[2] >= cluster.mConeCutoff * lengthProduct)
+			return false;
+	}
+	return true;
+}
+
+/// <summary>
+/// 逐子网格遍历其簇, 连续可见的簇合并为一条命令, 命令不跨越子网格, 保证每条命令只属于一个材质
+/// </summary>
+uint32_t cullMeshClusters(const Mesh* pMesh, const MeshClusterCullDesc* pDesc, VkDrawIndexedIndirectCommand* pCommands, uint32_t* pOutVisibleClusters)
+{
+	SHEN_PROFILE_FUNCTION();
+	if (pMesh->mClusterCount == 0)
+	{
+		for (uint32_t s = 0; s < pMesh->mSubmeshCount; ++s)
+		{
+			const MeshIndexRange& range = pMesh->pSubmeshes[s].mLods[0];
+			writeMeshDrawCommand(&pCommands[s], pMesh, range.mFirstIndex, range.mIndexCount);
+		}
+		if (pOutVisibleClusters)
+			*pOutVisibleClusters = 0;
+		return pMesh->mSubmeshCount;
+	}
+
+	MeshClusterCullConstants constants;
+	getMeshClusterCullConstants(pMesh, pDesc, 1, &constants);
+	MeshClusterCullInstance instance;
+	getMeshClusterCullInstance(pDesc->pWorldMatrix, &instance);
+
+	uint32_t commandCount = 0;
+	uint32_t visibleClusters = 0;
+	for (uint32_t s = 0; s < pMesh->mSubmeshCount; ++s)
+	{
+		const Submesh& submesh = pMesh->pSubmeshes[s];
+		uint32_t runEnd = UINT32_MAX;
+		for (uint32_t i = submesh.mFirstCluster; i < submesh.mFirstCluster + submesh.mClusterCount; ++i)
+		{
+			const MeshCluster& cluster = pMesh->pClusters[i];
+			if (!isMeshClusterVisible(cluster, &constants, &instance))
+				continue;
+
+			++visibleClusters;
+			if (cluster.mFirstIndex == runEnd)
+				pCommands[commandCount - 1].indexCount += cluster.mIndexCount;
+			else
+				writeMeshDrawCommand(&pCommands[commandCount++], pMesh, cluster.mFirstIndex, cluster.mIndexCount);
+			runEnd = cluster.mFirstIndex + cluster.mIndexCount;
+		}
+	}
+	if (pOutVisibleClusters)
+		*pOutVisibleClusters = visibleClusters;
+	return commandCount;
+}
+
+/// <summary>
+/// 工作组 x 方向覆盖簇, y 方向为实例, 实例数受 maxComputeWorkGroupCount[1] 限制 (至少 65535)
+/// </summary>
+void cmdCullMeshClusters(Cmd* pCmd, const Mesh* pMesh, Pipeline* pPipeline, DescriptorSet* pDescriptorSet,
+	const MeshClusterCullConstants* pConstants, Buffer* pCommandBuffer)
+{
+	if (pMesh->mClusterCount == 0 || pConstants->mInstanceCount == 0)
+		return;
+
+	cmdBindPipeline(pCmd, pPipeline);
+	cmdBindDescriptorSet(pCmd, pDescriptorSet);
+	cmdPushConstants(pCmd, pConstants, sizeof(*pConstants));
+	cmdDispatch(pCmd, (pMesh->mClusterCount + MESH_CLUSTER_CULL_GROUP_SIZE - 1) / MESH_CLUSTER_CULL_GROUP_SIZE, pConstants->mInstanceCount, 1);
+	cmdBufferBarrier(pCmd, pCommandBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT,
+		VK_PIPELINE_STAGE_DRAW_INDIRECT_BIT, VK_ACCESS_INDIRECT_COMMAND_READ_BIT);
+}
+
+void cmdBindGeometryBuffer(Cmd* pCmd, GeometryBuffer* pGeometryBuffer)
+{
+	cmdBindVertexBuffer(pCmd, pGeometryBuffer->pVertexBuffer, 0);
+	cmdBindIndexBuffer(pCmd, pGeometryBuffer->pIndexBuffer, 0, VK_INDEX_TYPE_UINT32);
+}
+
+void cmdDrawMesh(Cmd* pCmd, const Mesh* pMesh)
+{
+	cmdDrawMeshLod(pCmd, pMesh, 0);
+}
+
+void cmdDrawMeshLod(Cmd* pCmd, const Mesh* pMesh, uint32_t lod)
+{
+	const MeshIndexRange& range = pMesh->mLods[std::min(lod, pMesh->mLodCount - 1)];
+	cmdDrawIndexed(pCmd, range.mIndexCount, pMesh->mFirstIndex + range.mFirstIndex, (int32_t)pMesh->mFirstVertex);
+}
+
+void cmdDrawSubmesh(Cmd* pCmd, const Mesh* pMesh, uint32_t submesh, uint32_t lod)
+{
+	const MeshIndexRange& range = pMesh->pSubmeshes[submesh].mLods[std::min(lod, pMesh->mLodCount - 1)];
+	cmdDrawIndexed(pCmd, range.mIndexCount, pMesh->mFirstIndex + range.mFirstIndex, (int32_t)pMesh->mFirstVertex);
+}
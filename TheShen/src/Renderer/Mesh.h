@@ -0,0 +1,224 @@
+#pragma once
+
+#include "Renderer.h"
+#include "MeshFormat.h"
+#include "Core/Memory.h"
+
+/// <summary>
+/// 导入与优化时使用的顶点, 单一交错顶点流; 上传前按网格的 VertexFormat 编码
+/// </summary>
+typedef struct MeshVertex
+{
+	float mPosition[3];
+	float mNormal[3];
+	float mTexCoord[2];
+} MeshVertex;
+
+typedef enum MeshLoadFlags
+{
+	MESH_LOAD_FLAG_NONE = 0,
+	// 只做顶点去重, 跳过顶点缓存/过度绘制/顶点读取优化, 用于快速迭代资源
+	MESH_LOAD_FLAG_SKIP_OPTIMIZATION = 1 << 0,
+	// 压缩顶点: 位置 SNORM16 + 八面体法线 SNORM16 + UV UNORM16, 每顶点 16 字节 (默认全部 float, 32 字节)
+	MESH_LOAD_FLAG_COMPACT_VERTICES = 1 << 1,
+	// 以二次误差边折叠逐级简化生成 LOD 链 (每级约为上一级的一半三角形), MeshCooker 默认开启
+	MESH_LOAD_FLAG_GENERATE_LODS = 1 << 2,
+	// 把 LOD 0 分成小簇 (64 顶点 / 124 三角形) 并记录包围球与背面锥, 用 cmdCullMeshClusters (GPU) 或 cullMeshClusters (CPU) 做子网格级的剔除
+	// 簇内三角形按空间邻接排列, 取代过度绘制优化的三角形顺序; MeshCooker 默认开启
+	MESH_LOAD_FLAG_GENERATE_CLUSTERS = 1 << 3,
+} MeshLoadFlags;
+
+/// <summary>
+/// 共享几何缓冲描述, 容量以字节计
+/// </summary>
+typedef struct GeometryBufferDesc
+{
+	uint64_t mVertexBufferSize;
+	uint64_t mIndexBufferSize;
+} GeometryBufferDesc;
+
+typedef struct BufferRange
+{
+	uint64_t mOffset;
+	uint64_t mSize;
+} BufferRange;
+
+typedef std::vector<BufferRange, CategoryAllocator<BufferRange, MEMORY_CATEGORY_ASSETS>> BufferRangeList;
+
+/// <summary>
+/// 共享几何缓冲, 多个网格从同一对顶点/索引缓冲中子分配, 绘制时只需绑定一次
+/// 空闲区间按偏移有序, 首次适配分配, 释放时与相邻区间合并
+/// </summary>
+typedef struct GeometryBuffer
+{
+	Buffer*			pVertexBuffer;
+	Buffer*			pIndexBuffer;
+	BufferRangeList	mFreeVertexRanges;
+	BufferRangeList	mFreeIndexRanges;
+} GeometryBuffer;
+
+/// <summary>
+/// 网格描述
+/// </summary>
+typedef struct MeshDesc
+{
+	// .obj 在加载时解析并优化; .smesh (MeshCooker 的输出) 映射后直接上传, 不做任何解析
+	const char*		pFileName;
+	GeometryBuffer*	pGeometryBuffer;
+	// 执行上传拷贝的队列, addMesh 返回前会等待该队列空闲
+	Queue*			pQueue;
+	// MeshLoadFlags, 只作用于 .obj
+	uint32_t		mFlags;
+} MeshDesc;
+
+/// <summary>
+/// LOD 选择参数: 把每级 LOD 的简化误差投影到屏幕上, 选择误差不超过阈值的最粗一级
+/// </summary>
+typedef struct MeshLodSelectDesc
+{
+	// 相机到实例包围球的距离 (世界空间), 不大于 0 时 (相机在包围球内) 选择 LOD 0
+	float mDistance;
+	// 实例变换的最大缩放分量
+	float mScale;
+	// 每单位视空间距离 (距离为 1 处) 对应的像素数, 由 getMeshLodProjectionScale 计算
+	float mProjectionScale;
+	// 允许的屏幕空间误差 (像素)
+	float mThresholdPixels;
+	// [0, 1): 切换到更粗的 LOD 时阈值收紧的比例, 防止在临界距离附近来回切换
+	float mHysteresis;
+} MeshLodSelectDesc;
+
+/// <summary>
+/// 簇剔除参数, 矩阵均为列主序 4x4
+/// </summary>
+typedef struct MeshClusterCullDesc
+{
+	// 模型矩阵
+	const float*	pWorldMatrix;
+	// 视图投影矩阵, 裁剪空间深度范围 [0, 1]
+	const float*	pViewProjectionMatrix;
+	// 世界空间的相机位置
+	float			mCameraPosition[3];
+	// 背面锥剔除假定模型矩阵为均匀缩放, 非均匀缩放或双面材质时应关闭
+	bool			mConeCulling;
+} MeshClusterCullDesc;
+
+// 簇剔除计算着色器的工作组大小, 每个线程处理一个实例的一个簇
+#define MESH_CLUSTER_CULL_GROUP_SIZE 64
+
+/// <summary>
+/// 簇剔除的实例数据, 计算着色器按 std430 读取 (binding 1)
+/// </summary>
+typedef struct MeshClusterCullInstance
+{
+	// 模型矩阵, 列主序
+	float		mWorldMatrix[16];
+	// 模型矩阵最大的轴缩放, 用于放大簇的包围球半径
+	float		mRadiusScale;
+	uint32_t	mReserved[3];
+} MeshClusterCullInstance;
+
+/// <summary>
+/// 簇剔除计算着色器的推送常量, 正好占满 Vulkan 保证的 128 字节
+/// </summary>
+typedef struct MeshClusterCullConstants
+{
+	// 归一化的视锥平面, 法线指向视锥内部
+	float		mFrustumPlanes[6][4];
+	float		mCameraPosition[3];
+	uint32_t	mConeCulling;
+	uint32_t	mClusterCount;
+	uint32_t	mInstanceCount;
+	// 网格在几何缓冲中的起始索引与顶点, 写入命令的 firstIndex 与 vertexOffset
+	uint32_t	mFirstIndex;
+	int32_t		mVertexOffset;
+} MeshClusterCullConstants;
+
+// 运行时子网格与簇与文件中的布局相同, 加载烘焙文件时整表拷贝
+typedef MeshFileSubmesh Submesh;
+typedef MeshFileCluster MeshCluster;
+
+/// <summary>
+/// 网格, 顶点与索引位于所属几何缓冲的子区间内, 索引为 32 位
+/// 索引流依次存放各 LOD, 每个 LOD 内子网格连续存放
+/// </summary>
+typedef struct Mesh
+{
+	GeometryBuffer*	pGeometryBuffer;
+	BufferRange		mVertexRange;
+	BufferRange		mIndexRange;
+	// 以顶点/索引为单位的起始位置, 直接用于 cmdDrawIndexed
+	uint32_t		mFirstVertex;
+	uint32_t		mVertexCount;
+	uint32_t		mFirstIndex;
+	uint32_t		mIndexCount;
+	float			mBoundsMin[3];
+	float			mBoundsMax[3];
+	uint32_t		mLodCount;
+	float			mLodErrors[MESH_MAX_LODS];
+	MeshIndexRange	mLods[MESH_MAX_LODS];
+	Submesh*		pSubmeshes;
+	uint32_t		mSubmeshCount;
+	// LOD 0 的簇, 未生成簇时为空
+	MeshCluster*	pClusters;
+	uint32_t		mClusterCount;
+	// 簇表的 GPU 副本 (存储缓冲, std430), 供 cmdCullMeshClusters 读取, 未生成簇时为空
+	Buffer*			pClusterBuffer;
+	// 顶点编码, 绘制该网格的管线用 getVertexFormatLayout 生成顶点布局
+	VertexFormat			mVertexFormat;
+	VertexDequantization	mDequantization;
+	uint32_t				mVertexStride;
+} Mesh;
+
+// 添加共享几何缓冲
+void addGeometryBuffer(Renderer* pRenderer, const GeometryBufferDesc* pDesc, GeometryBuffer** ppGeometryBuffer);
+// 释放共享几何缓冲, 调用前需释放其中的全部网格
+void removeGeometryBuffer(Renderer* pRenderer, GeometryBuffer* pGeometryBuffer);
+// 从 OBJ 文件导入网格: 顶点去重, 重排索引与顶点, 同步上传到几何缓冲
+void addMesh(Renderer* pRenderer, const MeshDesc* pDesc, Mesh** ppMesh);
+// 释放网格, 归还几何缓冲中的区间; 调用前需确保使用该网格的提交已完成
+void removeMesh(Renderer* pRenderer, Mesh* pMesh);
+// 获取未压缩网格 (MeshVertex) 的顶点布局: location 0 位置, 1 法线, 2 纹理坐标
+const VertexLayout* getMeshVertexLayout();
+// 导入并优化 OBJ, 写出烘焙网格文件 (见 MeshFormat.h); 失败时返回 false, 不会留下不完整的文件
+bool cookMesh(const char* pSrcFileName, const char* pDstFileName, uint32_t flags);
+
+// 透视投影的像素比例: viewportHeight / (2 * tan(fovY / 2)), fovY 为弧度
+float getMeshLodProjectionScale(float fovY, float viewportHeight);
+// 按投影误差为一个实例选择 LOD, currentLod 为该实例上一帧的 LOD (用于滞后), 返回值可直接用于 cmdDrawMeshLod
+uint32_t selectMeshLod(const Mesh* pMesh, const MeshLodSelectDesc* pDesc, uint32_t currentLod);
+
+// 由模型矩阵填写簇剔除的实例数据
+void getMeshClusterCullInstance(const float* pWorldMatrix, MeshClusterCullInstance* pOutInstance);
+// 由剔除参数计算推送常量 (pDesc->pWorldMatrix 不使用, 模型矩阵来自实例数据)
+void getMeshClusterCullConstants(const Mesh* pMesh, const MeshClusterCullDesc* pDesc, uint32_t instanceCount, MeshClusterCullConstants* pOutConstants);
+
+/// <summary>
+/// CPU 参考实现与回退路径: 按视锥与背面锥剔除一个实例的 LOD 0 簇, 同一子网格内索引流相邻的可见簇合并为一条命令
+/// 命令不跨越子网格, firstInstance 为 0 (非 0 需要 drawIndirectFirstInstance 特性)
+/// pCommands 至少容纳 max(mClusterCount, mSubmeshCount) 条; 没有簇的网格为每个子网格输出整个 LOD 0
+/// 返回命令数, 写入带 VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT 的缓冲后用 cmdDrawIndexedIndirect 绘制
+/// 可见性判断与 cmdCullMeshClusters 相同, 两者得到的可见簇集合一致
+/// </summary>
+uint32_t cullMeshClusters(const Mesh* pMesh, const MeshClusterCullDesc* pDesc, VkDrawIndexedIndirectCommand* pCommands, uint32_t* pOutVisibleClusters);
+
+/// <summary>
+/// GPU 簇剔除: 一次分派剔除 instanceCount 个实例的全部簇, 需在渲染通道外录制, 网格必须带簇
+/// pPipeline 为簇剔除计算管线 (三个存储缓冲, 推送常量为 MeshClusterCullConstants)
+/// pDescriptorSet 依次绑定 pMesh->pClusterBuffer, 实例数据 (MeshClusterCullInstance 数组) 与 pCommandBuffer
+/// 每个簇占固定的一条命令: 实例 i 的簇 c 写在第 i * mClusterCount + c 条, 被剔除的簇 instanceCount 为 0,
+/// 因此不需要 drawIndirectCount, 实例 i 用 cmdDrawIndexedIndirect 从其起始处绘制 mClusterCount 条
+/// 录制的屏障使命令对随后的间接绘制可见
+/// 只做视锥与背面锥剔除; 渲染器尚不支持深度附件, 没有可供构建的深度金字塔, 因此不做 Hi-Z 遮挡剔除
+/// </summary>
+void cmdCullMeshClusters(Cmd* pCmd, const Mesh* pMesh, Pipeline* pPipeline, DescriptorSet* pDescriptorSet,
+	const MeshClusterCullConstants* pConstants, Buffer* pCommandBuffer);
+
+// 绑定几何缓冲的顶点与索引缓冲, 同一几何缓冲中的网格之间无需重新绑定
+void cmdBindGeometryBuffer(Cmd* pCmd, GeometryBuffer* pGeometryBuffer);
+// 绘制网格的 LOD 0, 需先绑定其所属的几何缓冲
+void cmdDrawMesh(Cmd* pCmd, const Mesh* pMesh);
+// 绘制网格某个 LOD 的全部子网格, lod 超出时使用最粗的一级
+void cmdDrawMeshLod(Cmd* pCmd, const Mesh* pMesh, uint32_t lod);
+// 绘制单个子网格
+void cmdDrawSubmesh(Cmd* pCmd, const Mesh* pMesh, uint32_t submesh, uint32_t lod);
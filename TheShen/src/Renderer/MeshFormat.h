@@ -0,0 +1,93 @@
+#pragma once
+
+#include "VertexFormat.h"
+
+#include <cstdint>
+
+// 烘焙网格文件 (.smesh) 的二进制布局, 由 MeshCooker 写出, addMesh 映射后直接读取
+// 文件为小端序, 各结构体按原样写入, 修改任何结构体都必须递增 MESH_FILE_VERSION
+//
+// [MeshFileHeader][MeshFileSubmesh x mSubmeshCount][MeshFileCluster x mClusterCount][对齐填充][顶点流][对齐填充][索引流]
+
+#define MESH_FILE_MAGIC 0x48534D53u // "SMSH"
+#define MESH_FILE_VERSION 3
+#define MESH_FILE_EXTENSION ".smesh"
+// 顶点流与索引流的起始偏移按此对齐, 映射后的指针可以直接作为 SIMD 拷贝的源
+#define MESH_FILE_STREAM_ALIGNMENT 64
+// 每个网格/子网格最多保存的 LOD 层级数
+#define MESH_MAX_LODS 8
+#define MESH_SUBMESH_NAME_LENGTH 64
+
+/// <summary>
+/// 索引区间, 以索引为单位, 相对于网格索引流的起点
+/// </summary>
+typedef struct MeshIndexRange
+{
+	uint32_t mFirstIndex;
+	uint32_t mIndexCount;
+} MeshIndexRange;
+
+/// <summary>
+/// 文件头, 偏移均相对于文件起点
+/// </summary>
+typedef struct MeshFileHeader
+{
+	uint32_t		mMagic;
+	uint32_t		mVersion;
+	uint32_t		mVertexStride;
+	uint32_t		mVertexCount;
+	uint32_t		mIndexCount;
+	uint32_t		mSubmeshCount;
+	uint32_t		mLodCount;
+	// LOD 0 的簇数, 未生成簇时为 0
+	uint32_t		mClusterCount;
+	uint64_t		mSubmeshOffset;
+	uint64_t		mClusterOffset;
+	uint64_t		mVertexOffset;
+	uint64_t		mIndexOffset;
+	// 整个文件的字节数, 用于检测截断的文件
+	uint64_t		mFileSize;
+	float			mBoundsMin[3];
+	float			mBoundsMax[3];
+	// 每个 LOD 相对于原始网格的简化误差 (以包围盒最大边长为单位), LOD 0 为 0
+	float			mLodErrors[MESH_MAX_LODS];
+	// 每个 LOD 覆盖全部子网格的索引区间, 同一 LOD 的子网格在索引流中连续存放
+	MeshIndexRange	mLods[MESH_MAX_LODS];
+	// 顶点流的编码, mVertexStride 等于其 getVertexFormatStride
+	VertexFormat			mVertexFormat;
+	VertexDequantization	mDequantization;
+} MeshFileHeader;
+
+/// <summary>
+/// 子网格, 对应 OBJ 中的一个 shape
+/// </summary>
+typedef struct MeshFileSubmesh
+{
+	char			mName[MESH_SUBMESH_NAME_LENGTH];
+	float			mBoundsMin[3];
+	float			mBoundsMax[3];
+	MeshIndexRange	mLods[MESH_MAX_LODS];
+	// 子网格 LOD 0 的簇在簇表中的区间, 这些簇依次覆盖 mLods[0]
+	uint32_t		mFirstCluster;
+	uint32_t		mClusterCount;
+} MeshFileSubmesh;
+
+/// <summary>
+/// 簇: LOD 0 索引流中连续的一段三角形 (不超过 64 个顶点 / 124 个三角形) 及其模型空间的剔除包围体
+/// 按 16 字节一行排列, 可以原样作为着色器中的 std430 结构数组读取
+/// </summary>
+typedef struct MeshFileCluster
+{
+	float		mCenter[3];
+	float		mRadius;
+	// 背面锥, 见 ClusterBounds
+	float		mConeApex[3];
+	float		mConeCutoff;
+	float		mConeAxis[3];
+	uint32_t	mFirstIndex;
+	uint32_t	mIndexCount;
+	uint32_t	mReserved[3];
+} MeshFileCluster;
+
+static_assert(sizeof(MeshFileCluster) == 64, "MeshFileCluster must stay 16-byte rows for GPU consumption");
+static_assert(sizeof(MeshFileHeader) % 8 == 0, "MeshFileHeader must keep the submesh table 8-byte aligned");
@@ -0,0 +1,628 @@
+#include "MeshOptimizer.h"
+#include "Core/Memory.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+typedef std::vector<uint32_t, CategoryAllocator<uint32_t, MEMORY_CATEGORY_ASSETS>> IndexList;
+
+const uint32_t INVALID_INDEX = ~0u;
+
+static uint32_t hashVertex(const uint8_t* pVertex, size_t vertexSize)
+{
+	// FNV-1a
+	uint32_t hash = 2166136261u;
+	for (size_t i = 0; i < vertexSize; ++i)
+		hash = (hash ^ pVertex[i]) * 16777619u;
+	return hash;
+}
+
+/// <summary>
+/// 开放寻址哈希表 (二次探测) 保存每个不同顶点首次出现的位置, 表大小为 2 的幂且至少为顶点数的 1.25 倍
+/// </summary>
+size_t generateVertexRemap(uint32_t* pRemap, const uint32_t* pIndices, size_t indexCount, const void* pVertices, size_t vertexCount, size_t vertexSize)
+{
+	memset(pRemap, 0xff, vertexCount * sizeof(uint32_t));
+
+	size_t tableSize = 1;
+	while (tableSize < vertexCount + vertexCount / 4)
+		tableSize *= 2;
+	IndexList table(tableSize, INVALID_INDEX);
+	const uint8_t* pBytes = (const uint8_t*)pVertices;
+
+	uint32_t nextVertex = 0;
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		uint32_t index = pIndices ? pIndices[i] : (uint32_t)i;
+		if (pRemap[index] != INVALID_INDEX)
+			continue;
+
+		const uint8_t* pVertex = pBytes + index * vertexSize;
+		size_t bucket = hashVertex(pVertex, vertexSize) & (tableSize - 1);
+		for (size_t probe = 1; table[bucket] != INVALID_INDEX; ++probe)
+		{
+			if (!memcmp(pBytes + table[bucket] * vertexSize, pVertex, vertexSize))
+				break;
+			bucket = (bucket + probe) & (tableSize - 1);
+		}
+
+		if (table[bucket] == INVALID_INDEX)
+		{
+			table[bucket] = index;
+			pRemap[index] = nextVertex++;
+		}
+		else
+		{
+			pRemap[index] = pRemap[table[bucket]];
+		}
+	}
+	return nextVertex;
+}
+
+void remapVertexBuffer(void* pDst, const void* pVertices, size_t vertexCount, size_t vertexSize, const uint32_t* pRemap)
+{
+	for (size_t i = 0; i < vertexCount; ++i)
+	{
+		if (pRemap[i] != INVALID_INDEX)
+			memcpy((uint8_t*)pDst + pRemap[i] * vertexSize, (const uint8_t*)pVertices + i * vertexSize, vertexSize);
+	}
+}
+
+void remapIndexBuffer(uint32_t* pDst, const uint32_t* pIndices, size_t indexCount, const uint32_t* pRemap)
+{
+	for (size_t i = 0; i < indexCount; ++i)
+		pDst[i] = pRemap[pIndices ? pIndices[i] : i];
+}
+
+/// <summary>
+/// 顶点到三角形的邻接表 (CSR 格式)
+/// </summary>
+struct TriangleAdjacency
+{
+	IndexList mOffsets;
+	IndexList mCounts;
+	IndexList mTriangles;
+};
+
+static void buildTriangleAdjacency(TriangleAdjacency* pAdjacency, const uint32_t* pIndices, size_t indexCount, size_t vertexCount)
+{
+	pAdjacency->mCounts.assign(vertexCount, 0);
+	pAdjacency->mOffsets.resize(vertexCount);
+	pAdjacency->mTriangles.resize(indexCount);
+	for (size_t i = 0; i < indexCount; ++i)
+		++pAdjacency->mCounts[pIndices[i]];
+
+	uint32_t offset = 0;
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		pAdjacency->mOffsets[v] = offset;
+		offset += pAdjacency->mCounts[v];
+	}
+	for (size_t i = 0; i < indexCount; ++i)
+		pAdjacency->mTriangles[pAdjacency->mOffsets[pIndices[i]]++] = (uint32_t)(i / 3);
+	// 填充时 mOffsets 被推进到了各自区间的末尾, 退回起点
+	for (size_t v = 0; v < vertexCount; ++v)
+		pAdjacency->mOffsets[v] -= pAdjacency->mCounts[v];
+}
+
+/// <summary>
+/// Tipsify (Sander, Nehab, Barczak 2007)
+/// 围绕一个扇心顶点输出其全部未输出的三角形, 再从刚引用过的顶点中选下一个扇心:
+/// 优先选择输出其剩余三角形后仍会留在缓存中的、最早进入缓存的顶点; 都不满足时从死端栈或输入顺序中选取
+/// </summary>
+void optimizeVertexCache(uint32_t* pDst, const uint32_t* pIndices, size_t indexCount, size_t vertexCount)
+{
+	const uint32_t cacheSize = MESH_OPTIMIZER_VERTEX_CACHE_SIZE;
+	size_t triangleCount = indexCount / 3;
+	if (!triangleCount)
+		return;
+
+	TriangleAdjacency adjacency;
+	buildTriangleAdjacency(&adjacency, pIndices, indexCount, vertexCount);
+
+	// 每个顶点剩余未输出的三角形数
+	IndexList liveTriangles(adjacency.mCounts);
+	IndexList cacheTimestamps(vertexCount, 0);
+	std::vector<bool> emitted(triangleCount, false);
+	IndexList deadEnd;
+	deadEnd.reserve(indexCount);
+	IndexList candidates;
+	candidates.reserve(64);
+
+	uint32_t timestamp = cacheSize + 1;
+	uint32_t inputCursor = 1;
+	size_t outputIndex = 0;
+	uint32_t fanVertex = 0;
+	while (fanVertex != INVALID_INDEX)
+	{
+		candidates.clear();
+		const uint32_t* pTriangles = adjacency.mTriangles.data() + adjacency.mOffsets[fanVertex];
+		for (uint32_t t = 0; t < adjacency.mCounts[fanVertex]; ++t)
+		{
+			uint32_t triangle = pTriangles[t];
+			if (emitted[triangle])
+				continue;
+			emitted[triangle] = true;
+			for (uint32_t k = 0; k < 3; ++k)
+			{
+				uint32_t vertex = pIndices[triangle * 3 + k];
+				pDst[outputIndex++] = vertex;
+				deadEnd.push_back(vertex);
+				candidates.push_back(vertex);
+				--liveTriangles[vertex];
+				if (timestamp - cacheTimestamps[vertex] > cacheSize)
+					cacheTimestamps[vertex] = timestamp++;
+			}
+		}
+
+		uint32_t bestVertex = INVALID_INDEX;
+		int64_t bestPriority = -1;
+		for (uint32_t vertex : candidates)
+		{
+			if (!liveTriangles[vertex])
+				continue;
+			int64_t priority = 0;
+			// 扇形输出会再引入约 2 * live 个顶点, 输出完成时仍在缓存中的顶点才值得继续
+			if (timestamp - cacheTimestamps[vertex] + 2 * liveTriangles[vertex] <= cacheSize)
+				priority = timestamp - cacheTimestamps[vertex];
+			if (priority > bestPriority)
+			{
+				bestPriority = priority;
+				bestVertex = vertex;
+			}
+		}
+
+		if (bestVertex == INVALID_INDEX)
+		{
+			while (!deadEnd.empty() && bestVertex == INVALID_INDEX)
+			{
+				uint32_t vertex = deadEnd.back();
+				deadEnd.pop_back();
+				if (liveTriangles[vertex])
+					bestVertex = vertex;
+			}
+			while (bestVertex == INVALID_INDEX && inputCursor < vertexCount)
+			{
+				if (liveTriangles[inputCursor])
+					bestVertex = inputCursor;
+				++inputCursor;
+			}
+		}
+		fanVertex = bestVertex;
+	}
+}
+
+// 返回本次三角形的缓存未命中数; 顶点时间戳距当前不超过缓存大小即视为命中 (FIFO)
+static uint32_t updateVertexCache(const uint32_t* pTriangle, uint32_t cacheSize, uint32_t* pTimestamps, uint32_t* pTimestamp)
+{
+	uint32_t misses = 0;
+	for (uint32_t k = 0; k < 3; ++k)
+	{
+		uint32_t vertex = pTriangle[k];
+		if (*pTimestamp - pTimestamps[vertex] > cacheSize)
+		{
+			pTimestamps[vertex] = (*pTimestamp)++;
+			++misses;
+		}
+	}
+	return misses;
+}
+
+/// <summary>
+/// 参考 Sander 等人的簇排序方法:
+/// 1. 三个顶点全部未命中的三角形视为新的连续面片, 作为硬边界
+/// 2. 在每个硬簇内, 累计 ACMR 降到整簇 ACMR * threshold 以下时切分出软簇, 缓存损失因此有上界
+/// 3. 按簇中心相对网格中心在簇法线上的投影从大到小排序, 朝外的簇先绘制, 遮挡后绘制的内部簇
+/// </summary>
+void optimizeOverdraw(uint32_t* pDst, const uint32_t* pIndices, size_t indexCount, const float* pPositions, size_t vertexCount, size_t vertexStride, float threshold)
+{
+	const uint32_t cacheSize = MESH_OPTIMIZER_VERTEX_CACHE_SIZE;
+	size_t triangleCount = indexCount / 3;
+	if (!triangleCount)
+		return;
+
+	IndexList cacheTimestamps(vertexCount, 0);
+	uint32_t timestamp = cacheSize + 1;
+
+	IndexList hardBoundaries;
+	for (size_t t = 0; t < triangleCount; ++t)
+	{
+		uint32_t misses = updateVertexCache(pIndices + t * 3, cacheSize, cacheTimestamps.data(), &timestamp);
+		if (t == 0 || misses == 3)
+			hardBoundaries.push_back((uint32_t)t);
+	}
+	hardBoundaries.push_back((uint32_t)triangleCount);
+
+	IndexList clusters;
+	for (size_t h = 0; h + 1 < hardBoundaries.size(); ++h)
+	{
+		uint32_t begin = hardBoundaries[h];
+		uint32_t end = hardBoundaries[h + 1];
+
+		// 跳过 cacheSize + 1 个时间戳相当于清空缓存
+		timestamp += cacheSize + 1;
+		uint32_t clusterMisses = 0;
+		for (uint32_t t = begin; t < end; ++t)
+			clusterMisses += updateVertexCache(pIndices + t * 3, cacheSize, cacheTimestamps.data(), &timestamp);
+		float clusterThreshold = threshold * (float)clusterMisses / (float)(end - begin);
+
+		clusters.push_back(begin);
+		timestamp += cacheSize + 1;
+		uint32_t runningMisses = 0;
+		uint32_t runningTriangles = 0;
+		for (uint32_t t = begin; t < end; ++t)
+		{
+			runningMisses += updateVertexCache(pIndices + t * 3, cacheSize, cacheTimestamps.data(), &timestamp);
+			++runningTriangles;
+			if ((float)runningMisses / (float)runningTriangles <= clusterThreshold)
+			{
+				clusters.push_back(t + 1);
+				timestamp += cacheSize + 1;
+				runningMisses = 0;
+				runningTriangles = 0;
+			}
+		}
+		// 恰好在簇尾切分时最后一个边界等于 end, 会产生空簇
+		if (clusters.back() == end)
+			clusters.pop_back();
+	}
+	clusters.push_back((uint32_t)triangleCount);
+	size_t clusterCount = clusters.size() - 1;
+
+	const uint8_t* pPositionBytes = (const uint8_t*)pPositions;
+	auto getPosition = [&](uint32_t vertex) { return (const float*)(pPositionBytes + vertex * vertexStride); };
+
+	// 以面积加权的三角形中心作为网格中心
+	double meshCentroid[3] = {};
+	double meshArea = 0.0;
+	std::vector<float> clusterKeys(clusterCount);
+	std::vector<float> clusterData(clusterCount * 7);
+	for (size_t c = 0; c < clusterCount; ++c)
+	{
+		float* pData = &clusterData[c * 7];
+		memset(pData, 0, 7 * sizeof(float));
+		for (uint32_t t = clusters[c]; t < clusters[c + 1]; ++t)
+		{
+			const float* p0 = getPosition(pIndices[t * 3 + 0]);
+			const float* p1 = getPosition(pIndices[t * 3 + 1]);
+			const float* p2 = getPosition(pIndices[t * 3 + 2]);
+			float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+			float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+			float normal[3] = { e1[1] * e2[2] - e1[2] * e2[1], e1[2] * e2[0] - e1[0] * e2[2], e1[0] * e2[1] - e1[1] * e2[0] };
+			float area = sqrtf(normal[0] * normal[0] + normal[1] * normal[1] + normal[2] * normal[2]);
+			for (uint32_t k = 0; k < 3; ++k)
+			{
+				float center = (p0[k] + p1[k] + p2[k]) / 3.0f;
+				pData[k] += center * area;
+				pData[3 + k] += normal[k];
+				meshCentroid[k] += center * area;
+			}
+			pData[6] += area;
+			meshArea += area;
+		}
+	}
+	for (uint32_t k = 0; k < 3; ++k)
+		meshCentroid[k] = meshArea > 0.0 ? meshCentroid[k] / meshArea : 0.0;
+
+	for (size_t c = 0; c < clusterCount; ++c)
+	{
+		const float* pData = &clusterData[c * 7];
+		float area = pData[6];
+		float normalLength = sqrtf(pData[3] * pData[3] + pData[4] * pData[4] + pData[5] * pData[5]);
+		float key = 0.0f;
+		if (area > 0.0f && normalLength > 0.0f)
+		{
+			for (uint32_t k = 0; k < 3; ++k)
+				key += (pData[k] / area - (float)meshCentroid[k]) * (pData[3 + k] / normalLength);
+		}
+		clusterKeys[c] = key;
+	}
+
+	IndexList order(clusterCount);
+	for (size_t c = 0; c < clusterCount; ++c)
+		order[c] = (uint32_t)c;
+	std::stable_sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) { return clusterKeys[a] > clusterKeys[b]; });
+
+	size_t outputIndex = 0;
+	for (uint32_t c : order)
+	{
+		size_t begin = (size_t)clusters[c] * 3;
+		size_t count = (size_t)(clusters[c + 1] - clusters[c]) * 3;
+		memcpy(pDst + outputIndex, pIndices + begin, count * sizeof(uint32_t));
+		outputIndex += count;
+	}
+}
+
+size_t optimizeVertexFetch(void* pDst, uint32_t* pIndices, size_t indexCount, const void* pVertices, size_t vertexCount, size_t vertexSize)
+{
+	IndexList remap(vertexCount, INVALID_INDEX);
+	uint32_t nextVertex = 0;
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		uint32_t index = pIndices[i];
+		if (remap[index] == INVALID_INDEX)
+		{
+			memcpy((uint8_t*)pDst + nextVertex * vertexSize, (const uint8_t*)pVertices + index * vertexSize, vertexSize);
+			remap[index] = nextVertex++;
+		}
+		pIndices[i] = remap[index];
+	}
+	return nextVertex;
+}
+
+size_t getClusterCountBound(size_t indexCount, uint32_t maxVertices, uint32_t maxTriangles)
+{
+	// 因顶点数结束的簇至少有 maxVertices - 2 个顶点, 因三角形数结束的簇恰好有 maxTriangles 个三角形
+	size_t byVertices = (indexCount + maxVertices - 3) / (maxVertices - 2);
+	size_t byTriangles = (indexCount / 3 + maxTriangles - 1) / maxTriangles;
+	return std::max(byVertices, byTriangles);
+}
+
+static const float* getPosition(const float* pPositions, size_t vertexStride, uint32_t vertex)
+{
+	return (const float*)((const uint8_t*)pPositions + vertex * vertexStride);
+}
+
+/// <summary>
+/// 邻接表中只保留未输出的三角形: 顶点 v 的前 liveTriangles[v] 项为未输出的三角形, 输出时与最后一项交换
+/// 簇编号兼作顶点的归属标记, 结束一个簇时无需清除
+/// </summary>
+size_t buildClusters(uint32_t* pDst, uint32_t* pClusterTriangleCounts, const uint32_t* pIndices, size_t indexCount, const float* pPositions,
+	size_t vertexCount, size_t vertexStride, uint32_t maxVertices, uint32_t maxTriangles)
+{
+	size_t triangleCount = indexCount / 3;
+	if (!triangleCount)
+		return 0;
+
+	TriangleAdjacency adjacency;
+	buildTriangleAdjacency(&adjacency, pIndices, indexCount, vertexCount);
+	IndexList liveTriangles(adjacency.mCounts);
+	std::vector<bool> emitted(triangleCount, false);
+	IndexList vertexCluster(vertexCount, INVALID_INDEX);
+	IndexList clusterVertices;
+	clusterVertices.reserve(maxVertices);
+
+	size_t clusterCount = 0;
+	uint32_t clusterTriangles = 0;
+	float centroidSum[3] = {};
+	size_t scanCursor = 0;
+	size_t outputIndex = 0;
+	for (size_t emittedCount = 0; emittedCount < triangleCount; ++emittedCount)
+	{
+		float center[3] = {};
+		for (uint32_t c = 0; c < 3 && clusterTriangles; ++c)
+			center[c] = centroidSum[c] / clusterTriangles;
+
+		uint32_t bestTriangle = INVALID_INDEX;
+		uint32_t bestExtra = 4;
+		float bestDistance = FLT_MAX;
+		for (uint32_t vertex : clusterVertices)
+		{
+			const uint32_t* pTriangles = adjacency.mTriangles.data() + adjacency.mOffsets[vertex];
+			for (uint32_t t = 0; t < liveTriangles[vertex]; ++t)
+			{
+				const uint32_t* pTriangle = pIndices + pTriangles[t] * 3;
+				uint32_t extra = (vertexCluster[pTriangle[0]] != clusterCount) +
+					(vertexCluster[pTriangle[1]] != clusterCount && pTriangle[1] != pTriangle[0]) +
+					(vertexCluster[pTriangle[2]] != clusterCount && pTriangle[2] != pTriangle[0] && pTriangle[2] != pTriangle[1]);
+				if (extra > bestExtra)
+					continue;
+
+				float distance = 0.0f;
+				for (uint32_t c = 0; c < 3; ++c)
+				{
+					float d = (getPosition(pPositions, vertexStride, pTriangle[0])[c] + getPosition(pPositions, vertexStride, pTriangle[1])[c] +
+						getPosition(pPositions, vertexStride, pTriangle[2])[c]) / 3.0f - center[c];
+					distance += d * d;
+				}
+				if (extra < bestExtra || distance < bestDistance)
+				{
+					bestTriangle = pTriangles[t];
+					bestExtra = extra;
+					bestDistance = distance;
+				}
+			}
+		}
+
+		if (bestTriangle == INVALID_INDEX)
+		{
+			while (emitted[scanCursor])
+				++scanCursor;
+			bestTriangle = (uint32_t)scanCursor;
+			bestExtra = 3;
+		}
+
+		// 放不下时结束当前簇, 该三角形作为下一个簇的起点
+		if (clusterTriangles && (clusterVertices.size() + bestExtra > maxVertices || clusterTriangles >= maxTriangles))
+		{
+			pClusterTriangleCounts[clusterCount++] = clusterTriangles;
+			clusterVertices.clear();
+			clusterTriangles = 0;
+			centroidSum[0] = centroidSum[1] = centroidSum[2] = 0.0f;
+		}
+
+		emitted[bestTriangle] = true;
+		for (uint32_t k = 0; k < 3; ++k)
+		{
+			uint32_t vertex = pIndices[bestTriangle * 3 + k];
+			pDst[outputIndex++] = vertex;
+			if (vertexCluster[vertex] != clusterCount)
+			{
+				vertexCluster[vertex] = (uint32_t)clusterCount;
+				clusterVertices.push_back(vertex);
+			}
+
+			uint32_t* pTriangles = adjacency.mTriangles.data() + adjacency.mOffsets[vertex];
+			uint32_t live = liveTriangles[vertex];
+			for (uint32_t t = 0; t < live; ++t)
+			{
+				if (pTriangles[t] == bestTriangle)
+				{
+					std::swap(pTriangles[t], pTriangles[live - 1]);
+					--liveTriangles[vertex];
+					break;
+				}
+			}
+
+			const float* pPosition = getPosition(pPositions, vertexStride, vertex);
+			for (uint32_t c = 0; c < 3; ++c)
+				centroidSum[c] += pPosition[c] / 3.0f;
+		}
+		++clusterTriangles;
+	}
+	pClusterTriangleCounts[clusterCount++] = clusterTriangles;
+	return clusterCount;
+}
+
+static float dot3(const float* a, const float* b)
+{
+	return a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
+}
+
+// 三角形的单位法线, 退化三角形返回 false
+static bool computeTriangleNormal(const float* p0, const float* p1, const float* p2, float* pNormal)
+{
+	float e1[3] = { p1[0] - p0[0], p1[1] - p0[1], p1[2] - p0[2] };
+	float e2[3] = { p2[0] - p0[0], p2[1] - p0[1], p2[2] - p0[2] };
+	pNormal[0] = e1[1] * e2[2] - e1[2] * e2[1];
+	pNormal[1] = e1[2] * e2[0] - e1[0] * e2[2];
+	pNormal[2] = e1[0] * e2[1] - e1[1] * e2[0];
+	float length = sqrtf(dot3(pNormal, pNormal));
+	if (length == 0.0f)
+		return false;
+	for (uint32_t c = 0; c < 3; ++c)
+		pNormal[c] /= length;
+	return true;
+}
+
+/// <summary>
+/// 包围球: 先取三个轴向上相距最远的一对极值点作为初始球 (Ritter), 再逐点扩大到包含所有顶点
+/// 背面锥 (与 meshoptimizer 相同的构造): 轴为法线的平均方向, 半角 a 由与轴夹角最大的法线决定;
+/// 锥顶沿轴后退到所有三角形平面的背面, 从锥顶看去视线与轴的夹角小于 90 - a 度时所有三角形都背向相机
+/// </summary>
+void computeClusterBounds(ClusterBounds* pBounds, const uint32_t* pIndices, size_t indexCount, const float* pPositions, size_t vertexStride)
+{
+	memset(pBounds, 0, sizeof(*pBounds));
+	pBounds->mConeCutoff = 1.0f;
+	if (indexCount < 3)
+		return;
+
+	uint32_t extremes[6] = {};
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		const float* pPosition = getPosition(pPositions, vertexStride, pIndices[i]);
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			if (pPosition[c] < getPosition(pPositions, vertexStride, pIndices[extremes[c * 2]])[c])
+				extremes[c * 2] = (uint32_t)i;
+			if (pPosition[c] > getPosition(pPositions, vertexStride, pIndices[extremes[c * 2 + 1]])[c])
+				extremes[c * 2 + 1] = (uint32_t)i;
+		}
+	}
+
+	float center[3] = {};
+	float radius = -1.0f;
+	for (uint32_t c = 0; c < 3; ++c)
+	{
+		const float* pMin = getPosition(pPositions, vertexStride, pIndices[extremes[c * 2]]);
+		const float* pMax = getPosition(pPositions, vertexStride, pIndices[extremes[c * 2 + 1]]);
+		float d[3] = { pMax[0] - pMin[0], pMax[1] - pMin[1], pMax[2] - pMin[2] };
+		float half = sqrtf(dot3(d, d)) * 0.5f;
+		if (half > radius)
+		{
+			radius = half;
+			for (uint32_t k = 0; k < 3; ++k)
+				center[k] = (pMin[k] + pMax[k]) * 0.5f;
+		}
+	}
+	for (size_t i = 0; i < indexCount; ++i)
+	{
+		const float* pPosition = getPosition(pPositions, vertexStride, pIndices[i]);
+		float d[3] = { pPosition[0] - center[0], pPosition[1] - center[1], pPosition[2] - center[2] };
+		float distance = sqrtf(dot3(d, d));
+		if (distance > radius)
+		{
+			float shift = (distance - radius) * 0.5f / distance;
+			for (uint32_t c = 0; c < 3; ++c)
+				center[c] += d[c] * shift;
+			radius = (radius + distance) * 0.5f;
+		}
+	}
+	memcpy(pBounds->mCenter, center, sizeof(center));
+	pBounds->mRadius = radius;
+	memcpy(pBounds->mConeApex, center, sizeof(center));
+
+	float axis[3] = {};
+	for (size_t i = 0; i + 2 < indexCount; i += 3)
+	{
+		float normal[3];
+		if (!computeTriangleNormal(getPosition(pPositions, vertexStride, pIndices[i]), getPosition(pPositions, vertexStride, pIndices[i + 1]),
+			getPosition(pPositions, vertexStride, pIndices[i + 2]), normal))
+			continue;
+		for (uint32_t c = 0; c < 3; ++c)
+			axis[c] += normal[c];
+	}
+	float axisLength = sqrtf(dot3(axis, axis));
+	if (axisLength == 0.0f)
+		return;
+	for (uint32_t c = 0; c < 3; ++c)
+		axis[c] /= axisLength;
+
+	float minDot = 1.0f;
+	float maxOffset = 0.0f;
+	for (size_t i = 0; i + 2 < indexCount; i += 3)
+	{
+		const float* p0 = getPosition(pPositions, vertexStride, pIndices[i]);
+		float normal[3];
+		if (!computeTriangleNormal(p0, getPosition(pPositions, vertexStride, pIndices[i + 1]), getPosition(pPositions, vertexStride, pIndices[i + 2]), normal))
+			continue;
+		float normalDot = dot3(axis, normal);
+		minDot = std::min(minDot, normalDot);
+		// 法线过于分散 (锥半角接近 90 度) 时锥剔除几乎不可能生效, 也避免下面除以接近 0 的数
+		if (minDot <= 0.1f)
+			return;
+
+		// 轴上满足 dot(center - t * axis - p0, normal) = 0 的 t, 锥顶需后退到所有三角形平面之后
+		float toCenter[3] = { center[0] - p0[0], center[1] - p0[1], center[2] - p0[2] };
+		maxOffset = std::max(maxOffset, dot3(toCenter, normal) / normalDot);
+	}
+
+	for (uint32_t c = 0; c < 3; ++c)
+	{
+		pBounds->mConeApex[c] = center[c] - axis[c] * maxOffset;
+		pBounds->mConeAxis[c] = axis[c];
+	}
+	// 法线锥半角 a 满足 cos(a) = minDot, 背面锥的半角为 90 - a, 其余弦为 sin(a)
+	pBounds->mConeCutoff = sqrtf(1.0f - minDot * minDot);
+}
+
+void analyzeVertexCache(const uint32_t* pIndices, size_t indexCount, size_t vertexCount, uint32_t cacheSize, VertexCacheStatistics* pOutStats)
+{
+	memset(pOutStats, 0, sizeof(*pOutStats));
+	size_t triangleCount = indexCount / 3;
+	if (!triangleCount)
+		return;
+
+	IndexList cacheTimestamps(vertexCount, 0);
+	std::vector<bool> referenced(vertexCount, false);
+	uint32_t timestamp = cacheSize + 1;
+	uint32_t referencedCount = 0;
+	for (size_t t = 0; t < triangleCount; ++t)
+	{
+		pOutStats->mVerticesTransformed += updateVertexCache(pIndices + t * 3, cacheSize, cacheTimestamps.data(), &timestamp);
+		for (uint32_t k = 0; k < 3; ++k)
+		{
+			uint32_t vertex = pIndices[t * 3 + k];
+			if (!referenced[vertex])
+			{
+				referenced[vertex] = true;
+				++referencedCount;
+			}
+		}
+	}
+	pOutStats->mAcmr = (float)pOutStats->mVerticesTransformed / (float)triangleCount;
+	pOutStats->mAtvr = referencedCount ? (float)pOutStats->mVerticesTransformed / (float)referencedCount : 0.0f;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 顶点缓存模拟与重排使用的缓存大小, 与多数 GPU 后变换缓存的有效容量相近
+#define MESH_OPTIMIZER_VERTEX_CACHE_SIZE 16
+// optimizeOverdraw 默认允许的顶点缓存命中率损失 (ACMR 最多变为原来的 1.05 倍)
+#define MESH_OPTIMIZER_DEFAULT_OVERDRAW_THRESHOLD 1.05f
+// 簇的默认上限, 与网格着色器常用的 meshlet 大小相同 (124 个三角形使索引数据恰好不超过 372 字节的 8 位局部索引)
+#define MESH_OPTIMIZER_CLUSTER_MAX_VERTICES 64
+#define MESH_OPTIMIZER_CLUSTER_MAX_TRIANGLES 124
+
+/// <summary>
+/// 顶点缓存模拟结果
+/// </summary>
+typedef struct VertexCacheStatistics
+{
+	uint32_t	mVerticesTransformed;
+	// 每个三角形的平均缓存未命中数 (ACMR), 规则网格的下限约为 0.5
+	float		mAcmr;
+	// 每个被引用顶点的平均变换次数 (ATVR), 理想值为 1
+	float		mAtvr;
+} VertexCacheStatistics;
+
+/// <summary>
+/// 按顶点内容 (逐字节比较) 去重, pRemap[i] 为顶点 i 的新序号, 未被引用的顶点为 UINT32_MAX
+/// pIndices 为 NULL 时按顺序处理非索引的顶点流 (indexCount 需等于 vertexCount)
+/// 返回唯一顶点数
+/// </summary>
+size_t generateVertexRemap(uint32_t* pRemap, const uint32_t* pIndices, size_t indexCount, const void* pVertices, size_t vertexCount, size_t vertexSize);
+// 按重映射表写出去重后的顶点, pDst 至少容纳 generateVertexRemap 返回的顶点数
+void remapVertexBuffer(void* pDst, const void* pVertices, size_t vertexCount, size_t vertexSize, const uint32_t* pRemap);
+// 按重映射表写出索引, pIndices 为 NULL 时视为 0, 1, 2 ...; pDst 可以与 pIndices 相同
+void remapIndexBuffer(uint32_t* pDst, const uint32_t* pIndices, size_t indexCount, const uint32_t* pRemap);
+
+// 重排三角形以提高后变换顶点缓存命中率 (Tipsify, 线性时间); pDst 不能与 pIndices 相同
+void optimizeVertexCache(uint32_t* pDst, const uint32_t* pIndices, size_t indexCount, size_t vertexCount);
+// 在 optimizeVertexCache 之后调用: 将三角形切分为簇, 按朝外程度排序以减少过度绘制
+// threshold 为允许的 ACMR 放大倍数; pPositions 为每个顶点的 float3 位置, vertexStride 为字节跨度; pDst 不能与 pIndices 相同
+void optimizeOverdraw(uint32_t* pDst, const uint32_t* pIndices, size_t indexCount, const float* pPositions, size_t vertexCount, size_t vertexStride, float threshold);
+// 按索引首次引用的顺序重排顶点, 提高顶点读取的内存局部性; 就地改写 pIndices, 返回写出的顶点数
+size_t optimizeVertexFetch(void* pDst, uint32_t* pIndices, size_t indexCount, const void* pVertices, size_t vertexCount, size_t vertexSize);
+
+/// <summary>
+/// 簇的剔除包围体, 与簇的三角形处于同一坐标空间
+/// </summary>
+typedef struct ClusterBounds
+{
+	float mCenter[3];
+	float mRadius;
+	// 背面锥: dot(normalize(mConeApex - 相机位置), mConeAxis) >= mConeCutoff 时簇内三角形全部背向相机
+	// 三角形朝向过于分散时 mConeAxis 为零向量且 mConeCutoff 为 1, 永远不会被剔除
+	float mConeApex[3];
+	float mConeAxis[3];
+	float mConeCutoff;
+} ClusterBounds;
+
+// buildClusters 可能输出的最大簇数, 用于分配 pClusterTriangleCounts
+size_t getClusterCountBound(size_t indexCount, uint32_t maxVertices, uint32_t maxTriangles);
+/// <summary>
+/// 把三角形分成顶点数与三角形数都不超过上限的簇, 每个簇的三角形在 pDst 中连续存放
+/// 贪心地从当前簇的顶点出发扩展: 优先选择新增顶点最少、离簇中心最近的相邻三角形, 没有相邻三角形时按输入顺序继续
+/// pClusterTriangleCounts 依次写出每个簇的三角形数, 返回簇数; pDst 不能与 pIndices 相同
+/// </summary>
+size_t buildClusters(uint32_t* pDst, uint32_t* pClusterTriangleCounts, const uint32_t* pIndices, size_t indexCount, const float* pPositions,
+	size_t vertexCount, size_t vertexStride, uint32_t maxVertices, uint32_t maxTriangles);
+// 计算一个簇 (pIndices 为其全部三角形) 的包围球与背面锥; 三角形正面按逆时针顶点顺序确定
+void computeClusterBounds(ClusterBounds* pBounds, const uint32_t* pIndices, size_t indexCount, const float* pPositions, size_t vertexStride);
+
+// 以 FIFO 缓存模拟后变换顶点缓存
+void analyzeVertexCache(const uint32_t* pIndices, size_t indexCount, size_t vertexCount, uint32_t cacheSize, VertexCacheStatistics* pOutStats);
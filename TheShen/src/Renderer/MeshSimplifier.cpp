@@ -0,0 +1,827 @@
+#include "MeshSimplifier.h"
+#include "Core/Memory.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+typedef std::vector<uint32_t, CategoryAllocator<uint32_t, MEMORY_CATEGORY_ASSETS>> IndexList;
+typedef std::vector<float, CategoryAllocator<float, MEMORY_CATEGORY_ASSETS>> FloatList;
+
+const uint32_t INVALID_INDEX = ~0u;
+
+// 边界边的平面二次误差权重, 越大越倾向于保持轮廓
+const float BORDER_EDGE_WEIGHT = 10.0f;
+// 每轮的误差上限相对本轮目标折叠数处候选误差的倍数
+const float PASS_ERROR_FACTOR = 1.5f;
+// 候选边按误差浮点数的高位计数排序: 误差非负, 去掉符号位后 16 位包含全部 8 位指数与 8 位尾数, 同一桶内的相对误差不超过 0.4%
+const uint32_t COLLAPSE_SORT_BITS = 16;
+
+typedef enum VertexKind
+{
+	// 内部顶点, 可以沿任意边折叠
+	VERTEX_KIND_MANIFOLD = 0,
+	// 开放边界上的顶点, 只能沿边界折叠到相邻的边界顶点
+	VERTEX_KIND_BORDER,
+	// 属性缝上的顶点 (同一位置恰好两个属性不同的顶点), 两侧一起沿缝折叠
+	VERTEX_KIND_SEAM,
+	// 拓扑复杂 (多条缝/边界交汇) 的顶点, 不移动
+	VERTEX_KIND_LOCKED,
+	VERTEX_KIND_COUNT,
+} VertexKind;
+
+// gCanCollapse[a][b]: a 类顶点能否折叠到 b 类顶点
+static const bool gCanCollapse[VERTEX_KIND_COUNT][VERTEX_KIND_COUNT] =
+{
+	{ true,  true,  true,  true  },
+	{ false, true,  false, false },
+	{ false, false, true,  false },
+	{ false, false, false, false },
+};
+
+// gHasOpposite[a][b]: 两类顶点之间的边是否在两个方向上都存在, 用于去掉重复的候选边
+static const bool gHasOpposite[VERTEX_KIND_COUNT][VERTEX_KIND_COUNT] =
+{
+	{ true,  true,  true,  false },
+	{ true,  false, true,  false },
+	{ true,  true,  true,  true  },
+	{ false, false, true,  false },
+};
+
+typedef struct Vector3
+{
+	float x, y, z;
+} Vector3;
+
+/// <summary>
+/// 对称矩阵形式的二次误差: E(p) = p^T A p + 2 b^T p + c, w 为累计权重
+/// </summary>
+typedef struct Quadric
+{
+	float a00, a11, a22;
+	float a10, a20, a21;
+	float b0, b1, b2;
+	float c;
+	float w;
+} Quadric;
+
+/// <summary>
+/// 属性的线性插值梯度, 属性 = gx * x + gy * y + gz * z + gw (已乘以三角形权重)
+/// </summary>
+typedef struct QuadricGrad
+{
+	float gx, gy, gz, gw;
+} QuadricGrad;
+
+typedef struct Collapse
+{
+	uint32_t	mV0;
+	uint32_t	mV1;
+	// 候选阶段标记边是否可以双向折叠, 评估后为折叠代价
+	union
+	{
+		uint32_t	mBidirectional;
+		float		mError;
+	};
+} Collapse;
+
+typedef std::vector<Vector3, CategoryAllocator<Vector3, MEMORY_CATEGORY_ASSETS>> Vector3List;
+typedef std::vector<Quadric, CategoryAllocator<Quadric, MEMORY_CATEGORY_ASSETS>> QuadricList;
+typedef std::vector<QuadricGrad, CategoryAllocator<QuadricGrad, MEMORY_CATEGORY_ASSETS>> QuadricGradList;
+typedef std::vector<Collapse, CategoryAllocator<Collapse, MEMORY_CATEGORY_ASSETS>> CollapseList;
+typedef std::vector<uint8_t, CategoryAllocator<uint8_t, MEMORY_CATEGORY_ASSETS>> ByteList;
+
+static float dot(const Vector3& a, const Vector3& b)
+{
+	return a.x * b.x + a.y * b.y + a.z * b.z;
+}
+
+static Vector3 sub(const Vector3& a, const Vector3& b)
+{
+	return { a.x - b.x, a.y - b.y, a.z - b.z };
+}
+
+static Vector3 cross(const Vector3& a, const Vector3& b)
+{
+	return { a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x };
+}
+
+static float normalize(Vector3* pV)
+{
+	float length = sqrtf(dot(*pV, *pV));
+	if (length > 0.0f)
+	{
+		pV->x /= length;
+		pV->y /= length;
+		pV->z /= length;
+	}
+	return length;
+}
+
+static void quadricAdd(Quadric* pQ, const Quadric& r)
+{
+	pQ->a00 += r.a00;
+	pQ->a11 += r.a11;
+	pQ->a22 += r.a22;
+	pQ->a10 += r.a10;
+	pQ->a20 += r.a20;
+	pQ->a21 += r.a21;
+	pQ->b0 += r.b0;
+	pQ->b1 += r.b1;
+	pQ->b2 += r.b2;
+	pQ->c += r.c;
+	pQ->w += r.w;
+}
+
+static void quadricAdd(QuadricGrad* pG, const QuadricGrad* pR, uint32_t attributeCount)
+{
+	for (uint32_t k = 0; k < attributeCount; ++k)
+	{
+		pG[k].gx += pR[k].gx;
+		pG[k].gy += pR[k].gy;
+		pG[k].gz += pR[k].gz;
+		pG[k].gw += pR[k].gw;
+	}
+}
+
+// 平面 n·p + d = 0 的距离平方误差
+static Quadric quadricFromPlane(const Vector3& n, float d, float w)
+{
+	Quadric q;
+	q.a00 = w * n.x * n.x;
+	q.a11 = w * n.y * n.y;
+	q.a22 = w * n.z * n.z;
+	q.a10 = w * n.y * n.x;
+	q.a20 = w * n.z * n.x;
+	q.a21 = w * n.z * n.y;
+	q.b0 = w * n.x * d;
+	q.b1 = w * n.y * d;
+	q.b2 = w * n.z * d;
+	q.c = w * d * d;
+	q.w = w;
+	return q;
+}
+
+static float quadricEvaluate(const Quadric& q, const Vector3& p)
+{
+	float rx = q.b0 + q.a10 * p.y;
+	float ry = q.b1 + q.a21 * p.z;
+	float rz = q.b2 + q.a20 * p.x;
+	rx = rx * 2.0f + q.a00 * p.x;
+	ry = ry * 2.0f + q.a11 * p.y;
+	rz = rz * 2.0f + q.a22 * p.z;
+	return q.c + rx * p.x + ry * p.y + rz * p.z;
+}
+
+// 按累计权重归一化, 几何误差为到各平面距离平方的加权平均
+static float quadricError(const Quadric& q, const Vector3& p)
+{
+	return q.w > 0.0f ? fabsf(quadricEvaluate(q, p)) / q.w : 0.0f;
+}
+
+static float quadricError(const Quadric& q, const QuadricGrad* pG, uint32_t attributeCount, const Vector3& p, const float* pAttributes)
+{
+	// 展开 (插值属性 - 目标属性)^2, 与目标属性无关的项已累计在 q 中
+	float r = quadricEvaluate(q, p);
+	for (uint32_t k = 0; k < attributeCount; ++k)
+	{
+		float a = pAttributes[k];
+		float g = p.x * pG[k].gx + p.y * pG[k].gy + p.z * pG[k].gz + pG[k].gw;
+		r += a * a * q.w - 2.0f * a * g;
+	}
+	return q.w > 0.0f ? fabsf(r) / q.w : 0.0f;
+}
+
+/// <summary>
+/// 三角形上属性的线性插值函数 f(p) = g·p + gw 由重心坐标对位置求导得到 (Hoppe 1999)
+/// 二次误差记录 sum((f(p) - a)^2), 其中与目标属性 a 相关的项留到求值时加入
+/// </summary>
+static void quadricFromAttributes(Quadric* pQ, QuadricGrad* pG, const Vector3& p0, const Vector3& p1, const Vector3& p2,
+	const float* pA0, const float* pA1, const float* pA2, uint32_t attributeCount)
+{
+	Vector3 p10 = sub(p1, p0);
+	Vector3 p20 = sub(p2, p0);
+	Vector3 normal = cross(p10, p20);
+	float w = sqrtf(dot(normal, normal));
+
+	float d00 = dot(p10, p10);
+	float d01 = dot(p10, p20);
+	float d11 = dot(p20, p20);
+	float denom = d00 * d11 - d01 * d01;
+	float denomInv = denom != 0.0f ? 1.0f / denom : 0.0f;
+
+	// 重心坐标 v, w 对位置的导数
+	Vector3 g1 = { (d11 * p10.x - d01 * p20.x) * denomInv, (d11 * p10.y - d01 * p20.y) * denomInv, (d11 * p10.z - d01 * p20.z) * denomInv };
+	Vector3 g2 = { (d00 * p20.x - d01 * p10.x) * denomInv, (d00 * p20.y - d01 * p10.y) * denomInv, (d00 * p20.z - d01 * p10.z) * denomInv };
+
+	memset(pQ, 0, sizeof(Quadric));
+	pQ->w = w;
+	for (uint32_t k = 0; k < attributeCount; ++k)
+	{
+		float a10 = pA1[k] - pA0[k];
+		float a20 = pA2[k] - pA0[k];
+		float gx = g1.x * a10 + g2.x * a20;
+		float gy = g1.y * a10 + g2.y * a20;
+		float gz = g1.z * a10 + g2.z * a20;
+		float gw = pA0[k] - p0.x * gx - p0.y * gy - p0.z * gz;
+
+		pQ->a00 += w * gx * gx;
+		pQ->a11 += w * gy * gy;
+		pQ->a22 += w * gz * gz;
+		pQ->a10 += w * gy * gx;
+		pQ->a20 += w * gz * gx;
+		pQ->a21 += w * gz * gy;
+		pQ->b0 += w * gx * gw;
+		pQ->b1 += w * gy * gw;
+		pQ->b2 += w * gz * gw;
+		pQ->c += w * gw * gw;
+
+		pG[k].gx = w * gx;
+		pG[k].gy = w * gy;
+		pG[k].gz = w * gz;
+		pG[k].gw = w * gw;
+	}
+}
+
+/// <summary>
+/// 有向边的邻接表 (CSR 格式), 顶点 v 的出边终点为 mData[mOffsets[v], mOffsets[v] + mCounts[v])
+/// 用于翻转检测时, 每条出边额外记录三角形的第三个顶点
+/// </summary>
+typedef struct EdgeAdjacency
+{
+	IndexList	mCounts;
+	IndexList	mOffsets;
+	IndexList	mData;
+} EdgeAdjacency;
+
+static void buildEdgeAdjacency(EdgeAdjacency* pAdjacency, const uint32_t* pIndices, size_t indexCount, size_t vertexCount, const uint32_t* pRemap, bool withOpposite)
+{
+	uint32_t width = withOpposite ? 2 : 1;
+	pAdjacency->mCounts.assign(vertexCount, 0);
+	pAdjacency->mOffsets.resize(vertexCount);
+	pAdjacency->mData.resize(indexCount * width);
+
+	for (size_t i = 0; i < indexCount; ++i)
+		pAdjacency->mCounts[pRemap ? pRemap[pIndices[i]] : pIndices[i]]++;
+
+	uint32_t offset = 0;
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		pAdjacency->mOffsets[v] = offset;
+		offset += pAdjacency->mCounts[v] * width;
+	}
+
+	IndexList cursor(pAdjacency->mOffsets);
+	for (size_t i = 0; i < indexCount; i += 3)
+	{
+		for (uint32_t e = 0; e < 3; ++e)
+		{
+			uint32_t a = pIndices[i + e];
+			uint32_t b = pIndices[i + (e + 1) % 3];
+			uint32_t c = pIndices[i + (e + 2) % 3];
+			if (pRemap)
+			{
+				a = pRemap[a];
+				b = pRemap[b];
+				c = pRemap[c];
+			}
+			pAdjacency->mData[cursor[a]++] = b;
+			if (withOpposite)
+				pAdjacency->mData[cursor[a]++] = c;
+		}
+	}
+}
+
+static bool hasEdge(const EdgeAdjacency& adjacency, uint32_t a, uint32_t b)
+{
+	const uint32_t* pBegin = adjacency.mData.data() + adjacency.mOffsets[a];
+	const uint32_t* pEnd = pBegin + adjacency.mCounts[a];
+	return std::find(pBegin, pEnd, b) != pEnd;
+}
+
+/// <summary>
+/// 位置相同的顶点归为一组: pRemap[v] 为组内第一个顶点, pWedge[v] 为组内下一个顶点 (环形链表)
+/// </summary>
+static void buildPositionRemap(uint32_t* pRemap, uint32_t* pWedge, const Vector3* pPositions, size_t vertexCount)
+{
+	size_t tableSize = 1;
+	while (tableSize < vertexCount + vertexCount / 4)
+		tableSize *= 2;
+	IndexList table(tableSize, INVALID_INDEX);
+
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		// FNV-1a
+		const uint8_t* pBytes = (const uint8_t*)&pPositions[v];
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; i < sizeof(Vector3); ++i)
+			hash = (hash ^ pBytes[i]) * 16777619u;
+
+		size_t bucket = hash & (tableSize - 1);
+		for (size_t probe = 1; table[bucket] != INVALID_INDEX; ++probe)
+		{
+			if (!memcmp(&pPositions[table[bucket]], &pPositions[v], sizeof(Vector3)))
+				break;
+			bucket = (bucket + probe) & (tableSize - 1);
+		}
+
+		if (table[bucket] == INVALID_INDEX)
+			table[bucket] = (uint32_t)v;
+		pRemap[v] = table[bucket];
+		pWedge[v] = (uint32_t)v;
+	}
+
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		uint32_t r = pRemap[v];
+		if (r != v)
+		{
+			pWedge[v] = pWedge[r];
+			pWedge[r] = (uint32_t)v;
+		}
+	}
+}
+
+/// <summary>
+/// 按开放边 (反向边不存在的边) 对顶点分类
+/// pLoop[v] / pLoopBack[v] 为 v 唯一的开放出边/入边的另一端, 没有或不唯一时为 INVALID_INDEX
+/// </summary>
+static void classifyVertices(uint8_t* pKinds, uint32_t* pLoop, uint32_t* pLoopBack, const uint32_t* pIndices, size_t indexCount, size_t vertexCount,
+	const uint32_t* pRemap, const uint32_t* pWedge)
+{
+	EdgeAdjacency adjacency;
+	buildEdgeAdjacency(&adjacency, pIndices, indexCount, vertexCount, NULL, false);
+
+	memset(pLoop, 0xff, vertexCount * sizeof(uint32_t));
+	memset(pLoopBack, 0xff, vertexCount * sizeof(uint32_t));
+
+	// 有多条开放边的顶点记为指向自身
+	for (size_t a = 0; a < vertexCount; ++a)
+	{
+		for (uint32_t i = 0; i < adjacency.mCounts[a]; ++i)
+		{
+			uint32_t b = adjacency.mData[adjacency.mOffsets[a] + i];
+			if (hasEdge(adjacency, b, (uint32_t)a))
+				continue;
+			pLoop[a] = pLoop[a] == INVALID_INDEX ? b : (uint32_t)a;
+			pLoopBack[b] = pLoopBack[b] == INVALID_INDEX ? (uint32_t)a : b;
+		}
+	}
+
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		if (pRemap[v] != v)
+		{
+			pKinds[v] = pKinds[pRemap[v]];
+			continue;
+		}
+
+		if (pWedge[v] == v)
+		{
+			// 同一位置只有一个顶点: 内部顶点或边界顶点
+			uint32_t openIn = pLoopBack[v], openOut = pLoop[v];
+			if (openIn == INVALID_INDEX && openOut == INVALID_INDEX)
+				pKinds[v] = VERTEX_KIND_MANIFOLD;
+			else if (openIn != INVALID_INDEX && openOut != INVALID_INDEX && openIn != v && openOut != v)
+				pKinds[v] = VERTEX_KIND_BORDER;
+			else
+				pKinds[v] = VERTEX_KIND_LOCKED;
+		}
+		else if (pWedge[pWedge[v]] == v)
+		{
+			// 同一位置恰好两个顶点: 缝的两侧开放边必须首尾相对
+			uint32_t w = pWedge[v];
+			uint32_t openIv = pLoopBack[v], openOv = pLoop[v];
+			uint32_t openIw = pLoopBack[w], openOw = pLoop[w];
+			if (openIv != INVALID_INDEX && openIv != v && openOv != INVALID_INDEX && openOv != v &&
+				openIw != INVALID_INDEX && openIw != w && openOw != INVALID_INDEX && openOw != w)
+			{
+				if (pRemap[openIv] == pRemap[openOw] && pRemap[openOv] == pRemap[openIw] && pRemap[openIv] != pRemap[openOv])
+					pKinds[v] = VERTEX_KIND_SEAM;
+				else
+					pKinds[v] = VERTEX_KIND_LOCKED;
+			}
+			else
+			{
+				pKinds[v] = VERTEX_KIND_LOCKED;
+			}
+		}
+		else
+		{
+			pKinds[v] = VERTEX_KIND_LOCKED;
+		}
+	}
+}
+
+static void fillFaceQuadrics(Quadric* pQuadrics, const uint32_t* pIndices, size_t indexCount, const Vector3* pPositions, const uint32_t* pRemap)
+{
+	for (size_t i = 0; i < indexCount; i += 3)
+	{
+		uint32_t i0 = pIndices[i + 0], i1 = pIndices[i + 1], i2 = pIndices[i + 2];
+		Vector3 normal = cross(sub(pPositions[i1], pPositions[i0]), sub(pPositions[i2], pPositions[i0]));
+		float area = normalize(&normal);
+		Quadric q = quadricFromPlane(normal, -dot(normal, pPositions[i0]), area);
+
+		quadricAdd(&pQuadrics[pRemap[i0]], q);
+		quadricAdd(&pQuadrics[pRemap[i1]], q);
+		quadricAdd(&pQuadrics[pRemap[i2]], q);
+	}
+}
+
+// 边界与缝的边额外加入过该边且垂直于三角形的平面, 防止轮廓向内收缩
+static void fillEdgeQuadrics(Quadric* pQuadrics, const uint32_t* pIndices, size_t indexCount, const Vector3* pPositions, const uint32_t* pRemap,
+	const uint8_t* pKinds, const uint32_t* pLoop, const uint32_t* pLoopBack)
+{
+	for (size_t i = 0; i < indexCount; i += 3)
+	{
+		for (uint32_t e = 0; e < 3; ++e)
+		{
+			uint32_t i0 = pIndices[i + e];
+			uint32_t i1 = pIndices[i + (e + 1) % 3];
+			uint32_t i2 = pIndices[i + (e + 2) % 3];
+			uint8_t k0 = pKinds[i0], k1 = pKinds[i1];
+			bool open0 = k0 == VERTEX_KIND_BORDER || k0 == VERTEX_KIND_SEAM;
+			bool open1 = k1 == VERTEX_KIND_BORDER || k1 == VERTEX_KIND_SEAM;
+
+			// 至少一端在边界/缝上且该边就是其开放边; 边界到锁定顶点的边也要计入, 否则拐角处的误差偏小
+			if (!open0 && !open1)
+				continue;
+			if (open0 && pLoop[i0] != i1)
+				continue;
+			if (open1 && pLoopBack[i1] != i0)
+				continue;
+			// 缝的边在两侧各出现一次, 只计一次
+			if (gHasOpposite[k0][k1] && pRemap[i1] > pRemap[i0])
+				continue;
+
+			const Vector3& p0 = pPositions[i0];
+			Vector3 p10 = sub(pPositions[i1], p0);
+			float length = normalize(&p10);
+			Vector3 p20 = sub(pPositions[i2], p0);
+			float projection = dot(p20, p10);
+			Vector3 perpendicular = { p20.x - p10.x * projection, p20.y - p10.y * projection, p20.z - p10.z * projection };
+			normalize(&perpendicular);
+
+			Quadric q = quadricFromPlane(perpendicular, -dot(perpendicular, p0), length * BORDER_EDGE_WEIGHT);
+			quadricAdd(&pQuadrics[pRemap[i0]], q);
+			quadricAdd(&pQuadrics[pRemap[i1]], q);
+		}
+	}
+}
+
+static void fillAttributeQuadrics(Quadric* pQuadrics, QuadricGrad* pGradients, const uint32_t* pIndices, size_t indexCount, const Vector3* pPositions,
+	const float* pAttributes, uint32_t attributeCount)
+{
+	for (size_t i = 0; i < indexCount; i += 3)
+	{
+		uint32_t i0 = pIndices[i + 0], i1 = pIndices[i + 1], i2 = pIndices[i + 2];
+		Quadric q;
+		QuadricGrad g[MESH_SIMPLIFIER_MAX_ATTRIBUTES];
+		quadricFromAttributes(&q, g, pPositions[i0], pPositions[i1], pPositions[i2],
+			pAttributes + i0 * attributeCount, pAttributes + i1 * attributeCount, pAttributes + i2 * attributeCount, attributeCount);
+
+		quadricAdd(&pQuadrics[i0], q);
+		quadricAdd(&pQuadrics[i1], q);
+		quadricAdd(&pQuadrics[i2], q);
+		quadricAdd(pGradients + i0 * attributeCount, g, attributeCount);
+		quadricAdd(pGradients + i1 * attributeCount, g, attributeCount);
+		quadricAdd(pGradients + i2 * attributeCount, g, attributeCount);
+	}
+}
+
+static void pickEdgeCollapses(CollapseList* pCollapses, const uint32_t* pIndices, size_t indexCount, const uint32_t* pRemap, const uint8_t* pKinds, const uint32_t* pLoop)
+{
+	pCollapses->clear();
+	for (size_t i = 0; i < indexCount; i += 3)
+	{
+		for (uint32_t e = 0; e < 3; ++e)
+		{
+			uint32_t i0 = pIndices[i + e];
+			uint32_t i1 = pIndices[i + (e + 1) % 3];
+
+			// 缝两侧的边折叠在位置上是同一次操作
+			if (pRemap[i0] == pRemap[i1])
+				continue;
+
+			uint8_t k0 = pKinds[i0], k1 = pKinds[i1];
+			if (!gCanCollapse[k0][k1] && !gCanCollapse[k1][k0])
+				continue;
+			// 边界与缝只能沿开放边折叠
+			if (k0 == k1 && (k0 == VERTEX_KIND_BORDER || k0 == VERTEX_KIND_SEAM) && pLoop[i0] != i1)
+				continue;
+			// 双向都存在的边只保留一个方向
+			if (gHasOpposite[k0][k1] && pRemap[i1] > pRemap[i0])
+				continue;
+
+			Collapse collapse;
+			if (k0 == k1)
+			{
+				// 沿边界/缝的边两个方向都可以折叠
+				collapse.mV0 = i0;
+				collapse.mV1 = i1;
+				collapse.mBidirectional = 1;
+			}
+			else
+			{
+				collapse.mV0 = gCanCollapse[k0][k1] ? i0 : i1;
+				collapse.mV1 = gCanCollapse[k0][k1] ? i1 : i0;
+				collapse.mBidirectional = 0;
+			}
+			pCollapses->push_back(collapse);
+		}
+	}
+}
+
+static float collapseError(uint32_t v0, uint32_t v1, const Vector3* pPositions, const uint32_t* pRemap, const uint32_t* pWedge, const uint8_t* pKinds,
+	const Quadric* pVertexQuadrics, const Quadric* pAttributeQuadrics, const QuadricGrad* pGradients, const float* pAttributes, uint32_t attributeCount)
+{
+	float error = quadricError(pVertexQuadrics[pRemap[v0]], pPositions[v1]);
+	if (attributeCount)
+	{
+		error += quadricError(pAttributeQuadrics[v0], pGradients + v0 * attributeCount, attributeCount, pPositions[v1], pAttributes + v1 * attributeCount);
+		// 缝的另一侧同时折叠到对应的顶点
+		if (pKinds[v0] == VERTEX_KIND_SEAM)
+		{
+			uint32_t s0 = pWedge[v0], s1 = pWedge[v1];
+			error += quadricError(pAttributeQuadrics[s0], pGradients + s0 * attributeCount, attributeCount, pPositions[s1], pAttributes + s1 * attributeCount);
+		}
+	}
+	return error;
+}
+
+/// <summary>
+/// 误差非负, 其浮点位模式的大小顺序与数值一致, 取高位做一次计数排序, 代替比较排序
+/// </summary>
+static void sortEdgeCollapses(uint32_t* pOrder, const Collapse* pCollapses, size_t collapseCount, uint32_t* pHistogram)
+{
+	const uint32_t shift = 31 - COLLAPSE_SORT_BITS;
+	memset(pHistogram, 0, sizeof(uint32_t) << COLLAPSE_SORT_BITS);
+	for (size_t i = 0; i < collapseCount; ++i)
+	{
+		uint32_t bits;
+		memcpy(&bits, &pCollapses[i].mError, sizeof(bits));
+		pHistogram[(bits >> shift) & ((1u << COLLAPSE_SORT_BITS) - 1)]++;
+	}
+
+	uint32_t offset = 0;
+	for (uint32_t bucket = 0; bucket < (1u << COLLAPSE_SORT_BITS); ++bucket)
+	{
+		uint32_t count = pHistogram[bucket];
+		pHistogram[bucket] = offset;
+		offset += count;
+	}
+
+	for (size_t i = 0; i < collapseCount; ++i)
+	{
+		uint32_t bits;
+		memcpy(&bits, &pCollapses[i].mError, sizeof(bits));
+		pOrder[pHistogram[(bits >> shift) & ((1u << COLLAPSE_SORT_BITS) - 1)]++] = (uint32_t)i;
+	}
+}
+
+// 检查把 r0 移动到 r1 后, r0 周围 (不含被折叠掉的) 三角形的法线是否反向
+static bool hasTriangleFlips(const EdgeAdjacency& adjacency, const Vector3* pPositions, const uint32_t* pRemap, const uint32_t* pCollapseRemap, uint32_t r0, uint32_t r1)
+{
+	const Vector3& v0 = pPositions[r0];
+	const Vector3& v1 = pPositions[r1];
+	const uint32_t* pEdges = adjacency.mData.data() + adjacency.mOffsets[r0];
+	for (uint32_t i = 0; i < adjacency.mCounts[r0]; ++i)
+	{
+		uint32_t a = pCollapseRemap[pEdges[i * 2 + 0]];
+		uint32_t b = pCollapseRemap[pEdges[i * 2 + 1]];
+		if (pRemap[a] == r1 || pRemap[b] == r1)
+			continue;
+
+		Vector3 pa = pPositions[a], pb = pPositions[b];
+		Vector3 n0 = cross(sub(pa, v0), sub(pb, v0));
+		Vector3 n1 = cross(sub(pa, v1), sub(pb, v1));
+		// 法线几乎垂直也视为翻转, 避免生成退化的三角形
+		if (dot(n0, n1) <= 1e-2f * sqrtf(dot(n0, n0) * dot(n1, n1)))
+			return true;
+	}
+	return false;
+}
+
+/// <summary>
+/// 每轮: 收集候选边并计算误差, 按误差从小到大依次折叠, 同一轮内一个位置只参与一次折叠
+/// 每轮结束时重写索引并删除退化三角形, 然后更新开放边的链接
+/// </summary>
+size_t simplifyMesh(uint32_t* pDst, const uint32_t* pIndices, size_t indexCount, const float* pPositions, size_t vertexCount, size_t vertexStride,
+	const float* pAttributes, size_t attributeStride, const float* pAttributeWeights, uint32_t attributeCount,
+	size_t targetIndexCount, float targetError, float* pOutError)
+{
+	if (pDst != pIndices)
+		memcpy(pDst, pIndices, indexCount * sizeof(uint32_t));
+	if (!pAttributes)
+		attributeCount = 0;
+	attributeCount = std::min(attributeCount, (uint32_t)MESH_SIMPLIFIER_MAX_ATTRIBUTES);
+
+	uint32_t* pResult = pDst;
+	size_t resultCount = indexCount;
+	float resultError = 0.0f;
+
+	// 位置归一化到单位立方体, 误差即为相对包围盒最大边长的值
+	float scale = getSimplifyScale(pPositions, vertexCount, vertexStride);
+	float minimum[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		const float* pPosition = (const float*)((const uint8_t*)pPositions + v * vertexStride);
+		for (uint32_t c = 0; c < 3; ++c)
+			minimum[c] = std::min(minimum[c], pPosition[c]);
+	}
+	float scaleInv = scale > 0.0f ? 1.0f / scale : 0.0f;
+
+	Vector3List positions(vertexCount);
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		const float* pPosition = (const float*)((const uint8_t*)pPositions + v * vertexStride);
+		positions[v] = { (pPosition[0] - minimum[0]) * scaleInv, (pPosition[1] - minimum[1]) * scaleInv, (pPosition[2] - minimum[2]) * scaleInv };
+	}
+
+	FloatList attributes(vertexCount * attributeCount);
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		const float* pAttribute = (const float*)((const uint8_t*)pAttributes + v * attributeStride);
+		for (uint32_t k = 0; k < attributeCount; ++k)
+			attributes[v * attributeCount + k] = pAttribute[k] * (pAttributeWeights ? pAttributeWeights[k] : 1.0f);
+	}
+
+	IndexList remap(vertexCount);
+	IndexList wedge(vertexCount);
+	buildPositionRemap(remap.data(), wedge.data(), positions.data(), vertexCount);
+
+	ByteList kinds(vertexCount);
+	IndexList loop(vertexCount);
+	IndexList loopBack(vertexCount);
+	classifyVertices(kinds.data(), loop.data(), loopBack.data(), pResult, resultCount, vertexCount, remap.data(), wedge.data());
+
+	QuadricList vertexQuadrics(vertexCount, Quadric{});
+	fillFaceQuadrics(vertexQuadrics.data(), pResult, resultCount, positions.data(), remap.data());
+	fillEdgeQuadrics(vertexQuadrics.data(), pResult, resultCount, positions.data(), remap.data(), kinds.data(), loop.data(), loopBack.data());
+
+	QuadricList attributeQuadrics(attributeCount ? vertexCount : 0, Quadric{});
+	QuadricGradList gradients(vertexCount * attributeCount, QuadricGrad{});
+	if (attributeCount)
+		fillAttributeQuadrics(attributeQuadrics.data(), gradients.data(), pResult, resultCount, positions.data(), attributes.data(), attributeCount);
+
+	EdgeAdjacency adjacency;
+	CollapseList collapses;
+	collapses.reserve(indexCount);
+	IndexList order;
+	IndexList histogram(1u << COLLAPSE_SORT_BITS);
+	IndexList collapseRemap(vertexCount);
+	ByteList collapseLocked(vertexCount);
+	float errorLimit = targetError * targetError;
+
+	while (resultCount > targetIndexCount)
+	{
+		buildEdgeAdjacency(&adjacency, pResult, resultCount, vertexCount, remap.data(), true);
+
+		pickEdgeCollapses(&collapses, pResult, resultCount, remap.data(), kinds.data(), loop.data());
+		if (collapses.empty())
+			break;
+
+		for (Collapse& collapse : collapses)
+		{
+			uint32_t i0 = collapse.mV0, i1 = collapse.mV1;
+			float ei = collapseError(i0, i1, positions.data(), remap.data(), wedge.data(), kinds.data(), vertexQuadrics.data(),
+				attributeQuadrics.data(), gradients.data(), attributes.data(), attributeCount);
+			float ej = collapse.mBidirectional ? collapseError(i1, i0, positions.data(), remap.data(), wedge.data(), kinds.data(), vertexQuadrics.data(),
+				attributeQuadrics.data(), gradients.data(), attributes.data(), attributeCount) : FLT_MAX;
+			collapse.mV0 = ei <= ej ? i0 : i1;
+			collapse.mV1 = ei <= ej ? i1 : i0;
+			collapse.mError = std::min(ei, ej);
+		}
+
+		order.resize(collapses.size());
+		sortEdgeCollapses(order.data(), collapses.data(), collapses.size(), histogram.data());
+
+		// 每次内部边折叠去掉两个三角形; 误差上限取本轮目标折叠数处候选误差的倍数, 让低误差的区域先简化
+		size_t triangleCollapseGoal = (resultCount - targetIndexCount) / 3;
+		size_t edgeCollapseGoal = triangleCollapseGoal / 2;
+		float passErrorLimit = errorLimit;
+		if (edgeCollapseGoal < collapses.size())
+			passErrorLimit = std::min(passErrorLimit, collapses[order[edgeCollapseGoal]].mError * PASS_ERROR_FACTOR);
+
+		for (size_t v = 0; v < vertexCount; ++v)
+			collapseRemap[v] = (uint32_t)v;
+		memset(collapseLocked.data(), 0, vertexCount);
+
+		size_t triangleCollapses = 0;
+		size_t edgeCollapses = 0;
+		for (uint32_t index : order)
+		{
+			const Collapse& collapse = collapses[index];
+			if (collapse.mError > passErrorLimit)
+				break;
+			if (triangleCollapses >= triangleCollapseGoal)
+				break;
+
+			uint32_t i0 = collapse.mV0, i1 = collapse.mV1;
+			uint32_t r0 = remap[i0], r1 = remap[i1];
+			if (collapseLocked[r0] || collapseLocked[r1])
+				continue;
+			// 周围的折叠完成后可能不再翻转, 下一轮重新评估
+			if (hasTriangleFlips(adjacency, positions.data(), remap.data(), collapseRemap.data(), r0, r1))
+				continue;
+
+			quadricAdd(&vertexQuadrics[r1], vertexQuadrics[r0]);
+			if (attributeCount)
+			{
+				quadricAdd(&attributeQuadrics[i1], attributeQuadrics[i0]);
+				quadricAdd(&gradients[i1 * attributeCount], &gradients[i0 * attributeCount], attributeCount);
+			}
+
+			if (kinds[i0] == VERTEX_KIND_SEAM)
+			{
+				uint32_t s0 = wedge[i0], s1 = wedge[i1];
+				if (attributeCount)
+				{
+					quadricAdd(&attributeQuadrics[s1], attributeQuadrics[s0]);
+					quadricAdd(&gradients[s1 * attributeCount], &gradients[s0 * attributeCount], attributeCount);
+				}
+				collapseRemap[i0] = i1;
+				collapseRemap[s0] = s1;
+			}
+			else
+			{
+				// 同一位置的所有顶点一起移动 (内部顶点只有一个, 锁定顶点不会被折叠)
+				uint32_t v = i0;
+				do
+				{
+					collapseRemap[v] = i1;
+					v = wedge[v];
+				} while (v != i0);
+			}
+
+			collapseLocked[r0] = 1;
+			collapseLocked[r1] = 1;
+			// 内部边折叠去掉两个三角形, 边界边去掉一个
+			triangleCollapses += kinds[i0] == VERTEX_KIND_BORDER ? 1 : 2;
+			edgeCollapses++;
+			resultError = std::max(resultError, collapse.mError);
+		}
+
+		if (!edgeCollapses)
+			break;
+
+		size_t writeCount = 0;
+		for (size_t i = 0; i < resultCount; i += 3)
+		{
+			uint32_t v0 = collapseRemap[pResult[i + 0]];
+			uint32_t v1 = collapseRemap[pResult[i + 1]];
+			uint32_t v2 = collapseRemap[pResult[i + 2]];
+			if (v0 != v1 && v0 != v2 && v1 != v2)
+			{
+				pResult[writeCount + 0] = v0;
+				pResult[writeCount + 1] = v1;
+				pResult[writeCount + 2] = v2;
+				writeCount += 3;
+			}
+		}
+		resultCount = writeCount;
+
+		// 开放边的下一个顶点被折叠后, 链接到其折叠目标; 沿反方向折叠时跳过被折叠的顶点
+		for (size_t v = 0; v < vertexCount; ++v)
+		{
+			if (loop[v] != INVALID_INDEX)
+			{
+				uint32_t l = loop[v];
+				uint32_t r = collapseRemap[l];
+				loop[v] = r == v ? loop[l] : r;
+			}
+			if (loopBack[v] != INVALID_INDEX)
+			{
+				uint32_t l = loopBack[v];
+				uint32_t r = collapseRemap[l];
+				loopBack[v] = r == v ? loopBack[l] : r;
+			}
+		}
+	}
+
+	if (pOutError)
+		*pOutError = sqrtf(resultError);
+	return resultCount;
+}
+
+float getSimplifyScale(const float* pPositions, size_t vertexCount, size_t vertexStride)
+{
+	float minimum[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+	float maximum[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+	for (size_t v = 0; v < vertexCount; ++v)
+	{
+		const float* pPosition = (const float*)((const uint8_t*)pPositions + v * vertexStride);
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			minimum[c] = std::min(minimum[c], pPosition[c]);
+			maximum[c] = std::max(maximum[c], pPosition[c]);
+		}
+	}
+
+	float extent = 0.0f;
+	for (uint32_t c = 0; c < 3; ++c)
+		extent = std::max(extent, maximum[c] - minimum[c]);
+	return extent;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+// 参与简化误差计算的顶点属性分量上限 (如法线 3 + UV 2)
+#define MESH_SIMPLIFIER_MAX_ATTRIBUTES 8
+
+/// <summary>
+/// 二次误差度量 (QEM) 边折叠简化, 折叠到已有顶点, 只输出新的索引, 顶点缓冲不变
+/// 属性缝 (位置相同而属性不同的顶点) 只能沿缝折叠, 开放边界只能沿边界折叠, 拓扑复杂的顶点不移动
+/// pAttributes 为每个顶点 attributeCount 个浮点分量, 乘以 pAttributeWeights 后与几何误差一起计入折叠代价; 可以为 NULL
+/// targetError 与 *pOutError 以网格包围盒的最大边长为单位; pDst 可以与 pIndices 相同
+/// 返回简化后的索引数, 达到 targetIndexCount 或继续折叠将超出 targetError 时停止
+/// </summary>
+size_t simplifyMesh(uint32_t* pDst, const uint32_t* pIndices, size_t indexCount, const float* pPositions, size_t vertexCount, size_t vertexStride,
+	const float* pAttributes, size_t attributeStride, const float* pAttributeWeights, uint32_t attributeCount,
+	size_t targetIndexCount, float targetError, float* pOutError);
+
+// 网格包围盒的最大边长, 用于把 simplifyMesh 的相对误差换算为模型空间的距离
+float getSimplifyScale(const float* pPositions, size_t vertexCount, size_t vertexStride);
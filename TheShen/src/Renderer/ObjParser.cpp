@@ -0,0 +1,790 @@
+// tinyobjloader 的实现在本文件中编译, ObjParser.h 已包含其头文件
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "ObjParser.h"
+#include "Core/JobSystem.h"
+#include "Core/Log.h"
+#include "Core/MappedFile.h"
+#include "Core/Memory.h"
+#include "Core/Profiler.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define OBJ_PARSER_SSE2 1
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+// 块大小的上下限, 块数目标为线程数的 4 倍, 使解析速度不均的块之间能够互相平衡
+const size_t OBJ_MIN_CHUNK_SIZE = 1 << 20;
+const size_t OBJ_MAX_CHUNK_SIZE = 16 << 20;
+// 查表覆盖的小数位数与十进制指数范围, 超出时与 tinyobj 一样调用 pow
+const int OBJ_FRACTION_TABLE_SIZE = 32;
+const int OBJ_EXPONENT_TABLE_RANGE = 400;
+
+typedef std::vector<float, CategoryAllocator<float, MEMORY_CATEGORY_ASSETS>> ObjFloatList;
+typedef std::vector<tinyobj::index_t, CategoryAllocator<tinyobj::index_t, MEMORY_CATEGORY_ASSETS>> ObjIndexList;
+
+typedef enum ObjEventType
+{
+	OBJ_EVENT_USEMTL = 0,
+	OBJ_EVENT_MTLLIB,
+	OBJ_EVENT_GROUP,
+	OBJ_EVENT_OBJECT,
+} ObjEventType;
+
+/// <summary>
+/// 影响分组的行, 记录其在块内出现时已解析的面数与三角形数, 合并时按顺序重放 tinyobj 的状态机
+/// </summary>
+typedef struct ObjEvent
+{
+	ObjEventType	mType;
+	std::string		mName;
+	uint64_t		mFaceCount;
+	uint64_t		mTriangleCount;
+} ObjEvent;
+
+// 负索引相对于当时已有的属性数, 块内只知道块内的数量, 合并时再加上前面各块的总数
+#define OBJ_RELATIVE_VERTEX		0x1u
+#define OBJ_RELATIVE_NORMAL		0x2u
+#define OBJ_RELATIVE_TEXCOORD	0x4u
+
+typedef struct ObjRelativeIndex
+{
+	uint64_t mPosition;
+	uint32_t mMask;
+} ObjRelativeIndex;
+
+typedef struct ObjCorner
+{
+	int			mVertex;
+	int			mNormal;
+	int			mTexCoord;
+	uint32_t	mRelativeMask;
+} ObjCorner;
+
+/// <summary>
+/// 一个按行对齐的块的解析结果, m*Base 为前面各块的累计数量 (前缀和)
+/// </summary>
+typedef struct ObjChunk
+{
+	const char*		pBegin;
+	const char*		pEnd;
+	ObjFloatList	mPositions;
+	ObjFloatList	mNormals;
+	ObjFloatList	mTexCoords;
+	// 三角化后的角, 每 3 个为一个三角形
+	ObjIndexList	mIndices;
+	std::vector<ObjRelativeIndex, CategoryAllocator<ObjRelativeIndex, MEMORY_CATEGORY_ASSETS>> mRelativeIndices;
+	std::vector<ObjEvent> mEvents;
+	uint64_t		mFaceCount;
+	uint64_t		mVertexBase;
+	uint64_t		mNormalBase;
+	uint64_t		mTexCoordBase;
+	uint64_t		mFaceBase;
+	uint64_t		mTriangleBase;
+	// 含有不支持的 SubD 标签行
+	bool			mUnsupported;
+} ObjChunk;
+
+/// <summary>
+/// 形状中的一段连续三角形, mBegin/mEnd 为全局三角形序号, mDestination 为在形状中的起始三角形
+/// </summary>
+typedef struct ObjSegment
+{
+	uint64_t	mBegin;
+	uint64_t	mEnd;
+	uint32_t	mShape;
+	uint64_t	mDestination;
+	int			mMaterial;
+} ObjSegment;
+
+typedef struct ObjParseContext
+{
+	std::vector<ObjChunk>	mChunks;
+	std::vector<ObjSegment>	mSegments;
+	const char*				pFileEnd;
+	tinyobj::attrib_t*		pAttrib;
+	std::vector<tinyobj::shape_t>* pShapes;
+} ObjParseContext;
+
+/// <summary>
+/// tinyobj 逐位累加尾数: 小数位乘以 pow(10, -位序), 最后 ldexp(尾数 * pow(5, e), e)
+/// 结果并非正确舍入, 为保证逐位相同这里重放同样的双精度运算, 只把 pow 换成同样由 pow 生成的表
+/// </summary>
+typedef struct ObjPowerTables
+{
+	double mNegativePowersOf10[OBJ_FRACTION_TABLE_SIZE + 1];
+	double mPowersOf5[2 * OBJ_EXPONENT_TABLE_RANGE + 1];
+
+	ObjPowerTables()
+	{
+		for (int i = 0; i <= OBJ_FRACTION_TABLE_SIZE; ++i)
+			mNegativePowersOf10[i] = pow(10.0, -i);
+		for (int i = -OBJ_EXPONENT_TABLE_RANGE; i <= OBJ_EXPONENT_TABLE_RANGE; ++i)
+			mPowersOf5[i + OBJ_EXPONENT_TABLE_RANGE] = pow(5.0, i);
+	}
+} ObjPowerTables;
+
+static const ObjPowerTables& getPowerTables()
+{
+	static const ObjPowerTables tables;
+	return tables;
+}
+
+static inline bool isDigit(char c)
+{
+	return (unsigned)(c - '0') < 10u;
+}
+
+static inline uint32_t countTrailingZeros(uint32_t mask)
+{
+#ifdef _MSC_VER
+	unsigned long index;
+	_BitScanForward(&index, mask);
+	return (uint32_t)index;
+#else
+	return (uint32_t)__builtin_ctz(mask);
+#endif
+}
+
+/// <summary>
+/// 从 p 开始连续数字的个数, 不超过 pEnd; pReadEnd 为可以安全读取的上界 (映射文件末尾)
+/// SSE2 一次判断 16 个字符, 数字串通常在一两次比较内结束
+/// </summary>
+static inline size_t countDigits(const char* p, const char* pEnd, const char* pReadEnd)
+{
+	const char* pStart = p;
+#ifdef OBJ_PARSER_SSE2
+	const __m128i zero = _mm_set1_epi8('0');
+	const __m128i nine = _mm_set1_epi8(9);
+	while (p + 16 <= pReadEnd && p < pEnd)
+	{
+		__m128i digits = _mm_sub_epi8(_mm_loadu_si128((const __m128i*)p), zero);
+		// 无符号比较 digits <= 9
+		uint32_t mask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_min_epu8(digits, nine), digits));
+		if (mask != 0xffff)
+		{
+			p += countTrailingZeros(~mask);
+			return (size_t)(std::min(p, pEnd) - pStart);
+		}
+		p += 16;
+	}
+	p = std::min(p, pEnd);
+#endif
+	while (p < pEnd && isDigit(*p))
+		++p;
+	return (size_t)(p - pStart);
+}
+
+/// <summary>
+/// 第一个空格/制表符/回车的位置 (tinyobj 的 strcspn(token, " \t\r")), 不超过 pEnd
+/// </summary>
+static inline const char* findTokenEnd(const char* p, const char* pEnd, const char* pReadEnd)
+{
+#ifdef OBJ_PARSER_SSE2
+	const __m128i space = _mm_set1_epi8(' ');
+	const __m128i tab = _mm_set1_epi8('\t');
+	const __m128i carriageReturn = _mm_set1_epi8('\r');
+	while (p + 16 <= pReadEnd && p < pEnd)
+	{
+		__m128i chars = _mm_loadu_si128((const __m128i*)p);
+		__m128i delimiters = _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chars, space), _mm_cmpeq_epi8(chars, tab)),
+			_mm_cmpeq_epi8(chars, carriageReturn));
+		uint32_t mask = (uint32_t)_mm_movemask_epi8(delimiters);
+		if (mask)
+			return std::min(p + countTrailingZeros(mask), pEnd);
+		p += 16;
+	}
+	p = std::min(p, pEnd);
+#endif
+	while (p < pEnd && *p != ' ' && *p != '\t' && *p != '\r')
+		++p;
+	return p;
+}
+
+/// <summary>
+/// tinyobj::tryParseDouble 的等价实现, 语法与运算顺序完全相同
+/// 整数部分不超过 15 位时按 64 位整数累加, 此时每一步双精度运算都是精确的, 结果相同
+/// </summary>
+static bool parseDouble(const char* s, const char* sEnd, const char* pReadEnd, double* pResult)
+{
+	if (s >= sEnd)
+		return false;
+
+	const char* curr = s;
+	char sign = '+';
+	if (*curr == '+' || *curr == '-')
+		sign = *curr++;
+	else if (!isDigit(*curr))
+		return false;
+
+	size_t digits = countDigits(curr, sEnd, pReadEnd);
+	if (!digits)
+		return false;
+	double mantissa = 0.0;
+	if (digits <= 15)
+	{
+		uint64_t value = 0;
+		for (size_t i = 0; i < digits; ++i)
+			value = value * 10 + (uint64_t)(curr[i] - '0');
+		mantissa = (double)value;
+	}
+	else
+	{
+		for (size_t i = 0; i < digits; ++i)
+		{
+			mantissa *= 10;
+			mantissa += (int)(curr[i] - '0');
+		}
+	}
+	curr += digits;
+
+	const ObjPowerTables& tables = getPowerTables();
+	if (curr != sEnd && *curr == '.')
+	{
+		++curr;
+		digits = countDigits(curr, sEnd, pReadEnd);
+		for (size_t i = 0; i < digits; ++i)
+		{
+			int read = (int)i + 1;
+			double scale = read <= OBJ_FRACTION_TABLE_SIZE ? tables.mNegativePowersOf10[read] : pow(10.0, -read);
+			mantissa += (int)(curr[i] - '0') * scale;
+		}
+		curr += digits;
+	}
+
+	int exponent = 0;
+	if (curr != sEnd && (*curr == 'e' || *curr == 'E'))
+	{
+		++curr;
+		char exponentSign = '+';
+		if (curr != sEnd && (*curr == '+' || *curr == '-'))
+			exponentSign = *curr++;
+		else if (curr == sEnd || !isDigit(*curr))
+			return false;
+
+		digits = countDigits(curr, sEnd, pReadEnd);
+		for (size_t i = 0; i < digits; ++i)
+		{
+			exponent *= 10;
+			exponent += (int)(curr[i] - '0');
+		}
+		exponent *= (exponentSign == '+' ? 1 : -1);
+		if (!digits)
+			return false;
+	}
+
+	double powerOf5 = abs(exponent) <= OBJ_EXPONENT_TABLE_RANGE ? tables.mPowersOf5[exponent + OBJ_EXPONENT_TABLE_RANGE] : pow(5.0, exponent);
+	*pResult = (sign == '+' ? 1 : -1) * ldexp(mantissa * powerOf5, exponent);
+	return true;
+}
+
+/// <summary>
+/// 行内游标, 越过行尾读取时返回 '\0', 与 tinyobj 在 std::string 上的行为一致
+/// </summary>
+typedef struct ObjLine
+{
+	const char* p;
+	const char* pEnd;
+	const char* pReadEnd;
+
+	char peek(size_t offset) const { return p + offset < pEnd ? p[offset] : '\0'; }
+	void skip(const char* pSet) { while (p < pEnd && strchr(pSet, *p) && *p) ++p; }
+} ObjLine;
+
+static inline float parseFloat(ObjLine* pLine)
+{
+	pLine->skip(" \t");
+	const char* pTokenEnd = findTokenEnd(pLine->p, pLine->pEnd, pLine->pReadEnd);
+	double value = 0.0;
+	parseDouble(pLine->p, pTokenEnd, pLine->pReadEnd, &value);
+	pLine->p = pTokenEnd;
+	return (float)value;
+}
+
+// atoi: 跳过空白, 可选符号, 十进制数字
+static inline int parseIndex(const ObjLine* pLine)
+{
+	const char* p = pLine->p;
+	while (p < pLine->pEnd && isspace((unsigned char)*p))
+		++p;
+	bool negative = false;
+	if (p < pLine->pEnd && (*p == '+' || *p == '-'))
+		negative = *p++ == '-';
+	int value = 0;
+	while (p < pLine->pEnd && isDigit(*p))
+		value = value * 10 + (*p++ - '0');
+	return negative ? -value : value;
+}
+
+// strcspn(token, "/ \t\r")
+static inline void skipIndexToken(ObjLine* pLine)
+{
+	while (pLine->p < pLine->pEnd && *pLine->p != '/' && *pLine->p != ' ' && *pLine->p != '\t' && *pLine->p != '\r')
+		++pLine->p;
+}
+
+// tinyobj::fixIndex, 负索引先记为块内相对值
+static inline int resolveIndex(int index, size_t localCount, uint32_t relativeBit, uint32_t* pRelativeMask)
+{
+	if (index > 0)
+		return index - 1;
+	if (index == 0)
+		return 0;
+	*pRelativeMask |= relativeBit;
+	return (int)localCount + index;
+}
+
+/// <summary>
+/// tinyobj::parseTriple: i, i/j/k, i//k, i/j
+/// </summary>
+static ObjCorner parseCorner(ObjLine* pLine, const ObjChunk* pChunk)
+{
+	ObjCorner corner = { -1, -1, -1, 0 };
+	corner.mVertex = resolveIndex(parseIndex(pLine), pChunk->mPositions.size() / 3, OBJ_RELATIVE_VERTEX, &corner.mRelativeMask);
+	skipIndexToken(pLine);
+	if (pLine->peek(0) != '/')
+		return corner;
+	++pLine->p;
+
+	if (pLine->peek(0) == '/')
+	{
+		++pLine->p;
+		corner.mNormal = resolveIndex(parseIndex(pLine), pChunk->mNormals.size() / 3, OBJ_RELATIVE_NORMAL, &corner.mRelativeMask);
+		skipIndexToken(pLine);
+		return corner;
+	}
+
+	corner.mTexCoord = resolveIndex(parseIndex(pLine), pChunk->mTexCoords.size() / 2, OBJ_RELATIVE_TEXCOORD, &corner.mRelativeMask);
+	skipIndexToken(pLine);
+	if (pLine->peek(0) != '/')
+		return corner;
+
+	++pLine->p;
+	corner.mNormal = resolveIndex(parseIndex(pLine), pChunk->mNormals.size() / 3, OBJ_RELATIVE_NORMAL, &corner.mRelativeMask);
+	skipIndexToken(pLine);
+	return corner;
+}
+
+static inline void emitCorner(ObjChunk* pChunk, const ObjCorner& corner)
+{
+	if (corner.mRelativeMask)
+		pChunk->mRelativeIndices.push_back({ pChunk->mIndices.size(), corner.mRelativeMask });
+	tinyobj::index_t index;
+	index.vertex_index = corner.mVertex;
+	index.normal_index = corner.mNormal;
+	index.texcoord_index = corner.mTexCoord;
+	pChunk->mIndices.push_back(index);
+}
+
+// sscanf("%s"): 跳过空白后的第一个单词
+static std::string parseWord(ObjLine line)
+{
+	while (line.p < line.pEnd && isspace((unsigned char)*line.p))
+		++line.p;
+	const char* pBegin = line.p;
+	while (line.p < line.pEnd && !isspace((unsigned char)*line.p))
+		++line.p;
+	return std::string(pBegin, line.p);
+}
+
+static void addEvent(ObjChunk* pChunk, ObjEventType type, std::string name)
+{
+	ObjEvent event;
+	event.mType = type;
+	event.mName = std::move(name);
+	event.mFaceCount = pChunk->mFaceCount;
+	event.mTriangleCount = pChunk->mIndices.size() / 3;
+	pChunk->mEvents.push_back(std::move(event));
+}
+
+static inline bool isObjSpace(char c)
+{
+	return c == ' ' || c == '\t';
+}
+
+/// <summary>
+/// 解析一个块, 行的识别规则与 tinyobj::LoadObj 相同, 未识别的行被忽略
+/// </summary>
+static void parseChunk(void* pUserData, uint32_t chunkIndex)
+{
+	SHEN_PROFILE_FUNCTION();
+	ObjParseContext* pContext = (ObjParseContext*)pUserData;
+	ObjChunk* pChunk = &pContext->mChunks[chunkIndex];
+
+	// 按块大小预估, 避免反复扩容; 典型扫描模型每个顶点约 30 字节, 每个面约 25 字节
+	size_t chunkSize = (size_t)(pChunk->pEnd - pChunk->pBegin);
+	pChunk->mPositions.reserve(chunkSize / 10);
+	pChunk->mIndices.reserve(chunkSize / 25 * 3);
+
+	std::vector<ObjCorner> face;
+	const char* p = pChunk->pBegin;
+	while (p < pChunk->pEnd)
+	{
+		const char* pNewLine = (const char*)memchr(p, '\n', (size_t)(pChunk->pEnd - p));
+		const char* pLineEnd = pNewLine ? pNewLine : pChunk->pEnd;
+		const char* pNext = pNewLine ? pNewLine + 1 : pChunk->pEnd;
+		if (pLineEnd > p && pLineEnd[-1] == '\r')
+			--pLineEnd;
+
+		ObjLine line = { p, pLineEnd, pContext->pFileEnd };
+		p = pNext;
+		line.skip(" \t");
+		if (line.p == line.pEnd || line.peek(0) == '#')
+			continue;
+
+		char c0 = line.peek(0);
+		char c1 = line.peek(1);
+		if (c0 == 'v' && isObjSpace(c1))
+		{
+			line.p += 2;
+			float x = parseFloat(&line);
+			float y = parseFloat(&line);
+			float z = parseFloat(&line);
+			pChunk->mPositions.insert(pChunk->mPositions.end(), { x, y, z });
+			continue;
+		}
+		if (c0 == 'v' && c1 == 'n' && isObjSpace(line.peek(2)))
+		{
+			line.p += 3;
+			float x = parseFloat(&line);
+			float y = parseFloat(&line);
+			float z = parseFloat(&line);
+			pChunk->mNormals.insert(pChunk->mNormals.end(), { x, y, z });
+			continue;
+		}
+		if (c0 == 'v' && c1 == 't' && isObjSpace(line.peek(2)))
+		{
+			line.p += 3;
+			float u = parseFloat(&line);
+			float v = parseFloat(&line);
+			pChunk->mTexCoords.insert(pChunk->mTexCoords.end(), { u, v });
+			continue;
+		}
+		if (c0 == 'f' && isObjSpace(c1))
+		{
+			line.p += 2;
+			line.skip(" \t");
+			face.clear();
+			while (line.peek(0) != '\r' && line.peek(0) != '\0')
+			{
+				face.push_back(parseCorner(&line, pChunk));
+				line.skip(" \t\r");
+			}
+
+			// 三角扇: (0, k - 1, k)
+			for (size_t k = 2; k < face.size(); ++k)
+			{
+				emitCorner(pChunk, face[0]);
+				emitCorner(pChunk, face[k - 1]);
+				emitCorner(pChunk, face[k]);
+			}
+			++pChunk->mFaceCount;
+			continue;
+		}
+		if (!strncmp(line.p, "usemtl", std::min<size_t>(6, line.pEnd - line.p)) && line.pEnd - line.p >= 6 && isObjSpace(line.peek(6)))
+		{
+			line.p += 7;
+			addEvent(pChunk, OBJ_EVENT_USEMTL, parseWord(line));
+			continue;
+		}
+		if (!strncmp(line.p, "mtllib", std::min<size_t>(6, line.pEnd - line.p)) && line.pEnd - line.p >= 6 && isObjSpace(line.peek(6)))
+		{
+			line.p += 7;
+			addEvent(pChunk, OBJ_EVENT_MTLLIB, parseWord(line));
+			continue;
+		}
+		if (c0 == 'g' && isObjSpace(c1))
+		{
+			// tinyobj 以空格/制表符/回车切分整行, 第一个词是 "g", 组名取第二个词
+			line.p += 1;
+			line.skip(" \t\r");
+			line.skip(" \t");
+			const char* pNameEnd = findTokenEnd(line.p, line.pEnd, line.pReadEnd);
+			addEvent(pChunk, OBJ_EVENT_GROUP, std::string(line.p, pNameEnd));
+			continue;
+		}
+		if (c0 == 'o' && isObjSpace(c1))
+		{
+			line.p += 2;
+			addEvent(pChunk, OBJ_EVENT_OBJECT, parseWord(line));
+			continue;
+		}
+		if (c0 == 't' && isObjSpace(c1))
+			pChunk->mUnsupported = true;
+	}
+}
+
+/// <summary>
+/// 负索引加上前面各块的属性数, 再把块内的顶点属性拷贝到最终位置
+/// </summary>
+static void mergeChunkAttributes(void* pUserData, uint32_t chunkIndex)
+{
+	SHEN_PROFILE_FUNCTION();
+	ObjParseContext* pContext = (ObjParseContext*)pUserData;
+	ObjChunk* pChunk = &pContext->mChunks[chunkIndex];
+
+	for (const ObjRelativeIndex& relative : pChunk->mRelativeIndices)
+	{
+		tinyobj::index_t& index = pChunk->mIndices[relative.mPosition];
+		if (relative.mMask & OBJ_RELATIVE_VERTEX)
+			index.vertex_index += (int)pChunk->mVertexBase;
+		if (relative.mMask & OBJ_RELATIVE_NORMAL)
+			index.normal_index += (int)pChunk->mNormalBase;
+		if (relative.mMask & OBJ_RELATIVE_TEXCOORD)
+			index.texcoord_index += (int)pChunk->mTexCoordBase;
+	}
+
+	tinyobj::attrib_t* pAttrib = pContext->pAttrib;
+	if (!pChunk->mPositions.empty())
+		memcpy(pAttrib->vertices.data() + pChunk->mVertexBase * 3, pChunk->mPositions.data(), pChunk->mPositions.size() * sizeof(float));
+	if (!pChunk->mNormals.empty())
+		memcpy(pAttrib->normals.data() + pChunk->mNormalBase * 3, pChunk->mNormals.data(), pChunk->mNormals.size() * sizeof(float));
+	if (!pChunk->mTexCoords.empty())
+		memcpy(pAttrib->texcoords.data() + pChunk->mTexCoordBase * 2, pChunk->mTexCoords.data(), pChunk->mTexCoords.size() * sizeof(float));
+	pChunk->mPositions = ObjFloatList();
+	pChunk->mNormals = ObjFloatList();
+	pChunk->mTexCoords = ObjFloatList();
+}
+
+/// <summary>
+/// 把块内的三角形拷贝到与之重叠的各形状段中
+/// </summary>
+static void mergeChunkTriangles(void* pUserData, uint32_t chunkIndex)
+{
+	SHEN_PROFILE_FUNCTION();
+	ObjParseContext* pContext = (ObjParseContext*)pUserData;
+	ObjChunk* pChunk = &pContext->mChunks[chunkIndex];
+	uint64_t chunkBegin = pChunk->mTriangleBase;
+	uint64_t chunkEnd = chunkBegin + pChunk->mIndices.size() / 3;
+
+	const std::vector<ObjSegment>& segments = pContext->mSegments;
+	auto it = std::upper_bound(segments.begin(), segments.end(), chunkBegin,
+		[](uint64_t triangle, const ObjSegment& segment) { return triangle < segment.mEnd; });
+	for (; it != segments.end() && it->mBegin < chunkEnd; ++it)
+	{
+		uint64_t begin = std::max(it->mBegin, chunkBegin);
+		uint64_t end = std::min(it->mEnd, chunkEnd);
+		if (begin >= end)
+			continue;
+
+		tinyobj::mesh_t& mesh = (*pContext->pShapes)[it->mShape].mesh;
+		uint64_t destination = it->mDestination + (begin - it->mBegin);
+		memcpy(mesh.indices.data() + destination * 3, pChunk->mIndices.data() + (begin - chunkBegin) * 3, (size_t)(end - begin) * 3 * sizeof(tinyobj::index_t));
+		memset(mesh.num_face_vertices.data() + destination, 3, (size_t)(end - begin));
+		std::fill(mesh.material_ids.begin() + destination, mesh.material_ids.begin() + destination + (end - begin), it->mMaterial);
+	}
+	pChunk->mIndices = ObjIndexList();
+}
+
+/// <summary>
+/// 当前形状与待导出面组的状态, 对应 tinyobj::LoadObj 中的 shape 与 faceGroup
+/// </summary>
+typedef struct ObjShapeBuilder
+{
+	std::vector<ObjSegment>	mSegments;
+	std::string				mName;
+	uint64_t				mTriangleCount;
+	uint64_t				mGroupFaceBegin;
+	uint64_t				mGroupTriangleBegin;
+} ObjShapeBuilder;
+
+// tinyobj::exportFaceGroupToShape: 面组为空时返回 false; 不足三个角的面不产生三角形, 但同样使面组非空
+static bool exportFaceGroup(ObjShapeBuilder* pBuilder, uint64_t faceEnd, uint64_t triangleEnd, int material, const std::string& name)
+{
+	if (faceEnd == pBuilder->mGroupFaceBegin)
+		return false;
+
+	if (triangleEnd > pBuilder->mGroupTriangleBegin)
+	{
+		ObjSegment segment = { pBuilder->mGroupTriangleBegin, triangleEnd, 0, pBuilder->mTriangleCount, material };
+		pBuilder->mSegments.push_back(segment);
+		pBuilder->mTriangleCount += triangleEnd - pBuilder->mGroupTriangleBegin;
+	}
+	pBuilder->mName = name;
+	return true;
+}
+
+static void pushShape(ObjShapeBuilder* pBuilder, ObjParseContext* pContext)
+{
+	uint32_t shapeIndex = (uint32_t)pContext->pShapes->size();
+	pContext->pShapes->emplace_back();
+	tinyobj::shape_t& shape = pContext->pShapes->back();
+	shape.name = pBuilder->mName;
+	shape.mesh.indices.resize((size_t)pBuilder->mTriangleCount * 3);
+	shape.mesh.num_face_vertices.resize((size_t)pBuilder->mTriangleCount);
+	shape.mesh.material_ids.resize((size_t)pBuilder->mTriangleCount);
+	for (ObjSegment& segment : pBuilder->mSegments)
+	{
+		segment.mShape = shapeIndex;
+		pContext->mSegments.push_back(segment);
+	}
+}
+
+static void resetShape(ObjShapeBuilder* pBuilder)
+{
+	pBuilder->mSegments.clear();
+	pBuilder->mName.clear();
+	pBuilder->mTriangleCount = 0;
+}
+
+/// <summary>
+/// 按文件顺序重放分组相关的行, 产生与 tinyobj 相同的形状划分与逐面材质
+/// </summary>
+static bool buildShapes(ObjParseContext* pContext, std::vector<tinyobj::material_t>* pMaterials, std::string* pError, const char* pMtlBasePath)
+{
+	SHEN_PROFILE_FUNCTION();
+	tinyobj::MaterialFileReader materialReader(pMtlBasePath ? pMtlBasePath : "");
+	std::map<std::string, int> materialMap;
+	int material = -1;
+	std::string name;
+	ObjShapeBuilder builder = {};
+
+	for (const ObjChunk& chunk : pContext->mChunks)
+	{
+		for (const ObjEvent& event : chunk.mEvents)
+		{
+			uint64_t facePosition = chunk.mFaceBase + event.mFaceCount;
+			uint64_t trianglePosition = chunk.mTriangleBase + event.mTriangleCount;
+			switch (event.mType)
+			{
+			case OBJ_EVENT_USEMTL:
+			{
+				auto it = materialMap.find(event.mName);
+				int newMaterial = it != materialMap.end() ? it->second : -1;
+				if (newMaterial != material)
+				{
+					exportFaceGroup(&builder, facePosition, trianglePosition, material, name);
+					builder.mGroupFaceBegin = facePosition;
+					builder.mGroupTriangleBegin = trianglePosition;
+					material = newMaterial;
+				}
+				break;
+			}
+			case OBJ_EVENT_MTLLIB:
+			{
+				std::string materialError;
+				bool loaded = materialReader(event.mName, pMaterials, &materialMap, &materialError);
+				if (pError)
+					*pError += materialError;
+				if (!loaded)
+					return false;
+				break;
+			}
+			case OBJ_EVENT_GROUP:
+			case OBJ_EVENT_OBJECT:
+				if (exportFaceGroup(&builder, facePosition, trianglePosition, material, name))
+					pushShape(&builder, pContext);
+				resetShape(&builder);
+				builder.mGroupFaceBegin = facePosition;
+				builder.mGroupTriangleBegin = trianglePosition;
+				name = event.mName;
+				break;
+			}
+		}
+	}
+
+	const ObjChunk& last = pContext->mChunks.back();
+	if (exportFaceGroup(&builder, last.mFaceBase + last.mFaceCount, last.mTriangleBase + last.mIndices.size() / 3, material, name))
+		pushShape(&builder, pContext);
+	return true;
+}
+
+bool loadObjParallel(tinyobj::attrib_t* pAttrib, std::vector<tinyobj::shape_t>* pShapes, std::vector<tinyobj::material_t>* pMaterials,
+	std::string* pError, const char* pFileName, const char* pMtlBasePath)
+{
+	SHEN_PROFILE_FUNCTION();
+	pAttrib->vertices.clear();
+	pAttrib->normals.clear();
+	pAttrib->texcoords.clear();
+	pShapes->clear();
+
+	MappedFile file;
+	if (!openMappedFile(pFileName, true, &file))
+	{
+		if (pError)
+			*pError = std::string("Cannot open file [") + pFileName + "]\n";
+		return false;
+	}
+
+	ObjParseContext context;
+	context.pFileEnd = (const char*)file.pData + file.mSize;
+	context.pAttrib = pAttrib;
+	context.pShapes = pShapes;
+
+	size_t chunkSize = std::min(std::max(file.mSize / (getJobThreadCount() * 4), OBJ_MIN_CHUNK_SIZE), OBJ_MAX_CHUNK_SIZE);
+	const char* pBegin = (const char*)file.pData;
+	while (pBegin < context.pFileEnd)
+	{
+		// 块的边界推进到下一个换行符之后, 每一行完整地落在一个块中
+		const char* pEnd = pBegin + std::min(chunkSize, (size_t)(context.pFileEnd - pBegin));
+		if (pEnd < context.pFileEnd)
+		{
+			const char* pNewLine = (const char*)memchr(pEnd - 1, '\n', (size_t)(context.pFileEnd - pEnd + 1));
+			pEnd = pNewLine ? pNewLine + 1 : context.pFileEnd;
+		}
+		context.mChunks.emplace_back();
+		ObjChunk& chunk = context.mChunks.back();
+		chunk.pBegin = pBegin;
+		chunk.pEnd = pEnd;
+		chunk.mFaceCount = 0;
+		chunk.mUnsupported = false;
+		pBegin = pEnd;
+	}
+	if (context.mChunks.empty())
+	{
+		closeMappedFile(&file);
+		return true;
+	}
+
+	parallelFor((uint32_t)context.mChunks.size(), parseChunk, &context);
+
+	bool unsupported = false;
+	uint64_t vertexCount = 0, normalCount = 0, texCoordCount = 0, faceCount = 0, triangleCount = 0;
+	for (ObjChunk& chunk : context.mChunks)
+	{
+		unsupported |= chunk.mUnsupported;
+		chunk.mVertexBase = vertexCount;
+		chunk.mNormalBase = normalCount;
+		chunk.mTexCoordBase = texCoordCount;
+		chunk.mFaceBase = faceCount;
+		chunk.mTriangleBase = triangleCount;
+		vertexCount += chunk.mPositions.size() / 3;
+		normalCount += chunk.mNormals.size() / 3;
+		texCoordCount += chunk.mTexCoords.size() / 2;
+		faceCount += chunk.mFaceCount;
+		triangleCount += chunk.mIndices.size() / 3;
+	}
+	if (unsupported)
+	{
+		closeMappedFile(&file);
+		SHEN_CORE_WARN("{0} uses subdivision tags, falling back to the serial OBJ loader", pFileName);
+		return tinyobj::LoadObj(pAttrib, pShapes, pMaterials, pError, pFileName, pMtlBasePath, true);
+	}
+
+	// 与 tinyobj 一样, 材质库加载失败时不输出顶点属性
+	if (!buildShapes(&context, pMaterials, pError, pMtlBasePath))
+	{
+		closeMappedFile(&file);
+		return false;
+	}
+
+	pAttrib->vertices.resize((size_t)vertexCount * 3);
+	pAttrib->normals.resize((size_t)normalCount * 3);
+	pAttrib->texcoords.resize((size_t)texCoordCount * 2);
+	parallelFor((uint32_t)context.mChunks.size(), mergeChunkAttributes, &context);
+	closeMappedFile(&file);
+	parallelFor((uint32_t)context.mChunks.size(), mergeChunkTriangles, &context);
+
+	SHEN_CORE_TRACE("parsed {0} with {1} chunks on {2} threads: {3} vertices, {4} triangles, {5} shapes", pFileName,
+		context.mChunks.size(), getJobThreadCount(), vertexCount, triangleCount, pShapes->size());
+	return true;
+}
@@ -0,0 +1,14 @@
+#pragma once
+
+#include "tiny_obj_loader.h"
+
+#include <string>
+#include <vector>
+
+/// <summary>
+/// 并行 OBJ 解析, 输出与 tinyobj::LoadObj (triangulate = true) 完全相同, 可直接替换
+/// 文件映射后按行对齐切块, 各块经作业系统并行解析, 再按前缀和合并顶点属性与三角形
+/// 含 SubD 标签 ('t' 行) 的文件回退到 tinyobj::LoadObj
+/// </summary>
+bool loadObjParallel(tinyobj::attrib_t* pAttrib, std::vector<tinyobj::shape_t>* pShapes, std::vector<tinyobj::material_t>* pMaterials,
+	std::string* pError, const char* pFileName, const char* pMtlBasePath = NULL);
@@ -1,5 +1,16 @@
 #include "Renderer.h"
+#include "GpuProfiler.h"
+#include "Core/AssetPack.h"
 #include "Core/Log.h"
+#include "Core/Memory.h"
+#include "Core/Profiler.h"
+#include "Core/FlightRecorder.h"
+#include "Core/MetricsExporter.h"
+
+#include <cctype>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
 const std::vector<const char*> validationLayers = {
 	"VK_LAYER_KHRONOS_validation"
@@ -17,6 +28,337 @@ const bool enableValidationLayers = true;
 
 VkDebugUtilsMessengerEXT debugMessenger;
 
+/// <summary>
+/// Vulkan 主机内存分配回调, 按 VkSystemAllocationScope 归类统计
+/// </summary>
+static MemoryCategory vkScopeToMemoryCategory(VkSystemAllocationScope scope)
+{
+	return (MemoryCategory)(MEMORY_CATEGORY_VULKAN_COMMAND + (uint32_t)scope);
+}
+
+static VKAPI_ATTR void* VKAPI_CALL vkTrackedAllocation(void* pUserData, size_t size, size_t alignment, VkSystemAllocationScope allocationScope)
+{
+	return shen_memalign(vkScopeToMemoryCategory(allocationScope), alignment, size);
+}
+
+static VKAPI_ATTR void* VKAPI_CALL vkTrackedReallocation(void* pUserData, void* pOriginal, size_t size, size_t alignment, VkSystemAllocationScope allocationScope)
+{
+	return shen_realloc_aligned_internal(vkScopeToMemoryCategory(allocationScope), pOriginal, alignment, size, __FILE__, __LINE__, __FUNCTION__);
+}
+
+static VKAPI_ATTR void VKAPI_CALL vkTrackedFree(void* pUserData, void* pMemory)
+{
+	shen_free(pMemory);
+}
+
+static VKAPI_ATTR void VKAPI_CALL vkTrackedInternalAllocation(void* pUserData, size_t size, VkInternalAllocationType allocationType, VkSystemAllocationScope allocationScope)
+{
+	memoryTrackExternalAllocation(MEMORY_CATEGORY_VULKAN_INTERNAL, size);
+}
+
+static VKAPI_ATTR void VKAPI_CALL vkTrackedInternalFree(void* pUserData, size_t size, VkInternalAllocationType allocationType, VkSystemAllocationScope allocationScope)
+{
+	memoryTrackExternalFree(MEMORY_CATEGORY_VULKAN_INTERNAL, size);
+}
+
+static VkAllocationCallbacks gVkAllocationCallbacks = {
+	NULL,
+	vkTrackedAllocation,
+	vkTrackedReallocation,
+	vkTrackedFree,
+	vkTrackedInternalAllocation,
+	vkTrackedInternalFree
+};
+
+// 每种资源池的默认容量
+const uint32_t DEFAULT_MAX_RESOURCES_PER_TYPE = 4096;
+// 图形管线的推送常量对顶点与片元着色器都可见 (计算管线只对计算阶段可见), 管线布局与 cmdPushConstants 必须使用相同的阶段
+const VkShaderStageFlags PUSH_CONSTANT_STAGES = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+/// <summary>
+/// 渲染资源注册表, 每种资源一个连续的资源池
+/// </summary>
+typedef struct ResourceRegistry
+{
+	ResourcePool<Queue>			mQueues;
+	ResourcePool<RenderPass>	mRenderPasses;
+	ResourcePool<Shader>		mShaders;
+	ResourcePool<Pipeline>		mPipelines;
+	ResourcePool<FrameBuffer>	mFrameBuffers;
+	ResourcePool<CmdPool>		mCmdPools;
+	ResourcePool<Cmd>			mCmds;
+	ResourcePool<Semaphore>		mSemaphores;
+	ResourcePool<Fence>			mFences;
+	ResourcePool<Texture>		mTextures;
+	ResourcePool<Buffer>		mBuffers;
+	ResourcePool<QueryPool>		mQueryPools;
+	ResourcePool<DescriptorSet>	mDescriptorSets;
+} ResourceRegistry;
+
+static void initResourceRegistry(Renderer* pRenderer, const RendererDesc* pSettings)
+{
+	uint32_t capacity = (pSettings && pSettings->mMaxResourcesPerType) ? pSettings->mMaxResourcesPerType : DEFAULT_MAX_RESOURCES_PER_TYPE;
+	ResourceRegistry* pResources = shen_new(MEMORY_CATEGORY_RENDERER, ResourceRegistry);
+	pResources->mQueues.Init("Queue", capacity);
+	pResources->mRenderPasses.Init("RenderPass", capacity);
+	pResources->mShaders.Init("Shader", capacity);
+	pResources->mPipelines.Init("Pipeline", capacity);
+	pResources->mFrameBuffers.Init("FrameBuffer", capacity);
+	pResources->mCmdPools.Init("CmdPool", capacity);
+	pResources->mCmds.Init("Cmd", capacity);
+	pResources->mSemaphores.Init("Semaphore", capacity);
+	pResources->mFences.Init("Fence", capacity);
+	pResources->mTextures.Init("Texture", capacity);
+	pResources->mBuffers.Init("Buffer", capacity);
+	pResources->mQueryPools.Init("QueryPool", capacity);
+	pResources->mDescriptorSets.Init("DescriptorSet", capacity);
+	pRenderer->pResources = pResources;
+}
+
+#define DEFINE_RENDERER_RESOURCE_HANDLE_API(Type, pool)							\
+	Type##Handle get##Type##Handle(Renderer* pRenderer, const Type* p##Type)	\
+	{																			\
+		return pRenderer->pResources->pool.GetHandle(p##Type);					\
+	}																			\
+	Type* get##Type(Renderer* pRenderer, Type##Handle handle)					\
+	{																			\
+		return pRenderer->pResources->pool.Get(handle);							\
+	}																			\
+	bool is##Type##HandleValid(Renderer* pRenderer, Type##Handle handle)		\
+	{																			\
+		return pRenderer->pResources->pool.IsValid(handle);						\
+	}
+
+DEFINE_RENDERER_RESOURCE_HANDLE_API(Queue, mQueues)
+DEFINE_RENDERER_RESOURCE_HANDLE_API(RenderPass, mRenderPasses)
+DEFINE_RENDERER_RESOURCE_HANDLE_API(Shader, mShaders)
+DEFINE_RENDERER_RESOURCE_HANDLE_API(Pipeline, mPipelines)
+DEFINE_RENDERER_RESOURCE_HANDLE_API(FrameBuffer, mFrameBuffers)
+DEFINE_RENDERER_RESOURCE_HANDLE_API(CmdPool, mCmdPools)
+DEFINE_RENDERER_RESOURCE_HANDLE_API(Cmd, mCmds)
+DEFINE_RENDERER_RESOURCE_HANDLE_API(Semaphore, mSemaphores)
+DEFINE_RENDERER_RESOURCE_HANDLE_API(Fence, mFences)
+DEFINE_RENDERER_RESOURCE_HANDLE_API(Texture, mTextures)
+DEFINE_RENDERER_RESOURCE_HANDLE_API(Buffer, mBuffers)
+DEFINE_RENDERER_RESOURCE_HANDLE_API(QueryPool, mQueryPools)
+DEFINE_RENDERER_RESOURCE_HANDLE_API(DescriptorSet, mDescriptorSets)
+
+/// <summary>
+/// 加载设备级函数表
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="headless">无窗口模式, 不加载交换链函数</param>
+static void loadDeviceDispatchTable(Renderer* pRenderer, bool headless)
+{
+	DeviceDispatchTable* pTable = &pRenderer->mVkDeviceTable;
+#define VK_LOAD_DEVICE_FUNCTION(name)																\
+	pTable->name = (PFN_##name)vkGetDeviceProcAddr(pRenderer->pVkDevice, #name);					\
+	if (!pTable->name)																				\
+	{																								\
+		SHEN_CORE_ERROR("failed to load device function {0}!", #name);								\
+		throw std::runtime_error("failed to load device function!");								\
+	}
+	VK_DEVICE_FUNCTION_LIST(VK_LOAD_DEVICE_FUNCTION)
+	if (!headless)
+	{
+		VK_DEVICE_SWAPCHAIN_FUNCTION_LIST(VK_LOAD_DEVICE_FUNCTION)
+	}
+#undef VK_LOAD_DEVICE_FUNCTION
+
+	// 可选函数缺失时保持为空, 调用方需先检查对应的 GPUCapabilities
+#define VK_LOAD_OPTIONAL_DEVICE_FUNCTION(name, alias)												\
+	pTable->name = (PFN_##name)vkGetDeviceProcAddr(pRenderer->pVkDevice, #name);					\
+	if (!pTable->name)																				\
+		pTable->name = (PFN_##name)vkGetDeviceProcAddr(pRenderer->pVkDevice, #alias);
+	VK_DEVICE_OPTIONAL_FUNCTION_LIST(VK_LOAD_OPTIONAL_DEVICE_FUNCTION)
+#undef VK_LOAD_OPTIONAL_DEVICE_FUNCTION
+
+	if (pRenderer->mCapabilities.mDynamicRendering && !(pTable->vkCmdBeginRendering && pTable->vkCmdEndRendering))
+	{
+		SHEN_CORE_WARN("dynamic rendering is reported but its entry points are missing, falling back to render passes");
+		pRenderer->mCapabilities.mDynamicRendering = 0;
+	}
+	if (pRenderer->mCapabilities.mHostQueryReset && !pTable->vkResetQueryPool)
+	{
+		SHEN_CORE_WARN("host query reset is reported but vkResetQueryPool is missing, queries will be reset on the gpu");
+		pRenderer->mCapabilities.mHostQueryReset = 0;
+	}
+}
+
+/// <summary>
+/// 渲染通道签名: 附件格式, 加载/存储操作与初始布局
+/// 管线兼容性只取决于格式, 因此兼容渲染通道使用默认操作的签名
+/// </summary>
+typedef struct RenderPassSignature
+{
+	uint32_t		mColorCount;
+	VkFormat		mColorFormats[MAX_RENDER_TARGET_ATTACHMENTS];
+	VkImageLayout	mInitialLayouts[MAX_RENDER_TARGET_ATTACHMENTS];
+	uint32_t		mLoadOps[MAX_RENDER_TARGET_ATTACHMENTS];
+	uint32_t		mStoreOps[MAX_RENDER_TARGET_ATTACHMENTS];
+} RenderPassSignature;
+
+typedef struct FrameBufferSignature
+{
+	VkRenderPass	pRenderPass;
+	VkImageView		pAttachments[MAX_RENDER_TARGET_ATTACHMENTS];
+	uint32_t		mAttachmentCount;
+	uint32_t		mWidth;
+	uint32_t		mHeight;
+	// 显式填充, 保证结构体没有未初始化的填充字节
+	uint32_t		mPadding;
+} FrameBufferSignature;
+
+// 签名在构造时整体清零, 可以按字节比较和哈希
+template<typename T>
+struct SignatureHasher
+{
+	size_t operator()(const T& signature) const
+	{
+		const uint8_t* pBytes = (const uint8_t*)&signature;
+		uint64_t hash = 14695981039346656037ull;
+		for (size_t i = 0; i < sizeof(T); ++i)
+			hash = (hash ^ pBytes[i]) * 1099511628211ull;
+		return (size_t)hash;
+	}
+};
+
+template<typename T>
+struct SignatureEqual
+{
+	bool operator()(const T& a, const T& b) const { return memcmp(&a, &b, sizeof(T)) == 0; }
+};
+
+typedef struct RenderPassCache
+{
+	std::mutex mMutex;
+	std::unordered_map<RenderPassSignature, VkRenderPass, SignatureHasher<RenderPassSignature>, SignatureEqual<RenderPassSignature>> mRenderPasses;
+	std::unordered_map<FrameBufferSignature, VkFramebuffer, SignatureHasher<FrameBufferSignature>, SignatureEqual<FrameBufferSignature>> mFrameBuffers;
+} RenderPassCache;
+
+static VkRenderPass createRenderPass(Renderer* pRenderer, const RenderPassSignature* pSignature)
+{
+	VkAttachmentDescription colorAttachments[MAX_RENDER_TARGET_ATTACHMENTS] = {};
+	VkAttachmentReference colorAttachmentRefs[MAX_RENDER_TARGET_ATTACHMENTS] = {};
+	for (uint32_t i = 0; i < pSignature->mColorCount; ++i)
+	{
+		colorAttachments[i].format = pSignature->mColorFormats[i];
+		colorAttachments[i].samples = VK_SAMPLE_COUNT_1_BIT;
+		colorAttachments[i].loadOp = (VkAttachmentLoadOp)pSignature->mLoadOps[i];
+		colorAttachments[i].storeOp = (VkAttachmentStoreOp)pSignature->mStoreOps[i];
+		colorAttachments[i].stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+		colorAttachments[i].stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+		colorAttachments[i].initialLayout = pSignature->mInitialLayouts[i];
+		colorAttachments[i].finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+		colorAttachmentRefs[i].attachment = i;
+		colorAttachmentRefs[i].layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	}
+
+	VkSubpassDescription subpass{};
+	subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	subpass.colorAttachmentCount = pSignature->mColorCount;
+	subpass.pColorAttachments = colorAttachmentRefs;
+
+	VkSubpassDependency dependency{};
+	dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
+	dependency.dstSubpass = 0;
+	dependency.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependency.srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+	dependency.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	dependency.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+	VkRenderPassCreateInfo renderPassInfo{};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	renderPassInfo.attachmentCount = pSignature->mColorCount;
+	renderPassInfo.pAttachments = colorAttachments;
+	renderPassInfo.subpassCount = 1;
+	renderPassInfo.pSubpasses = &subpass;
+	renderPassInfo.dependencyCount = 1;
+	renderPassInfo.pDependencies = &dependency;
+
+	VkRenderPass renderPass = VK_NULL_HANDLE;
+	if (pRenderer->mVkDeviceTable.vkCreateRenderPass(pRenderer->pVkDevice, &renderPassInfo, pRenderer->pVkAllocator, &renderPass) != VK_SUCCESS) {
+		SHEN_CORE_ERROR("failed to create render pass!");
+		throw std::runtime_error("failed to create render pass!");
+	}
+	return renderPass;
+}
+
+static VkRenderPass findOrCreateRenderPass(Renderer* pRenderer, const RenderPassSignature* pSignature)
+{
+	RenderPassCache* pCache = pRenderer->pRenderPassCache;
+	std::lock_guard<std::mutex> lock(pCache->mMutex);
+	auto it = pCache->mRenderPasses.find(*pSignature);
+	if (it != pCache->mRenderPasses.end())
+		return it->second;
+
+	VkRenderPass renderPass = createRenderPass(pRenderer, pSignature);
+	pCache->mRenderPasses.emplace(*pSignature, renderPass);
+	return renderPass;
+}
+
+static VkFramebuffer findOrCreateFrameBuffer(Renderer* pRenderer, const FrameBufferSignature* pSignature)
+{
+	RenderPassCache* pCache = pRenderer->pRenderPassCache;
+	std::lock_guard<std::mutex> lock(pCache->mMutex);
+	auto it = pCache->mFrameBuffers.find(*pSignature);
+	if (it != pCache->mFrameBuffers.end())
+		return it->second;
+
+	VkFramebufferCreateInfo framebufferInfo{};
+	framebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	framebufferInfo.renderPass = pSignature->pRenderPass;
+	framebufferInfo.attachmentCount = pSignature->mAttachmentCount;
+	framebufferInfo.pAttachments = pSignature->pAttachments;
+	framebufferInfo.width = pSignature->mWidth;
+	framebufferInfo.height = pSignature->mHeight;
+	framebufferInfo.layers = 1;
+
+	VkFramebuffer framebuffer = VK_NULL_HANDLE;
+	if (pRenderer->mVkDeviceTable.vkCreateFramebuffer(pRenderer->pVkDevice, &framebufferInfo, pRenderer->pVkAllocator, &framebuffer) != VK_SUCCESS) {
+		SHEN_CORE_ERROR("failed to create framebuffer!");
+		throw std::runtime_error("failed to create framebuffer!");
+	}
+	pCache->mFrameBuffers.emplace(*pSignature, framebuffer);
+	return framebuffer;
+}
+
+/// <summary>
+/// 获取与附件格式兼容的渲染通道
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="colorFormatCount"></param>
+/// <param name="pColorFormats"></param>
+/// <returns></returns>
+VkRenderPass getCompatibleRenderPass(Renderer* pRenderer, uint32_t colorFormatCount, const VkFormat* pColorFormats)
+{
+	RenderPassSignature signature;
+	memset(&signature, 0, sizeof(signature));
+	signature.mColorCount = colorFormatCount;
+	for (uint32_t i = 0; i < colorFormatCount; ++i)
+	{
+		signature.mColorFormats[i] = pColorFormats[i];
+		signature.mInitialLayouts[i] = VK_IMAGE_LAYOUT_UNDEFINED;
+		signature.mLoadOps[i] = (uint32_t)VK_ATTACHMENT_LOAD_OP_CLEAR;
+		signature.mStoreOps[i] = (uint32_t)VK_ATTACHMENT_STORE_OP_STORE;
+	}
+	return findOrCreateRenderPass(pRenderer, &signature);
+}
+
+/// <summary>
+/// 清空帧缓存缓存
+/// </summary>
+/// <param name="pRenderer"></param>
+void resetFrameBufferCache(Renderer* pRenderer)
+{
+	RenderPassCache* pCache = pRenderer->pRenderPassCache;
+	std::lock_guard<std::mutex> lock(pCache->mMutex);
+	for (auto& entry : pCache->mFrameBuffers)
+		pRenderer->mVkDeviceTable.vkDestroyFramebuffer(pRenderer->pVkDevice, entry.second, pRenderer->pVkAllocator);
+	pCache->mFrameBuffers.clear();
+}
+
 VkResult CreateDebugUtilsMessengerEXT(VkInstance instance, const VkDebugUtilsMessengerCreateInfoEXT* pCreateInfo, const VkAllocationCallbacks* pAllocator, VkDebugUtilsMessengerEXT* pDebugMessenger) {
 	auto func = (PFN_vkCreateDebugUtilsMessengerEXT)vkGetInstanceProcAddr(instance, "vkCreateDebugUtilsMessengerEXT");
 	if (func != nullptr) {
@@ -28,7 +370,7 @@ VkResult CreateDebugUtilsMessengerEXT(VkInstance instance, const VkDebugUtilsMes
 }
 
 /// <summary>
-/// ֤֧
+/// 检查验证层支持
 /// </summary>
 /// <returns></returns>
 bool checkValidationLayerSupport() {
@@ -57,15 +399,18 @@ bool checkValidationLayerSupport() {
 }
 
 /// <summary>
-/// ȡչϢ
+/// 获取扩展信息
 /// </summary>
 /// <returns></returns>
-std::vector<const char*> getRequiredExtensions() {
-	uint32_t glfwExtensionCount = 0;
-	const char** glfwExtensions;
-	glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
-
-	std::vector<const char*> extensions(glfwExtensions, glfwExtensions + glfwExtensionCount);
+std::vector<const char*> getRequiredExtensions(bool headless) {
+	std::vector<const char*> extensions;
+	// 无窗口时不需要表面扩展, 也就不依赖 glfw 的初始化
+	if (!headless) {
+		uint32_t glfwExtensionCount = 0;
+		const char** glfwExtensions;
+		glfwExtensions = glfwGetRequiredInstanceExtensions(&glfwExtensionCount);
+		extensions.assign(glfwExtensions, glfwExtensions + glfwExtensionCount);
+	}
 
 	if (enableValidationLayers) {
 		extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
@@ -74,8 +419,30 @@ std::vector<const char*> getRequiredExtensions() {
 	return extensions;
 }
 
+// 同一条验证层消息最多输出的次数, 超出后只计数不输出
+const uint32_t VALIDATION_MESSAGE_REPEAT_LIMIT = 3;
+
+// 最多跟踪的验证层消息 ID 数, 超出后新出现的 ID 不再计数, 每次都输出
+const size_t VALIDATION_MESSAGE_ID_LIMIT = 1024;
+
+// 验证层消息 (按 messageIdNumber) 的出现次数, 回调可能在任意线程触发
+static std::mutex validationMessageMutex;
+static std::unordered_map<int32_t, uint32_t> validationMessageCounts;
+
+static spdlog::level::level_enum getValidationLogLevel(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity)
+{
+	if (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)
+		return spdlog::level::err;
+	if (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT)
+		return spdlog::level::warn;
+	if (messageSeverity & VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT)
+		return spdlog::level::info;
+	return spdlog::level::trace;
+}
+
 /// <summary>
-/// ֤Ϣص
+/// 验证层消息回调, 经由异步日志输出, 不在调用线程上写控制台
+/// 低于日志级别的消息直接丢弃; 重复的消息只输出前 VALIDATION_MESSAGE_REPEAT_LIMIT 次
 /// </summary>
 /// <param name="messageSeverity"></param>
 /// <param name="messageType"></param>
@@ -83,18 +450,44 @@ std::vector<const char*> getRequiredExtensions() {
 /// <param name="pUserData"></param>
 /// <returns></returns>
 static VKAPI_ATTR VkBool32 VKAPI_CALL debugCallback(VkDebugUtilsMessageSeverityFlagBitsEXT messageSeverity, VkDebugUtilsMessageTypeFlagsEXT messageType, const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData, void* pUserData) {
-	std::cerr << "validation layer: " << pCallbackData->pMessage << std::endl;
+	spdlog::level::level_enum level = getValidationLogLevel(messageSeverity);
+	if (!Log::GetCoreLogger()->should_log(level))
+		return VK_FALSE;
+
+	// 消息文本含有句柄与地址, 同一问题每次都不同, 因此按 ID 计数; ID 为 0 的消息 (如加载器消息) 无法区分, 不计数
+	uint32_t count = 1;
+	if (pCallbackData->messageIdNumber != 0)
+	{
+		std::lock_guard<std::mutex> lock(validationMessageMutex);
+		auto it = validationMessageCounts.find(pCallbackData->messageIdNumber);
+		if (it != validationMessageCounts.end())
+			count = ++it->second;
+		else if (validationMessageCounts.size() < VALIDATION_MESSAGE_ID_LIMIT)
+			validationMessageCounts.emplace(pCallbackData->messageIdNumber, 1u);
+	}
+	if (count > VALIDATION_MESSAGE_REPEAT_LIMIT)
+		return VK_FALSE;
+
+	Log::GetCoreLogger()->log(level, "validation layer: {0}", pCallbackData->pMessage);
+	if (count == VALIDATION_MESSAGE_REPEAT_LIMIT)
+	{
+		Log::GetCoreLogger()->log(level, "validation layer: {0} repeated {1} times, further repeats are suppressed",
+			pCallbackData->pMessageIdName ? pCallbackData->pMessageIdName : "message", count);
+	}
 	return VK_FALSE;
 }
 
 /// <summary>
-/// Debug Ϣص
+/// Debug 消息回调
 /// </summary>
 /// <param name="createInfo"></param>
 void populateDebugMessengerCreateInfo(VkDebugUtilsMessengerCreateInfoEXT& createInfo) {
 	createInfo = {};
 	createInfo.sType = VK_STRUCTURE_TYPE_DEBUG_UTILS_MESSENGER_CREATE_INFO_EXT;
-	createInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+	// 只订阅日志会输出的级别, 被过滤的级别验证层不会生成消息
+	createInfo.messageSeverity = VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT;
+	if (Log::GetCoreLogger()->should_log(spdlog::level::trace))
+		createInfo.messageSeverity |= VK_DEBUG_UTILS_MESSAGE_SEVERITY_VERBOSE_BIT_EXT;
 	createInfo.messageType = VK_DEBUG_UTILS_MESSAGE_TYPE_GENERAL_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_VALIDATION_BIT_EXT | VK_DEBUG_UTILS_MESSAGE_TYPE_PERFORMANCE_BIT_EXT;
 	createInfo.pfnUserCallback = debugCallback;
 }
@@ -112,7 +505,7 @@ struct QueueFamilyIndices {
 };
 
 /// <summary>
-/// ֵ֧ϸϢ
+/// 交换链支持的细节信息
 /// </summary>
 struct SwapChainSupportDetails {
 	VkSurfaceCapabilitiesKHR capabilities;
@@ -143,8 +536,12 @@ QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surfa
 			indices.transferFamily = i;
 		}
 
+		// 无窗口时没有演示队列, 沿用图形队列
 		VkBool32 presentSupport = false;
-		vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
+		if (surface == VK_NULL_HANDLE)
+			presentSupport = indices.graphicsFamily.has_value() && indices.graphicsFamily.value() == (uint32_t)i;
+		else
+			vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface, &presentSupport);
 
 		if (presentSupport) {
 			indices.presentFamily = i;
@@ -160,7 +557,10 @@ QueueFamilyIndices findQueueFamilies(VkPhysicalDevice device, VkSurfaceKHR surfa
 	return indices;
 }
 
-bool checkDeviceExtensionSupport(VkPhysicalDevice device) {
+bool checkDeviceExtensionSupport(VkPhysicalDevice device, bool headless) {
+	if (headless)
+		return true;
+
 	uint32_t extensionCount;
 	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
 
@@ -177,10 +577,10 @@ bool checkDeviceExtensionSupport(VkPhysicalDevice device) {
 }
 
 /// <summary>
-/// ѯֵ֧ϸϢ
+/// 查询交换链支持的细节信息
 /// </summary>
-/// <param name="device">豸</param>
-/// <param name="surface">ʾ</param>
+/// <param name="device">物理设备</param>
+/// <param name="surface">显示表面</param>
 /// <returns></returns>
 SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device, VkSurfaceKHR surface) {
 	SwapChainSupportDetails details;
@@ -206,23 +606,286 @@ SwapChainSupportDetails querySwapChainSupport(VkPhysicalDevice device, VkSurface
 	return details;
 }
 
-bool isDeviceSuitable(Renderer pRenderer, VkPhysicalDevice device, VkSurfaceKHR surface) {
+bool isDeviceSuitable(VkPhysicalDevice device, VkSurfaceKHR surface) {
 	QueueFamilyIndices indices = findQueueFamilies(device, surface);
 
-	bool extensionsSupported = checkDeviceExtensionSupport(device);
+	bool headless = surface == VK_NULL_HANDLE;
+	bool extensionsSupported = checkDeviceExtensionSupport(device, headless);
 
-	bool swapChainAdequate = false;
-	if (extensionsSupported) {
+	bool swapChainAdequate = headless;
+	if (extensionsSupported && !headless) {
 		SwapChainSupportDetails swapChainSupport = querySwapChainSupport(device, surface);
 		swapChainAdequate = !swapChainSupport.formats.empty() && !swapChainSupport.presentModes.empty();
 	}
 
-	VkPhysicalDeviceFeatures supportedFeatures;
-	vkGetPhysicalDeviceFeatures(device, &supportedFeatures);
-	pRenderer.pVkGraphicsQueueFamilyIndex = indices.graphicsFamily.value();
-	pRenderer.pVkComputeQueueFamilyIndex = indices.computeFamily.value();
-	pRenderer.pVkTransferQueueFamilyIndex = indices.transferFamily.value();
-	return indices.isComplete() && extensionsSupported && swapChainAdequate && supportedFeatures.samplerAnisotropy;
+	return indices.isComplete() && extensionsSupported && swapChainAdequate;
+}
+
+static bool hasDeviceExtension(const std::vector<VkExtensionProperties>& extensions, const char* pName)
+{
+	for (const auto& extension : extensions)
+	{
+		if (strcmp(extension.extensionName, pName) == 0)
+			return true;
+	}
+	return false;
+}
+
+/// <summary>
+/// 探测显卡能力
+/// 1.2 特性在设备版本 >= 1.2 时经由 VkPhysicalDeviceVulkan12Features 查询;
+/// 动态渲染与 synchronization2 在 1.3 之前可以通过 KHR 扩展获得
+/// </summary>
+/// <param name="instanceApiVersion">实例创建时使用的 API 版本</param>
+/// <param name="device"></param>
+/// <param name="pCaps"></param>
+static void queryGpuCapabilities(uint32_t instanceApiVersion, VkPhysicalDevice device, GPUCapabilities* pCaps)
+{
+	memset(pCaps, 0, sizeof(GPUCapabilities));
+
+	VkPhysicalDeviceProperties properties;
+	vkGetPhysicalDeviceProperties(device, &properties);
+	strncpy(pCaps->mDeviceName, properties.deviceName, VK_MAX_PHYSICAL_DEVICE_NAME_SIZE - 1);
+	pCaps->mDeviceType = properties.deviceType;
+	pCaps->mVendorId = properties.vendorID;
+	pCaps->mDeviceId = properties.deviceID;
+	pCaps->mApiVersion = (std::min)(instanceApiVersion, properties.apiVersion);
+	pCaps->mTimestampPeriod = properties.limits.timestampPeriod;
+	pCaps->mTimestampComputeAndGraphics = properties.limits.timestampComputeAndGraphics;
+
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(device, &memoryProperties);
+	for (uint32_t i = 0; i < memoryProperties.memoryHeapCount; ++i)
+	{
+		if (memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+			pCaps->mDeviceLocalMemorySize += memoryProperties.memoryHeaps[i].size;
+	}
+
+	VkPhysicalDeviceFeatures features;
+	vkGetPhysicalDeviceFeatures(device, &features);
+	pCaps->mSamplerAnisotropy = features.samplerAnisotropy;
+	pCaps->mMultiDrawIndirect = features.multiDrawIndirect;
+	pCaps->mDrawIndirectFirstInstance = features.drawIndirectFirstInstance;
+	pCaps->mPipelineStatisticsQuery = features.pipelineStatisticsQuery;
+	pCaps->mTextureCompressionBC = features.textureCompressionBC;
+
+	// vkGetPhysicalDeviceFeatures2 需要 1.1 实例
+	if (pCaps->mApiVersion < VK_API_VERSION_1_1)
+		return;
+
+	uint32_t extensionCount = 0;
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+	std::vector<VkExtensionProperties> extensions(extensionCount);
+	vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, extensions.data());
+
+	VkPhysicalDeviceFeatures2 features2{};
+	features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+	VkPhysicalDeviceVulkan12Features features12{};
+	features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+	VkPhysicalDeviceVulkan13Features features13{};
+	features13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+	VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures{};
+	dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+	VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features{};
+	synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+
+	void** ppNext = &features2.pNext;
+	if (pCaps->mApiVersion >= VK_API_VERSION_1_2)
+	{
+		*ppNext = &features12;
+		ppNext = &features12.pNext;
+	}
+	if (pCaps->mApiVersion >= VK_API_VERSION_1_3)
+	{
+		*ppNext = &features13;
+		ppNext = &features13.pNext;
+	}
+	else
+	{
+		if (hasDeviceExtension(extensions, VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME))
+		{
+			*ppNext = &dynamicRenderingFeatures;
+			ppNext = &dynamicRenderingFeatures.pNext;
+		}
+		if (hasDeviceExtension(extensions, VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME))
+		{
+			*ppNext = &synchronization2Features;
+			ppNext = &synchronization2Features.pNext;
+		}
+	}
+	vkGetPhysicalDeviceFeatures2(device, &features2);
+
+	pCaps->mTimelineSemaphore = features12.timelineSemaphore;
+	pCaps->mBufferDeviceAddress = features12.bufferDeviceAddress;
+	pCaps->mHostQueryReset = features12.hostQueryReset;
+	pCaps->mDrawIndirectCount = features12.drawIndirectCount;
+	pCaps->mDescriptorIndexing = features12.descriptorIndexing && features12.runtimeDescriptorArray &&
+		features12.descriptorBindingPartiallyBound && features12.descriptorBindingVariableDescriptorCount &&
+		features12.shaderSampledImageArrayNonUniformIndexing;
+	pCaps->mSynchronization2 = features13.synchronization2 || synchronization2Features.synchronization2;
+	pCaps->mDynamicRendering = features13.dynamicRendering || dynamicRenderingFeatures.dynamicRendering;
+	// VK_KHR_dynamic_rendering 依赖 VK_KHR_depth_stencil_resolve, 后者又依赖 VK_KHR_create_renderpass2, 二者在 1.2 中并入核心
+	if (pCaps->mApiVersion < VK_API_VERSION_1_2 && pCaps->mDynamicRendering &&
+		!(hasDeviceExtension(extensions, VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME) &&
+			hasDeviceExtension(extensions, VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME)))
+		pCaps->mDynamicRendering = 0;
+	// 经由 vkGetPhysicalDeviceMemoryProperties2 查询, 同样需要 1.1 实例
+	pCaps->mMemoryBudget = hasDeviceExtension(extensions, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+}
+
+static const char* getGpuTypeName(VkPhysicalDeviceType type)
+{
+	switch (type)
+	{
+	case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: return "integrated";
+	case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: return "discrete";
+	case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: return "virtual";
+	case VK_PHYSICAL_DEVICE_TYPE_CPU: return "cpu";
+	default: return "other";
+	}
+}
+
+/// <summary>
+/// 显卡评分: 设备类型权重最高, 其次是显存大小和高级特性
+/// 软件光栅化设备得分最低, 只有在没有其他设备时才会被自动选中
+/// </summary>
+/// <param name="pCaps"></param>
+/// <returns></returns>
+static uint64_t scoreGpu(const GPUCapabilities* pCaps)
+{
+	uint64_t score = 0;
+	switch (pCaps->mDeviceType)
+	{
+	case VK_PHYSICAL_DEVICE_TYPE_DISCRETE_GPU: score += 100000; break;
+	case VK_PHYSICAL_DEVICE_TYPE_INTEGRATED_GPU: score += 50000; break;
+	case VK_PHYSICAL_DEVICE_TYPE_VIRTUAL_GPU: score += 20000; break;
+	case VK_PHYSICAL_DEVICE_TYPE_CPU: score += 1; break;
+	default: break;
+	}
+
+	// 每 16MB 显存 1 分, 8GB 显存约 512 分
+	score += pCaps->mDeviceLocalMemorySize / (16ull * 1024 * 1024);
+
+	const uint32_t featureScore = 2000;
+	score += pCaps->mDynamicRendering * featureScore;
+	score += pCaps->mSynchronization2 * featureScore;
+	score += pCaps->mTimelineSemaphore * featureScore;
+	score += pCaps->mDescriptorIndexing * featureScore;
+	score += pCaps->mBufferDeviceAddress * featureScore;
+	score += pCaps->mSamplerAnisotropy * (featureScore / 4);
+	score += pCaps->mMultiDrawIndirect * (featureScore / 4);
+	return score;
+}
+
+static bool containsIgnoreCase(const char* pHaystack, const char* pNeedle)
+{
+	size_t needleLength = strlen(pNeedle);
+	for (; *pHaystack; ++pHaystack)
+	{
+		size_t i = 0;
+		while (i < needleLength && pHaystack[i] && tolower((unsigned char)pHaystack[i]) == tolower((unsigned char)pNeedle[i]))
+			++i;
+		if (i == needleLength)
+			return true;
+	}
+	return needleLength == 0;
+}
+
+/// <summary>
+/// 选取物理设备
+/// 优先级: 环境变量 SHEN_GPU > RendererDesc 中的指定 > 评分最高的设备
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pSettings"></param>
+/// <param name="instanceApiVersion"></param>
+/// <param name="surface"></param>
+static void selectPhysicalDevice(Renderer* pRenderer, const RendererDesc* pSettings, uint32_t instanceApiVersion, VkSurfaceKHR surface)
+{
+	//获取设备的数量
+	uint32_t deviceCount = 0;
+	vkEnumeratePhysicalDevices(pRenderer->pVkInstance, &deviceCount, nullptr);
+
+	if (deviceCount == 0) {
+		SHEN_CORE_ERROR("failed to find GPUs with Vulkan support!");
+		throw std::runtime_error("failed to find GPUs with Vulkan support!");
+	}
+
+	//枚举所有的设备
+	std::vector<VkPhysicalDevice> devices(deviceCount);
+	vkEnumeratePhysicalDevices(pRenderer->pVkInstance, &deviceCount, devices.data());
+
+	const char* pGpuName = pSettings ? pSettings->pGpuName : NULL;
+	bool useGpuIndex = pSettings ? pSettings->mUseGpuIndex : false;
+	uint32_t gpuIndex = pSettings ? pSettings->mGpuIndex : 0;
+	bool forceSoftware = pSettings ? pSettings->mForceSoftwareRasterizer : false;
+
+	const char* pOverride = getenv("SHEN_GPU");
+	if (pOverride && *pOverride)
+	{
+		pGpuName = NULL;
+		useGpuIndex = false;
+		forceSoftware = false;
+		if (containsIgnoreCase(pOverride, "software") && strlen(pOverride) == strlen("software"))
+			forceSoftware = true;
+		else if (pOverride[0] == '#')
+		{
+			useGpuIndex = true;
+			gpuIndex = (uint32_t)strtoul(pOverride + 1, NULL, 10);
+		}
+		else
+			pGpuName = pOverride;
+		SHEN_CORE_INFO("GPU selection overridden by SHEN_GPU={0}", pOverride);
+	}
+
+	int32_t selected = -1;
+	uint64_t bestScore = 0;
+	GPUCapabilities selectedCaps = {};
+	for (uint32_t i = 0; i < deviceCount; ++i)
+	{
+		GPUCapabilities caps;
+		queryGpuCapabilities(instanceApiVersion, devices[i], &caps);
+		bool suitable = isDeviceSuitable(devices[i], surface);
+		uint64_t score = scoreGpu(&caps);
+		SHEN_CORE_INFO("GPU {0}: {1} ({2}, {3} MB, Vulkan {4}.{5}) {6} score {7}", i, caps.mDeviceName, getGpuTypeName(caps.mDeviceType),
+			caps.mDeviceLocalMemorySize / (1024 * 1024), VK_VERSION_MAJOR(caps.mApiVersion), VK_VERSION_MINOR(caps.mApiVersion),
+			suitable ? "suitable" : "not suitable", score);
+		if (!suitable)
+			continue;
+
+		bool matches;
+		if (useGpuIndex)
+			matches = i == gpuIndex;
+		else if (pGpuName)
+			matches = containsIgnoreCase(caps.mDeviceName, pGpuName);
+		else if (forceSoftware)
+			matches = caps.mDeviceType == VK_PHYSICAL_DEVICE_TYPE_CPU;
+		else
+			matches = true;
+
+		if (matches && (selected < 0 || score > bestScore))
+		{
+			selected = (int32_t)i;
+			bestScore = score;
+			selectedCaps = caps;
+		}
+	}
+
+	if (selected < 0)
+	{
+		if (useGpuIndex)
+			SHEN_CORE_ERROR("requested GPU index {0} is not available or not suitable!", gpuIndex);
+		else if (pGpuName)
+			SHEN_CORE_ERROR("no suitable GPU matches the name \"{0}\"!", pGpuName);
+		else if (forceSoftware)
+			SHEN_CORE_ERROR("no suitable software rasterizer found!");
+		else
+			SHEN_CORE_ERROR("failed to find a suitable GPU!");
+		throw std::runtime_error("failed to find a suitable GPU!");
+	}
+
+	pRenderer->pVkActiveGPU = devices[selected];
+	pRenderer->mCapabilities = selectedCaps;
+	SHEN_CORE_INFO("Selected GPU {0}: {1}", selected, selectedCaps.mDeviceName);
 }
 
 VkSurfaceFormatKHR chooseSwapSurfaceFormat(const std::vector<VkSurfaceFormatKHR>& availableFormats) {
@@ -266,21 +929,36 @@ VkExtent2D chooseSwapExtent(GLFWwindow* window, const VkSurfaceCapabilitiesKHR&
 }
 
 /// <summary>
-/// ʼȾϢ
+/// 初始化渲染配置信息
 /// </summary>
 /// <param name="appName"></param>
 /// <param name="pSettings"></param>
 /// <param name="ppRenderer"></param>
 void initRenderer(const char* appName, const RendererDesc* pSettings, Renderer** ppRenderer, SwapChainDesc* pDesc, SwapChain** ppSwapChain, std::vector<Texture>& pTextures)
 {
-	//ʼppRenderer
-	Renderer* pRenderer = (Renderer*)malloc(sizeof(Renderer));
+	SHEN_PROFILE_FUNCTION();
+	bool headless = pDesc == NULL || pDesc->mWindow == NULL;
+	//初始化ppRenderer
+	Renderer* pRenderer = (Renderer*)shen_calloc(MEMORY_CATEGORY_RENDERER, 1, sizeof(Renderer));
+	pRenderer->pVkAllocator = &gVkAllocationCallbacks;
+	initResourceRegistry(pRenderer, pSettings);
+
+	// 实例 API 版本: 取加载器支持的最高版本, 最高到 1.3
+	uint32_t instanceApiVersion = VK_API_VERSION_1_0;
+	{
+		PFN_vkEnumerateInstanceVersion pfnEnumerateInstanceVersion =
+			(PFN_vkEnumerateInstanceVersion)vkGetInstanceProcAddr(VK_NULL_HANDLE, "vkEnumerateInstanceVersion");
+		if (pfnEnumerateInstanceVersion)
+			pfnEnumerateInstanceVersion(&instanceApiVersion);
+		instanceApiVersion = (std::min)(instanceApiVersion, (uint32_t)VK_API_VERSION_1_3);
+	}
+
 	if (enableValidationLayers && !checkValidationLayerSupport())
 	{
 		SHEN_CORE_ERROR("validation layers requested, but not available!");
 		throw std::runtime_error("validation layers requested, but not available!");
 	}
-	//ӦϢ
+	//应用信息
 	{
 
 		VkApplicationInfo appInfo{};
@@ -289,15 +967,15 @@ void initRenderer(const char* appName, const RendererDesc* pSettings, Renderer**
 		appInfo.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
 		appInfo.pEngineName = "No Engine";
 		appInfo.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-		appInfo.apiVersion = VK_API_VERSION_1_0;
+		appInfo.apiVersion = instanceApiVersion;
 
-		//Ϣ
+		//创建信息
 		VkInstanceCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO;
 		createInfo.pApplicationInfo = &appInfo;
 
-		//ȡչϢ
-		auto extensions = getRequiredExtensions();
+		//获取扩展信息
+		auto extensions = getRequiredExtensions(headless);
 		createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
 		createInfo.ppEnabledExtensionNames = extensions.data();
 
@@ -315,70 +993,57 @@ void initRenderer(const char* appName, const RendererDesc* pSettings, Renderer**
 			createInfo.pNext = nullptr;
 		}
 
-		if (vkCreateInstance(&createInfo, nullptr, &pRenderer->pVkInstance) != VK_SUCCESS) {
+		if (vkCreateInstance(&createInfo, pRenderer->pVkAllocator, &pRenderer->pVkInstance) != VK_SUCCESS) {
 			SHEN_CORE_ERROR("failed to create instance!");
 			throw std::runtime_error("failed to create instance!");
 		}
 	}
 
-	//֤Ϣص
+	//验证层信息回调
 	if (enableValidationLayers)
 	{
 		VkDebugUtilsMessengerCreateInfoEXT createInfo;
 		populateDebugMessengerCreateInfo(createInfo);
 
-		if (CreateDebugUtilsMessengerEXT(pRenderer->pVkInstance, &createInfo, nullptr, &debugMessenger) != VK_SUCCESS) {
+		if (CreateDebugUtilsMessengerEXT(pRenderer->pVkInstance, &createInfo, pRenderer->pVkAllocator, &debugMessenger) != VK_SUCCESS) {
 			SHEN_CORE_ERROR("failed to set up debug messenger!");
 			throw std::runtime_error("failed to set up debug messenger!");
 		}
 	}
 
-	//surface
-	SwapChain* pSwapChain = (SwapChain*)malloc(sizeof(SwapChain));
+	//创建surface
+	SwapChain* pSwapChain = NULL;
+	VkSurfaceKHR surface = VK_NULL_HANDLE;
+	if (!headless)
 	{
-		if (glfwCreateWindowSurface(pRenderer->pVkInstance, (GLFWwindow*)pDesc->mWindow, nullptr, &pSwapChain->pVkSurface) != VK_SUCCESS) {
+		pSwapChain = (SwapChain*)shen_calloc(MEMORY_CATEGORY_RENDERER, 1, sizeof(SwapChain));
+		if (glfwCreateWindowSurface(pRenderer->pVkInstance, (GLFWwindow*)pDesc->mWindow, pRenderer->pVkAllocator, &pSwapChain->pVkSurface) != VK_SUCCESS) {
 			SHEN_CORE_ERROR("failed to create window surface!");
 			throw std::runtime_error("failed to create window surface!");
 		}
 	}
 
-	//ѡȡ豸
-	{
-		//ȡ豸
-		uint32_t deviceCount = 0;
-		vkEnumeratePhysicalDevices(pRenderer->pVkInstance, &deviceCount, nullptr);
-
-		if (deviceCount == 0) {
-			SHEN_CORE_ERROR("failed to find GPUs with Vulkan support!");
-			throw std::runtime_error("failed to find GPUs with Vulkan support!");
-		}
-
-		//öе豸
-		std::vector<VkPhysicalDevice> devices(deviceCount);
-		vkEnumeratePhysicalDevices(pRenderer->pVkInstance, &deviceCount, devices.data());
-
-		//ѡȡ֧ ͼ񣬼ʾܵԿ
-		for (const auto& device : devices)
-		{
-			if (isDeviceSuitable(*pRenderer, device, pSwapChain->pVkSurface)) {
-				pRenderer->pVkActiveGPU = device;
-				break;
-			}
-		}
-	}
+	//选取物理设备
+	if (pSwapChain)
+		surface = pSwapChain->pVkSurface;
+	selectPhysicalDevice(pRenderer, pSettings, instanceApiVersion, surface);
 
-	//߼豸
+	//创建逻辑设备
 	{
-		QueueFamilyIndices indices = findQueueFamilies(pRenderer->pVkActiveGPU, pSwapChain->pVkSurface);
+		QueueFamilyIndices indices = findQueueFamilies(pRenderer->pVkActiveGPU, surface);
 
 		std::vector<VkDeviceQueueCreateInfo> queueCreateInfos;
-		std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value() };
+		std::set<uint32_t> uniqueQueueFamilies = { indices.graphicsFamily.value(), indices.presentFamily.value(),
+			indices.computeFamily.value(), indices.transferFamily.value() };
 
-		//ͼ
+		//图像, 计算, 传输队列索引
 		pRenderer->pVkGraphicsQueueFamilyIndex = indices.graphicsFamily.value();
+		pRenderer->pVkComputeQueueFamilyIndex = indices.computeFamily.value();
+		pRenderer->pVkTransferQueueFamilyIndex = indices.transferFamily.value();
 
-		//ʾ
-		pSwapChain->mPresentQueueFamilyIndex = indices.presentFamily.value();
+		//演示队列索引
+		if (pSwapChain)
+			pSwapChain->mPresentQueueFamilyIndex = indices.presentFamily.value();
 
 		float queuePriority = 1.0f;
 		for (uint32_t queueFamily : uniqueQueueFamilies) {
@@ -390,8 +1055,81 @@ void initRenderer(const char* appName, const RendererDesc* pSettings, Renderer**
 			queueCreateInfos.push_back(queueCreateInfo);
 		}
 
+		// 只启用探测到的特性
+		const GPUCapabilities* pCaps = &pRenderer->mCapabilities;
 		VkPhysicalDeviceFeatures deviceFeatures{};
-		deviceFeatures.samplerAnisotropy = VK_TRUE;
+		deviceFeatures.samplerAnisotropy = pCaps->mSamplerAnisotropy;
+		deviceFeatures.multiDrawIndirect = pCaps->mMultiDrawIndirect;
+		deviceFeatures.drawIndirectFirstInstance = pCaps->mDrawIndirectFirstInstance;
+		deviceFeatures.pipelineStatisticsQuery = pCaps->mPipelineStatisticsQuery;
+		deviceFeatures.textureCompressionBC = pCaps->mTextureCompressionBC;
+
+		VkPhysicalDeviceVulkan12Features features12{};
+		features12.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_2_FEATURES;
+		features12.timelineSemaphore = pCaps->mTimelineSemaphore;
+		features12.bufferDeviceAddress = pCaps->mBufferDeviceAddress;
+		features12.hostQueryReset = pCaps->mHostQueryReset;
+		features12.drawIndirectCount = pCaps->mDrawIndirectCount;
+		features12.descriptorIndexing = pCaps->mDescriptorIndexing;
+		features12.runtimeDescriptorArray = pCaps->mDescriptorIndexing;
+		features12.descriptorBindingPartiallyBound = pCaps->mDescriptorIndexing;
+		features12.descriptorBindingVariableDescriptorCount = pCaps->mDescriptorIndexing;
+		features12.shaderSampledImageArrayNonUniformIndexing = pCaps->mDescriptorIndexing;
+
+		VkPhysicalDeviceVulkan13Features features13{};
+		features13.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_VULKAN_1_3_FEATURES;
+		features13.synchronization2 = pCaps->mSynchronization2;
+		features13.dynamicRendering = pCaps->mDynamicRendering;
+
+		VkPhysicalDeviceDynamicRenderingFeaturesKHR dynamicRenderingFeatures{};
+		dynamicRenderingFeatures.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DYNAMIC_RENDERING_FEATURES_KHR;
+		dynamicRenderingFeatures.dynamicRendering = VK_TRUE;
+
+		VkPhysicalDeviceSynchronization2FeaturesKHR synchronization2Features{};
+		synchronization2Features.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR;
+		synchronization2Features.synchronization2 = VK_TRUE;
+
+		std::vector<const char*> enabledExtensions;
+		if (!headless)
+			enabledExtensions.assign(deviceExtensions.begin(), deviceExtensions.end());
+		if (pCaps->mMemoryBudget)
+			enabledExtensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+
+		VkPhysicalDeviceFeatures2 features2{};
+		features2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2;
+		features2.features = deviceFeatures;
+		void** ppNext = &features2.pNext;
+		if (pCaps->mApiVersion >= VK_API_VERSION_1_2)
+		{
+			*ppNext = &features12;
+			ppNext = &features12.pNext;
+		}
+		if (pCaps->mApiVersion >= VK_API_VERSION_1_3)
+		{
+			*ppNext = &features13;
+			ppNext = &features13.pNext;
+		}
+		else
+		{
+			// 1.3 之前通过扩展启用
+			if (pCaps->mDynamicRendering)
+			{
+				enabledExtensions.push_back(VK_KHR_DYNAMIC_RENDERING_EXTENSION_NAME);
+				if (pCaps->mApiVersion < VK_API_VERSION_1_2)
+				{
+					enabledExtensions.push_back(VK_KHR_DEPTH_STENCIL_RESOLVE_EXTENSION_NAME);
+					enabledExtensions.push_back(VK_KHR_CREATE_RENDERPASS_2_EXTENSION_NAME);
+				}
+				*ppNext = &dynamicRenderingFeatures;
+				ppNext = &dynamicRenderingFeatures.pNext;
+			}
+			if (pCaps->mSynchronization2)
+			{
+				enabledExtensions.push_back(VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+				*ppNext = &synchronization2Features;
+				ppNext = &synchronization2Features.pNext;
+			}
+		}
 
 		VkDeviceCreateInfo createInfo{};
 		createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
@@ -399,10 +1137,14 @@ void initRenderer(const char* appName, const RendererDesc* pSettings, Renderer**
 		createInfo.queueCreateInfoCount = static_cast<uint32_t>(queueCreateInfos.size());
 		createInfo.pQueueCreateInfos = queueCreateInfos.data();
 
-		createInfo.pEnabledFeatures = &deviceFeatures;
+		// 1.0 设备只能通过 pEnabledFeatures 启用特性
+		if (pCaps->mApiVersion >= VK_API_VERSION_1_1)
+			createInfo.pNext = &features2;
+		else
+			createInfo.pEnabledFeatures = &deviceFeatures;
 
-		createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-		createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+		createInfo.enabledExtensionCount = static_cast<uint32_t>(enabledExtensions.size());
+		createInfo.ppEnabledExtensionNames = enabledExtensions.data();
 
 		if (enableValidationLayers) {
 			createInfo.enabledLayerCount = static_cast<uint32_t>(validationLayers.size());
@@ -412,13 +1154,18 @@ void initRenderer(const char* appName, const RendererDesc* pSettings, Renderer**
 			createInfo.enabledLayerCount = 0;
 		}
 
-		if (vkCreateDevice(pRenderer->pVkActiveGPU, &createInfo, nullptr, &pRenderer->pVkDevice) != VK_SUCCESS) {
+		if (vkCreateDevice(pRenderer->pVkActiveGPU, &createInfo, pRenderer->pVkAllocator, &pRenderer->pVkDevice) != VK_SUCCESS) {
 			SHEN_CORE_ERROR("failed to create logical device!");
 			throw std::runtime_error("failed to create logical device!");
 		}
+
+		loadDeviceDispatchTable(pRenderer, headless);
+		pRenderer->pRenderPassCache = shen_new(MEMORY_CATEGORY_RENDERER, RenderPassCache);
+		SHEN_CORE_INFO("Rendering path: {0}", pRenderer->mCapabilities.mDynamicRendering ? "dynamic rendering" : "cached render passes");
 	}
 
-	//
+	//创建交换链
+	if (!headless)
 	{
 		SwapChainSupportDetails swapChainSupport = querySwapChainSupport(pRenderer->pVkActiveGPU, pSwapChain->pVkSurface);
 		VkSurfaceFormatKHR surfaceFormat = chooseSwapSurfaceFormat(swapChainSupport.formats);
@@ -469,16 +1216,16 @@ void initRenderer(const char* appName, const RendererDesc* pSettings, Renderer**
 		createInfo.presentMode = presentMode;
 		createInfo.clipped = VK_TRUE;
 
-		if (vkCreateSwapchainKHR(pRenderer->pVkDevice, &createInfo, nullptr, &pSwapChain->pSwapChain) != VK_SUCCESS) {
+		if (pRenderer->mVkDeviceTable.vkCreateSwapchainKHR(pRenderer->pVkDevice, &createInfo, pRenderer->pVkAllocator, &pSwapChain->pSwapChain) != VK_SUCCESS) {
 			SHEN_CORE_ERROR("failed to create swap chain!");
 			throw std::runtime_error("failed to create swap chain!");
 		}
 
 		std::vector<VkImage> swapChainImages;
-		vkGetSwapchainImagesKHR(pRenderer->pVkDevice, pSwapChain->pSwapChain, &imageCount, nullptr);
+		pRenderer->mVkDeviceTable.vkGetSwapchainImagesKHR(pRenderer->pVkDevice, pSwapChain->pSwapChain, &imageCount, nullptr);
 		swapChainImages.resize(imageCount);
-		vkGetSwapchainImagesKHR(pRenderer->pVkDevice, pSwapChain->pSwapChain, &imageCount, swapChainImages.data());
-		//Ϣ洢
+		pRenderer->mVkDeviceTable.vkGetSwapchainImagesKHR(pRenderer->pVkDevice, pSwapChain->pSwapChain, &imageCount, swapChainImages.data());
+		//交换链其他信息存储
 		pTextures.resize(0);
 		for (uint32_t i = 0; i < swapChainImages.size(); i++) {
 			VkImageViewCreateInfo viewInfo{};
@@ -493,7 +1240,7 @@ void initRenderer(const char* appName, const RendererDesc* pSettings, Renderer**
 			viewInfo.subresourceRange.layerCount = 1;
 
 			VkImageView imageView;
-			if (vkCreateImageView(pRenderer->pVkDevice, &viewInfo, nullptr, &imageView) != VK_SUCCESS) {
+			if (pRenderer->mVkDeviceTable.vkCreateImageView(pRenderer->pVkDevice, &viewInfo, pRenderer->pVkAllocator, &imageView) != VK_SUCCESS) {
 				SHEN_CORE_ERROR("failed to create texture image view!");
 				throw std::runtime_error("failed to create texture image view!");
 			}
@@ -501,6 +1248,11 @@ void initRenderer(const char* appName, const RendererDesc* pSettings, Renderer**
 			memset(&pTexture, 0, sizeof(pTexture));
 			pTexture.pVkImage = swapChainImages[i];
 			pTexture.pVkSRVDescriptor = imageView;
+			pTexture.mFormat = surfaceFormat.format;
+			pTexture.mWidth = extent.width;
+			pTexture.mHeight = extent.height;
+			pTexture.mMipLevels = 1;
+			pTexture.mCurrentLayout = VK_IMAGE_LAYOUT_UNDEFINED;
 
 			pTextures.push_back(pTexture);
 		}
@@ -509,8 +1261,8 @@ void initRenderer(const char* appName, const RendererDesc* pSettings, Renderer**
 		pDesc->mExtend2D = extent;
 		pDesc->mImageCount = imageCount;
 		pSwapChain->pDesc = pDesc;
-		//ʾ
-		vkGetDeviceQueue(pRenderer->pVkDevice, pSwapChain->mPresentQueueFamilyIndex, 0, &pSwapChain->pPresentQueue);
+		//创建演示队列
+		pRenderer->mVkDeviceTable.vkGetDeviceQueue(pRenderer->pVkDevice, pSwapChain->mPresentQueueFamilyIndex, 0, &pSwapChain->pPresentQueue);
 	}
 	*ppRenderer = pRenderer;
 	*ppSwapChain = pSwapChain;
@@ -518,7 +1270,7 @@ void initRenderer(const char* appName, const RendererDesc* pSettings, Renderer**
 
 void uitil_find_queue_family_index(const Renderer* pRenderer, QueueType queueType, uint32_t* pOutFamilyIndex)
 {
-	//ͼζ
+	//图形队列
 	if (queueType == QUEUE_TYPE_GRAPHICS)
 	{
 		*pOutFamilyIndex = pRenderer->pVkGraphicsQueueFamilyIndex;
@@ -526,30 +1278,36 @@ void uitil_find_queue_family_index(const Renderer* pRenderer, QueueType queueTyp
 }
 
 /// <summary>
-/// Ӷ
+/// 添加队列族
 /// </summary>
 /// <param name="pRenderer"></param>
 /// <param name="pQDesc"></param>
 /// <param name="pQueue"></param>
 void addQueue(Renderer* pRenderer, QueueDesc* pDesc, Queue** ppQueue)
 {
-	Queue* pQueue = (Queue*)malloc(sizeof(Queue));
+	Queue* pQueue = pRenderer->pResources->mQueues.Allocate();
 	uint32_t queueFamilyIndex = UINT32_MAX;
 	uitil_find_queue_family_index(pRenderer, pDesc->mType, &queueFamilyIndex);
 	pQueue->mVkQueueIndex = queueFamilyIndex;
-	vkGetDeviceQueue(pRenderer->pVkDevice, queueFamilyIndex, 0, &pQueue->pVkQueue);
+	pQueue->pVkDeviceTable = &pRenderer->mVkDeviceTable;
+	pQueue->pRenderer = pRenderer;
+	pRenderer->mVkDeviceTable.vkGetDeviceQueue(pRenderer->pVkDevice, queueFamilyIndex, 0, &pQueue->pVkQueue);
+	if (pDesc->mFlag & QUEUE_FLAG_INIT_MICROPROFILE)
+	{
+		initGpuProfiler(pRenderer, pQueue, pDesc->mGpuProfilerFrameCount);
+	}
 	*ppQueue = pQueue;
 }
 
 /// <summary>
-/// Ⱦͨ
+/// 添加渲染通道
 /// </summary>
 /// <param name="pRenderer"></param>
 /// <param name="pDesc"></param>
 /// <param name="ppRenderPass"></param>
 void addRenderPass(Renderer* pRenderer, const RenderPassDesc* pDesc, RenderPass** ppRenderPass)
 {
-	RenderPass* pRenderPass = (RenderPass*)malloc(sizeof(RenderPass));
+	RenderPass* pRenderPass = pRenderer->pResources->mRenderPasses.Allocate();
 	VkAttachmentDescription colorAttachment{};
 	colorAttachment.format = pDesc->pColorFormats;
 	colorAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
@@ -587,18 +1345,19 @@ void addRenderPass(Renderer* pRenderer, const RenderPassDesc* pDesc, RenderPass*
 	renderPassInfo.pDependencies = &dependency;
 
 	VkRenderPass renderPass = {};
-	if (vkCreateRenderPass(pRenderer->pVkDevice, &renderPassInfo, nullptr, &renderPass) != VK_SUCCESS) {
+	if (pRenderer->mVkDeviceTable.vkCreateRenderPass(pRenderer->pVkDevice, &renderPassInfo, pRenderer->pVkAllocator, &renderPass) != VK_SUCCESS) {
 		SHEN_CORE_ERROR("failed to create render pass!");
 		throw std::runtime_error("failed to create render pass!");
 	}
 
 	pRenderPass->pRenderPass = renderPass;
+	pRenderPass->mDesc = *pDesc;
 	*ppRenderPass = pRenderPass;
 }
 
 void addGraphicsPipeline(Renderer* pRenderer, const PipelineDesc* pDesc, Pipeline** ppPipeline)
 {
-	Pipeline* pPipeline = (Pipeline*)malloc(sizeof(Pipeline));
+	Pipeline* pPipeline = pRenderer->pResources->mPipelines.Allocate();
 	pPipeline->mType = pDesc->mType;
 	int32_t shaderCount = pDesc->mGraphicsDesc.pShaderCount;
 	VkPipelineShaderStageCreateInfo vertShaderStageInfo{};
@@ -615,10 +1374,30 @@ void addGraphicsPipeline(Renderer* pRenderer, const PipelineDesc* pDesc, Pipelin
 
 	VkPipelineShaderStageCreateInfo shaderStages[] = { vertShaderStageInfo, fragShaderStageInfo };
 
+	VkVertexInputBindingDescription vertexBinding{};
+	VkVertexInputAttributeDescription vertexAttributes[MAX_VERTEX_ATTRIBS] = {};
 	VkPipelineVertexInputStateCreateInfo vertexInputInfo{};
 	vertexInputInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO;
 	vertexInputInfo.vertexBindingDescriptionCount = 0;
 	vertexInputInfo.vertexAttributeDescriptionCount = 0;
+	const VertexLayout* pVertexLayout = pDesc->mGraphicsDesc.pVertexLayout;
+	if (pVertexLayout && pVertexLayout->mAttribCount)
+	{
+		vertexBinding.binding = 0;
+		vertexBinding.stride = pVertexLayout->mStride;
+		vertexBinding.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+		for (uint32_t i = 0; i < pVertexLayout->mAttribCount; ++i)
+		{
+			vertexAttributes[i].location = pVertexLayout->mAttribs[i].mLocation;
+			vertexAttributes[i].binding = 0;
+			vertexAttributes[i].format = pVertexLayout->mAttribs[i].mFormat;
+			vertexAttributes[i].offset = pVertexLayout->mAttribs[i].mOffset;
+		}
+		vertexInputInfo.vertexBindingDescriptionCount = 1;
+		vertexInputInfo.pVertexBindingDescriptions = &vertexBinding;
+		vertexInputInfo.vertexAttributeDescriptionCount = pVertexLayout->mAttribCount;
+		vertexInputInfo.pVertexAttributeDescriptions = vertexAttributes;
+	}
 
 	VkPipelineInputAssemblyStateCreateInfo inputAssembly{};
 	inputAssembly.sType = VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO;
@@ -645,16 +1424,19 @@ void addGraphicsPipeline(Renderer* pRenderer, const PipelineDesc* pDesc, Pipelin
 	multisampling.sampleShadingEnable = VK_FALSE;
 	multisampling.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
 
-	VkPipelineColorBlendAttachmentState colorBlendAttachment{};
-	colorBlendAttachment.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-	colorBlendAttachment.blendEnable = VK_FALSE;
+	VkPipelineColorBlendAttachmentState colorBlendAttachments[MAX_RENDER_TARGET_ATTACHMENTS] = {};
+	for (uint32_t i = 0; i < pDesc->mGraphicsDesc.mRenderTargetCount; ++i)
+	{
+		colorBlendAttachments[i].colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+		colorBlendAttachments[i].blendEnable = VK_FALSE;
+	}
 
 	VkPipelineColorBlendStateCreateInfo colorBlending{};
 	colorBlending.sType = VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO;
 	colorBlending.logicOpEnable = VK_FALSE;
 	colorBlending.logicOp = VK_LOGIC_OP_COPY;
-	colorBlending.attachmentCount = 1;
-	colorBlending.pAttachments = &colorBlendAttachment;
+	colorBlending.attachmentCount = pDesc->mGraphicsDesc.mRenderTargetCount;
+	colorBlending.pAttachments = colorBlendAttachments;
 	colorBlending.blendConstants[0] = 0.0f;
 	colorBlending.blendConstants[1] = 0.0f;
 	colorBlending.blendConstants[2] = 0.0f;
@@ -669,26 +1451,43 @@ void addGraphicsPipeline(Renderer* pRenderer, const PipelineDesc* pDesc, Pipelin
 	dynamicState.dynamicStateCount = static_cast<uint32_t>(dynamicStates.size());
 	dynamicState.pDynamicStates = dynamicStates.data();
 
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = PUSH_CONSTANT_STAGES;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = pDesc->mGraphicsDesc.mPushConstantSize;
+
 	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
 	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
 	pipelineLayoutInfo.setLayoutCount = 0;
-	pipelineLayoutInfo.pushConstantRangeCount = 0;
+	pipelineLayoutInfo.pushConstantRangeCount = pushConstantRange.size ? 1 : 0;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
 
-	if (vkCreatePipelineLayout(pRenderer->pVkDevice, &pipelineLayoutInfo, nullptr, &pPipeline->mVkPipelineLayout) != VK_SUCCESS) {
+	if (pRenderer->mVkDeviceTable.vkCreatePipelineLayout(pRenderer->pVkDevice, &pipelineLayoutInfo, pRenderer->pVkAllocator, &pPipeline->mVkPipelineLayout) != VK_SUCCESS) {
 		SHEN_CORE_ERROR("failed to create pipeline layout!");
 		throw std::runtime_error("failed to create pipeline layout!");
 	}
 
 
 
-	RenderPassDesc renderPassDesc = {};
-	renderPassDesc.pColorFormats = pDesc->mGraphicsDesc.pColorFormats;
-	RenderPass* pRenderPass;
-	addRenderPass(pRenderer, &renderPassDesc, &pRenderPass);
-	pPipeline->mRenderPass = *pRenderPass;
-
+	const GraphicsPipelineDesc* pGraphicsDesc = &pDesc->mGraphicsDesc;
 	VkGraphicsPipelineCreateInfo pipelineInfo{};
 	pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
+
+	// 动态渲染: 管线只记录附件格式; 否则使用缓存中格式兼容的渲染通道
+	VkPipelineRenderingCreateInfoKHR renderingInfo{};
+	if (pRenderer->mCapabilities.mDynamicRendering)
+	{
+		renderingInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_RENDERING_CREATE_INFO_KHR;
+		renderingInfo.colorAttachmentCount = pGraphicsDesc->mRenderTargetCount;
+		renderingInfo.pColorAttachmentFormats = pGraphicsDesc->pColorFormats;
+		pipelineInfo.pNext = &renderingInfo;
+		pipelineInfo.renderPass = VK_NULL_HANDLE;
+	}
+	else
+	{
+		pipelineInfo.renderPass = getCompatibleRenderPass(pRenderer, pGraphicsDesc->mRenderTargetCount, pGraphicsDesc->pColorFormats);
+	}
+
 	pipelineInfo.stageCount = 2;
 	pipelineInfo.pStages = shaderStages;
 	pipelineInfo.pVertexInputState = &vertexInputInfo;
@@ -699,44 +1498,118 @@ void addGraphicsPipeline(Renderer* pRenderer, const PipelineDesc* pDesc, Pipelin
 	pipelineInfo.pColorBlendState = &colorBlending;
 	pipelineInfo.pDynamicState = &dynamicState;
 	pipelineInfo.layout = pPipeline->mVkPipelineLayout;
-	pipelineInfo.renderPass = pRenderPass->pRenderPass;
 	pipelineInfo.subpass = 0;
 	pipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
-	if (vkCreateGraphicsPipelines(pRenderer->pVkDevice, VK_NULL_HANDLE, 1, &pipelineInfo, nullptr, &pPipeline->pVkPipeline) != VK_SUCCESS) {
+	if (pRenderer->mVkDeviceTable.vkCreateGraphicsPipelines(pRenderer->pVkDevice, VK_NULL_HANDLE, 1, &pipelineInfo, pRenderer->pVkAllocator, &pPipeline->pVkPipeline) != VK_SUCCESS) {
 		SHEN_CORE_ERROR("failed to create graphics pipeline!");
 		throw std::runtime_error("failed to create graphics pipeline!");
 	}
 
-
-	vkDestroyShaderModule(pRenderer->pVkDevice, pDesc->mGraphicsDesc.pShaders[0]->pShaderModule, nullptr);
-	vkDestroyShaderModule(pRenderer->pVkDevice, pDesc->mGraphicsDesc.pShaders[1]->pShaderModule, nullptr);
-
 	*ppPipeline = pPipeline;
 }
 
-void addPipeline(Renderer* pRenderer, const PipelineDesc* pDesc, Pipeline** ppPipeline)
+/// <summary>
+/// 创建计算管线: 描述符集 0 依次绑定 mStorageBufferCount 个存储缓冲, 推送常量只对计算阶段可见
+/// 任一步骤失败时销毁已创建的对象并归还管线槽位
+/// </summary>
+void addComputePipeline(Renderer* pRenderer, const PipelineDesc* pDesc, Pipeline** ppPipeline)
 {
-	switch (pDesc->mType)
-	{
-	case PIPELINE_TYPE_GRAPHICS:
+	const ComputePipelineDesc* pComputeDesc = &pDesc->mComputeDesc;
+	if (pComputeDesc->mStorageBufferCount > MAX_COMPUTE_STORAGE_BUFFERS || pComputeDesc->mPushConstantSize > 128)
 	{
-		addGraphicsPipeline(pRenderer, pDesc, ppPipeline);
-		break;
-	}
-	default:
-		break;
+		SHEN_CORE_ERROR("compute pipeline supports at most {0} storage buffers and 128 bytes of push constants!", MAX_COMPUTE_STORAGE_BUFFERS);
+		throw std::runtime_error("invalid compute pipeline desc!");
 	}
 
+	Pipeline* pPipeline = pRenderer->pResources->mPipelines.Allocate();
+	pPipeline->mType = pDesc->mType;
+	pPipeline->mStorageBufferCount = pComputeDesc->mStorageBufferCount;
 
-}
+	VkDescriptorSetLayoutBinding bindings[MAX_COMPUTE_STORAGE_BUFFERS] = {};
+	for (uint32_t i = 0; i < pComputeDesc->mStorageBufferCount; ++i)
+	{
+		bindings[i].binding = i;
+		bindings[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		bindings[i].descriptorCount = 1;
+		bindings[i].stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	}
+	VkDescriptorSetLayoutCreateInfo setLayoutInfo{};
+	setLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	setLayoutInfo.bindingCount = pComputeDesc->mStorageBufferCount;
+	setLayoutInfo.pBindings = bindings;
+
+	VkPushConstantRange pushConstantRange{};
+	pushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	pushConstantRange.offset = 0;
+	pushConstantRange.size = pComputeDesc->mPushConstantSize;
+
+	VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+	pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+	pipelineLayoutInfo.setLayoutCount = 1;
+	pipelineLayoutInfo.pSetLayouts = &pPipeline->mVkDescriptorSetLayout;
+	pipelineLayoutInfo.pushConstantRangeCount = pushConstantRange.size ? 1 : 0;
+	pipelineLayoutInfo.pPushConstantRanges = &pushConstantRange;
+
+	VkComputePipelineCreateInfo pipelineInfo{};
+	pipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	pipelineInfo.stage.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+	pipelineInfo.stage.stage = VK_SHADER_STAGE_COMPUTE_BIT;
+	pipelineInfo.stage.module = pComputeDesc->pShader->pShaderModule;
+	pipelineInfo.stage.pName = "main";
+
+	const char* pFailure = NULL;
+	if (pRenderer->mVkDeviceTable.vkCreateDescriptorSetLayout(pRenderer->pVkDevice, &setLayoutInfo, pRenderer->pVkAllocator, &pPipeline->mVkDescriptorSetLayout) != VK_SUCCESS)
+		pFailure = "failed to create descriptor set layout!";
+	else if (pRenderer->mVkDeviceTable.vkCreatePipelineLayout(pRenderer->pVkDevice, &pipelineLayoutInfo, pRenderer->pVkAllocator, &pPipeline->mVkPipelineLayout) != VK_SUCCESS)
+		pFailure = "failed to create pipeline layout!";
+	else
+	{
+		pipelineInfo.layout = pPipeline->mVkPipelineLayout;
+		if (pRenderer->mVkDeviceTable.vkCreateComputePipelines(pRenderer->pVkDevice, VK_NULL_HANDLE, 1, &pipelineInfo, pRenderer->pVkAllocator, &pPipeline->pVkPipeline) != VK_SUCCESS)
+			pFailure = "failed to create compute pipeline!";
+	}
+	if (pFailure)
+	{
+		// 槽位已清零, 未创建的句柄为 VK_NULL_HANDLE, 销毁时忽略
+		pRenderer->mVkDeviceTable.vkDestroyPipelineLayout(pRenderer->pVkDevice, pPipeline->mVkPipelineLayout, pRenderer->pVkAllocator);
+		pRenderer->mVkDeviceTable.vkDestroyDescriptorSetLayout(pRenderer->pVkDevice, pPipeline->mVkDescriptorSetLayout, pRenderer->pVkAllocator);
+		pRenderer->pResources->mPipelines.Release(pRenderer->pResources->mPipelines.GetHandle(pPipeline));
+		SHEN_CORE_ERROR("{0}", pFailure);
+		throw std::runtime_error(pFailure);
+	}
+
+	*ppPipeline = pPipeline;
+}
+
+void addPipeline(Renderer* pRenderer, const PipelineDesc* pDesc, Pipeline** ppPipeline)
+{
+	SHEN_PROFILE_FUNCTION();
+	switch (pDesc->mType)
+	{
+	case PIPELINE_TYPE_GRAPHICS:
+	{
+		addGraphicsPipeline(pRenderer, pDesc, ppPipeline);
+		break;
+	}
+	case PIPELINE_TYPE_COMPUTE:
+	{
+		addComputePipeline(pRenderer, pDesc, ppPipeline);
+		break;
+	}
+	default:
+		break;
+	}
+
+
+}
 
 /// <summary>
-	/// ȡļ
+	/// 读取文件
 	/// </summary>
 	/// <param name="filename"></param>
 	/// <returns></returns>
-static std::vector<char> readFile(const std::string& filename) {
+static std::vector<char, CategoryAllocator<char, MEMORY_CATEGORY_ASSETS>> readFile(const std::string& filename) {
 	std::ifstream file(filename, std::ios::ate | std::ios::binary);
 
 	if (!file.is_open()) {
@@ -745,7 +1618,7 @@ static std::vector<char> readFile(const std::string& filename) {
 	}
 
 	size_t fileSize = (size_t)file.tellg();
-	std::vector<char> buffer(fileSize);
+	std::vector<char, CategoryAllocator<char, MEMORY_CATEGORY_ASSETS>> buffer(fileSize);
 
 	file.seekg(0);
 	file.read(buffer.data(), fileSize);
@@ -757,15 +1630,34 @@ static std::vector<char> readFile(const std::string& filename) {
 
 void addShader(Renderer* pRenderer, const ShaderDesc* pDesc, Shader** ppShader)
 {
-	int32_t size = sizeof(Shader);
-	Shader* pShader = (Shader*)malloc(sizeof(Shader));
-	auto shaderCode = readFile(pDesc->pFileName);
-
+	SHEN_PROFILE_FUNCTION();
+	Shader* pShader = pRenderer->pResources->mShaders.Allocate();
 	VkShaderModuleCreateInfo createInfo{};
 	createInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-	createInfo.codeSize = shaderCode.size();
-	createInfo.pCode = reinterpret_cast<const uint32_t*>(shaderCode.data());
-	if (vkCreateShaderModule(pRenderer->pVkDevice, &createInfo, nullptr, &pShader->pShaderModule) != VK_SUCCESS) {
+	VkResult result;
+	if (pDesc->pPack)
+	{
+		AssetRequest* pRequest = requestAsset(pDesc->pPack, pDesc->pFileName, ASSET_PRIORITY_HIGH);
+		if (!pRequest || !waitForAssetRequest(pRequest)) {
+			if (pRequest)
+				releaseAssetRequest(pRequest);
+			SHEN_CORE_ERROR("failed to load shader {0}", pDesc->pFileName);
+			throw std::runtime_error("failed to load shader!");
+		}
+		uint64_t codeSize;
+		createInfo.pCode = reinterpret_cast<const uint32_t*>(getAssetRequestData(pRequest, &codeSize));
+		createInfo.codeSize = (size_t)codeSize;
+		result = pRenderer->mVkDeviceTable.vkCreateShaderModule(pRenderer->pVkDevice, &createInfo, pRenderer->pVkAllocator, &pShader->pShaderModule);
+		releaseAssetRequest(pRequest);
+	}
+	else
+	{
+		auto shaderCode = readFile(pDesc->pFileName);
+		createInfo.codeSize = shaderCode.size();
+		createInfo.pCode = reinterpret_cast<const uint32_t*>(shaderCode.data());
+		result = pRenderer->mVkDeviceTable.vkCreateShaderModule(pRenderer->pVkDevice, &createInfo, pRenderer->pVkAllocator, &pShader->pShaderModule);
+	}
+	if (result != VK_SUCCESS) {
 		SHEN_CORE_ERROR("failed to create shader module!");
 		throw std::runtime_error("failed to create shader module!");
 	}
@@ -775,14 +1667,14 @@ void addShader(Renderer* pRenderer, const ShaderDesc* pDesc, Shader** ppShader)
 }
 
 /// <summary>
-/// ֡
+/// 添加帧缓存
 /// </summary>
 /// <param name="pRenderer"></param>
 /// <param name="pDesc"></param>
 /// <param name="ppFrameBuffer"></param>
 void addFrameBuffer(Renderer* pRenderer, const FrameBufferDesc* pDesc, FrameBuffer** ppFrameBuffer)
 {
-	FrameBuffer* pFrameBuffer = (FrameBuffer*)malloc(sizeof(FrameBuffer));
+	FrameBuffer* pFrameBuffer = pRenderer->pResources->mFrameBuffers.Allocate();
 
 	VkImageView attachments[] = {
 		pDesc->pTexture->pVkSRVDescriptor
@@ -797,7 +1689,7 @@ void addFrameBuffer(Renderer* pRenderer, const FrameBufferDesc* pDesc, FrameBuff
 	framebufferInfo.height = pDesc->mHeight;
 	framebufferInfo.layers = 1;
 
-	if (vkCreateFramebuffer(pRenderer->pVkDevice, &framebufferInfo, nullptr, &pFrameBuffer->pFramebuffer) != VK_SUCCESS) {
+	if (pRenderer->mVkDeviceTable.vkCreateFramebuffer(pRenderer->pVkDevice, &framebufferInfo, pRenderer->pVkAllocator, &pFrameBuffer->pFramebuffer) != VK_SUCCESS) {
 		SHEN_CORE_ERROR("failed to create framebuffer!");
 		throw std::runtime_error("failed to create framebuffer!");
 	}
@@ -808,19 +1700,19 @@ void addFrameBuffer(Renderer* pRenderer, const FrameBufferDesc* pDesc, FrameBuff
 }
 
 /// <summary>
-/// 
+/// 添加命令缓冲池
 /// </summary>
 /// <param name="pRenderer"></param>
 /// <param name="pDesc"></param>
 /// <param name="ppCmdPool"></param>
 void addCmdPool(Renderer* pRenderer, const CmdPoolDesc* pDesc, CmdPool** ppCmdPool)
 {
-	CmdPool* pCmdPool = (CmdPool*)malloc(sizeof(CmdPool));
+	CmdPool* pCmdPool = pRenderer->pResources->mCmdPools.Allocate();
 	VkCommandPoolCreateInfo poolInfo{};
 	poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
 	poolInfo.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
 	poolInfo.queueFamilyIndex = pDesc->pQueue->mVkQueueIndex;
-	if (vkCreateCommandPool(pRenderer->pVkDevice, &poolInfo, nullptr, &pCmdPool->pVkCmdPool) != VK_SUCCESS) {
+	if (pRenderer->mVkDeviceTable.vkCreateCommandPool(pRenderer->pVkDevice, &poolInfo, pRenderer->pVkAllocator, &pCmdPool->pVkCmdPool) != VK_SUCCESS) {
 		SHEN_CORE_ERROR("failed to create command pool!");
 		throw std::runtime_error("failed to create command pool!");
 	}
@@ -830,14 +1722,14 @@ void addCmdPool(Renderer* pRenderer, const CmdPoolDesc* pDesc, CmdPool** ppCmdPo
 }
 
 /// <summary>
-/// 
+/// 添加命令
 /// </summary>
 /// <param name="pRenderer"></param>
 /// <param name="pDesc"></param>
 /// <param name="ppCmd"></param>
 void addCmd(Renderer* pRenderer, const CmdDesc* pDesc, Cmd** ppCmd)
 {
-	Cmd* pCmd = (Cmd*)malloc(sizeof(Cmd));
+	Cmd* pCmd = pRenderer->pResources->mCmds.Allocate();
 
 	VkCommandBufferAllocateInfo allocInfo{};
 	allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
@@ -845,27 +1737,31 @@ void addCmd(Renderer* pRenderer, const CmdDesc* pDesc, Cmd** ppCmd)
 	allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
 	allocInfo.commandBufferCount = 1;
 
-	if (vkAllocateCommandBuffers(pRenderer->pVkDevice, &allocInfo, &(pCmd->pVkCmdBuf)) != VK_SUCCESS) {
+	if (pRenderer->mVkDeviceTable.vkAllocateCommandBuffers(pRenderer->pVkDevice, &allocInfo, &(pCmd->pVkCmdBuf)) != VK_SUCCESS) {
 		SHEN_CORE_ERROR("failed to allocate command buffers!");
 		throw std::runtime_error("failed to allocate command buffers!");
 	}
+	pCmd->pCmdPool = pDesc->pPool;
+	pCmd->pQueue = pDesc->pPool->pQueue;
+	pCmd->pRenderer = pRenderer;
+	pCmd->pVkDeviceTable = &pRenderer->mVkDeviceTable;
 
 	*ppCmd = pCmd;
 }
 
 /// <summary>
-/// ź
+/// 添加信号量
 /// </summary>
 /// <param name="pRenderer"></param>
 /// <param name="ppSemaphore"></param>
 void addSemaphore(Renderer* pRenderer, Semaphore** ppSemaphore)
 {
-	Semaphore* pSemaphore = (Semaphore*)malloc(sizeof(Semaphore));
+	Semaphore* pSemaphore = pRenderer->pResources->mSemaphores.Allocate();
 	VkSemaphoreCreateInfo semaphoreInfo{};
 	semaphoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
 	semaphoreInfo.pNext = NULL;
 	semaphoreInfo.flags = 0;
-	if (vkCreateSemaphore(pRenderer->pVkDevice, &semaphoreInfo, nullptr, &pSemaphore->pVkSemaphore) != VK_SUCCESS)
+	if (pRenderer->mVkDeviceTable.vkCreateSemaphore(pRenderer->pVkDevice, &semaphoreInfo, pRenderer->pVkAllocator, &pSemaphore->pVkSemaphore) != VK_SUCCESS)
 	{
 		SHEN_CORE_ERROR("failed to create synchronization objects for a frame!");
 		throw std::runtime_error("failed to create synchronization objects for a frame!");
@@ -875,20 +1771,20 @@ void addSemaphore(Renderer* pRenderer, Semaphore** ppSemaphore)
 }
 
 /// <summary>
-/// դ
+/// 添加栅栏
 /// </summary>
 /// <param name="pRenderer"></param>
 /// <param name="ppFence"></param>
 void addFence(Renderer* pRenderer, Fence** ppFence)
 {
-	Fence* pFence = (Fence*)malloc(sizeof(Fence));
+	Fence* pFence = pRenderer->pResources->mFences.Allocate();
 
 	VkFenceCreateInfo fenceInfo{};
 	fenceInfo.sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO;
 	fenceInfo.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 	fenceInfo.pNext = NULL;
 
-	if (vkCreateFence(pRenderer->pVkDevice, &fenceInfo, nullptr, &pFence->pVkFence) != VK_SUCCESS) {
+	if (pRenderer->mVkDeviceTable.vkCreateFence(pRenderer->pVkDevice, &fenceInfo, pRenderer->pVkAllocator, &pFence->pVkFence) != VK_SUCCESS) {
 		SHEN_CORE_ERROR("failed to create synchronization objects for a frame!");
 		throw std::runtime_error("failed to create synchronization objects for a frame!");
 	}
@@ -896,34 +1792,579 @@ void addFence(Renderer* pRenderer, Fence** ppFence)
 	*ppFence = pFence;
 }
 
-/*********  ͼβֺ ***********/
+/// <summary>
+/// 选取满足条件的显存类型, 优先选择同时带有 preferredProperties 的类型
+/// </summary>
+static uint32_t findMemoryType(Renderer* pRenderer, uint32_t typeBits, VkMemoryPropertyFlags properties, VkMemoryPropertyFlags preferredProperties)
+{
+	VkPhysicalDeviceMemoryProperties memoryProperties;
+	vkGetPhysicalDeviceMemoryProperties(pRenderer->pVkActiveGPU, &memoryProperties);
+	VkMemoryPropertyFlags candidates[2] = { properties | preferredProperties, properties };
+	for (VkMemoryPropertyFlags required : candidates)
+	{
+		for (uint32_t i = 0; i < memoryProperties.memoryTypeCount; ++i)
+		{
+			if ((typeBits & (1u << i)) && (memoryProperties.memoryTypes[i].propertyFlags & required) == required)
+				return i;
+		}
+	}
+	SHEN_CORE_ERROR("failed to find a suitable memory type!");
+	throw std::runtime_error("failed to find a suitable memory type!");
+}
+
+/// <summary>
+/// 创建二维图像, 分配独占的设备本地内存并创建覆盖全部 mip 层级的视图
+/// 渲染目标与采样纹理共用, 出错信息中的 pKind 区分两者
+/// </summary>
+static void createTextureImage(Renderer* pRenderer, uint32_t width, uint32_t height, uint32_t mipLevels, VkFormat format,
+	VkImageUsageFlags usage, const char* pKind, Texture* pTexture)
+{
+	VkImageCreateInfo imageInfo{};
+	imageInfo.sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO;
+	imageInfo.imageType = VK_IMAGE_TYPE_2D;
+	imageInfo.format = format;
+	imageInfo.extent = { width, height, 1 };
+	imageInfo.mipLevels = mipLevels;
+	imageInfo.arrayLayers = 1;
+	imageInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+	imageInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+	imageInfo.usage = usage;
+	imageInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+	if (pRenderer->mVkDeviceTable.vkCreateImage(pRenderer->pVkDevice, &imageInfo, pRenderer->pVkAllocator, &pTexture->pVkImage) != VK_SUCCESS)
+	{
+		SHEN_CORE_ERROR("failed to create {0} image!", pKind);
+		throw std::runtime_error("failed to create texture image!");
+	}
+
+	VkMemoryRequirements memoryRequirements;
+	pRenderer->mVkDeviceTable.vkGetImageMemoryRequirements(pRenderer->pVkDevice, pTexture->pVkImage, &memoryRequirements);
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = memoryRequirements.size;
+	allocInfo.memoryTypeIndex = findMemoryType(pRenderer, memoryRequirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0);
+	if (pRenderer->mVkDeviceTable.vkAllocateMemory(pRenderer->pVkDevice, &allocInfo, pRenderer->pVkAllocator, &pTexture->pVkMemory) != VK_SUCCESS)
+	{
+		SHEN_CORE_ERROR("failed to allocate {0} memory!", pKind);
+		throw std::runtime_error("failed to allocate texture memory!");
+	}
+	pRenderer->mVkDeviceTable.vkBindImageMemory(pRenderer->pVkDevice, pTexture->pVkImage, pTexture->pVkMemory, 0);
+	pTexture->mMemorySize = memoryRequirements.size;
+
+	VkImageViewCreateInfo viewInfo{};
+	viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
+	viewInfo.image = pTexture->pVkImage;
+	viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	viewInfo.format = format;
+	viewInfo.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	viewInfo.subresourceRange.levelCount = mipLevels;
+	viewInfo.subresourceRange.layerCount = 1;
+	if (pRenderer->mVkDeviceTable.vkCreateImageView(pRenderer->pVkDevice, &viewInfo, pRenderer->pVkAllocator, &pTexture->pVkSRVDescriptor) != VK_SUCCESS)
+	{
+		SHEN_CORE_ERROR("failed to create {0} image view!", pKind);
+		throw std::runtime_error("failed to create texture image view!");
+	}
+
+	pTexture->mFormat = format;
+	pTexture->mWidth = width;
+	pTexture->mHeight = height;
+	pTexture->mMipLevels = mipLevels;
+	pTexture->mCurrentLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+}
+
+/// <summary>
+/// 从纹理池取一个槽位并创建图像; 创建失败时销毁已创建的对象 (空句柄的销毁调用不做任何事), 归还槽位后继续抛出
+/// </summary>
+static Texture* addTextureImage(Renderer* pRenderer, uint32_t width, uint32_t height, uint32_t mipLevels, VkFormat format,
+	VkImageUsageFlags usage, const char* pKind)
+{
+	TextureHandle handle;
+	Texture* pTexture = pRenderer->pResources->mTextures.Allocate(&handle);
+	try
+	{
+		createTextureImage(pRenderer, width, height, mipLevels, format, usage, pKind, pTexture);
+	}
+	catch (...)
+	{
+		pRenderer->mVkDeviceTable.vkDestroyImageView(pRenderer->pVkDevice, pTexture->pVkSRVDescriptor, pRenderer->pVkAllocator);
+		pRenderer->mVkDeviceTable.vkDestroyImage(pRenderer->pVkDevice, pTexture->pVkImage, pRenderer->pVkAllocator);
+		pRenderer->mVkDeviceTable.vkFreeMemory(pRenderer->pVkDevice, pTexture->pVkMemory, pRenderer->pVkAllocator);
+		pRenderer->pResources->mTextures.Release(handle);
+		throw;
+	}
+	return pTexture;
+}
+
+/// <summary>
+/// 添加离屏渲染目标, 可作为颜色附件, 采样源与拷贝源
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pDesc"></param>
+/// <param name="ppTexture"></param>
+void addRenderTarget(Renderer* pRenderer, const RenderTargetDesc* pDesc, Texture** ppTexture)
+{
+	*ppTexture = addTextureImage(pRenderer, pDesc->mWidth, pDesc->mHeight, 1, pDesc->mFormat,
+		VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, "render target");
+}
+
+/// <summary>
+/// 添加采样纹理; 拷贝目标用于上传, blit 源用于 cmdGenerateMipmaps 逐级下采样
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pDesc"></param>
+/// <param name="ppTexture"></param>
+void addTexture(Renderer* pRenderer, const TextureDesc* pDesc, Texture** ppTexture)
+{
+	uint32_t mipLevels = pDesc->mMipLevels;
+	if (mipLevels == 0)
+	{
+		for (uint32_t size = std::max(pDesc->mWidth, pDesc->mHeight); size; size >>= 1)
+			++mipLevels;
+	}
+
+	*ppTexture = addTextureImage(pRenderer, pDesc->mWidth, pDesc->mHeight, mipLevels, pDesc->mFormat,
+		VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT, "texture");
+}
+
+/// <summary>
+/// 创建缓冲并分配独占的内存, 主机可见的内存在这里映射
+/// </summary>
+static void createBuffer(Renderer* pRenderer, const BufferDesc* pDesc, Buffer* pBuffer)
+{
+	VkBufferCreateInfo bufferInfo{};
+	bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
+	bufferInfo.size = pDesc->mSize;
+	bufferInfo.usage = pDesc->mUsage;
+	bufferInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+	if (pRenderer->mVkDeviceTable.vkCreateBuffer(pRenderer->pVkDevice, &bufferInfo, pRenderer->pVkAllocator, &pBuffer->pVkBuffer) != VK_SUCCESS)
+	{
+		SHEN_CORE_ERROR("failed to create buffer!");
+		throw std::runtime_error("failed to create buffer!");
+	}
+
+	VkMemoryPropertyFlags properties = VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT;
+	VkMemoryPropertyFlags preferredProperties = 0;
+	if (pDesc->mMemoryUsage == RESOURCE_MEMORY_USAGE_CPU_TO_GPU)
+	{
+		properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+	}
+	else if (pDesc->mMemoryUsage == RESOURCE_MEMORY_USAGE_GPU_TO_CPU)
+	{
+		// 回读时 CPU 逐项读取, 无缓存的主机内存读取非常慢
+		properties = VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT;
+		preferredProperties = VK_MEMORY_PROPERTY_HOST_CACHED_BIT;
+	}
+
+	VkMemoryRequirements memoryRequirements;
+	pRenderer->mVkDeviceTable.vkGetBufferMemoryRequirements(pRenderer->pVkDevice, pBuffer->pVkBuffer, &memoryRequirements);
+	VkMemoryAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
+	allocInfo.allocationSize = memoryRequirements.size;
+	allocInfo.memoryTypeIndex = findMemoryType(pRenderer, memoryRequirements.memoryTypeBits, properties, preferredProperties);
+	if (pRenderer->mVkDeviceTable.vkAllocateMemory(pRenderer->pVkDevice, &allocInfo, pRenderer->pVkAllocator, &pBuffer->pVkMemory) != VK_SUCCESS)
+	{
+		SHEN_CORE_ERROR("failed to allocate buffer memory!");
+		throw std::runtime_error("failed to allocate buffer memory!");
+	}
+	pRenderer->mVkDeviceTable.vkBindBufferMemory(pRenderer->pVkDevice, pBuffer->pVkBuffer, pBuffer->pVkMemory, 0);
+
+	if (pDesc->mMemoryUsage != RESOURCE_MEMORY_USAGE_GPU_ONLY &&
+		pRenderer->mVkDeviceTable.vkMapMemory(pRenderer->pVkDevice, pBuffer->pVkMemory, 0, VK_WHOLE_SIZE, 0, &pBuffer->pCpuMappedAddress) != VK_SUCCESS)
+	{
+		SHEN_CORE_ERROR("failed to map buffer memory!");
+		throw std::runtime_error("failed to map buffer memory!");
+	}
+
+	pBuffer->mSize = pDesc->mSize;
+	pBuffer->mMemoryUsage = pDesc->mMemoryUsage;
+}
+
+/// <summary>
+/// 添加缓冲, 主机可见的缓冲在创建时映射, 直到释放前一直保持映射
+/// 创建失败时销毁已创建的对象 (空句柄的销毁调用不做任何事), 归还槽位后继续抛出
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pDesc"></param>
+/// <param name="ppBuffer"></param>
+void addBuffer(Renderer* pRenderer, const BufferDesc* pDesc, Buffer** ppBuffer)
+{
+	BufferHandle handle;
+	Buffer* pBuffer = pRenderer->pResources->mBuffers.Allocate(&handle);
+	try
+	{
+		createBuffer(pRenderer, pDesc, pBuffer);
+	}
+	catch (...)
+	{
+		pRenderer->mVkDeviceTable.vkDestroyBuffer(pRenderer->pVkDevice, pBuffer->pVkBuffer, pRenderer->pVkAllocator);
+		pRenderer->mVkDeviceTable.vkFreeMemory(pRenderer->pVkDevice, pBuffer->pVkMemory, pRenderer->pVkAllocator);
+		pRenderer->pResources->mBuffers.Release(handle);
+		throw;
+	}
+	*ppBuffer = pBuffer;
+}
+
+/// <summary>
+/// 管线统计查询收集的计数项, 结果按位顺序依次写入, 与 PipelineStatistics 的字段一一对应
+/// </summary>
+static const VkQueryPipelineStatisticFlags PIPELINE_STATISTICS_FLAGS =
+	VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_CLIPPING_INVOCATIONS_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT |
+	VK_QUERY_PIPELINE_STATISTIC_COMPUTE_SHADER_INVOCATIONS_BIT;
+
+static_assert(sizeof(PipelineStatistics) == 7 * sizeof(uint64_t), "PipelineStatistics must match PIPELINE_STATISTICS_FLAGS");
+
+/// <summary>
+/// 添加查询池, 创建后所有查询处于未重置状态, 首次使用前需要 cmdResetQueryPool
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pDesc"></param>
+/// <param name="ppQueryPool"></param>
+void addQueryPool(Renderer* pRenderer, const QueryPoolDesc* pDesc, QueryPool** ppQueryPool)
+{
+	if (pDesc->mType == QUERY_TYPE_PIPELINE_STATISTICS && !pRenderer->mCapabilities.mPipelineStatisticsQuery)
+	{
+		SHEN_CORE_ERROR("pipeline statistics queries are not supported by {0}!", pRenderer->mCapabilities.mDeviceName);
+		throw std::runtime_error("pipeline statistics queries are not supported!");
+	}
+
+	VkQueryPoolCreateInfo queryPoolInfo{};
+	queryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	queryPoolInfo.queryCount = pDesc->mQueryCount;
+	uint32_t stride;
+	switch (pDesc->mType)
+	{
+	case QUERY_TYPE_TIMESTAMP:
+		queryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+		queryPoolInfo.queryCount = pDesc->mQueryCount * 2;
+		stride = 2 * sizeof(uint64_t);
+		break;
+	case QUERY_TYPE_OCCLUSION:
+		queryPoolInfo.queryType = VK_QUERY_TYPE_OCCLUSION;
+		stride = sizeof(uint64_t);
+		break;
+	case QUERY_TYPE_PIPELINE_STATISTICS:
+		queryPoolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+		queryPoolInfo.pipelineStatistics = PIPELINE_STATISTICS_FLAGS;
+		stride = sizeof(PipelineStatistics);
+		break;
+	default:
+		SHEN_CORE_ERROR("unknown query type {0}!", (uint32_t)pDesc->mType);
+		throw std::runtime_error("unknown query type!");
+	}
+
+	// 参数校验全部通过后才占用槽位, 之后唯一的失败点在归还槽位后抛出
+	QueryPoolHandle handle;
+	QueryPool* pQueryPool = pRenderer->pResources->mQueryPools.Allocate(&handle);
+	if (pRenderer->mVkDeviceTable.vkCreateQueryPool(pRenderer->pVkDevice, &queryPoolInfo, pRenderer->pVkAllocator, &pQueryPool->pVkQueryPool) != VK_SUCCESS)
+	{
+		pRenderer->pResources->mQueryPools.Release(handle);
+		SHEN_CORE_ERROR("failed to create query pool!");
+		throw std::runtime_error("failed to create query pool!");
+	}
+
+	pQueryPool->mStride = stride;
+	pQueryPool->mType = pDesc->mType;
+	pQueryPool->mCount = pDesc->mQueryCount;
+	*ppQueryPool = pQueryPool;
+}
+
+/// <summary>
+/// 按管线的描述符集布局分配描述符集, 每个集独占一个描述符池, 便于单独释放
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pDesc"></param>
+/// <param name="ppDescriptorSet"></param>
+void addDescriptorSet(Renderer* pRenderer, const DescriptorSetDesc* pDesc, DescriptorSet** ppDescriptorSet)
+{
+	Pipeline* pPipeline = pDesc->pPipeline;
+	if (!pPipeline->mVkDescriptorSetLayout)
+	{
+		SHEN_CORE_ERROR("pipeline has no descriptor set layout!");
+		throw std::runtime_error("pipeline has no descriptor set layout!");
+	}
+
+	VkDescriptorPoolSize poolSize{};
+	poolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+	poolSize.descriptorCount = pPipeline->mStorageBufferCount ? pPipeline->mStorageBufferCount : 1;
+	VkDescriptorPoolCreateInfo poolInfo{};
+	poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	poolInfo.maxSets = 1;
+	poolInfo.poolSizeCount = 1;
+	poolInfo.pPoolSizes = &poolSize;
+
+	DescriptorSetHandle handle;
+	DescriptorSet* pDescriptorSet = pRenderer->pResources->mDescriptorSets.Allocate(&handle);
+	if (pRenderer->mVkDeviceTable.vkCreateDescriptorPool(pRenderer->pVkDevice, &poolInfo, pRenderer->pVkAllocator, &pDescriptorSet->pVkDescriptorPool) != VK_SUCCESS)
+	{
+		pRenderer->pResources->mDescriptorSets.Release(handle);
+		SHEN_CORE_ERROR("failed to create descriptor pool!");
+		throw std::runtime_error("failed to create descriptor pool!");
+	}
+
+	VkDescriptorSetAllocateInfo allocInfo{};
+	allocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	allocInfo.descriptorPool = pDescriptorSet->pVkDescriptorPool;
+	allocInfo.descriptorSetCount = 1;
+	allocInfo.pSetLayouts = &pPipeline->mVkDescriptorSetLayout;
+	if (pRenderer->mVkDeviceTable.vkAllocateDescriptorSets(pRenderer->pVkDevice, &allocInfo, &pDescriptorSet->pVkDescriptorSet) != VK_SUCCESS)
+	{
+		pRenderer->mVkDeviceTable.vkDestroyDescriptorPool(pRenderer->pVkDevice, pDescriptorSet->pVkDescriptorPool, pRenderer->pVkAllocator);
+		pRenderer->pResources->mDescriptorSets.Release(handle);
+		SHEN_CORE_ERROR("failed to allocate descriptor set!");
+		throw std::runtime_error("failed to allocate descriptor set!");
+	}
+
+	pDescriptorSet->mVkPipelineLayout = pPipeline->mVkPipelineLayout;
+	pDescriptorSet->mBindPoint = pPipeline->mType == PIPELINE_TYPE_COMPUTE ? VK_PIPELINE_BIND_POINT_COMPUTE : VK_PIPELINE_BIND_POINT_GRAPHICS;
+	pDescriptorSet->mStorageBufferCount = pPipeline->mStorageBufferCount;
+	RENDERER_STATS_ADD(pRenderer, mDescriptorSetsAllocated, 1);
+	*ppDescriptorSet = pDescriptorSet;
+}
+
+/// <summary>
+/// 写入描述符集的存储缓冲, ppBuffers[i] 绑定到 binding i, 整个缓冲可见
+/// 调用前需确保 GPU 不再使用该描述符集
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pDescriptorSet"></param>
+/// <param name="bufferCount"></param>
+/// <param name="ppBuffers"></param>
+void updateDescriptorSet(Renderer* pRenderer, DescriptorSet* pDescriptorSet, uint32_t bufferCount, Buffer** ppBuffers)
+{
+	if (bufferCount > pDescriptorSet->mStorageBufferCount)
+	{
+		SHEN_CORE_ERROR("descriptor set has {0} storage buffer bindings, got {1}!", pDescriptorSet->mStorageBufferCount, bufferCount);
+		throw std::runtime_error("too many buffers for descriptor set!");
+	}
+
+	VkDescriptorBufferInfo bufferInfos[MAX_COMPUTE_STORAGE_BUFFERS] = {};
+	VkWriteDescriptorSet writes[MAX_COMPUTE_STORAGE_BUFFERS] = {};
+	for (uint32_t i = 0; i < bufferCount; ++i)
+	{
+		bufferInfos[i].buffer = ppBuffers[i]->pVkBuffer;
+		bufferInfos[i].offset = 0;
+		bufferInfos[i].range = VK_WHOLE_SIZE;
+		writes[i].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		writes[i].dstSet = pDescriptorSet->pVkDescriptorSet;
+		writes[i].dstBinding = i;
+		writes[i].descriptorCount = 1;
+		writes[i].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		writes[i].pBufferInfo = &bufferInfos[i];
+	}
+	pRenderer->mVkDeviceTable.vkUpdateDescriptorSets(pRenderer->pVkDevice, bufferCount, writes, 0, NULL);
+}
+
+/// <summary>
+/// 释放队列
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pQueue"></param>
+void removeQueue(Renderer* pRenderer, Queue* pQueue)
+{
+	exitGpuProfiler(pRenderer, pQueue);
+	pRenderer->pResources->mQueues.Release(pQueue);
+}
+
+/// <summary>
+/// 释放渲染通道
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pRenderPass"></param>
+void removeRenderPass(Renderer* pRenderer, RenderPass* pRenderPass)
+{
+	RenderPassHandle handle = pRenderer->pResources->mRenderPasses.GetHandle(pRenderPass);
+	pRenderer->mVkDeviceTable.vkDestroyRenderPass(pRenderer->pVkDevice, pRenderPass->pRenderPass, pRenderer->pVkAllocator);
+	pRenderer->pResources->mRenderPasses.Release(handle);
+}
+
+/// <summary>
+/// 释放管线
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pPipeline"></param>
+void removePipeline(Renderer* pRenderer, Pipeline* pPipeline)
+{
+	PipelineHandle handle = pRenderer->pResources->mPipelines.GetHandle(pPipeline);
+	pRenderer->mVkDeviceTable.vkDestroyPipeline(pRenderer->pVkDevice, pPipeline->pVkPipeline, pRenderer->pVkAllocator);
+	pRenderer->mVkDeviceTable.vkDestroyPipelineLayout(pRenderer->pVkDevice, pPipeline->mVkPipelineLayout, pRenderer->pVkAllocator);
+	pRenderer->mVkDeviceTable.vkDestroyDescriptorSetLayout(pRenderer->pVkDevice, pPipeline->mVkDescriptorSetLayout, pRenderer->pVkAllocator);
+	pRenderer->pResources->mPipelines.Release(handle);
+}
+
+/// <summary>
+/// 释放着色器, 管线创建完成后即可释放
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pShader"></param>
+void removeShader(Renderer* pRenderer, Shader* pShader)
+{
+	ShaderHandle handle = pRenderer->pResources->mShaders.GetHandle(pShader);
+	pRenderer->mVkDeviceTable.vkDestroyShaderModule(pRenderer->pVkDevice, pShader->pShaderModule, pRenderer->pVkAllocator);
+	pRenderer->pResources->mShaders.Release(handle);
+}
+
+/// <summary>
+/// 释放帧缓存
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pFrameBuffer"></param>
+void removeFrameBuffer(Renderer* pRenderer, FrameBuffer* pFrameBuffer)
+{
+	FrameBufferHandle handle = pRenderer->pResources->mFrameBuffers.GetHandle(pFrameBuffer);
+	pRenderer->mVkDeviceTable.vkDestroyFramebuffer(pRenderer->pVkDevice, pFrameBuffer->pFramebuffer, pRenderer->pVkAllocator);
+	pRenderer->pResources->mFrameBuffers.Release(handle);
+}
+
+/// <summary>
+/// 释放命令缓冲池
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pCmdPool"></param>
+void removeCmdPool(Renderer* pRenderer, CmdPool* pCmdPool)
+{
+	CmdPoolHandle handle = pRenderer->pResources->mCmdPools.GetHandle(pCmdPool);
+	pRenderer->mVkDeviceTable.vkDestroyCommandPool(pRenderer->pVkDevice, pCmdPool->pVkCmdPool, pRenderer->pVkAllocator);
+	pRenderer->pResources->mCmdPools.Release(handle);
+}
+
+/// <summary>
+/// 释放命令
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pCmd"></param>
+void removeCmd(Renderer* pRenderer, Cmd* pCmd)
+{
+	CmdHandle handle = pRenderer->pResources->mCmds.GetHandle(pCmd);
+	pRenderer->mVkDeviceTable.vkFreeCommandBuffers(pRenderer->pVkDevice, pCmd->pCmdPool->pVkCmdPool, 1, &pCmd->pVkCmdBuf);
+	pRenderer->pResources->mCmds.Release(handle);
+}
+
+/// <summary>
+/// 释放信号量
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pSemaphore"></param>
+void removeSemaphore(Renderer* pRenderer, Semaphore* pSemaphore)
+{
+	SemaphoreHandle handle = pRenderer->pResources->mSemaphores.GetHandle(pSemaphore);
+	pRenderer->mVkDeviceTable.vkDestroySemaphore(pRenderer->pVkDevice, pSemaphore->pVkSemaphore, pRenderer->pVkAllocator);
+	pRenderer->pResources->mSemaphores.Release(handle);
+}
+
+/// <summary>
+/// 释放栅栏
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pFence"></param>
+void removeFence(Renderer* pRenderer, Fence* pFence)
+{
+	FenceHandle handle = pRenderer->pResources->mFences.GetHandle(pFence);
+	pRenderer->mVkDeviceTable.vkDestroyFence(pRenderer->pVkDevice, pFence->pVkFence, pRenderer->pVkAllocator);
+	pRenderer->pResources->mFences.Release(handle);
+}
+
+/// <summary>
+/// 释放离屏渲染目标, 调用前需确保 GPU 不再使用
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pTexture"></param>
+void removeRenderTarget(Renderer* pRenderer, Texture* pTexture)
+{
+	TextureHandle handle = pRenderer->pResources->mTextures.GetHandle(pTexture);
+	pRenderer->mVkDeviceTable.vkDestroyImageView(pRenderer->pVkDevice, pTexture->pVkSRVDescriptor, pRenderer->pVkAllocator);
+	pRenderer->mVkDeviceTable.vkDestroyImage(pRenderer->pVkDevice, pTexture->pVkImage, pRenderer->pVkAllocator);
+	pRenderer->mVkDeviceTable.vkFreeMemory(pRenderer->pVkDevice, pTexture->pVkMemory, pRenderer->pVkAllocator);
+	// 图像销毁后, 以其视图为键缓存的帧缓存已经失效
+	resetFrameBufferCache(pRenderer);
+	pRenderer->pResources->mTextures.Release(handle);
+}
+
+/// <summary>
+/// 释放采样纹理, 调用前需确保 GPU 不再使用
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pTexture"></param>
+void removeTexture(Renderer* pRenderer, Texture* pTexture)
+{
+	TextureHandle handle = pRenderer->pResources->mTextures.GetHandle(pTexture);
+	pRenderer->mVkDeviceTable.vkDestroyImageView(pRenderer->pVkDevice, pTexture->pVkSRVDescriptor, pRenderer->pVkAllocator);
+	pRenderer->mVkDeviceTable.vkDestroyImage(pRenderer->pVkDevice, pTexture->pVkImage, pRenderer->pVkAllocator);
+	pRenderer->mVkDeviceTable.vkFreeMemory(pRenderer->pVkDevice, pTexture->pVkMemory, pRenderer->pVkAllocator);
+	pRenderer->pResources->mTextures.Release(handle);
+}
+
+/// <summary>
+/// 释放缓冲, 调用前需确保 GPU 不再使用
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pBuffer"></param>
+void removeBuffer(Renderer* pRenderer, Buffer* pBuffer)
+{
+	BufferHandle handle = pRenderer->pResources->mBuffers.GetHandle(pBuffer);
+	if (pBuffer->pCpuMappedAddress)
+		pRenderer->mVkDeviceTable.vkUnmapMemory(pRenderer->pVkDevice, pBuffer->pVkMemory);
+	pRenderer->mVkDeviceTable.vkDestroyBuffer(pRenderer->pVkDevice, pBuffer->pVkBuffer, pRenderer->pVkAllocator);
+	pRenderer->mVkDeviceTable.vkFreeMemory(pRenderer->pVkDevice, pBuffer->pVkMemory, pRenderer->pVkAllocator);
+	pRenderer->pResources->mBuffers.Release(handle);
+}
+
+/// <summary>
+/// 释放查询池, 调用前需确保 GPU 不再使用
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pQueryPool"></param>
+void removeQueryPool(Renderer* pRenderer, QueryPool* pQueryPool)
+{
+	QueryPoolHandle handle = pRenderer->pResources->mQueryPools.GetHandle(pQueryPool);
+	pRenderer->mVkDeviceTable.vkDestroyQueryPool(pRenderer->pVkDevice, pQueryPool->pVkQueryPool, pRenderer->pVkAllocator);
+	pRenderer->pResources->mQueryPools.Release(handle);
+}
+
+/// <summary>
+/// 释放描述符集及其独占的描述符池, 调用前需确保 GPU 不再使用
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pDescriptorSet"></param>
+void removeDescriptorSet(Renderer* pRenderer, DescriptorSet* pDescriptorSet)
+{
+	DescriptorSetHandle handle = pRenderer->pResources->mDescriptorSets.GetHandle(pDescriptorSet);
+	pRenderer->mVkDeviceTable.vkDestroyDescriptorPool(pRenderer->pVkDevice, pDescriptorSet->pVkDescriptorPool, pRenderer->pVkAllocator);
+	pRenderer->pResources->mDescriptorSets.Release(handle);
+}
+
+/*********  绘制图形部分函数 ***********/
 /***************************************/
 
 /// <summary>
-/// ȴդ
+/// 等待栅栏
 /// </summary>
 /// <param name="pRenderer"></param>
 /// <param name="fenceCount"></param>
 /// <param name="ppFences"></param>
 void waitForFences(Renderer* pRenderer, int32_t fenceCount, Fence** ppFences)
 {
-	VkFence* fences = (VkFence*)malloc(fenceCount * sizeof(VkFence));
+	SHEN_PROFILE_FUNCTION();
+	VkFence* fences = (VkFence*)alloca(fenceCount * sizeof(VkFence));
 	uint32_t numValidFences = 0;
 	for (size_t i = 0; i < fenceCount; i++)
 	{
 		if (ppFences[i]->mSubmitted)
 		{
-			fences[i] = ppFences[i]->pVkFence;
-			numValidFences++;
+			fences[numValidFences++] = ppFences[i]->pVkFence;
 		}
 	}
 	if (numValidFences)
 	{
-		if (vkWaitForFences(pRenderer->pVkDevice, numValidFences, fences, VK_TRUE, UINT64_MAX) != VK_SUCCESS)
+		if (pRenderer->mVkDeviceTable.vkWaitForFences(pRenderer->pVkDevice, numValidFences, fences, VK_TRUE, UINT64_MAX) != VK_SUCCESS)
 		{
 			SHEN_CORE_ERROR("failed to wait for fence!");
 		}
-		if (vkResetFences(pRenderer->pVkDevice, numValidFences, fences) != VK_SUCCESS)
+		if (pRenderer->mVkDeviceTable.vkResetFences(pRenderer->pVkDevice, numValidFences, fences) != VK_SUCCESS)
 		{
 			SHEN_CORE_ERROR("failed to reset fence!");
 		}
@@ -933,7 +2374,62 @@ void waitForFences(Renderer* pRenderer, int32_t fenceCount, Fence** ppFences)
 }
 
 /// <summary>
-/// ȡһ֡ͼ
+/// 查询栅栏状态, 不等待
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pFence"></param>
+/// <param name="pFenceStatus"></param>
+void getFenceStatus(Renderer* pRenderer, Fence* pFence, FenceStatus* pFenceStatus)
+{
+	if (!pFence->mSubmitted)
+	{
+		*pFenceStatus = FENCE_STATUS_NOTSUBMITTED;
+		return;
+	}
+	VkResult result = pRenderer->mVkDeviceTable.vkGetFenceStatus(pRenderer->pVkDevice, pFence->pVkFence);
+	if (result == VK_SUCCESS)
+	{
+		pRenderer->mVkDeviceTable.vkResetFences(pRenderer->pVkDevice, 1, &pFence->pVkFence);
+		pFence->mSubmitted = false;
+		*pFenceStatus = FENCE_STATUS_COMPLETE;
+		return;
+	}
+	if (result != VK_NOT_READY)
+		SHEN_CORE_ERROR("failed to get fence status!");
+	*pFenceStatus = FENCE_STATUS_INCOMPLETE;
+}
+
+/// <summary>
+/// 查询设备本地堆的预算与用量; 驱动每次调用都会刷新数值, 可以每帧调用
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pOutBudget"></param>
+/// <returns>设备不支持 VK_EXT_memory_budget 时返回 false</returns>
+bool getGpuMemoryBudget(Renderer* pRenderer, GpuMemoryBudget* pOutBudget)
+{
+	memset(pOutBudget, 0, sizeof(GpuMemoryBudget));
+	if (!pRenderer->mCapabilities.mMemoryBudget)
+		return false;
+
+	VkPhysicalDeviceMemoryBudgetPropertiesEXT budgetProperties{};
+	budgetProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+	VkPhysicalDeviceMemoryProperties2 memoryProperties{};
+	memoryProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2;
+	memoryProperties.pNext = &budgetProperties;
+	vkGetPhysicalDeviceMemoryProperties2(pRenderer->pVkActiveGPU, &memoryProperties);
+	for (uint32_t i = 0; i < memoryProperties.memoryProperties.memoryHeapCount; ++i)
+	{
+		if (memoryProperties.memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT)
+		{
+			pOutBudget->mBudget += budgetProperties.heapBudget[i];
+			pOutBudget->mUsage += budgetProperties.heapUsage[i];
+		}
+	}
+	return true;
+}
+
+/// <summary>
+/// 获取下一帧图像
 /// </summary>
 /// <param name="pRenderer"></param>
 /// <param name="pSwapChain"></param>
@@ -942,12 +2438,13 @@ void waitForFences(Renderer* pRenderer, int32_t fenceCount, Fence** ppFences)
 /// <param name="pImageIndex"></param>
 void acquireNextImage(Renderer* pRenderer, SwapChain* pSwapChain, Semaphore* pSignalSemaphore, Fence* pFence, uint32_t* pImageIndex)
 {
+	SHEN_PROFILE_FUNCTION();
 	VkResult vk_res = {};
-	vk_res = vkAcquireNextImageKHR(pRenderer->pVkDevice, pSwapChain->pSwapChain, UINT64_MAX, pSignalSemaphore->pVkSemaphore, VK_NULL_HANDLE, pImageIndex);
+	vk_res = pRenderer->mVkDeviceTable.vkAcquireNextImageKHR(pRenderer->pVkDevice, pSwapChain->pSwapChain, UINT64_MAX, pSignalSemaphore->pVkSemaphore, VK_NULL_HANDLE, pImageIndex);
 	if (vk_res == VK_ERROR_OUT_OF_DATE_KHR)
 	{
 		*pImageIndex = -1;
-		vkResetFences(pRenderer->pVkDevice, 1, &pFence->pVkFence);
+		pRenderer->mVkDeviceTable.vkResetFences(pRenderer->pVkDevice, 1, &pFence->pVkFence);
 		pFence->mSubmitted = false;
 		return;
 	}
@@ -955,24 +2452,25 @@ void acquireNextImage(Renderer* pRenderer, SwapChain* pSwapChain, Semaphore* pSi
 }
 
 /// <summary>
-/// ʼ¼ָ
+/// 开始录制指令
 /// </summary>
 /// <param name="pCmd"></param>
 void beginCmd(Cmd* pCmd)
 {
+	SHEN_PROFILE_FUNCTION();
 	VkCommandBufferBeginInfo begin_info{};
 	begin_info.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
 	begin_info.pNext = NULL;
 	begin_info.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
 	begin_info.pInheritanceInfo = NULL;
 
-	if (vkBeginCommandBuffer(pCmd->pVkCmdBuf, &begin_info) != VK_SUCCESS) {
+	if (pCmd->pVkDeviceTable->vkBeginCommandBuffer(pCmd->pVkCmdBuf, &begin_info) != VK_SUCCESS) {
 		SHEN_CORE_ERROR("failed to begin recording command buffer!");
 		throw std::runtime_error("failed to begin recording command buffer!");
 	}
 }
 
-// ָ󶨵Ⱦͨ
+// 指令绑定到渲染子通道
 void cmdBindRenderPass(Cmd* pCmd, RenderPass* pRenderPass, FrameBuffer* pFrameBuffer)
 {
 	VkRenderPassBeginInfo renderPassInfo{};
@@ -986,23 +2484,50 @@ void cmdBindRenderPass(Cmd* pCmd, RenderPass* pRenderPass, FrameBuffer* pFrameBu
 	VkClearValue clearColor = { {{0.0f, 0.0f, 0.0f, 1.0f}} };
 	renderPassInfo.clearValueCount = 1;
 	renderPassInfo.pClearValues = &clearColor;
-	vkCmdBeginRenderPass(pCmd->pVkCmdBuf, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	pCmd->pVkDeviceTable->vkCmdBeginRenderPass(pCmd->pVkCmdBuf, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	RENDERER_STATS_ADD(pCmd->pRenderer, mRenderPasses, 1);
 
 	pCmd->pVkActiveRenderPass = pRenderPass->pRenderPass;
 }
 
 /// <summary>
-/// ָ󶨵
+/// 指令绑定到管线
 /// </summary>
 /// <param name="pCmd"></param>
 /// <param name="pPipeline"></param>
 void cmdBindPipeline(Cmd* pCmd, Pipeline* pPipeline)
 {
-	vkCmdBindPipeline(pCmd->pVkCmdBuf, VK_PIPELINE_BIND_POINT_GRAPHICS, pPipeline->pVkPipeline);
+	bool compute = pPipeline->mType == PIPELINE_TYPE_COMPUTE;
+	pCmd->pVkDeviceTable->vkCmdBindPipeline(pCmd->pVkCmdBuf, compute ? VK_PIPELINE_BIND_POINT_COMPUTE : VK_PIPELINE_BIND_POINT_GRAPHICS, pPipeline->pVkPipeline);
+	pCmd->pBoundPipelineLayout = pPipeline->mVkPipelineLayout;
+	pCmd->mBoundPushConstantStages = compute ? VK_SHADER_STAGE_COMPUTE_BIT : PUSH_CONSTANT_STAGES;
+	RENDERER_STATS_ADD(pCmd->pRenderer, mPipelineBinds, 1);
 }
 
 /// <summary>
-/// ָӿ
+/// 绑定描述符集到 set 0, 绑定点与管线布局取自分配时的管线
+/// </summary>
+/// <param name="pCmd"></param>
+/// <param name="pDescriptorSet"></param>
+void cmdBindDescriptorSet(Cmd* pCmd, DescriptorSet* pDescriptorSet)
+{
+	pCmd->pVkDeviceTable->vkCmdBindDescriptorSets(pCmd->pVkCmdBuf, pDescriptorSet->mBindPoint, pDescriptorSet->mVkPipelineLayout, 0, 1, &pDescriptorSet->pVkDescriptorSet, 0, NULL);
+	RENDERER_STATS_ADD(pCmd->pRenderer, mDescriptorBinds, 1);
+}
+
+/// <summary>
+/// 写入推送常量, 使用最近一次 cmdBindPipeline 绑定的管线布局
+/// </summary>
+/// <param name="pCmd"></param>
+/// <param name="pData"></param>
+/// <param name="size"></param>
+void cmdPushConstants(Cmd* pCmd, const void* pData, uint32_t size)
+{
+	pCmd->pVkDeviceTable->vkCmdPushConstants(pCmd->pVkCmdBuf, pCmd->pBoundPipelineLayout, pCmd->mBoundPushConstantStages, 0, size, pData);
+}
+
+/// <summary>
+/// 指令视口设置
 /// </summary>
 /// <param name="pCmd"></param>
 /// <param name="x"></param>
@@ -1020,11 +2545,11 @@ void cmdSetViewport(Cmd* pCmd, float x, float y, float width, float height, floa
 	viewport.height = height;
 	viewport.minDepth = minDepth;
 	viewport.maxDepth = maxDepth;
-	vkCmdSetViewport(pCmd->pVkCmdBuf, 0, 1, &viewport);
+	pCmd->pVkDeviceTable->vkCmdSetViewport(pCmd->pVkCmdBuf, 0, 1, &viewport);
 }
 
 /// <summary>
-/// ָӿڲ
+/// 设置指令视口裁切
 /// </summary>
 /// <param name="pCmd"></param>
 /// <param name="x"></param>
@@ -1038,34 +2563,551 @@ void cmdSetScissor(Cmd* pCmd, uint32_t x, uint32_t y, uint32_t width, uint32_t h
 	scissor.offset.y = y;
 	scissor.extent.width = width;
 	scissor.extent.height = height;
-	vkCmdSetScissor(pCmd->pVkCmdBuf, 0, 1, &scissor);
+	pCmd->pVkDeviceTable->vkCmdSetScissor(pCmd->pVkCmdBuf, 0, 1, &scissor);
+}
+
+/// <summary>
+/// 结束当前渲染通道
+/// </summary>
+/// <param name="pCmd"></param>
+void cmdEndRenderPass(Cmd* pCmd)
+{
+	if (pCmd->pVkActiveRenderPass)
+	{
+		pCmd->pVkDeviceTable->vkCmdEndRenderPass(pCmd->pVkCmdBuf);
+		pCmd->pVkActiveRenderPass = VK_NULL_HANDLE;
+	}
+}
+
+static void getLayoutTransitionMasks(VkImageLayout layout, VkPipelineStageFlags* pStage, VkAccessFlags* pAccess)
+{
+	switch (layout)
+	{
+	case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+		*pStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+		*pAccess = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+		break;
+	case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+		*pStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+		*pAccess = VK_ACCESS_SHADER_READ_BIT;
+		break;
+	case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+		*pStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		*pAccess = VK_ACCESS_TRANSFER_READ_BIT;
+		break;
+	case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+		*pStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+		*pAccess = VK_ACCESS_TRANSFER_WRITE_BIT;
+		break;
+	case VK_IMAGE_LAYOUT_PRESENT_SRC_KHR:
+		*pStage = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+		*pAccess = 0;
+		break;
+	default:
+		*pStage = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+		*pAccess = 0;
+		break;
+	}
+}
+
+static void recordMipLayoutTransition(Cmd* pCmd, Texture* pTexture, uint32_t baseMipLevel, uint32_t mipLevelCount,
+	VkImageLayout oldLayout, VkImageLayout newLayout)
+{
+	VkImageMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	barrier.oldLayout = oldLayout;
+	barrier.newLayout = newLayout;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.image = pTexture->pVkImage;
+	barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	barrier.subresourceRange.baseMipLevel = baseMipLevel;
+	barrier.subresourceRange.levelCount = mipLevelCount;
+	barrier.subresourceRange.baseArrayLayer = 0;
+	barrier.subresourceRange.layerCount = VK_REMAINING_ARRAY_LAYERS;
+
+	VkPipelineStageFlags srcStage, dstStage;
+	getLayoutTransitionMasks(oldLayout, &srcStage, &barrier.srcAccessMask);
+	getLayoutTransitionMasks(newLayout, &dstStage, &barrier.dstAccessMask);
+	// 交换链图像由获取信号量在 COLOR_ATTACHMENT_OUTPUT 阶段等待, 从呈现布局转出时与该阶段同步
+	if (oldLayout == VK_IMAGE_LAYOUT_PRESENT_SRC_KHR || oldLayout == VK_IMAGE_LAYOUT_UNDEFINED)
+		srcStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+	pCmd->pVkDeviceTable->vkCmdPipelineBarrier(pCmd->pVkCmdBuf, srcStage, dstStage, 0, 0, NULL, 0, NULL, 1, &barrier);
+	RENDERER_STATS_ADD(pCmd->pRenderer, mBarriers, 1);
+}
+
+static void recordImageLayoutTransition(Cmd* pCmd, Texture* pTexture, VkImageLayout oldLayout, VkImageLayout newLayout)
+{
+	recordMipLayoutTransition(pCmd, pTexture, 0, VK_REMAINING_MIP_LEVELS, oldLayout, newLayout);
+	pTexture->mCurrentLayout = newLayout;
+}
+
+/// <summary>
+/// 图像布局转换
+/// </summary>
+/// <param name="pCmd"></param>
+/// <param name="pTexture"></param>
+/// <param name="newLayout"></param>
+void cmdTextureBarrier(Cmd* pCmd, Texture* pTexture, VkImageLayout newLayout)
+{
+	if (pTexture->mCurrentLayout == newLayout)
+		return;
+	recordImageLayoutTransition(pCmd, pTexture, pTexture->mCurrentLayout, newLayout);
+}
+
+/// <summary>
+/// 缓冲内存屏障
+/// </summary>
+/// <param name="pCmd"></param>
+/// <param name="pBuffer"></param>
+/// <param name="srcStage"></param>
+/// <param name="srcAccess"></param>
+/// <param name="dstStage"></param>
+/// <param name="dstAccess"></param>
+void cmdBufferBarrier(Cmd* pCmd, Buffer* pBuffer, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess)
+{
+	VkBufferMemoryBarrier barrier{};
+	barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+	barrier.srcAccessMask = srcAccess;
+	barrier.dstAccessMask = dstAccess;
+	barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	barrier.buffer = pBuffer->pVkBuffer;
+	barrier.offset = 0;
+	barrier.size = VK_WHOLE_SIZE;
+	pCmd->pVkDeviceTable->vkCmdPipelineBarrier(pCmd->pVkCmdBuf, srcStage, dstStage, 0, 0, NULL, 1, &barrier, 0, NULL);
+	RENDERER_STATS_ADD(pCmd->pRenderer, mBarriers, 1);
+}
+
+/// <summary>
+/// 缓冲间拷贝
+/// </summary>
+/// <param name="pCmd"></param>
+/// <param name="pDstBuffer"></param>
+/// <param name="dstOffset"></param>
+/// <param name="pSrcBuffer"></param>
+/// <param name="srcOffset"></param>
+/// <param name="size"></param>
+void cmdCopyBuffer(Cmd* pCmd, Buffer* pDstBuffer, uint64_t dstOffset, Buffer* pSrcBuffer, uint64_t srcOffset, uint64_t size)
+{
+	VkBufferCopy region{};
+	region.srcOffset = srcOffset;
+	region.dstOffset = dstOffset;
+	region.size = size;
+	pCmd->pVkDeviceTable->vkCmdCopyBuffer(pCmd->pVkCmdBuf, pSrcBuffer->pVkBuffer, pDstBuffer->pVkBuffer, 1, &region);
+	if (pSrcBuffer->mMemoryUsage == RESOURCE_MEMORY_USAGE_CPU_TO_GPU)
+		RENDERER_STATS_ADD(pCmd->pRenderer, mBytesUploaded, size);
+}
+
+// 上传统计用的层级字节数, 只覆盖纹理常用的格式; 块压缩格式按 4x4 块计算
+static uint64_t getTextureLevelSize(VkFormat format, uint32_t width, uint32_t height)
+{
+	uint64_t blocks = (uint64_t)((width + 3) / 4) * ((height + 3) / 4);
+	switch (format)
+	{
+	case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		return blocks * 8;
+	case VK_FORMAT_BC3_UNORM_BLOCK:
+	case VK_FORMAT_BC3_SRGB_BLOCK:
+	case VK_FORMAT_BC5_UNORM_BLOCK:
+	case VK_FORMAT_BC7_UNORM_BLOCK:
+	case VK_FORMAT_BC7_SRGB_BLOCK:
+		return blocks * 16;
+	case VK_FORMAT_R8_UNORM:
+		return (uint64_t)width * height;
+	case VK_FORMAT_R8G8_UNORM:
+		return (uint64_t)width * height * 2;
+	case VK_FORMAT_R16G16B16A16_SFLOAT:
+		return (uint64_t)width * height * 8;
+	case VK_FORMAT_R32G32B32A32_SFLOAT:
+		return (uint64_t)width * height * 16;
+	default:
+		return (uint64_t)width * height * 4;
+	}
+}
+
+/// <summary>
+/// 从缓冲拷贝像素到纹理的一个 mip 层级, 缓冲中的行 (块压缩格式为块行) 紧密排列
+/// </summary>
+/// <param name="pCmd"></param>
+/// <param name="pTexture"></param>
+/// <param name="mipLevel"></param>
+/// <param name="pSrcBuffer"></param>
+/// <param name="srcOffset"></param>
+void cmdCopyBufferToTexture(Cmd* pCmd, Texture* pTexture, uint32_t mipLevel, Buffer* pSrcBuffer, uint64_t srcOffset)
+{
+	VkBufferImageCopy region{};
+	region.bufferOffset = srcOffset;
+	region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+	region.imageSubresource.mipLevel = mipLevel;
+	region.imageSubresource.layerCount = 1;
+	region.imageExtent = { std::max(pTexture->mWidth >> mipLevel, 1u), std::max(pTexture->mHeight >> mipLevel, 1u), 1 };
+	pCmd->pVkDeviceTable->vkCmdCopyBufferToImage(pCmd->pVkCmdBuf, pSrcBuffer->pVkBuffer, pTexture->pVkImage,
+		VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &region);
+	if (pSrcBuffer->mMemoryUsage == RESOURCE_MEMORY_USAGE_CPU_TO_GPU)
+		RENDERER_STATS_ADD(pCmd->pRenderer, mBytesUploaded, getTextureLevelSize(pTexture->mFormat, region.imageExtent.width, region.imageExtent.height));
+}
+
+/// <summary>
+/// 逐级 blit 生成 mip 链: 层级 i - 1 转为 TRANSFER_SRC 后线性过滤缩小到层级 i
+/// 只在同一条命令内串行依赖, 不需要 CPU 参与; 纹理格式需支持线性过滤的 blit (RGBA8 UNORM/SRGB 为必须支持的格式)
+/// </summary>
+/// <param name="pCmd"></param>
+/// <param name="pTexture"></param>
+void cmdGenerateMipmaps(Cmd* pCmd, Texture* pTexture)
+{
+	int32_t width = (int32_t)pTexture->mWidth;
+	int32_t height = (int32_t)pTexture->mHeight;
+	for (uint32_t level = 1; level < pTexture->mMipLevels; ++level)
+	{
+		recordMipLayoutTransition(pCmd, pTexture, level - 1, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL);
+
+		VkImageBlit blit{};
+		blit.srcSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.srcSubresource.mipLevel = level - 1;
+		blit.srcSubresource.layerCount = 1;
+		blit.srcOffsets[1] = { width, height, 1 };
+		width = std::max(width / 2, 1);
+		height = std::max(height / 2, 1);
+		blit.dstSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+		blit.dstSubresource.mipLevel = level;
+		blit.dstSubresource.layerCount = 1;
+		blit.dstOffsets[1] = { width, height, 1 };
+		pCmd->pVkDeviceTable->vkCmdBlitImage(pCmd->pVkCmdBuf, pTexture->pVkImage, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+			pTexture->pVkImage, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &blit, VK_FILTER_LINEAR);
+	}
+
+	// 除最后一级外都已转为 TRANSFER_SRC
+	uint32_t lastLevel = pTexture->mMipLevels - 1;
+	if (lastLevel > 0)
+		recordMipLayoutTransition(pCmd, pTexture, 0, lastLevel, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	recordMipLayoutTransition(pCmd, pTexture, lastLevel, 1, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	pTexture->mCurrentLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+}
+
+/// <summary>
+/// 开始渲染到指定附件
+/// </summary>
+/// <param name="pCmd"></param>
+/// <param name="pDesc"></param>
+void cmdBeginRendering(Cmd* pCmd, const RenderingDesc* pDesc)
+{
+	SHEN_PROFILE_FUNCTION();
+	// 结束上一次渲染
+	cmdEndRendering(pCmd);
+
+	uint32_t colorCount = pDesc->mColorAttachmentCount;
+	if (colorCount == 0 || colorCount > MAX_RENDER_TARGET_ATTACHMENTS)
+	{
+		SHEN_CORE_ERROR("invalid color attachment count {0}!", colorCount);
+		throw std::runtime_error("invalid color attachment count!");
+	}
+
+	Renderer* pRenderer = pCmd->pRenderer;
+	VkRect2D renderArea = {};
+	renderArea.extent.width = pDesc->mColorAttachments[0].pTexture->mWidth;
+	renderArea.extent.height = pDesc->mColorAttachments[0].pTexture->mHeight;
+
+	if (pRenderer->mCapabilities.mDynamicRendering && !pDesc->mUseRenderPass)
+	{
+		VkRenderingAttachmentInfoKHR colorAttachments[MAX_RENDER_TARGET_ATTACHMENTS] = {};
+		for (uint32_t i = 0; i < colorCount; ++i)
+		{
+			const RenderTargetBindDesc* pBind = &pDesc->mColorAttachments[i];
+			// 不保留原内容时从 UNDEFINED 转换, 驱动可以跳过数据保留
+			if (pBind->mLoadOp != VK_ATTACHMENT_LOAD_OP_LOAD)
+				recordImageLayoutTransition(pCmd, pBind->pTexture, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+			else
+				cmdTextureBarrier(pCmd, pBind->pTexture, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL);
+
+			colorAttachments[i].sType = VK_STRUCTURE_TYPE_RENDERING_ATTACHMENT_INFO_KHR;
+			colorAttachments[i].imageView = pBind->pTexture->pVkSRVDescriptor;
+			colorAttachments[i].imageLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+			colorAttachments[i].resolveMode = VK_RESOLVE_MODE_NONE;
+			colorAttachments[i].loadOp = pBind->mLoadOp;
+			colorAttachments[i].storeOp = pBind->mStoreOp;
+			colorAttachments[i].clearValue = pBind->mClearValue;
+		}
+
+		VkRenderingInfoKHR renderingInfo{};
+		renderingInfo.sType = VK_STRUCTURE_TYPE_RENDERING_INFO_KHR;
+		renderingInfo.renderArea = renderArea;
+		renderingInfo.layerCount = 1;
+		renderingInfo.colorAttachmentCount = colorCount;
+		renderingInfo.pColorAttachments = colorAttachments;
+		pCmd->pVkDeviceTable->vkCmdBeginRendering(pCmd->pVkCmdBuf, &renderingInfo);
+		RENDERER_STATS_ADD(pRenderer, mRenderPasses, 1);
+		pCmd->mDynamicRenderingActive = 1;
+		return;
+	}
+
+	// 渲染通道路径: 布局转换由渲染通道完成, 签名中记录初始布局
+	RenderPassSignature renderPassSignature;
+	memset(&renderPassSignature, 0, sizeof(renderPassSignature));
+	FrameBufferSignature frameBufferSignature;
+	memset(&frameBufferSignature, 0, sizeof(frameBufferSignature));
+	VkClearValue clearValues[MAX_RENDER_TARGET_ATTACHMENTS];
+
+	renderPassSignature.mColorCount = colorCount;
+	for (uint32_t i = 0; i < colorCount; ++i)
+	{
+		const RenderTargetBindDesc* pBind = &pDesc->mColorAttachments[i];
+		renderPassSignature.mColorFormats[i] = pBind->pTexture->mFormat;
+		renderPassSignature.mInitialLayouts[i] = pBind->mLoadOp == VK_ATTACHMENT_LOAD_OP_LOAD ? pBind->pTexture->mCurrentLayout : VK_IMAGE_LAYOUT_UNDEFINED;
+		renderPassSignature.mLoadOps[i] = (uint32_t)pBind->mLoadOp;
+		renderPassSignature.mStoreOps[i] = (uint32_t)pBind->mStoreOp;
+		frameBufferSignature.pAttachments[i] = pBind->pTexture->pVkSRVDescriptor;
+		clearValues[i] = pBind->mClearValue;
+		pBind->pTexture->mCurrentLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+	}
+
+	VkRenderPass renderPass = findOrCreateRenderPass(pRenderer, &renderPassSignature);
+	frameBufferSignature.pRenderPass = renderPass;
+	frameBufferSignature.mAttachmentCount = colorCount;
+	frameBufferSignature.mWidth = renderArea.extent.width;
+	frameBufferSignature.mHeight = renderArea.extent.height;
+	VkFramebuffer framebuffer = findOrCreateFrameBuffer(pRenderer, &frameBufferSignature);
+
+	VkRenderPassBeginInfo renderPassInfo{};
+	renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	renderPassInfo.renderPass = renderPass;
+	renderPassInfo.framebuffer = framebuffer;
+	renderPassInfo.renderArea = renderArea;
+	renderPassInfo.clearValueCount = colorCount;
+	renderPassInfo.pClearValues = clearValues;
+	pCmd->pVkDeviceTable->vkCmdBeginRenderPass(pCmd->pVkCmdBuf, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	RENDERER_STATS_ADD(pRenderer, mRenderPasses, 1);
+	pCmd->pVkActiveRenderPass = renderPass;
+}
+
+/// <summary>
+/// 结束渲染
+/// </summary>
+/// <param name="pCmd"></param>
+void cmdEndRendering(Cmd* pCmd)
+{
+	if (pCmd->mDynamicRenderingActive)
+	{
+		pCmd->pVkDeviceTable->vkCmdEndRendering(pCmd->pVkCmdBuf);
+		pCmd->mDynamicRenderingActive = 0;
+	}
+	cmdEndRenderPass(pCmd);
 }
 
 /// <summary>
-/// ָ
+/// 指令绘制
 /// </summary>
 /// <param name="pCmd"></param>
 /// <param name="vertex_count"></param>
 /// <param name="first_vertex"></param>
 void cmdDraw(Cmd* pCmd, uint32_t vertex_count, uint32_t first_vertex)
 {
-	vkCmdDraw(pCmd->pVkCmdBuf, vertex_count, 1, first_vertex, 0);
+	pCmd->pVkDeviceTable->vkCmdDraw(pCmd->pVkCmdBuf, vertex_count, 1, first_vertex, 0);
+	RENDERER_STATS_ADD(pCmd->pRenderer, mDrawCalls, 1);
+	RENDERER_STATS_ADD(pCmd->pRenderer, mVertices, vertex_count);
+	RENDERER_STATS_ADD(pCmd->pRenderer, mInstances, 1);
 }
 
 /// <summary>
-/// ָ
+/// 绑定顶点缓冲
 /// </summary>
 /// <param name="pCmd"></param>
-void endCmd(Cmd* pCmd)
+/// <param name="pBuffer"></param>
+/// <param name="offset"></param>
+void cmdBindVertexBuffer(Cmd* pCmd, Buffer* pBuffer, uint64_t offset)
 {
-	if (pCmd->pVkActiveRenderPass)
+	VkDeviceSize vkOffset = offset;
+	pCmd->pVkDeviceTable->vkCmdBindVertexBuffers(pCmd->pVkCmdBuf, 0, 1, &pBuffer->pVkBuffer, &vkOffset);
+	RENDERER_STATS_ADD(pCmd->pRenderer, mBufferBinds, 1);
+}
+
+/// <summary>
+/// 绑定索引缓冲
+/// </summary>
+/// <param name="pCmd"></param>
+/// <param name="pBuffer"></param>
+/// <param name="offset"></param>
+/// <param name="indexType"></param>
+void cmdBindIndexBuffer(Cmd* pCmd, Buffer* pBuffer, uint64_t offset, VkIndexType indexType)
+{
+	pCmd->pVkDeviceTable->vkCmdBindIndexBuffer(pCmd->pVkCmdBuf, pBuffer->pVkBuffer, offset, indexType);
+	RENDERER_STATS_ADD(pCmd->pRenderer, mBufferBinds, 1);
+}
+
+/// <summary>
+/// 索引绘制
+/// </summary>
+/// <param name="pCmd"></param>
+/// <param name="indexCount"></param>
+/// <param name="firstIndex"></param>
+/// <param name="vertexOffset"></param>
+void cmdDrawIndexed(Cmd* pCmd, uint32_t indexCount, uint32_t firstIndex, int32_t vertexOffset)
+{
+	pCmd->pVkDeviceTable->vkCmdDrawIndexed(pCmd->pVkCmdBuf, indexCount, 1, firstIndex, vertexOffset, 0);
+	RENDERER_STATS_ADD(pCmd->pRenderer, mDrawCalls, 1);
+	RENDERER_STATS_ADD(pCmd->pRenderer, mVertices, indexCount);
+	RENDERER_STATS_ADD(pCmd->pRenderer, mInstances, 1);
+}
+
+/// <summary>
+/// 间接索引绘制, 绘制参数由缓冲提供 (可由 CPU 剔除写入或由计算着色器生成)
+/// 绘制数按 drawCount 计入统计, 顶点与实例数在录制时未知, 不计入
+/// </summary>
+/// <param name="pCmd"></param>
+/// <param name="pBuffer"></param>
+/// <param name="offset"></param>
+/// <param name="drawCount"></param>
+/// <param name="stride"></param>
+void cmdDrawIndexedIndirect(Cmd* pCmd, Buffer* pBuffer, uint64_t offset, uint32_t drawCount, uint32_t stride)
+{
+	if (!drawCount)
+		return;
+
+	if (pCmd->pRenderer->mCapabilities.mMultiDrawIndirect || drawCount == 1)
+	{
+		pCmd->pVkDeviceTable->vkCmdDrawIndexedIndirect(pCmd->pVkCmdBuf, pBuffer->pVkBuffer, offset, drawCount, stride);
+	}
+	else
+	{
+		for (uint32_t i = 0; i < drawCount; ++i)
+			pCmd->pVkDeviceTable->vkCmdDrawIndexedIndirect(pCmd->pVkCmdBuf, pBuffer->pVkBuffer, offset + (uint64_t)i * stride, 1, stride);
+	}
+	RENDERER_STATS_ADD(pCmd->pRenderer, mDrawCalls, drawCount);
+}
+
+/// <summary>
+/// 分派计算着色器, 需先绑定计算管线与描述符集
+/// </summary>
+/// <param name="pCmd"></param>
+/// <param name="groupCountX"></param>
+/// <param name="groupCountY"></param>
+/// <param name="groupCountZ"></param>
+void cmdDispatch(Cmd* pCmd, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ)
+{
+	if (!groupCountX || !groupCountY || !groupCountZ)
+		return;
+	pCmd->pVkDeviceTable->vkCmdDispatch(pCmd->pVkCmdBuf, groupCountX, groupCountY, groupCountZ);
+	RENDERER_STATS_ADD(pCmd->pRenderer, mDispatchCalls, 1);
+}
+
+/// <summary>
+/// 重置查询, 时间戳查询按每个查询两个时间戳换算
+/// </summary>
+/// <param name="pCmd"></param>
+/// <param name="pQueryPool"></param>
+/// <param name="startQuery"></param>
+/// <param name="queryCount"></param>
+void cmdResetQueryPool(Cmd* pCmd, QueryPool* pQueryPool, uint32_t startQuery, uint32_t queryCount)
+{
+	uint32_t scale = pQueryPool->mType == QUERY_TYPE_TIMESTAMP ? 2 : 1;
+	pCmd->pVkDeviceTable->vkCmdResetQueryPool(pCmd->pVkCmdBuf, pQueryPool->pVkQueryPool, startQuery * scale, queryCount * scale);
+}
+
+/// <summary>
+/// 开始查询; 时间戳查询在此写入开始时间戳
+/// </summary>
+/// <param name="pCmd"></param>
+/// <param name="pQueryPool"></param>
+/// <param name="pQuery"></param>
+void cmdBeginQuery(Cmd* pCmd, QueryPool* pQueryPool, const QueryDesc* pQuery)
+{
+	if (pQueryPool->mType == QUERY_TYPE_TIMESTAMP)
+	{
+		pCmd->pVkDeviceTable->vkCmdWriteTimestamp(pCmd->pVkCmdBuf, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, pQueryPool->pVkQueryPool, pQuery->mIndex * 2);
+		return;
+	}
+	pCmd->pVkDeviceTable->vkCmdBeginQuery(pCmd->pVkCmdBuf, pQueryPool->pVkQueryPool, pQuery->mIndex, 0);
+}
+
+/// <summary>
+/// 结束查询; 时间戳查询在此写入结束时间戳
+/// </summary>
+/// <param name="pCmd"></param>
+/// <param name="pQueryPool"></param>
+/// <param name="pQuery"></param>
+void cmdEndQuery(Cmd* pCmd, QueryPool* pQueryPool, const QueryDesc* pQuery)
+{
+	if (pQueryPool->mType == QUERY_TYPE_TIMESTAMP)
+	{
+		pCmd->pVkDeviceTable->vkCmdWriteTimestamp(pCmd->pVkCmdBuf, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, pQueryPool->pVkQueryPool, pQuery->mIndex * 2 + 1);
+		return;
+	}
+	pCmd->pVkDeviceTable->vkCmdEndQuery(pCmd->pVkCmdBuf, pQueryPool->pVkQueryPool, pQuery->mIndex);
+}
+
+/// <summary>
+/// 将查询结果拷贝到回读缓冲中 startQuery * mStride 的位置
+/// WAIT_BIT 只让 GPU 在拷贝前等待结果可用, CPU 不会阻塞; 随后的屏障使结果对主机读取可见
+/// </summary>
+/// <param name="pCmd"></param>
+/// <param name="pQueryPool"></param>
+/// <param name="pReadbackBuffer"></param>
+/// <param name="startQuery"></param>
+/// <param name="queryCount"></param>
+void cmdResolveQuery(Cmd* pCmd, QueryPool* pQueryPool, Buffer* pReadbackBuffer, uint32_t startQuery, uint32_t queryCount)
+{
+	VkDeviceSize offset = (VkDeviceSize)startQuery * pQueryPool->mStride;
+	VkDeviceSize size = (VkDeviceSize)queryCount * pQueryPool->mStride;
+	if (offset + size > pReadbackBuffer->mSize)
 	{
-		vkCmdEndRenderPass(pCmd->pVkCmdBuf);
+		SHEN_CORE_ERROR("query readback buffer is too small: {0} bytes needed, {1} available!", offset + size, pReadbackBuffer->mSize);
+		throw std::runtime_error("query readback buffer is too small!");
 	}
 
-	pCmd->pVkActiveRenderPass = VK_NULL_HANDLE;
+	uint32_t scale = pQueryPool->mType == QUERY_TYPE_TIMESTAMP ? 2 : 1;
+	pCmd->pVkDeviceTable->vkCmdCopyQueryPoolResults(pCmd->pVkCmdBuf, pQueryPool->pVkQueryPool, startQuery * scale, queryCount * scale,
+		pReadbackBuffer->pVkBuffer, offset, pQueryPool->mStride / scale, VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT);
 
-	if (vkEndCommandBuffer(pCmd->pVkCmdBuf) != VK_SUCCESS)
+	cmdBufferBarrier(pCmd, pReadbackBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_HOST_BIT, VK_ACCESS_HOST_READ_BIT);
+}
+
+/// <summary>
+/// 从回读缓冲解码查询结果
+/// 缓冲内容在对应提交的栅栏完成后才有效; 每个在途帧应使用各自的回读缓冲 (或缓冲的不同区间), 避免读取到正在写入的数据
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pQueryPool"></param>
+/// <param name="pReadbackBuffer"></param>
+/// <param name="queryIndex"></param>
+/// <param name="pOutResult"></param>
+void getQueryResult(Renderer* pRenderer, const QueryPool* pQueryPool, const Buffer* pReadbackBuffer, uint32_t queryIndex, QueryResult* pOutResult)
+{
+	memset(pOutResult, 0, sizeof(*pOutResult));
+	const uint8_t* pData = (const uint8_t*)pReadbackBuffer->pCpuMappedAddress + (size_t)queryIndex * pQueryPool->mStride;
+	switch (pQueryPool->mType)
+	{
+	case QUERY_TYPE_TIMESTAMP:
+	{
+		const uint64_t* pTimestamps = (const uint64_t*)pData;
+		pOutResult->mBeginTimestamp = pTimestamps[0];
+		pOutResult->mEndTimestamp = pTimestamps[1];
+		if (pTimestamps[1] > pTimestamps[0])
+			pOutResult->mDurationNanoseconds = (double)(pTimestamps[1] - pTimestamps[0]) * pRenderer->mCapabilities.mTimestampPeriod;
+		break;
+	}
+	case QUERY_TYPE_OCCLUSION:
+		pOutResult->mSamplesPassed = *(const uint64_t*)pData;
+		break;
+	case QUERY_TYPE_PIPELINE_STATISTICS:
+		memcpy(&pOutResult->mPipelineStatistics, pData, sizeof(PipelineStatistics));
+		break;
+	default:
+		break;
+	}
+}
+
+/// <summary>
+/// 结束指令绘制
+/// </summary>
+/// <param name="pCmd"></param>
+void endCmd(Cmd* pCmd)
+{
+	SHEN_PROFILE_FUNCTION();
+	cmdEndRendering(pCmd);
+
+	if (pCmd->pVkDeviceTable->vkEndCommandBuffer(pCmd->pVkCmdBuf) != VK_SUCCESS)
 	{
 		SHEN_CORE_ERROR("failed to record command buffer!");
 		throw std::runtime_error("failed to record command buffer!");
@@ -1073,12 +3115,13 @@ void endCmd(Cmd* pCmd)
 }
 
 /// <summary>
-/// ύ
+/// 队列提交
 /// </summary>
 /// <param name="pQueue"></param>
 /// <param name="pDesc"></param>
 void queueSubmit(Queue* pQueue, const QueueSubmitDesc* pDesc)
 {
+	SHEN_PROFILE_FUNCTION();
 	uint32_t    cmdCount = pDesc->mCmdCount;
 	Cmd** ppCmds = pDesc->ppCmds;
 	Fence* pFence = pDesc->pSignalFence;
@@ -1087,14 +3130,14 @@ void queueSubmit(Queue* pQueue, const QueueSubmitDesc* pDesc)
 	uint32_t    signalSemaphoreCount = pDesc->mSignalSemaphoreCount;
 	Semaphore** ppSignalSemaphores = pDesc->ppSignalSemaphores;
 
-	VkCommandBuffer* cmds = (VkCommandBuffer*)malloc(cmdCount * sizeof(VkCommandBuffer));
+	VkCommandBuffer* cmds = (VkCommandBuffer*)alloca(cmdCount * sizeof(VkCommandBuffer));
 	for (uint32_t i = 0; i < cmdCount; ++i)
 	{
 		cmds[i] = ppCmds[i]->pVkCmdBuf;
 	}
 
-	VkSemaphore* wait_semaphores = waitSemaphoreCount ? (VkSemaphore*)malloc(waitSemaphoreCount * sizeof(VkSemaphore)) : NULL;
-	VkPipelineStageFlags* wait_masks = (VkPipelineStageFlags*)malloc(waitSemaphoreCount * sizeof(VkPipelineStageFlags));
+	VkSemaphore* wait_semaphores = waitSemaphoreCount ? (VkSemaphore*)alloca(waitSemaphoreCount * sizeof(VkSemaphore)) : NULL;
+	VkPipelineStageFlags* wait_masks = waitSemaphoreCount ? (VkPipelineStageFlags*)alloca(waitSemaphoreCount * sizeof(VkPipelineStageFlags)) : NULL;
 	uint32_t              waitCount = 0;
 	for (uint32_t i = 0; i < waitSemaphoreCount; ++i)
 	{
@@ -1109,7 +3152,7 @@ void queueSubmit(Queue* pQueue, const QueueSubmitDesc* pDesc)
 		//}
 	}
 
-	VkSemaphore* signal_semaphores = signalSemaphoreCount ? (VkSemaphore*)malloc(signalSemaphoreCount * sizeof(VkSemaphore)) : NULL;
+	VkSemaphore* signal_semaphores = signalSemaphoreCount ? (VkSemaphore*)alloca(signalSemaphoreCount * sizeof(VkSemaphore)) : NULL;
 	uint32_t     signalCount = 0;
 	for (uint32_t i = 0; i < signalSemaphoreCount; ++i)
 	{
@@ -1136,20 +3179,25 @@ void queueSubmit(Queue* pQueue, const QueueSubmitDesc* pDesc)
 	submitInfo.signalSemaphoreCount = signalCount;
 	submitInfo.pSignalSemaphores = signal_semaphores;
 
-	if (vkQueueSubmit(pQueue->pVkQueue, 1, &submitInfo, pFence ? pFence->pVkFence : VK_NULL_HANDLE) != VK_SUCCESS)
+	if (pQueue->pVkDeviceTable->vkQueueSubmit(pQueue->pVkQueue, 1, &submitInfo, pFence ? pFence->pVkFence : VK_NULL_HANDLE) != VK_SUCCESS)
 	{
 		SHEN_CORE_ERROR("failed to submit draw command buffer!");
 		throw std::runtime_error("failed to submit draw command buffer!");
 	}
+	if (pFence)
+		pFence->mSubmitted = true;
+	RENDERER_STATS_ADD(pQueue->pRenderer, mQueueSubmits, 1);
+	flightRecorderOnSubmit(pQueue);
 }
 
 /// <summary>
-/// ͼʾ
+/// 图形演示
 /// </summary>
 /// <param name="pQueue"></param>
 /// <param name="pDesc"></param>
 void queuePresent(Queue* pQueue, const QueuePresentDesc* pDesc)
 {
+	SHEN_PROFILE_FUNCTION();
 	uint32_t    waitSemaphoreCount = pDesc->mWaitSemaphoreCount;
 	Semaphore** ppWaitSemaphores = pDesc->ppWaitSemaphores;
 
@@ -1180,10 +3228,68 @@ void queuePresent(Queue* pQueue, const QueuePresentDesc* pDesc)
 	present_info.pImageIndices = &(presentIndex);
 	present_info.pResults = NULL;
 
-	if (vkQueuePresentKHR(pSwapChain->pPresentQueue ? pSwapChain->pPresentQueue : pQueue->pVkQueue, &present_info) != VK_SUCCESS)
+	if (pQueue->pVkDeviceTable->vkQueuePresentKHR(pSwapChain->pPresentQueue ? pSwapChain->pPresentQueue : pQueue->pVkQueue, &present_info) != VK_SUCCESS)
 	{
 		SHEN_CORE_ERROR("failed to present!");
 		throw std::runtime_error("failed to present!");
 	}
+
+	endRendererFrame(pQueue->pRenderer);
+	flightRecorderOnPresent(pQueue);
+	metricsExporterOnPresent(pQueue);
+}
+
+/// <summary>
+/// 等待队列中已提交的工作全部完成
+/// </summary>
+/// <param name="pQueue"></param>
+void waitQueueIdle(Queue* pQueue)
+{
+	SHEN_PROFILE_FUNCTION();
+	pQueue->pVkDeviceTable->vkQueueWaitIdle(pQueue->pVkQueue);
+}
+
+/// <summary>
+/// 结束一帧, 清零当前帧计数并写入快照; 写入前后各递增一次序号, 读取方据此发现被打断的读取
+/// </summary>
+/// <param name="pRenderer"></param>
+void endRendererFrame(Renderer* pRenderer)
+{
+	uint32_t sequence = pRenderer->mStatsSequence.load(std::memory_order_relaxed);
+	pRenderer->mStatsSequence.store(sequence + 1, std::memory_order_relaxed);
+	// 序号变为奇数必须先于任何字段写入被读取方看到
+	std::atomic_thread_fence(std::memory_order_release);
+#define RENDERER_STATS_ARCHIVE_COUNTER(name) \
+	pRenderer->mStatsSnapshot.name.store(pRenderer->mFrameStats.name.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+	RENDERER_STATS_COUNTER_LIST(RENDERER_STATS_ARCHIVE_COUNTER)
+#undef RENDERER_STATS_ARCHIVE_COUNTER
+	pRenderer->mStatsSnapshotFrameIndex.store(++pRenderer->mStatsFrameIndex, std::memory_order_relaxed);
+	pRenderer->mStatsSequence.store(sequence + 2, std::memory_order_release);
+}
+
+/// <summary>
+/// 获取上一帧的渲染统计, 与 endRendererFrame 并发时重读, 直到拿到完整的一帧
+/// </summary>
+/// <param name="pRenderer"></param>
+/// <param name="pOutStats"></param>
+void getRendererStats(Renderer* pRenderer, RendererStats* pOutStats)
+{
+	for (;;)
+	{
+		uint32_t sequence = pRenderer->mStatsSequence.load(std::memory_order_acquire);
+		if (sequence & 1u)
+		{
+			std::this_thread::yield();
+			continue;
+		}
+#define RENDERER_STATS_READ_COUNTER(name) pOutStats->name = pRenderer->mStatsSnapshot.name.load(std::memory_order_relaxed);
+		RENDERER_STATS_COUNTER_LIST(RENDERER_STATS_READ_COUNTER)
+#undef RENDERER_STATS_READ_COUNTER
+		pOutStats->mFrameIndex = pRenderer->mStatsSnapshotFrameIndex.load(std::memory_order_relaxed);
+		// 字段读取必须先于第二次读取序号完成
+		std::atomic_thread_fence(std::memory_order_acquire);
+		if (pRenderer->mStatsSequence.load(std::memory_order_relaxed) == sequence)
+			return;
+	}
 }
 
@@ -18,18 +18,145 @@
 #include <array>
 #include <optional>
 #include <set>
-
+#include <atomic>
+
+#include "ResourcePool.h"
+#include "VulkanDispatch.h"
+
+typedef struct AssetPack AssetPack;
+typedef struct Queue Queue;
+typedef struct RenderPass RenderPass;
+typedef struct Shader Shader;
+typedef struct Pipeline Pipeline;
+typedef struct FrameBuffer FrameBuffer;
+typedef struct CmdPool CmdPool;
+typedef struct Cmd Cmd;
+typedef struct Semaphore Semaphore;
+typedef struct Fence Fence;
+typedef struct Texture Texture;
+typedef struct Buffer Buffer;
+typedef struct QueryPool QueryPool;
+typedef struct DescriptorSet DescriptorSet;
+
+// 渲染资源句柄, 可安全地跨线程传递, 通过 getXXX 解析为指针
+typedef ResourceHandle<Queue>       QueueHandle;
+typedef ResourceHandle<RenderPass>  RenderPassHandle;
+typedef ResourceHandle<Shader>      ShaderHandle;
+typedef ResourceHandle<Pipeline>    PipelineHandle;
+typedef ResourceHandle<FrameBuffer> FrameBufferHandle;
+typedef ResourceHandle<CmdPool>     CmdPoolHandle;
+typedef ResourceHandle<Cmd>         CmdHandle;
+typedef ResourceHandle<Semaphore>   SemaphoreHandle;
+typedef ResourceHandle<Fence>       FenceHandle;
+typedef ResourceHandle<Texture>     TextureHandle;
+typedef ResourceHandle<Buffer>      BufferHandle;
+typedef ResourceHandle<QueryPool>   QueryPoolHandle;
+typedef ResourceHandle<DescriptorSet> DescriptorSetHandle;
+
+typedef struct ResourceRegistry ResourceRegistry;
+typedef struct RenderPassCache RenderPassCache;
+typedef struct GpuProfiler GpuProfiler;
+
+// 单次渲染最多绑定的颜色附件数量
+#define MAX_RENDER_TARGET_ATTACHMENTS 8
+// 计算管线描述符集 0 最多绑定的存储缓冲数量
+#define MAX_COMPUTE_STORAGE_BUFFERS 8
 
 /// <summary>
-/// Ⱦʼ
+/// 渲染初始化参数描述
+/// 显卡选择默认按评分自动选取; 也可以通过环境变量 SHEN_GPU 覆盖:
+/// "software" 选择软件光栅化设备, "#2" 按索引选择, 其余按名称 (不区分大小写的子串) 匹配
 /// </summary>
 typedef struct RendererDesc
 {
-
+	/// 每种资源池的容量, 为 0 时使用默认值
+	uint32_t mMaxResourcesPerType;
+	/// 按名称指定显卡 (不区分大小写的子串匹配), 为 NULL 时自动选择
+	const char* pGpuName;
+	/// 按 vkEnumeratePhysicalDevices 的顺序指定显卡, mUseGpuIndex 为 false 时忽略
+	uint32_t mGpuIndex;
+	bool mUseGpuIndex;
+	/// 强制使用软件光栅化设备 (VK_PHYSICAL_DEVICE_TYPE_CPU, 如 lavapipe / SwiftShader)
+	bool mForceSoftwareRasterizer;
 }RendererDesc;
 
 /// <summary>
-/// Ⱦʼ
+/// 显卡能力, 在 initRenderer 中探测并启用
+/// </summary>
+typedef struct GPUCapabilities
+{
+	char					mDeviceName[VK_MAX_PHYSICAL_DEVICE_NAME_SIZE];
+	VkPhysicalDeviceType	mDeviceType;
+	uint32_t				mVendorId;
+	uint32_t				mDeviceId;
+	// 实际可用的 API 版本, 为实例与设备版本的较小值
+	uint32_t				mApiVersion;
+	uint64_t				mDeviceLocalMemorySize;
+	float					mTimestampPeriod;
+	uint32_t				mTimestampComputeAndGraphics : 1;
+	uint32_t				mSamplerAnisotropy : 1;
+	uint32_t				mMultiDrawIndirect : 1;
+	uint32_t				mDrawIndirectFirstInstance : 1;
+	uint32_t				mPipelineStatisticsQuery : 1;
+	uint32_t				mTextureCompressionBC : 1;
+	// VK_EXT_memory_budget, 可查询每个堆的实时预算与用量
+	uint32_t				mMemoryBudget : 1;
+	// Vulkan 1.2 特性
+	uint32_t				mTimelineSemaphore : 1;
+	uint32_t				mDescriptorIndexing : 1;
+	uint32_t				mBufferDeviceAddress : 1;
+	uint32_t				mHostQueryReset : 1;
+	uint32_t				mDrawIndirectCount : 1;
+	// Vulkan 1.3 特性 (或对应的 KHR 扩展)
+	uint32_t				mSynchronization2 : 1;
+	uint32_t				mDynamicRendering : 1;
+} GPUCapabilities;
+
+/// <summary>
+/// 每帧渲染计数项, 同时展开为快照结构 RendererStats 与原子计数块 RendererStatsCounters
+/// </summary>
+#define RENDERER_STATS_COUNTER_LIST(X)												\
+	X(mDrawCalls)				/* 绘制调用 (含间接与 UI 绘制) */				\
+	X(mDispatchCalls)			/* 计算派发 */									\
+	X(mVertices)				/* 提交的顶点数, 索引绘制按索引数计 */			\
+	X(mInstances)				/* 提交的实例数 */								\
+	X(mPipelineBinds)			/* 管线绑定 */									\
+	X(mDescriptorBinds)			/* 描述符集绑定 */								\
+	X(mBufferBinds)				/* 顶点/索引缓冲绑定 */							\
+	X(mBarriers)				/* 管线屏障 */									\
+	X(mRenderPasses)			/* 渲染通道或动态渲染的开始次数 */				\
+	X(mQueueSubmits)			/* 队列提交 */									\
+	X(mBytesUploaded)			/* 由主机上传到 GPU 的字节数 */					\
+	X(mDescriptorSetsAllocated)	/* 分配的描述符集 */
+
+/// <summary>
+/// 一帧渲染统计的快照, 由 getRendererStats 返回
+/// </summary>
+typedef struct RendererStats
+{
+#define RENDERER_STATS_DECLARE_VALUE(name) uint64_t name;
+	RENDERER_STATS_COUNTER_LIST(RENDERER_STATS_DECLARE_VALUE)
+#undef RENDERER_STATS_DECLARE_VALUE
+	// 快照所属的帧序号, 即归档时 endRendererFrame 的调用次数, 0 表示尚未归档任何帧
+	uint64_t mFrameIndex;
+} RendererStats;
+
+/// <summary>
+/// 当前帧的累计计数, 允许多个线程同时录制指令时并发累加
+/// </summary>
+typedef struct RendererStatsCounters
+{
+#define RENDERER_STATS_DECLARE_COUNTER(name) std::atomic<uint64_t> name;
+	RENDERER_STATS_COUNTER_LIST(RENDERER_STATS_DECLARE_COUNTER)
+#undef RENDERER_STATS_DECLARE_COUNTER
+} RendererStatsCounters;
+
+// 累加当前帧计数, 只保证计数本身原子, 不与其他内存操作排序
+#define RENDERER_STATS_ADD(pRenderer, name, value) \
+	(pRenderer)->mFrameStats.name.fetch_add((uint64_t)(value), std::memory_order_relaxed)
+
+/// <summary>
+/// 渲染初始化内容
 /// </summary>
 typedef struct Renderer
 {
@@ -41,6 +168,21 @@ typedef struct Renderer
 	uint32_t							pVkComputeQueueFamilyIndex;
 	uint32_t							pVkTransferQueueFamilyIndex;
 	//uint32_t							pVkPresentQueueFamilyIndex;
+	GPUCapabilities						mCapabilities;
+	ResourceRegistry*					pResources;
+	// 不支持动态渲染时, 按附件签名缓存的渲染通道与帧缓存
+	RenderPassCache*					pRenderPassCache;
+	// 所有 Vulkan 对象创建/销毁时使用的主机内存分配回调
+	const VkAllocationCallbacks*		pVkAllocator;
+	// 设备级函数表, 所有 vkCmd*/vkQueue* 调用都经由此表
+	DeviceDispatchTable					mVkDeviceTable;
+	// 当前帧累计的统计, endRendererFrame (queuePresent) 时清零并归档
+	RendererStatsCounters				mFrameStats;
+	// 最近归档的一帧, 以顺序锁保护: 写入期间 mStatsSequence 为奇数, 读取方在序号前后不一致时重读
+	RendererStatsCounters				mStatsSnapshot;
+	std::atomic<uint64_t>				mStatsSnapshotFrameIndex;
+	std::atomic<uint32_t>				mStatsSequence;
+	uint64_t							mStatsFrameIndex;
 } Renderer;
 
 typedef enum QueueType
@@ -60,20 +202,26 @@ typedef enum QueueFlag
 } QueueFlag;
 
 /// <summary>
-/// 
+/// 队列描述
 /// </summary>
 typedef struct QueueDesc
 {
 	QueueType							mType;
 	QueueFlag							mFlag;
+	// GPU 计时器的帧环形缓冲数量 (一般为同时在途的帧数), 为 0 时使用默认值
+	uint32_t							mGpuProfilerFrameCount;
 } QueueDesc;
 
 /// <summary>
-/// 
+/// 队列
 /// </summary>
 typedef struct Queue
 {
 	VkQueue	pVkQueue;
+	const DeviceDispatchTable* pVkDeviceTable;
+	// 设置 QUEUE_FLAG_INIT_MICROPROFILE 时创建, 否则为空
+	GpuProfiler* pGpuProfiler;
+	Renderer* pRenderer;
 	uint32_t mVkQueueIndex : 5;
 } Queue;
 
@@ -81,10 +229,141 @@ typedef struct Texture
 {
 	VkImageView pVkSRVDescriptor;
 	VkImage pVkImage;
+	VkFormat mFormat;
+	uint32_t mWidth;
+	uint32_t mHeight;
+	uint32_t mMipLevels;
+	// 录制指令时跟踪的图像布局 (全部 mip 层级一致), 由 cmdBeginRendering / cmdTextureBarrier / cmdGenerateMipmaps 更新
+	VkImageLayout mCurrentLayout;
+	// 离屏渲染目标与纹理占用的显存, 交换链图像为空
+	VkDeviceMemory pVkMemory;
+	// pVkMemory 的分配大小 (含驱动要求的对齐与元数据), 交换链图像为 0
+	uint64_t mMemorySize;
 }Texture;
 
 /// <summary>
-/// ʱFlag Ϣ;
+/// 采样纹理描述, 内容由 cmdCopyBufferToTexture 上传
+/// </summary>
+typedef struct TextureDesc
+{
+	uint32_t mWidth;
+	uint32_t mHeight;
+	// 为 0 时分配完整 mip 链 (直到 1x1)
+	uint32_t mMipLevels;
+	VkFormat mFormat;
+} TextureDesc;
+
+/// <summary>
+/// 离屏渲染目标描述
+/// </summary>
+typedef struct RenderTargetDesc
+{
+	uint32_t mWidth;
+	uint32_t mHeight;
+	VkFormat mFormat;
+} RenderTargetDesc;
+
+/// <summary>
+/// 缓冲所在内存的使用方式
+/// </summary>
+typedef enum ResourceMemoryUsage
+{
+	// 仅 GPU 访问, 设备本地内存
+	RESOURCE_MEMORY_USAGE_GPU_ONLY = 0,
+	// CPU 写入 GPU 读取, 常驻映射
+	RESOURCE_MEMORY_USAGE_CPU_TO_GPU,
+	// GPU 写入 CPU 读取 (回读), 常驻映射, 优先选择带缓存的主机内存
+	RESOURCE_MEMORY_USAGE_GPU_TO_CPU,
+} ResourceMemoryUsage;
+
+/// <summary>
+/// 缓冲描述
+/// </summary>
+typedef struct BufferDesc
+{
+	uint64_t			mSize;
+	VkBufferUsageFlags	mUsage;
+	ResourceMemoryUsage	mMemoryUsage;
+} BufferDesc;
+
+typedef struct Buffer
+{
+	VkBuffer			pVkBuffer;
+	VkDeviceMemory		pVkMemory;
+	// 主机可见内存的常驻映射地址, GPU_ONLY 时为空
+	void*				pCpuMappedAddress;
+	uint64_t			mSize;
+	ResourceMemoryUsage	mMemoryUsage;
+} Buffer;
+
+/// <summary>
+/// 查询类型
+/// </summary>
+typedef enum QueryType
+{
+	// 每个查询占两个时间戳: cmdBeginQuery 写入 TOP_OF_PIPE, cmdEndQuery 写入 BOTTOM_OF_PIPE
+	QUERY_TYPE_TIMESTAMP = 0,
+	// 通过深度/模板测试的采样数
+	QUERY_TYPE_OCCLUSION,
+	// 管线统计, 需要设备支持 pipelineStatisticsQuery
+	QUERY_TYPE_PIPELINE_STATISTICS,
+	QUERY_TYPE_COUNT,
+} QueryType;
+
+/// <summary>
+/// 查询池描述
+/// </summary>
+typedef struct QueryPoolDesc
+{
+	QueryType	mType;
+	uint32_t	mQueryCount;
+} QueryPoolDesc;
+
+typedef struct QueryPool
+{
+	VkQueryPool	pVkQueryPool;
+	QueryType	mType;
+	// 查询数量, 时间戳查询占用 2 * mCount 个 Vulkan 查询
+	uint32_t	mCount;
+	// 每个查询在回读缓冲中占用的字节数
+	uint32_t	mStride;
+} QueryPool;
+
+typedef struct QueryDesc
+{
+	uint32_t	mIndex;
+} QueryDesc;
+
+/// <summary>
+/// 管线统计结果, 顺序与 VkQueryPipelineStatisticFlagBits 的位顺序一致
+/// </summary>
+typedef struct PipelineStatistics
+{
+	uint64_t	mIAVertices;
+	uint64_t	mIAPrimitives;
+	uint64_t	mVSInvocations;
+	uint64_t	mClippingInvocations;
+	uint64_t	mClippingPrimitives;
+	uint64_t	mFSInvocations;
+	uint64_t	mCSInvocations;
+} PipelineStatistics;
+
+/// <summary>
+/// 解码后的单个查询结果, 按查询池类型读取对应字段
+/// </summary>
+typedef struct QueryResult
+{
+	// 时间戳查询: 开始与结束之间的 GPU 耗时 (纳秒)
+	double				mDurationNanoseconds;
+	uint64_t			mBeginTimestamp;
+	uint64_t			mEndTimestamp;
+	// 遮挡查询: 通过测试的采样数
+	uint64_t			mSamplesPassed;
+	PipelineStatistics	mPipelineStatistics;
+} QueryResult;
+
+/// <summary>
+/// 创建交换链描述符时的Flag 信息;
 /// </summary>
 typedef enum SwapChainCreationFlags
 {
@@ -93,7 +372,7 @@ typedef enum SwapChainCreationFlags
 } SwapChainCreationFlags;
 
 /// <summary>
-/// 
+/// 交互链描述
 /// </summary>
 typedef struct SwapChainDesc
 {
@@ -115,7 +394,7 @@ typedef struct SwapChainDesc
 } SwapChainDesc;
 
 /// <summary>
-/// 
+/// 交换链
 /// </summary>
 typedef struct SwapChain
 {
@@ -127,7 +406,7 @@ typedef struct SwapChain
 } SwapChain;
 
 /// <summary>
-/// Ⱦͨ
+/// 渲染通道描述符
 /// </summary>
 typedef struct RenderPassDesc
 {
@@ -136,7 +415,7 @@ typedef struct RenderPassDesc
 } RenderPassDesc;
 
 /// <summary>
-/// Ⱦͨ
+/// 渲染通道
 /// </summary>
 typedef struct RenderPass
 {
@@ -145,7 +424,7 @@ typedef struct RenderPass
 } RenderPass;
 
 /// <summary>
-/// 
+/// 管线类型
 /// </summary>
 typedef enum PipelineType
 {
@@ -176,7 +455,10 @@ typedef enum ShaderStage
 
 typedef struct ShaderDesc
 {
+	// SPIR-V 文件路径; pPack 非空时为资源包内的名称
 	const char* pFileName;
+	// 可选的资源包, 从包中读取而不是打开单独的文件
+	AssetPack*	pPack;
 	ShaderStage	mStages : 31;
 };
 
@@ -186,38 +468,101 @@ typedef struct Shader
 	ShaderStage		mStages : 31;
 }Shader;
 
+#define MAX_VERTEX_ATTRIBS 8
+
 /// <summary>
-/// ͼι˵
+/// 顶点属性, 全部来自绑定点 0
+/// </summary>
+typedef struct VertexAttrib
+{
+	VkFormat	mFormat;
+	uint32_t	mLocation;
+	uint32_t	mOffset;
+} VertexAttrib;
+
+/// <summary>
+/// 顶点布局, 单一交错顶点流
+/// </summary>
+typedef struct VertexLayout
+{
+	VertexAttrib	mAttribs[MAX_VERTEX_ATTRIBS];
+	uint32_t		mAttribCount;
+	uint32_t		mStride;
+} VertexLayout;
+
+/// <summary>
+/// 图形管线说明
 /// </summary>
 typedef struct GraphicsPipelineDesc
 {
 	Shader* pShaders[SHADER_STAGE_COUNT];
-	VkFormat pColorFormats;
+	// 管线只依赖附件格式, 与具体的渲染通道无关
+	VkFormat* pColorFormats;
+	// 为空时管线没有顶点输入, 顶点由着色器自行生成
+	const VertexLayout* pVertexLayout;
+	uint32_t mRenderTargetCount;
 	int32_t	pShaderCount;
+	// 顶点与片元着色器共用的推送常量字节数 (不超过 128), 0 表示管线不使用推送常量
+	uint32_t mPushConstantSize;
 } GraphicsPipelineDesc;
 
 /// <summary>
-/// 
+/// 计算管线说明, 管线布局为一个只含存储缓冲的描述符集 (set 0) 加可选的推送常量
+/// </summary>
+typedef struct ComputePipelineDesc
+{
+	Shader*		pShader;
+	// 描述符集 0 中的存储缓冲数量, 绑定号依次为 0 .. mStorageBufferCount - 1
+	uint32_t	mStorageBufferCount;
+	// 计算着色器的推送常量字节数 (不超过 128)
+	uint32_t	mPushConstantSize;
+} ComputePipelineDesc;
+
+/// <summary>
+/// 管线描述, 按 mType 使用对应的说明
 /// </summary>
 typedef struct PipelineDesc
 {
 	GraphicsPipelineDesc   mGraphicsDesc;
+	ComputePipelineDesc    mComputeDesc;
 	PipelineType   mType;
 };
 
 /// <summary>
-/// 
+/// 管线
 /// </summary>
 typedef struct Pipeline
 {
 	VkPipeline   pVkPipeline;
 	PipelineType mType;
-	RenderPass mRenderPass;
 	VkPipelineLayout mVkPipelineLayout;
+	// 计算管线的描述符集布局, 图形管线为空
+	VkDescriptorSetLayout mVkDescriptorSetLayout;
+	uint32_t     mStorageBufferCount;
 } Pipeline;
 
 /// <summary>
-/// ֡
+/// 描述符集描述, 按管线的描述符集布局分配
+/// </summary>
+typedef struct DescriptorSetDesc
+{
+	Pipeline* pPipeline;
+} DescriptorSetDesc;
+
+/// <summary>
+/// 描述符集, 独占一个容量恰好为一个集的描述符池, 释放时整池销毁
+/// </summary>
+typedef struct DescriptorSet
+{
+	VkDescriptorPool	pVkDescriptorPool;
+	VkDescriptorSet		pVkDescriptorSet;
+	VkPipelineLayout	mVkPipelineLayout;
+	VkPipelineBindPoint	mBindPoint;
+	uint32_t			mStorageBufferCount;
+} DescriptorSet;
+
+/// <summary>
+/// 帧缓存描述
 /// </summary>
 typedef struct FrameBufferDesc
 {
@@ -228,7 +573,7 @@ typedef struct FrameBufferDesc
 } FrameBufferDesc;
 
 /// <summary>
-/// ֡
+/// 帧缓存
 /// </summary>
 typedef struct FrameBuffer
 {
@@ -238,7 +583,7 @@ typedef struct FrameBuffer
 } FrameBuffer;
 
 /// <summary>
-/// 
+/// 命令池描述
 /// </summary>
 typedef struct CmdPoolDesc
 {
@@ -247,7 +592,7 @@ typedef struct CmdPoolDesc
 } CmdPoolDesc;
 
 /// <summary>
-/// 
+/// 命令池
 /// </summary>
 typedef struct CmdPool
 {
@@ -262,13 +607,18 @@ typedef struct CmdDesc
 } CmdDesc;
 
 /// <summary>
-/// 
+/// 命令
 /// </summary>
 typedef struct Cmd
 {
 	VkCommandBuffer  pVkCmdBuf;
+	// 录制指令时直接使用设备函数表, 避免每次经由 pRenderer 间接寻址
+	const DeviceDispatchTable* pVkDeviceTable;
 	VkRenderPass     pVkActiveRenderPass;
+	uint32_t         mDynamicRenderingActive : 1;
 	VkPipelineLayout pBoundPipelineLayout;
+	// 最近绑定的管线的推送常量阶段, 图形与计算管线不同
+	VkShaderStageFlags mBoundPushConstantStages;
 	CmdPool* pCmdPool;
 
 	Renderer* pRenderer;
@@ -276,7 +626,7 @@ typedef struct Cmd
 } Cmd;
 
 /// <summary>
-/// ź
+/// 信号量
 /// </summary>
 typedef struct Semaphore
 {
@@ -285,7 +635,7 @@ typedef struct Semaphore
 } Semaphore;
 
 /// <summary>
-/// դ
+/// 栅栏
 /// </summary>
 typedef struct Fence
 {
@@ -293,8 +643,50 @@ typedef struct Fence
 	uint32_t mSubmitted : 1;
 } Fence;
 
+typedef enum FenceStatus
+{
+	FENCE_STATUS_COMPLETE = 0,
+	FENCE_STATUS_INCOMPLETE,
+	// 自上次完成后没有被提交过
+	FENCE_STATUS_NOTSUBMITTED,
+} FenceStatus;
+
+/// <summary>
+/// 设备本地堆 (显存) 的预算与当前用量, 单位为字节, 所有 DEVICE_LOCAL 堆求和
+/// 预算由驱动根据系统中其他进程的占用动态给出, 用量包含本进程在这些堆上的全部分配
+/// </summary>
+typedef struct GpuMemoryBudget
+{
+	uint64_t mBudget;
+	uint64_t mUsage;
+} GpuMemoryBudget;
+
+/// <summary>
+/// 渲染附件绑定描述
+/// </summary>
+typedef struct RenderTargetBindDesc
+{
+	Texture*			pTexture;
+	VkAttachmentLoadOp	mLoadOp;
+	VkAttachmentStoreOp	mStoreOp;
+	VkClearValue		mClearValue;
+} RenderTargetBindDesc;
+
 /// <summary>
-/// ύϢ
+/// 渲染描述
+/// 支持 VK_KHR_dynamic_rendering 时直接录制 vkCmdBeginRendering,
+/// 否则从缓存中取得 (或创建) 与附件签名匹配的渲染通道和帧缓存
+/// </summary>
+typedef struct RenderingDesc
+{
+	RenderTargetBindDesc	mColorAttachments[MAX_RENDER_TARGET_ATTACHMENTS];
+	uint32_t				mColorAttachmentCount;
+	// 强制使用渲染通道路径, 用于管线只能基于 VkRenderPass 创建的情况 (如 ImGui 后端)
+	bool					mUseRenderPass;
+} RenderingDesc;
+
+/// <summary>
+/// 队列提交信息描述
 /// </summary>
 typedef struct QueueSubmitDesc
 {
@@ -309,7 +701,7 @@ typedef struct QueueSubmitDesc
 } QueueSubmitDesc;
 
 /// <summary>
-/// ʾϢ
+/// 演示队列信息描述
 /// </summary>
 typedef struct QueuePresentDesc
 {
@@ -320,49 +712,165 @@ typedef struct QueuePresentDesc
 	bool        mSubmitDone;
 } QueuePresentDesc;
 
-// ʼͼ豸,Ĵ
+// 初始化绘图设备,包含交换链的创建
+// p_desc 为空或 mWindow 为空时以无窗口模式初始化: 不创建表面与交换链, *p_swap_chain 置空, 只能渲染到离屏目标
 void initRenderer(const char* appName, const RendererDesc* pSettings, Renderer** ppRenderer, SwapChainDesc* p_desc, SwapChain** p_swap_chain, std::vector<Texture>& pTextures);
-// Ӷ
+// 添加队列
 void addQueue(Renderer* pRenderer, QueueDesc* pQDesc, Queue** pQueue);
-// Ⱦͨ
+// 添加渲染通道
 void addRenderPass(Renderer* pRenderer, const RenderPassDesc* pDesc, RenderPass** ppRenderPass);
-// Ⱦ
+// 添加渲染管线
 void addPipeline(Renderer* pRenderer, const PipelineDesc* pDesc, Pipeline** ppPipeline);
-// ɫ
+// 添加着色器
 void addShader(Renderer* pRenderer, const ShaderDesc* pDesc, Shader** ppShader);
-// ֡
+// 添加帧缓存
 void addFrameBuffer(Renderer* pRenderer, const FrameBufferDesc* pDesc, FrameBuffer** ppFrameBuffer);
-// 
+// 添加命令池
 void addCmdPool(Renderer* pRenderer, const CmdPoolDesc* pDesc, CmdPool** ppCmdPool);
-// 
+// 添加命令
 void addCmd(Renderer* pRenderer, const CmdDesc* pDesc, Cmd** ppCmd);
-// ź
+// 添加信号量
 void addSemaphore(Renderer* pRenderer, Semaphore** ppSemaphore);
-// դ
+// 增加栅栏
 void addFence(Renderer* pRenderer, Fence** ppFence);
-
-
-/*********  ͼβֺ ***********/
+// 添加离屏渲染目标
+void addRenderTarget(Renderer* pRenderer, const RenderTargetDesc* pDesc, Texture** ppTexture);
+// 添加采样纹理, 可作为拷贝目标与 blit 源
+void addTexture(Renderer* pRenderer, const TextureDesc* pDesc, Texture** ppTexture);
+// 添加缓冲
+void addBuffer(Renderer* pRenderer, const BufferDesc* pDesc, Buffer** ppBuffer);
+// 添加查询池
+void addQueryPool(Renderer* pRenderer, const QueryPoolDesc* pDesc, QueryPool** ppQueryPool);
+// 添加描述符集
+void addDescriptorSet(Renderer* pRenderer, const DescriptorSetDesc* pDesc, DescriptorSet** ppDescriptorSet);
+
+// 释放队列
+void removeQueue(Renderer* pRenderer, Queue* pQueue);
+// 释放渲染通道
+void removeRenderPass(Renderer* pRenderer, RenderPass* pRenderPass);
+// 释放渲染管线
+void removePipeline(Renderer* pRenderer, Pipeline* pPipeline);
+// 释放着色器
+void removeShader(Renderer* pRenderer, Shader* pShader);
+// 释放帧缓存
+void removeFrameBuffer(Renderer* pRenderer, FrameBuffer* pFrameBuffer);
+// 释放命令池
+void removeCmdPool(Renderer* pRenderer, CmdPool* pCmdPool);
+// 释放命令
+void removeCmd(Renderer* pRenderer, Cmd* pCmd);
+// 释放信号量
+void removeSemaphore(Renderer* pRenderer, Semaphore* pSemaphore);
+// 释放栅栏
+void removeFence(Renderer* pRenderer, Fence* pFence);
+// 释放离屏渲染目标
+void removeRenderTarget(Renderer* pRenderer, Texture* pTexture);
+// 释放采样纹理
+void removeTexture(Renderer* pRenderer, Texture* pTexture);
+// 释放缓冲
+void removeBuffer(Renderer* pRenderer, Buffer* pBuffer);
+// 释放查询池
+void removeQueryPool(Renderer* pRenderer, QueryPool* pQueryPool);
+// 释放描述符集, 调用前需确保 GPU 不再使用
+void removeDescriptorSet(Renderer* pRenderer, DescriptorSet* pDescriptorSet);
+// 把 ppBuffers 依次写入绑定 0 .. bufferCount - 1 (整个缓冲), 需在 GPU 不再使用该集时调用
+void updateDescriptorSet(Renderer* pRenderer, DescriptorSet* pDescriptorSet, uint32_t bufferCount, Buffer** ppBuffers);
+
+// 资源指针与句柄互转; 句柄失效 (资源已释放) 时 getXXX 会报告 use after free
+#define DECLARE_RENDERER_RESOURCE_HANDLE_API(Type)							\
+	Type##Handle get##Type##Handle(Renderer* pRenderer, const Type* p##Type);	\
+	Type* get##Type(Renderer* pRenderer, Type##Handle handle);					\
+	bool is##Type##HandleValid(Renderer* pRenderer, Type##Handle handle);
+
+DECLARE_RENDERER_RESOURCE_HANDLE_API(Queue)
+DECLARE_RENDERER_RESOURCE_HANDLE_API(RenderPass)
+DECLARE_RENDERER_RESOURCE_HANDLE_API(Shader)
+DECLARE_RENDERER_RESOURCE_HANDLE_API(Pipeline)
+DECLARE_RENDERER_RESOURCE_HANDLE_API(FrameBuffer)
+DECLARE_RENDERER_RESOURCE_HANDLE_API(CmdPool)
+DECLARE_RENDERER_RESOURCE_HANDLE_API(Cmd)
+DECLARE_RENDERER_RESOURCE_HANDLE_API(Semaphore)
+DECLARE_RENDERER_RESOURCE_HANDLE_API(Fence)
+DECLARE_RENDERER_RESOURCE_HANDLE_API(Texture)
+DECLARE_RENDERER_RESOURCE_HANDLE_API(Buffer)
+DECLARE_RENDERER_RESOURCE_HANDLE_API(QueryPool)
+DECLARE_RENDERER_RESOURCE_HANDLE_API(DescriptorSet)
+
+
+/*********  绘制图形部分函数 ***********/
 /***************************************/
-// ȴդ
+// 等待栅栏
 void waitForFences(Renderer* pRenderer, int32_t fenceCount, Fence** ppFences);
-// ȡһ֡ͼƬ
+// 非阻塞查询栅栏, 完成时重置栅栏以便再次提交
+void getFenceStatus(Renderer* pRenderer, Fence* pFence, FenceStatus* pFenceStatus);
+// 查询显存预算, 设备不支持 VK_EXT_memory_budget 时返回 false
+bool getGpuMemoryBudget(Renderer* pRenderer, GpuMemoryBudget* pOutBudget);
+// 获取下一帧图片
 void acquireNextImage(Renderer* pRenderer, SwapChain* pSwapChain, Semaphore* pSignalSemaphore, Fence* pFence, uint32_t* pImageIndex);
-// ָ¼
+// 开启指令录制
 void beginCmd(Cmd* pCmd);
-// ָ󶨵Ⱦͨ
+// 指令绑定到子渲染通道
 void cmdBindRenderPass(Cmd* pCmd, RenderPass* pRenderPass, FrameBuffer* pFrameBuffer);
-// ָ󶨵
+// 指令绑定到管线, 按管线类型绑定到图形或计算绑定点
 void cmdBindPipeline(Cmd* pCmd, Pipeline* pPipeline);
-// ָӿ
+// 绑定描述符集到 set 0
+void cmdBindDescriptorSet(Cmd* pCmd, DescriptorSet* pDescriptorSet);
+// 从偏移 0 写入当前绑定管线的推送常量, size 不超过创建管线时的 mPushConstantSize
+void cmdPushConstants(Cmd* pCmd, const void* pData, uint32_t size);
+// 指令视口设置
 void cmdSetViewport(Cmd* pCmd, float x, float y, float width, float height, float minDepth, float maxDepth);
-//ָӿڲ
+//设置指令视口裁切
 void cmdSetScissor(Cmd* pCmd, uint32_t x, uint32_t y, uint32_t width, uint32_t height);
-// ָ
+// 结束渲染通道
+void cmdEndRenderPass(Cmd* pCmd);
+// 开始渲染到指定附件
+void cmdBeginRendering(Cmd* pCmd, const RenderingDesc* pDesc);
+// 结束渲染
+void cmdEndRendering(Cmd* pCmd);
+// 图像布局转换
+void cmdTextureBarrier(Cmd* pCmd, Texture* pTexture, VkImageLayout newLayout);
+// 缓冲内存屏障, 覆盖整个缓冲
+void cmdBufferBarrier(Cmd* pCmd, Buffer* pBuffer, VkPipelineStageFlags srcStage, VkAccessFlags srcAccess, VkPipelineStageFlags dstStage, VkAccessFlags dstAccess);
+// 缓冲间拷贝, 需在渲染通道外录制; 源缓冲为 CPU_TO_GPU 时计入上传字节数
+void cmdCopyBuffer(Cmd* pCmd, Buffer* pDstBuffer, uint64_t dstOffset, Buffer* pSrcBuffer, uint64_t srcOffset, uint64_t size);
+// 从缓冲拷贝紧密排列的像素到纹理的一个 mip 层级, 纹理需处于 TRANSFER_DST_OPTIMAL
+void cmdCopyBufferToTexture(Cmd* pCmd, Texture* pTexture, uint32_t mipLevel, Buffer* pSrcBuffer, uint64_t srcOffset);
+// 以 mip 0 为源逐级 blit 生成其余层级, 纹理需处于 TRANSFER_DST_OPTIMAL, 完成后全部层级转为 SHADER_READ_ONLY_OPTIMAL
+void cmdGenerateMipmaps(Cmd* pCmd, Texture* pTexture);
+// 获取与附件格式兼容的渲染通道 (由缓存持有, 无需释放), 用于基于 VkRenderPass 创建管线
+VkRenderPass getCompatibleRenderPass(Renderer* pRenderer, uint32_t colorFormatCount, const VkFormat* pColorFormats);
+// 清空帧缓存缓存, 交换链图像重建后需要调用
+void resetFrameBufferCache(Renderer* pRenderer);
+// 指令绘制
 void cmdDraw(Cmd* pCmd, uint32_t vertex_count, uint32_t first_vertex);
-// ָ¼
+// 绑定顶点缓冲到绑定点 0
+void cmdBindVertexBuffer(Cmd* pCmd, Buffer* pBuffer, uint64_t offset);
+// 绑定索引缓冲
+void cmdBindIndexBuffer(Cmd* pCmd, Buffer* pBuffer, uint64_t offset, VkIndexType indexType);
+// 索引绘制, vertexOffset 加到每个索引上
+void cmdDrawIndexed(Cmd* pCmd, uint32_t indexCount, uint32_t firstIndex, int32_t vertexOffset);
+// 间接索引绘制, pBuffer 中为 drawCount 条 VkDrawIndexedIndirectCommand; 不支持 multiDrawIndirect 时逐条录制
+void cmdDrawIndexedIndirect(Cmd* pCmd, Buffer* pBuffer, uint64_t offset, uint32_t drawCount, uint32_t stride);
+// 计算派发, 需在渲染通道外录制
+void cmdDispatch(Cmd* pCmd, uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ);
+// 重置查询, 需在渲染通道外录制, 查询在每次使用前都要重置
+void cmdResetQueryPool(Cmd* pCmd, QueryPool* pQueryPool, uint32_t startQuery, uint32_t queryCount);
+// 开始查询
+void cmdBeginQuery(Cmd* pCmd, QueryPool* pQueryPool, const QueryDesc* pQuery);
+// 结束查询
+void cmdEndQuery(Cmd* pCmd, QueryPool* pQueryPool, const QueryDesc* pQuery);
+// 将已结束的查询结果拷贝到回读缓冲 (GPU_TO_CPU, 需带 TRANSFER_DST 用途), 需在渲染通道外录制, 不阻塞 CPU
+void cmdResolveQuery(Cmd* pCmd, QueryPool* pQueryPool, Buffer* pReadbackBuffer, uint32_t startQuery, uint32_t queryCount);
+// 从回读缓冲解码查询结果; 调用前需等待录制 cmdResolveQuery 的提交对应的栅栏
+void getQueryResult(Renderer* pRenderer, const QueryPool* pQueryPool, const Buffer* pReadbackBuffer, uint32_t queryIndex, QueryResult* pOutResult);
+// 结束指令录制
 void endCmd(Cmd* pCmd);
-// ύ
+// 队列提交
 void queueSubmit(Queue* pQueue, const QueueSubmitDesc* pDesc);
-// ʾ
+// 队列演示
 void queuePresent(Queue* pQueue, const QueuePresentDesc* pDesc);
+// 等待队列空闲
+void waitQueueIdle(Queue* pQueue);
+// 结束一帧, 归档渲染统计; queuePresent 会自动调用, 无交换链时由应用在每帧提交后调用; 同一时刻只能有一个线程调用
+void endRendererFrame(Renderer* pRenderer);
+// 获取最近归档的一帧渲染统计, 可在任意线程调用
+void getRendererStats(Renderer* pRenderer, RendererStats* pOutStats);
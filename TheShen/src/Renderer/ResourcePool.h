@@ -0,0 +1,232 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <stdexcept>
+
+#include "Core/Log.h"
+#include "Core/Memory.h"
+
+/// <summary>
+/// 资源句柄: 低 20 位为槽位索引, 高 12 位为代数 (generation)
+/// 代数为 0 的句柄永远无效, 因此零初始化的句柄即为空句柄
+/// </summary>
+template<typename T>
+struct ResourceHandle
+{
+	static const uint32_t INDEX_BITS = 20;
+	static const uint32_t GENERATION_BITS = 32 - INDEX_BITS;
+	static const uint32_t INDEX_MASK = (1u << INDEX_BITS) - 1;
+	static const uint32_t GENERATION_MASK = (1u << GENERATION_BITS) - 1;
+
+	uint32_t mValue;
+
+	uint32_t index() const { return mValue & INDEX_MASK; }
+	uint32_t generation() const { return mValue >> INDEX_BITS; }
+	bool     isNull() const { return generation() == 0; }
+
+	static ResourceHandle make(uint32_t index, uint32_t generation)
+	{
+		ResourceHandle handle;
+		handle.mValue = (generation << INDEX_BITS) | (index & INDEX_MASK);
+		return handle;
+	}
+
+	bool operator==(const ResourceHandle& other) const { return mValue == other.mValue; }
+	bool operator!=(const ResourceHandle& other) const { return mValue != other.mValue; }
+};
+
+/// <summary>
+/// 固定容量的资源池 (SoA 布局)
+/// 资源数据, 代数和空闲列表分别连续存放, 遍历资源数据时不会被元数据打断缓存行;
+/// 容量在初始化时确定, 因此 Allocate 返回的指针在资源释放前始终有效
+/// 分配、释放与句柄查询在同一把锁内校验并修改元数据, 可从任意线程调用;
+/// ForEach、GetLiveCount 与 Init/Exit 不加锁, 只能在拥有该池的线程上调用
+/// </summary>
+template<typename T>
+class ResourcePool
+{
+public:
+	typedef ResourceHandle<T> Handle;
+
+	void Init(const char* name, uint32_t capacity)
+	{
+		if (capacity == 0 || capacity > Handle::INDEX_MASK + 1)
+		{
+			SHEN_CORE_ERROR("invalid capacity {0} for resource pool {1}!", capacity, name);
+			throw std::runtime_error("invalid resource pool capacity!");
+		}
+
+		pName = name;
+		mCapacity = capacity;
+		mLiveCount = 0;
+		pData = (T*)shen_calloc(MEMORY_CATEGORY_RENDERER, capacity, sizeof(T));
+		pGenerations = (uint16_t*)shen_calloc(MEMORY_CATEGORY_RENDERER, capacity, sizeof(uint16_t));
+		pLive = (uint8_t*)shen_calloc(MEMORY_CATEGORY_RENDERER, capacity, sizeof(uint8_t));
+		pFreeList = (uint32_t*)shen_malloc(MEMORY_CATEGORY_RENDERER, capacity * sizeof(uint32_t));
+
+		// 倒序压栈, 使得最先分配的是低地址槽位
+		mFreeCount = capacity;
+		for (uint32_t i = 0; i < capacity; ++i)
+		{
+			pFreeList[i] = capacity - 1 - i;
+			pGenerations[i] = 1;
+		}
+	}
+
+	void Exit()
+	{
+		if (mLiveCount)
+		{
+			SHEN_CORE_WARN("resource pool {0} destroyed with {1} live objects!", pName, mLiveCount);
+		}
+		shen_free(pData);
+		shen_free(pGenerations);
+		shen_free(pLive);
+		shen_free(pFreeList);
+		pData = NULL;
+		pGenerations = NULL;
+		pLive = NULL;
+		pFreeList = NULL;
+		mCapacity = mFreeCount = mLiveCount = 0;
+	}
+
+	/// <summary>
+	/// 分配一个零初始化的槽位
+	/// </summary>
+	T* Allocate(Handle* pOutHandle = NULL)
+	{
+		uint32_t index;
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			if (mFreeCount == 0)
+			{
+				SHEN_CORE_ERROR("resource pool {0} is full ({1} objects)!", pName, mCapacity);
+				throw std::runtime_error("resource pool is full!");
+			}
+			index = pFreeList[--mFreeCount];
+			pLive[index] = 1;
+			++mLiveCount;
+			if (pOutHandle)
+				*pOutHandle = Handle::make(index, pGenerations[index]);
+		}
+
+		memset(&pData[index], 0, sizeof(T));
+		return &pData[index];
+	}
+
+	/// <summary>
+	/// 释放槽位, 代数加一使所有旧句柄失效; 校验与释放在同一把锁内, 重复释放必定被检测到
+	/// </summary>
+	void Release(Handle handle)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		Validate(handle, "release");
+		ReleaseSlot(handle.index());
+	}
+
+	void Release(const T* pObject)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		ReleaseSlot(GetHandleLocked(pObject).index());
+	}
+
+	T* Get(Handle handle)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		Validate(handle, "access");
+		return &pData[handle.index()];
+	}
+
+	bool IsValid(Handle handle) const
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		return IsValidLocked(handle);
+	}
+
+	/// <summary>
+	/// 由池内指针反查句柄
+	/// </summary>
+	Handle GetHandle(const T* pObject) const
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		return GetHandleLocked(pObject);
+	}
+
+	uint32_t GetLiveCount() const { return mLiveCount; }
+	uint32_t GetCapacity() const { return mCapacity; }
+
+	/// <summary>
+	/// 遍历所有存活对象
+	/// </summary>
+	template<typename F>
+	void ForEach(const F& func)
+	{
+		for (uint32_t i = 0; i < mCapacity; ++i)
+		{
+			if (pLive[i])
+				func(&pData[i]);
+		}
+	}
+
+private:
+	// 以下函数要求调用者持有 mMutex
+	bool IsValidLocked(Handle handle) const
+	{
+		uint32_t index = handle.index();
+		return !handle.isNull() && index < mCapacity && pLive[index] && pGenerations[index] == handle.generation();
+	}
+
+	Handle GetHandleLocked(const T* pObject) const
+	{
+		if (pObject < pData || pObject >= pData + mCapacity)
+		{
+			SHEN_CORE_ERROR("object {0} does not belong to resource pool {1}!", (const void*)pObject, pName);
+			throw std::runtime_error("object does not belong to resource pool!");
+		}
+		uint32_t index = (uint32_t)(pObject - pData);
+		if (!pLive[index])
+		{
+			SHEN_CORE_ERROR("use after free: {0} slot {1} has already been released!", pName, index);
+			throw std::runtime_error("use after free of renderer resource!");
+		}
+		return Handle::make(index, pGenerations[index]);
+	}
+
+	void Validate(Handle handle, const char* op) const
+	{
+		if (IsValidLocked(handle))
+			return;
+
+		uint32_t index = handle.index();
+		if (handle.isNull() || index >= mCapacity)
+		{
+			SHEN_CORE_ERROR("invalid {0} handle 0x{1:08x} on {2}!", pName, handle.mValue, op);
+			throw std::runtime_error("invalid renderer resource handle!");
+		}
+		SHEN_CORE_ERROR("use after free: {0} handle 0x{1:08x} (slot {2}, generation {3}) on {4}, slot is at generation {5}{6}!",
+			pName, handle.mValue, index, handle.generation(), op, pGenerations[index], pLive[index] ? "" : " and free");
+		throw std::runtime_error("use after free of renderer resource!");
+	}
+
+	void ReleaseSlot(uint32_t index)
+	{
+		uint32_t generation = (pGenerations[index] + 1) & Handle::GENERATION_MASK;
+		pGenerations[index] = (uint16_t)(generation ? generation : 1);
+		pLive[index] = 0;
+		pFreeList[mFreeCount++] = index;
+		--mLiveCount;
+	}
+
+	T*			pData = NULL;
+	uint16_t*	pGenerations = NULL;
+	uint8_t*	pLive = NULL;
+	uint32_t*	pFreeList = NULL;
+	uint32_t	mCapacity = 0;
+	uint32_t	mFreeCount = 0;
+	uint32_t	mLiveCount = 0;
+	const char* pName = "";
+	mutable std::mutex	mMutex;
+};
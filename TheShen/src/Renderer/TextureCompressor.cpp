@@ -0,0 +1,545 @@
+#include "TextureCompressor.h"
+#include "Core/JobSystem.h"
+#include "Core/Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// stb_dxt 的实现在本文件中编译, 它依赖调用方先包含 memcpy 的声明
+#define STB_DXT_IMPLEMENTATION
+#include "stb_dxt.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define TEXTURE_COMPRESSOR_SSE2 1
+#endif
+
+// BC7 4 位索引的插值权重 (以 64 为 1)
+static const int BC7_WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+// 最小二乘拟合与逐分量搜索的轮数, 按质量等级索引
+static const int BC7_REFINE_ITERATIONS[] = { 0, 2, 3 };
+static const int BC7_SEARCH_PASSES[] = { 0, 0, 2 };
+
+/// <summary>
+/// BC7 模式 6 的量化端点: 每个分量 7 位, 每个端点共享 1 个 p 位, 重建值为 (q << 1) | p
+/// </summary>
+typedef struct Bc7Endpoints
+{
+	int mQuantized[2][4];
+	int mPBits[2];
+} Bc7Endpoints;
+
+typedef struct Bc7Candidate
+{
+	Bc7Endpoints	mEndpoints;
+	uint8_t			mIndices[16];
+	uint32_t		mError;
+} Bc7Candidate;
+
+uint32_t getCompressedBlockSize(TextureCompressionFormat format)
+{
+	return format == TEXTURE_COMPRESSION_BC1 ? 8 : 16;
+}
+
+size_t getCompressedLevelSize(TextureCompressionFormat format, uint32_t width, uint32_t height)
+{
+	return (size_t)((width + 3) / 4) * ((height + 3) / 4) * getCompressedBlockSize(format);
+}
+
+static void buildBc7Palette(const Bc7Endpoints* pEndpoints, int palette[16][4])
+{
+	for (int c = 0; c < 4; ++c)
+	{
+		int e0 = (pEndpoints->mQuantized[0][c] << 1) | pEndpoints->mPBits[0];
+		int e1 = (pEndpoints->mQuantized[1][c] << 1) | pEndpoints->mPBits[1];
+		for (int i = 0; i < 16; ++i)
+			palette[i][c] = ((64 - BC7_WEIGHTS4[i]) * e0 + BC7_WEIGHTS4[i] * e1 + 32) >> 6;
+	}
+}
+
+#ifdef TEXTURE_COMPRESSOR_SSE2
+static inline __m128i minEpi32(__m128i a, __m128i b)
+{
+	__m128i less = _mm_cmplt_epi32(a, b);
+	return _mm_or_si128(_mm_and_si128(less, a), _mm_andnot_si128(less, b));
+}
+#endif
+
+/// <summary>
+/// 为每个像素选择误差平方和最小的调色板项, 返回整块误差
+/// SSE2: 调色板两项一组存为 8 个 int16, madd 得到每项 RG 与 BA 的平方和, 每次求出 4 项的误差
+/// 误差不超过 4 * 255^2 < 2^18, 左移 4 位后拼上索引, 一次取最小值同时得到误差与索引 (相等时取较小的索引)
+/// </summary>
+static uint32_t findBc7Indices(const uint8_t pPixels[16][4], const int palette[16][4], uint8_t* pIndices)
+{
+	uint32_t totalError = 0;
+#ifdef TEXTURE_COMPRESSOR_SSE2
+	__m128i entries[8];
+	for (int k = 0; k < 8; ++k)
+	{
+		const int* a = palette[k * 2];
+		const int* b = palette[k * 2 + 1];
+		entries[k] = _mm_setr_epi16((short)a[0], (short)a[1], (short)a[2], (short)a[3], (short)b[0], (short)b[1], (short)b[2], (short)b[3]);
+	}
+	const __m128i indexBase = _mm_setr_epi32(0, 1, 2, 3);
+	for (int i = 0; i < 16; ++i)
+	{
+		const uint8_t* p = pPixels[i];
+		__m128i pixel = _mm_setr_epi16(p[0], p[1], p[2], p[3], p[0], p[1], p[2], p[3]);
+		__m128i best = _mm_set1_epi32(0x7FFFFFFF);
+		for (int j = 0; j < 4; ++j)
+		{
+			__m128i d0 = _mm_sub_epi16(entries[j * 2], pixel);
+			__m128i d1 = _mm_sub_epi16(entries[j * 2 + 1], pixel);
+			__m128 m0 = _mm_castsi128_ps(_mm_madd_epi16(d0, d0));
+			__m128 m1 = _mm_castsi128_ps(_mm_madd_epi16(d1, d1));
+			__m128i even = _mm_castps_si128(_mm_shuffle_ps(m0, m1, _MM_SHUFFLE(2, 0, 2, 0)));
+			__m128i odd = _mm_castps_si128(_mm_shuffle_ps(m0, m1, _MM_SHUFFLE(3, 1, 3, 1)));
+			__m128i error = _mm_add_epi32(even, odd);
+			__m128i key = _mm_or_si128(_mm_slli_epi32(error, 4), _mm_add_epi32(indexBase, _mm_set1_epi32(j * 4)));
+			best = minEpi32(best, key);
+		}
+		best = minEpi32(best, _mm_shuffle_epi32(best, _MM_SHUFFLE(1, 0, 3, 2)));
+		best = minEpi32(best, _mm_shuffle_epi32(best, _MM_SHUFFLE(2, 3, 0, 1)));
+		uint32_t key = (uint32_t)_mm_cvtsi128_si32(best);
+		pIndices[i] = (uint8_t)(key & 15);
+		totalError += key >> 4;
+	}
+#else
+	for (int i = 0; i < 16; ++i)
+	{
+		uint32_t bestError = UINT32_MAX;
+		for (int k = 0; k < 16; ++k)
+		{
+			uint32_t error = 0;
+			for (int c = 0; c < 4; ++c)
+			{
+				int d = palette[k][c] - pPixels[i][c];
+				error += (uint32_t)(d * d);
+			}
+			if (error < bestError)
+			{
+				bestError = error;
+				pIndices[i] = (uint8_t)k;
+			}
+		}
+		totalError += bestError;
+	}
+#endif
+	return totalError;
+}
+
+static void evaluateBc7Candidate(const uint8_t pPixels[16][4], Bc7Candidate* pCandidate)
+{
+	int palette[16][4];
+	buildBc7Palette(&pCandidate->mEndpoints, palette);
+	pCandidate->mError = findBc7Indices(pPixels, palette, pCandidate->mIndices);
+}
+
+static void quantizeBc7Endpoint(const float* pColor, int pBit, int* pQuantized)
+{
+	for (int c = 0; c < 4; ++c)
+		pQuantized[c] = std::min(std::max((int)lrintf((pColor[c] - pBit) * 0.5f), 0), 127);
+}
+
+/// <summary>
+/// 量化一对浮点端点; exhaustive 为 false 时各端点独立选择重建误差较小的 p 位, 否则穷举 4 种 p 位组合按整块误差选择
+/// </summary>
+static void quantizeBc7Candidate(const uint8_t pPixels[16][4], const float endpoints[2][4], bool exhaustive, Bc7Candidate* pBest)
+{
+	if (!exhaustive)
+	{
+		for (int e = 0; e < 2; ++e)
+		{
+			float bestError = INFINITY;
+			for (int pBit = 0; pBit < 2; ++pBit)
+			{
+				int quantized[4];
+				quantizeBc7Endpoint(endpoints[e], pBit, quantized);
+				float error = 0.0f;
+				for (int c = 0; c < 4; ++c)
+				{
+					float d = (float)((quantized[c] << 1) | pBit) - endpoints[e][c];
+					error += d * d;
+				}
+				if (error < bestError)
+				{
+					bestError = error;
+					memcpy(pBest->mEndpoints.mQuantized[e], quantized, sizeof(quantized));
+					pBest->mEndpoints.mPBits[e] = pBit;
+				}
+			}
+		}
+		evaluateBc7Candidate(pPixels, pBest);
+		return;
+	}
+
+	pBest->mError = UINT32_MAX;
+	for (int pBits = 0; pBits < 4; ++pBits)
+	{
+		Bc7Candidate candidate;
+		for (int e = 0; e < 2; ++e)
+		{
+			candidate.mEndpoints.mPBits[e] = (pBits >> e) & 1;
+			quantizeBc7Endpoint(endpoints[e], candidate.mEndpoints.mPBits[e], candidate.mEndpoints.mQuantized[e]);
+		}
+		evaluateBc7Candidate(pPixels, &candidate);
+		if (candidate.mError < pBest->mError)
+			*pBest = candidate;
+	}
+}
+
+/// <summary>
+/// 以 RGBA 的主成分方向 (协方差矩阵幂迭代) 为初始直线, 像素投影的最小/最大值为端点
+/// </summary>
+static void fitBc7Principal(const uint8_t pPixels[16][4], float endpoints[2][4])
+{
+	float mean[4] = {};
+	float minimum[4] = { 255.0f, 255.0f, 255.0f, 255.0f };
+	float maximum[4] = {};
+	for (int i = 0; i < 16; ++i)
+	{
+		for (int c = 0; c < 4; ++c)
+		{
+			mean[c] += pPixels[i][c];
+			minimum[c] = std::min(minimum[c], (float)pPixels[i][c]);
+			maximum[c] = std::max(maximum[c], (float)pPixels[i][c]);
+		}
+	}
+	for (int c = 0; c < 4; ++c)
+		mean[c] *= 1.0f / 16.0f;
+
+	float covariance[4][4] = {};
+	for (int i = 0; i < 16; ++i)
+	{
+		float d[4];
+		for (int c = 0; c < 4; ++c)
+			d[c] = pPixels[i][c] - mean[c];
+		for (int r = 0; r < 4; ++r)
+			for (int c = 0; c < 4; ++c)
+				covariance[r][c] += d[r] * d[c];
+	}
+
+	float axis[4];
+	for (int c = 0; c < 4; ++c)
+		axis[c] = maximum[c] - minimum[c];
+	for (int iteration = 0; iteration < 8; ++iteration)
+	{
+		float next[4] = {};
+		for (int r = 0; r < 4; ++r)
+			for (int c = 0; c < 4; ++c)
+				next[r] += covariance[r][c] * axis[c];
+		float length = sqrtf(next[0] * next[0] + next[1] * next[1] + next[2] * next[2] + next[3] * next[3]);
+		if (length < 1e-6f)
+			break;
+		for (int c = 0; c < 4; ++c)
+			axis[c] = next[c] / length;
+	}
+	float axisLength = sqrtf(axis[0] * axis[0] + axis[1] * axis[1] + axis[2] * axis[2] + axis[3] * axis[3]);
+	if (axisLength < 1e-6f)
+	{
+		memcpy(endpoints[0], mean, sizeof(mean));
+		memcpy(endpoints[1], mean, sizeof(mean));
+		return;
+	}
+	for (int c = 0; c < 4; ++c)
+		axis[c] /= axisLength;
+
+	float minT = INFINITY, maxT = -INFINITY;
+	for (int i = 0; i < 16; ++i)
+	{
+		float t = 0.0f;
+		for (int c = 0; c < 4; ++c)
+			t += (pPixels[i][c] - mean[c]) * axis[c];
+		minT = std::min(minT, t);
+		maxT = std::max(maxT, t);
+	}
+	for (int c = 0; c < 4; ++c)
+	{
+		endpoints[0][c] = std::min(std::max(mean[c] + axis[c] * minT, 0.0f), 255.0f);
+		endpoints[1][c] = std::min(std::max(mean[c] + axis[c] * maxT, 0.0f), 255.0f);
+	}
+}
+
+/// <summary>
+/// 固定索引, 按最小二乘求使 sum |(1 - t) a + t b - p|^2 最小的端点 a, b; 所有像素同一索引时无解, 返回 false
+/// </summary>
+static bool refitBc7Endpoints(const uint8_t pPixels[16][4], const uint8_t* pIndices, float endpoints[2][4])
+{
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	float ap[4] = {}, bp[4] = {};
+	for (int i = 0; i < 16; ++i)
+	{
+		float t = BC7_WEIGHTS4[pIndices[i]] * (1.0f / 64.0f);
+		float s = 1.0f - t;
+		aa += s * s;
+		ab += s * t;
+		bb += t * t;
+		for (int c = 0; c < 4; ++c)
+		{
+			ap[c] += s * pPixels[i][c];
+			bp[c] += t * pPixels[i][c];
+		}
+	}
+	float determinant = aa * bb - ab * ab;
+	if (fabsf(determinant) < 1e-6f)
+		return false;
+	float inverse = 1.0f / determinant;
+	for (int c = 0; c < 4; ++c)
+	{
+		endpoints[0][c] = std::min(std::max((bb * ap[c] - ab * bp[c]) * inverse, 0.0f), 255.0f);
+		endpoints[1][c] = std::min(std::max((aa * bp[c] - ab * ap[c]) * inverse, 0.0f), 255.0f);
+	}
+	return true;
+}
+
+// 按 LSB 优先的顺序写入位流
+static void writeBits(uint8_t* pBlock, uint32_t* pBitPosition, uint32_t value, uint32_t bitCount)
+{
+	for (uint32_t i = 0; i < bitCount; ++i, ++*pBitPosition)
+	{
+		if (value >> i & 1)
+			pBlock[*pBitPosition >> 3] |= (uint8_t)(1 << (*pBitPosition & 7));
+	}
+}
+
+/// <summary>
+/// 模式 6 位布局: 模式 (7 位, 0000001) | R0 R1 G0 G1 B0 B1 A0 A1 (各 7 位) | P0 P1 | 索引 (首个 3 位, 其余 4 位)
+/// 首个索引的最高位隐含为 0, 超出时交换端点并翻转全部索引
+/// </summary>
+static void packBc7Mode6(uint8_t* pDst, Bc7Candidate* pCandidate)
+{
+	Bc7Endpoints& endpoints = pCandidate->mEndpoints;
+	if (pCandidate->mIndices[0] & 8)
+	{
+		std::swap(endpoints.mQuantized[0], endpoints.mQuantized[1]);
+		std::swap(endpoints.mPBits[0], endpoints.mPBits[1]);
+		for (int i = 0; i < 16; ++i)
+			pCandidate->mIndices[i] = (uint8_t)(15 - pCandidate->mIndices[i]);
+	}
+
+	memset(pDst, 0, 16);
+	uint32_t bitPosition = 0;
+	writeBits(pDst, &bitPosition, 1 << 6, 7);
+	for (int c = 0; c < 4; ++c)
+	{
+		writeBits(pDst, &bitPosition, (uint32_t)endpoints.mQuantized[0][c], 7);
+		writeBits(pDst, &bitPosition, (uint32_t)endpoints.mQuantized[1][c], 7);
+	}
+	writeBits(pDst, &bitPosition, (uint32_t)endpoints.mPBits[0], 1);
+	writeBits(pDst, &bitPosition, (uint32_t)endpoints.mPBits[1], 1);
+	writeBits(pDst, &bitPosition, pCandidate->mIndices[0], 3);
+	for (int i = 1; i < 16; ++i)
+		writeBits(pDst, &bitPosition, pCandidate->mIndices[i], 4);
+}
+
+/// <summary>
+/// 主成分端点 -> (NORMAL 起) 按当前索引反复最小二乘拟合 -> (HIGH) 逐分量 ±1 搜索量化端点, 始终保留整块误差最小的结果
+/// </summary>
+static void encodeBc7Block(uint8_t* pDst, const uint8_t pPixels[16][4], TextureCompressionQuality quality)
+{
+	bool exhaustive = quality == TEXTURE_COMPRESSION_QUALITY_HIGH;
+	float endpoints[2][4];
+	fitBc7Principal(pPixels, endpoints);
+	Bc7Candidate best;
+	quantizeBc7Candidate(pPixels, endpoints, exhaustive, &best);
+
+	for (int iteration = 0; iteration < BC7_REFINE_ITERATIONS[quality] && best.mError > 0; ++iteration)
+	{
+		if (!refitBc7Endpoints(pPixels, best.mIndices, endpoints))
+			break;
+		Bc7Candidate candidate;
+		quantizeBc7Candidate(pPixels, endpoints, exhaustive, &candidate);
+		if (candidate.mError >= best.mError)
+			break;
+		best = candidate;
+	}
+
+	for (int pass = 0; pass < BC7_SEARCH_PASSES[quality] && best.mError > 0; ++pass)
+	{
+		bool improved = false;
+		for (int e = 0; e < 2; ++e)
+		{
+			for (int c = 0; c < 4; ++c)
+			{
+				for (int step = -1; step <= 1; step += 2)
+				{
+					Bc7Candidate candidate = best;
+					int value = candidate.mEndpoints.mQuantized[e][c] + step;
+					if (value < 0 || value > 127)
+						continue;
+					candidate.mEndpoints.mQuantized[e][c] = value;
+					evaluateBc7Candidate(pPixels, &candidate);
+					if (candidate.mError < best.mError)
+					{
+						best = candidate;
+						improved = true;
+					}
+				}
+			}
+		}
+		if (!improved)
+			break;
+	}
+
+	packBc7Mode6(pDst, &best);
+}
+
+typedef struct TextureCompressContext
+{
+	uint8_t*					pDst;
+	const uint8_t*				pRgba;
+	uint32_t					mWidth;
+	uint32_t					mHeight;
+	TextureCompressionFormat	mFormat;
+	TextureCompressionQuality	mQuality;
+} TextureCompressContext;
+
+// 压缩一行块; 超出图像的像素取最近的边缘像素
+static void compressBlockRow(void* pUserData, uint32_t blockY)
+{
+	SHEN_PROFILE_FUNCTION();
+	const TextureCompressContext* pContext = (const TextureCompressContext*)pUserData;
+	uint32_t blocksX = (pContext->mWidth + 3) / 4;
+	uint32_t blockSize = getCompressedBlockSize(pContext->mFormat);
+	uint8_t* pDst = pContext->pDst + (size_t)blockY * blocksX * blockSize;
+
+	uint8_t pixels[16][4];
+	for (uint32_t blockX = 0; blockX < blocksX; ++blockX, pDst += blockSize)
+	{
+		for (uint32_t y = 0; y < 4; ++y)
+		{
+			uint32_t sourceY = std::min(blockY * 4 + y, pContext->mHeight - 1);
+			for (uint32_t x = 0; x < 4; ++x)
+			{
+				uint32_t sourceX = std::min(blockX * 4 + x, pContext->mWidth - 1);
+				memcpy(pixels[y * 4 + x], pContext->pRgba + ((size_t)sourceY * pContext->mWidth + sourceX) * 4, 4);
+			}
+		}
+
+		int stbMode = pContext->mQuality == TEXTURE_COMPRESSION_QUALITY_HIGH ? STB_DXT_HIGHQUAL : STB_DXT_NORMAL;
+		switch (pContext->mFormat)
+		{
+		case TEXTURE_COMPRESSION_BC1:
+			stb_compress_dxt_block(pDst, pixels[0], 0, stbMode);
+			break;
+		case TEXTURE_COMPRESSION_BC3:
+			stb_compress_dxt_block(pDst, pixels[0], 1, stbMode);
+			break;
+		case TEXTURE_COMPRESSION_BC5:
+		{
+			uint8_t channels[16][2];
+			for (int i = 0; i < 16; ++i)
+			{
+				channels[i][0] = pixels[i][0];
+				channels[i][1] = pixels[i][1];
+			}
+			stb_compress_bc5_block(pDst, channels[0]);
+			break;
+		}
+		default:
+			encodeBc7Block(pDst, pixels, pContext->mQuality);
+			break;
+		}
+	}
+}
+
+void compressTextureLevel(void* pDst, const uint8_t* pRgba, uint32_t width, uint32_t height, TextureCompressionFormat format,
+	TextureCompressionQuality quality)
+{
+	SHEN_PROFILE_FUNCTION();
+	TextureCompressContext context;
+	context.pDst = (uint8_t*)pDst;
+	context.pRgba = pRgba;
+	context.mWidth = width;
+	context.mHeight = height;
+	context.mFormat = format;
+	context.mQuality = quality;
+	parallelFor((height + 3) / 4, compressBlockRow, &context);
+}
+
+/// <summary>
+/// sRGB 与线性之间的转换表: 解码为 256 项浮点, 编码按 12 位线性值查表, 误差不超过 1
+/// </summary>
+typedef struct SrgbTables
+{
+	float	mToLinear[256];
+	uint8_t	mFromLinear[4096];
+
+	SrgbTables()
+	{
+		for (int i = 0; i < 256; ++i)
+		{
+			float c = i / 255.0f;
+			mToLinear[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+		}
+		for (int i = 0; i < 4096; ++i)
+		{
+			float l = i / 4095.0f;
+			float c = l <= 0.0031308f ? l * 12.92f : 1.055f * powf(l, 1.0f / 2.4f) - 0.055f;
+			mFromLinear[i] = (uint8_t)lrintf(c * 255.0f);
+		}
+	}
+} SrgbTables;
+
+static const SrgbTables& getSrgbTables()
+{
+	static const SrgbTables tables;
+	return tables;
+}
+
+/// <summary>
+/// 线性数据: SSE2 每次读两行各 4 个像素, 扩展到 16 位后两行相加, 再把相邻像素相加, (和 + 2) >> 2 精确取整, 输出 2 个像素
+/// sRGB 数据与奇数边长的末尾按标量处理
+/// </summary>
+void downsampleTextureLevel(uint8_t* pDst, const uint8_t* pSrc, uint32_t width, uint32_t height, bool srgb)
+{
+	SHEN_PROFILE_FUNCTION();
+	uint32_t dstWidth = std::max(width / 2, 1u);
+	uint32_t dstHeight = std::max(height / 2, 1u);
+	const SrgbTables& tables = getSrgbTables();
+	for (uint32_t y = 0; y < dstHeight; ++y)
+	{
+		const uint8_t* pRow0 = pSrc + (size_t)std::min(y * 2, height - 1) * width * 4;
+		const uint8_t* pRow1 = pSrc + (size_t)std::min(y * 2 + 1, height - 1) * width * 4;
+		uint8_t* pOut = pDst + (size_t)y * dstWidth * 4;
+		uint32_t x = 0;
+#ifdef TEXTURE_COMPRESSOR_SSE2
+		if (!srgb)
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i two = _mm_set1_epi16(2);
+			for (; x * 2 + 4 <= width && x + 2 <= dstWidth; x += 2)
+			{
+				__m128i row0 = _mm_loadu_si128((const __m128i*)(pRow0 + x * 8));
+				__m128i row1 = _mm_loadu_si128((const __m128i*)(pRow1 + x * 8));
+				__m128i low = _mm_add_epi16(_mm_unpacklo_epi8(row0, zero), _mm_unpacklo_epi8(row1, zero));
+				__m128i high = _mm_add_epi16(_mm_unpackhi_epi8(row0, zero), _mm_unpackhi_epi8(row1, zero));
+				low = _mm_add_epi16(low, _mm_srli_si128(low, 8));
+				high = _mm_add_epi16(high, _mm_srli_si128(high, 8));
+				__m128i sum = _mm_srli_epi16(_mm_add_epi16(_mm_unpacklo_epi64(low, high), two), 2);
+				_mm_storel_epi64((__m128i*)(pOut + x * 4), _mm_packus_epi16(sum, sum));
+			}
+		}
+#endif
+		for (; x < dstWidth; ++x)
+		{
+			uint32_t x0 = std::min(x * 2, width - 1) * 4;
+			uint32_t x1 = std::min(x * 2 + 1, width - 1) * 4;
+			for (uint32_t c = 0; c < 4; ++c)
+			{
+				if (srgb && c < 3)
+				{
+					float sum = tables.mToLinear[pRow0[x0 + c]] + tables.mToLinear[pRow0[x1 + c]] +
+						tables.mToLinear[pRow1[x0 + c]] + tables.mToLinear[pRow1[x1 + c]];
+					pOut[x * 4 + c] = tables.mFromLinear[(int)lrintf(sum * 0.25f * 4095.0f)];
+				}
+				else
+				{
+					pOut[x * 4 + c] = (uint8_t)((pRow0[x0 + c] + pRow0[x1 + c] + pRow1[x0 + c] + pRow1[x1 + c] + 2) >> 2);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+typedef enum TextureCompressionFormat
+{
+	// RGB, 每块 8 字节 (4 bpp), 不保存 alpha
+	TEXTURE_COMPRESSION_BC1 = 0,
+	// RGBA, BC1 颜色 + 独立插值的 alpha, 每块 16 字节
+	TEXTURE_COMPRESSION_BC3,
+	// 两个独立通道 (取 R 与 G), 用于切线空间法线贴图, 每块 16 字节
+	TEXTURE_COMPRESSION_BC5,
+	// RGBA, 质量明显高于 BC1/BC3, 每块 16 字节; 只使用模式 6 (单分区, 7 位端点 + p 位, 4 位索引)
+	TEXTURE_COMPRESSION_BC7,
+	TEXTURE_COMPRESSION_FORMAT_COUNT
+} TextureCompressionFormat;
+
+typedef enum TextureCompressionQuality
+{
+	// 只用主成分方向的端点
+	TEXTURE_COMPRESSION_QUALITY_FAST = 0,
+	// 按最小二乘反复拟合端点
+	TEXTURE_COMPRESSION_QUALITY_NORMAL,
+	// 另外穷举 p 位组合并逐分量搜索量化端点, 约为 NORMAL 的数倍耗时
+	TEXTURE_COMPRESSION_QUALITY_HIGH,
+} TextureCompressionQuality;
+
+// 每个 4x4 块的字节数
+uint32_t getCompressedBlockSize(TextureCompressionFormat format);
+// 一个 mip 层级压缩后的字节数, 边长按 4 向上取整
+size_t getCompressedLevelSize(TextureCompressionFormat format, uint32_t width, uint32_t height);
+
+/// <summary>
+/// 压缩一个 mip 层级, pRgba 为紧密排列的 RGBA8; 边缘不足 4x4 的块复制最后一行/列的像素填满
+/// 各块互不依赖, 按块行在作业系统上并行; BC7 的索引搜索使用 SSE2, BC1/BC3/BC5 由 stb_dxt 编码
+/// </summary>
+void compressTextureLevel(void* pDst, const uint8_t* pRgba, uint32_t width, uint32_t height, TextureCompressionFormat format,
+	TextureCompressionQuality quality);
+
+// 2x2 盒式滤波生成下一级 mip (尺寸减半向下取整, 最小为 1, 与 GPU mip 尺寸一致), 奇数边长时舍弃最后一行/列, 边长为 1 时复制该行/列; srgb 为 true 时颜色在线性空间平均, alpha 始终线性平均
+void downsampleTextureLevel(uint8_t* pDst, const uint8_t* pSrc, uint32_t width, uint32_t height, bool srgb);
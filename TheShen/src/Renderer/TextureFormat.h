@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstdint>
+
+// 烘焙纹理文件 (.stex) 的二进制布局, 由 TextureCooker 写出, loadTextures 映射后直接上传
+// 与 KTX2 相同: 文件头记录 VkFormat 与每个 mip 层级的偏移和大小, 层级数据从最小的一级开始存放,
+// 顺序读取时先得到低分辨率层级; 文件为小端序, 修改任何结构体都必须递增 TEXTURE_FILE_VERSION
+//
+// [TextureFileHeader][对齐填充][mip n-1]...[mip 1][mip 0]
+
+#define TEXTURE_FILE_MAGIC 0x58455453u // "STEX"
+#define TEXTURE_FILE_VERSION 1
+#define TEXTURE_FILE_EXTENSION ".stex"
+// 层级数据的起始偏移按此对齐, 满足 vkCmdCopyBufferToImage 对块大小 (8/16 字节) 的要求
+#define TEXTURE_FILE_LEVEL_ALIGNMENT 16
+// 16 级可容纳 32768x32768 的完整 mip 链
+#define TEXTURE_MAX_MIP_LEVELS 16
+
+/// <summary>
+/// 一个 mip 层级的数据区间, 偏移相对于文件起点, 块压缩格式按 4x4 块紧密排列
+/// </summary>
+typedef struct TextureFileLevel
+{
+	uint64_t mOffset;
+	uint64_t mSize;
+} TextureFileLevel;
+
+/// <summary>
+/// 文件头
+/// </summary>
+typedef struct TextureFileHeader
+{
+	uint32_t			mMagic;
+	uint32_t			mVersion;
+	// VkFormat 的数值, 块压缩格式 (BC1/BC3/BC5/BC7) 或 R8G8B8A8
+	uint32_t			mFormat;
+	uint32_t			mWidth;
+	uint32_t			mHeight;
+	uint32_t			mMipLevels;
+	// 整个文件的字节数, 用于检测截断的文件
+	uint64_t			mFileSize;
+	// 按 mip 层级索引, mLevels[0] 为最大的一级
+	TextureFileLevel	mLevels[TEXTURE_MAX_MIP_LEVELS];
+} TextureFileHeader;
+
+static_assert(sizeof(TextureFileLevel) == 16, "TextureFileLevel layout is part of the .stex format");
+static_assert(sizeof(TextureFileHeader) == 288, "TextureFileHeader layout is part of the .stex format, bump TEXTURE_FILE_VERSION when it changes");
@@ -0,0 +1,525 @@
+#include "TextureLoader.h"
+#include "Core/JobSystem.h"
+#include "Core/Log.h"
+#include "Core/MappedFile.h"
+#include "Core/Memory.h"
+#include "Core/Profiler.h"
+
+// stb_image 的实现在本文件中编译, 其内部分配计入资源类别
+#define STB_IMAGE_IMPLEMENTATION
+#define STBI_MALLOC(size) shen_malloc(MEMORY_CATEGORY_ASSETS, size)
+#define STBI_REALLOC(p, size) shen_realloc(MEMORY_CATEGORY_ASSETS, p, size)
+#define STBI_FREE(p) shen_free(p)
+#include "stb_image.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define TEXTURE_LOADER_SSE2 1
+#endif
+
+// 暂存缓冲中每个纹理的起始偏移对齐, 满足 vkCmdCopyBufferToImage 对 texel 大小与 4 字节的要求
+const uint64_t TEXTURE_STAGING_ALIGNMENT = 16;
+
+/// <summary>
+/// 单个纹理的加载状态, 文件在整次 loadTextures 期间保持映射
+/// </summary>
+typedef struct TextureLoadItem
+{
+	MappedFile	mFile;
+	// 烘焙文件的文件头 (指向映射内存), 未烘焙的图像为空
+	const TextureFileHeader* pCookedHeader;
+	int			mWidth;
+	int			mHeight;
+	int			mChannels;
+	uint64_t	mStagingOffset;
+	uint64_t	mStagingSize;
+	bool		mOpened;
+} TextureLoadItem;
+
+typedef struct TextureLoadContext
+{
+	const TextureLoadDesc*	pDescs;
+	TextureLoadItem*		pItems;
+	// 当前批次的第一个纹理与暂存缓冲的映射地址
+	uint32_t				mBatchBegin;
+	uint8_t*				pStagingData;
+	std::atomic<bool>		mFailed;
+} TextureLoadContext;
+
+/// <summary>
+/// RGB8 扩展为 RGBA8, alpha 为 255
+/// SSE2 一次读 16 字节处理 4 个像素: 像素 k 位于源的 3k 字节处, 整体左移 k 字节即落到目标的 4k 字节处, 掩码取出后合并
+/// 每次读取越过 4 个像素的 12 字节, 因此至少剩余 6 个像素时才走向量路径
+/// </summary>
+static void expandRgbToRgba(uint8_t* pDst, const uint8_t* pSrc, size_t pixelCount)
+{
+	size_t i = 0;
+#ifdef TEXTURE_LOADER_SSE2
+	const __m128i mask0 = _mm_setr_epi32(0x00FFFFFF, 0, 0, 0);
+	const __m128i mask1 = _mm_setr_epi32(0, 0x00FFFFFF, 0, 0);
+	const __m128i mask2 = _mm_setr_epi32(0, 0, 0x00FFFFFF, 0);
+	const __m128i mask3 = _mm_setr_epi32(0, 0, 0, 0x00FFFFFF);
+	const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+	for (; i + 6 <= pixelCount; i += 4)
+	{
+		__m128i rgb = _mm_loadu_si128((const __m128i*)(pSrc + i * 3));
+		__m128i rgba = _mm_or_si128(_mm_and_si128(rgb, mask0), _mm_and_si128(_mm_slli_si128(rgb, 1), mask1));
+		rgba = _mm_or_si128(rgba, _mm_and_si128(_mm_slli_si128(rgb, 2), mask2));
+		rgba = _mm_or_si128(rgba, _mm_and_si128(_mm_slli_si128(rgb, 3), mask3));
+		_mm_storeu_si128((__m128i*)(pDst + i * 4), _mm_or_si128(rgba, alpha));
+	}
+#endif
+	for (; i < pixelCount; ++i)
+	{
+		pDst[i * 4 + 0] = pSrc[i * 3 + 0];
+		pDst[i * 4 + 1] = pSrc[i * 3 + 1];
+		pDst[i * 4 + 2] = pSrc[i * 3 + 2];
+		pDst[i * 4 + 3] = 255;
+	}
+}
+
+// stb 的部分出错路径不设置原因字符串
+static const char* getDecodeFailureReason()
+{
+	const char* pReason = stbi_failure_reason();
+	return pReason && *pReason ? pReason : "corrupt image data";
+}
+
+static bool isCookedTextureFile(const char* pFileName)
+{
+	size_t length = strlen(pFileName);
+	size_t extensionLength = strlen(TEXTURE_FILE_EXTENSION);
+	return length >= extensionLength && !strcmp(pFileName + length - extensionLength, TEXTURE_FILE_EXTENSION);
+}
+
+// 烘焙文件允许的格式与每块 (4x4, 非压缩格式为单个像素) 的字节数, 不支持的格式返回 0
+static uint32_t getCookedFormatBlockSize(VkFormat format, uint32_t* pBlockDimension)
+{
+	*pBlockDimension = 4;
+	switch (format)
+	{
+	case VK_FORMAT_BC1_RGB_UNORM_BLOCK:
+	case VK_FORMAT_BC1_RGB_SRGB_BLOCK:
+		return 8;
+	case VK_FORMAT_BC3_UNORM_BLOCK:
+	case VK_FORMAT_BC3_SRGB_BLOCK:
+	case VK_FORMAT_BC5_UNORM_BLOCK:
+	case VK_FORMAT_BC7_UNORM_BLOCK:
+	case VK_FORMAT_BC7_SRGB_BLOCK:
+		return 16;
+	case VK_FORMAT_R8G8B8A8_UNORM:
+	case VK_FORMAT_R8G8B8A8_SRGB:
+		*pBlockDimension = 1;
+		return 4;
+	default:
+		return 0;
+	}
+}
+
+static bool isBlockCompressedFormat(VkFormat format)
+{
+	uint32_t blockDimension;
+	return getCookedFormatBlockSize(format, &blockDimension) && blockDimension == 4;
+}
+
+/// <summary>
+/// 校验映射的烘焙文件, 流式加载在打开文件时同样调用
+/// </summary>
+bool validateTextureFile(const char* pFileName, const MappedFile* pFile)
+{
+	if (pFile->mSize < sizeof(TextureFileHeader))
+	{
+		SHEN_CORE_ERROR("{0} is too small to be a texture file", pFileName);
+		return false;
+	}
+	const TextureFileHeader* pHeader = (const TextureFileHeader*)pFile->pData;
+	if (pHeader->mMagic != TEXTURE_FILE_MAGIC)
+	{
+		SHEN_CORE_ERROR("{0} is not a texture file", pFileName);
+		return false;
+	}
+	if (pHeader->mVersion != TEXTURE_FILE_VERSION)
+	{
+		SHEN_CORE_ERROR("{0} has version {1}, expected {2}; re-cook it with TextureCooker", pFileName, pHeader->mVersion, TEXTURE_FILE_VERSION);
+		return false;
+	}
+	uint32_t blockDimension;
+	uint32_t blockSize = getCookedFormatBlockSize((VkFormat)pHeader->mFormat, &blockDimension);
+	if (blockSize == 0)
+	{
+		SHEN_CORE_ERROR("{0} has an unsupported format {1}", pFileName, pHeader->mFormat);
+		return false;
+	}
+	if (pHeader->mFileSize != pFile->mSize || pHeader->mWidth == 0 || pHeader->mHeight == 0 ||
+		pHeader->mMipLevels == 0 || pHeader->mMipLevels > TEXTURE_MAX_MIP_LEVELS ||
+		std::max(pHeader->mWidth, pHeader->mHeight) >> (pHeader->mMipLevels - 1) == 0)
+	{
+		SHEN_CORE_ERROR("{0} is truncated or corrupt", pFileName);
+		return false;
+	}
+	// 层级从最小的一级开始连续存放, 整段数据一次拷贝
+	for (uint32_t level = 0; level < pHeader->mMipLevels; ++level)
+	{
+		const TextureFileLevel& range = pHeader->mLevels[level];
+		uint64_t width = std::max(pHeader->mWidth >> level, 1u);
+		uint64_t height = std::max(pHeader->mHeight >> level, 1u);
+		uint64_t expectedSize = (width + blockDimension - 1) / blockDimension * ((height + blockDimension - 1) / blockDimension) * blockSize;
+		bool ordered = level == 0 || range.mOffset < pHeader->mLevels[level - 1].mOffset;
+		if (range.mSize != expectedSize || range.mOffset % TEXTURE_FILE_LEVEL_ALIGNMENT != 0 || range.mOffset < sizeof(TextureFileHeader) ||
+			range.mOffset + range.mSize > pFile->mSize || !ordered)
+		{
+			SHEN_CORE_ERROR("{0} has an out of range mip level {1}", pFileName, level);
+			return false;
+		}
+	}
+	return true;
+}
+
+/// <summary>
+/// 映射文件并只解析文件头, 用于在解码前确定尺寸与暂存缓冲布局
+/// 烘焙文件的暂存区覆盖从最小一级到 mip 0 末尾的整段数据, 未烘焙的图像为解码后的 RGBA8
+/// </summary>
+static void openTextureFile(void* pUserData, uint32_t index)
+{
+	SHEN_PROFILE_FUNCTION();
+	TextureLoadContext* pContext = (TextureLoadContext*)pUserData;
+	TextureLoadItem* pItem = &pContext->pItems[index];
+	const char* pFileName = pContext->pDescs[index].pFileName;
+	if (!openMappedFile(pFileName, true, &pItem->mFile))
+	{
+		pContext->mFailed = true;
+		return;
+	}
+	pItem->mOpened = true;
+	if (isCookedTextureFile(pFileName))
+	{
+		if (!validateTextureFile(pFileName, &pItem->mFile))
+		{
+			pContext->mFailed = true;
+			return;
+		}
+		const TextureFileHeader* pHeader = (const TextureFileHeader*)pItem->mFile.pData;
+		pItem->pCookedHeader = pHeader;
+		pItem->mWidth = (int)pHeader->mWidth;
+		pItem->mHeight = (int)pHeader->mHeight;
+		pItem->mStagingSize = pHeader->mLevels[0].mOffset + pHeader->mLevels[0].mSize - pHeader->mLevels[pHeader->mMipLevels - 1].mOffset;
+		return;
+	}
+	if (!stbi_info_from_memory(pItem->mFile.pData, (int)pItem->mFile.mSize, &pItem->mWidth, &pItem->mHeight, &pItem->mChannels))
+	{
+		SHEN_CORE_ERROR("failed to read texture {0}: {1}", pFileName, getDecodeFailureReason());
+		pContext->mFailed = true;
+		return;
+	}
+	pItem->mStagingSize = (uint64_t)pItem->mWidth * pItem->mHeight * 4;
+}
+
+/// <summary>
+/// 解码到暂存缓冲; 三通道图像由 stb 输出紧密的 RGB 后向量化扩展, 其余通道数由 stb 直接转换为 RGBA
+/// 烘焙文件的压缩块原样拷贝; 暂存缓冲为写合并内存, 只顺序写入不回读
+/// </summary>
+static void decodeTexture(void* pUserData, uint32_t batchIndex)
+{
+	SHEN_PROFILE_FUNCTION();
+	TextureLoadContext* pContext = (TextureLoadContext*)pUserData;
+	uint32_t index = pContext->mBatchBegin + batchIndex;
+	TextureLoadItem* pItem = &pContext->pItems[index];
+	if (pItem->pCookedHeader)
+	{
+		const TextureFileHeader* pHeader = pItem->pCookedHeader;
+		memcpy(pContext->pStagingData + pItem->mStagingOffset, pItem->mFile.pData + pHeader->mLevels[pHeader->mMipLevels - 1].mOffset, pItem->mStagingSize);
+		return;
+	}
+
+	int width, height, channels;
+	int desiredChannels = pItem->mChannels == 3 ? 3 : 4;
+	stbi_uc* pPixels = stbi_load_from_memory(pItem->mFile.pData, (int)pItem->mFile.mSize, &width, &height, &channels, desiredChannels);
+	if (!pPixels || width != pItem->mWidth || height != pItem->mHeight)
+	{
+		SHEN_CORE_ERROR("failed to decode texture {0}: {1}", pContext->pDescs[index].pFileName, pPixels ? "size mismatch" : getDecodeFailureReason());
+		stbi_image_free(pPixels);
+		pContext->mFailed = true;
+		return;
+	}
+
+	size_t pixelCount = (size_t)width * height;
+	uint8_t* pDst = pContext->pStagingData + pItem->mStagingOffset;
+	if (desiredChannels == 3)
+		expandRgbToRgba(pDst, pPixels, pixelCount);
+	else
+		memcpy(pDst, pPixels, pixelCount * 4);
+	stbi_image_free(pPixels);
+}
+
+/// <summary>
+/// 录制并提交一批纹理的上传: 整张图转为 TRANSFER_DST
+/// 烘焙文件逐级拷贝后转为着色器只读; 其余拷贝 mip 0, 再由 cmdGenerateMipmaps 生成其余层级并转为着色器只读
+/// </summary>
+static void uploadTextures(Renderer* pRenderer, Queue* pQueue, Buffer* pStagingBuffer, const TextureLoadItem* pItems, Texture** ppTextures, uint32_t count)
+{
+	SHEN_PROFILE_FUNCTION();
+	CmdPoolDesc cmdPoolDesc = {};
+	cmdPoolDesc.pQueue = pQueue;
+	cmdPoolDesc.mTransient = true;
+	CmdPool* pCmdPool;
+	addCmdPool(pRenderer, &cmdPoolDesc, &pCmdPool);
+	CmdDesc cmdDesc = {};
+	cmdDesc.pPool = pCmdPool;
+	Cmd* pCmd;
+	addCmd(pRenderer, &cmdDesc, &pCmd);
+
+	beginCmd(pCmd);
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		cmdTextureBarrier(pCmd, ppTextures[i], VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+		const TextureFileHeader* pHeader = pItems[i].pCookedHeader;
+		if (pHeader)
+		{
+			uint64_t dataBegin = pHeader->mLevels[pHeader->mMipLevels - 1].mOffset;
+			for (uint32_t level = 0; level < pHeader->mMipLevels; ++level)
+				cmdCopyBufferToTexture(pCmd, ppTextures[i], level, pStagingBuffer, pItems[i].mStagingOffset + pHeader->mLevels[level].mOffset - dataBegin);
+			cmdTextureBarrier(pCmd, ppTextures[i], VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		}
+		else
+		{
+			cmdCopyBufferToTexture(pCmd, ppTextures[i], 0, pStagingBuffer, pItems[i].mStagingOffset);
+			cmdGenerateMipmaps(pCmd, ppTextures[i]);
+		}
+	}
+	endCmd(pCmd);
+
+	QueueSubmitDesc submitDesc = {};
+	submitDesc.ppCmds = &pCmd;
+	submitDesc.mCmdCount = 1;
+	queueSubmit(pQueue, &submitDesc);
+	waitQueueIdle(pQueue);
+
+	removeCmd(pRenderer, pCmd);
+	removeCmdPool(pRenderer, pCmdPool);
+}
+
+static void closeTextureFiles(TextureLoadItem* pItems, uint32_t count)
+{
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		if (pItems[i].mOpened)
+			closeMappedFile(&pItems[i].mFile);
+	}
+}
+
+/// <summary>
+/// 1. 并行映射全部文件并解析图像头
+/// 2. 按暂存预算切分批次; 每批在主线程创建纹理与暂存缓冲, 并行解码写入暂存缓冲, 然后一次提交上传
+/// 创建 Vulkan 对象与录制命令都在调用线程上完成, 工作线程只接触文件与暂存内存
+/// </summary>
+void loadTextures(Renderer* pRenderer, Queue* pQueue, const TextureLoadDesc* pDescs, uint32_t count, Texture** ppTextures)
+{
+	SHEN_PROFILE_FUNCTION();
+	if (count == 0)
+		return;
+
+	TextureLoadItem* pItems = (TextureLoadItem*)shen_calloc(MEMORY_CATEGORY_ASSETS, count, sizeof(TextureLoadItem));
+	TextureLoadContext context;
+	context.pDescs = pDescs;
+	context.pItems = pItems;
+	context.mBatchBegin = 0;
+	context.pStagingData = NULL;
+	context.mFailed = false;
+	parallelFor(count, openTextureFile, &context);
+
+	uint32_t loaded = 0;
+	uint64_t totalBytes = 0;
+	Buffer* pStagingBuffer = NULL;
+	try
+	{
+		if (context.mFailed)
+			throw std::runtime_error("failed to load texture!");
+
+		while (loaded < count)
+		{
+			uint32_t batchBegin = loaded;
+			uint64_t stagingSize = 0;
+			do
+			{
+				TextureLoadItem* pItem = &pItems[loaded];
+				if (loaded > batchBegin && stagingSize + pItem->mStagingSize > TEXTURE_LOADER_STAGING_BUDGET)
+					break;
+				pItem->mStagingOffset = stagingSize;
+				stagingSize = (stagingSize + pItem->mStagingSize + TEXTURE_STAGING_ALIGNMENT - 1) & ~(TEXTURE_STAGING_ALIGNMENT - 1);
+
+				TextureDesc textureDesc = {};
+				textureDesc.mWidth = (uint32_t)pItem->mWidth;
+				textureDesc.mHeight = (uint32_t)pItem->mHeight;
+				if (pItem->pCookedHeader)
+				{
+					textureDesc.mMipLevels = pItem->pCookedHeader->mMipLevels;
+					textureDesc.mFormat = (VkFormat)pItem->pCookedHeader->mFormat;
+					if (isBlockCompressedFormat(textureDesc.mFormat) && !pRenderer->mCapabilities.mTextureCompressionBC)
+					{
+						SHEN_CORE_ERROR("{0} is block compressed but the device does not support BC textures", pDescs[loaded].pFileName);
+						throw std::runtime_error("failed to load texture!");
+					}
+				}
+				else
+				{
+					textureDesc.mMipLevels = pDescs[loaded].mFlags & TEXTURE_LOAD_FLAG_GENERATE_MIPS ? 0 : 1;
+					textureDesc.mFormat = pDescs[loaded].mFlags & TEXTURE_LOAD_FLAG_SRGB ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+				}
+				addTexture(pRenderer, &textureDesc, &ppTextures[loaded]);
+				++loaded;
+			} while (loaded < count);
+
+			BufferDesc stagingDesc = {};
+			stagingDesc.mSize = stagingSize;
+			stagingDesc.mUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+			stagingDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+			addBuffer(pRenderer, &stagingDesc, &pStagingBuffer);
+
+			context.mBatchBegin = batchBegin;
+			context.pStagingData = (uint8_t*)pStagingBuffer->pCpuMappedAddress;
+			parallelFor(loaded - batchBegin, decodeTexture, &context);
+			if (context.mFailed)
+				throw std::runtime_error("failed to load texture!");
+
+			uploadTextures(pRenderer, pQueue, pStagingBuffer, pItems + batchBegin, ppTextures + batchBegin, loaded - batchBegin);
+			removeBuffer(pRenderer, pStagingBuffer);
+			pStagingBuffer = NULL;
+			totalBytes += stagingSize;
+		}
+	}
+	catch (...)
+	{
+		if (pStagingBuffer)
+			removeBuffer(pRenderer, pStagingBuffer);
+		for (uint32_t i = 0; i < loaded; ++i)
+		{
+			removeTexture(pRenderer, ppTextures[i]);
+			ppTextures[i] = NULL;
+		}
+		closeTextureFiles(pItems, count);
+		shen_free(pItems);
+		throw;
+	}
+
+	closeTextureFiles(pItems, count);
+	shen_free(pItems);
+	SHEN_CORE_TRACE("loaded {0} textures ({1:.1f} MB) on {2} threads", count, totalBytes / (1024.0 * 1024.0), getJobThreadCount());
+}
+
+void loadTexture(Renderer* pRenderer, Queue* pQueue, const TextureLoadDesc* pDesc, Texture** ppTexture)
+{
+	loadTextures(pRenderer, pQueue, pDesc, 1, ppTexture);
+}
+
+static VkFormat getCompressedVkFormat(TextureCompressionFormat format, bool srgb)
+{
+	switch (format)
+	{
+	case TEXTURE_COMPRESSION_BC1:
+		return srgb ? VK_FORMAT_BC1_RGB_SRGB_BLOCK : VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+	case TEXTURE_COMPRESSION_BC3:
+		return srgb ? VK_FORMAT_BC3_SRGB_BLOCK : VK_FORMAT_BC3_UNORM_BLOCK;
+	case TEXTURE_COMPRESSION_BC5:
+		return VK_FORMAT_BC5_UNORM_BLOCK;
+	default:
+		return srgb ? VK_FORMAT_BC7_SRGB_BLOCK : VK_FORMAT_BC7_UNORM_BLOCK;
+	}
+}
+
+/// <summary>
+/// 文件中层级从最小的一级开始存放, mip 0 位于文件末尾; 每一级压缩完成后由它滤波出下一级, 只保留两级 RGBA 像素
+/// </summary>
+bool cookTexture(const char* pSrcFileName, const char* pDstFileName, TextureCompressionFormat format, TextureCompressionQuality quality,
+	uint32_t flags)
+{
+	SHEN_PROFILE_FUNCTION();
+	MappedFile file;
+	if (!openMappedFile(pSrcFileName, true, &file))
+		return false;
+	int width, height, channels;
+	uint8_t* pPixels = stbi_load_from_memory(file.pData, (int)file.mSize, &width, &height, &channels, 4);
+	closeMappedFile(&file);
+	if (!pPixels)
+	{
+		SHEN_CORE_ERROR("failed to read texture {0}: {1}", pSrcFileName, getDecodeFailureReason());
+		return false;
+	}
+
+	bool srgb = (flags & TEXTURE_LOAD_FLAG_SRGB) && format != TEXTURE_COMPRESSION_BC5;
+	uint32_t fullChainLevels = 1;
+	while (std::max(width, height) >> fullChainLevels)
+		++fullChainLevels;
+	if (fullChainLevels > TEXTURE_MAX_MIP_LEVELS)
+	{
+		SHEN_CORE_ERROR("{0} is {1}x{2}, larger than the texture file supports", pSrcFileName, width, height);
+		stbi_image_free(pPixels);
+		return false;
+	}
+
+	TextureFileHeader header = {};
+	header.mMagic = TEXTURE_FILE_MAGIC;
+	header.mVersion = TEXTURE_FILE_VERSION;
+	header.mFormat = (uint32_t)getCompressedVkFormat(format, srgb);
+	header.mWidth = (uint32_t)width;
+	header.mHeight = (uint32_t)height;
+	header.mMipLevels = flags & TEXTURE_LOAD_FLAG_GENERATE_MIPS ? fullChainLevels : 1;
+	uint64_t offset = sizeof(TextureFileHeader);
+	for (uint32_t level = header.mMipLevels; level-- > 0;)
+	{
+		offset = (offset + TEXTURE_FILE_LEVEL_ALIGNMENT - 1) & ~(uint64_t)(TEXTURE_FILE_LEVEL_ALIGNMENT - 1);
+		header.mLevels[level].mOffset = offset;
+		header.mLevels[level].mSize = getCompressedLevelSize(format, std::max(header.mWidth >> level, 1u), std::max(header.mHeight >> level, 1u));
+		offset += header.mLevels[level].mSize;
+	}
+	header.mFileSize = offset;
+
+	// 压缩结果按文件布局排列, 写出时只需一次 fwrite
+	uint64_t dataBegin = header.mLevels[header.mMipLevels - 1].mOffset;
+	uint8_t* pData = (uint8_t*)shen_calloc(MEMORY_CATEGORY_ASSETS, header.mFileSize - dataBegin, 1);
+	// 下一级写入另一块缓冲后交换, 源图像的缓冲从第二级起复用为滤波目标
+	uint8_t* pScratch = NULL;
+	if (header.mMipLevels > 1)
+		pScratch = (uint8_t*)shen_malloc(MEMORY_CATEGORY_ASSETS, (size_t)std::max(width / 2, 1) * std::max(height / 2, 1) * 4);
+	uint8_t* pLevelPixels = pPixels;
+	uint8_t* pNextPixels = pScratch;
+	for (uint32_t level = 0; level < header.mMipLevels; ++level)
+	{
+		uint32_t levelWidth = std::max(header.mWidth >> level, 1u);
+		uint32_t levelHeight = std::max(header.mHeight >> level, 1u);
+		compressTextureLevel(pData + header.mLevels[level].mOffset - dataBegin, pLevelPixels, levelWidth, levelHeight, format, quality);
+		if (level + 1 < header.mMipLevels)
+		{
+			downsampleTextureLevel(pNextPixels, pLevelPixels, levelWidth, levelHeight, srgb);
+			std::swap(pLevelPixels, pNextPixels);
+		}
+	}
+	stbi_image_free(pPixels);
+	if (pScratch)
+		shen_free(pScratch);
+
+	FILE* pFile = fopen(pDstFileName, "wb");
+	if (!pFile)
+	{
+		SHEN_CORE_ERROR("failed to create {0}", pDstFileName);
+		shen_free(pData);
+		return false;
+	}
+	static const uint8_t padding[TEXTURE_FILE_LEVEL_ALIGNMENT] = {};
+	bool written =
+		fwrite(&header, sizeof(header), 1, pFile) == 1 &&
+		fwrite(padding, 1, dataBegin - sizeof(header), pFile) == dataBegin - sizeof(header) &&
+		fwrite(pData, 1, header.mFileSize - dataBegin, pFile) == header.mFileSize - dataBegin;
+	written = fclose(pFile) == 0 && written;
+	shen_free(pData);
+	if (!written)
+	{
+		SHEN_CORE_ERROR("failed to write {0}", pDstFileName);
+		remove(pDstFileName);
+	}
+	return written;
+}
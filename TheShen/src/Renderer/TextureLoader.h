@@ -0,0 +1,46 @@
+#pragma once
+
+#include "Renderer.h"
+#include "Core/MappedFile.h"
+#include "TextureCompressor.h"
+#include "TextureFormat.h"
+
+// 一批上传使用的暂存缓冲上限 (字节), 单个纹理超过上限时独占一批
+#define TEXTURE_LOADER_STAGING_BUDGET (256ull << 20)
+
+typedef enum TextureLoadFlags
+{
+	TEXTURE_LOAD_FLAG_NONE = 0,
+	// 像素按 sRGB 编码 (颜色贴图), 使用 _SRGB 格式由采样器转换到线性空间; 法线、粗糙度等数据贴图不要设置
+	TEXTURE_LOAD_FLAG_SRGB = 1 << 0,
+	// 生成完整 mip 链: 加载图像时在 GPU 上逐级 blit, 烘焙时在 CPU 上滤波后逐级压缩
+	TEXTURE_LOAD_FLAG_GENERATE_MIPS = 1 << 1,
+} TextureLoadFlags;
+
+/// <summary>
+/// 纹理文件描述
+/// .stex (TextureCooker 的输出) 映射后把各 mip 层级的压缩块直接拷贝到暂存缓冲, 格式与 mip 链由文件决定
+/// 其余文件交给 stb_image 解码 (PNG, JPEG, TGA, BMP, PSD, GIF, HDR, PIC, PNM), 全部转为 RGBA8, 16 位与 HDR 图像会被转换到 8 位
+/// </summary>
+typedef struct TextureLoadDesc
+{
+	const char*	pFileName;
+	// TextureLoadFlags, 只作用于未烘焙的图像
+	uint32_t	mFlags;
+} TextureLoadDesc;
+
+/// <summary>
+/// 批量加载纹理: 文件映射与解码在作业系统上并行, 解码结果直接写入暂存缓冲, 每批录制一次上传
+/// 暂存缓冲按 TEXTURE_LOADER_STAGING_BUDGET 分批, 每批提交后等待 pQueue 空闲; 返回时纹理处于 SHADER_READ_ONLY_OPTIMAL
+/// mip 由 vkCmdBlitImage 生成, pQueue 需为图形队列; 块压缩格式要求设备支持 textureCompressionBC
+/// 任一文件无法解码时释放已创建的纹理并抛出异常
+/// </summary>
+void loadTextures(Renderer* pRenderer, Queue* pQueue, const TextureLoadDesc* pDescs, uint32_t count, Texture** ppTextures);
+// 加载单个纹理, 只能利用一个线程解码; 多个纹理应合并为一次 loadTextures
+void loadTexture(Renderer* pRenderer, Queue* pQueue, const TextureLoadDesc* pDesc, Texture** ppTexture);
+// 校验映射的 .stex 文件: 格式受支持, 每个层级的大小与尺寸相符且落在文件内; 失败时记录原因并返回 false
+bool validateTextureFile(const char* pFileName, const MappedFile* pFile);
+// 解码图像, 按需在 CPU 上生成 mip 链并逐级压缩, 写出 .stex 文件 (见 TextureFormat.h); 失败时返回 false
+// flags 为 TextureLoadFlags; BC5 保存的是数据而非颜色, 忽略 TEXTURE_LOAD_FLAG_SRGB
+bool cookTexture(const char* pSrcFileName, const char* pDstFileName, TextureCompressionFormat format, TextureCompressionQuality quality,
+	uint32_t flags);
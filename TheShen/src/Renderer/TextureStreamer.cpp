@@ -0,0 +1,531 @@
+#include "TextureStreamer.h"
+#include "TextureFormat.h"
+#include "TextureLoader.h"
+#include "Core/Log.h"
+#include "Core/Memory.h"
+#include "Core/Profiler.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+// 暂存缓冲中每个纹理的起始偏移对齐, 满足 vkCmdCopyBufferToImage 对块大小的要求
+const uint64_t TEXTURE_STREAMING_STAGING_ALIGNMENT = 16;
+// 本帧没有请求时 mRequestedMip 的取值
+const uint32_t TEXTURE_STREAMING_NO_REQUEST = UINT32_MAX;
+
+/// <summary>
+/// 单个流式纹理; 文件在纹理的整个生命周期内保持映射, 升级时直接从映射内存拷贝到暂存缓冲
+/// </summary>
+typedef struct StreamedTexture
+{
+	TextureStreamer*			pStreamer;
+	MappedFile					mFile;
+	const TextureFileHeader*	pHeader;
+	// 当前可采样的纹理, 覆盖完整 mip 链中的 [mResidentMip, mMipLevels)
+	Texture*					pTexture;
+	// 上传中的纹理, 栅栏完成后替换 pTexture
+	Texture*					pPendingTexture;
+	uint32_t					mResidentMip;
+	uint32_t					mPendingMip;
+	// 最长边不超过 TEXTURE_STREAMING_TAIL_SIZE 的第一级, 常驻层级不会低于它
+	uint32_t					mTailMip;
+	// 本帧请求的层级, 没有请求时为 TEXTURE_STREAMING_NO_REQUEST
+	uint32_t					mRequestedMip;
+	// 最近一次请求的层级, 预算足够时保持该层级常驻
+	uint32_t					mWantedMip;
+	// 规划本帧预算时分配到的层级
+	uint32_t					mTargetMip;
+	uint64_t					mLastRequestFrame;
+	// 在 TextureStreamer::mTextures 中的位置
+	uint32_t					mIndex;
+	// 上传仍在途时被移除, 上传完成后释放
+	bool						mRemoved;
+} StreamedTexture;
+
+typedef struct RetiredTexture
+{
+	Texture*	pTexture;
+	// 被替换时的帧序号
+	uint64_t	mFrameIndex;
+} RetiredTexture;
+
+typedef struct TextureStreamer
+{
+	Renderer*							pRenderer;
+	Queue*								pQueue;
+	CmdPool*							pCmdPool;
+	Cmd*								pCmd;
+	Fence*								pFence;
+	// 常驻的暂存缓冲, 同一时间只有一批上传在途, 栅栏完成后复用
+	Buffer*								pStagingBuffer;
+	uint64_t							mUploadBudget;
+	uint64_t							mMemoryBudget;
+	uint32_t							mFramesInFlight;
+	std::vector<StreamedTexture*>		mTextures;
+	// 在途一批上传中的纹理
+	std::vector<StreamedTexture*>		mPendingTextures;
+	std::vector<RetiredTexture>			mRetiredTextures;
+	// 按最近请求帧排序的规划顺序, 每帧复用
+	std::vector<StreamedTexture*>		mPlanOrder;
+	// 实际分配与文件中层级数据大小之差的平均值 (对齐、元数据), 规划时计入每个纹理
+	uint64_t							mTextureOverhead;
+	uint64_t							mFrameIndex;
+	uint64_t							mResidentBytes;
+	TextureStreamerStats				mStats;
+	bool								mUploadInFlight;
+} TextureStreamer;
+
+/// <summary>
+/// 层级 [topMip, mMipLevels) 在文件中是一段连续区间 (从最小的一级开始存放), 大小即上传量, 也作为显存占用的估计
+/// </summary>
+static uint64_t getMipChainSize(const TextureFileHeader* pHeader, uint32_t topMip)
+{
+	return pHeader->mLevels[topMip].mOffset + pHeader->mLevels[topMip].mSize - pHeader->mLevels[pHeader->mMipLevels - 1].mOffset;
+}
+
+static uint64_t alignStagingOffset(uint64_t offset)
+{
+	return (offset + TEXTURE_STREAMING_STAGING_ALIGNMENT - 1) & ~(TEXTURE_STREAMING_STAGING_ALIGNMENT - 1);
+}
+
+static void retireTexture(TextureStreamer* pStreamer, Texture* pTexture)
+{
+	RetiredTexture retired;
+	retired.pTexture = pTexture;
+	retired.mFrameIndex = pStreamer->mFrameIndex;
+	pStreamer->mRetiredTextures.push_back(retired);
+}
+
+/// <summary>
+/// 释放在途帧已全部结束的旧纹理; force 为 true 时 (队列已空闲) 全部释放
+/// </summary>
+static void releaseRetiredTextures(TextureStreamer* pStreamer, bool force)
+{
+	size_t kept = 0;
+	for (size_t i = 0; i < pStreamer->mRetiredTextures.size(); ++i)
+	{
+		RetiredTexture retired = pStreamer->mRetiredTextures[i];
+		if (force || retired.mFrameIndex + pStreamer->mFramesInFlight <= pStreamer->mFrameIndex)
+		{
+			pStreamer->mResidentBytes -= retired.pTexture->mMemorySize;
+			removeTexture(pStreamer->pRenderer, retired.pTexture);
+		}
+		else
+			pStreamer->mRetiredTextures[kept++] = retired;
+	}
+	pStreamer->mRetiredTextures.resize(kept);
+}
+
+static void freeStreamedTexture(StreamedTexture* pTexture)
+{
+	closeMappedFile(&pTexture->mFile);
+	shen_delete(pTexture);
+}
+
+static void ensureStagingCapacity(TextureStreamer* pStreamer, uint64_t size)
+{
+	if (pStreamer->pStagingBuffer && pStreamer->pStagingBuffer->mSize >= size)
+		return;
+	if (pStreamer->pStagingBuffer)
+		removeBuffer(pStreamer->pRenderer, pStreamer->pStagingBuffer);
+	BufferDesc stagingDesc = {};
+	stagingDesc.mSize = size;
+	stagingDesc.mUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	stagingDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+	addBuffer(pStreamer->pRenderer, &stagingDesc, &pStreamer->pStagingBuffer);
+}
+
+/// <summary>
+/// 创建覆盖 [topMip, mMipLevels) 的纹理, 从映射文件拷贝到暂存缓冲并录制逐级拷贝, 录制结束时纹理处于着色器只读布局
+/// </summary>
+static Texture* recordMipChainUpload(TextureStreamer* pStreamer, Cmd* pCmd, Buffer* pStagingBuffer, uint64_t stagingOffset,
+	const StreamedTexture* pTexture, uint32_t topMip)
+{
+	const TextureFileHeader* pHeader = pTexture->pHeader;
+	TextureDesc textureDesc = {};
+	textureDesc.mWidth = std::max(pHeader->mWidth >> topMip, 1u);
+	textureDesc.mHeight = std::max(pHeader->mHeight >> topMip, 1u);
+	textureDesc.mMipLevels = pHeader->mMipLevels - topMip;
+	textureDesc.mFormat = (VkFormat)pHeader->mFormat;
+	Texture* pNewTexture;
+	addTexture(pStreamer->pRenderer, &textureDesc, &pNewTexture);
+	pStreamer->mResidentBytes += pNewTexture->mMemorySize;
+
+	uint64_t dataBegin = pHeader->mLevels[pHeader->mMipLevels - 1].mOffset;
+	memcpy((uint8_t*)pStagingBuffer->pCpuMappedAddress + stagingOffset, pTexture->mFile.pData + dataBegin, getMipChainSize(pHeader, topMip));
+	cmdTextureBarrier(pCmd, pNewTexture, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
+	for (uint32_t level = topMip; level < pHeader->mMipLevels; ++level)
+		cmdCopyBufferToTexture(pCmd, pNewTexture, level - topMip, pStagingBuffer, stagingOffset + pHeader->mLevels[level].mOffset - dataBegin);
+	cmdTextureBarrier(pCmd, pNewTexture, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+	return pNewTexture;
+}
+
+void addTextureStreamer(Renderer* pRenderer, const TextureStreamerDesc* pDesc, TextureStreamer** ppStreamer)
+{
+	TextureStreamer* pStreamer = shen_new(MEMORY_CATEGORY_ASSETS, TextureStreamer);
+	pStreamer->pRenderer = pRenderer;
+	pStreamer->pQueue = pDesc->pQueue;
+	pStreamer->pStagingBuffer = NULL;
+	pStreamer->mUploadBudget = pDesc->mUploadBudgetPerFrame ? pDesc->mUploadBudgetPerFrame : TEXTURE_STREAMING_DEFAULT_UPLOAD_BUDGET;
+	pStreamer->mMemoryBudget = pDesc->mMemoryBudget;
+	if (pStreamer->mMemoryBudget == 0 && !pRenderer->mCapabilities.mMemoryBudget)
+		pStreamer->mMemoryBudget = pRenderer->mCapabilities.mDeviceLocalMemorySize / 2;
+	pStreamer->mFramesInFlight = pDesc->mFramesInFlight;
+	pStreamer->mTextureOverhead = 0;
+	pStreamer->mFrameIndex = 0;
+	pStreamer->mResidentBytes = 0;
+	memset(&pStreamer->mStats, 0, sizeof(pStreamer->mStats));
+	pStreamer->mUploadInFlight = false;
+
+	CmdPoolDesc cmdPoolDesc = {};
+	cmdPoolDesc.pQueue = pDesc->pQueue;
+	addCmdPool(pRenderer, &cmdPoolDesc, &pStreamer->pCmdPool);
+	CmdDesc cmdDesc = {};
+	cmdDesc.pPool = pStreamer->pCmdPool;
+	addCmd(pRenderer, &cmdDesc, &pStreamer->pCmd);
+	// 栅栏创建时已触发, 重置后才能随提交使用
+	addFence(pRenderer, &pStreamer->pFence);
+	waitForFences(pRenderer, 1, &pStreamer->pFence);
+	ensureStagingCapacity(pStreamer, pStreamer->mUploadBudget);
+	*ppStreamer = pStreamer;
+}
+
+void removeTextureStreamer(TextureStreamer* pStreamer)
+{
+	Renderer* pRenderer = pStreamer->pRenderer;
+	waitQueueIdle(pStreamer->pQueue);
+	for (StreamedTexture* pTexture : pStreamer->mPendingTextures)
+	{
+		if (pTexture->mRemoved)
+		{
+			removeTexture(pRenderer, pTexture->pPendingTexture);
+			freeStreamedTexture(pTexture);
+		}
+		else
+			retireTexture(pStreamer, pTexture->pPendingTexture);
+	}
+	releaseRetiredTextures(pStreamer, true);
+	for (StreamedTexture* pTexture : pStreamer->mTextures)
+	{
+		removeTexture(pRenderer, pTexture->pTexture);
+		freeStreamedTexture(pTexture);
+	}
+
+	removeBuffer(pRenderer, pStreamer->pStagingBuffer);
+	removeFence(pRenderer, pStreamer->pFence);
+	removeCmd(pRenderer, pStreamer->pCmd);
+	removeCmdPool(pRenderer, pStreamer->pCmdPool);
+	shen_delete(pStreamer);
+}
+
+/// <summary>
+/// 打开并校验全部文件后, 把所有 mip 尾放进一个临时暂存缓冲, 一次提交并等待完成
+/// </summary>
+void addStreamedTextures(TextureStreamer* pStreamer, const char* const* ppFileNames, uint32_t count, StreamedTexture** ppTextures)
+{
+	SHEN_PROFILE_FUNCTION();
+	Renderer* pRenderer = pStreamer->pRenderer;
+	uint32_t opened = 0;
+	uint64_t stagingSize = 0;
+	bool failed = false;
+	for (; opened < count && !failed; ++opened)
+	{
+		StreamedTexture* pTexture = shen_new(MEMORY_CATEGORY_ASSETS, StreamedTexture);
+		memset(pTexture, 0, sizeof(StreamedTexture));
+		if (!openMappedFile(ppFileNames[opened], false, &pTexture->mFile))
+		{
+			shen_delete(pTexture);
+			failed = true;
+			break;
+		}
+		ppTextures[opened] = pTexture;
+		if (!validateTextureFile(ppFileNames[opened], &pTexture->mFile))
+		{
+			failed = true;
+			continue;
+		}
+		const TextureFileHeader* pHeader = (const TextureFileHeader*)pTexture->mFile.pData;
+		if (pHeader->mFormat != VK_FORMAT_R8G8B8A8_UNORM && pHeader->mFormat != VK_FORMAT_R8G8B8A8_SRGB && !pRenderer->mCapabilities.mTextureCompressionBC)
+		{
+			SHEN_CORE_ERROR("{0} is block compressed but the device does not support BC textures", ppFileNames[opened]);
+			failed = true;
+			continue;
+		}
+		pTexture->pStreamer = pStreamer;
+		pTexture->pHeader = pHeader;
+		pTexture->mTailMip = pHeader->mMipLevels - 1;
+		while (pTexture->mTailMip > 0 && std::max(pHeader->mWidth, pHeader->mHeight) >> (pTexture->mTailMip - 1) <= TEXTURE_STREAMING_TAIL_SIZE)
+			--pTexture->mTailMip;
+		pTexture->mResidentMip = pTexture->mTailMip;
+		pTexture->mWantedMip = pTexture->mTailMip;
+		pTexture->mTargetMip = pTexture->mTailMip;
+		pTexture->mRequestedMip = TEXTURE_STREAMING_NO_REQUEST;
+		stagingSize = alignStagingOffset(stagingSize) + getMipChainSize(pHeader, pTexture->mTailMip);
+	}
+	if (failed)
+	{
+		for (uint32_t i = 0; i < opened; ++i)
+			freeStreamedTexture(ppTextures[i]);
+		throw std::runtime_error("failed to load streamed texture!");
+	}
+
+	BufferDesc stagingDesc = {};
+	stagingDesc.mSize = std::max(stagingSize, (uint64_t)1);
+	stagingDesc.mUsage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+	stagingDesc.mMemoryUsage = RESOURCE_MEMORY_USAGE_CPU_TO_GPU;
+	Buffer* pStagingBuffer;
+	addBuffer(pRenderer, &stagingDesc, &pStagingBuffer);
+	CmdPoolDesc cmdPoolDesc = {};
+	cmdPoolDesc.pQueue = pStreamer->pQueue;
+	cmdPoolDesc.mTransient = true;
+	CmdPool* pCmdPool;
+	addCmdPool(pRenderer, &cmdPoolDesc, &pCmdPool);
+	CmdDesc cmdDesc = {};
+	cmdDesc.pPool = pCmdPool;
+	Cmd* pCmd;
+	addCmd(pRenderer, &cmdDesc, &pCmd);
+
+	beginCmd(pCmd);
+	uint64_t stagingOffset = 0;
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		StreamedTexture* pTexture = ppTextures[i];
+		stagingOffset = alignStagingOffset(stagingOffset);
+		pTexture->pTexture = recordMipChainUpload(pStreamer, pCmd, pStagingBuffer, stagingOffset, pTexture, pTexture->mTailMip);
+		stagingOffset += getMipChainSize(pTexture->pHeader, pTexture->mTailMip);
+		pTexture->mIndex = (uint32_t)pStreamer->mTextures.size();
+		pStreamer->mTextures.push_back(pTexture);
+	}
+	endCmd(pCmd);
+
+	QueueSubmitDesc submitDesc = {};
+	submitDesc.ppCmds = &pCmd;
+	submitDesc.mCmdCount = 1;
+	queueSubmit(pStreamer->pQueue, &submitDesc);
+	waitQueueIdle(pStreamer->pQueue);
+	removeCmd(pRenderer, pCmd);
+	removeCmdPool(pRenderer, pCmdPool);
+	removeBuffer(pRenderer, pStagingBuffer);
+}
+
+void removeStreamedTexture(TextureStreamer* pStreamer, StreamedTexture* pTexture)
+{
+	StreamedTexture* pLast = pStreamer->mTextures.back();
+	pStreamer->mTextures[pTexture->mIndex] = pLast;
+	pLast->mIndex = pTexture->mIndex;
+	pStreamer->mTextures.pop_back();
+
+	retireTexture(pStreamer, pTexture->pTexture);
+	pTexture->pTexture = NULL;
+	if (pTexture->pPendingTexture)
+		pTexture->mRemoved = true;
+	else
+		freeStreamedTexture(pTexture);
+}
+
+void requestStreamedTextureMip(StreamedTexture* pTexture, uint32_t mipLevel)
+{
+	pTexture->mRequestedMip = std::min(pTexture->mRequestedMip, std::min(mipLevel, pTexture->mTailMip));
+	pTexture->mLastRequestFrame = pTexture->pStreamer->mFrameIndex;
+}
+
+void requestStreamedTextureScreenSize(StreamedTexture* pTexture, float screenSize)
+{
+	float ratio = screenSize > 0.0f ? (float)std::max(pTexture->pHeader->mWidth, pTexture->pHeader->mHeight) / screenSize : INFINITY;
+	requestStreamedTextureMip(pTexture, ratio <= 1.0f ? 0 : (uint32_t)std::min(std::floor(std::log2(ratio)), 31.0f));
+}
+
+/// <summary>
+/// 上传完成: 新纹理替换当前纹理, 旧纹理等待在途帧结束后释放
+/// </summary>
+static void completePendingUploads(TextureStreamer* pStreamer)
+{
+	for (StreamedTexture* pTexture : pStreamer->mPendingTextures)
+	{
+		if (pTexture->mRemoved)
+		{
+			retireTexture(pStreamer, pTexture->pPendingTexture);
+			freeStreamedTexture(pTexture);
+			continue;
+		}
+		retireTexture(pStreamer, pTexture->pTexture);
+		pTexture->pTexture = pTexture->pPendingTexture;
+		pTexture->mResidentMip = pTexture->mPendingMip;
+		pTexture->pPendingTexture = NULL;
+	}
+	pStreamer->mPendingTextures.clear();
+	pStreamer->mUploadInFlight = false;
+}
+
+/// <summary>
+/// 本帧生效的预算: 配置的上限, 再按设备余量收紧, 其他分配增长时流式纹理随之让出显存
+/// </summary>
+static uint64_t computeMemoryBudget(TextureStreamer* pStreamer)
+{
+	uint64_t budget = pStreamer->mMemoryBudget ? pStreamer->mMemoryBudget : UINT64_MAX;
+	GpuMemoryBudget gpuBudget;
+	if (getGpuMemoryBudget(pStreamer->pRenderer, &gpuBudget))
+	{
+		uint64_t usable = gpuBudget.mBudget / 100 * (100 - TEXTURE_STREAMING_BUDGET_MARGIN_PERCENT);
+		// 设备用量中包含流式纹理自己, 余量为负时需要让出差额
+		uint64_t others = gpuBudget.mUsage > pStreamer->mResidentBytes ? gpuBudget.mUsage - pStreamer->mResidentBytes : 0;
+		budget = std::min(budget, usable > others ? usable - others : 0);
+	}
+	return budget;
+}
+
+/// <summary>
+/// 按最近请求帧从新到旧分配预算: mip 尾先全部计入, 之后每个纹理取预算内最接近期望的层级
+/// 放不下的纹理降到更低的层级, 因此超出预算时最久未请求的纹理最先失去高分辨率层级
+/// </summary>
+static void planResidency(TextureStreamer* pStreamer, uint64_t budget)
+{
+	std::vector<StreamedTexture*>& order = pStreamer->mPlanOrder;
+	order.assign(pStreamer->mTextures.begin(), pStreamer->mTextures.end());
+	std::stable_sort(order.begin(), order.end(), [](const StreamedTexture* pA, const StreamedTexture* pB)
+	{
+		return pA->mLastRequestFrame > pB->mLastRequestFrame;
+	});
+
+	uint64_t tailBytes = 0;
+	uint64_t requestedBytes = 0;
+	uint64_t allocatedBytes = 0;
+	uint64_t dataBytes = 0;
+	for (StreamedTexture* pTexture : order)
+	{
+		if (pTexture->mRequestedMip != TEXTURE_STREAMING_NO_REQUEST)
+			pTexture->mWantedMip = pTexture->mRequestedMip;
+		pTexture->mRequestedMip = TEXTURE_STREAMING_NO_REQUEST;
+		tailBytes += getMipChainSize(pTexture->pHeader, pTexture->mTailMip);
+		requestedBytes += getMipChainSize(pTexture->pHeader, pTexture->mWantedMip);
+		allocatedBytes += pTexture->pTexture->mMemorySize;
+		dataBytes += getMipChainSize(pTexture->pHeader, pTexture->mResidentMip);
+	}
+	uint64_t textureCount = order.size();
+	pStreamer->mTextureOverhead = textureCount && allocatedBytes > dataBytes ? (allocatedBytes - dataBytes) / textureCount : 0;
+	tailBytes += pStreamer->mTextureOverhead * textureCount;
+	requestedBytes += pStreamer->mTextureOverhead * textureCount;
+
+	uint64_t remaining = budget > tailBytes ? budget - tailBytes : 0;
+	for (StreamedTexture* pTexture : order)
+	{
+		uint64_t tailSize = getMipChainSize(pTexture->pHeader, pTexture->mTailMip);
+		uint32_t target = pTexture->mWantedMip;
+		while (target < pTexture->mTailMip && getMipChainSize(pTexture->pHeader, target) - tailSize > remaining)
+			++target;
+		remaining -= getMipChainSize(pTexture->pHeader, target) - tailSize;
+		pTexture->mTargetMip = target;
+	}
+	pStreamer->mStats.mRequestedBytes = requestedBytes;
+}
+
+/// <summary>
+/// 先降级 (从最久未请求的开始) 再升级 (从最近请求的开始), 升级只在新旧纹理同时存在也不超预算时进行
+/// 每个纹理一次直接换到目标层级, 本帧上传量达到预算后剩余的变化留到下一帧
+/// </summary>
+static void recordResidencyChanges(TextureStreamer* pStreamer, uint64_t budget)
+{
+	SHEN_PROFILE_FUNCTION();
+	const std::vector<StreamedTexture*>& order = pStreamer->mPlanOrder;
+	std::vector<StreamedTexture*>& batch = pStreamer->mPendingTextures;
+	uint64_t uploadBytes = 0;
+	// 按稳态占用判断预算: 等待释放的旧纹理与被替换的纹理只在在途帧内短暂共存, 不计入
+	uint64_t projectedBytes = pStreamer->mResidentBytes;
+	for (const RetiredTexture& retired : pStreamer->mRetiredTextures)
+		projectedBytes -= retired.pTexture->mMemorySize;
+	for (auto it = order.rbegin(); it != order.rend(); ++it)
+	{
+		StreamedTexture* pTexture = *it;
+		if (pTexture->mTargetMip <= pTexture->mResidentMip)
+			continue;
+		uint64_t size = getMipChainSize(pTexture->pHeader, pTexture->mTargetMip);
+		if (!batch.empty() && uploadBytes + size > pStreamer->mUploadBudget)
+			break;
+		projectedBytes += size + pStreamer->mTextureOverhead - pTexture->pTexture->mMemorySize;
+		uploadBytes = alignStagingOffset(uploadBytes) + size;
+		batch.push_back(pTexture);
+		++pStreamer->mStats.mEvictions;
+	}
+	for (StreamedTexture* pTexture : order)
+	{
+		if (pTexture->mTargetMip >= pTexture->mResidentMip)
+			continue;
+		uint64_t size = getMipChainSize(pTexture->pHeader, pTexture->mTargetMip);
+		uint64_t grownBytes = size + pStreamer->mTextureOverhead - pTexture->pTexture->mMemorySize;
+		if (projectedBytes + grownBytes > budget)
+			continue;
+		if (!batch.empty() && uploadBytes + size > pStreamer->mUploadBudget)
+			break;
+		projectedBytes += grownBytes;
+		uploadBytes = alignStagingOffset(uploadBytes) + size;
+		batch.push_back(pTexture);
+		++pStreamer->mStats.mUpgrades;
+	}
+	if (batch.empty())
+		return;
+
+	ensureStagingCapacity(pStreamer, uploadBytes);
+	Cmd* pCmd = pStreamer->pCmd;
+	beginCmd(pCmd);
+	uint64_t stagingOffset = 0;
+	for (StreamedTexture* pTexture : batch)
+	{
+		stagingOffset = alignStagingOffset(stagingOffset);
+		pTexture->pPendingTexture = recordMipChainUpload(pStreamer, pCmd, pStreamer->pStagingBuffer, stagingOffset, pTexture, pTexture->mTargetMip);
+		pTexture->mPendingMip = pTexture->mTargetMip;
+		stagingOffset += getMipChainSize(pTexture->pHeader, pTexture->mTargetMip);
+	}
+	endCmd(pCmd);
+
+	QueueSubmitDesc submitDesc = {};
+	submitDesc.ppCmds = &pCmd;
+	submitDesc.mCmdCount = 1;
+	submitDesc.pSignalFence = pStreamer->pFence;
+	queueSubmit(pStreamer->pQueue, &submitDesc);
+	pStreamer->mUploadInFlight = true;
+	pStreamer->mStats.mUploadedBytes = uploadBytes;
+}
+
+void updateTextureStreamer(TextureStreamer* pStreamer)
+{
+	SHEN_PROFILE_FUNCTION();
+	++pStreamer->mFrameIndex;
+	pStreamer->mStats.mUploadedBytes = 0;
+	pStreamer->mStats.mUpgrades = 0;
+	pStreamer->mStats.mEvictions = 0;
+	if (pStreamer->mUploadInFlight)
+	{
+		FenceStatus status;
+		getFenceStatus(pStreamer->pRenderer, pStreamer->pFence, &status);
+		if (status != FENCE_STATUS_INCOMPLETE)
+			completePendingUploads(pStreamer);
+	}
+	releaseRetiredTextures(pStreamer, false);
+
+	uint64_t budget = computeMemoryBudget(pStreamer);
+	planResidency(pStreamer, budget);
+	// 同一时间只有一批上传在途, 期间的请求已经计入 mWantedMip, 在上传完成后的帧处理
+	if (!pStreamer->mUploadInFlight)
+		recordResidencyChanges(pStreamer, budget);
+
+	pStreamer->mStats.mTextureCount = (uint32_t)pStreamer->mTextures.size();
+	pStreamer->mStats.mResidentBytes = pStreamer->mResidentBytes;
+	pStreamer->mStats.mBudgetBytes = budget;
+}
+
+Texture* getStreamedTexture(const StreamedTexture* pTexture)
+{
+	return pTexture->pTexture;
+}
+
+uint32_t getStreamedTextureResidentMip(const StreamedTexture* pTexture)
+{
+	return pTexture->mResidentMip;
+}
+
+void getTextureStreamerStats(const TextureStreamer* pStreamer, TextureStreamerStats* pOutStats)
+{
+	*pOutStats = pStreamer->mStats;
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+#include "Renderer.h"
+
+// 最长边不超过此值的低分辨率层级 (mip 尾) 在添加纹理时同步上传, 之后始终常驻, 不参与逐出
+#define TEXTURE_STREAMING_TAIL_SIZE 64
+// 使用 VK_EXT_memory_budget 时, 设备预算中留给其他分配与驱动的比例 (百分比)
+#define TEXTURE_STREAMING_BUDGET_MARGIN_PERCENT 10
+// 未指定时每帧最多上传的字节数
+#define TEXTURE_STREAMING_DEFAULT_UPLOAD_BUDGET (32ull << 20)
+
+typedef struct TextureStreamer TextureStreamer;
+typedef struct StreamedTexture StreamedTexture;
+
+/// <summary>
+/// 流式纹理管理器描述
+/// </summary>
+typedef struct TextureStreamerDesc
+{
+	// 上传队列, 需与采样这些纹理的队列属于同一队列族 (图像为独占共享模式)
+	Queue*		pQueue;
+	// 流式纹理可占用的显存上限 (字节); 设备支持 VK_EXT_memory_budget 时还会按设备的实时余量收紧
+	// 为 0 时只使用设备余量, 不支持该扩展时取设备本地内存的一半
+	uint64_t	mMemoryBudget;
+	// 每帧最多上传的字节数, 为 0 时使用默认值; 单个纹理的一次升级超过该值时独占一帧
+	uint64_t	mUploadBudgetPerFrame;
+	// 同时在途的帧数, 被替换下来的纹理在之后这么多次 updateTextureStreamer 后才释放
+	uint32_t	mFramesInFlight;
+} TextureStreamerDesc;
+
+/// <summary>
+/// 最近一次 updateTextureStreamer 的统计
+/// </summary>
+typedef struct TextureStreamerStats
+{
+	uint32_t	mTextureCount;
+	// 流式纹理实际占用的显存, 含上传中与等待释放的纹理
+	uint64_t	mResidentBytes;
+	// 本帧生效的预算
+	uint64_t	mBudgetBytes;
+	// 所有纹理都达到请求层级时需要的字节数, 超过预算时最久未请求的纹理会被降级
+	uint64_t	mRequestedBytes;
+	uint64_t	mUploadedBytes;
+	// 本帧开始升级/降级的纹理数量
+	uint32_t	mUpgrades;
+	uint32_t	mEvictions;
+} TextureStreamerStats;
+
+// 创建流式纹理管理器, 持有自己的指令池、栅栏与暂存缓冲
+void addTextureStreamer(Renderer* pRenderer, const TextureStreamerDesc* pDesc, TextureStreamer** ppStreamer);
+// 等待上传队列空闲后释放管理器与其中的全部纹理
+void removeTextureStreamer(TextureStreamer* pStreamer);
+
+/// <summary>
+/// 添加流式纹理, 只接受 .stex 文件 (完整 mip 链由 TextureCooker 预先生成)
+/// 文件保持映射, mip 尾在返回前同步上传, 更高的层级在请求后由 updateTextureStreamer 异步加载
+/// 任一文件无法打开或校验失败时释放本次添加的纹理并抛出异常
+/// </summary>
+void addStreamedTextures(TextureStreamer* pStreamer, const char* const* ppFileNames, uint32_t count, StreamedTexture** ppTextures);
+// 移除流式纹理, 纹理在在途帧结束后才释放
+void removeStreamedTexture(TextureStreamer* pStreamer, StreamedTexture* pTexture);
+
+// 请求本帧需要的最高层级 (0 为完整分辨率), 同一帧内多次请求取最精细的一级; 只能在调用 updateTextureStreamer 的线程上调用
+void requestStreamedTextureMip(StreamedTexture* pTexture, uint32_t mipLevel);
+// 按屏幕尺寸请求: screenSize 为纹理 [0, 1] UV 范围在屏幕上覆盖的像素数 (较长的一边), 选择纹素不少于屏幕像素的一级
+void requestStreamedTextureScreenSize(StreamedTexture* pTexture, float screenSize);
+
+/// <summary>
+/// 每帧调用一次:
+/// 1. 回收完成的上传, 用新纹理替换旧纹理, 释放在途帧已结束的旧纹理
+/// 2. 按最近请求帧从新到旧分配预算, 放不下的纹理逐级降到更低的层级, 最久未使用的纹理最先被逐出
+/// 3. 在上传预算内为层级变化的纹理创建新图像并从映射文件拷贝, 提交后不等待
+/// </summary>
+void updateTextureStreamer(TextureStreamer* pStreamer);
+
+// 当前可采样的纹理, 层级变化后会替换为新的纹理, 每帧绑定前重新获取; 视图的 mip 0 为当前常驻的最高层级
+Texture* getStreamedTexture(const StreamedTexture* pTexture);
+// 当前常驻的最高层级在完整 mip 链中的索引
+uint32_t getStreamedTextureResidentMip(const StreamedTexture* pTexture);
+void getTextureStreamerStats(const TextureStreamer* pStreamer, TextureStreamerStats* pOutStats);
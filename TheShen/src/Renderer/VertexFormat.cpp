@@ -0,0 +1,348 @@
+#include "VertexFormat.h"
+#include "Core/Log.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+
+typedef struct VertexAttribFormat
+{
+	VkFormat mFormat;
+	uint32_t mSize;
+} VertexAttribFormat;
+
+// 每种语义/编码组合对应的 Vulkan 格式, 大小为 0 表示不支持
+// 3 分量的 16 位与 8 位格式作为顶点输入的支持很差, 统一补齐为 4 分量
+static const VertexAttribFormat gAttribFormats[VERTEX_SEMANTIC_COUNT][VERTEX_ENCODING_COUNT] = {
+	// POSITION
+	{ {}, { VK_FORMAT_R32G32B32_SFLOAT, 12 }, { VK_FORMAT_R16G16B16A16_SFLOAT, 8 }, { VK_FORMAT_R16G16B16A16_SNORM, 8 }, {}, {}, {}, {} },
+	// NORMAL
+	{ {}, { VK_FORMAT_R32G32B32_SFLOAT, 12 }, { VK_FORMAT_R16G16B16A16_SFLOAT, 8 }, {}, { VK_FORMAT_R16G16_SNORM, 4 }, { VK_FORMAT_R8G8_SNORM, 2 }, {}, {} },
+	// TEXCOORD
+	{ {}, { VK_FORMAT_R32G32_SFLOAT, 8 }, { VK_FORMAT_R16G16_SFLOAT, 4 }, {}, {}, {}, { VK_FORMAT_R16G16_UNORM, 4 }, {} },
+	// TANGENT, 八面体编码时 z 为副切线符号
+	{ {}, { VK_FORMAT_R32G32B32A32_SFLOAT, 16 }, { VK_FORMAT_R16G16B16A16_SFLOAT, 8 }, {}, { VK_FORMAT_R16G16B16A16_SNORM, 8 }, { VK_FORMAT_R8G8B8A8_SNORM, 4 }, {}, {} },
+	// COLOR
+	{ {}, { VK_FORMAT_R32G32B32A32_SFLOAT, 16 }, { VK_FORMAT_R16G16B16A16_SFLOAT, 8 }, {}, {}, {}, { VK_FORMAT_R16G16B16A16_UNORM, 8 }, { VK_FORMAT_R8G8B8A8_UNORM, 4 } },
+};
+
+// 每种语义输入流的浮点分量数
+static const uint32_t gSemanticComponents[VERTEX_SEMANTIC_COUNT] = { 3, 3, 2, 4, 4 };
+
+static uint32_t alignAttribOffset(uint32_t offset)
+{
+	return (offset + 3) & ~3u;
+}
+
+bool isVertexFormatValid(const VertexFormat* pFormat)
+{
+	for (uint32_t i = 0; i < VERTEX_FORMAT_MAX_SEMANTICS; ++i)
+	{
+		uint32_t encoding = pFormat->mEncodings[i];
+		if (encoding == VERTEX_ENCODING_NONE)
+			continue;
+		if (i >= VERTEX_SEMANTIC_COUNT || encoding >= VERTEX_ENCODING_COUNT || !gAttribFormats[i][encoding].mSize)
+			return false;
+	}
+	return pFormat->mEncodings[VERTEX_SEMANTIC_POSITION] != VERTEX_ENCODING_NONE;
+}
+
+uint32_t getVertexFormatStride(const VertexFormat* pFormat)
+{
+	uint32_t stride = 0;
+	for (uint32_t i = 0; i < VERTEX_SEMANTIC_COUNT; ++i)
+	{
+		if (pFormat->mEncodings[i] != VERTEX_ENCODING_NONE)
+			stride = alignAttribOffset(stride) + gAttribFormats[i][pFormat->mEncodings[i]].mSize;
+	}
+	return alignAttribOffset(stride);
+}
+
+void getVertexFormatLayout(const VertexFormat* pFormat, VertexLayout* pOutLayout)
+{
+	memset(pOutLayout, 0, sizeof(*pOutLayout));
+	uint32_t offset = 0;
+	for (uint32_t i = 0; i < VERTEX_SEMANTIC_COUNT; ++i)
+	{
+		if (pFormat->mEncodings[i] == VERTEX_ENCODING_NONE)
+			continue;
+		const VertexAttribFormat& format = gAttribFormats[i][pFormat->mEncodings[i]];
+		offset = alignAttribOffset(offset);
+		VertexAttrib& attrib = pOutLayout->mAttribs[pOutLayout->mAttribCount++];
+		attrib.mFormat = format.mFormat;
+		attrib.mLocation = i;
+		attrib.mOffset = offset;
+		offset += format.mSize;
+	}
+	pOutLayout->mStride = alignAttribOffset(offset);
+}
+
+static inline const float* getStreamElement(const VertexStream& stream, uint32_t vertex)
+{
+	return (const float*)((const uint8_t*)stream.pData + (size_t)vertex * stream.mStride);
+}
+
+// 包围范围, 退化的轴 scale 取 1, 避免除零
+static void computeRange(const VertexStream& stream, uint32_t vertexCount, uint32_t componentCount, float* pMin, float* pMax)
+{
+	for (uint32_t c = 0; c < componentCount; ++c)
+	{
+		pMin[c] = vertexCount ? FLT_MAX : 0.0f;
+		pMax[c] = vertexCount ? -FLT_MAX : 0.0f;
+	}
+	for (uint32_t v = 0; v < vertexCount; ++v)
+	{
+		const float* pValue = getStreamElement(stream, v);
+		for (uint32_t c = 0; c < componentCount; ++c)
+		{
+			pMin[c] = std::min(pMin[c], pValue[c]);
+			pMax[c] = std::max(pMax[c], pValue[c]);
+		}
+	}
+}
+
+void computeVertexDequantization(const VertexFormat* pFormat, const VertexStreamsDesc* pStreams, VertexDequantization* pOutDequantization)
+{
+	for (uint32_t c = 0; c < 3; ++c)
+	{
+		pOutDequantization->mPositionScale[c] = 1.0f;
+		pOutDequantization->mPositionOffset[c] = 0.0f;
+	}
+	for (uint32_t c = 0; c < 2; ++c)
+	{
+		pOutDequantization->mTexCoordScale[c] = 1.0f;
+		pOutDequantization->mTexCoordOffset[c] = 0.0f;
+	}
+
+	uint8_t positionEncoding = pFormat->mEncodings[VERTEX_SEMANTIC_POSITION];
+	if (positionEncoding == VERTEX_ENCODING_SNORM16 || positionEncoding == VERTEX_ENCODING_FLOAT16)
+	{
+		float boundsMin[3], boundsMax[3];
+		computeRange(pStreams->mStreams[VERTEX_SEMANTIC_POSITION], pStreams->mVertexCount, 3, boundsMin, boundsMax);
+		for (uint32_t c = 0; c < 3; ++c)
+		{
+			// 以中心为原点: SNORM16 归一化到 [-1, 1], FLOAT16 只平移, 使半精度的有效位用在网格尺度上
+			float halfExtent = 0.5f * (boundsMax[c] - boundsMin[c]);
+			pOutDequantization->mPositionOffset[c] = 0.5f * (boundsMin[c] + boundsMax[c]);
+			if (positionEncoding == VERTEX_ENCODING_SNORM16)
+				pOutDequantization->mPositionScale[c] = halfExtent > 0.0f ? halfExtent : 1.0f;
+		}
+	}
+
+	if (pFormat->mEncodings[VERTEX_SEMANTIC_TEXCOORD] == VERTEX_ENCODING_UNORM16)
+	{
+		float rangeMin[2], rangeMax[2];
+		computeRange(pStreams->mStreams[VERTEX_SEMANTIC_TEXCOORD], pStreams->mVertexCount, 2, rangeMin, rangeMax);
+		for (uint32_t c = 0; c < 2; ++c)
+		{
+			float extent = rangeMax[c] - rangeMin[c];
+			pOutDequantization->mTexCoordOffset[c] = rangeMin[c];
+			pOutDequantization->mTexCoordScale[c] = extent > 0.0f ? extent : 1.0f;
+		}
+	}
+}
+
+/// <summary>
+/// 单精度转半精度, 就近舍入到偶数, 超出范围为无穷大, 保留 NaN
+/// </summary>
+static uint16_t floatToHalf(float value)
+{
+	uint32_t bits;
+	memcpy(&bits, &value, sizeof(bits));
+	uint32_t sign = (bits >> 16) & 0x8000u;
+	uint32_t exponent = (bits >> 23) & 0xffu;
+	uint32_t mantissa = bits & 0x7fffffu;
+	if (exponent == 0xff)
+		return (uint16_t)(sign | 0x7c00u | (mantissa ? 0x200u : 0u));
+
+	int halfExponent = (int)exponent - 127 + 15;
+	if (halfExponent >= 31)
+		return (uint16_t)(sign | 0x7c00u);
+	if (halfExponent <= 0)
+	{
+		// 非规格化数, 比最小非规格化数的一半还小时为 0
+		if (halfExponent < -10)
+			return (uint16_t)sign;
+		mantissa |= 0x800000u;
+		uint32_t shift = (uint32_t)(14 - halfExponent);
+		uint32_t half = mantissa >> shift;
+		uint32_t remainder = mantissa & ((1u << shift) - 1);
+		uint32_t halfway = 1u << (shift - 1);
+		if (remainder > halfway || (remainder == halfway && (half & 1)))
+			++half;
+		return (uint16_t)(sign | half);
+	}
+
+	// 尾数进位可以溢出到指数, 最大值舍入后正好成为无穷大
+	uint32_t half = ((uint32_t)halfExponent << 10) | (mantissa >> 13);
+	uint32_t remainder = mantissa & 0x1fffu;
+	if (remainder > 0x1000u || (remainder == 0x1000u && (half & 1)))
+		++half;
+	return (uint16_t)(sign | half);
+}
+
+static inline int16_t quantizeSnorm16(float value)
+{
+	return (int16_t)lrintf(std::min(std::max(value, -1.0f), 1.0f) * 32767.0f);
+}
+
+static inline int8_t quantizeSnorm8(float value)
+{
+	return (int8_t)lrintf(std::min(std::max(value, -1.0f), 1.0f) * 127.0f);
+}
+
+static inline uint16_t quantizeUnorm16(float value)
+{
+	return (uint16_t)lrintf(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f);
+}
+
+static inline uint8_t quantizeUnorm8(float value)
+{
+	return (uint8_t)lrintf(std::min(std::max(value, 0.0f), 1.0f) * 255.0f);
+}
+
+/// <summary>
+/// 八面体映射: 单位向量投影到 L1 单位球面, 下半球沿对角线折叠到外侧三角形, 结果在 [-1, 1]^2
+/// 零向量映射为 (0, 0), 解码为 +Z
+/// </summary>
+static void encodeOctahedral(const float* pVector, float* pOut)
+{
+	float length = fabsf(pVector[0]) + fabsf(pVector[1]) + fabsf(pVector[2]);
+	if (length <= 0.0f)
+	{
+		pOut[0] = 0.0f;
+		pOut[1] = 0.0f;
+		return;
+	}
+	float x = pVector[0] / length;
+	float y = pVector[1] / length;
+	if (pVector[2] < 0.0f)
+	{
+		float foldedX = (1.0f - fabsf(y)) * (x >= 0.0f ? 1.0f : -1.0f);
+		float foldedY = (1.0f - fabsf(x)) * (y >= 0.0f ? 1.0f : -1.0f);
+		x = foldedX;
+		y = foldedY;
+	}
+	pOut[0] = x;
+	pOut[1] = y;
+}
+
+/// <summary>
+/// 编码一个属性, pValue 为 componentCount 个浮点分量
+/// </summary>
+static void encodeAttrib(uint32_t semantic, uint32_t encoding, const float* pValue, const float* pScale, const float* pOffset, uint8_t* pDst)
+{
+	uint32_t componentCount = gSemanticComponents[semantic];
+	switch (encoding)
+	{
+	case VERTEX_ENCODING_FLOAT32:
+		memcpy(pDst, pValue, componentCount * sizeof(float));
+		break;
+	case VERTEX_ENCODING_FLOAT16:
+	{
+		uint16_t* pHalf = (uint16_t*)pDst;
+		uint32_t paddedCount = gAttribFormats[semantic][encoding].mSize / sizeof(uint16_t);
+		for (uint32_t c = 0; c < paddedCount; ++c)
+		{
+			float value = c < componentCount ? pValue[c] : 0.0f;
+			if (pOffset && c < 3)
+				value -= pOffset[c];
+			pHalf[c] = floatToHalf(value);
+		}
+		break;
+	}
+	case VERTEX_ENCODING_SNORM16:
+	{
+		int16_t* pSnorm = (int16_t*)pDst;
+		for (uint32_t c = 0; c < 3; ++c)
+			pSnorm[c] = quantizeSnorm16((pValue[c] - pOffset[c]) / pScale[c]);
+		pSnorm[3] = 0;
+		break;
+	}
+	case VERTEX_ENCODING_OCT_SNORM16:
+	case VERTEX_ENCODING_OCT_SNORM8:
+	{
+		float octahedral[2];
+		encodeOctahedral(pValue, octahedral);
+		float components[4] = { octahedral[0], octahedral[1], 0.0f, 0.0f };
+		if (semantic == VERTEX_SEMANTIC_TANGENT)
+			components[2] = pValue[3] < 0.0f ? -1.0f : 1.0f;
+		uint32_t size = gAttribFormats[semantic][encoding].mSize;
+		if (encoding == VERTEX_ENCODING_OCT_SNORM16)
+		{
+			for (uint32_t c = 0; c < size / sizeof(int16_t); ++c)
+				((int16_t*)pDst)[c] = quantizeSnorm16(components[c]);
+		}
+		else
+		{
+			for (uint32_t c = 0; c < size; ++c)
+				((int8_t*)pDst)[c] = quantizeSnorm8(components[c]);
+		}
+		break;
+	}
+	case VERTEX_ENCODING_UNORM16:
+		for (uint32_t c = 0; c < componentCount; ++c)
+			((uint16_t*)pDst)[c] = quantizeUnorm16(pScale ? (pValue[c] - pOffset[c]) / pScale[c] : pValue[c]);
+		break;
+	case VERTEX_ENCODING_UNORM8:
+		for (uint32_t c = 0; c < componentCount; ++c)
+			pDst[c] = quantizeUnorm8(pValue[c]);
+		break;
+	}
+}
+
+/// <summary>
+/// 逐属性编码, 属性之间的对齐填充写 0, 使相同的输入总是得到相同的字节 (烘焙结果可复现)
+/// </summary>
+void encodeVertices(const VertexFormat* pFormat, const VertexStreamsDesc* pStreams, const VertexDequantization* pDequantization, void* pDst)
+{
+	if (!isVertexFormatValid(pFormat))
+	{
+		SHEN_CORE_ERROR("vertex format has an unsupported attribute encoding");
+		throw std::runtime_error("invalid vertex format!");
+	}
+
+	VertexLayout layout;
+	getVertexFormatLayout(pFormat, &layout);
+	memset(pDst, 0, (size_t)pStreams->mVertexCount * layout.mStride);
+	for (uint32_t a = 0; a < layout.mAttribCount; ++a)
+	{
+		uint32_t semantic = layout.mAttribs[a].mLocation;
+		const VertexStream& stream = pStreams->mStreams[semantic];
+		if (!stream.pData)
+		{
+			SHEN_CORE_ERROR("vertex format needs attribute {0} but no stream was given", semantic);
+			throw std::runtime_error("missing vertex stream!");
+		}
+
+		const float* pScale = NULL;
+		const float* pOffset = NULL;
+		if (semantic == VERTEX_SEMANTIC_POSITION)
+		{
+			pScale = pDequantization->mPositionScale;
+			pOffset = pDequantization->mPositionOffset;
+		}
+		else if (semantic == VERTEX_SEMANTIC_TEXCOORD && pFormat->mEncodings[semantic] == VERTEX_ENCODING_UNORM16)
+		{
+			pScale = pDequantization->mTexCoordScale;
+			pOffset = pDequantization->mTexCoordOffset;
+		}
+
+		uint32_t encoding = pFormat->mEncodings[semantic];
+		uint8_t* pAttrib = (uint8_t*)pDst + layout.mAttribs[a].mOffset;
+		for (uint32_t v = 0; v < pStreams->mVertexCount; ++v)
+			encodeAttrib(semantic, encoding, getStreamElement(stream, v), pScale, pOffset, pAttrib + (size_t)v * layout.mStride);
+	}
+}
+
+void getVertexDequantizationMatrix(const VertexDequantization* pDequantization, float* pOutMatrix)
+{
+	memset(pOutMatrix, 0, 16 * sizeof(float));
+	for (uint32_t c = 0; c < 3; ++c)
+	{
+		pOutMatrix[c * 4 + c] = pDequantization->mPositionScale[c];
+		pOutMatrix[12 + c] = pDequantization->mPositionOffset[c];
+	}
+	pOutMatrix[15] = 1.0f;
+}
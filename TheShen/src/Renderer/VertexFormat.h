@@ -0,0 +1,95 @@
+#pragma once
+
+#include "Renderer.h"
+
+// 顶点格式: 每种语义选择一种编码, 烘焙时按格式编码顶点, 运行时由格式生成顶点输入布局
+// 语义的 location 固定为其枚举值, 着色器按 location 声明输入即可适配不同的编码
+//
+// 着色器中的解码:
+//   位置   position = dequant.positionOffset + inPosition.xyz * dequant.positionScale
+//          (可以合并进模型矩阵, 见 getVertexDequantizationMatrix)
+//   UV     uv = dequant.texCoordOffset + inTexCoord * dequant.texCoordScale
+//   八面体 n = vec3(e.xy, 1 - |e.x| - |e.y|); t = max(-n.z, 0); n.xy += (n.xy >= 0 ? -t : t); n = normalize(n)
+//          切线的 z 分量为副切线符号 (+1/-1)
+
+typedef enum VertexSemantic
+{
+	VERTEX_SEMANTIC_POSITION = 0,
+	VERTEX_SEMANTIC_NORMAL,
+	VERTEX_SEMANTIC_TEXCOORD,
+	// xyz 为切线方向, w 为副切线符号
+	VERTEX_SEMANTIC_TANGENT,
+	// 线性 RGBA
+	VERTEX_SEMANTIC_COLOR,
+	VERTEX_SEMANTIC_COUNT,
+} VertexSemantic;
+
+typedef enum VertexEncoding
+{
+	// 格式中不含该语义
+	VERTEX_ENCODING_NONE = 0,
+	VERTEX_ENCODING_FLOAT32,
+	// 半精度, 位置存为相对包围盒中心的坐标
+	VERTEX_ENCODING_FLOAT16,
+	// 仅位置: 按包围盒归一化到 [-1, 1] 后量化
+	VERTEX_ENCODING_SNORM16,
+	// 仅法线/切线: 八面体映射到 2 个分量
+	VERTEX_ENCODING_OCT_SNORM16,
+	VERTEX_ENCODING_OCT_SNORM8,
+	// UV 按取值范围归一化后量化, 颜色钳制到 [0, 1] 后量化
+	VERTEX_ENCODING_UNORM16,
+	VERTEX_ENCODING_UNORM8,
+	VERTEX_ENCODING_COUNT,
+} VertexEncoding;
+
+// 格式固定 8 个字节, 可以原样写入烘焙文件
+#define VERTEX_FORMAT_MAX_SEMANTICS 8
+
+/// <summary>
+/// 顶点格式, mEncodings 按 VertexSemantic 索引, 属性按语义顺序交错存放
+/// </summary>
+typedef struct VertexFormat
+{
+	uint8_t mEncodings[VERTEX_FORMAT_MAX_SEMANTICS];
+} VertexFormat;
+
+/// <summary>
+/// 反量化参数, 原值 = offset + 存储值 * scale; 未量化的语义为 scale 1, offset 0
+/// </summary>
+typedef struct VertexDequantization
+{
+	float mPositionScale[3];
+	float mPositionOffset[3];
+	float mTexCoordScale[2];
+	float mTexCoordOffset[2];
+} VertexDequantization;
+
+/// <summary>
+/// 编码的输入, 每种语义一条浮点分量流 (位置/法线 3, UV 2, 切线/颜色 4)
+/// 格式中包含的语义必须提供数据
+/// </summary>
+typedef struct VertexStream
+{
+	const float*	pData;
+	// 相邻顶点之间的字节数
+	uint32_t		mStride;
+} VertexStream;
+
+typedef struct VertexStreamsDesc
+{
+	VertexStream	mStreams[VERTEX_SEMANTIC_COUNT];
+	uint32_t		mVertexCount;
+} VertexStreamsDesc;
+
+// 检查每种语义的编码是否受支持, 且至少包含位置
+bool isVertexFormatValid(const VertexFormat* pFormat);
+// 一个顶点的字节数, 每个属性按 4 字节对齐
+uint32_t getVertexFormatStride(const VertexFormat* pFormat);
+// 生成格式对应的顶点输入布局, 用于 GraphicsPipelineDesc::pVertexLayout
+void getVertexFormatLayout(const VertexFormat* pFormat, VertexLayout* pOutLayout);
+// 由顶点数据计算反量化参数, 量化的语义取其包围范围
+void computeVertexDequantization(const VertexFormat* pFormat, const VertexStreamsDesc* pStreams, VertexDequantization* pOutDequantization);
+// 按格式编码顶点, pDst 至少为 mVertexCount * stride 字节
+void encodeVertices(const VertexFormat* pFormat, const VertexStreamsDesc* pStreams, const VertexDequantization* pDequantization, void* pDst);
+// 位置反量化对应的列主序 4x4 矩阵 (先缩放后平移), 右乘到模型矩阵后着色器无需单独解码位置
+void getVertexDequantizationMatrix(const VertexDequantization* pDequantization, float* pOutMatrix);
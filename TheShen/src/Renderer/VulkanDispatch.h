@@ -0,0 +1,111 @@
+#pragma once
+
+/// <summary>
+/// 设备级 Vulkan 函数表
+/// 由 vkGetDeviceProcAddr 在创建逻辑设备后直接从驱动加载, 调用时不再经过 vulkan-1 加载器的跳板函数 (trampoline);
+/// 实例级函数调用频率很低, 仍然通过加载器调用
+/// 新增设备级调用时需要先加入下面的函数列表
+/// </summary>
+#define VK_DEVICE_FUNCTION_LIST(X)		\
+	X(vkGetDeviceQueue)					\
+	X(vkDeviceWaitIdle)					\
+	X(vkQueueSubmit)					\
+	X(vkQueueWaitIdle)					\
+	X(vkCreateImage)					\
+	X(vkDestroyImage)					\
+	X(vkGetImageMemoryRequirements)		\
+	X(vkAllocateMemory)					\
+	X(vkFreeMemory)						\
+	X(vkBindImageMemory)				\
+	X(vkCreateBuffer)					\
+	X(vkDestroyBuffer)					\
+	X(vkGetBufferMemoryRequirements)	\
+	X(vkBindBufferMemory)				\
+	X(vkMapMemory)						\
+	X(vkUnmapMemory)					\
+	X(vkCreateImageView)				\
+	X(vkDestroyImageView)				\
+	X(vkCreateRenderPass)				\
+	X(vkDestroyRenderPass)				\
+	X(vkCreateFramebuffer)				\
+	X(vkDestroyFramebuffer)				\
+	X(vkCreateShaderModule)				\
+	X(vkDestroyShaderModule)			\
+	X(vkCreatePipelineLayout)			\
+	X(vkDestroyPipelineLayout)			\
+	X(vkCreateGraphicsPipelines)		\
+	X(vkCreateComputePipelines)			\
+	X(vkDestroyPipeline)				\
+	X(vkCreateDescriptorSetLayout)		\
+	X(vkDestroyDescriptorSetLayout)		\
+	X(vkCreateDescriptorPool)			\
+	X(vkDestroyDescriptorPool)			\
+	X(vkAllocateDescriptorSets)			\
+	X(vkUpdateDescriptorSets)			\
+	X(vkCreateCommandPool)				\
+	X(vkDestroyCommandPool)				\
+	X(vkAllocateCommandBuffers)			\
+	X(vkFreeCommandBuffers)				\
+	X(vkBeginCommandBuffer)				\
+	X(vkEndCommandBuffer)				\
+	X(vkCreateSemaphore)				\
+	X(vkDestroySemaphore)				\
+	X(vkCreateFence)					\
+	X(vkDestroyFence)					\
+	X(vkWaitForFences)					\
+	X(vkResetFences)					\
+	X(vkGetFenceStatus)					\
+	X(vkCreateQueryPool)				\
+	X(vkDestroyQueryPool)				\
+	X(vkGetQueryPoolResults)			\
+	X(vkCmdBeginRenderPass)				\
+	X(vkCmdEndRenderPass)				\
+	X(vkCmdBindPipeline)				\
+	X(vkCmdBindDescriptorSets)			\
+	X(vkCmdPushConstants)				\
+	X(vkCmdSetViewport)					\
+	X(vkCmdSetScissor)					\
+	X(vkCmdPipelineBarrier)				\
+	X(vkCmdResetQueryPool)				\
+	X(vkCmdWriteTimestamp)				\
+	X(vkCmdBeginQuery)					\
+	X(vkCmdEndQuery)					\
+	X(vkCmdCopyQueryPoolResults)		\
+	X(vkCmdCopyBuffer)					\
+	X(vkCmdCopyBufferToImage)			\
+	X(vkCmdBlitImage)					\
+	X(vkCmdBindVertexBuffers)			\
+	X(vkCmdBindIndexBuffer)				\
+	X(vkCmdDrawIndexed)					\
+	X(vkCmdDrawIndexedIndirect)			\
+	X(vkCmdDraw)						\
+	X(vkCmdDispatch)
+
+/// <summary>
+/// 交换链函数, 只在有窗口 (启用 VK_KHR_swapchain) 时加载, 无窗口模式下为空
+/// </summary>
+#define VK_DEVICE_SWAPCHAIN_FUNCTION_LIST(X)	\
+	X(vkQueuePresentKHR)					\
+	X(vkCreateSwapchainKHR)					\
+	X(vkDestroySwapchainKHR)				\
+	X(vkGetSwapchainImagesKHR)				\
+	X(vkAcquireNextImageKHR)
+
+/// <summary>
+/// 可选的设备级函数, 依赖探测到的特性; 先取核心版本名称, 取不到再取扩展别名
+/// </summary>
+#define VK_DEVICE_OPTIONAL_FUNCTION_LIST(X)			\
+	X(vkCmdBeginRendering, vkCmdBeginRenderingKHR)	\
+	X(vkCmdEndRendering, vkCmdEndRenderingKHR)		\
+	X(vkResetQueryPool, vkResetQueryPoolEXT)
+
+typedef struct DeviceDispatchTable
+{
+#define VK_DECLARE_DEVICE_FUNCTION(name) PFN_##name name;
+	VK_DEVICE_FUNCTION_LIST(VK_DECLARE_DEVICE_FUNCTION)
+	VK_DEVICE_SWAPCHAIN_FUNCTION_LIST(VK_DECLARE_DEVICE_FUNCTION)
+#undef VK_DECLARE_DEVICE_FUNCTION
+#define VK_DECLARE_OPTIONAL_DEVICE_FUNCTION(name, alias) PFN_##name name;
+	VK_DEVICE_OPTIONAL_FUNCTION_LIST(VK_DECLARE_OPTIONAL_DEVICE_FUNCTION)
+#undef VK_DECLARE_OPTIONAL_DEVICE_FUNCTION
+} DeviceDispatchTable;
@@ -0,0 +1,48 @@
+#pragma once
+// Minimal stand-in for The Forge's IFileSystem.h so that mmgr.c can be built inside TheShen.
+// Only the stream functions used by the leak report are provided; RD_LOG maps to the working directory.
+
+#include <stdio.h>
+#include <string.h>
+
+typedef enum ResourceDirectory
+{
+	RD_LOG = 0,
+} ResourceDirectory;
+
+typedef enum FileMode
+{
+	FM_READ = 1 << 0,
+	FM_WRITE = 1 << 1,
+	FM_APPEND = 1 << 2,
+} FileMode;
+
+typedef struct FileStream
+{
+	FILE* pFile;
+} FileStream;
+
+inline bool fsOpenStreamFromPath(ResourceDirectory resourceDir, const char* fileName, FileMode mode, const char* password, FileStream* pOut)
+{
+	(void)resourceDir;
+	(void)password;
+	pOut->pFile = fopen(fileName, (mode & FM_APPEND) ? "ab" : ((mode & FM_WRITE) ? "wb" : "rb"));
+	return pOut->pFile != NULL;
+}
+
+inline size_t fsWriteToStream(FileStream* pStream, const void* pData, size_t size)
+{
+	return pStream->pFile ? fwrite(pData, 1, size, pStream->pFile) : 0;
+}
+
+inline bool fsFlushStream(FileStream* pStream)
+{
+	return pStream->pFile ? fflush(pStream->pFile) == 0 : false;
+}
+
+inline bool fsCloseStream(FileStream* pStream)
+{
+	bool success = pStream->pFile ? fclose(pStream->pFile) == 0 : false;
+	pStream->pFile = NULL;
+	return success;
+}
@@ -0,0 +1,33 @@
+#pragma once
+// Minimal stand-in for The Forge's IThread.h so that mmgr.c can be built inside TheShen.
+
+#include <new>
+#include <mutex>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#define _OutputDebugString(str) OutputDebugStringA(str)
+#else
+#include <stdio.h>
+#define _OutputDebugString(str) fputs(str, stderr)
+#endif
+
+typedef struct Mutex
+{
+	std::mutex mHandle;
+} Mutex;
+
+inline bool initMutex(Mutex* pMutex)
+{
+	new (pMutex) Mutex();
+	return true;
+}
+
+inline void destroyMutex(Mutex* pMutex) { pMutex->~Mutex(); }
+
+inline void acquireMutex(Mutex* pMutex) { pMutex->mHandle.lock(); }
+
+inline void releaseMutex(Mutex* pMutex) { pMutex->mHandle.unlock(); }
@@ -5,9 +5,41 @@ workspace "TheShen"
 	configurations
 	{
 		"Debug",
-		"Release"
+		"Release",
+		"Dist"
 	}
 
+	-- Log.h expands to the same macros in every project, so the level is set workspace-wide
+	filter "options:log-level=trace"
+		defines { "SHEN_LOG_ACTIVE_LEVEL=SHEN_LOG_LEVEL_TRACE" }
+	filter "options:log-level=info"
+		defines { "SHEN_LOG_ACTIVE_LEVEL=SHEN_LOG_LEVEL_INFO" }
+	filter "options:log-level=warn"
+		defines { "SHEN_LOG_ACTIVE_LEVEL=SHEN_LOG_LEVEL_WARN" }
+	filter "options:log-level=error"
+		defines { "SHEN_LOG_ACTIVE_LEVEL=SHEN_LOG_LEVEL_ERROR" }
+	filter {}
+
+newoption
+{
+	trigger = "mmgr",
+	description = "Forward engine allocations to the FluidStudios memory manager (leak report on exit)"
+}
+
+newoption
+{
+	trigger = "log-level",
+	value = "LEVEL",
+	description = "Compile out log macros below LEVEL in every project (see TheShen/src/Core/Log.h)",
+	allowed =
+	{
+		{ "trace", "Keep every log macro (default, Dist defaults to warn)" },
+		{ "info", "Strip TRACE" },
+		{ "warn", "Strip TRACE and INFO" },
+		{ "error", "Strip everything below ERROR" },
+	}
+}
+
 outputdir="%{cfg.buildcfg}-%{cfg.system}-%{cfg.architecture}"
 
 -- Include directories relative to root folder (solution directory)
@@ -45,6 +77,7 @@ project "TheShen"
 		"%{prj.name}/src/**.h",
 		"%{prj.name}/src/**.cpp",
 		"Vendor/stb/stb_image.h",
+		"Vendor/stb/stb_dxt.h",
 		"Vendor/tinyobjloader/tiny_obj_loader.h",
 		"%{prj.name}/vendor/glm/glm/**.hpp",
 		"%{prj.name}/vendor/glm/glm/**.inl",
@@ -88,6 +121,24 @@ project "TheShen"
 			GLFW_INCLUDE_NONE
 		}
 
+	-- mmgr.c relies on C++ (placement new, references) through the interface shims
+	filter "files:Vendor/FluidStudios/MemoryManager/mmgr.c"
+		compileas "C++"
+		defines { "WIN32" }
+
+	-- The ImGui Vulkan backend loads its entry points through ImGui_ImplVulkan_LoadFunctions
+	filter "files:TheShen/src/ImGui/example/imgui_impl_vulkan.cpp"
+		defines { "IMGUI_IMPL_VULKAN_NO_PROTOTYPES" }
+
+	-- The memory manager is only built when the tracker forwards to it, so other builds do not link it in
+	filter "options:mmgr"
+		defines { "SHEN_USE_MMGR" }
+		files
+		{
+			"Vendor/FluidStudios/MemoryManager/mmgr.h",
+			"Vendor/FluidStudios/MemoryManager/mmgr.c",
+			"Vendor/FluidStudios/src/Interfaces/**.h",
+		}
 
 	filter "configurations:Debug"
 		defines ""
@@ -99,6 +150,12 @@ project "TheShen"
 		runtime "Release"
 		optimize "on"
 
+	-- Shipping build: profiling scopes and other instrumentation compile out
+	filter "configurations:Dist"
+		defines { "SHEN_DIST" }
+		runtime "Release"
+		optimize "on"
+
 project "Sandbox"
 
 	location "Sandbox"
@@ -160,4 +217,368 @@ project "Sandbox"
 	filter "configurations:Release"
 		defines ""
 		runtime "Release"
-		optimize "on"
\ No newline at end of file
+		optimize "on"
+
+	-- Shipping build: profiling scopes and other instrumentation compile out
+	filter "configurations:Dist"
+		defines { "SHEN_DIST" }
+		runtime "Release"
+		optimize "on"
+-- Headless benchmark: synthetic scenes, JSON/CSV report, non-zero exit on regressions against a baseline
+project "Benchmark"
+
+	location "Benchmark"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+	staticruntime "on"
+	characterset ("MBCS")
+
+	targetdir("bin/" ..outputdir.. "/%{prj.name}")
+	objdir("bin-int/" ..outputdir.. "/%{prj.name}")
+	debugdir("bin/" ..outputdir.. "/%{prj.name}")
+
+	files
+	{
+		"%{prj.name}/src/**.h",
+		"%{prj.name}/src/**.cpp",
+		"%{prj.name}/shaders/**",
+	}
+
+	includedirs
+	{
+		"vendor/spdlog/include",
+		"TheShen/src",
+		"%{IncludeDir.GLFW}",
+		"%VULKAN_SDK%/include",
+		"%{IncludeDir.glm}",
+		"%{IncludeDir.imgui}"
+	}
+
+	links
+	{
+		"TheShen",
+		"GLFW",
+		"ImGui",
+		"vulkan-1.lib"
+	}
+
+	libdirs 
+	{ 
+		"%VULKAN_SDK%/lib" 
+	}
+
+	-- The meshes and clusters scenes compile their own GLSL with the Vulkan SDK's glslc into ./shaders next to the executable
+	prebuildcommands
+	{
+		"{MKDIR} %{cfg.targetdir}/shaders",
+		"\"%VULKAN_SDK%/Bin/glslc\" %{wks.location}/Benchmark/shaders/mesh.vert -o %{cfg.targetdir}/shaders/mesh_vert.spv",
+		"\"%VULKAN_SDK%/Bin/glslc\" %{wks.location}/Benchmark/shaders/mesh.frag -o %{cfg.targetdir}/shaders/mesh_frag.spv",
+		"\"%VULKAN_SDK%/Bin/glslc\" %{wks.location}/Benchmark/shaders/cluster_cull.comp -o %{cfg.targetdir}/shaders/cluster_cull.spv"
+	}
+
+	-- The other scenes load the Sandbox triangle shaders from the same directory
+	postbuildcommands
+	{
+		"{COPYDIR} %{wks.location}/Sandbox/shaders %{cfg.targetdir}/shaders"
+	}
+
+	filter "system:windows"
+		systemversion "latest"
+
+		defines
+		{
+			GLFW_INCLUDE_NONE
+		}
+
+
+	filter "configurations:Debug"
+		defines ""
+		runtime "Debug"
+		symbols "on"
+
+	filter "configurations:Release"
+		defines ""
+		runtime "Release"
+		optimize "on"
+
+	filter "configurations:Dist"
+		defines { "SHEN_DIST" }
+		runtime "Release"
+		optimize "on"
+
+
+-- Fixed-iteration microbenchmarks for events, layers, logging and renderer primitives
+project "MicroBenchmark"
+
+	location "MicroBenchmark"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+	staticruntime "on"
+	characterset ("MBCS")
+
+	targetdir("bin/" ..outputdir.. "/%{prj.name}")
+	objdir("bin-int/" ..outputdir.. "/%{prj.name}")
+	debugdir("bin/" ..outputdir.. "/%{prj.name}")
+
+	files
+	{
+		"%{prj.name}/src/**.h",
+		"%{prj.name}/src/**.cpp",
+	}
+
+	includedirs
+	{
+		"vendor/spdlog/include",
+		"TheShen/src",
+		"%{IncludeDir.GLFW}",
+		"%VULKAN_SDK%/include",
+		"%{IncludeDir.glm}",
+		"%{IncludeDir.imgui}",
+		"%{IncludeDir.tinyobjloader}"
+	}
+
+	links
+	{
+		"TheShen",
+		"GLFW",
+		"ImGui",
+		"vulkan-1.lib"
+	}
+
+	libdirs 
+	{ 
+		"%VULKAN_SDK%/lib" 
+	}
+
+	-- renderer/cmd_draw loads the Sandbox triangle shaders from ./shaders next to the executable
+	postbuildcommands
+	{
+		"{COPYDIR} %{wks.location}/Sandbox/shaders %{cfg.targetdir}/shaders"
+	}
+
+	filter "system:windows"
+		systemversion "latest"
+
+		defines
+		{
+			GLFW_INCLUDE_NONE
+		}
+
+
+	filter "configurations:Debug"
+		defines ""
+		runtime "Debug"
+		symbols "on"
+
+	filter "configurations:Release"
+		defines ""
+		runtime "Release"
+		optimize "on"
+
+	filter "configurations:Dist"
+		defines { "SHEN_DIST" }
+		runtime "Release"
+		optimize "on"
+
+
+-- Offline asset cooker: OBJ -> versioned binary meshes (.smesh) that addMesh maps without parsing
+project "MeshCooker"
+
+	location "MeshCooker"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+	staticruntime "on"
+	characterset ("MBCS")
+
+	targetdir("bin/" ..outputdir.. "/%{prj.name}")
+	objdir("bin-int/" ..outputdir.. "/%{prj.name}")
+
+	files
+	{
+		"%{prj.name}/src/**.h",
+		"%{prj.name}/src/**.cpp",
+	}
+
+	includedirs
+	{
+		"vendor/spdlog/include",
+		"TheShen/src",
+		"%{IncludeDir.GLFW}",
+		"%VULKAN_SDK%/include",
+		"%{IncludeDir.glm}",
+		"%{IncludeDir.imgui}"
+	}
+
+	-- Mesh.cpp shares the import pipeline with the runtime, which pulls in the renderer
+	links
+	{
+		"TheShen",
+		"GLFW",
+		"ImGui",
+		"vulkan-1.lib"
+	}
+
+	libdirs 
+	{ 
+		"%VULKAN_SDK%/lib" 
+	}
+
+	filter "system:windows"
+		systemversion "latest"
+
+		defines
+		{
+			GLFW_INCLUDE_NONE
+		}
+
+
+	filter "configurations:Debug"
+		defines ""
+		runtime "Debug"
+		symbols "on"
+
+	filter "configurations:Release"
+		defines ""
+		runtime "Release"
+		optimize "on"
+
+	filter "configurations:Dist"
+		defines { "SHEN_DIST" }
+		runtime "Release"
+		optimize "on"
+
+project "TextureCooker"
+
+	location "TextureCooker"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+	staticruntime "on"
+	characterset ("MBCS")
+
+	targetdir("bin/" ..outputdir.. "/%{prj.name}")
+	objdir("bin-int/" ..outputdir.. "/%{prj.name}")
+
+	files
+	{
+		"%{prj.name}/src/**.h",
+		"%{prj.name}/src/**.cpp",
+	}
+
+	includedirs
+	{
+		"vendor/spdlog/include",
+		"TheShen/src",
+		"%{IncludeDir.GLFW}",
+		"%VULKAN_SDK%/include",
+		"%{IncludeDir.glm}",
+		"%{IncludeDir.imgui}"
+	}
+
+	-- TextureLoader.cpp shares the decoder and compressor with the runtime, which pulls in the renderer
+	links
+	{
+		"TheShen",
+		"GLFW",
+		"ImGui",
+		"vulkan-1.lib"
+	}
+
+	libdirs 
+	{ 
+		"%VULKAN_SDK%/lib" 
+	}
+
+	filter "system:windows"
+		systemversion "latest"
+
+		defines
+		{
+			GLFW_INCLUDE_NONE
+		}
+
+
+	filter "configurations:Debug"
+		defines ""
+		runtime "Debug"
+		symbols "on"
+
+	filter "configurations:Release"
+		defines ""
+		runtime "Release"
+		optimize "on"
+
+	filter "configurations:Dist"
+		defines { "SHEN_DIST" }
+		runtime "Release"
+		optimize "on"
+
+-- Offline asset packer: many small files -> one LZ4 compressed pack (.spak) read through openAssetPack
+project "AssetPacker"
+
+	location "AssetPacker"
+	kind "ConsoleApp"
+	language "C++"
+	cppdialect "C++17"
+	staticruntime "on"
+	characterset ("MBCS")
+
+	targetdir("bin/" ..outputdir.. "/%{prj.name}")
+	objdir("bin-int/" ..outputdir.. "/%{prj.name}")
+
+	files
+	{
+		"%{prj.name}/src/**.h",
+		"%{prj.name}/src/**.cpp",
+	}
+
+	includedirs
+	{
+		"vendor/spdlog/include",
+		"TheShen/src",
+		"%{IncludeDir.GLFW}",
+		"%VULKAN_SDK%/include",
+		"%{IncludeDir.glm}",
+		"%{IncludeDir.imgui}"
+	}
+
+	-- Only Core is used, the engine library still links against GLFW, ImGui and Vulkan as a whole
+	links
+	{
+		"TheShen",
+		"GLFW",
+		"ImGui",
+		"vulkan-1.lib"
+	}
+
+	libdirs 
+	{ 
+		"%VULKAN_SDK%/lib" 
+	}
+
+	filter "system:windows"
+		systemversion "latest"
+
+		defines
+		{
+			GLFW_INCLUDE_NONE
+		}
+
+
+	filter "configurations:Debug"
+		defines ""
+		runtime "Debug"
+		symbols "on"
+
+	filter "configurations:Release"
+		defines ""
+		runtime "Release"
+		optimize "on"
+
+	filter "configurations:Dist"
+		defines { "SHEN_DIST" }
+		runtime "Release"
+		optimize "on"